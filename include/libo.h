@@ -32,6 +32,10 @@
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 #include <zip.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <time.h>
 
 #include <libstrings.h>
 
@@ -62,9 +66,34 @@ typedef enum
   libo_xl_cell_type_none,        /**<  no or unknown cell type  */
   libo_xl_cell_type_reference,   /**<  reference  */
   libo_xl_cell_type_expression,  /**<  expression, such as formula  */
-  libo_xl_cell_type_number       /**<  direct value  */
+  libo_xl_cell_type_number,      /**<  direct value  */
+  libo_xl_cell_type_boolean,     /**<  TRUE or FALSE  */
+  libo_xl_cell_type_error,       /**<  error value, such as #N/A  */
+  libo_xl_cell_type_empty,       /**<  present but holds no value  */
+  libo_xl_cell_type_date         /**<  date or time, held as serial number  */
 } libo_xl_cell_type;
 
+#define LIBO_XL_CELL_TYPES 8  /**<  number of @a libo_xl_cell_type values  */
+#define LIBO_XL_NUMBER_SIZE 32  /**<  buffer size that holds any formatted number  */
+
+  /**
+   *  @typedef enum libo_xl_error
+   *
+   *  @brief error value held by an Excel cell
+   */
+
+typedef enum
+{
+  libo_xl_error_none,   /**<  no error  */
+  libo_xl_error_null,   /**<  #NULL!    */
+  libo_xl_error_div0,   /**<  #DIV/0!   */
+  libo_xl_error_value,  /**<  #VALUE!   */
+  libo_xl_error_ref,    /**<  #REF!     */
+  libo_xl_error_name,   /**<  #NAME?    */
+  libo_xl_error_num,    /**<  #NUM!     */
+  libo_xl_error_na      /**<  #N/A      */
+} libo_xl_error;
+
   /**
    *  @typedef enum libo_xl_expression_type
    *
@@ -78,6 +107,64 @@ typedef enum
   libo_xl_expression_type_value
 } libo_xl_expression_type;
 
+  /**
+   *  @typedef enum libo_xl_sheet_state
+   *
+   *  @brief residency of an Excel work sheet's rows
+   */
+
+typedef enum
+{
+  libo_xl_sheet_state_resident,  /**<  rows are in memory                 */
+  libo_xl_sheet_state_evicted,   /**<  rows dropped, reparsed on access   */
+  libo_xl_sheet_state_spilled    /**<  rows moved to a temporary file     */
+} libo_xl_sheet_state;
+
+  /**
+   *  @typedef enum libo_xl_storage
+   *
+   *  @brief where an Excel work sheet keeps its rows
+   */
+
+typedef enum
+{
+  libo_xl_storage_memory,     /**<  rows are allocated on the heap          */
+  libo_xl_storage_disk,       /**<  rows are packed into a mapped temp file  */
+  libo_xl_storage_compressed, /**<  rows are packed into compressed blocks   */
+  libo_xl_storage_columnar    /**<  rows are split into encoded columns      */
+} libo_xl_storage;
+
+  /**
+   *  @typedef enum libo_xl_encoding
+   *
+   *  @brief how a column of a columnar work sheet is encoded
+   */
+
+typedef enum
+{
+  libo_xl_encoding_none,        /**<  column is not encoded                       */
+  libo_xl_encoding_plain,       /**<  values are kept as they are                 */
+  libo_xl_encoding_run_length,  /**<  runs of repeated values                     */
+  libo_xl_encoding_dictionary,  /**<  distinct values, and bit-packed indices     */
+  libo_xl_encoding_frame        /**<  bit-packed offsets from smallest integer    */
+} libo_xl_encoding;
+
+  /**
+   *  @typedef enum libo_xl_column_type
+   *
+   *  @brief dominant type inferred for the cells of a column
+   */
+
+typedef enum
+{
+  libo_xl_column_type_mixed,      /**<  no type dominates                  */
+  libo_xl_column_type_integer,    /**<  whole numbers, held as int64       */
+  libo_xl_column_type_number,     /**<  numbers, held as double            */
+  libo_xl_column_type_reference,  /**<  shared strings, held as string id  */
+  libo_xl_column_type_boolean,    /**<  booleans, held as 0 or 1           */
+  libo_xl_column_type_error       /**<  error codes, held as libo_xl_error */
+} libo_xl_column_type;
+
   /**
    *  @typedef struct libo_xl_cell_expression libo_xl_cell_expression
    *
@@ -114,15 +201,50 @@ typedef struct libo_xl_cell libo_xl_cell;
 
 struct libo_xl_cell
 {
-  libo_xl_cell_type type;      /**<  type of cell, see @a libo_xl_cell_type  */
+  unsigned char type;          /**<  type of cell, a @a libo_xl_cell_type  */
+  unsigned short style;        /**<  index of cell format in style sheet,
+                                     0 for the default                   */
+  int shared;                  /**<  1 + index of shared formula of
+                                     expression in its sheet, 0 if none  */
   union
   {
     int reference;                       /**<  reference identifier          */
     libo_xl_cell_expression expression;  /**<  expression                    */
     double number;                       /**<  direct value                  */
+    int boolean;                         /**<  1 if TRUE, 0 if FALSE         */
+    libo_xl_error error;                 /**<  error value                   */
   };
 };
 
+  /**
+   *  @typedef struct libo_xl_value libo_xl_value
+   *
+   *  @brief create a type for struct @a libo_xl_value
+   */
+
+typedef struct libo_xl_value libo_xl_value;
+
+  /**
+   *  @struct libo_xl_value
+   *
+   *  @brief struct that holds a typed view of a cell's value
+   *
+   *  NOTE:  @a text points into the string dictionary or the cell's expression
+   *         and is valid only while those are left unchanged
+   */
+
+struct libo_xl_value
+{
+  libo_xl_cell_type type;  /**<  type of cell, see @a libo_xl_cell_type   */
+  double number;           /**<  value of number cells, 1 or 0 for
+                                 boolean cells, 0 otherwise               */
+  int reference;           /**<  string id of reference cells, else -1    */
+  libo_xl_error error;     /**<  error of error cells, else none          */
+  const char *text;        /**<  text of reference, expression, boolean
+                                 and error cells                          */
+  size_t length;           /**<  length of @a text in bytes               */
+};
+
   /**
    *  @typedef struct libo_xl_row libo_xl_row;
    *
@@ -216,6 +338,97 @@ struct libo_xl_filter
   unsigned int last_column;   /**<  last column to filter   */
 };
 
+  /**
+   *  @typedef struct libo_xl_sort_key libo_xl_sort_key;
+   *
+   *  @brief create a type for struct @a libo_xl_sort_key
+   */
+
+typedef struct libo_xl_sort_key libo_xl_sort_key;
+
+  /**
+   *  @struct libo_xl_sort_key
+   *
+   *  @brief struct that holds one column rows are sorted by
+   */
+
+struct libo_xl_sort_key
+{
+  int col;         /**<  index of column                   */
+  int descending;  /**<  1 for largest first, 0 otherwise  */
+};
+
+  /**
+   *  @typedef struct libo_xl_sort libo_xl_sort;
+   *
+   *  @brief create a type for struct @a libo_xl_sort
+   */
+
+typedef struct libo_xl_sort libo_xl_sort;
+
+  /**
+   *  @struct libo_xl_sort
+   *
+   *  @brief struct that holds sort applied to a work sheet
+   */
+
+struct libo_xl_sort
+{
+  int first_row;          /**<  index of first sorted row     */
+  int n_keys;             /**<  number of keys                */
+  libo_xl_sort_key *key;  /**<  keys, most significant first  */
+};
+
+  /**
+   *  @typedef struct libo_xl_column_stats libo_xl_column_stats;
+   *
+   *  @brief create a type for struct @a libo_xl_column_stats
+   */
+
+typedef struct libo_xl_column_stats libo_xl_column_stats;
+
+  /**
+   *  @struct libo_xl_column_stats
+   *
+   *  @brief struct that holds aggregates of numbers in a column
+   */
+
+struct libo_xl_column_stats
+{
+  long count;       /**<  number of numbers                          */
+  double sum;       /**<  sum of numbers                             */
+  double min;       /**<  smallest number, 0 if none                 */
+  double max;       /**<  largest number, 0 if none                  */
+  double mean;      /**<  average of numbers, 0 if none              */
+  double variance;  /**<  sample variance, 0 if fewer than 2 numbers  */
+};
+
+  /**
+   *  @typedef struct libo_xl_column_profile libo_xl_column_profile;
+   *
+   *  @brief create a type for struct @a libo_xl_column_profile
+   */
+
+typedef struct libo_xl_column_profile libo_xl_column_profile;
+
+#define LIBO_XL_PROFILE_REGISTERS 2048  /**<  HyperLogLog registers per column  */
+
+  /**
+   *  @struct libo_xl_column_profile
+   *
+   *  @brief struct that holds a profile of a column, gathered as its work
+   *         sheet is read
+   */
+
+struct libo_xl_column_profile
+{
+  long count[LIBO_XL_CELL_TYPES];  /**<  cells of each @a libo_xl_cell_type, nulls excluded  */
+  long nulls;                      /**<  empty cells                                       */
+  double min;                      /**<  smallest number, 0 if none                        */
+  double max;                      /**<  largest number, 0 if none                         */
+  unsigned char registers[LIBO_XL_PROFILE_REGISTERS];  /**<  HyperLogLog sketch of values  */
+};
+
   /**
    *  @typedef struct libo_xl_sheet libo_xl_sheet;
    *
@@ -224,6 +437,233 @@ struct libo_xl_filter
 
 typedef struct libo_xl_sheet libo_xl_sheet;
 
+  /**
+   *  @typedef struct libo_xl_store libo_xl_store;
+   *
+   *  @brief create a type for opaque struct @a libo_xl_store, which holds
+   *         rows of a work sheet in blocks outside of the heap
+   */
+
+typedef struct libo_xl_store libo_xl_store;
+
+  /**
+   *  @typedef struct libo_xl_seek_index libo_xl_seek_index;
+   *
+   *  @brief create a type for opaque struct @a libo_xl_seek_index, which
+   *         holds checkpoints that resume decompressing a work sheet part
+   *         way through
+   */
+
+typedef struct libo_xl_seek_index libo_xl_seek_index;
+
+  /**
+   *  @typedef struct libo_xl_index libo_xl_index;
+   *
+   *  @brief create a type for opaque struct @a libo_xl_index, which finds
+   *         rows of a work sheet by the value in one column
+   */
+
+typedef struct libo_xl_index libo_xl_index;
+
+  /**
+   *  @typedef struct libo_xl_sorted_index libo_xl_sorted_index;
+   *
+   *  @brief create a type for opaque struct @a libo_xl_sorted_index, which
+   *         holds rows of a column in sorted order for range lookups
+   */
+
+typedef struct libo_xl_sorted_index libo_xl_sorted_index;
+
+  /**
+   *  @typedef struct libo_xl_view libo_xl_view;
+   *
+   *  @brief create a type for opaque struct @a libo_xl_view, which holds a
+   *         set of rows of a work sheet
+   */
+
+typedef struct libo_xl_view libo_xl_view;
+
+  /**
+   *  @typedef struct libo_xl_schema libo_xl_schema;
+   *
+   *  @brief create a type for opaque struct @a libo_xl_schema, which finds
+   *         columns of a work sheet by the names in its header row
+   */
+
+typedef struct libo_xl_schema libo_xl_schema;
+
+  /**
+   *  @typedef struct libo_xl_calc libo_xl_calc;
+   *
+   *  @brief create a type for opaque struct @a libo_xl_calc, which holds the
+   *         formulas of a workbook compiled, and the cells each reads
+   */
+
+typedef struct libo_xl_calc libo_xl_calc;
+
+  /**
+   *  @typedef struct libo_xl_styles libo_xl_styles;
+   *
+   *  @brief create a type for opaque struct @a libo_xl_styles, which holds
+   *         the fonts, fills, borders, number formats and cell formats of a
+   *         workbook, each interned
+   */
+
+typedef struct libo_xl_styles libo_xl_styles;
+
+#define LIBO_XL_STYLE_APPLY_NUMBER_FORMAT  0x01  /**<  applyNumberFormat  */
+#define LIBO_XL_STYLE_APPLY_FONT           0x02  /**<  applyFont          */
+#define LIBO_XL_STYLE_APPLY_FILL           0x04  /**<  applyFill          */
+#define LIBO_XL_STYLE_APPLY_BORDER         0x08  /**<  applyBorder        */
+#define LIBO_XL_STYLE_APPLY_ALIGNMENT      0x10  /**<  applyAlignment     */
+#define LIBO_XL_STYLE_APPLY_PROTECTION     0x20  /**<  applyProtection    */
+#define LIBO_XL_STYLE_QUOTE_PREFIX         0x40  /**<  quotePrefix        */
+#define LIBO_XL_STYLE_PIVOT_BUTTON         0x80  /**<  pivotButton        */
+
+#define LIBO_XL_STYLES_MAX 65536  /**<  number of cell formats a cell can refer to  */
+
+  /**
+   *  @typedef struct libo_xl_style libo_xl_style;
+   *
+   *  @brief create a type for struct @a libo_xl_style
+   */
+
+typedef struct libo_xl_style libo_xl_style;
+
+  /**
+   *  @struct libo_xl_style
+   *
+   *  @brief struct that holds a cell format, an xf of a style sheet
+   */
+
+struct libo_xl_style
+{
+  int number_format;  /**<  id of number format, 0 for General       */
+  int font;           /**<  index of font                            */
+  int fill;           /**<  index of fill                            */
+  int border;         /**<  index of border                          */
+  int parent;         /**<  index of cell style format, 0 for Normal */
+  int flags;          /**<  LIBO_XL_STYLE_* bits                     */
+  int cleared;        /**<  LIBO_XL_STYLE_* bits given as 0          */
+  char *alignment;    /**<  XML of alignment and protection elements,
+                            or NULL                                  */
+};
+
+  /**
+   *  @typedef struct libo_xl_record libo_xl_record;
+   *
+   *  @brief create a type for struct @a libo_xl_record
+   */
+
+typedef struct libo_xl_record libo_xl_record;
+
+  /**
+   *  @struct libo_xl_record
+   *
+   *  @brief struct that holds a row of a work sheet, with the names of its
+   *         columns
+   */
+
+struct libo_xl_record
+{
+  libo_xl_schema *schema;  /**<  names of columns        */
+  libo_xl_row *row;        /**<  cells of row            */
+  int n;                   /**<  index of row in sheet   */
+};
+
+  /**
+   *  @typedef int (*libo_xl_record_handler)(libo_xl_record *rec, void *data)
+   *
+   *  @brief called for each record of a streamed work sheet, returns
+   *         non-zero to stop reading
+   */
+
+typedef int (*libo_xl_record_handler)(libo_xl_record *rec, void *data);
+
+  /**
+   *  @typedef enum libo_xl_field_type
+   *
+   *  @brief type of a field of a struct rows are bound to
+   *
+   *  Integer fields take whole numbers exactly, even past 2^53, and cut
+   *  other numbers toward zero.  A value out of range of the field leaves
+   *  it untouched.
+   */
+
+typedef enum
+{
+  libo_xl_field_double,     /**<  double, from a number                       */
+  libo_xl_field_int64,      /**<  int64_t, from a number                      */
+  libo_xl_field_int,        /**<  int, from a number                          */
+  libo_xl_field_text,       /**<  char *, text of a shared string, not copied */
+  libo_xl_field_string_id   /**<  int, id of a shared string, -1 if none      */
+} libo_xl_field_type;
+
+  /**
+   *  @typedef struct libo_xl_field libo_xl_field;
+   *
+   *  @brief create a type for struct @a libo_xl_field
+   */
+
+typedef struct libo_xl_field libo_xl_field;
+
+  /**
+   *  @struct libo_xl_field
+   *
+   *  @brief struct that describes a field of a struct rows are bound to
+   */
+
+struct libo_xl_field
+{
+  int col;                  /**<  index of column read                */
+  libo_xl_field_type type;  /**<  type of field                       */
+  size_t offset;            /**<  offset of field, from @a offsetof   */
+};
+
+  /**
+   *  @typedef enum libo_xl_predicate_op
+   *
+   *  @brief test made by a predicate
+   */
+
+typedef enum
+{
+  libo_xl_predicate_op_equal,          /**<  number equal to lo               */
+  libo_xl_predicate_op_not_equal,      /**<  number not equal to lo           */
+  libo_xl_predicate_op_less,           /**<  number less than lo              */
+  libo_xl_predicate_op_less_equal,     /**<  number not greater than lo       */
+  libo_xl_predicate_op_greater,        /**<  number greater than lo           */
+  libo_xl_predicate_op_greater_equal,  /**<  number not less than lo          */
+  libo_xl_predicate_op_between,        /**<  number from lo to hi, inclusive  */
+  libo_xl_predicate_op_in              /**<  shared string id one of ids      */
+} libo_xl_predicate_op;
+
+  /**
+   *  @typedef struct libo_xl_predicate libo_xl_predicate;
+   *
+   *  @brief create a type for struct @a libo_xl_predicate
+   */
+
+typedef struct libo_xl_predicate libo_xl_predicate;
+
+  /**
+   *  @struct libo_xl_predicate
+   *
+   *  @brief struct that holds a condition on the cells of a column
+   */
+
+struct libo_xl_predicate
+{
+  int col;                  /**<  index of column tested           */
+  libo_xl_predicate_op op;  /**<  test made                        */
+  double lo;                /**<  number compared, or lower bound  */
+  double hi;                /**<  upper bound                      */
+  int n_ids;                /**<  number of ids in @a ids          */
+  int *ids;                 /**<  set of shared string ids         */
+  int n_texts;              /**<  number of texts in @a texts      */
+  char **texts;             /**<  set of texts, resolved to ids    */
+};
+
   /**
    *  @struct libo_xl_sheet
    *
@@ -242,6 +682,26 @@ struct libo_xl_sheet
   libo_xl_row **row;          /**<  arrow of rows                       */
   libo_xl_column **column;    /**<  columnn attributes                  */
   libo_xl_filter *filter;     /**<  filtered columns                    */
+  int index;                  /**<  position of work sheet in file      */
+  libo_xl_sheet_state state;  /**<  residency of rows                   */
+  int dirty;                  /**<  rows changed since read from file   */
+  unsigned long used;         /**<  book clock at last access           */
+  size_t bytes;               /**<  memory used when last measured      */
+  FILE *spill;                /**<  temporary file holding spilled rows */
+  libo_xl_store *store;       /**<  out of core rows, NULL if in memory */
+  unsigned long version;      /**<  incremented as cells change         */
+  int n_profiles;             /**<  number of column profiles           */
+  libo_xl_column_profile **profile;  /**<  column profiles, NULL if not gathered  */
+  libo_xl_sort *sort;         /**<  last sort applied, NULL if none     */
+  libo_xl_view *visible;      /**<  rows not hidden, NULL if all        */
+  int n_sources;              /**<  number of entries of @a source      */
+  int *source;                /**<  columns of file read, NULL if all   */
+  libo_xl_seek_index *seek;   /**<  checkpoints into file, NULL if none */
+  int n_shared;               /**<  number of shared formulas           */
+  char **shared;              /**<  shared formulas in R1C1 form        */
+  int n_dates;                /**<  number of entries of @a dates       */
+  unsigned char *dates;       /**<  1 for each cell format showing a
+                                    date, NULL if none                  */
 };
 
   /**
@@ -260,8 +720,15 @@ typedef struct libo_xl_book libo_xl_book;
 
 struct libo_xl_book
 {
-  int n_sheets;           /**<  number of worksheets  */
-  libo_xl_sheet **sheet;  /**<  array of work sheets  */
+  int n_sheets;                  /**<  number of worksheets                   */
+  libo_xl_sheet **sheet;         /**<  array of work sheets                   */
+  char *path;                    /**<  file work sheets are reparsed from     */
+  unsigned long crc;             /**<  checksum of file's ZIP directory       */
+  size_t memory_budget;          /**<  maximum bytes of resident sheets, or 0 */
+  unsigned long clock;           /**<  counts sheet accesses                  */
+  pthread_mutex_t lock;          /**<  serializes sheet accesses and eviction */
+  struct libo_options *options;  /**<  options work sheets are reparsed with  */
+  int date1904;                  /**<  1 if serial dates count from 1904      */
 };
 
   /**
@@ -280,8 +747,9 @@ typedef struct libo_xl libo_xl;
 
 struct libo_xl
 {
-  libo_xl_book *book;  /**< workbook           */
-  strings *strings;    /**< strings dictionary */
+  libo_xl_book *book;      /**< workbook                              */
+  strings *strings;        /**< strings dictionary                    */
+  libo_xl_styles *styles;  /**< style sheet, NULL until read or used  */
 };
 
   /**
@@ -326,6 +794,58 @@ struct libo_pp
   // NOT IMPLEMENTED
 };
 
+  /**
+   *  @typedef struct libo_xl_projection libo_xl_projection;
+   *
+   *  @brief create a type for struct @a libo_xl_projection
+   */
+
+typedef struct libo_xl_projection libo_xl_projection;
+
+  /**
+   *  @struct libo_xl_projection
+   *
+   *  @brief struct that holds a column of work sheets to read
+   */
+
+struct libo_xl_projection
+{
+  int col;     /**<  index of column, or -1 to find it by heading  */
+  char *name;  /**<  text of heading in first row, or NULL         */
+  int id;      /**<  shared string id of @a name, -1 if none       */
+};
+
+  /**
+   *  @typedef struct libo_options libo_options;
+   *
+   *  @brief create a type for struct @a libo_options
+   */
+
+typedef struct libo_options libo_options;
+
+  /**
+   *  @struct libo_options
+   *
+   *  @brief struct that holds options used when opening an Office document
+   */
+
+struct libo_options
+{
+  size_t memory_budget;          /**<  maximum bytes of resident work sheets, 0 for no limit  */
+  libo_xl_storage storage;       /**<  where rows of work sheets are kept                     */
+  int profile;                   /**<  1 to profile columns of work sheets as they are read    */
+  int n_predicates;              /**<  number of predicates rows must meet to be read         */
+  libo_xl_predicate *predicate;  /**<  predicates rows must meet to be read                   */
+  int header_rows;               /**<  number of leading rows read regardless of predicates   */
+  int n_columns;                 /**<  number of columns read, 0 for all                      */
+  libo_xl_projection *column;    /**<  columns read, in order they are kept                   */
+  int first_row;                 /**<  first row of work sheets read                          */
+  int last_row;                  /**<  row after last row of work sheets read, -1 for all     */
+  int sample_rows;               /**<  number of rows sampled at random, 0 to read all        */
+  unsigned long seed;            /**<  seed of random choice of rows sampled                  */
+  size_t seek_span;              /**<  bytes of XML between checkpoints, 0 for none           */
+};
+
   /**
    *  @typedef struct libo libo;
    *
@@ -342,9 +862,10 @@ typedef struct libo libo;
 
 struct libo
 {
-  char *path;      /**<  full path to document file       */
-  libo_type type;  /**<  type of Office document          */
-  zip_t *z;        /**<  ZIP file data                    */
+  char *path;             /**<  full path to document file     */
+  libo_type type;         /**<  type of Office document        */
+  zip_t *z;               /**<  ZIP file data                  */
+  libo_options *options;  /**<  options used to open document  */
   union
   {
     libo_xl *xl;    /**<  pointer to Excel document       */
@@ -353,6 +874,69 @@ struct libo
   };
 };
 
+  /**
+   *  @typedef struct libo_cache_entry libo_cache_entry;
+   *
+   *  @brief create a type for struct @a libo_cache_entry
+   */
+
+typedef struct libo_cache_entry libo_cache_entry;
+
+  /**
+   *  @struct libo_cache_entry
+   *
+   *  @brief struct that holds one cached Office document
+   */
+
+struct libo_cache_entry
+{
+  char *path;               /**<  path used to open document              */
+  off_t size;               /**<  file size when document was read        */
+  time_t mtime;             /**<  file modification time when read        */
+  unsigned long crc;        /**<  checksum of ZIP central directory       */
+  size_t bytes;             /**<  memory used by document                 */
+  int refs;                 /**<  number of references handed out         */
+  int stale;                /**<  file changed while document referenced  */
+  libo *l;                  /**<  cached document                         */
+  libo_cache_entry *chain;  /**<  next entry in same hash bucket          */
+  libo_cache_entry *prev;   /**<  more recently used entry                */
+  libo_cache_entry *next;   /**<  less recently used entry                */
+};
+
+  /**
+   *  @typedef struct libo_cache libo_cache;
+   *
+   *  @brief create a type for struct @a libo_cache
+   */
+
+typedef struct libo_cache libo_cache;
+
+  /**
+   *  @struct libo_cache
+   *
+   *  @brief struct that holds an LRU cache of opened Office documents
+   *
+   *  Documents are keyed by path, and revalidated against file size,
+   *  modification time and a checksum of the ZIP central directory.
+   *  Documents handed out by the cache are shared and must be treated
+   *  as read-only.
+   */
+
+struct libo_cache
+{
+  size_t budget;              /**<  maximum bytes of cached documents   */
+  size_t bytes;               /**<  bytes currently used by documents   */
+  int n_entries;              /**<  number of entries in hash table     */
+  int n_buckets;              /**<  number of hash buckets              */
+  libo_cache_entry **bucket;  /**<  hash table of entries, by path      */
+  libo_cache_entry *head;     /**<  most recently used entry            */
+  libo_cache_entry *tail;     /**<  least recently used entry           */
+  libo_cache_entry *stale;    /**<  replaced entries still referenced   */
+  unsigned long hits;         /**<  number of lookups served by cache   */
+  unsigned long misses;       /**<  number of lookups that read a file  */
+  pthread_mutex_t lock;       /**<  serializes access to cache          */
+};
+
   /*
    *  Library helpers
    */
@@ -367,6 +951,7 @@ void libo_cleanup(void);
 libo *libo_new(void);
 libo *libo_dup(libo *l);
 libo *libo_open(char *path);
+libo *libo_open_with_options(char *path, libo_options *options);
 void libo_free(libo *l);
 void libo_close(libo *l);
 
@@ -384,6 +969,63 @@ void libo_dump(libo *l, FILE *stream, int indent);
 
 int libo_write(libo *l, char *path);
 
+size_t libo_memory_size(libo *l);
+
+  /*
+   *  OPTIONS
+   */
+
+libo_options *libo_options_new(void);
+libo_options *libo_options_dup(libo_options *options);
+void libo_options_free(libo_options *options);
+
+size_t libo_options_get_memory_budget(libo_options *options);
+void libo_options_set_memory_budget(libo_options *options, size_t budget);
+
+libo_xl_storage libo_options_get_storage(libo_options *options);
+void libo_options_set_storage(libo_options *options, libo_xl_storage storage);
+
+int libo_options_get_profile(libo_options *options);
+void libo_options_set_profile(libo_options *options, int profile);
+
+int libo_options_add_predicate(libo_options *options, libo_xl_predicate *pred);
+int libo_options_get_predicate_count(libo_options *options);
+void libo_options_clear_predicates(libo_options *options);
+
+int libo_options_get_header_rows(libo_options *options);
+void libo_options_set_header_rows(libo_options *options, int header_rows);
+
+int libo_options_add_column(libo_options *options, char *letters);
+int libo_options_add_column_name(libo_options *options, char *name);
+int libo_options_get_column_count(libo_options *options);
+void libo_options_clear_columns(libo_options *options);
+
+int libo_options_get_first_row(libo_options *options);
+int libo_options_get_last_row(libo_options *options);
+void libo_options_set_row_range(libo_options *options, int first, int last);
+
+int libo_options_get_sample_rows(libo_options *options);
+unsigned long libo_options_get_sample_seed(libo_options *options);
+void libo_options_set_sample(libo_options *options, int k, unsigned long seed);
+
+size_t libo_options_get_seek_span(libo_options *options);
+void libo_options_set_seek_span(libo_options *options, size_t span);
+
+  /*
+   *  CACHE
+   */
+
+libo_cache *libo_cache_new(size_t budget);
+void libo_cache_free(libo_cache *cache);
+
+libo *libo_cache_open(libo_cache *cache, char *path);
+void libo_cache_release(libo_cache *cache, libo *l);
+
+size_t libo_cache_get_budget(libo_cache *cache);
+void libo_cache_set_budget(libo_cache *cache, size_t budget);
+
+void libo_cache_dump(libo_cache *cache, FILE *stream, int indent);
+
   /*
    *  DOC
    */
@@ -413,11 +1055,43 @@ void libo_xl_free(libo_xl *xl);
 
 libo_xl_book *libo_xl_get_book(libo_xl *xl);
 
+size_t libo_xl_memory_size(libo_xl *xl);
+
 strings *libo_xl_strings_read(libo *l);
 void libo_xl_strings_dump(strings *strs, FILE *stream, int indent);
 
 void libo_xl_dump(libo_xl *xl, FILE *stream, int indent);
 
+  /*
+   *  XL styles
+   */
+
+libo_xl_styles *libo_xl_get_styles(libo_xl *xl);
+libo_xl_styles *libo_xl_styles_read(libo *l);
+void libo_xl_styles_free(libo_xl_styles *styles);
+size_t libo_xl_styles_memory_size(libo_xl_styles *styles);
+void libo_xl_styles_dump(libo_xl_styles *styles, FILE *stream, int indent);
+
+int libo_xl_styles_add_font(libo_xl_styles *styles, const char *xml);
+int libo_xl_styles_add_fill(libo_xl_styles *styles, const char *xml);
+int libo_xl_styles_add_border(libo_xl_styles *styles, const char *xml);
+int libo_xl_styles_add_number_format(libo_xl_styles *styles, const char *code);
+const char *libo_xl_styles_get_number_format(libo_xl_styles *styles, int id);
+
+int libo_xl_styles_add_style(libo_xl_styles *styles, libo_xl_style *style);
+int libo_xl_styles_get_style(libo_xl_styles *styles, int index, libo_xl_style *style);
+int libo_xl_styles_get_count(libo_xl_styles *styles);
+int libo_xl_styles_is_date(libo_xl_styles *styles, int index);
+
+  /*
+   *  XL dates
+   */
+
+int libo_xl_serial_to_epoch(double serial, int date1904, double *seconds);
+int libo_xl_epoch_to_serial(double seconds, int date1904, double *serial);
+int libo_xl_serials_to_epoch(const double *serial, double *seconds, size_t n, int date1904);
+int libo_xl_epochs_to_serial(const double *seconds, double *serial, size_t n, int date1904);
+
   /*
    *  XL book
    */
@@ -432,6 +1106,14 @@ libo_xl_sheet *libo_xl_book_get_sheet(libo_xl_book *xlb, int n);
 
 void libo_xl_book_add(libo_xl_book *xlb, libo_xl_sheet *xls);
 
+size_t libo_xl_book_memory_size(libo_xl_book *book);
+
+size_t libo_xl_book_get_memory_budget(libo_xl_book *book);
+void libo_xl_book_set_memory_budget(libo_xl_book *book, size_t budget);
+int libo_xl_book_get_date1904(libo_xl_book *book);
+void libo_xl_book_set_date1904(libo_xl_book *book, int date1904);
+void libo_xl_book_trim(libo_xl_book *book, libo_xl_sheet *keep);
+
 void libo_xl_book_dump(libo_xl_book *lxb, FILE *stream, int indent);
 
   /*
@@ -441,15 +1123,68 @@ void libo_xl_book_dump(libo_xl_book *lxb, FILE *stream, int indent);
 libo_xl_sheet *libo_xl_sheet_new(void);
 libo_xl_sheet *libo_xl_sheet_dup(libo_xl_sheet *sheet);
 void libo_xl_sheet_read(libo *l, libo_xl_sheet *sheet, int n);
+int libo_xl_sheet_read_range(libo *l, libo_xl_sheet *sheet, int first, int last);
+int libo_xl_sheet_read_sample(libo *l, libo_xl_sheet *sheet, int k, unsigned long seed);
 libo_xl_sheet *libo_xl_sheet_meta_read(xmlDocPtr doc, int n);
 libo_xl_row **libo_xl_sheet_rows_read(libo_xl_sheet *sheet, xmlDocPtr doc);
 void libo_xl_sheet_free(libo_xl_sheet *sheet);
 
 int libo_xl_sheet_get_row_count(libo_xl_sheet *xls);
 int libo_xl_sheet_get_column_count(libo_xl_sheet *xls);
+int libo_xl_sheet_get_checkpoint_count(libo_xl_sheet *xls);
+int libo_xl_sheet_get_source_column(libo_xl_sheet *xls, int col);
 
 libo_xl_row *libo_xl_sheet_get_row(libo_xl_sheet *xls, int n);
 
+size_t libo_xl_sheet_memory_size(libo_xl_sheet *sheet);
+
+libo_xl_sheet_state libo_xl_sheet_get_state(libo_xl_sheet *sheet);
+int libo_xl_sheet_get_dirty(libo_xl_sheet *sheet);
+void libo_xl_sheet_set_dirty(libo_xl_sheet *sheet, int dirty);
+int libo_xl_sheet_set_number(libo_xl_sheet *sheet, int row, int col, double number);
+int libo_xl_sheet_set_text(libo_xl *xl, libo_xl_sheet *sheet, int row, int col, char *text);
+
+libo_xl_storage libo_xl_sheet_get_storage(libo_xl_sheet *sheet);
+int libo_xl_sheet_set_storage(libo_xl_sheet *sheet, libo_xl_storage storage);
+
+libo_xl_encoding libo_xl_sheet_get_column_encoding(libo_xl_sheet *sheet, int col);
+libo_xl_column_type libo_xl_sheet_get_column_type(libo_xl_sheet *sheet, int col);
+long libo_xl_sheet_column_read_numbers(libo_xl_sheet *sheet,
+                                       int col,
+                                       int first_row,
+                                       int last_row,
+                                       double *out);
+long libo_xl_sheet_column_read_dates(libo_xl_sheet *sheet,
+                                     int col,
+                                     int first_row,
+                                     int last_row,
+                                     int date1904,
+                                     double *out);
+long libo_xl_sheet_column_count_range(libo_xl_sheet *sheet,
+                                      int col,
+                                      double lo,
+                                      double hi);
+long libo_xl_sheet_column_count_reference(libo_xl_sheet *sheet,
+                                          int col,
+                                          int reference);
+double libo_xl_sheet_column_sum(libo_xl_sheet *sheet, int col);
+
+int libo_xl_sheet_column_stats(libo_xl_sheet *sheet,
+                               int col,
+                               libo_xl_column_stats *out);
+int libo_xl_sheet_column_stats_range(libo_xl_sheet *sheet,
+                                     int col,
+                                     int first_row,
+                                     int last_row,
+                                     libo_xl_column_stats *out);
+void libo_xl_column_stats_compute(const double *values,
+                                  size_t n,
+                                  libo_xl_column_stats *out);
+
+int libo_xl_sheet_get_column_profile_count(libo_xl_sheet *sheet);
+libo_xl_column_profile *libo_xl_sheet_get_column_profile(libo_xl_sheet *sheet,
+                                                         int col);
+
 char *libo_xl_sheet_get_name(libo_xl_sheet *xls);
 void libo_xl_sheet_set_name(libo_xl_sheet *xls, char *name);
 
@@ -468,11 +1203,48 @@ void libo_xl_sheet_set_freeze(libo_xl_sheet *sheet,
                               int n);
 
 void libo_xl_sheet_add(libo_xl_sheet *xls, libo_xl_row *xlr);
+int libo_xl_sheet_append_matrix(libo_xl_sheet *sheet,
+                                const double *data,
+                                int rows,
+                                int cols,
+                                size_t stride);
+int libo_xl_sheet_append_matrix_int64(libo_xl_sheet *sheet,
+                                      const int64_t *data,
+                                      int rows,
+                                      int cols,
+                                      size_t stride);
+int libo_xl_sheet_append_matrix_strings(libo_xl *xl,
+                                        libo_xl_sheet *sheet,
+                                        const int *data,
+                                        int rows,
+                                        int cols,
+                                        size_t stride);
 
 void libo_xl_sheet_add_filter(libo_xl_sheet *sheet,
                               unsigned int first_column,
                               unsigned int last_column);
 void libo_xl_sheet_remove_filter(libo_xl_sheet *sheet);
+int libo_xl_sheet_sort(libo_xl *xl,
+                       libo_xl_sheet *sheet,
+                       int first_row,
+                       libo_xl_sort_key *keys,
+                       int n_keys);
+libo_xl_sort *libo_xl_sheet_get_sort(libo_xl_sheet *sheet);
+void libo_xl_sheet_remove_sort(libo_xl_sheet *sheet);
+void libo_xl_sheet_show_all(libo_xl_sheet *sheet);
+
+size_t libo_xl_sheet_format_formula(libo_xl_sheet *sheet,
+                                    int row,
+                                    int col,
+                                    char *buffer,
+                                    size_t size);
+char *libo_xl_sheet_get_string_value(libo_xl *xl,
+                                     libo_xl_sheet *sheet,
+                                     int row,
+                                     int col);
+int libo_xl_sheet_get_shared_count(libo_xl_sheet *sheet);
+char *libo_xl_sheet_get_shared(libo_xl_sheet *sheet, int n);
+int libo_xl_sheet_expand_formulas(libo_xl_sheet *sheet);
 
 void libo_xl_sheet_dump(libo_xl_sheet *lxs, FILE *stream, int indent);
 
@@ -493,6 +1265,141 @@ libo_xl_filter *libo_xl_filter_new_with_values(unsigned int first_column,
                                                unsigned int last_column);
 void libo_xl_filter_free(libo_xl_filter *filter);
 
+  /*
+   *  XL sort
+   */
+
+libo_xl_sort *libo_xl_sort_new(void);
+libo_xl_sort *libo_xl_sort_new_with_values(int first_row,
+                                           libo_xl_sort_key *keys,
+                                           int n_keys);
+void libo_xl_sort_free(libo_xl_sort *sort);
+
+  /*
+   *  XL column profile
+   */
+
+libo_xl_column_profile *libo_xl_column_profile_new(void);
+void libo_xl_column_profile_free(libo_xl_column_profile *profile);
+void libo_xl_column_profile_add(libo_xl_column_profile *profile,
+                                libo_xl_cell *cell);
+double libo_xl_column_profile_get_distinct(libo_xl_column_profile *profile);
+void libo_xl_column_profile_dump(libo_xl_column_profile *profile,
+                                 FILE *stream,
+                                 int indent);
+
+  /*
+   *  XL index
+   */
+
+libo_xl_index *libo_xl_index_build(libo_xl_sheet *sheet, int col);
+void libo_xl_index_free(libo_xl_index *idx);
+int libo_xl_index_lookup(libo_xl_index *idx, libo_xl_cell *value);
+int libo_xl_index_lookup_number(libo_xl_index *idx, double number);
+int libo_xl_index_lookup_reference(libo_xl_index *idx, int reference);
+int libo_xl_index_lookup_text(libo_xl_index *idx, libo_xl *xl, char *text);
+int libo_xl_index_next(libo_xl_index *idx, int row);
+
+  /*
+   *  XL sorted index
+   */
+
+libo_xl_sorted_index *libo_xl_sorted_index_build(libo_xl *xl, libo_xl_sheet *sheet, int col);
+void libo_xl_sorted_index_free(libo_xl_sorted_index *idx);
+int libo_xl_sorted_index_is_stale(libo_xl_sorted_index *idx);
+int libo_xl_sorted_index_get_count(libo_xl_sorted_index *idx);
+int libo_xl_sorted_index_get_row(libo_xl_sorted_index *idx, int pos);
+int libo_xl_sorted_index_lower_bound(libo_xl_sorted_index *idx, libo_xl_cell *value);
+int libo_xl_sorted_index_upper_bound(libo_xl_sorted_index *idx, libo_xl_cell *value);
+int libo_xl_sorted_index_lower_bound_number(libo_xl_sorted_index *idx, double number);
+int libo_xl_sorted_index_upper_bound_number(libo_xl_sorted_index *idx, double number);
+int libo_xl_sorted_index_lower_bound_text(libo_xl_sorted_index *idx, char *text);
+int libo_xl_sorted_index_upper_bound_text(libo_xl_sorted_index *idx, char *text);
+int libo_xl_sorted_index_match(libo_xl_sorted_index *idx, libo_xl_cell *value);
+int libo_xl_sorted_index_rows(libo_xl_sorted_index *idx, int first, int last, int *rows);
+int libo_xl_rows_intersect(const int *a, int na, const int *b, int nb, int *rows);
+int libo_xl_rows_union(const int *a, int na, const int *b, int nb, int *rows);
+
+  /*
+   *  XL view
+   */
+
+libo_xl_view *libo_xl_view_filter(libo_xl_sheet *sheet, libo_xl_predicate *pred);
+libo_xl_view *libo_xl_view_and(libo_xl_view *a, libo_xl_view *b);
+libo_xl_view *libo_xl_view_or(libo_xl_view *a, libo_xl_view *b);
+void libo_xl_view_free(libo_xl_view *view);
+int libo_xl_view_get_count(libo_xl_view *view);
+int libo_xl_view_contains(libo_xl_view *view, int row);
+int libo_xl_view_next(libo_xl_view *view, int row);
+libo_xl_sheet *libo_xl_view_to_sheet(libo_xl_view *view);
+int libo_xl_view_apply(libo_xl_view *view,
+                       unsigned int first_column,
+                       unsigned int last_column);
+
+  /*
+   *  XL schema
+   */
+
+libo_xl_schema *libo_xl_sheet_schema(libo_xl *xl, libo_xl_sheet *sheet, int header_row);
+void libo_xl_schema_free(libo_xl_schema *schema);
+int libo_xl_schema_get_column_count(libo_xl_schema *schema);
+char *libo_xl_schema_get_name(libo_xl_schema *schema, int col);
+int libo_xl_schema_get_column(libo_xl_schema *schema, char *name);
+
+int libo_xl_sheet_get_record(libo_xl_sheet *sheet,
+                             libo_xl_schema *schema,
+                             int n,
+                             libo_xl_record *rec);
+int libo_xl_sheet_stream_records(libo *l,
+                                 libo_xl_sheet *sheet,
+                                 int header_row,
+                                 libo_xl_record_handler handler,
+                                 void *data);
+
+libo_xl_cell *libo_xl_record_get_cell(libo_xl_record *rec, char *name);
+double libo_xl_record_get_number(libo_xl_record *rec, char *name);
+char *libo_xl_record_get_text(libo_xl_record *rec, char *name);
+
+  /*
+   *  XL binding
+   */
+
+long libo_xl_sheet_bind(libo *l,
+                        libo_xl_sheet *sheet,
+                        int first,
+                        int last,
+                        libo_xl_field *field,
+                        int n_fields,
+                        size_t size,
+                        void **records);
+
+  /*
+   *  XL formula
+   */
+
+char *libo_xl_formula_to_r1c1(const char *formula, int row, int col);
+size_t libo_xl_formula_from_r1c1(const char *r1c1,
+                                 int row,
+                                 int col,
+                                 char *buffer,
+                                 size_t size);
+
+  /*
+   *  XL calc
+   */
+
+libo_xl_calc *libo_xl_calc_new(libo_xl *xl);
+void libo_xl_calc_free(libo_xl_calc *calc);
+int libo_xl_calc_get_formula_count(libo_xl_calc *calc);
+int libo_xl_calc_recalculate(libo_xl_calc *calc);
+int libo_xl_calc_mark(libo_xl_calc *calc, libo_xl_sheet *sheet, int row, int col);
+int libo_xl_calc_update(libo_xl_calc *calc);
+int libo_xl_calc_get_value(libo_xl_calc *calc,
+                           libo_xl_sheet *sheet,
+                           int row,
+                           int col,
+                           libo_xl_value *value);
+
   /*
    *  XL row
    */
@@ -505,6 +1412,8 @@ int libo_xl_row_get_cell_count(libo_xl_row *xlr);
 
 libo_xl_cell *libo_xl_row_get_cell(libo_xl_row *xlr, int n);
 
+size_t libo_xl_row_memory_size(libo_xl_row *row);
+
 void libo_xl_row_add(libo_xl_row *xlr, libo_xl_cell *xlc);
 
 void libo_xl_row_dump(libo_xl_row *row, FILE *stream, int indent);
@@ -521,7 +1430,12 @@ void libo_xl_cell_free(libo_xl_cell *cell);
 libo_xl_cell_type libo_xl_cell_get_type(libo_xl_cell *xlc);
 void libo_xl_cell_set_type(libo_xl_cell *xlc, libo_xl_cell_type type);
 
+size_t libo_xl_cell_memory_size(libo_xl_cell *cell);
+
 char *libo_xl_cell_get_string_value(libo_xl *xl, libo_xl_cell *xlc);
+const char *libo_xl_cell_get_string_view(libo_xl *xl, libo_xl_cell *xlc, size_t *length);
+size_t libo_xl_cell_format_number(libo_xl_cell *xlc, char *buffer, size_t size);
+int libo_xl_cell_get_value(libo_xl *xl, libo_xl_cell *xlc, libo_xl_value *value);
 
 int libo_xl_cell_get_reference(libo_xl_cell *xlc);
 void libo_xl_cell_set_reference(libo_xl_cell *xlc, int reference);
@@ -541,6 +1455,18 @@ void libo_xl_cell_expression_set_value(libo_xl_cell_expression *xlce, char *valu
 double libo_xl_cell_get_number(libo_xl_cell *xlc);
 void libo_xl_cell_set_number(libo_xl_cell *xlc, double number);
 
+int libo_xl_cell_get_style(libo_xl_cell *xlc);
+void libo_xl_cell_set_style(libo_xl_cell *xlc, int style);
+
+int libo_xl_cell_get_boolean(libo_xl_cell *xlc);
+void libo_xl_cell_set_boolean(libo_xl_cell *xlc, int boolean);
+
+libo_xl_error libo_xl_cell_get_error(libo_xl_cell *xlc);
+void libo_xl_cell_set_error(libo_xl_cell *xlc, libo_xl_error error);
+
+double libo_xl_cell_get_date(libo_xl_cell *xlc, int date1904);
+int libo_xl_cell_set_date(libo_xl_cell *xlc, double seconds, int date1904);
+
 void libo_xl_cell_dump(libo_xl_cell *cell, FILE *stream, int indent);
 
   /*
@@ -548,6 +1474,11 @@ void libo_xl_cell_dump(libo_xl_cell *cell, FILE *stream, int indent);
    */
 
 char *libo_xl_cell_type_to_string(libo_xl_cell_type ct);
+const char *libo_xl_error_to_string(libo_xl_error error);
+libo_xl_error libo_xl_error_from_string(const char *text);
+int libo_xl_number_format_is_date(const char *code);
+char *libo_xl_encoding_to_string(libo_xl_encoding encoding);
+char *libo_xl_column_type_to_string(libo_xl_column_type type);
 char *libo_type_to_string(libo_type lt);
 
 #endif //LIBO_H
@@ -28,6 +28,22 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define X86_KERNELS 1  /**<  switches on SSE2 and AVX2 column kernels  */
+#endif
+
+#include <libxml/xmlreader.h>
+#include <zlib.h>
 
 #include "libo.h"
 
@@ -37,1667 +53,2898 @@
 #define XPATH_ENABLED 0  /**<  switches off XPath code when needed  */
 #endif
 
-static void cell_ref_to_row_col(char *ref, int *row, int *col);
-static int is_office(libo *l);
-static int is_supported(libo *l);
-static libo_type get_type(libo *l);
-static void do_indent(FILE *stream, int indent);
-static char *find_app_type_name_in_xml(xmlDocPtr doc);
-static int count_sheets_in_xml(xmlDocPtr doc);
-static int count_sheet_rows_in_xml(xmlDocPtr doc);
-static int count_sheet_columns_in_xml(xmlDocPtr doc);
-static libo_xl_cell_type string_to_libo_xl_cell_type(char *s);
-static int libo_xl_write(libo *l);
-static void libo_xl_sheet_count_columns(libo_xl_sheet *xls);
-static int libo_xl_themes_write(libo *l);
-static int libo_xl_styles_write(libo *l);
-static int libo_xl_docprops_write(libo *l);
-static int libo_xl_docprops_app_write(libo *l);
-static int libo_xl_docprops_core_write(libo *l);
-static int libo_xl_xl_rels_write(libo *l);
-static int libo_xl__rels_dot_rels_write(libo *l);
-static int libo_xl_xl_rels_workbook_rels_write(libo *l);
-static int libo_xl_content_types_write(libo *l);
-static int libo_xl_workbook_write(libo *l);
-static int libo_xl_sheets_write(libo *l);
-static int libo_xl_sheet_write(libo *l, int sheet);
-static char *strapp(char *s1, char *s2);
-static int libo_xl_shared_strings_write(libo *l);
-static void libo_xl_renumber_strings(libo *l);
-static int libo_xl_shared_strings_write(libo *l);
-static void libo_xl_sheet_dimension_add(libo *l, int sheet, char **buf);
-static void libo_xl_sheet_sheetviews_add(libo *l, int sheet, char **buf);
-static void libo_xl_sheet_formatpr_add(libo *l, int sheet, char **buf);
-static void libo_xl_sheet_cols_add(libo *l, int sheet, char **buf);
-static void libo_xl_sheet_sheetdata_add(libo *l, int sheet, char **buf);
-static void libo_xl_sheet_sheetdata_row_add(libo *l,
-                                                int sheet,
-                                                int row,
-                                                char **buf);
-static void libo_xl_sheet_sheetdata_row_col_add(libo *l,
-                                                    int sheet,
-                                                    int row,
-                                                    int col,
-                                                    char **buf);
-static void libo_xl_sheet_filter_add(libo *l, int sheet, char **buf);
-static void libo_xl_strings_count_action(avl_node *n);
-static void libo_xl_strings_add_action(avl_node *n);
-static char *column_number_to_reference(unsigned int n);
-static char *reverse(char *s);
-static void libo_xl_row_fill(libo_xl_sheet *sheet, int max_row);
-static void libo_xl_col_fill(libo_xl_sheet *sheet, int row, int max_col);
-static void string_dumper(avl_node *n);
-static void libo_xl_cell_clear(libo_xl_cell *cell);
-static libo_xl_column **libo_xl_sheet_columns_create_defaults(libo_xl_sheet *sheet);
+  /**
+   *  @typedef cell_size_check
+   *
+   *  @brief fails to compile if type, format and shared formula of a cell
+   *         take more than the 8 bytes ahead of its value
+   */
 
-static int _strings_count = 0;     /**<  used when counting XL strings  */
-static char *_strings_buf = NULL;  /**<  used when accumulating strings
-                                         into XML buffer  */
+typedef char cell_size_check[(sizeof(libo_xl_cell) <= 8 + sizeof(libo_xl_cell_expression)) ? 1 : -1];
+
+  /**
+   *  @typedef struct pack_buffer pack_buffer;
+   *
+   *  @brief growable buffer holding binary form of rows
+   */
 
+typedef struct
+{
+  unsigned char *data;  /**<  packed bytes           */
+  size_t len;           /**<  number of bytes used   */
+  size_t size;          /**<  number of bytes allocated  */
+} pack_buffer;
+
+#define LIBO_XL_STORE_BLOCK 65536  /**<  packed bytes per block of stored rows  */
+#define LIBO_XL_STORE_PAGES 8      /**<  decoded blocks cached per thread       */
+#define LZ_HASH_BITS 12            /**<  size of match table of compressor      */
+#define LIBO_XL_STORE_GROUP 4096   /**<  rows per block of a columnar store     */
+#define LIBO_XL_DICTIONARY_MAX 65536  /**<  most distinct values in a dictionary  */
+#define LIBO_XL_PROFILE_BITS 11    /**<  log2 of LIBO_XL_PROFILE_REGISTERS      */
+#define LIBO_XL_SORT_THREADS 8    /**<  most threads sharing one sort          */
+#define LIBO_XL_SORT_MIN 16384     /**<  fewest items sorted by several threads  */
+#define LIBO_XL_VIEW_SPAN 65536    /**<  rows covered by one container of a view  */
+#define LIBO_XL_VIEW_WORDS 1024    /**<  words of bits of one container           */
+#define LIBO_XL_VIEW_ARRAY_MAX 4096  /**<  most rows of a container kept as array  */
+#define LIBO_XL_VIEW_BLOCK 4096    /**<  rows tested by a kernel at a time        */
+#define LIBO_XL_VIEW_SET_MAX 32    /**<  largest set of ids tested by a kernel    */
+#define LIBO_XL_SCHEMA_CACHE 16    /**<  names a schema remembers by address      */
+#define LIBO_XL_SEEK_WINDOW 32768  /**<  bytes of XML deflate refers back to      */
+#define LIBO_XL_SEEK_INPUT 16384   /**<  compressed bytes read at a time          */
+#define LIBO_XL_SEEK_PROLOG 1048576  /**<  most bytes of XML before first row     */
+#define LIBO_XL_FORMAT_CELLS 16384  /**<  most cells formatted by the writer at once  */
+#define LIBO_XL_CALC_ROWS 1048576  /**<  rows a formula may refer to             */
+#define LIBO_XL_CALC_COLS 16384    /**<  columns a formula may refer to          */
+#define LIBO_XL_CALC_BLOCK 4096    /**<  bytes of text made by formulas at once  */
 
   /**
-   *  @fn void libo_init(void)
+   *  @typedef enum chunk_kind
    *
-   *  @brief initialize libo library for later use
+   *  @brief kind of values held by a column chunk
+   */
+
+typedef enum
+{
+  chunk_kind_number,     /**<  typed cells are numbers             */
+  chunk_kind_integer,    /**<  typed cells are whole numbers       */
+  chunk_kind_reference,  /**<  typed cells are shared string ids   */
+  chunk_kind_boolean,    /**<  typed cells are booleans            */
+  chunk_kind_error,      /**<  typed cells are error codes         */
+  chunk_kind_cells       /**<  no dominant type, all cells packed  */
+} chunk_kind;
+
+  /**
+   *  @typedef struct column_chunk column_chunk;
    *
-   *  @par Parameters
-   *  None.
+   *  @brief cells of one column of a block of a columnar store
    *
-   *  @par Returns
-   *  Nothing.
+   *  Cells of the dominant type of the column are typed values, held as
+   *  64 bit keys, the bits of the double, the integer, the id, the boolean
+   *  or the error code, encoded with whichever of @a libo_xl_encoding takes
+   *  the least memory.  Booleans and errors pack into a bit or a few.  The
+   *  few other cells are exceptions, packed as a row, with their positions.
    */
 
-void libo_init(void)
+typedef struct
 {
-  xmlInitParser();
-  LIBXML_TEST_VERSION
-
-  return;
-}
+  chunk_kind kind;            /**<  kind of typed values                    */
+  libo_xl_encoding encoding;  /**<  encoding of typed values                */
+  int n_cells;                /**<  number of cells in chunk                */
+  int n_values;               /**<  number of typed values                  */
+  int n_entries;              /**<  number of runs, or dictionary entries   */
+  int width;                  /**<  bits per packed index or offset         */
+  int64_t base;               /**<  smallest integer, frame encoding        */
+  unsigned short style;       /**<  cell format of every typed value        */
+  unsigned char date;         /**<  1 if typed values are dates             */
+  uint64_t *values;           /**<  plain values, run values, dictionary    */
+  unsigned int *ends;         /**<  index just past each run                */
+  uint64_t *packed;           /**<  bit-packed indices or offsets           */
+  int n_exceptions;           /**<  number of cells not of kind             */
+  unsigned int *at;           /**<  position of each exception, NULL if
+                                    every cell is one                       */
+  unsigned char *cells;       /**<  packed exception cells                  */
+  size_t len;                 /**<  number of bytes in cells                */
+} column_chunk;
 
   /**
-   *  @fn void libo_cleanup(void)
+   *  @typedef struct column_census column_census;
    *
-   *  @brief called after all use of libo is complete
+   *  @brief tally of cells of a column, from which its type is inferred
+   */
+
+typedef struct
+{
+  int n;           /**<  number of cells            */
+  int numbers;     /**<  number of numbers          */
+  int integral;    /**<  number of whole numbers    */
+  int references;  /**<  number of shared strings   */
+  int booleans;    /**<  number of booleans         */
+  int errors;      /**<  number of error codes      */
+} column_census;
+
+  /**
+   *  @typedef struct column_predicate column_predicate;
    *
-   *  @par Parameters
-   *  None.
+   *  @brief condition tested against cells of a column
+   */
+
+typedef struct
+{
+  libo_xl_cell_type type;  /**<  number for a range, reference for an id  */
+  double lo;               /**<  smallest matching number                  */
+  double hi;               /**<  largest matching number                   */
+  int reference;           /**<  matching shared string id                 */
+} column_predicate;
+
+  /**
+   *  @typedef struct store_block store_block;
    *
-   *  @par Returns
-   *  Nothing.
+   *  @brief index entry locating a block of packed rows
    */
 
-void libo_cleanup(void)
+typedef struct
 {
-  xmlCleanupParser();
+  size_t offset;        /**<  position of block in spill file           */
+  size_t len;           /**<  number of bytes stored for block          */
+  size_t raw_len;       /**<  number of packed bytes before compression  */
+  unsigned char *data;  /**<  compressed block, NULL if in spill file   */
+  int first_row;        /**<  index of first row in block               */
+  int n_rows;           /**<  number of rows in block                   */
+  int width;            /**<  cells in widest row, columnar blocks      */
+  int *widths;          /**<  cells in each row, NULL if all are wide   */
+  int n_chunks;         /**<  number of columns, columnar blocks        */
+  column_chunk *chunk;  /**<  encoded columns, columnar blocks          */
+} store_block;
 
-  return;
-}
+  /**
+   *  @typedef struct store_page store_page;
+   *
+   *  @brief block of stored rows decoded into memory
+   */
+
+typedef struct
+{
+  unsigned long store;  /**<  serial of owning store, 0 if unused  */
+  int block;            /**<  index of decoded block               */
+  int n_rows;           /**<  number of decoded rows               */
+  libo_xl_row **row;    /**<  decoded rows                         */
+  unsigned long used;   /**<  cache clock at last access           */
+} store_page;
 
   /**
-   *  @fn libo *libo_new(void)
+   *  @typedef struct store_cache store_cache;
    *
-   *  @brief creates a new @a libo struct
+   *  @brief blocks most recently decoded by one thread
+   */
+
+typedef struct
+{
+  store_page page[LIBO_XL_STORE_PAGES];  /**<  decoded blocks                     */
+  unsigned long clock;                   /**<  incremented on each block lookup  */
+} store_cache;
+
+  /**
+   *  @struct libo_xl_store
    *
-   *  @par Parameters
-   *  None.
+   *  @brief rows of a work sheet packed into blocks
    *
-   *  @return pointer to new @a libo struct
+   *  Blocks are located through an in memory index.  They live either in a
+   *  temporary file, read through a read only mapping, on the heap,
+   *  compressed, or on the heap as encoded columns.  Rows are only ever
+   *  handed out from blocks decoded into the cache of the calling thread.
    */
 
-libo *libo_new(void)
+struct libo_xl_store
 {
-  libo *l;
-
-  l = (libo *)malloc(sizeof(libo));
-  if (!l) return NULL;
+  libo_xl_storage type;   /**<  where blocks are kept                  */
+  unsigned long serial;   /**<  identifies store in caches             */
+  FILE *fp;               /**<  spill file, NULL if compressed         */
+  size_t size;            /**<  bytes of all blocks                    */
+  unsigned char *map;     /**<  mapping of spill file, or NULL         */
+  size_t map_size;        /**<  bytes mapped                           */
+  int n_rows;             /**<  rows in store                          */
+  int n_blocks;           /**<  number of blocks                       */
+  store_block *block;     /**<  index of blocks                        */
+  pack_buffer pending;    /**<  rows not yet sealed into a block       */
+  int pending_rows;       /**<  number of rows not yet sealed          */
+  pthread_mutex_t lock;   /**<  serializes changes to index and file   */
+};
 
-  memset(l, 0, sizeof(libo));
+  /**
+   *  @typedef int (*row_handler)(libo_xl_row *row, int n, void *data)
+   *
+   *  @brief called for each row of a streamed work sheet, returns non-zero
+   *         to stop reading
+   */
 
-  return l;
-}
+typedef int (*row_handler)(libo_xl_row *row, int n, void *data);
 
   /**
-   *  @fn libo *libo_dup(libo *l)
-   *
-   *  @brief creates a deep copy of @p l
+   *  @typedef int (*row_select)(int n, void *data)
    *
-   *  @param l - pointer to existing libo struct
+   *  @brief called before row @p n of a streamed work sheet is built,
+   *         returns 1 to build it, 0 to pass over it, -1 to stop reading
+   */
+
+typedef int (*row_select)(int n, void *data);
+
+  /**
+   *  @typedef struct row_range row_range;
    *
-   *  @return pointer to new @a libo struct
+   *  @brief rows of a work sheet to read
    */
 
-libo *libo_dup(libo *l)
+typedef struct
 {
-  libo *nl = NULL;
+  int first;  /**<  first row read                   */
+  int last;   /**<  row after last row, -1 for all   */
+} row_range;
 
-  if (!l) goto exit;
+  /**
+   *  @typedef struct row_sample row_sample;
+   *
+   *  @brief rows of a work sheet sampled at random
+   */
 
-  nl = libo_new();
-  if (!nl) goto exit;
+typedef struct
+{
+  libo_xl_sheet *sheet;  /**<  sheet receiving rows                  */
+  int header_rows;       /**<  leading rows always kept              */
+  int k;                 /**<  number of rows sampled                */
+  int n;                 /**<  number of rows held                   */
+  uint64_t state;        /**<  state of random numbers               */
+  int slot;              /**<  entry receiving next row, -1 for none */
+  libo_xl_row **row;     /**<  rows held                             */
+  int *index;            /**<  position in sheet of each row held    */
+} row_sample;
 
-  if (l->path) nl->path = strdup(l->path);
-  nl->type = l->type;
-  nl->z = NULL;
+  /**
+   *  @typedef struct number_batch number_batch;
+   *
+   *  @brief numbers of a span of rows formatted a column at a time, for the
+   *         writer
+   */
 
-  switch (l->type)
-  {
-    case libo_type_doc:
-      nl->doc = libo_doc_dup(l->doc);
-      break;
+typedef struct
+{
+  int first;        /**<  first row of span                                */
+  int n_rows;       /**<  number of rows in span                           */
+  int n_cols;       /**<  number of columns in span                        */
+  int size_rows;    /**<  rows allocated                                   */
+  int size_cols;    /**<  columns allocated                                */
+  double *number;   /**<  numbers of one column, gathered                  */
+  int *at;          /**<  row in span of each gathered number              */
+  size_t *start;    /**<  offset of each formatted number in text          */
+  size_t *offset;   /**<  offset in text of each cell, or -1 if no number  */
+  char *text;       /**<  formatted numbers                                */
+} number_batch;
 
-    case libo_type_pp:
-      nl->pp = libo_pp_dup(l->pp);
-      break;
+  /**
+   *  @typedef struct formula_runs formula_runs;
+   *
+   *  @brief runs of cells down each column sharing a formula, for the
+   *         writer
+   */
 
-    case libo_type_xl:
-      nl->xl = libo_xl_dup(l->xl);
-      break;
+typedef struct
+{
+  int n_cols;    /**<  number of columns                               */
+  int *end;      /**<  row after run of each column, 0 if none         */
+  int *si;       /**<  shared index of run of each column              */
+  int n_groups;  /**<  number of shared indexes given                  */
+} formula_runs;
 
-    case libo_type_none:
-    default:
-      break;
-  }
+  /**
+   *  @typedef struct formula_ref formula_ref;
+   *
+   *  @brief cell, whole column or whole row named by a formula
+   */
 
-exit:
-  return nl;
-}
+typedef struct
+{
+  int row;    /**<  index of row, -1 for a whole column          */
+  int col;    /**<  index of column, -1 for a whole row          */
+  int fixed;  /**<  1 if row is absolute, 2 if column is         */
+  int bad;    /**<  1 if reference falls outside a work sheet    */
+} formula_ref;
 
   /**
-   *  @fn void libo_free(libo *l)
+   *  @typedef struct index_slot index_slot;
    *
-   *  @brief frees all memory allocated to @p l
+   *  @brief one distinct value of a hash index, with its rows
+   */
+
+typedef struct
+{
+  uint64_t key;            /**<  bits of number, or string id                */
+  libo_xl_cell_type type;  /**<  type of value                               */
+  int head;                /**<  first row holding value, -1 if slot is free  */
+  int tail;                /**<  last row holding value                      */
+} index_slot;
+
+  /**
+   *  @struct libo_xl_index
    *
-   *  @param l - pointer to existing @a libo struct
+   *  @brief hash index over the values of one column of a work sheet
    *
-   *  @par Returns
-   *  Nothing.
+   *  Numbers are keyed by their bits, and shared strings by their id, so no
+   *  strings are compared.  Rows holding the same value are chained in
+   *  order.  The index is rebuilt on the next lookup once cells of the
+   *  sheet change.
    */
 
-void libo_free(libo *l)
+struct libo_xl_index
 {
-  if (!l) return;
+  libo_xl_sheet *sheet;    /**<  indexed work sheet                       */
+  int col;                 /**<  indexed column                           */
+  unsigned long version;   /**<  version of sheet when built              */
+  int n_slots;             /**<  number of slots, a power of two          */
+  index_slot *slot;        /**<  open addressed table of values           */
+  int n_rows;              /**<  number of rows when built                */
+  int *next;               /**<  next row holding same value, or -1       */
+  pthread_rwlock_t lock;   /**<  shared by lookups, exclusive to rebuild  */
+};
 
-  if (l->path) free(l->path);
-  switch (l->type)
-  {
-    case libo_type_none: break;
-    case libo_type_xl: libo_xl_free(l->xl); break;
-    case libo_type_doc: libo_doc_free(l->doc); break;
-    case libo_type_pp: libo_pp_free(l->pp); break;
-  }
+  /**
+   *  @typedef struct sorted_entry sorted_entry;
+   *
+   *  @brief one row of a sorted index, with its sort key
+   */
 
-  libo_close(l);
+typedef struct
+{
+  double key;  /**<  number, or rank of shared string  */
+  int kind;    /**<  0 for numbers, 1 for text         */
+  int row;     /**<  index of row                      */
+} sorted_entry;
 
-  free(l);
+  /**
+   *  @struct libo_xl_sorted_index
+   *
+   *  @brief rows of one column of a work sheet in sorted order
+   *
+   *  Shared strings are keyed by their rank in sorted order, so rows are
+   *  sorted and searched without comparing strings.
+   */
 
-  return;
-}
+struct libo_xl_sorted_index
+{
+  libo_xl *xl;             /**<  workbook owning strings, or NULL       */
+  libo_xl_sheet *sheet;    /**<  indexed work sheet                     */
+  int col;                 /**<  indexed column                         */
+  unsigned long version;   /**<  version of sheet when built            */
+  int n;                   /**<  number of entries                      */
+  sorted_entry *entry;     /**<  entries in sorted order                */
+  int n_strings;           /**<  number of ids in @a rank               */
+  int *rank;               /**<  rank of each shared string, by id      */
+  int n_ranked;            /**<  number of ids in @a by_rank            */
+  int *by_rank;            /**<  ids of shared strings in sorted order  */
+};
 
   /**
-   *  @fn libo *libo_open(char *path)
-   *
-   *  @brief creates a new @a libo struct from a file
+   *  @typedef int (*perm_compare)(int a, int b, void *data)
    *
-   *  @param path - name of file to open
+   *  @brief compares items @p a and @p b of a permutation being sorted
+   */
+
+typedef int (*perm_compare)(int a, int b, void *data);
+
+  /**
+   *  @typedef struct sort_task sort_task;
    *
-   *  @return pointer to new @a libo struct, NULL on error
+   *  @brief share of a parallel sort done by one thread
    */
 
-libo *libo_open(char *path)
+typedef struct
 {
-  libo *l = NULL;
-  int err = 0;
+  int *perm;         /**<  items being sorted             */
+  int *tmp;          /**<  scratch array                  */
+  int lo;            /**<  first item of run              */
+  int mid;           /**<  first item of second run       */
+  int hi;            /**<  item after last                */
+  perm_compare cmp;  /**<  function comparing items       */
+  void *data;        /**<  passed to @a cmp               */
+} sort_task;
 
-  if (!XPATH_ENABLED)
-  {
-    fprintf(stderr, "XPATH is not enabled in LIBXML2\n");
-    return NULL;
-  }
+  /**
+   *  @typedef struct sort_context sort_context;
+   *
+   *  @brief keys and rows of a sort of a work sheet
+   */
 
-  if (!path) return NULL;
+typedef struct
+{
+  int n_keys;             /**<  number of keys                      */
+  libo_xl_sort_key *key;  /**<  columns sorted by                   */
+  sorted_entry *entry;    /**<  keys of each row, row by row        */
+  libo_xl_row **row;      /**<  rows being sorted                   */
+} sort_context;
 
-  l = libo_new();
-  if (!l) return NULL;
+  /**
+   *  @typedef void (*stats_kernel)(const double *v,
+   *                                size_t n,
+   *                                double *sum,
+   *                                double *min,
+   *                                double *max)
+   *
+   *  @brief sums @p n numbers of @p v, and finds the smallest and largest
+   */
 
-  l->path = strdup(path);
+typedef void (*stats_kernel)(const double *v,
+                             size_t n,
+                             double *sum,
+                             double *min,
+                             double *max);
 
-  l->z = zip_open(path, ZIP_RDONLY, &err);
-  if (!l->z)
-  {
-    fprintf(stderr, "Can not open '%s', error code is %d\n", path, err);
-    return NULL;
-  }
+  /**
+   *  @typedef double (*deviation_kernel)(const double *v,
+   *                                      size_t n,
+   *                                      double mean)
+   *
+   *  @brief returns sum of squared differences of @p n numbers of @p v from
+   *         @p mean
+   */
 
-  if (!is_office(l))
-  {
-    libo_free(l);
-    fprintf(stderr, "'%s' is does not appear to be an Office document\n", path);
-    return NULL;
-  }
+typedef double (*deviation_kernel)(const double *v, size_t n, double mean);
 
-  l->type = get_type(l);
-
-  if (!is_supported(l))
-  {
-    libo_free(l);
-    fprintf(stderr, "'%s' is not a supported Office document\n", path);
-    return NULL;
-  }
+  /**
+   *  @typedef void (*range_kernel)(const double *v,
+   *                                int n,
+   *                                double lo,
+   *                                double hi,
+   *                                uint64_t *bits)
+   *
+   *  @brief sets a bit for each number of @p v from @p lo to @p hi
+   */
 
-  switch (l->type)
-  {
-    case libo_type_none: break;
-    case libo_type_xl:
-      l->xl = libo_xl_read(l);
-      if (!l->xl)
-      {
-        libo_free(l);
-        fprintf(stderr, "Can not establish XL document\n");
-        return NULL;
-      }
-      break;
-    case libo_type_doc:
-      l->doc = libo_doc_new();
-      if (!l->doc)
-      {
-        libo_free(l);
-        fprintf(stderr, "Can not establish DOC document\n");
-        return NULL;
-      }
-      break;
-    case libo_type_pp:
-      l->pp = libo_pp_new();
-      if (!l->pp)
-      {
-        libo_free(l);
-        fprintf(stderr, "Can not establish PP document\n");
-        return NULL;
-      }
-      break;
-  }
+typedef void (*range_kernel)(const double *v, int n, double lo, double hi, uint64_t *bits);
 
+  /**
+   *  @typedef void (*member_kernel)(const int *v,
+   *                                 int n,
+   *                                 const int *ids,
+   *                                 int n_ids,
+   *                                 uint64_t *bits)
+   *
+   *  @brief sets a bit for each id of @p v found in @p ids
+   */
 
-  return l;
-}
+typedef void (*member_kernel)(const int *v, int n, const int *ids, int n_ids, uint64_t *bits);
 
   /**
-   *  @fn int libo_write(libo *l, char *path)
+   *  @typedef struct view_container view_container;
    *
-   *  @brief write libo document to a file
+   *  @brief rows of a view within one span of LIBO_XL_VIEW_SPAN rows
+   */
+
+typedef struct
+{
+  int key;          /**<  index of span                               */
+  int n;            /**<  number of rows                              */
+  uint16_t *array;  /**<  rows within span in order, if few, or NULL  */
+  uint64_t *bits;   /**<  bit for each row of span, if many, or NULL  */
+} view_container;
+
+  /**
+   *  @struct libo_xl_view
    *
-   *  @param l - pointer to existing @a libo struct
-   *  @param path - string containing path to file
+   *  @brief set of rows of a work sheet
    *
-   *  @return 0 on success, STDIO error on failure
+   *  Rows are kept as a compressed bitmap: spans holding few rows keep a
+   *  sorted array of them, spans holding many keep a bit for every row,
+   *  and spans holding none keep nothing.
    */
 
-int libo_write(libo *l, char *path)
+struct libo_xl_view
 {
-  char *fname = NULL;
-  int err = 0;
-  int r = 0;
+  libo_xl_sheet *sheet;       /**<  sheet rows belong to            */
+  int n_containers;           /**<  number of spans holding rows    */
+  int size;                   /**<  number of containers allocated  */
+  view_container *container;  /**<  spans holding rows, in order    */
+  int count;                  /**<  number of rows                  */
+};
 
-  if (!l) return -1;
-
-  if (path) fname = path;
-  else fname = l->path;
+  /**
+   *  @typedef struct view_test view_test;
+   *
+   *  @brief predicate made ready for the filter kernels
+   */
 
-  if (!fname) return -1;
+typedef struct
+{
+  int sets;                /**<  1 for sets of ids, 0 for numbers       */
+  int negate;              /**<  1 to keep numbers outside range        */
+  double lo;               /**<  smallest matching number               */
+  double hi;               /**<  largest matching number                */
+  int n_ids;               /**<  number of ids in set                   */
+  int *ids;                /**<  set of shared string ids               */
+  int n_member;            /**<  number of entries of @a member         */
+  unsigned char *member;   /**<  1 for each id of a large set, or NULL  */
+  double *number;          /**<  numbers of a block of rows             */
+  int *id;                 /**<  ids of a block of rows                 */
+  uint64_t *ordered;       /**<  bits of rows holding numbers           */
+} view_test;
 
-  l->z = zip_open(fname, ZIP_CREATE, &err);
-  if (!l->z)
-  {
-    fprintf(stderr, "Can not open '%s', error code is %d\n", path, err);
-    return -1;
-  }
+  /**
+   *  @typedef struct stream_cell stream_cell;
+   *
+   *  @brief raw values of a cell of a streamed row, kept until the row
+   *         meets its predicates
+   */
 
-  switch (l->type)
-  {
-    case libo_type_xl:
-      r = libo_xl_write(l);
-      break;
-    case libo_type_doc:
-      break;
-    case libo_type_pp:
-      break;
-    default: break;
-  }
+typedef struct
+{
+  int col;   /**<  index of column              */
+  int s;     /**<  style attribute, 0 if none   */
+  char *t;   /**<  type attribute, or NULL      */
+  char *f;   /**<  formula element, or NULL     */
+  char *v;   /**<  value element, or NULL       */
+} stream_cell;
 
-  libo_close(l);
+  /**
+   *  @typedef struct schema_hit schema_hit;
+   *
+   *  @brief column last found for a name, kept by address of the name
+   */
 
-  return r;
-}
+typedef struct
+{
+  char *name;  /**<  name looked up, or NULL   */
+  int col;     /**<  column of name            */
+} schema_hit;
 
   /**
-   *  @fn void libo_close(libo *l)
-   *
-   *  @brief closes the open ZIP file associated with @p l
+   *  @struct libo_xl_schema
    *
-   *  @param l - pointer to existing @a libo struct
-   *
-   *  @par Returns
-   *  Nothing.
+   *  @brief names of the columns of a work sheet, hashed to their columns
    */
 
-void libo_close(libo *l)
+struct libo_xl_schema
 {
-  if (!l) return;
+  libo_xl *xl;                            /**<  workbook holding shared strings       */
+  int n_names;                            /**<  number of columns                     */
+  char **name;                            /**<  heading of each column, NULL if none  */
+  int size;                               /**<  number of slots, a power of 2         */
+  int *slot;                              /**<  column of each slot, -1 if empty      */
+  schema_hit hit[LIBO_XL_SCHEMA_CACHE];   /**<  columns of names last looked up       */
+};
 
-  if (l->z)
-  {
-    zip_close(l->z);
-    l->z = NULL;
-  }
+  /**
+   *  @typedef struct record_stream record_stream;
+   *
+   *  @brief state of a work sheet streamed as records
+   */
 
-  return;
-}
+typedef struct
+{
+  libo_xl *xl;                     /**<  workbook holding shared strings    */
+  int header_row;                  /**<  index of row holding headings      */
+  libo_xl_schema *schema;          /**<  names of columns, once read        */
+  libo_xl_record_handler handler;  /**<  function called with each record   */
+  void *data;                      /**<  passed to @a handler               */
+  int failed;                      /**<  1 if schema could not be built     */
+} record_stream;
 
   /**
-   *  @fn void libo_dump(libo *l, FILE *stream, int indent)
-   *
-   *  @brief dumps contents of @p l to a file, @b STDOUT by default
+   *  @typedef struct seek_point seek_point;
    *
-   *  @param l - pointer to existing @a libo struct
-   *  @param stream - open FILE pointer for writing
-   *  @param indent - initial indentation to use for output
-   *
-   *  @par Returns
-   *  Nothing.
+   *  @brief state of decompression of a work sheet at the end of a deflate
+   *         block, from which decompression can resume
    */
 
-void libo_dump(libo *l, FILE *stream, int indent)
+typedef struct
 {
-  if (!l) return;
+  size_t in;               /**<  bytes of compressed data consumed        */
+  int bits;                /**<  bits of byte before @a in still unused   */
+  size_t out;              /**<  bytes of XML before checkpoint           */
+  int row;                 /**<  rows started before checkpoint           */
+  int n_window;            /**<  bytes of @a window used                  */
+  unsigned char *window;   /**<  XML just before checkpoint               */
+} seek_point;
 
-  if (!stream) stream = stdout;
+  /**
+   *  @struct libo_xl_seek_index
+   *
+   *  @brief checkpoints into the compressed XML of a work sheet
+   */
 
-  do_indent(stream, indent); fprintf(stream, "LIBO:\n");
-  indent += 2;
-  do_indent(stream, indent); fprintf(stream, "Path: %s\n", l->path);
-  do_indent(stream, indent); fprintf(stream, "Type: %s\n", libo_type_to_string(l->type));
-  do_indent(stream, indent); fprintf(stream, "z: %p\n", l->z);
+struct libo_xl_seek_index
+{
+  int sheet;               /**<  index of work sheet                      */
+  int n_cols;              /**<  width of sheet, from its first row       */
+  size_t out;              /**<  bytes of XML scanned for checkpoints     */
+  size_t n_prolog;         /**<  bytes of @a prolog                       */
+  unsigned char *prolog;   /**<  XML up to the name of the first row      */
+  int n_points;            /**<  number of checkpoints                    */
+  int size_points;         /**<  number of checkpoints allocated          */
+  seek_point *point;       /**<  checkpoints, in order                    */
+  int shared_rows;         /**<  rows read for the entries of @a shared   */
+  int n_shared;            /**<  number of entries of @a shared           */
+  char **shared;           /**<  shared formulas, R1C1, by identifier     */
+};
 
-  switch (l->type)
-  {
-    case libo_type_none: break;
-    case libo_type_xl:
-      libo_xl_dump(l->xl, stream, indent);
-      break;
-    case libo_type_doc:
-      libo_doc_dump(l->doc, stream, indent);
-      break;
-    case libo_type_pp:
-      libo_pp_dump(l->pp, stream, indent);
-      break;
-  }
+  /**
+   *  @typedef struct seek_stream seek_stream;
+   *
+   *  @brief raw deflate decompression of a work sheet, which records
+   *         checkpoints, or resumes from one
+   */
 
-  return;
-}
+typedef struct
+{
+  zip_file_t *zf;                                /**<  compressed member       */
+  z_stream strm;                                 /**<  inflate state           */
+  unsigned char in[LIBO_XL_SEEK_INPUT];          /**<  compressed bytes        */
+  unsigned char window[LIBO_XL_SEEK_WINDOW];     /**<  XML last inflated       */
+  size_t have;                                   /**<  bytes of window filled  */
+  size_t sent;                                   /**<  bytes of window read    */
+  int wrapped;                                   /**<  1 once window is reused */
+  size_t out;                                    /**<  bytes of XML inflated   */
+  int match;                                     /**<  chars of "<row" seen    */
+  int rows;                                      /**<  rows started            */
+  int found;                                     /**<  1 once rows are read    */
+  int end;                                       /**<  1 at end of data        */
+  unsigned char *head;                           /**<  XML read before window  */
+  size_t n_head;                                 /**<  bytes of @a head        */
+  size_t sent_head;                              /**<  bytes of @a head read   */
+  libo_xl_seek_index *build;                     /**<  index built, or NULL    */
+  size_t span;                                   /**<  bytes between points    */
+  size_t last;                                   /**<  XML at last checkpoint  */
+} seek_stream;
 
   /**
-   *  @fn libo_type libo_get_type(libo *l)
-   *
-   *  @brief returns document type of @p l
+   *  @typedef struct sheet_reader sheet_reader;
    *
-   *  @param l - pointer to existing @a libo struct
-   *
-   *  @return @a libo_type
+   *  @brief XML reader over a work sheet, and the source it reads
    */
 
-libo_type libo_get_type(libo *l)
+typedef struct
 {
-  if (!l) return libo_type_none;
+  zip_file_t *zf;              /**<  member read from its start, or NULL    */
+  seek_stream *ss;             /**<  member read with checkpoints, or NULL  */
+  seek_point *point;           /**<  checkpoint resumed from, or NULL       */
+  libo_xl_seek_index *build;   /**<  index built while reading, or NULL     */
+  xmlTextReaderPtr reader;     /**<  XML reader over member                 */
+} sheet_reader;
 
-  return l->type;
-}
 
   /**
-   *  @fn void libo_set_type(libo *l, libo_type type)
+   *  @typedef enum calc_kind
    *
-   *  @brief sets type of @p l to @p type
-   *
-   *  @param l - pointer to existing @a libo struct
-   *  @param type - @a libo_type
-   *
-   *  @par Returns
-   *  Nothing.
+   *  @brief kind of value produced while a formula is evaluated
    */
 
-void libo_set_type(libo *l, libo_type type)
+typedef enum
 {
-  if (!l) return;
-
-  libo_close(l);
-
-  switch (l->type)
-  {
-    case libo_type_doc:
-      libo_doc_free(l->doc);
-      break;
+  calc_empty,   /**<  empty cell or missing argument  */
+  calc_number,  /**<  number                          */
+  calc_text,    /**<  text                            */
+  calc_bool,    /**<  TRUE or FALSE                   */
+  calc_error,   /**<  error, such as #N/A             */
+  calc_range    /**<  rectangle of cells              */
+} calc_kind;
 
-    case libo_type_pp:
-      libo_pp_free(l->pp);
-      break;
+  /**
+   *  @typedef enum calc_error_code
+   *
+   *  @brief errors a formula may produce, see @a _calc_errors
+   */
 
-    case libo_type_xl:
-      libo_xl_free(l->xl);
-      break;
+typedef enum
+{
+  calc_error_none,   /**<  no error   */
+  calc_error_null,   /**<  #NULL!     */
+  calc_error_div0,   /**<  #DIV/0!    */
+  calc_error_value,  /**<  #VALUE!    */
+  calc_error_ref,    /**<  #REF!      */
+  calc_error_name,   /**<  #NAME?     */
+  calc_error_num,    /**<  #NUM!      */
+  calc_error_na      /**<  #N/A       */
+} calc_error_code;
 
-    case libo_type_none:
-    default:
-      break;
-  }
+  /**
+   *  @typedef enum calc_op
+   *
+   *  @brief instructions of compiled formulas
+   *
+   *  Operands follow their instruction unaligned, and are read with memcpy.
+   */
 
-  l->type = type;
+typedef enum
+{
+  calc_op_number,    /**<  push number, a double follows                   */
+  calc_op_text,      /**<  push text, an int length and its bytes follow   */
+  calc_op_bool,      /**<  push boolean, a byte follows                    */
+  calc_op_error,     /**<  push error, a byte of @a calc_error_code follows */
+  calc_op_empty,     /**<  push missing argument                           */
+  calc_op_cell,      /**<  push value of cell, sheet, row and col follow   */
+  calc_op_range,     /**<  push range, sheet and two corners follow        */
+  calc_op_negate,    /**<  negate top of stack                             */
+  calc_op_percent,   /**<  divide top of stack by 100                      */
+  calc_op_add,       /**<  add top two values                              */
+  calc_op_subtract,  /**<  subtract top from next                          */
+  calc_op_multiply,  /**<  multiply top two values                         */
+  calc_op_divide,    /**<  divide next by top                              */
+  calc_op_power,     /**<  raise next to power of top                      */
+  calc_op_concat,    /**<  join top two values as text                     */
+  calc_op_eq,        /**<  compare top two values, =                       */
+  calc_op_ne,        /**<  compare top two values, <>                      */
+  calc_op_lt,        /**<  compare top two values, <                       */
+  calc_op_le,        /**<  compare top two values, <=                      */
+  calc_op_gt,        /**<  compare top two values, >                       */
+  calc_op_ge,        /**<  compare top two values, >=                      */
+  calc_op_call       /**<  call function, a byte id and byte count follow  */
+} calc_op;
 
-  switch (l->type)
-  {
-    case libo_type_doc:
-      l->doc = libo_doc_new();
-      break;
+  /**
+   *  @typedef struct calc_area calc_area;
+   *
+   *  @brief rectangle of cells named by a formula, corners inclusive
+   */
 
-    case libo_type_pp:
-      l->pp = libo_pp_new();
-      break;
+typedef struct
+{
+  int sheet;  /**<  index of sheet in book  */
+  int r1;     /**<  first row               */
+  int c1;     /**<  first column            */
+  int r2;     /**<  last row                */
+  int c2;     /**<  last column             */
+} calc_area;
 
-    case libo_type_xl:
-      l->xl = libo_xl_new();
-      break;
+  /**
+   *  @typedef struct calc_value calc_value;
+   *
+   *  @brief value on the stack of an evaluated formula
+   */
 
-    case libo_type_none:
-    default:
-      l->xl = NULL;
-      break;
-  }
-}
+typedef struct
+{
+  calc_kind kind;        /**<  kind of value                              */
+  double number;         /**<  number, or 1 and 0 for TRUE and FALSE      */
+  calc_error_code error; /**<  error, if kind is @a calc_error            */
+  const char *text;      /**<  text, not terminated, if kind is text      */
+  size_t len;            /**<  length of @a text                          */
+  calc_area area;        /**<  cells, if kind is @a calc_range            */
+} calc_value;
 
   /**
-   *  @fn char *libo_get_path(libo *l)
-   *
-   *  @brief returns path to @a libo file
-   *
-   *  @param l - pointer to existing @a libo struct
+   *  @typedef struct calc_node calc_node;
    *
-   *  @return string containing path to file
+   *  @brief cell holding a formula, with its compiled code and last result
    */
 
-char *libo_get_path(libo *l)
+typedef struct
 {
-  if (!l) return NULL;
-
-  return l->path;
-}
+  int sheet;            /**<  index of sheet in book                  */
+  int row;              /**<  row of cell                             */
+  int col;              /**<  column of cell                          */
+  unsigned char *code;  /**<  compiled formula, NULL if cell has none  */
+  size_t n_code;        /**<  bytes of @a code                        */
+  int depth;            /**<  most values @a code stacks              */
+  calc_value value;     /**<  last result                             */
+  char *text;           /**<  text of last result, owned              */
+  int dirty;            /**<  1 if result must be recalculated        */
+  int pending;          /**<  dirty precedents not yet recalculated   */
+} calc_node;
 
   /**
-   *  @fn void libo_set_path(libo *l, char *path)
-   *
-   *  @brief sets path in @p l to @p path
+   *  @typedef struct calc_slot calc_slot;
    *
-   *  @param l - pointer to existing @a libo struct
-   *  @param path - string containing new path
-   *
-   *  @par Returns
-   *  Nothing.
+   *  @brief entry of the table finding formulas by position
    */
 
-void libo_set_path(libo *l, char *path)
+typedef struct
 {
-  if (!l) return;
-  if (l->path) free(l->path);
-  l->path = NULL;
-  if (path) l->path = strdup(path);
-}
+  uint64_t key;  /**<  position of cell, see @a calc_key   */
+  int node;      /**<  index of node, -1 if slot is free  */
+} calc_slot;
 
   /**
-   *  @fn libo_xl *libo_get_xl(libo *l)
+   *  @typedef struct calc_edge calc_edge;
    *
-   *  @brief returns @a libo_xl from @p l
-   *
-   *  @param l - pointer to existing @a libo struct
-   *
-   *  @return pointer to @a libo_xl
+   *  @brief formula reading one cell, chained by position of the cell
    */
 
-libo_xl *libo_get_xl(libo *l)
+typedef struct
 {
-  if (!l) return NULL;
+  uint64_t key;  /**<  position of cell read   */
+  int node;      /**<  formula reading it      */
+  int next;      /**<  next edge, -1 if last   */
+} calc_edge;
 
-  if (l->type == libo_type_xl) return l->xl;
+  /**
+   *  @typedef struct calc_dep calc_dep;
+   *
+   *  @brief formula reading a range of cells
+   */
 
-  return NULL;
-}
+typedef struct
+{
+  calc_area area;  /**<  cells read                   */
+  int node;        /**<  formula, -1 if entry unused  */
+} calc_dep;
 
   /**
-   *  @fn libo_xl_book *libo_xl_get_book(libo_xl *xl)
-   *
-   *  @brief returns @a libo_xl_book from @p xl
-   *
-   *  @param xl - pointer to existing @a libo_xl struct
+   *  @typedef struct calc_column calc_column;
    *
-   *  @return pointer to @a libo_xl_book
+   *  @brief what a formula engine knows of one column of a work sheet
    */
 
-libo_xl_book *libo_xl_get_book(libo_xl *xl)
+typedef struct
 {
-  if (!xl) return NULL;
+  int n_nodes;                  /**<  formulas in column                   */
+  int n_values;                 /**<  expression cells, never lowered      */
+  int n_deps;                   /**<  ranges reading column                */
+  int size_deps;                /**<  entries allocated in @a dep          */
+  int *dep;                     /**<  indices of ranges reading column     */
+  libo_xl_sorted_index *sorted; /**<  sorted index, built on first use     */
+} calc_column;
 
-  return xl->book;
+  /**
+   *  @typedef struct calc_sheet calc_sheet;
+   *
+   *  @brief work sheet of a book seen by a formula engine
+   */
 
-  return NULL;
-}
+typedef struct
+{
+  libo_xl_sheet *sheet;  /**<  work sheet                   */
+  int n_cols;            /**<  entries of @a col            */
+  calc_column *col;      /**<  columns, grown as needed     */
+} calc_sheet;
 
   /**
-   *  @fn int libo_xl_book_get_sheet_count(libo_xl_book *xlb)
-   *
-   *  @brief returns number of work sheets in @p xlb
+   *  @typedef struct calc_block calc_block;
    *
-   *  @param xlb - pointer to existing @a libo_xl_book struct
-   *
-   *  @return count of sheets
+   *  @brief block of text made while formulas are evaluated
    */
 
-int libo_xl_book_get_sheet_count(libo_xl_book *xlb)
+typedef struct calc_block
 {
-  if (!xlb) return 0;
-
-  return xlb->n_sheets;
-}
+  struct calc_block *next;  /**<  block filled before, or NULL  */
+  size_t used;              /**<  bytes used                    */
+  size_t size;              /**<  bytes of @a data              */
+  char data[];              /**<  text                          */
+} calc_block;
 
   /**
-   *  @fn libo_xl_sheet *libo_xl_book_get_sheet(libo_xl_book *xlb, int n)
-   *
-   *  @brief returns specific work sheet in @p xlb
+   *  @struct libo_xl_calc
    *
-   *  @param xlb - pointer to existing @a libo_xl_book struct
-   *  @param n - index of desired sheet
+   *  @brief formulas of a workbook compiled to code, and the cells they read
    *
-   *  @return pointer to @a libo_xl_sheet
+   *  Each formula is compiled once.  Cells read by formulas are chained by
+   *  position to the formulas reading them, and ranges are listed by
+   *  column, so the formulas affected by a change are found without
+   *  looking at any other.
    */
 
-libo_xl_sheet *libo_xl_book_get_sheet(libo_xl_book *xlb, int n)
+struct libo_xl_calc
 {
-  if (!xlb) return NULL;
-
-  if (n < 0) return NULL;
-  if (n >= xlb->n_sheets) return NULL;
-
-  return xlb->sheet[n];
-}
+  libo_xl *xl;            /**<  workbook                                  */
+  int n_sheets;           /**<  number of work sheets                     */
+  calc_sheet *sheet;      /**<  work sheets                               */
+  int n_nodes;            /**<  number of nodes                           */
+  int size_nodes;         /**<  nodes allocated                           */
+  calc_node *node;        /**<  formulas                                  */
+  int n_slots;            /**<  slots of @a slot, a power of two          */
+  calc_slot *slot;        /**<  open addressed table of nodes by position  */
+  int n_edges;            /**<  edges in use                              */
+  int size_edges;         /**<  edges allocated                           */
+  calc_edge *edge;        /**<  cells read by formulas                    */
+  int free_edge;          /**<  first unused edge, -1 if none             */
+  int n_heads;            /**<  chains of edges, a power of two           */
+  int *head;              /**<  first edge of each chain, or -1           */
+  int n_deps;             /**<  ranges allocated                          */
+  calc_dep *dep;          /**<  ranges read by formulas                   */
+  int n_dirty;            /**<  formulas to recalculate                   */
+  int *dirty;             /**<  formulas to recalculate, @a size_nodes    */
+  int *queue;             /**<  formulas ready to recalculate             */
+  int size_stack;         /**<  values allocated in @a stack              */
+  calc_value *stack;      /**<  stack of evaluated formula                */
+  calc_block *block;      /**<  text made by evaluated formula            */
+};
 
   /**
-   *  @fn int libo_xl_sheet_get_row_count(libo_xl_sheet *xls)
-   *
-   *  @brief returns number of rows in @p xls
+   *  @typedef struct calc_compiler calc_compiler;
    *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
-   *
-   *  @return count of rows
+   *  @brief state of a formula being compiled
    */
 
-int libo_xl_sheet_get_row_count(libo_xl_sheet *xls)
+typedef struct
 {
-  if (!xls) return 0;
-
-  return xls->n_rows;
-}
+  libo_xl_calc *calc;   /**<  engine compiling                       */
+  int sheet;            /**<  sheet of unqualified references        */
+  const char *p;        /**<  next character of formula              */
+  unsigned char *code;  /**<  code emitted                           */
+  size_t n;             /**<  bytes of @a code                       */
+  size_t size;          /**<  bytes allocated                        */
+  int depth;            /**<  values stacked at this point           */
+  int max;              /**<  most values stacked                    */
+  int error;            /**<  1 if formula could not be compiled     */
+} calc_compiler;
 
   /**
-   *  @fn int libo_xl_sheet_get_column_count(libo_xl_sheet *xls)
-   *
-   *  @brief returns number of columns in @p xls
+   *  @typedef void (*calc_function)(libo_xl_calc *calc,
+   *                                 calc_value *arg,
+   *                                 int n,
+   *                                 calc_value *out)
    *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @brief function callable from formulas, sets @p out from @p n
+   *         arguments @p arg
+   */
+
+typedef void (*calc_function)(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+
+  /**
+   *  @typedef struct calc_builtin calc_builtin;
    *
-   *  @return count of columns
+   *  @brief function known to formulas
    */
 
-int libo_xl_sheet_get_column_count(libo_xl_sheet *xls)
+typedef struct
 {
-  if (!xls) return 0;
-
-  return xls->n_cols;
-}
+  const char *name;    /**<  name, in upper case    */
+  int min_args;        /**<  fewest arguments       */
+  int max_args;        /**<  most arguments         */
+  calc_function call;  /**<  implementation         */
+} calc_builtin;
 
   /**
-   *  @fn char *libo_xl_sheet_get_name(libo_xl_sheet *xls)
-   *
-   *  @brief returns title of @p xls
-   *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @typedef struct calc_aggregate calc_aggregate;
    *
-   *  @return string containing title/name of work sheet
+   *  @brief running aggregates of the numbers of function arguments
    */
 
-char *libo_xl_sheet_get_name(libo_xl_sheet *xls)
+typedef struct
 {
-  if (!xls) return NULL;
-
-  return xls->name;
-}
+  double sum;             /**<  sum of numbers             */
+  double product;         /**<  product of numbers         */
+  double min;             /**<  smallest number            */
+  double max;             /**<  largest number             */
+  long count;             /**<  number of numbers          */
+  long values;            /**<  number of non-empty values */
+  int full;               /**<  1 if product and values are needed, which
+                                column kernels do not give              */
+  calc_error_code error;  /**<  first error met            */
+} calc_aggregate;
 
   /**
-   *  @fn int libo_xl_sheet_get_id(libo_xl_sheet *xls)
-   *
-   *  @brief returns identifier of @p xls
+   *  @typedef struct calc_criteria calc_criteria;
    *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
-   *
-   *  @return integer identifier
+   *  @brief condition of COUNTIF and SUMIF
    */
 
-int libo_xl_sheet_get_id(libo_xl_sheet *xls)
+typedef struct
 {
-  if (!xls) return 0;
-
-  return xls->ID;
-}
+  calc_op op;         /**<  comparison, @a calc_op_eq to @a calc_op_ge  */
+  calc_value value;   /**<  value compared against                      */
+  int wildcards;      /**<  1 if text holds * or ?                      */
+} calc_criteria;
 
   /**
-   *  @fn char *libo_xl_sheet_get_rid(libo_xl_sheet *xls)
-   *
-   *  @brief returns relative identifier of @p xls
-   *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @typedef struct style_pool style_pool;
    *
-   *  @return string containing relative identifier
+   *  @brief interned XML of the fonts, fills or borders of a style sheet,
+   *         or codes of its number formats
    */
 
-char *libo_xl_sheet_get_rid(libo_xl_sheet *xls)
+typedef struct
 {
-  if (!xls) return NULL;
-
-  return xls->rID;
-}
+  int n;                /**<  number of entries                       */
+  int size;             /**<  entries allocated                       */
+  char **text;          /**<  text of each entry                      */
+  unsigned long *hash;  /**<  hash of each entry                      */
+  int n_slots;          /**<  slots of @a slot, a power of two        */
+  int *slot;            /**<  open addressed table of entries, or -1  */
+} style_pool;
 
   /**
-   *  @fn libo_xl_row *libo_xl_sheet_get_row(libo_xl_sheet *xls, int n)
+   *  @struct libo_xl_styles
    *
-   *  @brief returns row at index @p n from @p xls
-   *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
-   *  @param n - index of row to retrieve
+   *  @brief fonts, fills, borders, number formats and cell formats of a
+   *         workbook
    *
-   *  @return pointer to @a libo_xl_row
+   *  Fonts, fills and borders are kept as the XML of their elements, and
+   *  cell formats as @a libo_xl_style structs, each interned, so one added
+   *  twice keeps its index.  Parts of the style sheet that nothing refers
+   *  to by index are kept as read.
    */
 
-libo_xl_row *libo_xl_sheet_get_row(libo_xl_sheet *xls, int n)
+struct libo_xl_styles
 {
-  if (!xls) return NULL;
+  style_pool font;          /**<  fonts                                   */
+  style_pool fill;          /**<  fills                                   */
+  style_pool border;        /**<  borders                                 */
+  style_pool format;        /**<  codes of custom number formats          */
+  int *format_id;           /**<  id of each custom number format         */
+  int next_format;          /**<  id given to next custom number format   */
+  int n_styles;             /**<  number of cell formats                  */
+  int size_styles;          /**<  cell formats allocated                  */
+  libo_xl_style *style;     /**<  cell formats, cellXfs                   */
+  unsigned long *hash;      /**<  hash of each cell format                */
+  unsigned char *date;      /**<  1 for each cell format showing a date   */
+  int n_slots;              /**<  slots of @a slot, a power of two        */
+  int *slot;                /**<  open addressed table of cell formats    */
+  int n_parents;            /**<  number of cell style formats            */
+  libo_xl_style *parent;    /**<  cell style formats, cellStyleXfs        */
+  int n_names;              /**<  number of named cell styles             */
+  char **name;              /**<  attributes of each cellStyle but xfId   */
+  int *name_parent;         /**<  xfId of each cellStyle                  */
+  char *rest;               /**<  dxfs, tableStyles, colors and extLst,
+                                  as read                                 */
+  int *map;                 /**<  index written for each cell format, set
+                                  while a workbook is written             */
+};
 
-  if (n < 0) return NULL;
-  if (n >= xls->n_rows) return NULL;
+static void cell_ref_to_row_col(char *ref, int *row, int *col);
+static int style_slots_grow(int **slot, int *n_slots, unsigned long *hash, int n);
+static void style_slot_put(int *slot, int n_slots, unsigned long h, int index);
+static int style_pool_find(style_pool *pool, const char *text);
+static int style_pool_put(style_pool *pool, const char *text, int intern);
+static void style_pool_clear(style_pool *pool);
+static unsigned long style_hash(libo_xl_style *style);
+static int style_same(libo_xl_style *a, libo_xl_style *b);
+static int style_attr_int(xmlNodePtr node, char *name);
+static char *style_node_xml(xmlDocPtr doc, xmlNodePtr node, int children);
+static void style_parse_xf(xmlDocPtr doc, xmlNodePtr node, libo_xl_style *style);
+static int styles_put_style(libo_xl_styles *styles, libo_xl_style *style, int intern);
+static int styles_put_format(libo_xl_styles *styles, const char *code, int id);
+static int styles_format_is_date(libo_xl_styles *styles, int id);
+static int64_t date_serial_to_epoch(int64_t ms, int64_t date1904);
+static int64_t date_epoch_to_serial(int64_t ms, int64_t date1904);
+static int64_t date_serial_max(int64_t date1904);
+static libo_xl_styles *styles_parse(xmlDocPtr doc);
+static libo_xl_styles *styles_new_standard(void);
+static libo_xl_styles *styles_dup(libo_xl_styles *styles);
+static unsigned char *styles_used(libo_xl_book *book, libo_xl_styles *styles);
+static char *styles_xf_xml(char *buf, libo_xl_style *style, int **map, int *n, int cell);
+static char *styles_xml(libo_xl_styles *styles, unsigned char *used);
+static int is_office(libo *l);
+static int is_supported(libo *l);
+static libo_type get_type(libo *l);
+static void do_indent(FILE *stream, int indent);
+static char *find_app_type_name_in_xml(xmlDocPtr doc);
+static int count_sheets_in_xml(xmlDocPtr doc);
+static int count_sheet_rows_in_xml(xmlDocPtr doc);
+static int count_sheet_columns_in_xml(xmlDocPtr doc);
+static libo_xl_cell_type string_to_libo_xl_cell_type(char *s);
+static int libo_xl_write(libo *l);
+static void libo_xl_sheet_count_columns(libo_xl_sheet *xls);
+static int libo_xl_themes_write(libo *l);
+static int libo_xl_styles_write(libo *l);
+static int libo_xl_docprops_write(libo *l);
+static int libo_xl_docprops_app_write(libo *l);
+static int libo_xl_docprops_core_write(libo *l);
+static int libo_xl_xl_rels_write(libo *l);
+static int libo_xl__rels_dot_rels_write(libo *l);
+static int libo_xl_xl_rels_workbook_rels_write(libo *l);
+static int libo_xl_content_types_write(libo *l);
+static int libo_xl_workbook_write(libo *l);
+static int libo_xl_sheets_write(libo *l);
+static int libo_xl_sheet_write(libo *l, int sheet);
+static char *strapp(char *s1, char *s2);
+static int libo_xl_shared_strings_write(libo *l);
+static void libo_xl_renumber_strings(libo *l);
+static int libo_xl_shared_strings_write(libo *l);
+static void libo_xl_sheet_dimension_add(libo *l, int sheet, char **buf);
+static void libo_xl_sheet_sheetviews_add(libo *l, int sheet, char **buf);
+static void libo_xl_sheet_formatpr_add(libo *l, int sheet, char **buf);
+static void libo_xl_sheet_cols_add(libo *l, int sheet, char **buf);
+static void libo_xl_sheet_sheetdata_add(libo *l,
+                                            int sheet,
+                                            char **buf,
+                                            FILE *stream);
+static void libo_xl_sheet_sheetdata_row_add(libo *l,
+                                                int sheet,
+                                                int row,
+                                                number_batch *batch,
+                                                formula_runs *runs,
+                                                char **buf);
+static void libo_xl_sheet_sheetdata_row_col_add(libo *l,
+                                                    int sheet,
+                                                    int row,
+                                                    int col,
+                                                    char *value,
+                                                    formula_runs *runs,
+                                                    char **buf);
+static void libo_xl_sheet_filter_add(libo *l, int sheet, char **buf);
+static void libo_xl_strings_count_action(avl_node *n);
+static void libo_xl_strings_add_action(avl_node *n);
+static char *column_number_to_reference(unsigned int n);
+static char *reverse(char *s);
+static void libo_xl_row_fill(libo_xl_sheet *sheet, int max_row);
+static void libo_xl_col_fill(libo_xl_sheet *sheet, int row, int max_col);
+static void string_dumper(avl_node *n);
+static void libo_xl_cell_clear(libo_xl_cell *cell);
+static libo_xl_column **libo_xl_sheet_columns_create_defaults(libo_xl_sheet *sheet);
+static unsigned long hash_string(char *s);
+static unsigned long hash_bytes(unsigned long h, void *p, size_t len);
+static int zip_directory_crc(char *path, unsigned long *crc);
+static libo_cache_entry *libo_cache_lookup(libo_cache *cache, char *path);
+static void libo_cache_touch(libo_cache *cache, libo_cache_entry *e);
+static void libo_cache_insert(libo_cache *cache, libo_cache_entry *e);
+static void libo_cache_remove(libo_cache *cache, libo_cache_entry *e);
+static void libo_cache_trim(libo_cache *cache);
+static void libo_cache_entry_free(libo_cache_entry *e);
+static int pack_bytes(pack_buffer *b, void *p, size_t len);
+static int pack_string(pack_buffer *b, char *s);
+static int unpack_bytes(unsigned char **p, unsigned char *end, void *dst, size_t len);
+static char *unpack_string(unsigned char **p, unsigned char *end);
+static int libo_xl_row_pack(libo_xl_row *row, pack_buffer *b);
+static libo_xl_row *libo_xl_row_unpack(unsigned char **p, unsigned char *end);
+static int libo_xl_sheet_evict(libo_xl_book *book, libo_xl_sheet *sheet);
+static int libo_xl_sheet_restore(libo_xl_book *book, libo_xl_sheet *sheet);
+static void book_trim(libo_xl_book *book, libo_xl_sheet *keep);
+static int sheet_unpack(libo_xl_sheet *sheet, FILE *fp);
+static libo_xl_sheet *sheet_copy_rows(libo_xl_book *book, libo_xl_sheet *sheet);
+static void store_cache_key_create(void);
+static store_cache *store_cache_get(void);
+static void store_cache_free(void *cache);
+static void store_page_clear(store_page *page);
+static libo_xl_store *libo_xl_store_new(libo_xl_storage type);
+static void libo_xl_store_free(libo_xl_store *store);
+static int libo_xl_store_append(libo_xl_store *store, libo_xl_row *row);
+static int sheet_append_matrix(libo_xl_sheet *sheet,
+                               libo_xl_field_type type,
+                               const void *data,
+                               int rows,
+                               int cols,
+                               size_t stride);
+static int matrix_check(libo_xl *xl,
+                        libo_xl_field_type type,
+                        const void *data,
+                        int rows,
+                        int cols,
+                        size_t stride);
+static void matrix_cell_set(libo_xl_cell *cell,
+                            libo_xl_field_type type,
+                            const void *data,
+                            size_t i);
+static int format_integer(long long x, char *s);
+static size_t format_numbers(const double *v, int n, char *text, size_t *start);
+static const char *expression_value_type(const char *value);
+static int number_batch_fill(number_batch *batch, libo_xl_sheet *sheet, int first);
+static char *number_batch_get(number_batch *batch, int row, int col);
+static void number_batch_clear(number_batch *batch);
+static int libo_xl_store_flush(libo_xl_store *store);
+static libo_xl_row *libo_xl_store_get_row(libo_xl_store *store, int n);
+static size_t libo_xl_store_memory_size(libo_xl_store *store);
+static int lz_emit(unsigned char **op,
+                   unsigned char *oend,
+                   unsigned char *literals,
+                   size_t n_literals,
+                   size_t offset,
+                   size_t match);
+static size_t lz_compress(unsigned char *src, size_t len, unsigned char *dst, size_t cap);
+static int lz_decompress(unsigned char *src, size_t len, unsigned char *dst, size_t raw_len);
+static int bits_for(uint64_t x);
+static uint64_t bits_get(uint64_t *p, size_t i, int width);
+static void bits_put(uint64_t *p, size_t i, int width, uint64_t v);
+static double column_key_to_number(chunk_kind kind, uint64_t key);
+static int column_number_is_integral(double d);
+static void column_census_add(column_census *census, libo_xl_cell *cell);
+static chunk_kind column_census_kind(column_census *census);
+static int column_kind_is_numeric(chunk_kind kind);
+static int column_cell_is_kind(libo_xl_cell *cell, chunk_kind kind);
+static int column_chunk_is_exception(column_chunk *chunk, int p, int e);
+static libo_xl_row *column_chunk_exceptions(column_chunk *chunk);
+static int column_chunk_build(column_chunk *chunk, libo_xl_cell **cells, int n);
+static int column_chunk_encode(column_chunk *chunk, uint64_t *keys, int n, int integral);
+static int column_chunk_decode(column_chunk *chunk, uint64_t *keys);
+static void column_chunk_clear(column_chunk *chunk);
+static size_t column_chunk_memory_size(column_chunk *chunk);
+static long column_chunk_count(column_chunk *chunk, column_predicate *pred);
+static double column_chunk_sum(column_chunk *chunk, long *count);
+static int column_cell_matches(libo_xl_cell *cell, column_predicate *pred);
+static int column_key_matches(chunk_kind kind, uint64_t key, column_predicate *pred);
+static int column_block_build(store_block *block, pack_buffer *pending, int n_rows);
+static int column_block_decode(store_block *block, libo_xl_row **rows);
+static void column_block_clear(store_block *block);
+static long libo_xl_store_scan(libo_xl_store *store,
+                               int col,
+                               column_predicate *pred,
+                               double *sum);
+static long libo_xl_sheet_column_scan(libo_xl_sheet *sheet,
+                                      int col,
+                                      column_predicate *pred,
+                                      double *sum);
+static void stats_kernels_select(void);
+static void stats_sum_scalar(const double *v,
+                             size_t n,
+                             double *sum,
+                             double *min,
+                             double *max);
+static double stats_deviation_scalar(const double *v, size_t n, double mean);
+#ifdef X86_KERNELS
+static void stats_sum_sse2(const double *v,
+                           size_t n,
+                           double *sum,
+                           double *min,
+                           double *max);
+static double stats_deviation_sse2(const double *v, size_t n, double mean);
+static void stats_sum_avx2(const double *v,
+                           size_t n,
+                           double *sum,
+                           double *min,
+                           double *max);
+static double stats_deviation_avx2(const double *v, size_t n, double mean);
+#endif
+static libo_xl_view *libo_xl_view_new(libo_xl_sheet *sheet);
+static int view_test_init(view_test *test, libo_xl_predicate *pred);
+static void view_test_clear(view_test *test);
+static void view_test_rows(view_test *test,
+                           libo_xl_sheet *sheet,
+                           int col,
+                           int first,
+                           int n,
+                           uint64_t *words);
+static int view_test_token(view_test *test, char *t, char *v);
+static int view_container_add(libo_xl_view *view, int key, const uint64_t *words);
+static void view_container_words(view_container *c, uint64_t *words);
+static view_container *view_container_find(libo_xl_view *view, int key);
+static int view_container_next(view_container *c, int low);
+static libo_xl_view *view_combine(libo_xl_view *a, libo_xl_view *b, int any);
+static void filter_range_scalar(const double *v, int n, double lo, double hi, uint64_t *bits);
+static void filter_member_scalar(const int *v, int n, const int *ids, int n_ids, uint64_t *bits);
+#ifdef X86_KERNELS
+static void filter_range_sse2(const double *v, int n, double lo, double hi, uint64_t *bits);
+static void filter_member_sse2(const int *v, int n, const int *ids, int n_ids, uint64_t *bits);
+static void filter_range_avx2(const double *v, int n, double lo, double hi, uint64_t *bits);
+static void filter_member_avx2(const int *v, int n, const int *ids, int n_ids, uint64_t *bits);
+#endif
+static void column_stats_add(libo_xl_column_stats *acc,
+                             const double *v,
+                             size_t n);
+static void column_stats_finish(libo_xl_column_stats *acc);
+static int column_block_numbers(store_block *block,
+                                int col,
+                                int first,
+                                int last,
+                                double *out);
+static uint64_t hash_mix(uint64_t h);
+static int index_cell_key(libo_xl_cell *cell, uint64_t *key);
+static index_slot *index_find(libo_xl_index *idx, libo_xl_cell_type type, uint64_t key);
+static int libo_xl_index_fill(libo_xl_index *idx);
+static int libo_xl_index_find_row(libo_xl_index *idx, libo_xl_cell_type type, uint64_t key);
+static int int_compare(const void *a, const void *b);
+static int sort_threads(int n);
+static void merge_runs(const int *src, int *dst, int lo, int mid, int hi, perm_compare cmp, void *data);
+static void sort_run(int *perm, int *tmp, int lo, int hi, perm_compare cmp, void *data);
+static void *sort_worker(void *arg);
+static void *merge_worker(void *arg);
+static void sort_tasks_run(sort_task *task, int n, void *(*worker)(void *));
+static int parallel_sort(int *perm, int n, perm_compare cmp, void *data);
+static int string_rank_compare(int a, int b, void *data);
+static int *libo_xl_strings_rank(libo_xl *xl, int *n_strings, int **by_rank, int *n_ranked);
+static int sorted_key_compare(const sorted_entry *a, const sorted_entry *b);
+static int sorted_entry_compare(int a, int b, void *data);
+static int sorted_cell_key(libo_xl_sorted_index *idx, libo_xl_cell *cell, sorted_entry *key);
+static void sorted_text_key(libo_xl_sorted_index *idx, char *text, sorted_entry *key);
+static int sorted_bound(libo_xl_sorted_index *idx, sorted_entry *key, int upper);
+static void sort_cell_key(libo_xl_cell *cell, int *rank, int n_strings, sorted_entry *key);
+static int sort_rows_compare(int a, int b, void *data);
+static void libo_xl_sheet_sortstate_add(libo_xl_sheet *sheet,
+                                        unsigned int first_column,
+                                        unsigned int last_column,
+                                        char **buf);
+static int profile_cell_is_empty(libo_xl_cell *cell);
+static uint64_t profile_cell_hash(libo_xl_cell *cell);
+static void libo_xl_sheet_profile_row(libo_xl_sheet *sheet, libo_xl_row *row);
+static void libo_xl_sheet_profiles_free(libo_xl_sheet *sheet);
+static libo_xl_cell *libo_xl_cell_parse(char *t, int s, char *f, char *v);
+static void libo_xl_cell_parse_value(libo_xl_cell *cell, char *v);
+static libo_xl_cell *libo_xl_cell_new_padding(void);
+static int zip_read_callback(void *context, char *buffer, int len);
+static libo_xl_seek_index *seek_index_new(void);
+static void seek_index_free(libo_xl_seek_index *seek);
+static size_t seek_index_memory_size(libo_xl_seek_index *seek);
+static seek_point *seek_index_find(libo_xl_seek_index *seek, int row);
+static int seek_index_add(seek_stream *s);
+static seek_stream *seek_stream_open(zip_t *z,
+                                     char *path,
+                                     libo_xl_seek_index *seek,
+                                     seek_point *point,
+                                     libo_xl_seek_index *build,
+                                     size_t span);
+static void seek_stream_close(seek_stream *s);
+static int seek_stream_fill(seek_stream *s);
+static int seek_stream_scan(seek_stream *s, size_t start);
+static int seek_stream_read(void *context, char *buffer, int len);
+static int sheet_reader_open(libo *l,
+                             int n,
+                             libo_xl_seek_index **seek,
+                             int first,
+                             int resume,
+                             sheet_reader *sr);
+static void sheet_reader_close(sheet_reader *sr, libo_xl_seek_index **seek);
+static int libo_xl_sheet_stream(libo *l,
+                                libo_xl_sheet *sheet,
+                                int n,
+                                int *source,
+                                libo_xl_seek_index **seek,
+                                int first,
+                                row_select select,
+                                void *select_data,
+                                row_handler handler,
+                                void *data);
+static int stream_slots(int *from, int n, int **slot, int *n_slots);
+static int store_row_handler(libo_xl_row *row, int n, void *data);
+static int libo_xl_sheet_read_stream(libo *l,
+                                     libo_xl_sheet *sheet,
+                                     int n,
+                                     int first,
+                                     row_select select,
+                                     void *select_data,
+                                     row_handler handler,
+                                     void *data);
+static void libo_xl_sheet_read_reset(libo *l, libo_xl_sheet *sheet);
+static int libo_xl_sheet_sample(libo *l, libo_xl_sheet *sheet, int n, int k, unsigned long seed);
+static int int_rank_compare(int a, int b, void *data);
+static int range_select(int n, void *data);
+static int sample_select(int n, void *data);
+static int sample_row_handler(libo_xl_row *row, int n, void *data);
+static int predicate_copy(libo_xl_predicate *dst, libo_xl_predicate *src);
+static libo_xl_schema *schema_build(libo_xl *xl, libo_xl_row *row);
+static char *schema_cell_name(libo_xl *xl, libo_xl_cell *cell, char *buf);
+static int schema_find(libo_xl_schema *schema, char *name);
+static int record_row_handler(libo_xl_row *row, int n, void *data);
+static void bind_value(char *rec,
+                       libo_xl_field *field,
+                       int n_fields,
+                       int col,
+                       char *t,
+                       char *v,
+                       strings *strings);
+static int bind_integer(char *v, double d, int64_t *i64);
+static uint64_t calc_key(int sheet, int row, int col);
+static int calc_find(libo_xl_calc *calc, uint64_t key);
+static int calc_node_get(libo_xl_calc *calc, int sheet, int row, int col);
+static calc_column *calc_column_get(libo_xl_calc *calc, int sheet, int col);
+static int calc_column_is_plain(libo_xl_calc *calc, int sheet, int col);
+static libo_xl_sheet *calc_sheet_get(libo_xl_calc *calc, int sheet);
+static int calc_edge_add(libo_xl_calc *calc, uint64_t key, int node);
+static void calc_edge_remove(libo_xl_calc *calc, uint64_t key, int node);
+static int calc_dep_add(libo_xl_calc *calc, calc_area *area, int node);
+static size_t calc_instr_size(const unsigned char *ip);
+static int calc_node_link(libo_xl_calc *calc, int n, int link);
+static void calc_spread(libo_xl_calc *calc, int first);
+static void calc_touch(libo_xl_calc *calc, int sheet, int row, int col);
+static int calc_dependents(libo_xl_calc *calc, int n, int step, int *queue, int n_queue);
+static int calc_run(libo_xl_calc *calc);
+static void calc_emit(calc_compiler *cc, const void *p, size_t n);
+static void calc_emit_op(calc_compiler *cc, calc_op op, int pushed);
+static void calc_emit_error(calc_compiler *cc, calc_error_code error);
+static void calc_skip(calc_compiler *cc);
+static int calc_ref_parse(const char *s, size_t n, int *row, int *col, int *fixed);
+static size_t calc_word(calc_compiler *cc);
+static size_t formula_word(const char *p);
+static size_t formula_literal(const char *p);
+static int formula_a1_parse(const char *p, size_t n, formula_ref *ref);
+static size_t formula_r1c1_parse(const char *p, int row, int col, formula_ref *ref);
+static const char *formula_r1c1_part(const char *p,
+                                     char axis,
+                                     int base,
+                                     int limit,
+                                     int *value,
+                                     int *fixed,
+                                     int *bad);
+static size_t formula_a1_format(formula_ref *ref, char *s);
+static size_t formula_r1c1_format(formula_ref *ref, int row, int col, char *s);
+static size_t formula_column_format(int col, char *s);
+static void formula_put(char *buffer, size_t size, size_t *len, const char *s, size_t n);
+static int cell_has_formula(libo_xl_cell *cell);
+static int cell_is_number(libo_xl_cell *cell);
+static void cell_resolve_date(libo_xl_cell *cell, libo_xl_sheet *sheet);
+static int sheet_set_dates(libo_xl_sheet *sheet, libo_xl_styles *styles);
+static libo_xl_book *book_read(libo *l, libo_xl_styles *styles);
+static int workbook_date1904(xmlDocPtr doc);
+static char *cell_formula_r1c1(libo_xl_sheet *sheet, libo_xl_cell *cell, int row, int col);
+static int sheet_formula_share(libo_xl_sheet *sheet,
+                               int **group,
+                               int *n_groups,
+                               char *si,
+                               char *text,
+                               int row,
+                               int col);
+static int sheet_row_expand(libo_xl_sheet *sheet, int n, libo_xl_row *row);
+static int cell_formula_expand(libo_xl_sheet *sheet, libo_xl_cell *cell, int row, int col);
+static void sheet_row_dump(libo_xl_sheet *sheet,
+                           int n,
+                           libo_xl_row *row,
+                           FILE *stream,
+                           int indent);
+static void cell_dump(libo_xl_cell *cell, const char *formula, FILE *stream, int indent);
+static void sheet_shared_free(libo_xl_sheet *sheet);
+static char *stream_formula_share(xmlTextReaderPtr reader,
+                                  int row,
+                                  int col,
+                                  int keep,
+                                  char ***shared,
+                                  int *n_shared);
+static int formula_runs_init(formula_runs *runs, libo_xl_sheet *sheet);
+static void formula_runs_add(formula_runs *runs,
+                             libo_xl_sheet *sheet,
+                             libo_xl_cell *cell,
+                             int row,
+                             int col,
+                             char **buf);
+static void formula_runs_clear(formula_runs *runs);
+static int calc_sheet_find(libo_xl_calc *calc, const char *name, size_t n);
+static int calc_parse_reference(calc_compiler *cc, int sheet);
+static int calc_parse_call(calc_compiler *cc, const char *name, size_t n);
+static int calc_parse_primary(calc_compiler *cc);
+static int calc_parse_unary(calc_compiler *cc);
+static int calc_parse_binary(calc_compiler *cc, int level);
+static int calc_parse_expression(calc_compiler *cc);
+static int calc_compile(libo_xl_calc *calc, int n, const char *formula);
+static int calc_compile_cell(libo_xl_calc *calc,
+                             int n,
+                             libo_xl_sheet *sheet,
+                             libo_xl_cell *cell,
+                             int row,
+                             int col);
+static char *calc_alloc(libo_xl_calc *calc, size_t n);
+static void calc_arena_reset(libo_xl_calc *calc);
+static void calc_set_number(calc_value *v, double number);
+static void calc_set_bool(calc_value *v, int b);
+static void calc_set_error(calc_value *v, calc_error_code error);
+static void calc_set_text(calc_value *v, const char *text, size_t len);
+static void calc_parse_value(libo_xl_calc *calc, const char *s, calc_value *out);
+static void calc_cell_value(libo_xl_calc *calc, int sheet, int row, int col, calc_value *out);
+static void calc_scalar(libo_xl_calc *calc, calc_value *v);
+static calc_error_code calc_to_number(calc_value *v, double *number);
+static calc_error_code calc_to_text(libo_xl_calc *calc, calc_value *v, const char **text, size_t *len);
+static calc_error_code calc_to_bool(calc_value *v, int *b);
+static int calc_text_compare(const char *a, size_t na, const char *b, size_t nb);
+static int calc_compare(calc_value *a, calc_value *b);
+static int calc_wildcard(const char *p, size_t np, const char *t, size_t nt);
+static void calc_arith(libo_xl_calc *calc, calc_op op, calc_value *a, calc_value *b);
+static void calc_concat(libo_xl_calc *calc, calc_value *a, calc_value *b);
+static void calc_relate(libo_xl_calc *calc, calc_op op, calc_value *a, calc_value *b);
+static void calc_eval(libo_xl_calc *calc, int n);
+static void calc_result_set(calc_node *node, calc_value *value);
+static const char *calc_format(calc_value *v, char *buffer, size_t size);
+static void calc_store(libo_xl_calc *calc, int n);
+static calc_error_code calc_arg_number(libo_xl_calc *calc, calc_value *arg, double *number);
+static void calc_aggregate_number(calc_aggregate *agg, double number);
+static void calc_aggregate_value(calc_aggregate *agg, calc_value *v, int direct);
+static int calc_area_rows(libo_xl_calc *calc, calc_area *area);
+static void calc_aggregate_range(libo_xl_calc *calc, calc_area *area, calc_aggregate *agg);
+static void calc_aggregate_args(libo_xl_calc *calc, calc_value *arg, int n, int full, calc_aggregate *agg);
+static void calc_fn_sum(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_average(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_min(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_max(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_product(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_count(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_counta(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static libo_xl_sorted_index *calc_sorted(libo_xl_calc *calc, int sheet, int col);
+static int calc_sorted_key(libo_xl_calc *calc, libo_xl_sorted_index *idx, calc_value *v, sorted_entry *key);
+static int calc_match(libo_xl_calc *calc, calc_value *v, calc_area *area, int type);
+static void calc_fn_match(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_lookup(libo_xl_calc *calc, calc_value *arg, int n, int vertical, calc_value *out);
+static void calc_fn_vlookup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_hlookup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_index(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_criteria_parse(calc_value *v, calc_criteria *cr);
+static int calc_criteria_match(calc_criteria *cr, calc_value *v);
+static void calc_conditional(libo_xl_calc *calc, calc_value *arg, int n, int sum, calc_value *out);
+static void calc_fn_countif(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_sumif(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_math(libo_xl_calc *calc, calc_value *arg, double (*f)(double), calc_value *out);
+static double calc_sign(double x);
+static void calc_fn_abs(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_int(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_sqrt(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_exp(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_ln(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_log10(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_sign(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_pi(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_power(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_mod(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_round(libo_xl_calc *calc, calc_value *arg, int mode, calc_value *out);
+static void calc_fn_round(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_roundup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_rounddown(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_if(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_logical(libo_xl_calc *calc, calc_value *arg, int n, int any, calc_value *out);
+static void calc_fn_and(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_or(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_not(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_iferror(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_iserror(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_isna(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_isblank(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_isnumber(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_istext(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_len(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_concatenate(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_side(libo_xl_calc *calc, calc_value *arg, int n, int right, calc_value *out);
+static void calc_fn_left(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_right(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_mid(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_case(libo_xl_calc *calc, calc_value *arg, int upper, calc_value *out);
+static void calc_fn_upper(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static void calc_fn_lower(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out);
+static int calc_sheet_index(libo_xl_calc *calc, libo_xl_sheet *sheet);
+static int calc_sheet_has_formulas(libo_xl_sheet *sheet);
+static int calc_cell_is_value(libo_xl_cell *cell);
+static void predicate_clear(libo_xl_predicate *pred);
+static int projection_add(libo_options *options, libo_xl_projection *pick);
+static void libo_options_resolve_texts(libo_options *options, strings *strings);
 
-  return xls->row[n];
+static int _strings_count = 0;     /**<  used when counting XL strings  */
+static char *_strings_buf = NULL;  /**<  used when accumulating strings
+                                         into XML buffer  */
 
-  return NULL;
-}
+static pthread_once_t _store_cache_once = PTHREAD_ONCE_INIT;  /**<  guards creation of cache key  */
+static pthread_key_t _store_cache_key;                        /**<  per thread block caches      */
+static int _store_cache_ready = 0;                            /**<  1 once cache key exists      */
+static pthread_mutex_t _store_serial_lock = PTHREAD_MUTEX_INITIALIZER;  /**<  guards serials  */
+static unsigned long _store_serial = 0;                       /**<  last store serial issued     */
 
-  /**
-   *  @fn int libo_xl_row_get_cell_count(libo_xl_row *xlr)
-   *
-   *  @brief returns number of cells in @p xlr
-   *
-   *  @param xlr - pointer to existing @a libo_xl_row struct
-   *
-   *  @return number of cells in @p xlr
-   */
+static pthread_once_t _stats_once = PTHREAD_ONCE_INIT;           /**<  guards choice of kernels     */
+static stats_kernel _stats_sum = stats_sum_scalar;              /**<  fastest sum kernel           */
+static deviation_kernel _stats_deviation = stats_deviation_scalar;  /**<  fastest deviation kernel  */
+static range_kernel _filter_range = filter_range_scalar;        /**<  fastest range filter kernel  */
+static member_kernel _filter_member = filter_member_scalar;     /**<  fastest set filter kernel    */
 
-int libo_xl_row_get_cell_count(libo_xl_row *xlr)
+static const char *_calc_errors[] =  /**<  names of errors, by calc_error_code  */
 {
-  if (!xlr) return 0;
+  "", "#NULL!", "#DIV/0!", "#VALUE!", "#REF!", "#NAME?", "#NUM!", "#N/A"
+};
 
-  return xlr->n_cells;
-}
+#define XL_BUILTIN_FORMATS 50   /**<  ids below which number formats may be built in  */
+#define XL_CUSTOM_FORMATS 164   /**<  first id of custom number formats               */
 
-  /**
-   *  @fn libo_xl_cell *libo_xl_row_get_cell(libo_xl_row *xlr, int n)
-   *
-   *  @brief returns cell at index @p n from @p xlr
-   *
-   *  @param xlr - pointer to existing @a libo_xl_row struct
-   *  @param n - index of cell to retrieve
-   *
-   *  @return pointer to @a libo_xl_cell
-   */
+#define XL_DAY_MS 86400000LL    /**<  milliseconds in a day                           */
+#define XL_EPOCH_1900 25569LL   /**<  serial of 1970-01-01, 1900 date system          */
+#define XL_EPOCH_1904 24107LL   /**<  serial of 1970-01-01, 1904 date system          */
+#define XL_LEAP_1900 61LL       /**<  first serial after 29 February 1900             */
+#define XL_SERIAL_MAX 2958466LL /**<  first serial after 31 December 9999, 1900 system */
+#define XL_EXACT_MAX 9007199254740992LL  /**<  2^53, past which doubles skip integers  */
 
-libo_xl_cell *libo_xl_row_get_cell(libo_xl_row *xlr, int n)
+static const char *_xl_number_formats[XL_BUILTIN_FORMATS] =  /**<  built in number formats, by id  */
 {
-  if (!xlr) return NULL;
+  "General", "0", "0.00", "#,##0", "#,##0.00", NULL, NULL, NULL, NULL, "0%",
+  "0.00%", "0.00E+00", "# ?/?", "# ?\?/?\?", "mm-dd-yy", "d-mmm-yy", "d-mmm", "mmm-yy",
+  "h:mm AM/PM", "h:mm:ss AM/PM", "h:mm", "h:mm:ss", "m/d/yy h:mm", NULL, NULL, NULL,
+  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+  "#,##0 ;(#,##0)", "#,##0 ;[Red](#,##0)", "#,##0.00;(#,##0.00)",
+  "#,##0.00;[Red](#,##0.00)", NULL, NULL, NULL, NULL, "mm:ss", "[h]:mm:ss", "mmss.0",
+  "##0.0E+0", "@"
+};
+
+static const char *_xl_style_flags[] =  /**<  attributes of cell formats, by LIBO_XL_STYLE_* bit  */
+{
+  "applyNumberFormat", "applyFont", "applyFill", "applyBorder",
+  "applyAlignment", "applyProtection", "quotePrefix", "pivotButton"
+};
 
-  if (n < 0) return NULL;
-  if (n >= xlr->n_cells) return NULL;
+static const calc_builtin _calc_builtins[] =  /**<  functions known to formulas, by id  */
+{
+  { "SUM",         1, 255, calc_fn_sum },
+  { "AVERAGE",     1, 255, calc_fn_average },
+  { "MIN",         1, 255, calc_fn_min },
+  { "MAX",         1, 255, calc_fn_max },
+  { "PRODUCT",     1, 255, calc_fn_product },
+  { "COUNT",       1, 255, calc_fn_count },
+  { "COUNTA",      1, 255, calc_fn_counta },
+  { "COUNTIF",     2, 2,   calc_fn_countif },
+  { "SUMIF",       2, 3,   calc_fn_sumif },
+  { "MATCH",       2, 3,   calc_fn_match },
+  { "INDEX",       2, 3,   calc_fn_index },
+  { "VLOOKUP",     3, 4,   calc_fn_vlookup },
+  { "HLOOKUP",     3, 4,   calc_fn_hlookup },
+  { "ABS",         1, 1,   calc_fn_abs },
+  { "INT",         1, 1,   calc_fn_int },
+  { "ROUND",       2, 2,   calc_fn_round },
+  { "ROUNDUP",     2, 2,   calc_fn_roundup },
+  { "ROUNDDOWN",   2, 2,   calc_fn_rounddown },
+  { "MOD",         2, 2,   calc_fn_mod },
+  { "SQRT",        1, 1,   calc_fn_sqrt },
+  { "POWER",       2, 2,   calc_fn_power },
+  { "EXP",         1, 1,   calc_fn_exp },
+  { "LN",          1, 1,   calc_fn_ln },
+  { "LOG10",       1, 1,   calc_fn_log10 },
+  { "PI",          0, 0,   calc_fn_pi },
+  { "SIGN",        1, 1,   calc_fn_sign },
+  { "IF",          1, 3,   calc_fn_if },
+  { "AND",         1, 255, calc_fn_and },
+  { "OR",          1, 255, calc_fn_or },
+  { "NOT",         1, 1,   calc_fn_not },
+  { "IFERROR",     2, 2,   calc_fn_iferror },
+  { "ISERROR",     1, 1,   calc_fn_iserror },
+  { "ISNA",        1, 1,   calc_fn_isna },
+  { "ISBLANK",     1, 1,   calc_fn_isblank },
+  { "ISNUMBER",    1, 1,   calc_fn_isnumber },
+  { "ISTEXT",      1, 1,   calc_fn_istext },
+  { "LEN",         1, 1,   calc_fn_len },
+  { "CONCATENATE", 1, 255, calc_fn_concatenate },
+  { "LEFT",        1, 2,   calc_fn_left },
+  { "RIGHT",       1, 2,   calc_fn_right },
+  { "MID",         3, 3,   calc_fn_mid },
+  { "UPPER",       1, 1,   calc_fn_upper },
+  { "LOWER",       1, 1,   calc_fn_lower },
+  { NULL,          0, 0,   NULL }
+};
 
-  return xlr->cell[n];
-}
 
   /**
-   *  @fn libo_xl_cell_type libo_xl_cell_get_type(libo_xl_cell *xlc)
+   *  @fn void libo_init(void)
    *
-   *  @brief returns cell type of @p xlc
+   *  @brief initialize libo library for later use
    *
-   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @par Parameters
+   *  None.
    *
-   *  @return @a libo_xl_cell_type
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_xl_cell_type libo_xl_cell_get_type(libo_xl_cell *xlc)
+void libo_init(void)
 {
-  if (!xlc) return libo_xl_cell_type_none;
+  xmlInitParser();
+  LIBXML_TEST_VERSION
 
-  return xlc->type;
+  return;
 }
 
   /**
-   *  @fn void libo_xl_cell_set_type(libo_xl_cell *xlc, libo_xl_cell_type type)
+   *  @fn void libo_cleanup(void)
    *
-   *  @brief sets cell type of @p xlc to @p type
+   *  @brief called after all use of libo is complete
    *
-   *  @param xlc - pointer to existing @a libo_xl_cell
-   *  @param type - @a libo_xl_cell_type
+   *  @par Parameters
+   *  None.
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_cell_set_type(libo_xl_cell *xlc, libo_xl_cell_type type)
+void libo_cleanup(void)
 {
-  if (!xlc) return;
-
-  if (xlc->type == libo_xl_cell_type_expression)
+  if (_store_cache_ready)
   {
-    if (xlc->expression.formula) free(xlc->expression.formula);
-    if (xlc->expression.value) free(xlc->expression.value);
+    store_cache_free(pthread_getspecific(_store_cache_key));
+    pthread_setspecific(_store_cache_key, NULL);
   }
 
-  memset(&xlc->expression, 0, sizeof(libo_xl_cell_expression));
+  xmlCleanupParser();
 
-  xlc->type = type;
+  return;
 }
 
   /**
-   *  @fn char *libo_xl_cell_get_string_value(libo_xl *xl, libo_xl_cell *xlc)
+   *  @fn libo *libo_new(void)
    *
-   *  @brief returns string value of @p xlc
+   *  @brief creates a new @a libo struct
    *
-   *  NOTE:  @p xl is required, as we need to lookup values in the string dictionary
+   *  @par Parameters
+   *  None.
    *
-   *  @param xl - pointer to existing @a libo_xl
-   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @return pointer to new @a libo struct
+   */
+
+libo *libo_new(void)
+{
+  libo *l;
+
+  l = (libo *)malloc(sizeof(libo));
+  if (!l) return NULL;
+
+  memset(l, 0, sizeof(libo));
+
+  return l;
+}
+
+  /**
+   *  @fn libo *libo_dup(libo *l)
    *
-   *  @return string containing cell's value, NULL if cell type is unknown
+   *  @brief creates a deep copy of @p l
+   *
+   *  @param l - pointer to existing libo struct
+   *
+   *  @return pointer to new @a libo struct
    */
 
-char *libo_xl_cell_get_string_value(libo_xl *xl, libo_xl_cell *xlc)
+libo *libo_dup(libo *l)
 {
-  libo_xl_cell_type type;
-  libo_xl_cell_expression *expr;
-  char *value = NULL;
+  libo *nl = NULL;
 
-  if (!xlc) return NULL;
+  if (!l) goto exit;
+
+  nl = libo_new();
+  if (!nl) goto exit;
 
-  type = libo_xl_cell_get_type(xlc);
+  if (l->path) nl->path = strdup(l->path);
+  if (l->options) nl->options = libo_options_dup(l->options);
+  nl->type = l->type;
+  nl->z = NULL;
 
-  switch (type)
+  switch (l->type)
   {
-    case libo_xl_cell_type_none: break;
+    case libo_type_doc:
+      nl->doc = libo_doc_dup(l->doc);
+      break;
 
-    case libo_xl_cell_type_reference:
-      if (!xl) return NULL;
-      value = libo_xl_cell_get_text(xl, xlc);
-      if (value) value = strdup(value);
+    case libo_type_pp:
+      nl->pp = libo_pp_dup(l->pp);
       break;
 
-    case libo_xl_cell_type_expression:
-      expr = libo_xl_cell_get_expression(xlc);
-      value = strdup(libo_xl_cell_expression_get_formula(expr));
-      if (!value)
-        value = strdup(libo_xl_cell_expression_get_value(expr));
-      if (!value)
-        value = strdup("");
+    case libo_type_xl:
+      nl->xl = libo_xl_dup(l->xl);
       break;
 
-    case libo_xl_cell_type_number:
-      value = (char *)malloc(50);
-      memset(value, 0, 50);
-      sprintf(value, "%g", libo_xl_cell_get_number(xlc));
+    case libo_type_none:
+    default:
       break;
   }
 
-  return value;
+exit:
+  return nl;
 }
 
   /**
-   *  @fn int libo_xl_cell_get_reference(libo_xl_cell *xlc)
+   *  @fn void libo_free(libo *l)
    *
-   *  @brief returns reference id in @p xlc
+   *  @brief frees all memory allocated to @p l
    *
-   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param l - pointer to existing @a libo struct
    *
-   *  @return reference id of @p xld, 0 if cell type is not a reference
+   *  @par Returns
+   *  Nothing.
    */
 
-int libo_xl_cell_get_reference(libo_xl_cell *xlc)
+void libo_free(libo *l)
 {
-  if (!xlc) return 0;
-  if (xlc->type != libo_xl_cell_type_reference) return 0;
+  if (!l) return;
 
-  return xlc->reference;
+  if (l->path) free(l->path);
+  switch (l->type)
+  {
+    case libo_type_none: break;
+    case libo_type_xl: libo_xl_free(l->xl); break;
+    case libo_type_doc: libo_doc_free(l->doc); break;
+    case libo_type_pp: libo_pp_free(l->pp); break;
+  }
+
+  libo_close(l);
+
+  if (l->options) libo_options_free(l->options);
+
+  free(l);
+
+  return;
 }
 
   /**
-   *  @fn void libo_xl_cell_set_reference(libo_xl_cell *xlc, int reference)
+   *  @fn libo *libo_open(char *path)
    *
-   *  @brief sets reference value in @p xlc to @p reference
+   *  @brief creates a new @a libo struct from a file
    *
-   *  @param xlc - pointer to existing @a libo_xl_cell
-   *  @param reference - new reference value
+   *  @param path - name of file to open
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return pointer to new @a libo struct, NULL on error
    */
 
-void libo_xl_cell_set_reference(libo_xl_cell *xlc, int reference)
+libo *libo_open(char *path)
 {
-  if (!xlc) return;
-  if (xlc->type != libo_xl_cell_type_reference) return;
-
-  xlc->reference = reference;
+  return libo_open_with_options(path, NULL);
 }
 
   /**
-   *  @fn char *libo_xl_cell_get_text(libo_xl *xl, libo_xl_cell *xlc)
-   *
-   *  @brief returns string value of @p xlc
+   *  @fn libo *libo_open_with_options(char *path, libo_options *options)
    *
-   *  NOTE:  @p xl is required, as we need to lookup values in the string dictionary
+   *  @brief creates a new @a libo struct from a file, using @p options
    *
-   *  @param xl - pointer to existing @a libo_xl
-   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param path - name of file to open
+   *  @param options - pointer to @a libo_options struct, or NULL for defaults
    *
-   *  @return string value of @p xlc
+   *  @return pointer to new @a libo struct, NULL on error
    */
 
-char *libo_xl_cell_get_text(libo_xl *xl, libo_xl_cell *xlc)
+libo *libo_open_with_options(char *path, libo_options *options)
 {
-  string *str;
-  char *value = NULL;
+  libo *l = NULL;
+  int err = 0;
 
-  if (!xl) goto exit;
-  if (!xlc) goto exit;
-  if (xlc->type != libo_xl_cell_type_reference) goto exit;
+  if (!XPATH_ENABLED)
+  {
+    fprintf(stderr, "XPATH is not enabled in LIBXML2\n");
+    return NULL;
+  }
 
-  str = strings_find_by_id(xl->strings, xlc->reference);
-  if (str) value = str->text;
+  if (!path) return NULL;
 
-exit:
-  return value;
+  l = libo_new();
+  if (!l) return NULL;
+
+  l->path = strdup(path);
+  if (options) l->options = libo_options_dup(options);
+
+  l->z = zip_open(path, ZIP_RDONLY, &err);
+  if (!l->z)
+  {
+    fprintf(stderr, "Can not open '%s', error code is %d\n", path, err);
+    return NULL;
+  }
+
+  if (!is_office(l))
+  {
+    libo_free(l);
+    fprintf(stderr, "'%s' is does not appear to be an Office document\n", path);
+    return NULL;
+  }
+
+  l->type = get_type(l);
+
+  if (!is_supported(l))
+  {
+    libo_free(l);
+    fprintf(stderr, "'%s' is not a supported Office document\n", path);
+    return NULL;
+  }
+
+  switch (l->type)
+  {
+    case libo_type_none: break;
+    case libo_type_xl:
+      l->xl = libo_xl_read(l);
+      if (!l->xl)
+      {
+        libo_free(l);
+        fprintf(stderr, "Can not establish XL document\n");
+        return NULL;
+      }
+      break;
+    case libo_type_doc:
+      l->doc = libo_doc_new();
+      if (!l->doc)
+      {
+        libo_free(l);
+        fprintf(stderr, "Can not establish DOC document\n");
+        return NULL;
+      }
+      break;
+    case libo_type_pp:
+      l->pp = libo_pp_new();
+      if (!l->pp)
+      {
+        libo_free(l);
+        fprintf(stderr, "Can not establish PP document\n");
+        return NULL;
+      }
+      break;
+  }
+
+
+  return l;
 }
 
   /**
-   *  @fn void libo_xl_cell_set_text(libo_xl *xl, libo_xl_cell *xlc, char *text)
+   *  @fn int libo_write(libo *l, char *path)
    *
-   *  @brief sets text value in @p xlc to @p text
+   *  @brief write libo document to a file
    *
-   *  @param xl - pointer to existing @a libo_xl
-   *  @param xlc - pointer to existing @a libo_xl_cell
-   *  @param text - new string value for text
+   *  @param l - pointer to existing @a libo struct
+   *  @param path - string containing path to file
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return 0 on success, STDIO error on failure
    */
 
-void libo_xl_cell_set_text(libo_xl *xl, libo_xl_cell *xlc, char *text)
+int libo_write(libo *l, char *path)
 {
-  string *str;
+  char *fname = NULL;
+  int err = 0;
+  int r = 0;
 
-  if (!xl) return;
-  if (!xlc) return;
+  if (!l) return -1;
 
-  libo_xl_cell_clear(xlc);
+  if (path) fname = path;
+  else fname = l->path;
 
-  libo_xl_cell_set_type(xlc, libo_xl_cell_type_reference);
+  if (!fname) return -1;
 
-  str = strings_find_by_text(xl->strings, text);
-  if (!str)
+  l->z = zip_open(fname, ZIP_CREATE, &err);
+  if (!l->z)
   {
-    str = string_new_with_values(text, 0);
-    if (str) strings_add(xl->strings, str);
-    str = strings_find_by_text(xl->strings, text);
+    fprintf(stderr, "Can not open '%s', error code is %d\n", path, err);
+    return -1;
   }
 
-  if (str) libo_xl_cell_set_reference(xlc, str->id);
+  switch (l->type)
+  {
+    case libo_type_xl:
+      r = libo_xl_write(l);
+      break;
+    case libo_type_doc:
+      break;
+    case libo_type_pp:
+      break;
+    default: break;
+  }
+
+  libo_close(l);
+
+  return r;
 }
 
   /**
-   *  @fn libo_xl_cell_expression *libo_xl_cell_get_expression(libo_xl_cell *xlc)
+   *  @fn void libo_close(libo *l)
    *
-   *  @brief returns cell expression from @p xlc
+   *  @brief closes the open ZIP file associated with @p l
    *
-   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param l - pointer to existing @a libo struct
    *
-   *  @return pointer to @a libo_xl_cell_expression, NULL if cell type is not an expression
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_xl_cell_expression *libo_xl_cell_get_expression(libo_xl_cell *xlc)
+void libo_close(libo *l)
 {
-  if (!xlc) return NULL;
-  if (xlc->type != libo_xl_cell_type_expression) return NULL;
+  if (!l) return;
 
-  return &xlc->expression;
+  if (l->z)
+  {
+    zip_close(l->z);
+    l->z = NULL;
+  }
+
+  return;
 }
 
   /**
-   *  @fn void libo_xl_cell_set_expression(libo_xl_cell *xlc, libo_xl_cell_expression *xlce)
+   *  @fn libo_options *libo_options_new(void)
    *
-   *  @brief sets @p xlc expression values to those in @p xlce
+   *  @brief creates a new @a libo_options struct, filled with defaults
    *
-   *  @param xlc - pointer to existing @a libo_xl_cell
-   *  @param xlce - pointer to existing @a libo_xl_cell_expression
+   *  @par Parameters
+   *  None.
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return pointer to new @a libo_options struct
    */
 
-void libo_xl_cell_set_expression(libo_xl_cell *xlc, libo_xl_cell_expression *xlce)
+libo_options *libo_options_new(void)
 {
-  if (!xlc || !xlce) return;
+  libo_options *options;
 
-  libo_xl_cell_clear(xlc);
+  options = (libo_options *)malloc(sizeof(libo_options));
+  if (!options) return NULL;
+  memset(options, 0, sizeof(libo_options));
 
-  libo_xl_cell_set_type(xlc, libo_xl_cell_type_expression);
+  options->last_row = -1;
 
-  if (xlce->formula) libo_xl_cell_expression_set_formula(&xlc->expression, xlce->formula);
-  if (xlce->value) libo_xl_cell_expression_set_value(&xlc->expression, xlce->value);
+  return options;
 }
 
   /**
-   *  @fn char *libo_xl_cell_expression_get_formula(libo_xl_cell_expression *xlce)
+   *  @fn libo_options *libo_options_dup(libo_options *options)
    *
-   *  @brief returns formula from @p xlce
+   *  @brief creates a deep copy of @p options
    *
-   *  @param xlce - pointer to existing @a libo_xl_cell_expression
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @return string containing cell's formula
+   *  @return pointer to new @a libo_options struct
    */
 
-char *libo_xl_cell_expression_get_formula(libo_xl_cell_expression *xlce)
+libo_options *libo_options_dup(libo_options *options)
 {
-  if (!xlce) return NULL;
+  libo_options *noptions = NULL;
+  int i;
 
-  return xlce->formula;
+  if (!options) goto exit;
+
+  noptions = libo_options_new();
+  if (!noptions) goto exit;
+
+  memcpy(noptions, options, sizeof(libo_options));
+  noptions->n_predicates = 0;
+  noptions->predicate = NULL;
+  noptions->n_columns = 0;
+  noptions->column = NULL;
+
+  for (i = 0; i < options->n_predicates; i++)
+  {
+    if (libo_options_add_predicate(noptions, &options->predicate[i]))
+    {
+      libo_options_free(noptions);
+      noptions = NULL;
+      goto exit;
+    }
+  }
+
+  for (i = 0; i < options->n_columns; i++)
+  {
+    if (projection_add(noptions, &options->column[i]))
+    {
+      libo_options_free(noptions);
+      noptions = NULL;
+      goto exit;
+    }
+  }
+
+exit:
+  return noptions;
 }
 
   /**
-   *  @fn void libo_xl_cell_expression_set_formula(libo_xl_cell_expression *xlce, char *formula)
+   *  @fn void libo_options_free(libo_options *options)
    *
-   *  @brief sets formula in @p xlce to @p formula
+   *  @brief frees all memory allocated to @p options
    *
-   *  @param xlce - pointer to existing @a libo_xl_cell_expression
-   *  @param formula - string containing new formula
+   *  @param options - pointer to existing @a libo_options struct
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_cell_expression_set_formula(libo_xl_cell_expression *xlce,
-                                         char *formula)
+void libo_options_free(libo_options *options)
 {
-  char *old_formula = NULL;
-
-  if (!xlce || !formula) return;
-
-  if (xlce->formula) old_formula = xlce->formula;
+  if (!options) return;
 
-  xlce->formula = NULL;
+  libo_options_clear_predicates(options);
+  libo_options_clear_columns(options);
 
-  xlce->formula = strdup(formula);
+  free(options);
 
-  if (old_formula) free(old_formula);
+  return;
 }
 
   /**
-   *  @fn char *libo_xl_cell_expression_get_value(libo_xl_cell_expression *xlce)
+   *  @fn size_t libo_options_get_memory_budget(libo_options *options)
    *
-   *  @brief returns value from @p xlce
+   *  @brief returns memory budget for work sheets in @p options
    *
-   *  @param xlce - pointer to existing @a libo_xl_cell_expression
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @return string containing cell's calculated value
+   *  @return maximum bytes of resident work sheets, 0 for no limit
    */
 
-char *libo_xl_cell_expression_get_value(libo_xl_cell_expression *xlce)
+size_t libo_options_get_memory_budget(libo_options *options)
 {
-  if (!xlce) return NULL;
+  if (!options) return 0;
 
-  return xlce->value;
+  return options->memory_budget;
 }
 
   /**
-   *  @fn void libo_xl_cell_expression_set_value(libo_xl_cell_expression *xlce,
-   *                                             char *value)
+   *  @fn void libo_options_set_memory_budget(libo_options *options,
+   *                                          size_t budget)
    *
-   *  @brief sets value in @p xlce to @p value
+   *  @brief sets memory budget for work sheets in @p options
    *
-   *  @param xlce - pointer to existing @a libo_xl_cell_expression
-   *  @param value - string containing new value
+   *  With a budget, work sheets are read one at a time, and the least
+   *  recently used sheets are evicted whenever the budget is exceeded.
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param budget - maximum bytes of resident work sheets, 0 for no limit
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_cell_expression_set_value(libo_xl_cell_expression *xlce,
-                                       char *value)
+void libo_options_set_memory_budget(libo_options *options, size_t budget)
 {
-  char *old_value = NULL;
-
-  if (!xlce || !value) return;
-
-  if (xlce->value) old_value = xlce->value;
-  xlce->value = NULL;
-
-  if (value) xlce->value = strdup(value);
+  if (!options) return;
 
-  if (old_value) free(old_value);
+  options->memory_budget = budget;
 }
 
   /**
-   *  @fn double libo_xl_cell_get_number(libo_xl_cell *xlc)
+   *  @fn libo_xl_storage libo_options_get_storage(libo_options *options)
    *
-   *  @brief returns direct value from @p xlc
+   *  @brief returns where rows of work sheets are kept for @p options
    *
-   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @return direct numeric value of @p xlc
+   *  @return @a libo_xl_storage
    */
 
-double libo_xl_cell_get_number(libo_xl_cell *xlc)
+libo_xl_storage libo_options_get_storage(libo_options *options)
 {
-  if (!xlc) return 0;
-  if (xlc->type != libo_xl_cell_type_number) return 0;
+  if (!options) return libo_xl_storage_memory;
 
-  return xlc->number;
+  return options->storage;
 }
 
   /**
-   *  @fn void libo_xl_cell_set_number(libo_xl_cell *xlc, double number)
+   *  @fn void libo_options_set_storage(libo_options *options,
+   *                                    libo_xl_storage storage)
    *
-   *  @brief sets number value in @p xlc to @p number
+   *  @brief sets where rows of work sheets are kept for @p options
    *
-   *  @param xlc - pointer to existing @a libo_xl_cell
-   *  @param number - new number value
+   *  With @a libo_xl_storage_disk, work sheets are streamed from the file
+   *  straight into temporary files, so sheets larger than memory can be
+   *  read.  With @a libo_xl_storage_compressed, they are streamed into
+   *  compressed blocks kept in memory, which suits many large, mostly read
+   *  workbooks held open at once.  With @a libo_xl_storage_columnar, they
+   *  are split into columns, whose dominant types are inferred as they
+   *  load, and kept as typed arrays encoded to suit their values, which
+   *  can be counted and summed without decoding them.
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param storage - @a libo_xl_storage
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_cell_set_number(libo_xl_cell *xlc, double number)
+void libo_options_set_storage(libo_options *options, libo_xl_storage storage)
 {
-  if (!xlc) return;
-
-  libo_xl_cell_clear(xlc);
-
-  libo_xl_cell_set_type(xlc, libo_xl_cell_type_number);
+  if (!options) return;
 
-  xlc->number = number;
+  options->storage = storage;
 }
 
   /**
-   *  @fn libo_doc *libo_get_doc(libo *l)
+   *  @fn int libo_options_get_profile(libo_options *options)
    *
-   *  @brief returns Word document from @p l
+   *  @brief returns whether columns of work sheets are profiled as they are
+   *         read for @p options
    *
-   *  @param l - pointer to existing @a libo
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @return pointer to @a libo_doc, NULL if document type is not a Word document
+   *  @return 1 if columns are profiled, 0 otherwise
    */
 
-libo_doc *libo_get_doc(libo *l)
+int libo_options_get_profile(libo_options *options)
 {
-  if (!l) return NULL;
-
-  if (l->type == libo_type_doc) return l->doc;
+  if (!options) return 0;
 
-  return NULL;
+  return options->profile;
 }
 
   /**
-   *  @fn libo_pp *libo_get_pp(libo *l)
+   *  @fn void libo_options_set_profile(libo_options *options, int profile)
    *
-   *  @brief returns PowerPoint document from @p l
+   *  @brief sets whether columns of work sheets are profiled as they are
+   *         read for @p options
    *
-   *  @param l - pointer to existing @a libo
+   *  Profiles count the cells of each type and the empty cells of each
+   *  column, track the smallest and largest number, and estimate the number
+   *  of distinct values, all while the rows are parsed.
    *
-   *  @return pointer to @a libo_pp, NULL if document type is not a PowerPoint document
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param profile - 1 to profile columns, 0 not to
+   *
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_pp *libo_get_pp(libo *l)
+void libo_options_set_profile(libo_options *options, int profile)
 {
-  if (!l) return NULL;
-
-  if (l->type == libo_type_pp) return l->pp;
+  if (!options) return;
 
-  return NULL;
+  options->profile = profile ? 1 : 0;
 }
 
   /**
-   *  @fn libo_xl *libo_xl_new(void)
+   *  @fn int libo_options_add_predicate(libo_options *options,
+   *                                     libo_xl_predicate *pred)
    *
-   *  @brief creates a new @a libo_xl struct
+   *  @brief adds a copy of @p pred to the predicates rows of work sheets
+   *         must meet to be read for @p options
    *
-   *  @par Parameters
-   *  None.
+   *  Predicates are tested on the raw values of cells as each row is
+   *  parsed, before any cell is built, and rows failing any of them are
+   *  skipped.  Texts of @p pred are looked up in the shared strings, which
+   *  are read before the work sheets, and join its set of ids, so
+   *  @a libo_xl_predicate_op_in can match texts without knowing their ids.
+   *  Rows are renumbered as they are read, so skipped rows leave no gaps.
    *
-   *  @return pointer to @a libo_xl
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param pred - pointer to existing @a libo_xl_predicate struct
+   *
+   *  @return 0 on success, -1 on failure
    */
 
-libo_xl *libo_xl_new(void)
+int libo_options_add_predicate(libo_options *options, libo_xl_predicate *pred)
 {
-  libo_xl *xl;
+  libo_xl_predicate *tmp;
 
-  xl = (libo_xl *)malloc(sizeof(libo_xl));
-  if (!xl) return NULL;
-  memset(xl, 0, sizeof(libo_xl));
+  if (!options || !pred) return -1;
+  if (pred->col < 0) return -1;
+  if ((pred->n_ids < 0) || (pred->n_ids && !pred->ids)) return -1;
+  if ((pred->n_texts < 0) || (pred->n_texts && !pred->texts)) return -1;
 
-  xl->book = libo_xl_book_new();
-  xl->strings = strings_new();
+  tmp = (libo_xl_predicate *)realloc(options->predicate,
+                                     sizeof(libo_xl_predicate) * (options->n_predicates + 1));
+  if (!tmp) return -1;
+  options->predicate = tmp;
 
-  return xl;
+  if (predicate_copy(&options->predicate[options->n_predicates], pred)) return -1;
+
+  ++options->n_predicates;
+
+  return 0;
 }
 
   /**
-   *  @fn libo_xl *libo_xl_dup(libo_xl *xl)
+   *  @fn int libo_options_get_predicate_count(libo_options *options)
    *
-   *  @brief creates a deep copy of @p xl
+   *  @brief returns number of predicates rows of work sheets must meet to
+   *         be read for @p options
    *
-   *  @param xl - pointer to existing @a libo_xlstruct
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @return pointer to new @a libo_xl struct
+   *  @return number of predicates
    */
 
-libo_xl *libo_xl_dup(libo_xl *xl)
+int libo_options_get_predicate_count(libo_options *options)
 {
-  libo_xl *nxl = NULL;
-
-  if (!xl) goto exit;
-
-  nxl = libo_xl_new();
-  if (!nxl) goto exit;
-
-  if (xl->book) nxl->book = libo_xl_book_dup(xl->book);
-  if (xl->strings) nxl->strings = strings_dup(xl->strings);
+  if (!options) return 0;
 
-exit:
-  return nxl;
+  return options->n_predicates;
 }
 
   /**
-   *  @fn void libo_xl_free(libo_xl *xl)
+   *  @fn void libo_options_clear_predicates(libo_options *options)
    *
-   *  @brief frees all memory allocated to @p xl
+   *  @brief removes all predicates rows of work sheets must meet to be read
+   *         from @p options
    *
-   *  @param xl - pointer to existing @a libo_xl struct
+   *  @param options - pointer to existing @a libo_options struct
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_free(libo_xl *xl)
+void libo_options_clear_predicates(libo_options *options)
 {
-  if (!xl) return;
+  int i;
 
-  if (xl->book) libo_xl_book_free(xl->book);
-  if (xl->strings) strings_free(xl->strings);
+  if (!options) return;
 
-  free(xl);
+  for (i = 0; i < options->n_predicates; i++)
+    predicate_clear(&options->predicate[i]);
 
-  return;
+  free(options->predicate);
+  options->predicate = NULL;
+  options->n_predicates = 0;
 }
 
   /**
-   *  @fn void libo_xl_sheet_set_default_row_height(libo_xl_sheet *sheet,
-   *                                                double default_row_height)
+   *  @fn int libo_options_get_header_rows(libo_options *options)
    *
-   *  @brief sets default row height of @p sheet
+   *  @brief returns number of leading rows of work sheets read regardless
+   *         of predicates for @p options
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
-   *  @param default_row_height
+   *  @param options - pointer to existing @a libo_options struct
+   *
+   *  @return number of header rows
+   */
+
+int libo_options_get_header_rows(libo_options *options)
+{
+  if (!options) return 0;
+
+  return options->header_rows;
+}
+
+  /**
+   *  @fn void libo_options_set_header_rows(libo_options *options,
+   *                                        int header_rows)
+   *
+   *  @brief sets number of leading rows of work sheets read regardless of
+   *         predicates for @p options
+   *
+   *  Headings seldom meet the predicates put on the values below them, so
+   *  they are kept this way.
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param header_rows - number of header rows
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_sheet_set_default_row_height(libo_xl_sheet *sheet,
-                                          double default_row_height)
+void libo_options_set_header_rows(libo_options *options, int header_rows)
 {
-  if (!sheet) return;
+  if (!options) return;
 
-  sheet->default_row_height = default_row_height;
+  options->header_rows = (header_rows > 0) ? header_rows : 0;
 }
 
   /**
-   *  @fn libo_xl_freeze *libo_xl_sheet_get_freeze(libo_xl_sheet *sheet)
+   *  @fn int libo_options_add_column(libo_options *options, char *letters)
    *
-   *  @brief gets row/column freeze from @p sheet, if any
+   *  @brief adds column named by @p letters to the columns of work sheets
+   *         read for @p options
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  Once any column is added, only the columns added are read, in the
+   *  order they were added, and cells of all other columns are passed over
+   *  unread.  @a libo_xl_sheet_get_source_column maps the columns kept back
+   *  to those of the file.  Predicates still name columns of the file.
    *
-   *  @return pointer to @a libo_xl_freeze struct, or NULL if none.
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param letters - string containing letters of column, such as "C"
+   *
+   *  @return 0 on success, -1 on failure
    */
 
-libo_xl_freeze *libo_xl_sheet_get_freeze(libo_xl_sheet *sheet)
+int libo_options_add_column(libo_options *options, char *letters)
 {
-  if (!sheet) return NULL;
+  libo_xl_projection pick;
+  char ref[8];
+  int r, c;
+  int i;
 
-  return &(sheet->freeze);
+  if (!options || !letters) return -1;
+
+  for (i = 0; letters[i]; i++)
+  {
+    if ((i >= 3) || !isalpha((unsigned char)letters[i])) return -1;
+    ref[i] = toupper((unsigned char)letters[i]);
+  }
+  if (!i) return -1;
+  ref[i] = '\0';
+
+  cell_ref_to_row_col(ref, &r, &c);
+
+  pick.col = c;
+  pick.name = NULL;
+  pick.id = -1;
+
+  return projection_add(options, &pick);
 }
 
   /**
-   *  @fn void libo_xl_sheet_set_freeze(libo_xl_sheet *sheet,
-   *                                    libo_xl_freeze_type type,
-   *                                    int n)
+   *  @fn int libo_options_add_column_name(libo_options *options, char *name)
    *
-   *  @brief sets row/column freeze for @p sheet
+   *  @brief adds column headed by @p name to the columns of work sheets
+   *         read for @p options
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
-   *  @param type - @a libo_xl_freeze_type (top or left)
-   *  @param n - number of rows or columns to freeze
+   *  Headings are looked for in the first row of each work sheet, which is
+   *  read whole.  Columns whose heading is not found are kept empty.
    *
-   *  @par Returns
-   *  Nothing.
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param name - string containing text of heading
+   *
+   *  @return 0 on success, -1 on failure
    */
 
-void libo_xl_sheet_set_freeze(libo_xl_sheet *sheet,
-                              libo_xl_freeze_type type,
-                              int n)
+int libo_options_add_column_name(libo_options *options, char *name)
 {
-  if (!sheet) return;
+  libo_xl_projection pick;
 
-  sheet->freeze.type = type;
-  sheet->freeze.n = n;
+  if (!options || !name) return -1;
+
+  pick.col = -1;
+  pick.name = name;
+  pick.id = -1;
+
+  return projection_add(options, &pick);
 }
 
   /**
-   *  @fn void libo_xl_sheet_add_filter(libo_xl_sheet *sheet,
-   *                                    unsigned int first_column,
-   *                                    unsigned int last_column)
+   *  @fn int libo_options_get_column_count(libo_options *options)
    *
-   *  @brief adds columns filter to XL worksheet
+   *  @brief returns number of columns of work sheets read for @p options
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
-   *  @param first_column
-   *  @param last_column
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return number of columns, 0 if all are read
    */
 
-void libo_xl_sheet_add_filter(libo_xl_sheet *sheet,
-                              unsigned int first_column,
-                              unsigned int last_column)
+int libo_options_get_column_count(libo_options *options)
 {
-  if (!sheet) return;
+  if (!options) return 0;
 
-  if (sheet->filter) libo_xl_filter_free(sheet->filter);
-  sheet->filter = libo_xl_filter_new_with_values(first_column, last_column);
+  return options->n_columns;
 }
 
   /**
-   *  @fn void libo_xl_sheet_remove_filter(libo_xl_sheet *sheet)
+   *  @fn void libo_options_clear_columns(libo_options *options)
    *
-   *  @brief removes filter from XL worksheet
+   *  @brief removes all columns of work sheets read from @p options, so all
+   *         are read
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param options - pointer to existing @a libo_options struct
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_sheet_remove_filter(libo_xl_sheet *sheet)
+void libo_options_clear_columns(libo_options *options)
 {
-  if (!sheet) return;
+  int i;
 
-  libo_xl_filter_free(sheet->filter);
-  sheet->filter = NULL;
+  if (!options) return;
+
+  for (i = 0; i < options->n_columns; i++)
+    free(options->column[i].name);
+
+  free(options->column);
+  options->column = NULL;
+  options->n_columns = 0;
 }
 
   /**
-   *  @fn libo_doc *libo_doc_new(void)
+   *  @fn int libo_options_get_first_row(libo_options *options)
    *
-   *  @brief creates a new @a libo_doc struct
+   *  @brief returns first row of work sheets read for @p options
    *
-   *  @par Parameters
-   *  None.
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @return pointer to @a libo_doc
+   *  @return index of first row
    */
 
-libo_doc *libo_doc_new(void)
+int libo_options_get_first_row(libo_options *options)
 {
-  libo_doc *doc;
+  if (!options) return 0;
 
-  doc = (libo_doc *)malloc(sizeof(libo_doc));
-  if (!doc) return NULL;
-  memset(doc, 0, sizeof(libo_doc));
-
-  return doc;
+  return options->first_row;
 }
 
   /**
-   *  @fn libo_doc *libo_doc_dup(libo_doc *doc)
+   *  @fn int libo_options_get_last_row(libo_options *options)
    *
-   *  @brief creates a deep copy of @p doc
+   *  @brief returns row after last row of work sheets read for @p options
    *
-   *  @param doc - pointer to existing @a libo_doc struct
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @return pointer to @a libo_doc
+   *  @return index of row after last row, -1 if rows are read to the end
    */
 
-libo_doc *libo_doc_dup(libo_doc *doc)
+int libo_options_get_last_row(libo_options *options)
 {
-  libo_doc *ndoc = NULL;
-
-  if (!doc) goto exit;
-
-  ndoc = libo_doc_new();
-  if (!ndoc) goto exit;
+  if (!options) return -1;
 
-exit:
-  return ndoc;
+  return options->last_row;
 }
 
   /**
-   *  @fn void libo_doc_free(libo_doc *doc)
+   *  @fn void libo_options_set_row_range(libo_options *options,
+   *                                      int first,
+   *                                      int last)
    *
-   *  @brief frees all memory allocated to @p doc
+   *  @brief sets rows of work sheets read for @p options to rows @p first
+   *         up to, but not including, @p last
    *
-   *  @param doc - pointer to existing @a libo_doc struct
+   *  Rows before @p first are passed over without building their cells,
+   *  and reading stops at @p last, so the rest of the work sheet is never
+   *  decompressed.  Rows are counted after predicates are met.
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param first - index of first row
+   *  @param last - index of row after last row, -1 to read to the end
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_doc_free(libo_doc *doc)
+void libo_options_set_row_range(libo_options *options, int first, int last)
 {
-  if (!doc) return;
+  if (!options) return;
 
-  free(doc);
-
-  return;
+  options->first_row = (first > 0) ? first : 0;
+  options->last_row = (last >= 0) ? last : -1;
 }
 
   /**
-   *  @fn libo_pp *libo_pp_new(void)
+   *  @fn int libo_options_get_sample_rows(libo_options *options)
    *
-   *  @brief creates a new @a libo_pp struct
+   *  @brief returns number of rows of work sheets sampled at random for
+   *         @p options
    *
-   *  @par Parameters
-   *  None.
+   *  @param options - pointer to existing @a libo_options struct
    *
-   *  @return pointer to @a libo_pp
+   *  @return number of rows, 0 if all rows are read
    */
 
-libo_pp *libo_pp_new(void)
+int libo_options_get_sample_rows(libo_options *options)
 {
-  libo_pp *pp;
+  if (!options) return 0;
 
-  pp = (libo_pp *)malloc(sizeof(libo_pp));
-  if (!pp) return NULL;
-  memset(pp, 0, sizeof(libo_pp));
+  return options->sample_rows;
+}
 
-  return pp;
+  /**
+   *  @fn unsigned long libo_options_get_sample_seed(libo_options *options)
+   *
+   *  @brief returns seed of random choice of rows sampled for @p options
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *
+   *  @return seed
+   */
+
+unsigned long libo_options_get_sample_seed(libo_options *options)
+{
+  if (!options) return 0;
+
+  return options->seed;
 }
 
   /**
-   *  @fn libo_pp *libo_pp_dup(libo_pp *pp)
+   *  @fn void libo_options_set_sample(libo_options *options,
+   *                                   int k,
+   *                                   unsigned long seed)
    *
-   *  @brief creates a deep copy of @p pp
+   *  @brief sets number of rows of work sheets sampled at random for
+   *         @p options
    *
-   *  @param pp - pointer to existing @a libo_pp struct
+   *  See @a libo_xl_sheet_read_sample.  Sampling takes the place of any
+   *  range of rows.
    *
-   *  @return pointer to @a libo_pp
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param k - number of rows sampled, 0 to read all rows
+   *  @param seed - seed of random choice of rows, the same seed choosing
+   *                the same rows
+   *
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_pp *libo_pp_dup(libo_pp *pp)
+void libo_options_set_sample(libo_options *options, int k, unsigned long seed)
 {
-  libo_pp *npp = NULL;
+  if (!options) return;
 
-  if (!pp) goto exit;
+  options->sample_rows = (k > 0) ? k : 0;
+  options->seed = seed;
+}
 
-  npp = libo_pp_new();
-  if (!npp) goto exit;
+  /**
+   *  @fn size_t libo_options_get_seek_span(libo_options *options)
+   *
+   *  @brief returns bytes of XML between checkpoints into work sheets for
+   *         @p options
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *
+   *  @return number of bytes, 0 if no checkpoints are kept
+   */
 
-exit:
-  return npp;
+size_t libo_options_get_seek_span(libo_options *options)
+{
+  if (!options) return 0;
+
+  return options->seek_span;
 }
 
   /**
-   *  @fn void libo_pp_free(libo_pp *pp)
+   *  @fn void libo_options_set_seek_span(libo_options *options, size_t span)
    *
-   *  @brief frees all memory allocated to @p pp
+   *  @brief sets bytes of XML between checkpoints into work sheets for
+   *         @p options
    *
-   *  @param pp - pointer to existing @a libo_pp struct
+   *  The first time a work sheet is read from its start, the state of
+   *  decompression is saved about every @p span bytes of XML, along with
+   *  the last 32K of XML and the number of rows before it.  Reading a range
+   *  of rows later resumes from the last checkpoint before the range,
+   *  rather than decompressing the work sheet from its start.  Each
+   *  checkpoint takes a little over 32K of memory.
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param span - bytes of XML between checkpoints, 0 to keep none
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_pp_free(libo_pp *pp)
+void libo_options_set_seek_span(libo_options *options, size_t span)
 {
-  if (!pp) return;
-
-  free(pp);
+  if (!options) return;
 
-  return;
+  options->seek_span = span;
 }
 
   /**
-   *  @fn char *libo_type_to_string(libo_type lt)
+   *  @fn size_t libo_memory_size(libo *l)
    *
-   *  @brief returns string representation of @p lt
+   *  @brief returns number of bytes of memory used by @p l
    *
-   *  @param lt - @a libo_type
+   *  @param l - pointer to existing @a libo struct
    *
-   *  @return string representation of @p lt
+   *  @return approximate number of bytes allocated to @p l
    */
 
-char *libo_type_to_string(libo_type lt)
+size_t libo_memory_size(libo *l)
 {
-  switch (lt)
+  size_t bytes = 0;
+
+  if (!l) return 0;
+
+  bytes = sizeof(libo);
+  if (l->path) bytes += strlen(l->path) + 1;
+
+  switch (l->type)
   {
-    case libo_type_none: return "[UNKNOWN]";
-    case libo_type_xl: return "Microsoft Excel";
-    case libo_type_doc: return "Microsoft Word";
-    case libo_type_pp: return "Microsoft PowerPoint";
+    case libo_type_xl: bytes += libo_xl_memory_size(l->xl); break;
+    case libo_type_doc: bytes += sizeof(libo_doc); break;
+    case libo_type_pp: bytes += sizeof(libo_pp); break;
+    case libo_type_none:
+    default:
+      break;
   }
 
-  return libo_type_none;
+  return bytes;
 }
 
   /**
-   *  @fn libo_xl_strings *libo_xl_strings_read(libo *l)
+   *  @fn libo_cache *libo_cache_new(size_t budget)
    *
-   *  @brief creates new @a libo_xl_strings struct from file
+   *  @brief creates a new @a libo_cache struct
    *
-   *  @param l - pointer to existing @a libo struct
+   *  @param budget - maximum number of bytes of documents to keep cached
    *
-   *  @return pointer to new and filled @a libo_xl_strings struct
+   *  @return pointer to new @a libo_cache struct
    */
 
-strings *libo_xl_strings_read(libo *l)
+libo_cache *libo_cache_new(size_t budget)
 {
-  char *strings_file_name = "xl/sharedStrings.xml";
-  zip_stat_t stat;
-  zip_file_t *zf = NULL;
-  xmlDocPtr doc = NULL;
-  xmlNodePtr node = NULL;
-  char *buf = NULL;
-  int len;
-  strings *strings;
-  string *str;
+  libo_cache *cache;
 
-  if (!l) return NULL;
-  if (!l->z) return NULL;
+  cache = (libo_cache *)malloc(sizeof(libo_cache));
+  if (!cache) return NULL;
+  memset(cache, 0, sizeof(libo_cache));
 
-    // open xl/shareStrings.xml
+  cache->budget = budget;
+  cache->n_buckets = 64;
 
-  if (zip_stat(l->z, strings_file_name, 0, &stat)) return NULL;
-  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return NULL;
+  cache->bucket = (libo_cache_entry **)malloc(sizeof(libo_cache_entry *) * cache->n_buckets);
+  if (!cache->bucket)
+  {
+    free(cache);
+    return NULL;
+  }
+  memset(cache->bucket, 0, sizeof(libo_cache_entry *) * cache->n_buckets);
 
-  if (strcmp(strings_file_name, stat.name)) return NULL;
+  pthread_mutex_init(&cache->lock, NULL);
 
-  len = stat.size;
+  return cache;
+}
 
-  zf = zip_fopen(l->z, strings_file_name, 0);
-  if (!zf)
+  /**
+   *  @fn void libo_cache_free(libo_cache *cache)
+   *
+   *  @brief frees all memory allocated to @p cache, including cached documents
+   *
+   *  NOTE:  All documents obtained from @p cache become invalid
+   *
+   *  @param cache - pointer to existing @a libo_cache struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_cache_free(libo_cache *cache)
+{
+  libo_cache_entry *e;
+  libo_cache_entry *next;
+
+  if (!cache) return;
+
+  for (e = cache->head; e; e = next)
   {
-    fprintf(stderr, "Can not open '%s'\n", strings_file_name); fflush(stderr);
-    return NULL;
+    next = e->next;
+    libo_cache_entry_free(e);
   }
 
-  buf = (char *)malloc(len+1);
-  if (!buf)
+  for (e = cache->stale; e; e = next)
   {
-    zip_fclose(zf);
-    return NULL;
+    next = e->next;
+    libo_cache_entry_free(e);
   }
-  memset(buf, 0, len+1);
 
-  zip_fread(zf, buf, len);
+  pthread_mutex_destroy(&cache->lock);
 
-  zip_fclose(zf);
+  free(cache->bucket);
+  free(cache);
 
-  doc = xmlParseMemory(buf, len);
-  if (!doc)
+  return;
+}
+
+  /**
+   *  @fn libo *libo_cache_open(libo_cache *cache, char *path)
+   *
+   *  @brief returns shared document for @p path, reading file only when needed
+   *
+   *  A cached document is reused as long as the file's size and modification
+   *  time are unchanged.  If they have changed, the ZIP central directory is
+   *  checked, and the file is only read again if its contents differ.
+   *
+   *  NOTE:  The returned document is shared, and must not be modified or freed.
+   *         Call libo_cache_release() when it is no longer needed.
+   *
+   *  @param cache - pointer to existing @a libo_cache struct
+   *  @param path - name of file to open
+   *
+   *  @return pointer to shared @a libo struct, NULL on error
+   */
+
+libo *libo_cache_open(libo_cache *cache, char *path)
+{
+  libo_cache_entry *e;
+  libo_cache_entry *found;
+  struct stat st;
+  unsigned long crc = 0;
+  libo *l;
+
+  if (!cache || !path) return NULL;
+
+  if (stat(path, &st)) return NULL;
+
+  pthread_mutex_lock(&cache->lock);
+
+  e = libo_cache_lookup(cache, path);
+  if (e && (e->size == st.st_size) && (e->mtime == st.st_mtime))
   {
-    fprintf(stderr, "Failed to parse app.xml\n"); fflush(stderr);
-    return NULL;
+    libo_cache_touch(cache, e);
+    ++e->refs;
+    ++cache->hits;
+    pthread_mutex_unlock(&cache->lock);
+    return e->l;
   }
-  free(buf);
 
-    // Fill libo_xl_strings structure with strings from XML
+  pthread_mutex_unlock(&cache->lock);
 
-  strings = strings_new();
-  if (!strings)
+    // file changed, or not cached yet, check central directory before reading
+
+  if (zip_directory_crc(path, &crc)) return NULL;
+
+  pthread_mutex_lock(&cache->lock);
+
+  e = libo_cache_lookup(cache, path);
+  if (e && (e->crc == crc))
   {
-    xmlFreeDoc(doc);
+    e->size = st.st_size;
+    e->mtime = st.st_mtime;
+    libo_cache_touch(cache, e);
+    ++e->refs;
+    ++cache->hits;
+    pthread_mutex_unlock(&cache->lock);
+    return e->l;
+  }
+
+  ++cache->misses;
+
+  pthread_mutex_unlock(&cache->lock);
+
+  l = libo_open(path);
+  if (!l) return NULL;
+
+  libo_close(l);
+
+  e = (libo_cache_entry *)malloc(sizeof(libo_cache_entry));
+  if (!e)
+  {
+    libo_free(l);
     return NULL;
   }
+  memset(e, 0, sizeof(libo_cache_entry));
 
-  node = xmlDocGetRootElement(doc);
-  if (!strcmp((char *)node->name, "sst"))
+  e->path = strdup(path);
+  e->size = st.st_size;
+  e->mtime = st.st_mtime;
+  e->crc = crc;
+  e->l = l;
+  e->bytes = libo_memory_size(l) + sizeof(libo_cache_entry);
+  e->refs = 1;
+
+  pthread_mutex_lock(&cache->lock);
+
+    // another thread may have read the same file in the meantime
+
+  found = libo_cache_lookup(cache, path);
+  if (found && (found->crc == crc))
   {
-    node = node->children;
-    while (node)
-    {
-      if (!strcmp((char *)node->name, "si"))
-      {
-        buf = (char *)xmlNodeGetContent(node);
-        str = string_new_with_values(buf, 0);
-        if (str) strings_add(strings, str);
-      }
-      node = node->next;
-    }
+    libo_cache_touch(cache, found);
+    ++found->refs;
+    l = found->l;
+    pthread_mutex_unlock(&cache->lock);
+    libo_cache_entry_free(e);
+    return l;
   }
 
-  xmlFreeDoc(doc);
+  if (found) libo_cache_remove(cache, found);
 
-  return strings;
-}
+  libo_cache_insert(cache, e);
+  libo_cache_trim(cache);
 
-static int _strings_indent = 0;    /**<  Used by string_dumper()  */
-static FILE *_dumper_file = NULL;  /**<  Used by dumpers  */
+  pthread_mutex_unlock(&cache->lock);
+
+  return l;
+}
 
   /**
-   *  @fn void libo_xl_strings_dump(strings *strs, FILE *stream, int indent)
+   *  @fn void libo_cache_release(libo_cache *cache, libo *l)
    *
-   *  @brief dumps contents of @p lxs to @p stream, default is STDOUT
+   *  @brief returns a reference obtained by libo_cache_open() to @p cache
    *
-   *  @param strs - pointer to @a strings struct
-   *  @param stream - open FILE * for writing
-   *  @param indent - number of spaces to indent output
+   *  @param cache - pointer to existing @a libo_cache struct
+   *  @param l - pointer to @a libo struct obtained from @p cache
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_strings_dump(strings *strs, FILE *stream, int indent)
+void libo_cache_release(libo_cache *cache, libo *l)
 {
-  if (!strs) return;
+  libo_cache_entry *e;
+  libo_cache_entry *prev = NULL;
 
-  if (!stream) stream = stdout;
+  if (!cache || !l) return;
 
-  do_indent(stream, indent); fprintf(stream,
-                                     "Shared strings (%d):\n",
-                                     strs->last_id);
-  indent += 2;
+  pthread_mutex_lock(&cache->lock);
 
-  _dumper_file = stream;
-  _strings_indent = indent;
+  e = libo_cache_lookup(cache, l->path);
+  if (e && (e->l == l))
+  {
+    if (e->refs > 0) --e->refs;
+    libo_cache_trim(cache);
+    pthread_mutex_unlock(&cache->lock);
+    return;
+  }
 
-  avl_walk(strs->id_root, string_id, string_dumper);
+  for (e = cache->stale; e; prev = e, e = e->next)
+  {
+    if (e->l != l) continue;
+
+    if (e->refs > 0) --e->refs;
+    if (!e->refs)
+    {
+      if (prev) prev->next = e->next;
+      else cache->stale = e->next;
+      libo_cache_entry_free(e);
+    }
+    break;
+  }
+
+  pthread_mutex_unlock(&cache->lock);
 
   return;
 }
 
-libo_xl *__xl__ = NULL ;  /**<  CHEAT -- short cut to parent @a libo_xl for various dumps  */
-
   /**
-   *  @fn void libo_xl_dump(libo_xl *xl, FILE *stream, int indent)
+   *  @fn size_t libo_cache_get_budget(libo_cache *cache)
    *
-   *  @brief dumps contents of @p xl to @p stream, default is STDOUT
+   *  @brief returns memory budget of @p cache
    *
-   *  @param xl - pointer to existing @a libo_xl struct
-   *  @param stream - open FILE * for writing
-   *  @param indent - number of spaces to indent output
+   *  @param cache - pointer to existing @a libo_cache struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return maximum number of bytes of cached documents
    */
 
-void libo_xl_dump(libo_xl *xl, FILE *stream, int indent)
+size_t libo_cache_get_budget(libo_cache *cache)
 {
-  if (!xl) return;
-  if (!stream) return;
-
-  __xl__ = xl;
+  if (!cache) return 0;
 
-  do_indent(stream, indent); fprintf(stream, "LIBO_XL:\n");
-  indent += 2;
-  if (xl->book) libo_xl_book_dump(xl->book, stream, indent);
-  if (xl->strings) libo_xl_strings_dump(xl->strings, stream, indent);
-
-  return;
+  return cache->budget;
 }
 
   /**
-   *  @fn void libo_doc_dump(libo_doc *doc, FILE *stream, int indent)
+   *  @fn void libo_cache_set_budget(libo_cache *cache, size_t budget)
    *
-   *  @brief dumps contents of @p doc to @p stream, default is STDOUT
+   *  @brief sets memory budget of @p cache, evicting documents as needed
    *
-   *  @param doc - pointer to existing @a libo_doc struct
-   *  @param stream - open FILE * for writing
-   *  @param indent - number of spaces to indent output
+   *  @param cache - pointer to existing @a libo_cache struct
+   *  @param budget - maximum number of bytes of cached documents
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_doc_dump(libo_doc *doc, FILE *stream, int indent)
+void libo_cache_set_budget(libo_cache *cache, size_t budget)
 {
-  if (!doc) return;
-  if (!stream) return;
+  if (!cache) return;
 
-  do_indent(stream, indent); fprintf(stream, "LIBO_DOC:\n");
-  return;
+  pthread_mutex_lock(&cache->lock);
+
+  cache->budget = budget;
+  libo_cache_trim(cache);
+
+  pthread_mutex_unlock(&cache->lock);
 }
 
   /**
-   *  @fn void libo_pp_dump(libo_pp *pp, FILE *stream, int indent)
+   *  @fn void libo_cache_dump(libo_cache *cache, FILE *stream, int indent)
    *
-   *  @brief dumps contents of @p pp to @p stream, default is STDOUT
+   *  @brief dumps contents of @p cache to @p stream, default is STDOUT
    *
-   *  @param pp - pointer to existing @a libo_pp struct
+   *  @param cache - pointer to existing @a libo_cache struct
    *  @param stream - open FILE * for writing
    *  @param indent - number of spaces to indent output
    *
@@ -1705,3306 +2952,24287 @@ void libo_doc_dump(libo_doc *doc, FILE *stream, int indent)
    *  Nothing.
    */
 
-void libo_pp_dump(libo_pp *pp, FILE *stream, int indent)
+void libo_cache_dump(libo_cache *cache, FILE *stream, int indent)
 {
-  if (!pp) return;
-  if (!stream) return;
+  libo_cache_entry *e;
 
-  do_indent(stream, indent); fprintf(stream, "LIBO_PP:\n");
-  return;
-}
+  if (!cache) return;
 
-  /**
-   *  @fn libo_xl_book *libo_xl_book_new(void)
-   *
-   *  @brief returns new @a libo_xl_book struct
-   *
-   *  @par Parameters
-   *  None.
-   *
-   *  @return pointer to new @a libo_xl_book struct
-   */
+  if (!stream) stream = stdout;
 
-libo_xl_book *libo_xl_book_new(void)
-{
-  libo_xl_book *book;
+  pthread_mutex_lock(&cache->lock);
 
-  book = (libo_xl_book *)malloc(sizeof(libo_xl_book));
-  if (!book) return NULL;
-  memset(book, 0, sizeof(libo_xl_book));
+  do_indent(stream, indent); fprintf(stream, "LIBO_CACHE:\n");
+  indent += 2;
+  do_indent(stream, indent); fprintf(stream, "Budget: %zu\n", cache->budget);
+  do_indent(stream, indent); fprintf(stream, "Bytes: %zu\n", cache->bytes);
+  do_indent(stream, indent); fprintf(stream, "Hits: %lu\n", cache->hits);
+  do_indent(stream, indent); fprintf(stream, "Misses: %lu\n", cache->misses);
+  do_indent(stream, indent); fprintf(stream, "Entries (%d):\n", cache->n_entries);
 
-  return book;
+  indent += 2;
+  for (e = cache->head; e; e = e->next)
+  {
+    do_indent(stream, indent);
+      fprintf(stream,
+              "Path: %s, Bytes: %zu, References: %d, CRC: %08lx\n",
+              e->path,
+              e->bytes,
+              e->refs,
+              e->crc);
+  }
+
+  pthread_mutex_unlock(&cache->lock);
+
+  return;
 }
 
   /**
-   *  @fn libo_xl_book *libo_xl_book_dup(libo_xl_book *book)
+   *  @fn void libo_dump(libo *l, FILE *stream, int indent)
    *
-   *  @brief creates a deep copy of @p book
+   *  @brief dumps contents of @p l to a file, @b STDOUT by default
    *
-   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param l - pointer to existing @a libo struct
+   *  @param stream - open FILE pointer for writing
+   *  @param indent - initial indentation to use for output
    *
-   *  @return pointer to new @a libo_xl_book struct
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_xl_book *libo_xl_book_dup(libo_xl_book *book)
+void libo_dump(libo *l, FILE *stream, int indent)
 {
-  libo_xl_book *nbook = NULL;
-  int i;
-
-  if (!book) goto exit;
+  if (!l) return;
 
-  nbook = libo_xl_book_new();
-  if (!nbook) goto exit;
+  if (!stream) stream = stdout;
 
-  nbook->n_sheets = book->n_sheets;
+  do_indent(stream, indent); fprintf(stream, "LIBO:\n");
+  indent += 2;
+  do_indent(stream, indent); fprintf(stream, "Path: %s\n", l->path);
+  do_indent(stream, indent); fprintf(stream, "Type: %s\n", libo_type_to_string(l->type));
+  do_indent(stream, indent); fprintf(stream, "z: %p\n", l->z);
 
-  for (i = 0; i < book->n_sheets; i++)
-    libo_xl_book_add(nbook, book->sheet[i]);
+  switch (l->type)
+  {
+    case libo_type_none: break;
+    case libo_type_xl:
+      libo_xl_dump(l->xl, stream, indent);
+      break;
+    case libo_type_doc:
+      libo_doc_dump(l->doc, stream, indent);
+      break;
+    case libo_type_pp:
+      libo_pp_dump(l->pp, stream, indent);
+      break;
+  }
 
-exit:
-  return nbook;
+  return;
 }
 
   /**
-   *  @fn void libo_xl_book_free(libo_xl_book *book)
+   *  @fn libo_type libo_get_type(libo *l)
    *
-   *  @brief frees all memory allocated to @p book
+   *  @brief returns document type of @p l
    *
-   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param l - pointer to existing @a libo struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return @a libo_type
    */
 
-void libo_xl_book_free(libo_xl_book *book)
+libo_type libo_get_type(libo *l)
 {
-  int i;
-
-  if (!book) return;
-
-  for (i = 0; i < book->n_sheets; i++)
-    libo_xl_sheet_free(book->sheet[i]);
-
-  free(book);
+  if (!l) return libo_type_none;
 
-  return;
+  return l->type;
 }
 
   /**
-   *  @fn void libo_xl_book_add(libo_xl_book *xlb, libo_xl_sheet *xls)
+   *  @fn void libo_set_type(libo *l, libo_type type)
    *
-   *  @brief add @p xls to @p xlb
+   *  @brief sets type of @p l to @p type
    *
-   *  @param xlb - pointer to existing @a libo_xl_book struct
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @param l - pointer to existing @a libo struct
+   *  @param type - @a libo_type
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_book_add(libo_xl_book *xlb, libo_xl_sheet *xls)
+void libo_set_type(libo *l, libo_type type)
 {
-  libo_xl_sheet **tmp = NULL;
-  char rid_str[128];
+  if (!l) return;
 
-  if (!xlb || !xls) return;
+  libo_close(l);
 
-  memset(rid_str, 0, 128);
+  switch (l->type)
+  {
+    case libo_type_doc:
+      libo_doc_free(l->doc);
+      break;
 
-  tmp = realloc(xlb->sheet, sizeof(libo_xl_sheet *) * (xlb->n_sheets + 1));
-  if (!tmp) return;
+    case libo_type_pp:
+      libo_pp_free(l->pp);
+      break;
 
-  xlb->sheet = tmp;
+    case libo_type_xl:
+      libo_xl_free(l->xl);
+      break;
 
-  xlb->sheet[xlb->n_sheets] = libo_xl_sheet_dup(xls);
+    case libo_type_none:
+    default:
+      break;
+  }
 
-  xlb->sheet[xlb->n_sheets]->ID = xlb->n_sheets + 1;
+  l->type = type;
 
-  sprintf(rid_str, "rId%d", xlb->n_sheets + 4);
-  if (xlb->sheet[xlb->n_sheets]->rID)
-    free(xlb->sheet[xlb->n_sheets]->rID);
-  xlb->sheet[xlb->n_sheets]->rID = strdup(rid_str);
+  switch (l->type)
+  {
+    case libo_type_doc:
+      l->doc = libo_doc_new();
+      break;
 
-  ++xlb->n_sheets;
+    case libo_type_pp:
+      l->pp = libo_pp_new();
+      break;
+
+    case libo_type_xl:
+      l->xl = libo_xl_new();
+      break;
+
+    case libo_type_none:
+    default:
+      l->xl = NULL;
+      break;
+  }
 }
 
   /**
-   *  @fn libo_xl_sheet *libo_xl_sheet_new(void)
+   *  @fn char *libo_get_path(libo *l)
    *
-   *  @brief returns new @a libo_xl_sheet struct
+   *  @brief returns path to @a libo file
    *
-   *  @par Parameters
-   *  None.
+   *  @param l - pointer to existing @a libo struct
    *
-   *  @return pointer to new @a libo_xl_sheet struct
+   *  @return string containing path to file
    */
 
-libo_xl_sheet *libo_xl_sheet_new(void)
+char *libo_get_path(libo *l)
 {
-  libo_xl_sheet *sheet;
-
-  sheet = (libo_xl_sheet *)malloc(sizeof(libo_xl_sheet));
-  if (!sheet) return NULL;
-  memset(sheet, 0, sizeof(libo_xl_sheet));
-
-  sheet->default_row_height = 14.4;
+  if (!l) return NULL;
 
-  return sheet;
+  return l->path;
 }
 
   /**
-   *  @fn libo_xl_sheet *libo_xl_sheet_dup(libo_xl_sheet *sheet)
+   *  @fn void libo_set_path(libo *l, char *path)
    *
-   *  @brief makes deep copy of @p sheet
+   *  @brief sets path in @p l to @p path
    *
-   *  @param sheet - pointer to existing @a libo_xml_sheet struct
+   *  @param l - pointer to existing @a libo struct
+   *  @param path - string containing new path
    *
-   *  @return pointer to new @a libo_xl_sheet struct
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_xl_sheet *libo_xl_sheet_dup(libo_xl_sheet *sheet)
+void libo_set_path(libo *l, char *path)
 {
-  libo_xl_sheet *nsheet = NULL;
-  int i;
-
-  if (!sheet) goto exit;
-
-  nsheet = libo_xl_sheet_new();
-  if (!nsheet) goto exit;
-
-  nsheet->n_cols = sheet->n_cols;
-  nsheet->default_row_height = sheet->default_row_height;
-
-  if (sheet->name) nsheet->name = strdup(sheet->name);
-
-  for (i = 0; i < sheet->n_rows; i++)
-    libo_xl_sheet_add(nsheet, sheet->row[i]);
-
-exit:
-  return nsheet;
+  if (!l) return;
+  if (l->path) free(l->path);
+  l->path = NULL;
+  if (path) l->path = strdup(path);
 }
 
   /**
-   *  @fn void libo_xl_sheet_free(libo_xl_sheet *sheet)
+   *  @fn libo_xl *libo_get_xl(libo *l)
    *
-   *  @brief frees all memory allocated to @p sheet
+   *  @brief returns @a libo_xl from @p l
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param l - pointer to existing @a libo struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return pointer to @a libo_xl
    */
 
-void libo_xl_sheet_free(libo_xl_sheet *sheet)
+libo_xl *libo_get_xl(libo *l)
 {
-  int i;
-
-  if (!sheet) return;
-
-  for (i = 0; i < sheet->n_rows; i++)
-    libo_xl_row_free(sheet->row[i]);
+  if (!l) return NULL;
 
-  free(sheet);
+  if (l->type == libo_type_xl) return l->xl;
 
-  return;
+  return NULL;
 }
 
   /**
-   *  @fn void libo_xl_sheet_set_name(libo_xl_sheet *xls, char *name);
+   *  @fn libo_xl_book *libo_xl_get_book(libo_xl *xl)
    *
-   *  @brief sets name value for @p xls to @p name
+   *  @brief returns @a libo_xl_book from @p xl
    *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
-   *  @param name - string containing new name value
+   *  @param xl - pointer to existing @a libo_xl struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return pointer to @a libo_xl_book
    */
 
-void libo_xl_sheet_set_name(libo_xl_sheet *xls, char *name)
+libo_xl_book *libo_xl_get_book(libo_xl *xl)
 {
-  if (!xls) return;
+  if (!xl) return NULL;
 
-  if (xls->name) free(xls->name);
-  xls->name = NULL;
-  if (name) xls->name = strdup(name);
+  return xl->book;
+
+  return NULL;
 }
 
   /**
-   *  @fn void libo_xl_sheet_set_id(libo_xl_sheet *xls, int id)
+   *  @fn int libo_xl_book_get_sheet_count(libo_xl_book *xlb)
    *
-   *  @brief sets ID value for @p xls to @p id
+   *  @brief returns number of work sheets in @p xlb
    *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
-   *  @param id - string containing new ID value
+   *  @param xlb - pointer to existing @a libo_xl_book struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return count of sheets
    */
 
-void libo_xl_sheet_set_id(libo_xl_sheet *xls, int id)
+int libo_xl_book_get_sheet_count(libo_xl_book *xlb)
 {
-  if (!xls) return;
+  if (!xlb) return 0;
 
-  xls->ID = id;
+  return xlb->n_sheets;
 }
 
   /**
-   *  @fn void libo_xl_sheet_set_rid(libo_xl_sheet *xls, char *rid)
+   *  @fn libo_xl_sheet *libo_xl_book_get_sheet(libo_xl_book *xlb, int n)
    *
-   *  @brief sets rID value for @p xls to @p rid
+   *  @brief returns specific work sheet in @p xlb
    *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
-   *  @param rid - string containing new rID value
+   *  If the sheet's rows were evicted to fit the memory budget of @p xlb,
+   *  they are read again, and other sheets may be evicted in turn.
    *
-   *  @par Returns
-   *  Nothing.
+   *  @param xlb - pointer to existing @a libo_xl_book struct
+   *  @param n - index of desired sheet
+   *
+   *  @return pointer to @a libo_xl_sheet
    */
 
-void libo_xl_sheet_set_rid(libo_xl_sheet *xls, char *rid)
+libo_xl_sheet *libo_xl_book_get_sheet(libo_xl_book *xlb, int n)
 {
-  if (!xls) return;
+  libo_xl_sheet *sheet;
 
-  if (xls->rID) free(xls->rID);
-  xls->rID = NULL;
-  if (rid) xls->rID = strdup(rid);
+  if (!xlb) return NULL;
+
+  if (n < 0) return NULL;
+  if (n >= xlb->n_sheets) return NULL;
+
+  sheet = xlb->sheet[n];
+  if (!sheet) return NULL;
+
+    // shared books are read from several threads, and eviction picks
+    // sheets by the clock, so both happen under the lock
+
+  pthread_mutex_lock(&xlb->lock);
+
+  sheet->used = ++xlb->clock;
+
+  if (sheet->state != libo_xl_sheet_state_resident)
+  {
+    if (libo_xl_sheet_restore(xlb, sheet)) sheet = NULL;
+    else if (xlb->memory_budget) book_trim(xlb, sheet);
+  }
+
+  pthread_mutex_unlock(&xlb->lock);
+
+  return sheet;
 }
 
   /**
-   *  @fn void libo_xl_sheet_add(libo_xl_sheet *xls, libo_xl_row *xlr)
+   *  @fn int libo_xl_sheet_get_row_count(libo_xl_sheet *xls)
    *
-   *  @brief add @p xlr to @p xls
+   *  @brief returns number of rows in @p xls
    *
    *  @param xls - pointer to existing @a libo_xl_sheet struct
-   *  @param xlr - pointer to existing @a libo_xl_row struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return count of rows
    */
 
-void libo_xl_sheet_add(libo_xl_sheet *xls, libo_xl_row *xlr)
+int libo_xl_sheet_get_row_count(libo_xl_sheet *xls)
 {
-  libo_xl_row **tmp = NULL;
-
-  if (!xls || !xlr) return;
-
-  tmp = realloc(xls->row, sizeof(libo_xl_row *) * (xls->n_rows + 1));
-  if (!tmp) return;
-
-  xls->row = tmp;
-
-  xls->row[xls->n_rows] = libo_xl_row_dup(xlr);
+  if (!xls) return 0;
 
-  ++xls->n_rows;
+  return xls->n_rows;
 }
 
   /**
-   *  @fn libo_xl_row *libo_xl_row_new(void)
+   *  @fn int libo_xl_sheet_get_column_count(libo_xl_sheet *xls)
    *
-   *  @brief returns new @a libo_xl_row struct
+   *  @brief returns number of columns in @p xls
    *
-   *  @par Parameters
-   *  None.
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
    *
-   *  @return pointer to new @a libo_xl_row struct
+   *  @return count of columns
    */
 
-libo_xl_row *libo_xl_row_new(void)
+int libo_xl_sheet_get_column_count(libo_xl_sheet *xls)
 {
-  libo_xl_row *row;
-
-  row = (libo_xl_row *)malloc(sizeof(libo_xl_row));
-  if (!row) return NULL;
-  memset(row, 0, sizeof(libo_xl_row));
+  if (!xls) return 0;
 
-  return row;
+  return xls->n_cols;
 }
 
   /**
-   *  @fn libo_xl_row *libo_xl_row_dup(libo_xl_row *row)
+   *  @fn int libo_xl_sheet_get_checkpoint_count(libo_xl_sheet *xls)
    *
-   *  @brief returns deep copy of @p row
+   *  @brief returns number of checkpoints reads of @p xls can resume from
    *
-   *  @param row - pointer to existing @a libo_xl_row struct
+   *  See @a libo_options_set_seek_span.
    *
-   *  @return pointer to new @a libo_xl_row struct
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return count of checkpoints
    */
 
-libo_xl_row *libo_xl_row_dup(libo_xl_row *row)
+int libo_xl_sheet_get_checkpoint_count(libo_xl_sheet *xls)
 {
-  libo_xl_row *nrow = NULL;
-  int i;
-
-  if (!row) goto exit;
-
-  nrow = libo_xl_row_new();
-  if (!nrow) goto exit;
-
-  for (i = 0; i < row->n_cells; i++)
-    libo_xl_row_add(nrow, row->cell[i]);
+  if (!xls) return 0;
+  if (!xls->seek) return 0;
 
-exit:
-  return nrow;
+  return xls->seek->n_points;
 }
 
   /**
-   *  @fn void libo_xl_row_free(libo_xl_row *row)
+   *  @fn int libo_xl_sheet_get_source_column(libo_xl_sheet *xls, int col)
    *
-   *  @brief frees all memory allocated to @p row
+   *  @brief returns index of column of file that column @p col of @p xls
+   *         was read from
    *
-   *  @param row - pointer to existing @a libo_xl_row struct
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return index of column in file, @p col if all columns were read, -1
+   *          if the column was not found or @p col is out of range
    */
 
-void libo_xl_row_free(libo_xl_row *row)
+int libo_xl_sheet_get_source_column(libo_xl_sheet *xls, int col)
 {
-  int i;
+  if (!xls) return -1;
+  if (col < 0) return -1;
 
-  if (!row) return;
-
-  for (i = 0; i < row->n_cells; i++)
-    libo_xl_cell_free(row->cell[i]);
+  if (!xls->source) return col;
 
-  free(row);
+  if (col >= xls->n_sources) return -1;
 
-  return;
+  return xls->source[col];
 }
 
   /**
-   *  @fn void libo_xl_row_add(libo_xl_row *xlr, libo_xl_cell *xlc)
+   *  @fn char *libo_xl_sheet_get_name(libo_xl_sheet *xls)
    *
-   *  @brief add @p xlc to @p xlr
+   *  @brief returns title of @p xls
    *
-   *  @param xlr - pointer to existing @a libo_xl_row struct
-   *  @param xlc - pointer to existing @a libo_xl_cell struct
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return string containing title/name of work sheet
    */
 
-void libo_xl_row_add(libo_xl_row *xlr, libo_xl_cell *xlc)
+char *libo_xl_sheet_get_name(libo_xl_sheet *xls)
 {
-  libo_xl_cell **tmp = NULL;
-
-  if (!xlr || !xlc) return;
-
-  tmp = realloc(xlr->cell, sizeof(libo_xl_cell *) * (xlr->n_cells + 1));
-  if (!tmp) return;
-
-  xlr->cell = tmp;
-
-  xlr->cell[xlr->n_cells] = libo_xl_cell_dup(xlc);
+  if (!xls) return NULL;
 
-  ++xlr->n_cells;
+  return xls->name;
 }
 
   /**
-   *  @fn libo_xl_cell *libo_xl_cell_new(void)
+   *  @fn int libo_xl_sheet_get_id(libo_xl_sheet *xls)
    *
-   *  @brief returns new @a libo_xl_cell struct
+   *  @brief returns identifier of @p xls
    *
-   *  @par Parameters
-   *  None.
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
    *
-   *  @return pointer to new @a libo_xl_cell struct
+   *  @return integer identifier
    */
 
-libo_xl_cell *libo_xl_cell_new(void)
+int libo_xl_sheet_get_id(libo_xl_sheet *xls)
 {
-  libo_xl_cell *cell;
-
-  cell = (libo_xl_cell *)malloc(sizeof(libo_xl_cell));
-  if (cell) memset(cell, 0, sizeof(libo_xl_cell));
+  if (!xls) return 0;
 
-  return cell;
+  return xls->ID;
 }
 
   /**
-   *  @fn libo_xl_cell *libo_xl_cell_dup(libo_xl_cell *cell)
+   *  @fn char *libo_xl_sheet_get_rid(libo_xl_sheet *xls)
    *
-   *  @brief returns deep copy of @p cell
+   *  @brief returns relative identifier of @p xls
    *
-   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
    *
-   *  @return pointer to new @a libo_xl_cell struct
+   *  @return string containing relative identifier
    */
 
-libo_xl_cell *libo_xl_cell_dup(libo_xl_cell *cell)
+char *libo_xl_sheet_get_rid(libo_xl_sheet *xls)
 {
-  libo_xl_cell *ncell = NULL;
-
-  if (!cell) goto exit;
-
-  ncell = libo_xl_cell_new();
-  if (!ncell) goto exit;
-
-  memcpy(ncell, cell, sizeof(libo_xl_cell));
-
-  if (cell->type == libo_xl_cell_type_expression)
-  {
-    if (cell->expression.formula)
-      libo_xl_cell_expression_set_formula(&cell->expression,
-                                          cell->expression.formula);
-    if (cell->expression.value)
-      libo_xl_cell_expression_set_value(&cell->expression,
-                                        cell->expression.value);
-  }
+  if (!xls) return NULL;
 
-exit:
-  return ncell;
+  return xls->rID;
 }
 
   /**
-   *  @fn libo_xl_cell *libo_xl_cell_create(libo_xl_sheet *sheet,
-   *                                        int row,
-   *                                        int col)
+   *  @fn libo_xl_row *libo_xl_sheet_get_row(libo_xl_sheet *xls, int n)
    *
-   *  @brief returns deep copy of @p cell
+   *  @brief returns row at index @p n from @p xls
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
-   *  @param row - row index to into which to add the cell
-   *  @param col - col index of cell to create
+   *  NOTE:  for a sheet on disk, compressed or columnar, the row is a
+   *         decoded copy held in a per thread cache of 8 blocks.  It is
+   *         freed once 8 other blocks have been read on the thread, and
+   *         changes made to it are dropped.  Copy what must be kept, and
+   *         change cells through @a libo_xl_cell_create.
    *
-   *  @return pointer to new @a libo_xl_cell struct
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @param n - index of row to retrieve
+   *
+   *  @return pointer to @a libo_xl_row
    */
 
-libo_xl_cell *libo_xl_cell_create(libo_xl_sheet *sheet, int row, int col)
+libo_xl_row *libo_xl_sheet_get_row(libo_xl_sheet *xls, int n)
 {
-  if (!sheet) return NULL;
-  if (row < 0) return NULL;
-  if (col < 0) return NULL;
+  if (!xls) return NULL;
+
+  if (n < 0) return NULL;
+  if (n >= xls->n_rows) return NULL;
 
-  if ((row < sheet->n_rows) && (col < sheet->row[row]->n_cells))
-    return sheet->row[row]->cell[col];
+  if (xls->store) return libo_xl_store_get_row(xls->store, n);
 
-  libo_xl_col_fill(sheet, row, col);
+    // rows of a sheet that could not be restored are not resident
 
-  return NULL;
+  if (!xls->row) return NULL;
+
+  return xls->row[n];
 }
 
   /**
-   *  @fn void libo_xl_cell_free(libo_xl_cell *cell)
+   *  @fn int libo_xl_row_get_cell_count(libo_xl_row *xlr)
    *
-   *  @brief frees all memory allocated to @p cell
+   *  @brief returns number of cells in @p xlr
    *
-   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param xlr - pointer to existing @a libo_xl_row struct
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return number of cells in @p xlr
    */
 
-void libo_xl_cell_free(libo_xl_cell *cell)
+int libo_xl_row_get_cell_count(libo_xl_row *xlr)
 {
-  if (!cell) return;
-
-  free(cell);
+  if (!xlr) return 0;
 
-  return;
+  return xlr->n_cells;
 }
 
   /**
-   *  @fn libo_xl *libo_xl_read(libo *l)
+   *  @fn libo_xl_cell *libo_xl_row_get_cell(libo_xl_row *xlr, int n)
    *
-   *  @brief reads entire contents of Excel parts of document file
+   *  @brief returns cell at index @p n from @p xlr
    *
-   *  @param l - pointer to existing @a libo struct
+   *  NOTE:  a cell of a row of a sheet on disk, compressed or columnar
+   *         belongs to a decoded copy of the row, valid only until 8 other
+   *         blocks are read on the thread, see @a libo_xl_sheet_get_row.
    *
-   *  NOTE:  @p l must already have read ZIP file
+   *  Changing the cell does not mark its sheet changed, so indexes over it
+   *  go on giving the old value.  Change cells of a sheet through
+   *  @a libo_xl_cell_create or @a libo_xl_sheet_set_number, or call
+   *  @a libo_xl_sheet_set_dirty after.
    *
-   *  @return pointer to new @a lib_xl struct
+   *  @param xlr - pointer to existing @a libo_xl_row struct
+   *  @param n - index of cell to retrieve
+   *
+   *  @return pointer to @a libo_xl_cell
    */
 
-libo_xl *libo_xl_read(libo *l)
+libo_xl_cell *libo_xl_row_get_cell(libo_xl_row *xlr, int n)
 {
-  libo_xl *xl;
-
-  if (!l) return NULL;
-
-  xl = libo_xl_new();
-  if (!xl) return NULL;
+  if (!xlr) return NULL;
 
-  xl->book = libo_xl_book_read(l);
-  xl->strings = libo_xl_strings_read(l);
+  if (n < 0) return NULL;
+  if (n >= xlr->n_cells) return NULL;
 
-  return xl;
+  return xlr->cell[n];
 }
 
   /**
-   *  @fn libo_xl_book *libo_xl_book_read(libo *l)
-   *
-   *  @brief reads work book contents of Excel parts of document file
+   *  @fn libo_xl_cell_type libo_xl_cell_get_type(libo_xl_cell *xlc)
    *
-   *  @param l - pointer to existing @a libo struct
+   *  @brief returns cell type of @p xlc
    *
-   *  NOTE:  @p l must already have read ZIP file
+   *  @param xlc - pointer to existing @a libo_xl_cell
    *
-   *  @return pointer to new @a lib_xl struct
+   *  @return @a libo_xl_cell_type
    */
 
-libo_xl_book *libo_xl_book_read(libo *l)
+libo_xl_cell_type libo_xl_cell_get_type(libo_xl_cell *xlc)
 {
-  libo_xl_book *book;
-  zip_file_t *zf;
-  int len;
-  char *workbook_file_name = "xl/workbook.xml";
-  char *buf;
-  zip_stat_t stat;
-  xmlDocPtr doc = NULL;
-  int i;
-
-  book = libo_xl_book_new();
-  if (!book) return NULL;
-
-    // open xl/workbook.xml
+  if (!xlc) return libo_xl_cell_type_none;
 
-  if (zip_stat(l->z, workbook_file_name, 0, &stat)) return NULL;
-  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return NULL;
+  return xlc->type;
+}
 
-  if (strcmp(workbook_file_name, stat.name)) return NULL;
+  /**
+   *  @fn void libo_xl_cell_set_type(libo_xl_cell *xlc, libo_xl_cell_type type)
+   *
+   *  @brief sets cell type of @p xlc to @p type
+   *
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param type - @a libo_xl_cell_type
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-  len = stat.size;
+void libo_xl_cell_set_type(libo_xl_cell *xlc, libo_xl_cell_type type)
+{
+  if (!xlc) return;
 
-  zf = zip_fopen(l->z, workbook_file_name, 0);
-  if (!zf)
+  if (xlc->type == libo_xl_cell_type_expression)
   {
-    fprintf(stderr, "Can not open '%s'\n", workbook_file_name); fflush(stderr);
-    return NULL;
+    if (xlc->expression.formula) free(xlc->expression.formula);
+    if (xlc->expression.value) free(xlc->expression.value);
   }
 
-  buf = (char *)malloc(len+1);
-  if (!buf)
-  {
-    zip_fclose(zf);
-    return NULL;
-  }
-  memset(buf, 0, len+1);
+  memset(&xlc->expression, 0, sizeof(libo_xl_cell_expression));
 
-  zip_fread(zf, buf, len);
+  xlc->type = type;
+  xlc->shared = 0;
+}
 
-  zip_fclose(zf);
+  /**
+   *  @fn char *libo_xl_cell_get_string_value(libo_xl *xl, libo_xl_cell *xlc)
+   *
+   *  @brief returns string value of @p xlc
+   *
+   *  NOTE:  @p xl is required, as we need to lookup values in the string dictionary
+   *
+   *  NOTE:  the value is allocated on every call, see
+   *         @a libo_xl_cell_get_string_view and @a libo_xl_cell_format_number
+   *         for accessors that do not allocate
+   *
+   *  @param xl - pointer to existing @a libo_xl
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *
+   *  @return string containing cell's value, NULL if cell type is unknown
+   */
 
-  doc = xmlParseMemory(buf, len);
-  if (!doc)
-  {
-    fprintf(stderr, "Failed to parse '%s'\n", workbook_file_name); fflush(stderr);
-    return NULL;
-  }
-  free(buf);
+char *libo_xl_cell_get_string_value(libo_xl *xl, libo_xl_cell *xlc)
+{
+  const char *view;
+  char *value = NULL;
 
-  book->n_sheets = count_sheets_in_xml(doc);
+  if (!xlc) return NULL;
 
-  book->sheet = (libo_xl_sheet **)malloc(sizeof(libo_xl_sheet *) * book->n_sheets);
-  if (!book->sheet)
+  if (cell_is_number(xlc))
   {
-    xmlFreeDoc(doc);
-    return NULL;
+    value = (char *)malloc(LIBO_XL_NUMBER_SIZE);
+    if (value) libo_xl_cell_format_number(xlc, value, LIBO_XL_NUMBER_SIZE);
   }
-
-  for (i = 0; i < book->n_sheets; i++)
+  else
   {
-    book->sheet[i] = libo_xl_sheet_meta_read(doc, i);
-    libo_xl_sheet_read(l, book->sheet[i], i);
+    view = libo_xl_cell_get_string_view(xl, xlc, NULL);
+    if (view) value = strdup(view);
   }
 
-  xmlFreeDoc(doc);
-
-  return book;
+  return value;
 }
 
   /**
-   *  @fn void libo_xl_book_dump(libo_xl_book *lxb, FILE *stream, int indent)
+   *  @fn const char *libo_xl_cell_get_string_view(libo_xl *xl,
+   *                                               libo_xl_cell *xlc,
+   *                                               size_t *length)
    *
-   *  @brief dumps contents of @p lxb to @p stream, default is STDOUT
+   *  @brief returns text of @p xlc without copying it
    *
-   *  @param lxb - pointer to existing @a libo_xl_box struct
-   *  @param stream - open FILE * for writing
-   *  @param indent - number of spaces to indent output
+   *  Reference cells give their text in the string dictionary, expression
+   *  cells their formula or, lacking one, their value.  Booleans give TRUE
+   *  or FALSE, errors their code, and empty cells no text.  Number cells
+   *  have no stored text, format them with @a libo_xl_cell_format_number.  Cells
+   *  of a sheet sharing a formula hold no text of their own and give their
+   *  value, format theirs with @a libo_xl_sheet_format_formula.
    *
-   *  @par Returns
-   *  Nothing.
+   *  @param xl - pointer to existing @a libo_xl
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param length - if not NULL, receives length of text in bytes
+   *
+   *  @return pointer to text owned by @p xl or @p xlc, NULL if @p xlc has none
    */
 
-void libo_xl_book_dump(libo_xl_book *lxb, FILE *stream, int indent)
+const char *libo_xl_cell_get_string_view(libo_xl *xl, libo_xl_cell *xlc, size_t *length)
 {
-  int i;
+  libo_xl_cell_expression *expr;
+  const char *view = NULL;
 
-  if (!lxb) return;
+  if (length) *length = 0;
+  if (!xlc) return NULL;
 
-  if (!stream) stream = stdout;
+  switch (libo_xl_cell_get_type(xlc))
+  {
+    case libo_xl_cell_type_reference:
+      view = libo_xl_cell_get_text(xl, xlc);
+      break;
 
-  do_indent(stream, indent); fprintf(stream, "Book:\n");
-  indent += 2;
+    case libo_xl_cell_type_expression:
+      expr = libo_xl_cell_get_expression(xlc);
+      view = libo_xl_cell_expression_get_formula(expr);
+      if (!view) view = libo_xl_cell_expression_get_value(expr);
+      if (!view) view = "";
+      break;
 
-  do_indent(stream, indent); fprintf(stream, "Sheets (%d):\n", lxb->n_sheets);
+    case libo_xl_cell_type_boolean:
+      view = xlc->boolean ? "TRUE" : "FALSE";
+      break;
 
-  indent += 2;
+    case libo_xl_cell_type_error:
+      view = libo_xl_error_to_string(xlc->error);
+      break;
 
-  for (i = 0; i < lxb->n_sheets; i++)
-    libo_xl_sheet_dump(lxb->sheet[i], stream, indent);
+    case libo_xl_cell_type_empty:
+      view = "";
+      break;
 
-  return;
+    default: break;
+  }
+
+  if (view && length) *length = strlen(view);
+
+  return view;
 }
 
   /**
-   *  @fn void libo_xl_sheet_dump(libo_xl_sheet *lxs, FILE *stream, int indent)
+   *  @fn size_t libo_xl_cell_format_number(libo_xl_cell *xlc, char *buffer,
+   *                                        size_t size)
    *
-   *  @brief dumps contents of @p lxs to @p stream, default is STDOUT
+   *  @brief formats number in @p xlc into @p buffer
    *
-   *  @param lxs - pointer to existing @a libo_xl_sheet struct
-   *  @param stream - open FILE * for writing
-   *  @param indent - number of spaces to indent output
+   *  The number is written as @a libo_xl_cell_get_string_value would give it,
+   *  with the fewest digits that read back the same, truncated to fit
+   *  @p size bytes including the terminator.  A buffer of
+   *  @a LIBO_XL_NUMBER_SIZE bytes always holds the whole number.
    *
-   *  @par Returns
-   *  Nothing.
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param buffer - buffer to receive formatted number
+   *  @param size - size of @p buffer in bytes
+   *
+   *  @return length of formatted number, 0 if @p xlc is not a number
    */
 
-void libo_xl_sheet_dump(libo_xl_sheet *lxs, FILE *stream, int indent)
+size_t libo_xl_cell_format_number(libo_xl_cell *xlc, char *buffer, size_t size)
 {
-  int i;
-
-  if (!lxs) return;
-
-  do_indent(stream, indent); fprintf(stream, "Sheet:\n");
-
-  indent += 2;
-
-  do_indent(stream, indent); fprintf(stream, "Name: %s\n", lxs->name);
-  do_indent(stream, indent); fprintf(stream, "ID: %d\n", lxs->ID);
-  do_indent(stream, indent); fprintf(stream, "rID: %s\n", lxs->rID);
+  char text[LIBO_XL_NUMBER_SIZE];
+  int n;
 
-  do_indent(stream, indent);
-    fprintf(stream, "Rows (%d):\n", lxs->n_rows);
+  if (buffer && size) *buffer = 0;
+  if (!cell_is_number(xlc)) return 0;
 
-  indent += 2;
-  for (i = 0; i < lxs->n_rows; i++)
-    libo_xl_row_dump(lxs->row[i], stream, indent);
+  n = snprintf(text, sizeof(text), "%.15g", xlc->number);
+  if (strtod(text, NULL) != xlc->number) n = snprintf(text, sizeof(text), "%.17g", xlc->number);
+  if (buffer && size) snprintf(buffer, size, "%s", text);
 
-  return;
+  return n < 0 ? 0 : (size_t)n;
 }
 
   /**
-   *  @fn libo_xl_sheet *libo_xl_sheet_meta_read(xmlDocPtr doc, int n)
+   *  @fn int libo_xl_cell_get_value(libo_xl *xl, libo_xl_cell *xlc,
+   *                                 libo_xl_value *value)
    *
-   *  @brief creates new @a libo_xl_sheet struct from work sheet at position @p n in file in @a doc
+   *  @brief fills @p value with the type and value of @p xlc
    *
-   *  @param doc - pointer to existing XML document
-   *  @param n - index of work sheet to extract
+   *  Text is given as a view, see @a libo_xl_cell_get_string_view, so
+   *  nothing is allocated.
    *
-   *  @return pointer to new @a libo_xl_sheet struct
+   *  @param xl - pointer to existing @a libo_xl
+   *  @param xlc - pointer to existing @a libo_xl_cell, NULL for an empty cell
+   *  @param value - pointer to @a libo_xl_value to fill
+   *
+   *  @return type of @p xlc, -1 on error
    */
 
-libo_xl_sheet *libo_xl_sheet_meta_read(xmlDocPtr doc, int n)
+int libo_xl_cell_get_value(libo_xl *xl, libo_xl_cell *xlc, libo_xl_value *value)
 {
-  libo_xl_sheet *sheet = NULL;
-  xmlXPathContextPtr xpathCtx; 
-  xmlXPathObjectPtr xpathObj; 
-  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'workbook']/*[local-name() = 'sheets']/*[local-name() = 'sheet']";
-  xmlNodeSetPtr nodes;
-  xmlNodePtr node;
-  int i;
+  if (!value) return -1;
 
-  if (!doc) return NULL;
-  if (n < 0) return NULL;
-
-  sheet = libo_xl_sheet_new();
-  if (!sheet) return NULL;
+  value->type = libo_xl_cell_get_type(xlc);
+  value->number = 0;
+  value->reference = -1;
+  value->error = libo_xl_error_none;
+  value->text = NULL;
+  value->length = 0;
 
-  xpathCtx = xmlXPathNewContext(doc);
-  if(!xpathCtx)
+  switch (value->type)
   {
-    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
-    return NULL;
-  }
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      value->number = xlc->number;
+      break;
 
-  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-  if(!xpathObj)
-  {
-      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-      xmlXPathFreeContext(xpathCtx); 
-      return NULL;
-  }
+    case libo_xl_cell_type_boolean:
+      value->number = xlc->boolean ? 1 : 0;
+      value->text = libo_xl_cell_get_string_view(xl, xlc, &value->length);
+      break;
 
-  nodes = xpathObj->nodesetval;
-  if (nodes)
-  {
-    for (i = 0; i < nodes->nodeNr; i++)
-    {
-      if (!nodes->nodeTab[i]) continue;
-      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
-      {
-        node = nodes->nodeTab[i];
-        if (i == n)
-        {
-          sheet->name = strdup((char *)xmlGetProp(node, (xmlChar *)"name"));
-          sheet->ID = atoi((char *)xmlGetProp(node, (xmlChar *)"sheetId"));
-          sheet->rID = strdup((char *)xmlGetProp(node, (xmlChar *)"id"));
-          break;
-        }
-      }
-    }
-  }
+    case libo_xl_cell_type_error:
+      value->error = xlc->error;
+      value->text = libo_xl_cell_get_string_view(xl, xlc, &value->length);
+      break;
 
-  xmlXPathFreeObject(xpathObj);
-  xmlXPathFreeContext(xpathCtx); 
+    case libo_xl_cell_type_reference:
+      value->reference = xlc->reference;
+      /* fall through */
 
-  return sheet;
+    case libo_xl_cell_type_expression:
+      value->text = libo_xl_cell_get_string_view(xl, xlc, &value->length);
+      break;
+
+    default: break;
+  }
+
+  return value->type;
 }
 
   /**
-   *  @fn void libo_xl_sheet_read(libo *l, libo_xl_sheet *sheet, int n)
+   *  @fn int libo_xl_cell_get_reference(libo_xl_cell *xlc)
    *
-   *  @brief builds data for sheet number @p n into @p sheet that resides in @p l
+   *  @brief returns reference id in @p xlc
    *
-   *  @param l - pointer to existing @a libo struct
-   *  @param sheet = pointer to existing @a libo_xl_sheet, filled with meta data
-   *  @param n - index of work sheet to extract
+   *  @param xlc - pointer to existing @a libo_xl_cell
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return reference id of @p xld, 0 if cell type is not a reference
    */
 
-void libo_xl_sheet_read(libo *l, libo_xl_sheet *sheet, int n)
+int libo_xl_cell_get_reference(libo_xl_cell *xlc)
 {
-  char path[4096];
-  zip_file_t *zf;
-  int len;
-  char *buf;
-  zip_stat_t stat;
-  xmlDocPtr doc = NULL;
-
-  if (!l) return;
-  if (!sheet) return;
-  if (n < 0) return;
-
-  memset(path, 0, 4096);
-
-  sprintf(path, "xl/worksheets/sheet%d.xml", n+1);
-
-    // open xl/worksheets/sheetN.xml
-
-  if (zip_stat(l->z, path, 0, &stat)) return;
-  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return;
-
-  if (strcmp(path, stat.name)) return;
+  if (!xlc) return 0;
+  if (xlc->type != libo_xl_cell_type_reference) return 0;
 
-  len = stat.size;
+  return xlc->reference;
+}
 
-  zf = zip_fopen(l->z, path, 0);
-  if (!zf)
-  {
-    fprintf(stderr, "Can not open '%s'\n", path); fflush(stderr);
-    return;
-  }
+  /**
+   *  @fn void libo_xl_cell_set_reference(libo_xl_cell *xlc, int reference)
+   *
+   *  @brief sets reference value in @p xlc to @p reference
+   *
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param reference - new reference value
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-  buf = (char *)malloc(len+1);
-  if (!buf)
-  {
-    zip_fclose(zf);
-    return;
-  }
-  memset(buf, 0, len+1);
+void libo_xl_cell_set_reference(libo_xl_cell *xlc, int reference)
+{
+  if (!xlc) return;
+  if (xlc->type != libo_xl_cell_type_reference) return;
 
-  zip_fread(zf, buf, len);
+  xlc->reference = reference;
+}
 
-  zip_fclose(zf);
+  /**
+   *  @fn char *libo_xl_cell_get_text(libo_xl *xl, libo_xl_cell *xlc)
+   *
+   *  @brief returns string value of @p xlc
+   *
+   *  NOTE:  @p xl is required, as we need to lookup values in the string dictionary
+   *
+   *  @param xl - pointer to existing @a libo_xl
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *
+   *  @return string value of @p xlc
+   */
 
-  doc = xmlParseMemory(buf, len);
-  if (!doc)
-  {
-    fprintf(stderr, "Failed to parse '%s'\n", path); fflush(stderr);
-    return;
-  }
-  free(buf);
+char *libo_xl_cell_get_text(libo_xl *xl, libo_xl_cell *xlc)
+{
+  string *str;
+  char *value = NULL;
 
-  sheet->n_rows = count_sheet_rows_in_xml(doc);
-  sheet->n_cols = count_sheet_columns_in_xml(doc);
-  sheet->row = libo_xl_sheet_rows_read(sheet, doc);
+  if (!xl) goto exit;
+  if (!xlc) goto exit;
+  if (xlc->type != libo_xl_cell_type_reference) goto exit;
 
-  xmlFreeDoc(doc);
+  str = strings_find_by_id(xl->strings, xlc->reference);
+  if (str) value = str->text;
 
-  return;
+exit:
+  return value;
 }
 
   /**
-   *  @fn libo_xl_row **libo_xl_sheet_rows_read(libo_xl_sheet *sheet, xmlDocPtr doc)
+   *  @fn void libo_xl_cell_set_text(libo_xl *xl, libo_xl_cell *xlc, char *text)
    *
-   *  @brief builds rows for sheet number @p sheet from @p doc
+   *  @brief sets text value in @p xlc to @p text
    *
-   *  @param sheet = pointer to existing @a libo_xl_sheet, filled with meta data
-   *  @param doc - pointer to existing XML document
+   *  @param xl - pointer to existing @a libo_xl
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param text - new string value for text
    *
-   *  @return pointer to new @a libo_xl_sheet struct
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_xl_row **libo_xl_sheet_rows_read(libo_xl_sheet *sheet, xmlDocPtr doc)
+void libo_xl_cell_set_text(libo_xl *xl, libo_xl_cell *xlc, char *text)
 {
-  int i, j;
-  libo_xl_row **rows = NULL;
-  libo_xl_row *row;
-  libo_xl_cell *cell;
-  xmlXPathContextPtr xpathCtx; 
-  xmlXPathObjectPtr xpathObj; 
-  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'worksheet']/*[local-name() = 'sheetData']/*[local-name() = 'row']";
-  xmlNodeSetPtr nodes;
-  xmlNodePtr node;
-  xmlNodePtr node2;
-  xmlNodePtr node3;
-  int k;
-  int r,c;
-  char *ref;
-
-  if (!sheet) return NULL;
-  if (!doc) return NULL;
-
-  rows = (libo_xl_row **)malloc(sizeof(libo_xl_row *) * sheet->n_rows);
-  if (!rows) return NULL;
-  memset(rows, 0, sizeof(libo_xl_row *) * sheet->n_rows);
-
-  for (i = 0; i < sheet->n_rows; i++)
-  {
-    row = rows[i] = libo_xl_row_new();
+  string *str;
 
-    row->cell = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * sheet->n_cols);
-    if (!row->cell) break;
-    memset(row->cell, 0, sizeof(libo_xl_cell *) * sheet->n_cols);
-    row->n_cells = sheet->n_cols;
+  if (!xl) return;
+  if (!xlc) return;
 
-    for (j = 0; j < sheet->n_cols; j++)
-      row->cell[j] = libo_xl_cell_new();
-  }
+  libo_xl_cell_clear(xlc);
 
-  xpathCtx = xmlXPathNewContext(doc);
-  if(!xpathCtx)
-  {
-    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
-    return 0;
-  }
+  libo_xl_cell_set_type(xlc, libo_xl_cell_type_reference);
 
-  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-  if(!xpathObj)
+  str = strings_find_by_text(xl->strings, text);
+  if (!str)
   {
-      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-      xmlXPathFreeContext(xpathCtx); 
-      return 0;
+    str = string_new_with_values(text, 0);
+    if (str) strings_add(xl->strings, str);
+    str = strings_find_by_text(xl->strings, text);
   }
 
-  nodes = xpathObj->nodesetval;
-  if (nodes)
-  {
-    if (nodes->nodeNr != sheet->n_rows)
-      fprintf(stderr, "Row count does not match XML nodes\n");
-    else
-    {
-      for (i = 0; i < sheet->n_rows; i++)
-      {
-        row = rows[i];
-
-        if (!nodes->nodeTab[i]) continue;
-        node = nodes->nodeTab[i];
-        if (node->type == XML_ELEMENT_NODE)
-        {
-          if (!strcmp((char *)node->name, "row"))
-          {
-            node2 = node->xmlChildrenNode;
-
-            for (j = 0; node2 && (j < sheet->n_cols);)
-            {
-              if (node->type == XML_ELEMENT_NODE)
-              {
-                if (!strcmp((char *)node2->name, "c"))
-                {
-                  ref = (char *)xmlGetProp(node2, (xmlChar *)"r");
-                  cell_ref_to_row_col(ref, &r, &c);
-
-                  while (j < c)
-                  {
-                    cell = row->cell[j];
-                    cell->type = libo_xl_cell_type_expression;
-                    cell->expression.value = strdup((char *)"");
-                    ++j;
-                  }
-
-                  cell = row->cell[j];
-
-                  if (xmlGetProp(node2, (xmlChar *)"t"))
-                    cell->type = string_to_libo_xl_cell_type((char *)xmlGetProp(node2, (xmlChar *)"t"));
-                  else
-                    cell->type = libo_xl_cell_type_number;
-
-                  switch (cell->type)
-                  {
-                    case libo_xl_cell_type_none:
-                      break;
-                    case libo_xl_cell_type_reference:
-                      for (node3 = node2->xmlChildrenNode; node3; node3 = node3->next)
-                      {
-                        if (node3->type == XML_ELEMENT_NODE)
-                        {
-                          if (!strcmp((char *)node3->name, "v"))
-                            cell->reference = atoi((char *)xmlNodeGetContent(node3));
-                        }
-                      }
-                      break;
-                    case libo_xl_cell_type_expression:
-                      for (node3 = node2->xmlChildrenNode; node3; node3 = node3->next)
-                      {
-                        if (node3->type == XML_ELEMENT_NODE)
-                        {
-                          if (!strcmp((char *)node3->name, "f"))
-                            cell->expression.formula = strdup((char *)xmlNodeGetContent(node3));
-                          else if (!strcmp((char *)node3->name, "v"))
-                            cell->expression.value = strdup((char *)xmlNodeGetContent(node3));
-                        }
-                      }
-                      break;
-                    case libo_xl_cell_type_number:
-                      for (node3 = node2->xmlChildrenNode; node3; node3 = node3->next)
-                      {
-                        if (node3->type == XML_ELEMENT_NODE)
-                        {
-                          if (!strcmp((char *)node3->name, "v"))
-                            cell->number = atof((char *)xmlNodeGetContent(node3));
-                        }
-                      }
-                      break;
-                  }
-                }
-                ++k;
-                ++j;
-              }
-              node2 = node2->next;
-            }
-
-            while (j < sheet->n_cols)
-            {
-              cell = row->cell[j];
-              cell->type = libo_xl_cell_type_expression;
-              cell->expression.value = strdup((char *)"");
-              ++j;
-            }
+  if (str) libo_xl_cell_set_reference(xlc, str->id);
+}
 
-          }
-        }
-      }
-    }
-  }
+  /**
+   *  @fn libo_xl_cell_expression *libo_xl_cell_get_expression(libo_xl_cell *xlc)
+   *
+   *  @brief returns cell expression from @p xlc
+   *
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *
+   *  @return pointer to @a libo_xl_cell_expression, NULL if cell type is not an expression
+   */
 
-  xmlXPathFreeObject(xpathObj);
-  xmlXPathFreeContext(xpathCtx); 
+libo_xl_cell_expression *libo_xl_cell_get_expression(libo_xl_cell *xlc)
+{
+  if (!xlc) return NULL;
+  if (xlc->type != libo_xl_cell_type_expression) return NULL;
 
-  return rows;
+  return &xlc->expression;
 }
 
   /**
-   *  @fn void libo_xl_row_dump(libo_xl_row *row, FILE *stream, int indent)
+   *  @fn void libo_xl_cell_set_expression(libo_xl_cell *xlc, libo_xl_cell_expression *xlce)
    *
-   *  @brief dumps contents of @p row to @p stream, default is STDOUT
+   *  @brief sets @p xlc expression values to those in @p xlce
    *
-   *  @param row - pointer to existing @a libo_xl_row struct
-   *  @param stream - open FILE * for writing
-   *  @param indent - number of spaces to indent output
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param xlce - pointer to existing @a libo_xl_cell_expression
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_row_dump(libo_xl_row *row, FILE *stream, int indent)
+void libo_xl_cell_set_expression(libo_xl_cell *xlc, libo_xl_cell_expression *xlce)
 {
-  int i;
+  if (!xlc || !xlce) return;
 
-  if (!row) return;
+  libo_xl_cell_clear(xlc);
 
-  do_indent(stream, indent); fprintf(stream, "Row:\n");
-  indent += 2;
+  libo_xl_cell_set_type(xlc, libo_xl_cell_type_expression);
 
-  do_indent(stream, indent);
-    fprintf(stream, "Cells (%d):\n", row->n_cells);
-  indent += 2;
+  if (xlce->formula) libo_xl_cell_expression_set_formula(&xlc->expression, xlce->formula);
+  if (xlce->value) libo_xl_cell_expression_set_value(&xlc->expression, xlce->value);
+}
 
-  for (i = 0; i < row->n_cells; i++)
-    libo_xl_cell_dump(row->cell[i], stream, indent);
+  /**
+   *  @fn char *libo_xl_cell_expression_get_formula(libo_xl_cell_expression *xlce)
+   *
+   *  @brief returns formula from @p xlce
+   *
+   *  Cells of a sheet sharing a formula hold no text of their own, format
+   *  theirs with @a libo_xl_sheet_format_formula.
+   *
+   *  @param xlce - pointer to existing @a libo_xl_cell_expression
+   *
+   *  @return string containing cell's formula
+   */
 
-  return;
+char *libo_xl_cell_expression_get_formula(libo_xl_cell_expression *xlce)
+{
+  if (!xlce) return NULL;
+
+  return xlce->formula;
 }
 
   /**
-   *  @fn void libo_xl_cell_dump(libo_xl_cell *cell, FILE *stream, int indent)
+   *  @fn void libo_xl_cell_expression_set_formula(libo_xl_cell_expression *xlce, char *formula)
    *
-   *  @brief dumps contents of @p cell to @p stream, default is STDOUT
+   *  @brief sets formula in @p xlce to @p formula
    *
-   *  @param cell - pointer to existing @a libo_xl_cell struct
-   *  @param stream - open FILE * for writing
-   *  @param indent - number of spaces to indent output
+   *  @param xlce - pointer to existing @a libo_xl_cell_expression
+   *  @param formula - string containing new formula
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_cell_dump(libo_xl_cell *cell, FILE *stream, int indent)
+void libo_xl_cell_expression_set_formula(libo_xl_cell_expression *xlce,
+                                         char *formula)
 {
-  string *str;
-
-  if (!cell) return;
-  if (!stream) stream = stdout;
+  char *old_formula = NULL;
 
-  do_indent(stream, indent); fprintf(stream, "Cell:\n");
-  indent += 2;
+  if (!xlce || !formula) return;
 
-  do_indent(stream, indent);
-    fprintf(stream, "Type: %s\n",
-            libo_xl_cell_type_to_string(cell->type));
+  if (xlce->formula) old_formula = xlce->formula;
 
-  do_indent(stream, indent); fprintf(stream, "Contents:\n");
-  indent += 2;
+  xlce->formula = NULL;
 
-  switch (cell->type)
-  {
-    case libo_xl_cell_type_none:
-      do_indent(stream, indent); fprintf(stream, "[NONE]\n");
-      break;
-    case libo_xl_cell_type_reference:
-      do_indent(stream, indent);
-        fprintf(stream, "Reference: %d\n", cell->reference);
-      do_indent(stream, indent);
-        str = strings_find_by_id(__xl__->strings, cell->reference);
-        fprintf(stream, "String: %s\n", str ? str->text : "");
-      break;
-    case libo_xl_cell_type_expression:
-      do_indent(stream, indent); fprintf(stream, "Expression:\n");
-      indent += 2;
-      do_indent(stream, indent);
-        fprintf(stream, "Formula: %s\n", cell->expression.formula);
-      do_indent(stream, indent);
-        fprintf(stream, "Value: %s\n", cell->expression.value);
-      break;
-    case libo_xl_cell_type_number:
-      do_indent(stream, indent);
-        fprintf(stream, "Number: %f\n", cell->number);
-      break;
-  }
+  xlce->formula = strdup(formula);
 
-  return;
+  if (old_formula) free(old_formula);
 }
 
   /**
-   *  @fn char *libo_xl_cell_type_to_string(libo_xl_cell_type ct)
+   *  @fn char *libo_xl_cell_expression_get_value(libo_xl_cell_expression *xlce)
    *
-   *  @brief returns string representation of @p ct
+   *  @brief returns value from @p xlce
    *
-   *  @param ct - @a libo_xl_cell_type
+   *  @param xlce - pointer to existing @a libo_xl_cell_expression
    *
-   *  @return string representation of @p ct
+   *  @return string containing cell's calculated value
    */
 
-char *libo_xl_cell_type_to_string(libo_xl_cell_type ct)
+char *libo_xl_cell_expression_get_value(libo_xl_cell_expression *xlce)
 {
-  switch (ct)
-  {
-    case libo_xl_cell_type_none: return "[UNKNOWN]";
-    case libo_xl_cell_type_reference: return "REFERENCE";
-    case libo_xl_cell_type_expression: return "EXPRESSION";
-    case libo_xl_cell_type_number: return "NUMBER";
-  }
+  if (!xlce) return NULL;
 
-  return "[UNKNOWN]";
+  return xlce->value;
 }
 
   /**
-   *  @fn libo_xl_column *libo_xl_column_new(void)
+   *  @fn void libo_xl_cell_expression_set_value(libo_xl_cell_expression *xlce,
+   *                                             char *value)
    *
-   *  @brief creates a new @a libo_xl_column struct
+   *  @brief sets value in @p xlce to @p value
    *
-   *  @par Parameters
-   *  None.
+   *  @param xlce - pointer to existing @a libo_xl_cell_expression
+   *  @param value - string containing new value
    *
-   *  @return pointer to new @a libo_xl_column struct
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_xl_column *libo_xl_column_new(void)
+void libo_xl_cell_expression_set_value(libo_xl_cell_expression *xlce,
+                                       char *value)
 {
-  libo_xl_column *c = malloc(sizeof(libo_xl_column));
-  if (c) memset(c, 0, sizeof(libo_xl_column));
+  char *old_value = NULL;
 
-  return c;
+  if (!xlce || !value) return;
+
+  if (xlce->value) old_value = xlce->value;
+  xlce->value = NULL;
+
+  if (value) xlce->value = strdup(value);
+
+  if (old_value) free(old_value);
 }
 
   /**
-   *  @fn libo_xl_column *libo_xl_column_new_with_values(float width, int autowidth)
+   *  @fn double libo_xl_cell_get_number(libo_xl_cell *xlc)
    *
-   *  @brief creates a new @a libo_xl_column struct with values filled
+   *  @brief returns direct value from @p xlc
    *
-   *  @param width - specific width of column
-   *  @param autowidth - flag, 1 to auto-caculate column width, 0 to use specific width
+   *  @param xlc - pointer to existing @a libo_xl_cell
    *
-   *  @return pointer to new @a libo_xl_column struct
+   *  @return direct numeric value of @p xlc
    */
 
-libo_xl_column *libo_xl_column_new_with_values(float width, int autowidth)
+double libo_xl_cell_get_number(libo_xl_cell *xlc)
 {
-  libo_xl_column *c = libo_xl_column_new();
-  if (c)
-  {
-    c->width = width;
-    c->autowidth = autowidth;
-  }
+  if (!cell_is_number(xlc)) return 0;
 
-  return c;
+  return xlc->number;
 }
 
   /**
-   *  @fn void libo_xl_column_free(libo_xl_column *column)
+   *  @fn void libo_xl_cell_set_number(libo_xl_cell *xlc, double number)
    *
-   *  @brief frees all memory allocated to @p column
+   *  @brief sets number value in @p xlc to @p number
    *
-   *  @param column - pointer to existing @a libo_xl_column struct
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param number - new number value
    *
    *  @par Returns
    *  Nothing.
    */
 
-void libo_xl_column_free(libo_xl_column *column) { if (column) free(column); }
+void libo_xl_cell_set_number(libo_xl_cell *xlc, double number)
+{
+  if (!xlc) return;
+
+  libo_xl_cell_clear(xlc);
+
+  libo_xl_cell_set_type(xlc, libo_xl_cell_type_number);
+
+  xlc->number = number;
+}
 
   /**
-   *  @fn libo_xl_filter *libo_xl_filter_new(void)
+   *  @fn int libo_xl_cell_get_boolean(libo_xl_cell *xlc)
    *
-   *  @brief returns new @a libo_xl_filter struct
+   *  @brief returns boolean value from @p xlc
    *
-   *  @par Parameters
-   *  None.
+   *  @param xlc - pointer to existing @a libo_xl_cell
    *
-   *  @return pointer to new @a libo_xl_filter struct
+   *  @return 1 if @p xlc is TRUE, 0 if FALSE or not a boolean
    */
 
-libo_xl_filter *libo_xl_filter_new(void)
+int libo_xl_cell_get_boolean(libo_xl_cell *xlc)
 {
-  libo_xl_filter *filter;
-
-  filter = (libo_xl_filter *)malloc(sizeof(libo_xl_filter));
-  if (filter) memset(filter, 0, sizeof(libo_xl_filter));
+  if (!xlc) return 0;
+  if (xlc->type != libo_xl_cell_type_boolean) return 0;
 
-  return filter;
+  return xlc->boolean;
 }
 
   /**
-   *  @fn libo_xl_filter *libo_xl_filter_new_with_values(
-   *                         unsigned int first_column,
-   *                         unsigned int last_column)
+   *  @fn void libo_xl_cell_set_boolean(libo_xl_cell *xlc, int boolean)
    *
-   *  @brief returns new @a libo_xl_filter struct
+   *  @brief sets boolean value in @p xlc to @p boolean
    *
-   *  @param first_column - first column that defines filter
-   *  @param last_column - last column that defines filter
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param boolean - non zero for TRUE, 0 for FALSE
    *
-   *  @return pointer to new @a libo_xl_filter struct
+   *  @par Returns
+   *  Nothing.
    */
 
-libo_xl_filter *libo_xl_filter_new_with_values(unsigned int first_column,
-                                               unsigned int last_column)
+void libo_xl_cell_set_boolean(libo_xl_cell *xlc, int boolean)
 {
-  libo_xl_filter *filter;
+  if (!xlc) return;
 
-  filter = libo_xl_filter_new();
-  if (filter)
-  {
-    filter->first_column = first_column;
-    filter->last_column = last_column;
-  }
+  libo_xl_cell_clear(xlc);
 
-  return filter;
+  libo_xl_cell_set_type(xlc, libo_xl_cell_type_boolean);
+
+  xlc->boolean = boolean != 0;
 }
 
   /**
-   *  @fn void libo_xl_filter_free(libo_xl_filter *filter)
+   *  @fn libo_xl_error libo_xl_cell_get_error(libo_xl_cell *xlc)
    *
-   *  @brief frees all memory allocated to @p filter
+   *  @brief returns error value from @p xlc
    *
-   *  @param filter - pointer to existing @a libo_xl_filter struct
+   *  @param xlc - pointer to existing @a libo_xl_cell
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return @a libo_xl_error, libo_xl_error_none if @p xlc is not an error
    */
 
-void libo_xl_filter_free(libo_xl_filter *filter)
+libo_xl_error libo_xl_cell_get_error(libo_xl_cell *xlc)
 {
-  if (!filter) return;
+  if (!xlc) return libo_xl_error_none;
+  if (xlc->type != libo_xl_cell_type_error) return libo_xl_error_none;
 
-  free(filter);
+  return xlc->error;
 }
 
- // INTERNALS
-
   /**
-   *  @fn static void cell_ref_to_row_col(char *ref, int *row, int *col)
+   *  @fn void libo_xl_cell_set_error(libo_xl_cell *xlc, libo_xl_error error)
    *
-   *  @brief converts string cell reference to row and column
+   *  @brief sets error value in @p xlc to @p error
    *
-   *  @p ref is in form "A1", or "YX120"
+   *  Setting libo_xl_error_none leaves @p xlc empty.
    *
-   *  @param ref - string cell reference
-   *  @param row - pointer to integer to store extracted row
-   *  @param col - pointer to integer to store extracted col
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param error - new error value
    *
    *  @par Returns
    *  Nothing.
    */
 
-static void cell_ref_to_row_col(char *ref, int *row, int *col)
+void libo_xl_cell_set_error(libo_xl_cell *xlc, libo_xl_error error)
 {
-  char *p;
-  int c;
-  int i;
-  int prod;
-  int mag = 0;
-
-  *row = *col = 0;
-
-  if (!ref || !row || !col) return;
-
-  p = ref;
-  while (isalpha(*p)) ++p;
-  *row = atoi(p) - 1;
+  if (!xlc) return;
 
-  --p;
+  libo_xl_cell_clear(xlc);
 
-  while (p >= ref)
+  if (error == libo_xl_error_none)
   {
-    c = (*p - 'A' + 1);
-    for (prod = 1, i = 0; i < mag; i++)
-      prod *= 26;
-    *col += c * prod;
-    ++mag;
-    --p;
+    libo_xl_cell_set_type(xlc, libo_xl_cell_type_empty);
+    return;
   }
 
-  *col -= 1;
+  libo_xl_cell_set_type(xlc, libo_xl_cell_type_error);
 
-  return;
+  xlc->error = error;
 }
 
   /**
-   *  @fn static int is_office(libo *l)
+   *  @fn double libo_xl_cell_get_date(libo_xl_cell *xlc, int date1904)
    *
-   *  @brief determines if contents of @p l is legitimate Office document
+   *  @brief returns date of @p xlc as seconds since the epoch
    *
-   *  @param l - pointer to existing @a libo struct, with ZIP contents
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param date1904 - date system of the workbook, see
+   *                    @a libo_xl_book_get_date1904
    *
-   *  @return 1 if Office document, 0 for anything else
+   *  @return seconds since 1970-01-01 00:00:00 UTC, 0 if @p xlc is not
+   *          a date, or holds a serial outside the dates Excel shows
    */
 
-static int is_office(libo *l)
+double libo_xl_cell_get_date(libo_xl_cell *xlc, int date1904)
 {
-  zip_int64_t n_entries;
-  int i;
-  char *name;
-  int have_core = 0;
-  int have_app = 0;
+  double seconds;
 
-  if (!l) return 0;
-  if (!l->z) return 0;
+  if (!xlc) return 0;
+  if (xlc->type != libo_xl_cell_type_date) return 0;
 
-  n_entries = zip_get_num_entries(l->z, 0);
+  if (libo_xl_serial_to_epoch(xlc->number, date1904, &seconds)) return 0;
 
-  for (i = 0; i < n_entries; i++)
-  {
-    name = (char *)zip_get_name(l->z, i, 0);
-    if (!strcmp(name, "docProps/core.xml")) have_core = 1;
-    if (!strcmp(name, "docProps/app.xml")) have_app = 1;
+  return seconds;
+}
 
-    if (have_core && have_app) return 1;
-  }
+  /**
+   *  @fn int libo_xl_cell_set_date(libo_xl_cell *xlc,
+   *                                 double seconds,
+   *                                 int date1904)
+   *
+   *  @brief sets @p xlc to the date @p seconds since the epoch
+   *
+   *  The cell keeps its format, which should show a date for the cell to
+   *  read back as one.
+   *
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param seconds - seconds since 1970-01-01 00:00:00 UTC
+   *  @param date1904 - date system of the workbook, see
+   *                    @a libo_xl_book_get_date1904
+   *
+   *  @return 0 on success, -1 if @p seconds is outside the dates Excel
+   *          shows, leaving @p xlc as it was
+   */
+
+int libo_xl_cell_set_date(libo_xl_cell *xlc, double seconds, int date1904)
+{
+  double serial;
+
+  if (!xlc) return -1;
+
+  if (libo_xl_epoch_to_serial(seconds, date1904, &serial)) return -1;
+
+  libo_xl_cell_clear(xlc);
+
+  libo_xl_cell_set_type(xlc, libo_xl_cell_type_date);
+
+  xlc->number = serial;
 
   return 0;
 }
 
   /**
-   *  @fn static void do_indent(FILE *stream, int indent)
+   *  @fn int libo_xl_cell_get_style(libo_xl_cell *xlc)
    *
-   *  @brief emits @p indent spaces to @p stream
+   *  @brief returns index of cell format of @p xlc
    *
-   *  @param stream - open FILE * for writing
-   *  @param indent - number of spaces to output
+   *  @param xlc - pointer to existing @a libo_xl_cell
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return index of cell format in style sheet, 0 for the default
    */
 
-static void do_indent(FILE *stream, int indent)
+int libo_xl_cell_get_style(libo_xl_cell *xlc)
 {
-  int i;
+  if (!xlc) return 0;
 
-  if (!stream) return;
+  return xlc->style;
+}
 
-  for (i = 0; i < indent; i++) fputc(' ', stream);
+  /**
+   *  @fn void libo_xl_cell_set_style(libo_xl_cell *xlc, int style)
+   *
+   *  @brief sets cell format of @p xlc to @p style, leaving its value
+   *
+   *  @param xlc - pointer to existing @a libo_xl_cell
+   *  @param style - index of cell format, see @a libo_xl_styles_add_style
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-  return;
+void libo_xl_cell_set_style(libo_xl_cell *xlc, int style)
+{
+  if (!xlc) return;
+  if ((style < 0) || (style >= LIBO_XL_STYLES_MAX)) return;
+
+  xlc->style = (unsigned short)style;
 }
 
   /**
-   *  @fn static int is_supported(libo *l)
+   *  @fn libo_doc *libo_get_doc(libo *l)
    *
-   *  @brief determines if this Office document is currently implemented
+   *  @brief returns Word document from @p l
    *
-   *  @param l - pointer to existing @a libo struct, with ZIP contents
+   *  @param l - pointer to existing @a libo
    *
-   *  @return 1 implemented, 0 otherwise
+   *  @return pointer to @a libo_doc, NULL if document type is not a Word document
    */
 
-static int is_supported(libo *l)
+libo_doc *libo_get_doc(libo *l)
 {
-  if (!l) return 0;
-
-  switch (l->type)
-  {
-    case libo_type_xl:
-      return 1;
+  if (!l) return NULL;
 
-    case libo_type_none:
-    case libo_type_doc:
-    case libo_type_pp:
-    default:
-      return 0;
-  }
+  if (l->type == libo_type_doc) return l->doc;
 
-  return 0;
+  return NULL;
 }
 
   /**
-   *  @fn static libo_type get_type(libo *l)
+   *  @fn libo_pp *libo_get_pp(libo *l)
    *
-   *  @brief returns Office document type from @p l
+   *  @brief returns PowerPoint document from @p l
    *
-   *  @param l - pointer to existing @a libo struct, with ZIP contents
+   *  @param l - pointer to existing @a libo
    *
-   *  @return @a libo_type of document
+   *  @return pointer to @a libo_pp, NULL if document type is not a PowerPoint document
    */
 
-static libo_type get_type(libo *l)
+libo_pp *libo_get_pp(libo *l)
 {
-  zip_file_t *zf;
-  int len;
-  char *buf;
-  char *app_file_name = "docProps/app.xml";
-  zip_stat_t stat;
-  xmlDocPtr doc = NULL;
-  libo_type type = libo_type_none;
+  if (!l) return NULL;
 
-  if (!l) return libo_type_none;
+  if (l->type == libo_type_pp) return l->pp;
 
-    // open docProps/app.xml
+  return NULL;
+}
 
-  if (zip_stat(l->z, app_file_name, 0, &stat)) return libo_type_none;
-  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return libo_type_none;
+  /**
+   *  @fn libo_xl *libo_xl_new(void)
+   *
+   *  @brief creates a new @a libo_xl struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to @a libo_xl
+   */
 
-  if (strcmp(app_file_name, stat.name)) return libo_type_none;
+libo_xl *libo_xl_new(void)
+{
+  libo_xl *xl;
 
-  len = stat.size;
+  xl = (libo_xl *)malloc(sizeof(libo_xl));
+  if (!xl) return NULL;
+  memset(xl, 0, sizeof(libo_xl));
 
-  zf = zip_fopen(l->z, app_file_name, 0);
-  if (!zf)
-  {
-    fprintf(stderr, "Can not open '%s'\n", app_file_name); fflush(stderr);
-    return libo_type_none;
-  }
+  xl->book = libo_xl_book_new();
+  xl->strings = strings_new();
 
-  buf = (char *)malloc(len+1);
-  if (!buf)
-  {
-    zip_fclose(zf);
-    return libo_type_none;
-  }
-  memset(buf, 0, len+1);
+  return xl;
+}
 
-  zip_fread(zf, buf, len);
+  /**
+   *  @fn libo_xl *libo_xl_dup(libo_xl *xl)
+   *
+   *  @brief creates a deep copy of @p xl
+   *
+   *  @param xl - pointer to existing @a libo_xlstruct
+   *
+   *  @return pointer to new @a libo_xl struct
+   */
 
-  zip_fclose(zf);
+libo_xl *libo_xl_dup(libo_xl *xl)
+{
+  libo_xl *nxl = NULL;
 
-  doc = xmlParseMemory(buf, len);
-  if (!doc)
-  {
-    fprintf(stderr, "Failed to parse app.xml\n"); fflush(stderr);
-    return libo_type_none;
-  }
-  free(buf);
+  if (!xl) goto exit;
 
-    // find entry for document type
+  nxl = libo_xl_new();
+  if (!nxl) goto exit;
 
-  buf = find_app_type_name_in_xml(doc);
+  if (xl->book) nxl->book = libo_xl_book_dup(xl->book);
+  if (xl->strings) nxl->strings = strings_dup(xl->strings);
+  if (xl->styles) nxl->styles = styles_dup(xl->styles);
 
-  xmlFreeDoc(doc);
+exit:
+  return nxl;
+}
 
-  if (!buf) return libo_type_none;
+  /**
+   *  @fn void libo_xl_free(libo_xl *xl)
+   *
+   *  @brief frees all memory allocated to @p xl
+   *
+   *  @param xl - pointer to existing @a libo_xl struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-    // convert to libo_type
+void libo_xl_free(libo_xl *xl)
+{
+  if (!xl) return;
 
-  if (!strcmp(buf, "Microsoft Excel")) type = libo_type_xl;
+  if (xl->book) libo_xl_book_free(xl->book);
+  if (xl->strings) strings_free(xl->strings);
+  if (xl->styles) libo_xl_styles_free(xl->styles);
 
-  free(buf);
+  free(xl);
 
-  return type;
+  return;
 }
 
   /**
-   *  @fn static char *find_app_type_name_in_xml(xmlDocPtr doc)
+   *  @fn size_t libo_xl_memory_size(libo_xl *xl)
    *
-   *  @brief locates application type name in XML document
+   *  @brief returns number of bytes of memory used by @p xl
    *
-   *  @param doc - pointer to XML document
+   *  @param xl - pointer to existing @a libo_xl struct
    *
-   *  @return string containing application type name
+   *  @return approximate number of bytes allocated to @p xl
    */
 
-static char *find_app_type_name_in_xml(xmlDocPtr doc)
+size_t libo_xl_memory_size(libo_xl *xl)
 {
-  xmlXPathContextPtr xpathCtx; 
-  xmlXPathObjectPtr xpathObj; 
-  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'Properties']/*[local-name() = 'Application']";
-  xmlNodeSetPtr nodes;
-  xmlNodePtr node;
-  char *app_type_name = NULL;
-
-  if (!doc) return NULL;
+  size_t bytes;
+  string *str;
+  unsigned int i;
 
-  xpathCtx = xmlXPathNewContext(doc);
-  if(!xpathCtx)
-  {
-    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
-    return NULL;
-  }
+  if (!xl) return 0;
 
-  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-  if(!xpathObj)
-  {
-      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-      xmlXPathFreeContext(xpathCtx); 
-      return NULL;
-  }
+  bytes = sizeof(libo_xl);
+  bytes += libo_xl_book_memory_size(xl->book);
 
-  nodes = xpathObj->nodesetval;
-  if (nodes)
+  if (xl->strings)
   {
-    for (int i = 0; i < nodes->nodeNr; i++)
+    bytes += sizeof(strings);
+    for (i = 0; i < xl->strings->last_id; i++)
     {
-      if (!nodes->nodeTab[i]) continue;
-      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
-      {
-        node = nodes->nodeTab[i];
-        app_type_name = (char *)xmlNodeListGetString(doc, node->xmlChildrenNode, 1);
-        break;
-      }
+      str = strings_find_by_id(xl->strings, i);
+      if (!str) continue;
+      bytes += sizeof(string_node);
+      if (str->text) bytes += strlen(str->text) + 1;
     }
   }
 
-  xmlXPathFreeObject(xpathObj);
-  xmlXPathFreeContext(xpathCtx); 
+  bytes += libo_xl_styles_memory_size(xl->styles);
 
-  return app_type_name;
+  return bytes;
 }
 
   /**
-   *  @fn static int count_sheets_in_xml(xmlDocPtr doc)
+   *  @fn void libo_xl_sheet_set_default_row_height(libo_xl_sheet *sheet,
+   *                                                double default_row_height)
    *
-   *  @brief returns number of work sheets in XML document
+   *  @brief sets default row height of @p sheet
    *
-   *  @param doc - pointer to XML document
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param default_row_height
    *
-   *  @return count of work sheets
+   *  @par Returns
+   *  Nothing.
    */
 
-static int count_sheets_in_xml(xmlDocPtr doc)
+void libo_xl_sheet_set_default_row_height(libo_xl_sheet *sheet,
+                                          double default_row_height)
 {
-  xmlXPathContextPtr xpathCtx; 
-  xmlXPathObjectPtr xpathObj; 
-  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'workbook']/*[local-name() = 'sheets']";
-  xmlNodeSetPtr nodes;
-  xmlNodePtr node;
-  int count = 0;
+  if (!sheet) return;
 
-  if (!doc) return 0;
+  sheet->default_row_height = default_row_height;
+}
 
-  xpathCtx = xmlXPathNewContext(doc);
-  if(!xpathCtx)
-  {
-    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
-    return 0;
-  }
-
-  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-  if(!xpathObj)
-  {
-      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-      xmlXPathFreeContext(xpathCtx); 
-      return 0;
-  }
-
-  nodes = xpathObj->nodesetval;
-  if (nodes)
-  {
-    for (int i = 0; i < nodes->nodeNr; i++)
-    {
-      if (!nodes->nodeTab[i]) continue;
-      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
-      {
-        node = nodes->nodeTab[i];
-        if (!strcmp((char *)node->name, "sheets"))
-        {
-          count = xmlChildElementCount(node);
-          break;
-        }
-      }
-    }
-  }
+  /**
+   *  @fn libo_xl_freeze *libo_xl_sheet_get_freeze(libo_xl_sheet *sheet)
+   *
+   *  @brief gets row/column freeze from @p sheet, if any
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return pointer to @a libo_xl_freeze struct, or NULL if none.
+   */
 
-  xmlXPathFreeObject(xpathObj);
-  xmlXPathFreeContext(xpathCtx); 
+libo_xl_freeze *libo_xl_sheet_get_freeze(libo_xl_sheet *sheet)
+{
+  if (!sheet) return NULL;
 
-  return count;
+  return &(sheet->freeze);
 }
 
   /**
-   *  @fn static int count_sheet_rows_in_xml(xmlDocPtr doc)
+   *  @fn void libo_xl_sheet_set_freeze(libo_xl_sheet *sheet,
+   *                                    libo_xl_freeze_type type,
+   *                                    int n)
    *
-   *  @brief returns number of work sheet rows in XML document
+   *  @brief sets row/column freeze for @p sheet
    *
-   *  @param doc - pointer to XML document
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param type - @a libo_xl_freeze_type (top or left)
+   *  @param n - number of rows or columns to freeze
    *
-   *  @return count of rows
+   *  @par Returns
+   *  Nothing.
    */
 
-static int count_sheet_rows_in_xml(xmlDocPtr doc)
+void libo_xl_sheet_set_freeze(libo_xl_sheet *sheet,
+                              libo_xl_freeze_type type,
+                              int n)
 {
-  xmlXPathContextPtr xpathCtx; 
-  xmlXPathObjectPtr xpathObj; 
-  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'worksheet']/*[local-name() = 'sheetData']";
-  xmlNodeSetPtr nodes;
-  xmlNodePtr node;
-  int count = 0;
-
-  if (!doc) return 0;
-
-  xpathCtx = xmlXPathNewContext(doc);
-  if(!xpathCtx)
-  {
-    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
-    return 0;
-  }
+  if (!sheet) return;
 
-  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-  if(!xpathObj)
-  {
-      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-      xmlXPathFreeContext(xpathCtx); 
-      return 0;
-  }
+  sheet->freeze.type = type;
+  sheet->freeze.n = n;
+}
 
-  nodes = xpathObj->nodesetval;
-  if (nodes)
-  {
-    for (int i = 0; i < nodes->nodeNr; i++)
-    {
-      if (!nodes->nodeTab[i]) continue;
-      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
-      {
-        node = nodes->nodeTab[i];
-        if (!strcmp((char *)node->name, "sheetData"))
-        {
-          count = xmlChildElementCount(node);
-          break;
-        }
-      }
-    }
-  }
+  /**
+   *  @fn void libo_xl_sheet_add_filter(libo_xl_sheet *sheet,
+   *                                    unsigned int first_column,
+   *                                    unsigned int last_column)
+   *
+   *  @brief adds columns filter to XL worksheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param first_column
+   *  @param last_column
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-  xmlXPathFreeObject(xpathObj);
-  xmlXPathFreeContext(xpathCtx); 
+void libo_xl_sheet_add_filter(libo_xl_sheet *sheet,
+                              unsigned int first_column,
+                              unsigned int last_column)
+{
+  if (!sheet) return;
 
-  return count;
+  if (sheet->filter) libo_xl_filter_free(sheet->filter);
+  sheet->filter = libo_xl_filter_new_with_values(first_column, last_column);
 }
 
   /**
-   *  @fn static int count_sheet_columns_in_xml(xmlDocPtr doc)
+   *  @fn void libo_xl_sheet_remove_filter(libo_xl_sheet *sheet)
    *
-   *  @brief returns number of work sheet columns in XML document
+   *  @brief removes filter from XL worksheet
    *
-   *  @param doc - pointer to XML document
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
    *
-   *  @return count of columns
+   *  @par Returns
+   *  Nothing.
    */
 
-static int count_sheet_columns_in_xml(xmlDocPtr doc)
+void libo_xl_sheet_remove_filter(libo_xl_sheet *sheet)
 {
-  xmlXPathContextPtr xpathCtx; 
-  xmlXPathObjectPtr xpathObj; 
-  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'worksheet']/*[local-name() = 'sheetData']/*[local-name() = 'row']";
-  xmlNodeSetPtr nodes;
-  xmlNodePtr node;
-  int count = 0;
-  char *spans;
-  char *p;
+  if (!sheet) return;
 
-  if (!doc) return 0;
+  libo_xl_filter_free(sheet->filter);
+  sheet->filter = NULL;
+}
 
-  xpathCtx = xmlXPathNewContext(doc);
-  if(!xpathCtx)
-  {
-    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
-    return 0;
-  }
+  /**
+   *  @fn int libo_xl_sheet_sort(libo_xl *xl,
+   *                             libo_xl_sheet *sheet,
+   *                             int first_row,
+   *                             libo_xl_sort_key *keys,
+   *                             int n_keys)
+   *
+   *  @brief sorts rows of @p sheet from @p first_row on by columns of
+   *         @p keys
+   *
+   *  Rows are ordered as Excel sorts them: numbers before text, text
+   *  ignoring case, then formulas by their value, and empty cells last in
+   *  either direction.  Rows equal in all keys keep their order.  Text is
+   *  compared by rank of its shared string, so no strings are compared
+   *  while sorting; without @p xl it is left in place among itself.
+   *
+   *  A sheet on disk, compressed or columnar is moved back into memory,
+   *  and its shared formulas are expanded, see
+   *  @a libo_xl_sheet_expand_formulas.  The sort is kept with @p sheet,
+   *  and written as its sort state.
+   *
+   *  @param xl - pointer to existing @a libo_xl struct owning the sheet, or
+   *              NULL
+   *  @param sheet - pointer to resident @a libo_xl_sheet struct
+   *  @param first_row - index of first row to sort, rows before it, such as
+   *                     headings, stay in place
+   *  @param keys - array of @a libo_xl_sort_key, most significant first
+   *  @param n_keys - number of keys
+   *
+   *  @return 0 on success, -1 on failure
+   */
 
-  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-  if(!xpathObj)
-  {
-      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-      xmlXPathFreeContext(xpathCtx); 
-      return 0;
-  }
+int libo_xl_sheet_sort(libo_xl *xl,
+                       libo_xl_sheet *sheet,
+                       int first_row,
+                       libo_xl_sort_key *keys,
+                       int n_keys)
+{
+  sort_context ctx;
+  libo_xl_sort *sort = NULL;
+  libo_xl_row **rows = NULL;
+  int *perm = NULL;
+  int n_strings = 0;
+  int *rank = NULL;
+  int n;
+  int i, k;
+  int rc = -1;
 
-  nodes = xpathObj->nodesetval;
-  if (nodes)
+  if (!sheet || !keys || (n_keys < 1) || (first_row < 0)) return -1;
+  if (sheet->state != libo_xl_sheet_state_resident) return -1;
+
+  for (k = 0; k < n_keys; k++)
+    if (keys[k].col < 0) return -1;
+
+  if (sheet->store && libo_xl_sheet_set_storage(sheet, libo_xl_storage_memory))
+    return -1;
+
+    // shared formulas hold only at the rows they were read at
+
+  if (libo_xl_sheet_expand_formulas(sheet) < 0) return -1;
+
+  sort = libo_xl_sort_new_with_values(first_row, keys, n_keys);
+  if (!sort) return -1;
+
+  n = (first_row < sheet->n_rows) ? sheet->n_rows - first_row : 0;
+
+  memset(&ctx, 0, sizeof(sort_context));
+  ctx.n_keys = n_keys;
+  ctx.key = keys;
+  ctx.row = sheet->row ? sheet->row + first_row : NULL;
+  ctx.entry = (sorted_entry *)malloc(sizeof(sorted_entry) * n_keys * (size_t)(n ? n : 1));
+  if (!ctx.entry) goto bail;
+
+  if (xl && xl->strings)
   {
-    for (int i = 0; i < nodes->nodeNr; i++)
-    {
-      if (!nodes->nodeTab[i]) continue;
-      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
-      {
-        node = nodes->nodeTab[i];
-        if (!strcmp((char *)node->name, "row"))
-        {
-          spans = (char *)xmlGetProp(node, (xmlChar *)"spans");
-          if (spans)
-          {
-            p = strchr(spans, ':');
-            if (p)
-            {
-              ++p;
-              count = atoi(p);
-            }
-          }
-          break;
-        }
-      }
-    }
+    rank = libo_xl_strings_rank(xl, &n_strings, NULL, NULL);
+    if (!rank) goto bail;
   }
 
-  xmlXPathFreeObject(xpathObj);
-  xmlXPathFreeContext(xpathCtx); 
+    // each key is turned into a number once, so comparisons are cheap,
+    // and keys of a row are kept together, so they share a cache line
 
-  return count;
+  for (i = 0; i < n; i++)
+    for (k = 0; k < n_keys; k++)
+      sort_cell_key(libo_xl_row_get_cell(ctx.row[i], keys[k].col),
+                    rank, n_strings, &ctx.entry[(size_t)i * n_keys + k]);
+
+  perm = (int *)malloc(sizeof(int) * (n ? n : 1));
+  rows = (libo_xl_row **)malloc(sizeof(libo_xl_row *) * (n ? n : 1));
+  if (!perm || !rows) goto bail;
+
+  for (i = 0; i < n; i++)
+    perm[i] = i;
+
+  if (parallel_sort(perm, n, sort_rows_compare, &ctx)) goto bail;
+
+  for (i = 0; i < n; i++)
+    rows[i] = ctx.row[perm[i]];
+  if (n) memcpy(ctx.row, rows, sizeof(libo_xl_row *) * n);
+
+  libo_xl_sort_free(sheet->sort);
+  sheet->sort = sort;
+  sort = NULL;
+
+  ++sheet->version;
+  sheet->dirty = 1;
+
+  rc = 0;
+
+bail:
+  free(ctx.entry);
+  free(rank);
+  free(perm);
+  free(rows);
+  libo_xl_sort_free(sort);
+
+  return rc;
 }
 
   /**
-   *  @fn static libo_xl_cell_type string_to_libo_xl_cell_type(char *s)
+   *  @fn libo_xl_sort *libo_xl_sheet_get_sort(libo_xl_sheet *sheet)
    *
-   *  @brief converts string representation of cell type to @a libo_xl_cell_type
+   *  @brief returns last sort applied to @p sheet
    *
-   *  @param s - string representation of cell type
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
    *
-   *  @return @a libo_xl_cell_type
+   *  @return pointer to @a libo_xl_sort struct, NULL if none
    */
 
-static libo_xl_cell_type string_to_libo_xl_cell_type(char *s)
+libo_xl_sort *libo_xl_sheet_get_sort(libo_xl_sheet *sheet)
 {
-  if (!s) return libo_xl_cell_type_none;
-
-  if (!strcmp(s, "s")) return libo_xl_cell_type_reference;
-  if (!strcmp(s, "e")) return libo_xl_cell_type_expression;
+  if (!sheet) return NULL;
 
-  return libo_xl_cell_type_none;
+  return sheet->sort;
 }
 
   /**
-   *  @fn static int libo_xl_write(libo *l)
+   *  @fn void libo_xl_sheet_remove_sort(libo_xl_sheet *sheet)
    *
-   *  @brief writes XL document to file
+   *  @brief forgets sort of @p sheet, so no sort state is written
    *
-   *  @param l - pointer to existing @a libo struct
+   *  The order of rows is not changed.
    *
-   *  @return 0 on success, STDIO error on failure
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @par Returns
+   *  Nothing.
    */
 
-static int libo_xl_write(libo *l)
+void libo_xl_sheet_remove_sort(libo_xl_sheet *sheet)
 {
-  int success = -1;
+  if (!sheet) return;
 
-    // create required directories in zip file
+  libo_xl_sort_free(sheet->sort);
+  sheet->sort = NULL;
+}
 
-  if (!l) goto bail;
-  if (!l->z) goto bail;
+  /**
+   *  @fn void libo_xl_sheet_show_all(libo_xl_sheet *sheet)
+   *
+   *  @brief shows rows of @p sheet hidden by libo_xl_view_apply()
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-/*
-  if ((zip_dir_add(l->z, "_rels", 0)) < 0) goto bail;
-  if ((zip_dir_add(l->z, "docProps", 0)) < 0) goto bail;
-  if ((zip_dir_add(l->z, "xl", 0)) < 0) goto bail;
-  if ((zip_dir_add(l->z, "xl/_rels", 0)) < 0) goto bail;
-  if ((zip_dir_add(l->z, "xl/theme", 0)) < 0) goto bail;
-  if ((zip_dir_add(l->z, "xl/worksheets", 0)) < 0) goto bail;
-*/
-
-  libo_xl_content_types_write(l);
-  libo_xl_docprops_write(l);
-  libo_xl__rels_dot_rels_write(l);
-  libo_xl_xl_rels_write(l);
-  libo_xl_themes_write(l);
-  libo_xl_styles_write(l);
-  libo_xl_workbook_write(l);
-  libo_xl_sheets_write(l);
-  libo_xl_shared_strings_write(l);
-
-  success = 0;
+void libo_xl_sheet_show_all(libo_xl_sheet *sheet)
+{
+  if (!sheet) return;
 
-bail:
-  return success;
+  libo_xl_view_free(sheet->visible);
+  sheet->visible = NULL;
 }
 
-#include "libo-xl-theme.c"
-
   /**
-   *  @fn int libo_xl_themes_write(libo *l)
+   *  @fn size_t libo_xl_sheet_format_formula(libo_xl_sheet *sheet,
+   *                                          int row,
+   *                                          int col,
+   *                                          char *buffer,
+   *                                          size_t size)
    *
-   *  @brief writes XL themes to document file
+   *  @brief formats formula of cell at @p row and @p col of @p sheet into
+   *         @p buffer
    *
-   *  @param l - pointer to existing @a libo document
+   *  Cells sharing a formula without text of their own have their formula
+   *  made from the shared formula of @p sheet.  The formula is truncated to
+   *  fit @p size bytes including the terminator, as by snprintf().
    *
-   *  @return 0 on success, -1 on failure
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param row - index of row
+   *  @param col - index of column
+   *  @param buffer - buffer to receive formula, or NULL
+   *  @param size - size of @p buffer in bytes
+   *
+   *  @return length of whole formula, 0 if the cell has none
    */
 
-static int libo_xl_themes_write(libo *l)
+size_t libo_xl_sheet_format_formula(libo_xl_sheet *sheet,
+                                    int row,
+                                    int col,
+                                    char *buffer,
+                                    size_t size)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
+  libo_xl_cell *cell;
+  int n;
 
-  if (!l || !l->z) return -1;
+  if (buffer && size) *buffer = 0;
 
-  zs = zip_source_buffer_create(libo_xl_theme_standard, strlen(libo_xl_theme_standard), 0, &err);
-  if (!zs) return -1;
+  cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, row), col);
+  if (libo_xl_cell_get_type(cell) != libo_xl_cell_type_expression) return 0;
 
-  if ((zip_file_add(l->z, "xl/theme/theme1.xml", zs, 0)) < 0) return -1;
+  if (!cell->expression.formula && (cell->shared > 0) && (cell->shared <= sheet->n_shared))
+    return libo_xl_formula_from_r1c1(sheet->shared[cell->shared - 1], row, col, buffer, size);
 
-  return 0;
-}
+  if (!cell->expression.formula) return 0;
 
-#include "libo-xl-styles.c"
+  n = snprintf(buffer, buffer ? size : 0, "%s", cell->expression.formula);
+
+  return n < 0 ? 0 : (size_t)n;
+}
 
   /**
-   *  @fn int libo_xl_styles_write(libo *l)
+   *  @fn char *libo_xl_sheet_get_string_value(libo_xl *xl,
+   *                                           libo_xl_sheet *sheet,
+   *                                           int row,
+   *                                           int col)
    *
-   *  @brief writes XL styles to document file
+   *  @brief returns string value of cell at @p row and @p col of @p sheet
    *
-   *  @param l - pointer to existing @a libo document
+   *  As @a libo_xl_cell_get_string_value, but cells sharing a formula give
+   *  its text at their position.
    *
-   *  @return 0 on success, -1 on failure
+   *  @param xl - pointer to existing @a libo_xl
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param row - index of row
+   *  @param col - index of column
+   *
+   *  @return string containing cell's value, to be freed by caller, NULL if
+   *          there is no cell or its type is unknown
    */
 
-static int libo_xl_styles_write(libo *l)
+char *libo_xl_sheet_get_string_value(libo_xl *xl,
+                                     libo_xl_sheet *sheet,
+                                     int row,
+                                     int col)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
+  libo_xl_cell *cell;
+  char *value;
+  size_t len;
 
-  if (!l || !l->z) return -1;
+  cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, row), col);
+  if (!cell) return NULL;
 
-  zs = zip_source_buffer_create(libo_xl_styles_standard, strlen(libo_xl_styles_standard), 0, &err);
-  if (!zs) return -1;
+  if (!cell->shared || cell->expression.formula)
+    return libo_xl_cell_get_string_value(xl, cell);
 
-  if ((zip_file_add(l->z, "xl/styles.xml", zs, 0)) < 0) return -1;
+  len = libo_xl_sheet_format_formula(sheet, row, col, NULL, 0);
+  if (!len) return libo_xl_cell_get_string_value(xl, cell);
 
-  return 0;
+  value = (char *)malloc(len + 1);
+  if (value) libo_xl_sheet_format_formula(sheet, row, col, value, len + 1);
+
+  return value;
 }
 
   /**
-   *  @fn int libo_xl_docprops_write(libo *l)
+   *  @fn int libo_xl_sheet_get_shared_count(libo_xl_sheet *sheet)
    *
-   *  @brief writes XL document properties to document file
+   *  @brief returns number of shared formulas of @p sheet
    *
-   *  @param l - pointer to existing @a libo document
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
    *
-   *  @return 0 on success, -1 on failure
+   *  @return number of shared formulas
    */
 
-static int libo_xl_docprops_write(libo *l)
+int libo_xl_sheet_get_shared_count(libo_xl_sheet *sheet)
 {
-  int success = -1;
+  if (!sheet) return 0;
 
-  if (!l || !l->z) goto bail;
-
-  if (libo_xl_docprops_app_write(l)) goto bail;
-  if (libo_xl_docprops_core_write(l)) goto bail;
+  return sheet->n_shared;
+}
 
-  success = 0;
+  /**
+   *  @fn char *libo_xl_sheet_get_shared(libo_xl_sheet *sheet, int n)
+   *
+   *  @brief returns shared formula at index @p n of @p sheet, in R1C1 form
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param n - index of shared formula
+   *
+   *  @return formula owned by @p sheet, NULL if none
+   */
 
-bail:
-  return success;
-}
+char *libo_xl_sheet_get_shared(libo_xl_sheet *sheet, int n)
+{
+  if (!sheet) return NULL;
 
-static char *libo_xl_app_boiler_plate_1 =  /**<  XML boiler plate  */
-  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
-  "<Properties xmlns=\"http://schemas.openxmlformats.org/officeDocument/2006/extended-properties\" xmlns:vt=\"http://schemas.openxmlformats.org/officeDocument/2006/docPropsVTypes\">"
-  "<Application>Microsoft Excel</Application>"
-  "<DocSecurity>0</DocSecurity>"
-  "<ScaleCrop>false</ScaleCrop>";
+  if (n < 0) return NULL;
+  if (n >= sheet->n_shared) return NULL;
 
-static char *libo_xl_app_boiler_plate_2 =  /**<  XML boiler plate  */
-  "<LinksUpToDate>false</LinksUpToDate>"
-  "<SharedDoc>false</SharedDoc>"
-  "<HyperlinksChanged>false</HyperlinksChanged>"
-  "<AppVersion>16.0300</AppVersion>"
-  "</Properties>";
+  return sheet->shared[n];
+}
 
   /**
-   *  @fn int libo_xl_docprops_app_write(libo *l)
+   *  @fn int libo_xl_sheet_expand_formulas(libo_xl_sheet *sheet)
    *
-   *  @brief writes application document properties to document file
+   *  @brief gives each cell of @p sheet sharing a formula its own text,
+   *         and forgets the shared formulas
    *
-   *  @param l - pointer to existing @a libo document
+   *  Needed before cells are moved, as a shared formula only holds for the
+   *  position of each cell.  A sheet on disk, compressed or columnar is
+   *  moved back into memory.
    *
-   *  @return 0 on success, -1 on failure
+   *  @param sheet - pointer to resident @a libo_xl_sheet struct
+   *
+   *  @return number of cells given text, -1 on failure
    */
 
-static int libo_xl_docprops_app_write(libo *l)
+int libo_xl_sheet_expand_formulas(libo_xl_sheet *sheet)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
-  int success = -1;
-  char number[25];
-  char *buf = NULL;
+  int n = 0;
+  int k;
   int i;
 
-  if (!l || !l->z) goto bail;
-
-  memset(number, 0, 25);
+  if (!sheet) return -1;
+  if (!sheet->n_shared) return 0;
+  if (sheet->state != libo_xl_sheet_state_resident) return -1;
 
-  buf = strapp(buf, libo_xl_app_boiler_plate_1);
+  if (sheet->store && libo_xl_sheet_set_storage(sheet, libo_xl_storage_memory))
+    return -1;
 
-  buf = strapp(buf, "<HeadingPairs>");
-  buf = strapp(buf, "<vt:vector size=\"2\" baseType=\"variant\">");
-  buf = strapp(buf, "<vt:variant>");
-  buf = strapp(buf, "<vt:lpstr>Worksheets</vt:lpstr>");
-  buf = strapp(buf, "</vt:variant>");
-  buf = strapp(buf, "<vt:variant>");
-  buf = strapp(buf, "<vt:i4>");
-  sprintf(number, "%d", l->xl->book->n_sheets);
-  buf = strapp(buf, number);
-  buf = strapp(buf, "</vt:i4>");
-  buf = strapp(buf, "</vt:variant>");
-  buf = strapp(buf, "</vt:vector>");
-  buf = strapp(buf, "</HeadingPairs>");
-  buf = strapp(buf, "<TitlesOfParts>");
-  buf = strapp(buf, "<vt:vector size=\"");
-  sprintf(number, "%d", l->xl->book->n_sheets);
-  buf = strapp(buf, number);
-  buf = strapp(buf, "\" baseType=\"lpstr\">");
-  for (i = 0; i < l->xl->book->n_sheets; i++)
+  for (i = 0; i < sheet->n_rows; i++)
   {
-    buf = strapp(buf, "<vt:lpstr>");
-    buf = strapp(buf, l->xl->book->sheet[i]->name);
-    buf = strapp(buf, "</vt:lpstr>");
+    k = sheet_row_expand(sheet, i, sheet->row[i]);
+    if (k < 0) return -1;
+    n += k;
   }
-  buf = strapp(buf, "</vt:vector>");
-  buf = strapp(buf, "</TitlesOfParts>");
-
-  buf = strapp(buf, libo_xl_app_boiler_plate_2);
-
-  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
-  if (!zs) goto bail;
-
-  if ((zip_file_add(l->z, "docProps/app.xml", zs, 0)) < 0) goto bail;
 
-  success = 0;
-
-bail:
-  if (success < 0 && buf) free(buf);
+  sheet_shared_free(sheet);
 
-  return success;
+  return n;
 }
 
-static char *libo_xl_core_boiler_plate_1 =  /**<  XML boiler plate  */
-  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
-  "<cp:coreProperties xmlns:cp=\"http://schemas.openxmlformats.org/package/2006/metadata/core-properties\" xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:dcterms=\"http://purl.org/dc/terms/\" xmlns:dcmitype=\"http://purl.org/dc/dcmitype/\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">"
-  "<dc:creator>LIBO</dc:creator>"
-  "<cp:lastModifiedBy>LIBO</cp:lastModifiedBy>";
-
-static char *libo_xl_core_boiler_plate_2 =  /**<  XML boiler plate  */
-  "</cp:coreProperties>";
-
   /**
-   *  @fn int libo_xl_docprops_core_write(libo *l)
+   *  @fn libo_doc *libo_doc_new(void)
    *
-   *  @brief writes XL core document properties to document file
+   *  @brief creates a new @a libo_doc struct
    *
-   *  @param l - pointer to existing @a libo document
+   *  @par Parameters
+   *  None.
    *
-   *  @return 0 on success, -1 on failure
+   *  @return pointer to @a libo_doc
    */
 
-static int libo_xl_docprops_core_write(libo *l)
+libo_doc *libo_doc_new(void)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
-  int success = -1;
-  char *buf = NULL;
-  char date[50];
-  time_t tim = 0;
-  struct tm *gmt;
-
-  if (!l || !l->z) goto bail;
-
-  memset(date, 0, 50);
-
-  tim = time(NULL);
-  gmt = gmtime(&tim);
-  strftime(date, 50, "%Y-%m-%dT%H:%M:%SZ", gmt);
-
-  buf = strapp(buf, libo_xl_core_boiler_plate_1);
-
-  buf = strapp(buf, "<dcterms:created xsi:type=\"dcterms:W3CDTF\">");
-  buf = strapp(buf, date);
-  buf = strapp(buf, "</dcterms:created>");
-  buf = strapp(buf, "<dcterms:modified xsi:type=\"dcterms:W3CDTF\">");
-  buf = strapp(buf, date);
-  buf = strapp(buf, "</dcterms:modified>");
-
-  buf = strapp(buf, libo_xl_core_boiler_plate_2);
-
-  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
-  if (!zs) goto bail;
-
-  if ((zip_file_add(l->z, "docProps/core.xml", zs, 0)) < 0) goto bail;
-
-  success = 0;
+  libo_doc *doc;
 
-bail:
-  if (success < 0 && buf) free(buf);
+  doc = (libo_doc *)malloc(sizeof(libo_doc));
+  if (!doc) return NULL;
+  memset(doc, 0, sizeof(libo_doc));
 
-  return success;
+  return doc;
 }
 
   /**
-   *  @fn int libo_xl_xl_rels_write(libo *l)
+   *  @fn libo_doc *libo_doc_dup(libo_doc *doc)
    *
-   *  @brief writes XL relationships to document file
+   *  @brief creates a deep copy of @p doc
    *
-   *  @param l - pointer to existing @a libo document
+   *  @param doc - pointer to existing @a libo_doc struct
    *
-   *  @return 0 on success, -1 on failure
+   *  @return pointer to @a libo_doc
    */
 
-static int libo_xl_xl_rels_write(libo *l)
+libo_doc *libo_doc_dup(libo_doc *doc)
 {
-  int success = -1;
-
-  if (!l || !l->z) goto bail;
+  libo_doc *ndoc = NULL;
 
-  if (libo_xl_xl_rels_workbook_rels_write(l)) goto bail;
+  if (!doc) goto exit;
 
-  success = 0;
+  ndoc = libo_doc_new();
+  if (!ndoc) goto exit;
 
-bail:
-  return success;
+exit:
+  return ndoc;
 }
 
-static char *libo_xl__rels_dot_rels_boiler_plate_1 =  /**<  XML boiler plate  */
-  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
-  "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
-  "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
-  "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/package/2006/relationships/metadata/core-properties\" Target=\"docProps/core.xml\"/>"
-  "<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/extended-properties\" Target=\"docProps/app.xml\"/>"
-  "</Relationships>";
-
   /**
-   *  @fn int libo_xl__rels_dot_rels_write(libo *l)
+   *  @fn void libo_doc_free(libo_doc *doc)
    *
-   *  @brief writes XL default relationships to document files
+   *  @brief frees all memory allocated to @p doc
    *
-   *  @param l - pointer to existing @a libo document
+   *  @param doc - pointer to existing @a libo_doc struct
    *
-   *  @return 0 on success, -1 on failure
+   *  @par Returns
+   *  Nothing.
    */
 
-static int libo_xl__rels_dot_rels_write(libo *l)
+void libo_doc_free(libo_doc *doc)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
-  int success = -1;
-  char *buf = NULL;
+  if (!doc) return;
 
-  buf = strapp(buf, libo_xl__rels_dot_rels_boiler_plate_1);
+  free(doc);
 
-  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
-  if (!zs) goto bail;
+  return;
+}
 
-  if ((zip_file_add(l->z, "_rels/.rels", zs, 0)) < 0) goto bail;
+  /**
+   *  @fn libo_pp *libo_pp_new(void)
+   *
+   *  @brief creates a new @a libo_pp struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to @a libo_pp
+   */
 
-  success = 0;
+libo_pp *libo_pp_new(void)
+{
+  libo_pp *pp;
 
-bail:
-  if (success < 0 && buf) free(buf);
+  pp = (libo_pp *)malloc(sizeof(libo_pp));
+  if (!pp) return NULL;
+  memset(pp, 0, sizeof(libo_pp));
 
-  return success;
+  return pp;
 }
 
-static char *libo_xl_workbook_rels_boiler_plate_1 =  /**<  XML boiler plate  */
-  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
-  "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
-  "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/theme\" Target=\"theme/theme1.xml\"/>"
-  "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>"
-  "<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>";
-
-static char *libo_xl_workbook_rels_boiler_plate_2 =  /**<  XML boiler plate  */
-  "</Relationships>";
-
   /**
-   *  @fn int libo_xl_xl_rels_workbook_rels_write(libo *l)
+   *  @fn libo_pp *libo_pp_dup(libo_pp *pp)
    *
-   *  @brief writes XL workbook relationships to document file
+   *  @brief creates a deep copy of @p pp
    *
-   *  @param l - pointer to existing @a libo document
+   *  @param pp - pointer to existing @a libo_pp struct
    *
-   *  @return 0 on success, -1 on failure
+   *  @return pointer to @a libo_pp
    */
 
-static int libo_xl_xl_rels_workbook_rels_write(libo *l)
+libo_pp *libo_pp_dup(libo_pp *pp)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
-  int success = -1;
-  char *buf = NULL;
-  char number[25];
-  int i;
+  libo_pp *npp = NULL;
 
-  if (!l || !l->z) goto bail;
+  if (!pp) goto exit;
 
-  memset(number, 0, 25);
+  npp = libo_pp_new();
+  if (!npp) goto exit;
 
-  buf = strapp(buf, libo_xl_workbook_rels_boiler_plate_1);
+exit:
+  return npp;
+}
 
-  for (i = 0; i < l->xl->book->n_sheets; i++)
-  {
-    sprintf(number, "%d", i+4);
-    buf = strapp(buf, "<Relationship Id=\"rId");
-    buf = strapp(buf, number);
-    buf = strapp(buf, "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet");
-    sprintf(number, "%d", i+1);
-    buf = strapp(buf, number);
-    buf = strapp(buf, ".xml\"/>");
-  }
+  /**
+   *  @fn void libo_pp_free(libo_pp *pp)
+   *
+   *  @brief frees all memory allocated to @p pp
+   *
+   *  @param pp - pointer to existing @a libo_pp struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-  buf = strapp(buf, libo_xl_workbook_rels_boiler_plate_2);
+void libo_pp_free(libo_pp *pp)
+{
+  if (!pp) return;
 
-  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
-  if (!zs) goto bail;
+  free(pp);
 
-  if ((zip_file_add(l->z, "xl/_rels/workbook.xml.rels", zs, 0)) < 0) goto bail;
+  return;
+}
 
-  success = 0;
+  /**
+   *  @fn char *libo_type_to_string(libo_type lt)
+   *
+   *  @brief returns string representation of @p lt
+   *
+   *  @param lt - @a libo_type
+   *
+   *  @return string representation of @p lt
+   */
 
-bail:
-  if (success < 0 && buf) free(buf);
+char *libo_type_to_string(libo_type lt)
+{
+  switch (lt)
+  {
+    case libo_type_none: return "[UNKNOWN]";
+    case libo_type_xl: return "Microsoft Excel";
+    case libo_type_doc: return "Microsoft Word";
+    case libo_type_pp: return "Microsoft PowerPoint";
+  }
 
-  return success;
+  return libo_type_none;
 }
 
-static char *libo_xl_content_types_boiler_plate_1 =  /**<  XML boiler plate  */
-  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
-  "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">\n"
-  //"<Default Extension=\"bin\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.printerSettings\"/>\n"
-  "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>\n"
-  "<Default Extension=\"xml\" ContentType=\"application/xml\"/>\n";
-
-static char *libo_xl_content_types_boiler_plate_2 =  /**<  XML boiler plate  */
-  "<Override PartName=\"/docProps/core.xml\" ContentType=\"application/vnd.openxmlformats-package.core-properties+xml\"/>\n"
-  "<Override PartName=\"/docProps/app.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.extended-properties+xml\"/>\n"
-  "</Types>\n";
-
   /**
-   *  @fn int libo_xl_content_types_write(libo *l)
+   *  @fn libo_xl_strings *libo_xl_strings_read(libo *l)
    *
-   *  @brief writes XL content types to document file
+   *  @brief creates new @a libo_xl_strings struct from file
    *
-   *  @param l - pointer to existing @a libo document
+   *  @param l - pointer to existing @a libo struct
    *
-   *  @return 0 on success, -1 on failure
+   *  @return pointer to new and filled @a libo_xl_strings struct
    */
 
-static int libo_xl_content_types_write(libo *l)
+strings *libo_xl_strings_read(libo *l)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
+  char *strings_file_name = "xl/sharedStrings.xml";
+  zip_stat_t stat;
+  zip_file_t *zf = NULL;
+  xmlDocPtr doc = NULL;
+  xmlNodePtr node = NULL;
   char *buf = NULL;
-  char number[25];
-  int i;
-  int success = -1;
+  int len;
+  strings *strings;
+  string *str;
 
-  if (!l || !l->z) goto bail;
+  if (!l) return NULL;
+  if (!l->z) return NULL;
 
-  memset(number, 0, 25);
+    // open xl/shareStrings.xml
 
-  buf = strapp(buf, libo_xl_content_types_boiler_plate_1);
+  if (zip_stat(l->z, strings_file_name, 0, &stat)) return NULL;
+  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return NULL;
 
-  switch (l->type)
-  {
-    case libo_type_xl:
-      buf = strapp(buf, "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>");
+  if (strcmp(strings_file_name, stat.name)) return NULL;
 
-      for (i = 0; i < l->xl->book->n_sheets; i++)
-      {
-        buf = strapp(buf, "<Override PartName=\"/xl/worksheets/sheet");
-        sprintf(number, "%d", i+1);
-        buf = strapp(buf, number);
-        buf = strapp(buf, ".xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>");
-      }
+  len = stat.size;
 
-      buf = strapp(buf, "<Override PartName=\"/xl/theme/theme1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.theme+xml\"/>");
-      buf = strapp(buf, "<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>");
-      buf = strapp(buf, "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>");
+  zf = zip_fopen(l->z, strings_file_name, 0);
+  if (!zf)
+  {
+    fprintf(stderr, "Can not open '%s'\n", strings_file_name); fflush(stderr);
+    return NULL;
+  }
 
-      break; //libo_type_xl
+  buf = (char *)malloc(len+1);
+  if (!buf)
+  {
+    zip_fclose(zf);
+    return NULL;
+  }
+  memset(buf, 0, len+1);
 
-    case libo_type_doc:
-      break; //libo_type_doc
+  zip_fread(zf, buf, len);
 
-    case libo_type_pp:
-      break; //libo_type_pp
+  zip_fclose(zf);
 
-    default: break;
+  doc = xmlParseMemory(buf, len);
+  if (!doc)
+  {
+    fprintf(stderr, "Failed to parse app.xml\n"); fflush(stderr);
+    return NULL;
   }
+  free(buf);
 
-  buf = strapp(buf, libo_xl_content_types_boiler_plate_2);
-
-  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
-  if (!zs) goto bail;
+    // Fill libo_xl_strings structure with strings from XML
 
-  if ((zip_file_add(l->z, "[Content_Types].xml", zs, 0)) < 0) goto bail;
+  strings = strings_new();
+  if (!strings)
+  {
+    xmlFreeDoc(doc);
+    return NULL;
+  }
 
-  success = 0;
+  node = xmlDocGetRootElement(doc);
+  if (!strcmp((char *)node->name, "sst"))
+  {
+    node = node->children;
+    while (node)
+    {
+      if (!strcmp((char *)node->name, "si"))
+      {
+        buf = (char *)xmlNodeGetContent(node);
+        str = string_new_with_values(buf, 0);
+        if (str) strings_add(strings, str);
+      }
+      node = node->next;
+    }
+  }
 
-bail:
-  if (success < 0 && buf) free(buf);
+  xmlFreeDoc(doc);
 
-  return success;
+  return strings;
 }
 
-static char *libo_xl_workbook_boiler_plate_1 =  /**<  XML boiler plate  */
-  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
-  "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\" xmlns:x15=\"http://schemas.microsoft.com/office/spreadsheetml/2010/11/main\" xmlns:xr=\"http://schemas.microsoft.com/office/spreadsheetml/2014/revision\" xmlns:xr6=\"http://schemas.microsoft.com/office/spreadsheetml/2016/revision6\" xmlns:xr10=\"http://schemas.microsoft.com/office/spreadsheetml/2016/revision10\" mc:Ignorable=\"x15 xr xr6 xr10\">";
+static int _strings_indent = 0;    /**<  Used by string_dumper()  */
+static FILE *_dumper_file = NULL;  /**<  Used by dumpers  */
 
   /**
-   *  @fn int libo_xl_workbook_write(libo *l)
+   *  @fn void libo_xl_strings_dump(strings *strs, FILE *stream, int indent)
    *
-   *  @brief writes XL workbook to document file
+   *  @brief dumps contents of @p lxs to @p stream, default is STDOUT
    *
-   *  @param l - pointer to existing @a libo document
+   *  @param strs - pointer to @a strings struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
    *
-   *  @return 0 on success, -1 on failure
+   *  @par Returns
+   *  Nothing.
    */
 
-static int libo_xl_workbook_write(libo *l)
+void libo_xl_strings_dump(strings *strs, FILE *stream, int indent)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
-  char *buf = NULL;
-  char number[25];
-  int success = -1;
-  int i;
+  if (!strs) return;
 
-  if (!l || !l->z) goto bail;
+  if (!stream) stream = stdout;
 
-  buf = strapp(buf, libo_xl_workbook_boiler_plate_1);
-  buf = strapp(buf, "<fileVersion appName=\"xl\" lastEdited=\"1\" lowestEdited=\"1\" rupBuild=\"25601\"/>"); // what are parameters??
-  buf = strapp(buf, "<workbookPr defaultThemeVersion=\"166925\"/>");
-  buf = strapp(buf, "<mc:AlternateContent xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">");
-  buf = strapp(buf, "<mc:Choice Requires=\"x15\">");
-  buf = strapp(buf, "<x15ac:absPath xmlns:x15ac=\"http://schemas.microsoft.com/office/spreadsheetml/2010/11/ac\" url=\"");
-  buf = strapp(buf, l->path);
-  buf = strapp(buf, "\"/>");
-  buf = strapp(buf, "</mc:Choice>");
-  buf = strapp(buf, "</mc:AlternateContent>");
-  buf = strapp(buf, "<xr:revisionPtr revIDLastSave=\"0\" documentId=\"13_ncr:40009_{47680350-0BCE-45AA-9C35-94426BD8D69C}\" xr6:coauthVersionLast=\"47\" xr6:coauthVersionMax=\"47\" xr10:uidLastSave=\"{00000000-0000-0000-0000-000000000000}\"/>");
-  buf = strapp(buf, "<bookViews>");
-  buf = strapp(buf, "<workbookView xWindow=\"-108\" yWindow=\"-108\" windowWidth=\"23256\" windowHeight=\"12576\"/>");
-  buf = strapp(buf, "</bookViews>");
-  buf = strapp(buf, "<sheets>");
-  for (i = 0; i < l->xl->book->n_sheets; i++)
-  {
-    buf = strapp(buf, "<sheet name=\"");
-    buf = strapp(buf, l->xl->book->sheet[i]->name);
-    buf = strapp(buf, "\" sheetId=\"");
-    sprintf(number, "%d", i+1);
-    buf = strapp(buf, number);
-    buf = strapp(buf, "\" r:id=\"rId");
-    sprintf(number, "%d", i+4);
-    buf = strapp(buf, number);
-    buf = strapp(buf, "\"/>");
-  }
-  buf = strapp(buf, "</sheets>");
-  buf = strapp(buf, "<calcPr calcId=\"0\"/>");
-  buf = strapp(buf, "</workbook>");
+  do_indent(stream, indent); fprintf(stream,
+                                     "Shared strings (%d):\n",
+                                     strs->last_id);
+  indent += 2;
 
-  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
-  if (!zs) goto bail;
+  _dumper_file = stream;
+  _strings_indent = indent;
 
-  if ((zip_file_add(l->z, "xl/workbook.xml", zs, 0)) < 0) goto bail;
+  avl_walk(strs->id_root, string_id, string_dumper);
 
-  success = 0;
+  return;
+}
 
-bail:
-  if (success < 0 && buf) free(buf);
+  /**
+   *  @fn libo_xl_styles *libo_xl_get_styles(libo_xl *xl)
+   *
+   *  @brief returns style sheet of @p xl, creating the standard one if
+   *         none was read
+   *
+   *  @param xl - pointer to existing @a libo_xl struct
+   *
+   *  @return pointer to @a libo_xl_styles struct, NULL on failure
+   */
 
-  return success;
+libo_xl_styles *libo_xl_get_styles(libo_xl *xl)
+{
+  if (!xl) return NULL;
+
+  if (!xl->styles) xl->styles = styles_new_standard();
+
+  return xl->styles;
 }
 
   /**
-   *  @fn int libo_xl_sheets_write(libo *l)
+   *  @fn libo_xl_styles *libo_xl_styles_read(libo *l)
    *
-   *  @brief writes XL worksheets to document file
+   *  @brief creates new @a libo_xl_styles struct from style sheet of file
    *
-   *  @param l - pointer to existing @a libo document
+   *  @param l - pointer to existing @a libo struct
    *
-   *  @return 0 on success, -1 on failure
+   *  @return pointer to new and filled @a libo_xl_styles struct, NULL if
+   *          the file has no style sheet
    */
 
-static int libo_xl_sheets_write(libo *l)
+libo_xl_styles *libo_xl_styles_read(libo *l)
 {
-  int success = -1;
-  int i;
+  char *styles_file_name = "xl/styles.xml";
+  libo_xl_styles *styles;
+  zip_stat_t stat;
+  zip_file_t *zf = NULL;
+  xmlDocPtr doc = NULL;
+  char *buf = NULL;
+  int len;
 
-  if (!l) goto bail;
-  if (l->type != libo_type_xl) goto bail;
+  if (!l) return NULL;
+  if (!l->z) return NULL;
 
-  libo_xl_renumber_strings(l);
+  if (zip_stat(l->z, styles_file_name, 0, &stat)) return NULL;
+  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return NULL;
 
-  for (i = 0; i < l->xl->book->n_sheets; i++)
-    if (libo_xl_sheet_write(l, i) < 0) goto bail;
+  len = stat.size;
 
-  success = 0;
+  zf = zip_fopen(l->z, styles_file_name, 0);
+  if (!zf)
+  {
+    fprintf(stderr, "Can not open '%s'\n", styles_file_name); fflush(stderr);
+    return NULL;
+  }
 
-bail:
-  return success;
-}
+  buf = (char *)malloc(len+1);
+  if (!buf)
+  {
+    zip_fclose(zf);
+    return NULL;
+  }
+  memset(buf, 0, len+1);
 
-  //"<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\" xmlns:x14ac=\"http://schemas.microsoft.com/office/spreadsheetml/2009/9/ac\" mc:Ignorable=\"x14ac\">";
-static char *libo_xl_sheet_boiler_plate_1 =  /**<  XML boiler plate  */
-  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
-  "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\" xmlns:x14ac=\"http://schemas.microsoft.com/office/spreadsheetml/2009/9/ac\" xmlns:xr=\"http://schemas.microsoft.com/office/spreadsheetml/2014/revision\" xmlns:xr2=\"http://schemas.microsoft.com/office/spreadsheetml/2015/revision2\" xmlns:xr3=\"http://schemas.microsoft.com/office/spreadsheetml/2016/revision3\" mc:Ignorable=\"x14ac xr xr2 xr3\" xr:uid=\"{00000000-0001-0000-0800-000000000000}\">\n";
+  zip_fread(zf, buf, len);
 
-static char *libo_xl_sheet_boiler_plate_2 =  /**<  XML boiler plate  */
-  "<pageMargins left=\"0.7\" right=\"0.7\" top=\"0.75\" bottom=\"0.75\" header=\"0.3\" footer=\"0.3\"/>\n"
-  "<pageSetup orientation=\"portrait\" horizontalDpi=\"300\" verticalDpi=\"300\" r:id=\"rId1\"/>\n"
-  "</worksheet>\n";
+  zip_fclose(zf);
+
+  doc = xmlParseMemory(buf, len);
+  free(buf);
+  if (!doc)
+  {
+    fprintf(stderr, "Failed to parse styles.xml\n"); fflush(stderr);
+    return NULL;
+  }
+
+  styles = styles_parse(doc);
+
+  xmlFreeDoc(doc);
+
+  return styles;
+}
 
   /**
-   *  @fn int libo_xl_sheet_write(libo *l, int sheet)
+   *  @fn void libo_xl_styles_free(libo_xl_styles *styles)
    *
-   *  @brief writes XL worksheet to document file
+   *  @brief frees all memory allocated to @p styles
    *
-   *  @param l - pointer to existing @a libo document
-   *  @param sheet - index of sheet to write 
+   *  @param styles - pointer to existing @a libo_xl_styles struct
    *
-   *  @return 0 on success, -1 on failure
+   *  @par Returns
+   *  Nothing.
    */
 
-static int libo_xl_sheet_write(libo *l, int sheet)
+void libo_xl_styles_free(libo_xl_styles *styles)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
-  char *buf = NULL;
-  char number[25];
-  char name[256];
-  int success = -1;
-  libo_xl_sheet *sht;
+  int i;
 
-  if (!l) goto bail;
-  if (l->type != libo_type_xl) goto bail;
-  if (!l->xl) goto bail;
-  if (!l->xl->book) goto bail;
-  if (sheet >= l->xl->book->n_sheets) goto bail;
-  if (!l->xl->book->sheet[sheet]) goto bail;
+  if (!styles) return;
+
+  style_pool_clear(&styles->font);
+  style_pool_clear(&styles->fill);
+  style_pool_clear(&styles->border);
+  style_pool_clear(&styles->format);
+  free(styles->format_id);
+
+  for (i = 0; i < styles->n_styles; i++)
+    free(styles->style[i].alignment);
+  free(styles->style);
+  free(styles->hash);
+  free(styles->date);
+  free(styles->slot);
+
+  for (i = 0; i < styles->n_parents; i++)
+    free(styles->parent[i].alignment);
+  free(styles->parent);
+
+  for (i = 0; i < styles->n_names; i++)
+    free(styles->name[i]);
+  free(styles->name);
+  free(styles->name_parent);
+
+  free(styles->rest);
+  free(styles->map);
+  free(styles);
+}
 
-  memset(number, 0, 25);
-  memset(name, 0, 256);
+  /**
+   *  @fn size_t libo_xl_styles_memory_size(libo_xl_styles *styles)
+   *
+   *  @brief returns number of bytes of memory used by @p styles
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *
+   *  @return approximate number of bytes allocated to @p styles
+   */
 
-  sht = l->xl->book->sheet[sheet];
+size_t libo_xl_styles_memory_size(libo_xl_styles *styles)
+{
+  style_pool *pool[4];
+  size_t bytes;
+  int i, j;
 
-  libo_xl_sheet_count_columns(sht);
-  if (!sht->column) sht->column = libo_xl_sheet_columns_create_defaults(sht);
+  if (!styles) return 0;
 
-  buf = strapp(buf, libo_xl_sheet_boiler_plate_1);
+  bytes = sizeof(libo_xl_styles);
 
-  libo_xl_sheet_dimension_add(l, sheet, &buf);
-  libo_xl_sheet_sheetviews_add(l, sheet, &buf);
-  libo_xl_sheet_formatpr_add(l, sheet, &buf);
-  libo_xl_sheet_cols_add(l, sheet, &buf);
-  libo_xl_sheet_sheetdata_add(l, sheet, &buf);
-  libo_xl_sheet_filter_add(l, sheet, &buf);
+  pool[0] = &styles->font;
+  pool[1] = &styles->fill;
+  pool[2] = &styles->border;
+  pool[3] = &styles->format;
 
-  buf = strapp(buf, libo_xl_sheet_boiler_plate_2);
+  for (j = 0; j < 4; j++)
+  {
+    bytes += (sizeof(char *) + sizeof(unsigned long)) * pool[j]->size;
+    bytes += sizeof(int) * pool[j]->n_slots;
+    for (i = 0; i < pool[j]->n; i++)
+      bytes += strlen(pool[j]->text[i]) + 1;
+  }
+  bytes += sizeof(int) * styles->format.size;
 
-  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
-  if (!zs) goto bail;
+  bytes += (sizeof(libo_xl_style) + sizeof(unsigned long) + 1) * styles->size_styles;
+  bytes += sizeof(int) * styles->n_slots;
+  for (i = 0; i < styles->n_styles; i++)
+    if (styles->style[i].alignment) bytes += strlen(styles->style[i].alignment) + 1;
 
-  sprintf(name, "xl/worksheets/sheet%d.xml", sheet+1);
-  if ((zip_file_add(l->z, name, zs, 0)) < 0) goto bail;
+  bytes += sizeof(libo_xl_style) * styles->n_parents;
+  for (i = 0; i < styles->n_parents; i++)
+    if (styles->parent[i].alignment) bytes += strlen(styles->parent[i].alignment) + 1;
 
-  success = 0;
+  bytes += (sizeof(char *) + sizeof(int)) * styles->n_names;
+  for (i = 0; i < styles->n_names; i++)
+    bytes += strlen(styles->name[i]) + 1;
 
-bail:
-  if (success < 0 && buf) free(buf);
+  if (styles->rest) bytes += strlen(styles->rest) + 1;
+  if (styles->map) bytes += sizeof(int) * styles->n_styles;
 
-  return success;
+  return bytes;
 }
 
- /**
-  * @fn static char *strapp(char *s1, char *s2)
-  *
-  * @brief appends @p s2 to @p s1 , reallocating memory
-  *
-  * NOTE:  The user is responsible for freeing @p s2 if required.
-  *
-  * @param s1 - original string, can be NULL
-  * @param s2 - addendum to string
-  *
-  * @return pointer to newly formed string
-  */
+  /**
+   *  @fn void libo_xl_styles_dump(libo_xl_styles *styles, FILE *stream, int indent)
+   *
+   *  @brief dumps contents of @p styles to @p stream, default is STDOUT
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-static char *strapp(char *s1, char *s2)
+void libo_xl_styles_dump(libo_xl_styles *styles, FILE *stream, int indent)
 {
-  int len1, len2;
-  char *tmp;
+  libo_xl_style *style;
+  int i;
 
-  if (!s1)
-  {
-    s1 = malloc(1);
-    if (!s1) return NULL;
-    *s1 = 0;
-  }
+  if (!styles) return;
+  if (!stream) stream = stdout;
 
-  if (!s2) return s1;
+  do_indent(stream, indent);
+    fprintf(stream, "Styles: %d fonts, %d fills, %d borders, %d number formats\n",
+            styles->font.n, styles->fill.n, styles->border.n, styles->format.n);
+  indent += 2;
 
-  len1 = strlen(s1);
-  len2 = strlen(s2);
+  for (i = 0; i < styles->format.n; i++)
+  {
+    do_indent(stream, indent);
+      fprintf(stream, "Number format %d: %s\n", styles->format_id[i], styles->format.text[i]);
+  }
 
-  tmp = realloc(s1, len1 + len2 + 1);
-  if (tmp)
+  for (i = 0; i < styles->n_styles; i++)
   {
-    s1 = tmp;
-    strcat(s1, s2);
+    style = &styles->style[i];
+    do_indent(stream, indent);
+      fprintf(stream, "Cell format %d: number format=%d, font=%d, fill=%d, border=%d, parent=%d, flags=%#x, cleared=%#x%s%s\n",
+              i, style->number_format, style->font, style->fill, style->border,
+              style->parent, style->flags, style->cleared,
+              style->alignment ? ", " : "", style->alignment ? style->alignment : "");
   }
 
-  return s1;
+  for (i = 0; i < styles->n_parents; i++)
+  {
+    style = &styles->parent[i];
+    do_indent(stream, indent);
+      fprintf(stream, "Cell style format %d: number format=%d, font=%d, fill=%d, border=%d, flags=%#x, cleared=%#x%s%s\n",
+              i, style->number_format, style->font, style->fill, style->border,
+              style->flags, style->cleared,
+              style->alignment ? ", " : "", style->alignment ? style->alignment : "");
+  }
 }
 
- /**
-  * @fn static int libo_xl_shared_strings_write(libo *l)
-  *
-  * @brief writes XL shared strings to file
-  *
-  * @param l - pointer to existing @a libo struct
-  *
-  * @return 0 on success, STDIO error on failure
-  */
+  /**
+   *  @fn int libo_xl_styles_add_font(libo_xl_styles *styles, const char *xml)
+   *
+   *  @brief adds font to @p styles, unless it holds one the same
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param xml - XML of font element, such as
+   *               <font><b/><sz val="11"/><name val="Calibri"/></font>
+   *
+   *  @return index of font, -1 on failure
+   */
 
-static int libo_xl_shared_strings_write(libo *l)
+int libo_xl_styles_add_font(libo_xl_styles *styles, const char *xml)
 {
-  zip_error_t err;
-  zip_source_t *zs = NULL;
-  char *buf = NULL;
-  strings *strs;
-  char number[25];
-  char name[256];
-  int success = -1;
+  if (!styles || !xml) return -1;
 
-  if (!l) goto bail;
-  if (l->type != libo_type_xl) goto bail;
-  if (!l->xl) goto bail;
-  if (!l->xl->strings) goto bail;
+  return style_pool_put(&styles->font, xml, 1);
+}
 
-  strs = l->xl->strings;
+  /**
+   *  @fn int libo_xl_styles_add_fill(libo_xl_styles *styles, const char *xml)
+   *
+   *  @brief adds fill to @p styles, unless it holds one the same
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param xml - XML of fill element
+   *
+   *  @return index of fill, -1 on failure
+   */
 
-    // Count number of strings
+int libo_xl_styles_add_fill(libo_xl_styles *styles, const char *xml)
+{
+  if (!styles || !xml) return -1;
 
-  _strings_count = 0;
-  strings_walk(strs, string_text, libo_xl_strings_count_action);
+  return style_pool_put(&styles->fill, xml, 1);
+}
 
-  buf = strapp(buf, "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
-  sprintf(number, "%d", _strings_count);
-  buf = strapp(buf, "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"");
-  buf = strapp(buf, number);
-  buf = strapp(buf, "\" uniqueCount=\"");
-  buf = strapp(buf, number);
-  buf = strapp(buf, "\">");
+  /**
+   *  @fn int libo_xl_styles_add_border(libo_xl_styles *styles, const char *xml)
+   *
+   *  @brief adds border to @p styles, unless it holds one the same
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param xml - XML of border element
+   *
+   *  @return index of border, -1 on failure
+   */
 
-    // Add each strings entry into buffer
+int libo_xl_styles_add_border(libo_xl_styles *styles, const char *xml)
+{
+  if (!styles || !xml) return -1;
 
-  _strings_buf = buf;
-  strings_walk(strs, string_id, libo_xl_strings_add_action);
-  buf = _strings_buf;
+  return style_pool_put(&styles->border, xml, 1);
+}
 
-  strapp(buf, "</sst>");
+  /**
+   *  @fn int libo_xl_styles_add_number_format(libo_xl_styles *styles,
+   *                                           const char *code)
+   *
+   *  @brief adds number format @p code to @p styles, unless it is built in
+   *         or held already
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param code - format code, such as yyyy-mm-dd
+   *
+   *  @return id of number format, -1 on failure
+   */
 
-  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
-  if (!zs) goto bail;
+int libo_xl_styles_add_number_format(libo_xl_styles *styles, const char *code)
+{
+  int i;
 
-  strcpy(name, "xl/sharedStrings.xml");
-  if ((zip_file_add(l->z, name, zs, 0)) < 0) goto bail;
+  if (!styles || !code) return -1;
 
-  success = 0;
+  for (i = 0; i < XL_BUILTIN_FORMATS; i++)
+    if (_xl_number_formats[i] && !strcmp(_xl_number_formats[i], code)) return i;
 
-bail:
-  if (success < 0 && buf) free(buf);
+  return styles_put_format(styles, code, -1);
+}
 
-  return success;
+  /**
+   *  @fn const char *libo_xl_styles_get_number_format(libo_xl_styles *styles,
+   *                                                   int id)
+   *
+   *  @brief returns code of number format @p id
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param id - id of number format
+   *
+   *  @return format code, NULL if @p id is neither held nor built in
+   */
+
+const char *libo_xl_styles_get_number_format(libo_xl_styles *styles, int id)
+{
+  int i;
+
+  if (!styles || (id < 0)) return NULL;
+
+    // files may give codes of built in formats
+
+  for (i = 0; i < styles->format.n; i++)
+    if (styles->format_id[i] == id) return styles->format.text[i];
+
+  if (id < XL_BUILTIN_FORMATS) return _xl_number_formats[id];
+
+  return NULL;
 }
 
- /**
-  * @fn static void libo_xl_renumber_strings(libo *l)
-  *
-  * @brief renumbers all string references in XL doc
-  *
-  * @param l - pointer to existing @a libo struct
-  *
-  * @par Returns
-  * Nothing.
-  */
+  /**
+   *  @fn int libo_xl_styles_add_style(libo_xl_styles *styles,
+   *                                   libo_xl_style *style)
+   *
+   *  @brief adds cell format @p style to @p styles, unless it holds one the
+   *         same
+   *
+   *  Cells refer to formats by index, see @a libo_xl_cell_set_style.
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param style - cell format, whose fonts, fills, borders and parent
+   *                 are held by @p styles
+   *
+   *  @return index of cell format, -1 on failure or if @p styles holds
+   *          LIBO_XL_STYLES_MAX formats
+   */
 
-static void libo_xl_renumber_strings(libo *l)
+int libo_xl_styles_add_style(libo_xl_styles *styles, libo_xl_style *style)
 {
-  libo_xl_book *book;
-  libo_xl_sheet *sheet;
-  libo_xl_row *row;
-  libo_xl_cell *cell;
-  int i, j, k;
-  unsigned int new_id = 0;
-  strings *strings = NULL;
-  string *found;
+  if (!styles || !style) return -1;
 
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (!l->xl) return;
-  if (!l->xl->strings) return;
+  if ((style->number_format < 0) || !libo_xl_styles_get_number_format(styles, style->number_format))
+    return -1;
+  if ((style->font < 0) || (style->font >= styles->font.n)) return -1;
+  if ((style->fill < 0) || (style->fill >= styles->fill.n)) return -1;
+  if ((style->border < 0) || (style->border >= styles->border.n)) return -1;
+  if ((style->parent < 0) || (style->parent >= (styles->n_parents ? styles->n_parents : 1)))
+    return -1;
 
-  book = l->xl->book;
-  if (!book) return;
+  return styles_put_style(styles, style, 1);
+}
 
-  strings = strings_new();
-  if (!strings) return;
+  /**
+   *  @fn int libo_xl_styles_get_style(libo_xl_styles *styles,
+   *                                   int index,
+   *                                   libo_xl_style *style)
+   *
+   *  @brief fills @p style with cell format @p index of @p styles
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param index - index of cell format
+   *  @param style - pointer to @a libo_xl_style to fill, whose alignment
+   *                 then belongs to @p styles
+   *
+   *  @return 0 on success, -1 if @p styles holds no format @p index
+   */
 
-    // Set shared string references to new strings IDs
+int libo_xl_styles_get_style(libo_xl_styles *styles, int index, libo_xl_style *style)
+{
+  if (!styles || !style) return -1;
+  if ((index < 0) || (index >= styles->n_styles)) return -1;
 
-  for (i = 0; i < book->n_sheets; i++)
-  {
-    sheet = book->sheet[i];
-    if (!sheet) return;
-    for (j = 0; j < sheet->n_rows; j++)
-    {
-      row = sheet->row[j];
-      if (!row) return;
-      for (k = 0; k < row->n_cells; k++)
-      {
-        cell = row->cell[k];
-        switch (cell->type)
-        {
-          case libo_xl_cell_type_none:
-          case libo_xl_cell_type_expression:
-          case libo_xl_cell_type_number:
-            break;
+  *style = styles->style[index];
 
-          case libo_xl_cell_type_reference:
-            found = strings_find_by_id(l->xl->strings, cell->reference);
-            if (found) found = strings_find_by_text(strings, found->text);
-            if (found)
-            {
-              strings_add(strings, string_dup(found));
-              cell->reference = found->id;
-            }
-            else
-            {
-              found = strings_find_by_id(l->xl->strings, cell->reference);
-              if (found) strings_add(strings, string_dup(found));
-              cell->reference = new_id;
-              ++new_id;
-            }
-            break;
-        }
-      }
-    }
-  }
+  return 0;
+}
 
-  strings_free(l->xl->strings);
-  l->xl->strings = strings;
+  /**
+   *  @fn int libo_xl_styles_get_count(libo_xl_styles *styles)
+   *
+   *  @brief returns number of cell formats in @p styles
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *
+   *  @return number of cell formats
+   */
+
+int libo_xl_styles_get_count(libo_xl_styles *styles)
+{
+  if (!styles) return 0;
+
+  return styles->n_styles;
 }
 
- /**
-  * @fn static void libo_xl_sheet_dimension_add(libo *l,
-  *                                                 int sheet,
-  *                                                 char **buf)
-  *
-  * @brief adds worksheet dimension references to XML buffer
-  *
-  * @param l - pointer to existing @a libo struct
-  * @param sheet - index of sheet in book
-  * @param buf - pointer to string holding XML buffer
-  *
-  * @par Returns
-  * Nothing.
-  */
+  /**
+   *  @fn int libo_xl_styles_is_date(libo_xl_styles *styles, int index)
+   *
+   *  @brief tells whether cell format @p index of @p styles shows a date
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param index - index of cell format
+   *
+   *  @return 1 if cells of format @p index show a date or time, 0 otherwise
+   */
 
-static void libo_xl_sheet_dimension_add(libo *l, int sheet, char **buf)
+int libo_xl_styles_is_date(libo_xl_styles *styles, int index)
 {
-  char number[25];
+  if (!styles) return 0;
+  if ((index < 0) || (index >= styles->n_styles)) return 0;
 
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (sheet >= l->xl->book->n_sheets) return;
-  if (!buf) return;
+  return styles->date[index];
+}
 
-  memset(number, 0, 25);
+  /**
+   *  @fn int libo_xl_serial_to_epoch(double serial,
+   *                                  int date1904,
+   *                                  double *seconds)
+   *
+   *  @brief converts Excel serial date @p serial to seconds since the epoch
+   *
+   *  In the 1900 date system, serial 60 is 29 February 1900, which never
+   *  was, and reads as 1 March.  Serials run from 0 up to the end of 31
+   *  December 9999, 2958465.99999 in the 1900 date system.
+   *
+   *  @param serial - days since the start of the date system, time of day
+   *                  as fraction
+   *  @param date1904 - 1 for the 1904 date system, 0 for the 1900 one
+   *  @param seconds - receives seconds since 1970-01-01 00:00:00 UTC, to
+   *                   the millisecond
+   *
+   *  @return 0 on success, -1 if @p serial is NaN or out of range
+   */
 
-    /* <dimension ref="A1:G5"/> */
+int libo_xl_serial_to_epoch(double serial, int date1904, double *seconds)
+{
+  int64_t m = date1904 != 0;
 
-  *buf = strapp(*buf, "<dimension ref=\"A1:");
-  if (l->xl->book->sheet[sheet]->n_cols)
-    *buf = strapp(*buf, column_number_to_reference(l->xl->book->sheet[sheet]->n_cols-1));
-  else *buf = strapp(*buf, "A");
-  sprintf(number, "%d", l->xl->book->sheet[sheet]->n_rows);
-  *buf = strapp(*buf, number);
-  *buf = strapp(*buf, "\"/>\n");
+    // NaN fails both tests
+
+  if (!((serial >= 0) && (serial < (double)date_serial_max(m)))) return -1;
+
+  if (seconds) *seconds = (double)date_serial_to_epoch(llrint(serial * XL_DAY_MS), m) / 1000;
+
+  return 0;
 }
 
- /**
-  * @fn static void libo_xl_sheet_sheetviews_add(libo *l,
-  *                                                  int sheet,
-  *                                                  char **buf)
-  *
-  * @brief adds XL sheetviews information to XML buffer
-  *
-  * @param l - pointer to existing @a libo struct
-  * @param sheet - index of sheet in book
-  * @param buf - pointer to string holding XML buffer
-  *
-  * @par Returns
-  * Nothing.
-  */
+  /**
+   *  @fn int libo_xl_epoch_to_serial(double seconds,
+   *                                  int date1904,
+   *                                  double *serial)
+   *
+   *  @brief converts @p seconds since the epoch to an Excel serial date
+   *
+   *  @param seconds - seconds since 1970-01-01 00:00:00 UTC
+   *  @param date1904 - 1 for the 1904 date system, 0 for the 1900 one
+   *  @param serial - receives serial date, to the millisecond
+   *
+   *  @return 0 on success, -1 if @p seconds is NaN or falls outside the
+   *          serials of @a libo_xl_serial_to_epoch
+   */
 
-static void libo_xl_sheet_sheetviews_add(libo *l, int sheet, char **buf)
+int libo_xl_epoch_to_serial(double seconds, int date1904, double *serial)
 {
-  char number[25];
-  libo_xl_sheet *sht;
+  int64_t m = date1904 != 0;
+  double lo, hi;
 
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (sheet >= l->xl->book->n_sheets) return;
-  if (!buf) return;
+  lo = (double)date_serial_to_epoch(0, m) / 1000;
+  hi = (double)date_serial_to_epoch(date_serial_max(m) * XL_DAY_MS, m) / 1000;
+  if (!((seconds >= lo) && (seconds < hi))) return -1;
 
-  memset(number, 0, 25);
+  if (serial) *serial = (double)date_epoch_to_serial(llrint(seconds * 1000), m) / XL_DAY_MS;
 
-  sht = l->xl->book->sheet[sheet];
+  return 0;
+}
 
-  if (!sht->freeze.type) return;
+  /**
+   *  @fn int libo_xl_serials_to_epoch(const double *serial,
+   *                                    double *seconds,
+   *                                    size_t n,
+   *                                    int date1904)
+   *
+   *  @brief converts @p n Excel serial dates to seconds since the epoch,
+   *         as @a libo_xl_serial_to_epoch does
+   *
+   *  Serials that are NaN or out of range give NaN.
+   *
+   *  @param serial - serial dates
+   *  @param seconds - receives @p n times, may be @p serial
+   *  @param n - number of dates
+   *  @param date1904 - 1 for the 1904 date system, 0 for the 1900 one
+   *
+   *  @return 0 on success, -1 if any serial was NaN or out of range
+   */
 
-  *buf = strapp(*buf, "<sheetViews>\n");
-  *buf = strapp(*buf, "<sheetView tabSelected=\"1\" topLeftCell=\"A1\" workbookViewId=\"0\">\n");
-  *buf = strapp(*buf, "<pane ");
-  switch (sht->freeze.type)
+int libo_xl_serials_to_epoch(const double *serial, double *seconds, size_t n, int date1904)
+{
+  int64_t m = date1904 != 0;
+  double max = (double)date_serial_max(m);
+  double x;
+  int ok;
+  int bad = 0;
+  size_t i;
+
+  if (!serial || !seconds) return -1;
+
+    // serials out of range are converted as 0, then replaced, so the loop
+    // has no branch
+
+  for (i = 0; i < n; i++)
   {
-    case libo_xl_freeze_type_none: break;
-    case libo_xl_freeze_type_top:
-      *buf = strapp(*buf, "ySplit");
-      break;
-    case libo_xl_freeze_type_left: break;
-      *buf = strapp(*buf, "xSplit");
-      break;
+    ok = (serial[i] >= 0) & (serial[i] < max);
+    x = ok ? serial[i] : 0;
+    x = (double)date_serial_to_epoch(llrint(x * XL_DAY_MS), m) / 1000;
+    seconds[i] = ok ? x : NAN;
+    bad |= !ok;
   }
-  *buf = strapp(*buf, "=\"1\" topLeftCell=\"");
-  switch (sht->freeze.type)
+
+  return bad ? -1 : 0;
+}
+
+  /**
+   *  @fn int libo_xl_epochs_to_serial(const double *seconds,
+   *                                    double *serial,
+   *                                    size_t n,
+   *                                    int date1904)
+   *
+   *  @brief converts @p n times in seconds since the epoch to Excel serial
+   *         dates, as @a libo_xl_epoch_to_serial does
+   *
+   *  Times that are NaN or out of range give NaN.
+   *
+   *  @param seconds - seconds since 1970-01-01 00:00:00 UTC
+   *  @param serial - receives @p n serial dates, may be @p seconds
+   *  @param n - number of times
+   *  @param date1904 - 1 for the 1904 date system, 0 for the 1900 one
+   *
+   *  @return 0 on success, -1 if any time was NaN or out of range
+   */
+
+int libo_xl_epochs_to_serial(const double *seconds, double *serial, size_t n, int date1904)
+{
+  int64_t m = date1904 != 0;
+  double lo, hi;
+  double x;
+  int ok;
+  int bad = 0;
+  size_t i;
+
+  if (!seconds || !serial) return -1;
+
+  lo = (double)date_serial_to_epoch(0, m) / 1000;
+  hi = (double)date_serial_to_epoch(date_serial_max(m) * XL_DAY_MS, m) / 1000;
+
+  for (i = 0; i < n; i++)
   {
-    case libo_xl_freeze_type_none: break;
-    case libo_xl_freeze_type_top:
-      *buf = strapp(*buf, "A");
-      sprintf(number, "%d", sht->freeze.n + 1);
-      *buf = strapp(*buf, number);
-      break;
-    case libo_xl_freeze_type_left: break;
-      sprintf(number, "%c", sht->freeze.n + 'A');
-      *buf = strapp(*buf, number);
-      *buf = strapp(*buf, "1");
+    ok = (seconds[i] >= lo) & (seconds[i] < hi);
+    x = ok ? seconds[i] : 0;
+    x = (double)date_epoch_to_serial(llrint(x * 1000), m) / XL_DAY_MS;
+    serial[i] = ok ? x : NAN;
+    bad |= !ok;
+  }
+
+  return bad ? -1 : 0;
+}
+
+libo_xl *__xl__ = NULL ;  /**<  CHEAT -- short cut to parent @a libo_xl for various dumps  */
+
+  /**
+   *  @fn void libo_xl_dump(libo_xl *xl, FILE *stream, int indent)
+   *
+   *  @brief dumps contents of @p xl to @p stream, default is STDOUT
+   *
+   *  @param xl - pointer to existing @a libo_xl struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_dump(libo_xl *xl, FILE *stream, int indent)
+{
+  if (!xl) return;
+  if (!stream) return;
+
+  __xl__ = xl;
+
+  do_indent(stream, indent); fprintf(stream, "LIBO_XL:\n");
+  indent += 2;
+  if (xl->book) libo_xl_book_dump(xl->book, stream, indent);
+  if (xl->strings) libo_xl_strings_dump(xl->strings, stream, indent);
+  if (xl->styles) libo_xl_styles_dump(xl->styles, stream, indent);
+
+  return;
+}
+
+  /**
+   *  @fn void libo_doc_dump(libo_doc *doc, FILE *stream, int indent)
+   *
+   *  @brief dumps contents of @p doc to @p stream, default is STDOUT
+   *
+   *  @param doc - pointer to existing @a libo_doc struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_doc_dump(libo_doc *doc, FILE *stream, int indent)
+{
+  if (!doc) return;
+  if (!stream) return;
+
+  do_indent(stream, indent); fprintf(stream, "LIBO_DOC:\n");
+  return;
+}
+
+  /**
+   *  @fn void libo_pp_dump(libo_pp *pp, FILE *stream, int indent)
+   *
+   *  @brief dumps contents of @p pp to @p stream, default is STDOUT
+   *
+   *  @param pp - pointer to existing @a libo_pp struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_pp_dump(libo_pp *pp, FILE *stream, int indent)
+{
+  if (!pp) return;
+  if (!stream) return;
+
+  do_indent(stream, indent); fprintf(stream, "LIBO_PP:\n");
+  return;
+}
+
+  /**
+   *  @fn libo_xl_book *libo_xl_book_new(void)
+   *
+   *  @brief returns new @a libo_xl_book struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_book struct
+   */
+
+libo_xl_book *libo_xl_book_new(void)
+{
+  libo_xl_book *book;
+
+  book = (libo_xl_book *)malloc(sizeof(libo_xl_book));
+  if (!book) return NULL;
+  memset(book, 0, sizeof(libo_xl_book));
+
+  pthread_mutex_init(&book->lock, NULL);
+
+  return book;
+}
+
+  /**
+   *  @fn libo_xl_book *libo_xl_book_dup(libo_xl_book *book)
+   *
+   *  @brief creates a deep copy of @p book
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *
+   *  @return pointer to new @a libo_xl_book struct
+   */
+
+libo_xl_book *libo_xl_book_dup(libo_xl_book *book)
+{
+  libo_xl_book *nbook = NULL;
+  libo_xl_sheet *sheet;
+  libo_xl_sheet *copy;
+  int i;
+
+  if (!book) goto exit;
+
+  nbook = libo_xl_book_new();
+  if (!nbook) goto exit;
+
+  nbook->date1904 = book->date1904;
+
+    // copy evicted and spilled sheets without making them resident, so
+    // neither their state nor the clock of a shared book changes
+
+  pthread_mutex_lock(&book->lock);
+
+  for (i = 0; i < book->n_sheets; i++)
+  {
+    sheet = book->sheet[i];
+    if (!sheet) continue;
+
+    if (sheet->state == libo_xl_sheet_state_resident)
+    {
+      libo_xl_book_add(nbook, sheet);
+      continue;
+    }
+
+    copy = sheet_copy_rows(book, sheet);
+    if (!copy)
+    {
+      libo_xl_book_free(nbook);
+      nbook = NULL;
       break;
+    }
+
+    libo_xl_book_add(nbook, copy);
+    libo_xl_sheet_free(copy);
+  }
+
+  pthread_mutex_unlock(&book->lock);
+
+exit:
+  return nbook;
+}
+
+  /**
+   *  @fn void libo_xl_book_free(libo_xl_book *book)
+   *
+   *  @brief frees all memory allocated to @p book
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_book_free(libo_xl_book *book)
+{
+  int i;
+
+  if (!book) return;
+
+  for (i = 0; i < book->n_sheets; i++)
+    libo_xl_sheet_free(book->sheet[i]);
+
+  if (book->path) free(book->path);
+  libo_options_free(book->options);
+
+  pthread_mutex_destroy(&book->lock);
+
+  free(book);
+
+  return;
+}
+
+  /**
+   *  @fn void libo_xl_book_add(libo_xl_book *xlb, libo_xl_sheet *xls)
+   *
+   *  @brief add @p xls to @p xlb
+   *
+   *  @param xlb - pointer to existing @a libo_xl_book struct
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_book_add(libo_xl_book *xlb, libo_xl_sheet *xls)
+{
+  libo_xl_sheet **tmp = NULL;
+  char rid_str[128];
+
+  if (!xlb || !xls) return;
+
+  memset(rid_str, 0, 128);
+
+  tmp = realloc(xlb->sheet, sizeof(libo_xl_sheet *) * (xlb->n_sheets + 1));
+  if (!tmp) return;
+
+  xlb->sheet = tmp;
+
+  xlb->sheet[xlb->n_sheets] = libo_xl_sheet_dup(xls);
+
+  xlb->sheet[xlb->n_sheets]->ID = xlb->n_sheets + 1;
+
+  sprintf(rid_str, "rId%d", xlb->n_sheets + 4);
+  if (xlb->sheet[xlb->n_sheets]->rID)
+    free(xlb->sheet[xlb->n_sheets]->rID);
+  xlb->sheet[xlb->n_sheets]->rID = strdup(rid_str);
+
+  ++xlb->n_sheets;
+}
+
+  /**
+   *  @fn size_t libo_xl_book_memory_size(libo_xl_book *book)
+   *
+   *  @brief returns number of bytes of memory used by @p book
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *
+   *  @return approximate number of bytes allocated to @p book
+   */
+
+size_t libo_xl_book_memory_size(libo_xl_book *book)
+{
+  size_t bytes;
+  int i;
+
+  if (!book) return 0;
+
+  bytes = sizeof(libo_xl_book) + sizeof(libo_xl_sheet *) * book->n_sheets;
+
+  for (i = 0; i < book->n_sheets; i++)
+    bytes += libo_xl_sheet_memory_size(book->sheet[i]);
+
+  return bytes;
+}
+
+  /**
+   *  @fn size_t libo_xl_book_get_memory_budget(libo_xl_book *book)
+   *
+   *  @brief returns memory budget for resident work sheets of @p book
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *
+   *  @return maximum bytes of resident work sheets, 0 for no limit
+   */
+
+size_t libo_xl_book_get_memory_budget(libo_xl_book *book)
+{
+  if (!book) return 0;
+
+  return book->memory_budget;
+}
+
+  /**
+   *  @fn void libo_xl_book_set_memory_budget(libo_xl_book *book,
+   *                                          size_t budget)
+   *
+   *  @brief sets memory budget for resident work sheets of @p book
+   *
+   *  When the budget is exceeded, the least recently used sheets are
+   *  evicted.  Clean sheets drop their rows, and are reparsed from the
+   *  file on the next libo_xl_book_get_sheet().  Dirty sheets, or sheets
+   *  of a book not read from a file, are spilled to a temporary file.
+   *
+   *  NOTE:  Once a budget is set, a sheet pointer is only valid until the
+   *         next call of libo_xl_book_get_sheet() for another sheet.
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param budget - maximum bytes of resident work sheets, 0 for no limit
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_book_set_memory_budget(libo_xl_book *book, size_t budget)
+{
+  if (!book) return;
+
+  pthread_mutex_lock(&book->lock);
+
+  book->memory_budget = budget;
+  book_trim(book, NULL);
+
+  pthread_mutex_unlock(&book->lock);
+}
+
+  /**
+   *  @fn int libo_xl_book_get_date1904(libo_xl_book *book)
+   *
+   *  @brief returns date system of @p book
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *
+   *  @return 1 if serial dates of @p book count from 1904, 0 if from 1900
+   */
+
+int libo_xl_book_get_date1904(libo_xl_book *book)
+{
+  if (!book) return 0;
+
+  return book->date1904;
+}
+
+  /**
+   *  @fn void libo_xl_book_set_date1904(libo_xl_book *book, int date1904)
+   *
+   *  @brief sets date system of @p book
+   *
+   *  Serial numbers of date cells are kept as they are, so the dates they
+   *  show move by four years.
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param date1904 - 1 to count serial dates from 1904, 0 from 1900
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_book_set_date1904(libo_xl_book *book, int date1904)
+{
+  if (!book) return;
+
+  book->date1904 = date1904 ? 1 : 0;
+}
+
+  /**
+   *  @fn void libo_xl_book_trim(libo_xl_book *book, libo_xl_sheet *keep)
+   *
+   *  @brief evicts least recently used work sheets of @p book until it fits
+   *         its memory budget
+   *
+   *  Clean sheets are evicted before dirty sheets are spilled.
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param keep - pointer to sheet that must stay resident, or NULL
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_book_trim(libo_xl_book *book, libo_xl_sheet *keep)
+{
+  if (!book) return;
+
+  pthread_mutex_lock(&book->lock);
+  book_trim(book, keep);
+  pthread_mutex_unlock(&book->lock);
+}
+
+  /**
+   *  @fn static void book_trim(libo_xl_book *book, libo_xl_sheet *keep)
+   *
+   *  @brief evicts least recently used work sheets of @p book until it fits
+   *         its memory budget
+   *
+   *  NOTE:  caller must hold lock of @p book
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param keep - pointer to sheet that must stay resident, or NULL
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void book_trim(libo_xl_book *book, libo_xl_sheet *keep)
+{
+  libo_xl_sheet *sheet;
+  libo_xl_sheet *victim;
+  size_t total = 0;
+  int clean;
+  int i;
+
+  if (!book) return;
+  if (!book->memory_budget) return;
+
+  for (i = 0; i < book->n_sheets; i++)
+  {
+    sheet = book->sheet[i];
+    if (!sheet) continue;
+    if (sheet->state != libo_xl_sheet_state_resident) continue;
+
+    if (sheet->dirty || !sheet->bytes)
+      sheet->bytes = libo_xl_sheet_memory_size(sheet);
+
+    total += sheet->bytes;
+  }
+
+  while (total > book->memory_budget)
+  {
+    victim = NULL;
+    clean = 0;
+
+    for (i = 0; i < book->n_sheets; i++)
+    {
+      sheet = book->sheet[i];
+      if (!sheet || (sheet == keep)) continue;
+      if (sheet->state != libo_xl_sheet_state_resident) continue;
+      if (!sheet->row) continue;
+
+      if (!sheet->dirty && book->path)
+      {
+        if (!clean || (sheet->used < victim->used)) victim = sheet;
+        clean = 1;
+      }
+      else if (!clean && (!victim || (sheet->used < victim->used)))
+        victim = sheet;
+    }
+
+    if (!victim) break;
+
+    total -= victim->bytes;
+
+    if (libo_xl_sheet_evict(book, victim)) break;
+  }
+
+  return;
+}
+
+  /**
+   *  @fn libo_xl_sheet *libo_xl_sheet_new(void)
+   *
+   *  @brief returns new @a libo_xl_sheet struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_sheet struct
+   */
+
+libo_xl_sheet *libo_xl_sheet_new(void)
+{
+  libo_xl_sheet *sheet;
+
+  sheet = (libo_xl_sheet *)malloc(sizeof(libo_xl_sheet));
+  if (!sheet) return NULL;
+  memset(sheet, 0, sizeof(libo_xl_sheet));
+
+  sheet->default_row_height = 14.4;
+
+  return sheet;
+}
+
+  /**
+   *  @fn libo_xl_sheet *libo_xl_sheet_dup(libo_xl_sheet *sheet)
+   *
+   *  @brief makes deep copy of @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xml_sheet struct
+   *
+   *  @return pointer to new @a libo_xl_sheet struct
+   */
+
+libo_xl_sheet *libo_xl_sheet_dup(libo_xl_sheet *sheet)
+{
+  libo_xl_sheet *nsheet = NULL;
+  int i;
+
+  if (!sheet) goto exit;
+
+  nsheet = libo_xl_sheet_new();
+  if (!nsheet) goto exit;
+
+  nsheet->n_cols = sheet->n_cols;
+  nsheet->default_row_height = sheet->default_row_height;
+
+  if (sheet->name) nsheet->name = strdup(sheet->name);
+
+  if (sheet->source)
+  {
+    nsheet->source = (int *)malloc(sizeof(int) * sheet->n_sources);
+    if (nsheet->source)
+    {
+      memcpy(nsheet->source, sheet->source, sizeof(int) * sheet->n_sources);
+      nsheet->n_sources = sheet->n_sources;
+    }
+  }
+
+  if (sheet->n_shared)
+  {
+    nsheet->shared = (char **)malloc(sizeof(char *) * sheet->n_shared);
+    if (nsheet->shared)
+    {
+      for (i = 0; i < sheet->n_shared; i++)
+        if (!(nsheet->shared[i] = strdup(sheet->shared[i]))) break;
+      nsheet->n_shared = i;
+    }
+  }
+
+  if (sheet->dates)
+  {
+    nsheet->dates = (unsigned char *)malloc(sheet->n_dates);
+    if (nsheet->dates)
+    {
+      memcpy(nsheet->dates, sheet->dates, sheet->n_dates);
+      nsheet->n_dates = sheet->n_dates;
+    }
+  }
+
+  for (i = 0; i < sheet->n_rows; i++)
+    libo_xl_sheet_add(nsheet, libo_xl_sheet_get_row(sheet, i));
+
+exit:
+  return nsheet;
+}
+
+  /**
+   *  @fn void libo_xl_sheet_free(libo_xl_sheet *sheet)
+   *
+   *  @brief frees all memory allocated to @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sheet_free(libo_xl_sheet *sheet)
+{
+  int i;
+
+  if (!sheet) return;
+
+  if (sheet->row)
+  {
+    for (i = 0; i < sheet->n_rows; i++)
+      libo_xl_row_free(sheet->row[i]);
+    free(sheet->row);
+  }
+
+  if (sheet->spill) fclose(sheet->spill);
+
+  libo_xl_store_free(sheet->store);
+
+  libo_xl_sheet_profiles_free(sheet);
+
+  libo_xl_sort_free(sheet->sort);
+
+  libo_xl_view_free(sheet->visible);
+
+  free(sheet->source);
+
+  seek_index_free(sheet->seek);
+
+  sheet_shared_free(sheet);
+
+  free(sheet->dates);
+
+  free(sheet);
+
+  return;
+}
+
+  /**
+   *  @fn void libo_xl_sheet_set_name(libo_xl_sheet *xls, char *name);
+   *
+   *  @brief sets name value for @p xls to @p name
+   *
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @param name - string containing new name value
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sheet_set_name(libo_xl_sheet *xls, char *name)
+{
+  if (!xls) return;
+
+  if (xls->name) free(xls->name);
+  xls->name = NULL;
+  if (name) xls->name = strdup(name);
+}
+
+  /**
+   *  @fn void libo_xl_sheet_set_id(libo_xl_sheet *xls, int id)
+   *
+   *  @brief sets ID value for @p xls to @p id
+   *
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @param id - string containing new ID value
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sheet_set_id(libo_xl_sheet *xls, int id)
+{
+  if (!xls) return;
+
+  xls->ID = id;
+}
+
+  /**
+   *  @fn void libo_xl_sheet_set_rid(libo_xl_sheet *xls, char *rid)
+   *
+   *  @brief sets rID value for @p xls to @p rid
+   *
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @param rid - string containing new rID value
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sheet_set_rid(libo_xl_sheet *xls, char *rid)
+{
+  if (!xls) return;
+
+  if (xls->rID) free(xls->rID);
+  xls->rID = NULL;
+  if (rid) xls->rID = strdup(rid);
+}
+
+  /**
+   *  @fn void libo_xl_sheet_add(libo_xl_sheet *xls, libo_xl_row *xlr)
+   *
+   *  @brief add @p xlr to @p xls
+   *
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @param xlr - pointer to existing @a libo_xl_row struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sheet_add(libo_xl_sheet *xls, libo_xl_row *xlr)
+{
+  libo_xl_row **tmp = NULL;
+
+  if (!xls || !xlr) return;
+
+  if (xls->store)
+  {
+    if (libo_xl_store_append(xls->store, xlr)) return;
+
+    if (xlr->n_cells > xls->n_cols) xls->n_cols = xlr->n_cells;
+
+    ++xls->n_rows;
+    ++xls->version;
+    xls->dirty = 1;
+
+    return;
+  }
+
+  tmp = realloc(xls->row, sizeof(libo_xl_row *) * (xls->n_rows + 1));
+  if (!tmp) return;
+
+  xls->row = tmp;
+
+  xls->row[xls->n_rows] = libo_xl_row_dup(xlr);
+
+  ++xls->n_rows;
+  ++xls->version;
+  xls->dirty = 1;
+}
+
+  /**
+   *  @fn int libo_xl_sheet_append_matrix(libo_xl_sheet *sheet,
+   *                                      const double *data,
+   *                                      int rows,
+   *                                      int cols,
+   *                                      size_t stride)
+   *
+   *  @brief appends a row major matrix of numbers to @p sheet
+   *
+   *  Each row of @p data becomes a row of @p sheet, without building and
+   *  copying a row and cells for each through @a libo_xl_sheet_add.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param data - @p rows rows of @p cols numbers
+   *  @param rows - number of rows in @p data
+   *  @param cols - number of columns in @p data
+   *  @param stride - elements from the start of one row to the next, 0 if
+   *                  rows are packed
+   *
+   *  @return 0 on success, -1 on error
+   */
+
+int libo_xl_sheet_append_matrix(libo_xl_sheet *sheet,
+                                const double *data,
+                                int rows,
+                                int cols,
+                                size_t stride)
+{
+  return sheet_append_matrix(sheet, libo_xl_field_double, data, rows, cols, stride);
+}
+
+  /**
+   *  @fn int libo_xl_sheet_append_matrix_int64(libo_xl_sheet *sheet,
+   *                                            const int64_t *data,
+   *                                            int rows,
+   *                                            int cols,
+   *                                            size_t stride)
+   *
+   *  @brief appends a row major matrix of integers to @p sheet, as numbers
+   *
+   *  Cells hold doubles, so every integer must lie within +/-2^53, where
+   *  each is held exactly.  Otherwise nothing is appended.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param data - @p rows rows of @p cols integers
+   *  @param rows - number of rows in @p data
+   *  @param cols - number of columns in @p data
+   *  @param stride - elements from the start of one row to the next, 0 if
+   *                  rows are packed
+   *
+   *  @return 0 on success, -1 on error or for an integer out of range
+   */
+
+int libo_xl_sheet_append_matrix_int64(libo_xl_sheet *sheet,
+                                      const int64_t *data,
+                                      int rows,
+                                      int cols,
+                                      size_t stride)
+{
+  if (matrix_check(NULL, libo_xl_field_int64, data, rows, cols, stride)) return -1;
+
+  return sheet_append_matrix(sheet, libo_xl_field_int64, data, rows, cols, stride);
+}
+
+  /**
+   *  @fn int libo_xl_sheet_append_matrix_strings(libo_xl *xl,
+   *                                              libo_xl_sheet *sheet,
+   *                                              const int *data,
+   *                                              int rows,
+   *                                              int cols,
+   *                                              size_t stride)
+   *
+   *  @brief appends a row major matrix of shared string ids to @p sheet
+   *
+   *  Every id must be in the string dictionary of @p xl, or nothing is
+   *  appended.
+   *
+   *  @param xl - pointer to existing @a libo_xl owning @p sheet
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param data - @p rows rows of @p cols string ids
+   *  @param rows - number of rows in @p data
+   *  @param cols - number of columns in @p data
+   *  @param stride - elements from the start of one row to the next, 0 if
+   *                  rows are packed
+   *
+   *  @return 0 on success, -1 on error or for an id not in @p xl
+   */
+
+int libo_xl_sheet_append_matrix_strings(libo_xl *xl,
+                                        libo_xl_sheet *sheet,
+                                        const int *data,
+                                        int rows,
+                                        int cols,
+                                        size_t stride)
+{
+  if (!xl || !xl->strings) return -1;
+  if (matrix_check(xl, libo_xl_field_string_id, data, rows, cols, stride)) return -1;
+
+  return sheet_append_matrix(sheet, libo_xl_field_string_id, data, rows, cols, stride);
+}
+
+  /**
+   *  @fn size_t libo_xl_sheet_memory_size(libo_xl_sheet *sheet)
+   *
+   *  @brief returns number of bytes of memory used by @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return approximate number of bytes allocated to @p sheet
+   */
+
+size_t libo_xl_sheet_memory_size(libo_xl_sheet *sheet)
+{
+  size_t bytes;
+  int i;
+
+  if (!sheet) return 0;
+
+  bytes = sizeof(libo_xl_sheet);
+  if (sheet->name) bytes += strlen(sheet->name) + 1;
+  if (sheet->rID) bytes += strlen(sheet->rID) + 1;
+  if (sheet->filter) bytes += sizeof(libo_xl_filter);
+  if (sheet->column)
+    bytes += (sizeof(libo_xl_column *) + sizeof(libo_xl_column)) * sheet->n_cols;
+
+  if (sheet->row)
+  {
+    bytes += sizeof(libo_xl_row *) * sheet->n_rows;
+    for (i = 0; i < sheet->n_rows; i++)
+      bytes += libo_xl_row_memory_size(sheet->row[i]);
+  }
+
+  bytes += libo_xl_store_memory_size(sheet->store);
+  bytes += seek_index_memory_size(sheet->seek);
+
+  bytes += sizeof(char *) * sheet->n_shared;
+  for (i = 0; i < sheet->n_shared; i++)
+    bytes += strlen(sheet->shared[i]) + 1;
+
+  bytes += sheet->n_dates;
+
+  if (sheet->profile)
+    bytes += (sizeof(libo_xl_column_profile *) + sizeof(libo_xl_column_profile)) * sheet->n_profiles;
+
+  return bytes;
+}
+
+  /**
+   *  @fn libo_xl_sheet_state libo_xl_sheet_get_state(libo_xl_sheet *sheet)
+   *
+   *  @brief returns residency of rows of @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return @a libo_xl_sheet_state
+   */
+
+libo_xl_sheet_state libo_xl_sheet_get_state(libo_xl_sheet *sheet)
+{
+  if (!sheet) return libo_xl_sheet_state_resident;
+
+  return sheet->state;
+}
+
+  /**
+   *  @fn int libo_xl_sheet_get_dirty(libo_xl_sheet *sheet)
+   *
+   *  @brief returns whether @p sheet changed since it was read
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return 1 if changed, 0 otherwise
+   */
+
+int libo_xl_sheet_get_dirty(libo_xl_sheet *sheet)
+{
+  if (!sheet) return 0;
+
+  return sheet->dirty;
+}
+
+  /**
+   *  @fn void libo_xl_sheet_set_dirty(libo_xl_sheet *sheet, int dirty)
+   *
+   *  @brief marks @p sheet as changed, or unchanged, since it was read
+   *
+   *  Changing cells directly through @a libo_xl_cell functions does not
+   *  mark the sheet dirty.  Callers doing so on a book with a memory
+   *  budget must call this, or the changes may be lost on eviction, and
+   *  indexes over the sheet will not see the changes.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param dirty - 1 if changed, 0 otherwise
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sheet_set_dirty(libo_xl_sheet *sheet, int dirty)
+{
+  if (!sheet) return;
+
+  if (dirty) ++sheet->version;
+
+  sheet->dirty = dirty ? 1 : 0;
+}
+
+  /**
+   *  @fn libo_xl_storage libo_xl_sheet_get_storage(libo_xl_sheet *sheet)
+   *
+   *  @brief returns where rows of @p sheet are kept
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return @a libo_xl_storage
+   */
+
+libo_xl_storage libo_xl_sheet_get_storage(libo_xl_sheet *sheet)
+{
+  if (!sheet) return libo_xl_storage_memory;
+
+  return sheet->store ? sheet->store->type : libo_xl_storage_memory;
+}
+
+  /**
+   *  @fn int libo_xl_sheet_set_storage(libo_xl_sheet *sheet,
+   *                                    libo_xl_storage storage)
+   *
+   *  @brief moves rows of @p sheet into memory, out to a temporary file,
+   *         into compressed blocks, or into encoded columns
+   *
+   *  Rows returned by @a libo_xl_sheet_get_row for a sheet on disk,
+   *  compressed or columnar are decoded copies, shared by a small per
+   *  thread cache.  Changes made to them are not kept, so
+   *  @a libo_xl_cell_create moves a sheet back into memory.
+   *
+   *  @param sheet - pointer to resident @a libo_xl_sheet struct
+   *  @param storage - @a libo_xl_storage
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_sheet_set_storage(libo_xl_sheet *sheet, libo_xl_storage storage)
+{
+  libo_xl_store *store;
+  libo_xl_row **rows;
+  int i;
+
+  if (!sheet) return -1;
+  if (sheet->state != libo_xl_sheet_state_resident) return -1;
+
+  if (libo_xl_sheet_get_storage(sheet) == storage) return 0;
+
+    // rows move between stores by way of memory
+
+  if (sheet->store && (storage != libo_xl_storage_memory))
+    if (libo_xl_sheet_set_storage(sheet, libo_xl_storage_memory)) return -1;
+
+  switch (storage)
+  {
+    case libo_xl_storage_disk:
+    case libo_xl_storage_compressed:
+    case libo_xl_storage_columnar:
+      libo_xl_sheet_count_columns(sheet);
+
+      store = libo_xl_store_new(storage);
+      if (!store) return -1;
+
+      for (i = 0; i < sheet->n_rows; i++)
+      {
+        if (libo_xl_store_append(store, sheet->row[i]))
+        {
+          libo_xl_store_free(store);
+          return -1;
+        }
+      }
+
+      if (sheet->row)
+      {
+        for (i = 0; i < sheet->n_rows; i++)
+          libo_xl_row_free(sheet->row[i]);
+        free(sheet->row);
+        sheet->row = NULL;
+      }
+
+      sheet->store = store;
+      break;
+
+    case libo_xl_storage_memory:
+      rows = (libo_xl_row **)malloc(sizeof(libo_xl_row *) * (sheet->n_rows ? sheet->n_rows : 1));
+      if (!rows) return -1;
+
+      for (i = 0; i < sheet->n_rows; i++)
+        rows[i] = libo_xl_row_dup(libo_xl_store_get_row(sheet->store, i));
+
+      libo_xl_store_free(sheet->store);
+      sheet->store = NULL;
+      sheet->row = rows;
+      break;
+  }
+
+  sheet->bytes = libo_xl_sheet_memory_size(sheet);
+
+  return 0;
+}
+
+  /**
+   *  @fn libo_xl_encoding libo_xl_sheet_get_column_encoding(libo_xl_sheet *sheet,
+   *                                                        int col)
+   *
+   *  @brief returns encoding of column @p col of columnar @p sheet
+   *
+   *  Encodings are chosen per group of rows as the sheet is loaded, this
+   *  returns the one of the first group.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *
+   *  @return @a libo_xl_encoding, @a libo_xl_encoding_none if @p sheet is
+   *          not columnar
+   */
+
+libo_xl_encoding libo_xl_sheet_get_column_encoding(libo_xl_sheet *sheet, int col)
+{
+  libo_xl_store *store;
+  libo_xl_encoding encoding = libo_xl_encoding_none;
+
+  if (!sheet || (col < 0)) return libo_xl_encoding_none;
+
+  store = sheet->store;
+  if (!store || (store->type != libo_xl_storage_columnar))
+    return libo_xl_encoding_none;
+
+  pthread_mutex_lock(&store->lock);
+
+  libo_xl_store_flush(store);
+
+  if (store->n_blocks && (col < store->block[0].n_chunks))
+  {
+    if (store->block[0].chunk[col].kind == chunk_kind_cells)
+      encoding = libo_xl_encoding_plain;
+    else
+      encoding = store->block[0].chunk[col].encoding;
+  }
+
+  pthread_mutex_unlock(&store->lock);
+
+  return encoding;
+}
+
+  /**
+   *  @fn libo_xl_column_type libo_xl_sheet_get_column_type(libo_xl_sheet *sheet,
+   *                                                       int col)
+   *
+   *  @brief returns dominant type of cells in column @p col of @p sheet
+   *
+   *  Columnar sheets infer the type of each group of rows as they are
+   *  loaded, and keep cells of it as typed arrays, with the few others
+   *  aside.  The column has a type when every group agrees, whole numbers
+   *  widening to numbers.  Other sheets are tallied on request.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *
+   *  @return @a libo_xl_column_type
+   */
+
+libo_xl_column_type libo_xl_sheet_get_column_type(libo_xl_sheet *sheet, int col)
+{
+  libo_xl_store *store;
+  column_census census;
+  libo_xl_cell *cell;
+  chunk_kind kind = chunk_kind_cells;
+  chunk_kind k;
+  int i;
+
+  if (!sheet || (col < 0)) return libo_xl_column_type_mixed;
+
+  store = sheet->store;
+
+  if (store && (store->type == libo_xl_storage_columnar))
+  {
+    pthread_mutex_lock(&store->lock);
+
+    libo_xl_store_flush(store);
+
+    for (i = 0; i < store->n_blocks; i++)
+    {
+      if (col >= store->block[i].n_chunks) continue;
+
+      k = store->block[i].chunk[col].kind;
+      if (!i || (kind == k))
+        kind = k;
+      else if (((kind == chunk_kind_number) || (kind == chunk_kind_integer)) &&
+               ((k == chunk_kind_number) || (k == chunk_kind_integer)))
+        kind = chunk_kind_number;
+      else
+      {
+        kind = chunk_kind_cells;
+        break;
+      }
+    }
+
+    pthread_mutex_unlock(&store->lock);
+  }
+  else
+  {
+    memset(&census, 0, sizeof(column_census));
+
+    for (i = 0; i < sheet->n_rows; i++)
+    {
+      cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), col);
+      if (cell) column_census_add(&census, cell);
+    }
+
+    if (census.n) kind = column_census_kind(&census);
+  }
+
+  switch (kind)
+  {
+    case chunk_kind_integer: return libo_xl_column_type_integer;
+    case chunk_kind_number: return libo_xl_column_type_number;
+    case chunk_kind_reference: return libo_xl_column_type_reference;
+    case chunk_kind_boolean: return libo_xl_column_type_boolean;
+    case chunk_kind_error: return libo_xl_column_type_error;
+    case chunk_kind_cells:
+    default:
+      return libo_xl_column_type_mixed;
+  }
+}
+
+  /**
+   *  @fn long libo_xl_sheet_column_read_numbers(libo_xl_sheet *sheet,
+   *                                             int col,
+   *                                             int first_row,
+   *                                             int last_row,
+   *                                             double *out)
+   *
+   *  @brief copies numbers in column @p col of @p sheet, from row
+   *         @p first_row to row @p last_row, into @p out
+   *
+   *  Columnar sheets copy straight from their typed arrays, without
+   *  building rows.  Cells that are not numbers are skipped.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *  @param first_row - index of first row
+   *  @param last_row - index of last row, inclusive
+   *  @param out - room for a number from each row
+   *
+   *  @return number of numbers copied, -1 on failure
+   */
+
+long libo_xl_sheet_column_read_numbers(libo_xl_sheet *sheet,
+                                       int col,
+                                       int first_row,
+                                       int last_row,
+                                       double *out)
+{
+  libo_xl_store *store;
+  store_block *block;
+  libo_xl_cell *cell;
+  long n = 0;
+  int i;
+
+  if (!sheet || !out || (col < 0)) return -1;
+
+  if (first_row < 0) first_row = 0;
+  if (last_row >= sheet->n_rows) last_row = sheet->n_rows - 1;
+  if (last_row < first_row) return 0;
+
+  store = sheet->store;
+
+  if (store && (store->type == libo_xl_storage_columnar))
+  {
+    pthread_mutex_lock(&store->lock);
+
+    libo_xl_store_flush(store);
+
+    for (i = 0; i < store->n_blocks; i++)
+    {
+      block = &store->block[i];
+      if (block->first_row + block->n_rows <= first_row) continue;
+      if (block->first_row > last_row) break;
+
+      n += column_block_numbers(block,
+                                col,
+                                first_row - block->first_row,
+                                last_row - block->first_row,
+                                out + n);
+    }
+
+    pthread_mutex_unlock(&store->lock);
+
+    return n;
+  }
+
+  for (i = first_row; i <= last_row; i++)
+  {
+    cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), col);
+    if (cell_is_number(cell))
+      out[n++] = cell->number;
+  }
+
+  return n;
+}
+
+  /**
+   *  @fn long libo_xl_sheet_column_read_dates(libo_xl_sheet *sheet,
+   *                                           int col,
+   *                                           int first_row,
+   *                                           int last_row,
+   *                                           int date1904,
+   *                                           double *out)
+   *
+   *  @brief copies numbers in column @p col of @p sheet, from row
+   *         @p first_row to row @p last_row, into @p out as seconds since
+   *         1970-01-01
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *  @param first_row - index of first row
+   *  @param last_row - index of last row, inclusive
+   *  @param date1904 - 1 if serial dates count from 1904, 0 if from 1900
+   *  @param out - room for a number from each row
+   *
+   *  @return number of dates copied, numbers outside the dates Excel shows
+   *          giving NaN, -1 on failure
+   */
+
+long libo_xl_sheet_column_read_dates(libo_xl_sheet *sheet,
+                                     int col,
+                                     int first_row,
+                                     int last_row,
+                                     int date1904,
+                                     double *out)
+{
+  long n;
+
+  n = libo_xl_sheet_column_read_numbers(sheet, col, first_row, last_row, out);
+  if (n > 0) libo_xl_serials_to_epoch(out, out, (size_t)n, date1904);
+
+  return n;
+}
+
+  /**
+   *  @fn long libo_xl_sheet_column_count_range(libo_xl_sheet *sheet,
+   *                                            int col,
+   *                                            double lo,
+   *                                            double hi)
+   *
+   *  @brief counts numbers in column @p col of @p sheet from @p lo to @p hi
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *  @param lo - lowest number counted
+   *  @param hi - highest number counted
+   *
+   *  @return number of cells
+   */
+
+long libo_xl_sheet_column_count_range(libo_xl_sheet *sheet,
+                                      int col,
+                                      double lo,
+                                      double hi)
+{
+  column_predicate pred;
+
+  memset(&pred, 0, sizeof(column_predicate));
+  pred.type = libo_xl_cell_type_number;
+  pred.lo = lo;
+  pred.hi = hi;
+
+  return libo_xl_sheet_column_scan(sheet, col, &pred, NULL);
+}
+
+  /**
+   *  @fn long libo_xl_sheet_column_count_reference(libo_xl_sheet *sheet,
+   *                                                int col,
+   *                                                int reference)
+   *
+   *  @brief counts cells in column @p col of @p sheet holding shared string
+   *         @p reference
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *  @param reference - index of shared string
+   *
+   *  @return number of cells
+   */
+
+long libo_xl_sheet_column_count_reference(libo_xl_sheet *sheet,
+                                          int col,
+                                          int reference)
+{
+  column_predicate pred;
+
+  memset(&pred, 0, sizeof(column_predicate));
+  pred.type = libo_xl_cell_type_reference;
+  pred.reference = reference;
+
+  return libo_xl_sheet_column_scan(sheet, col, &pred, NULL);
+}
+
+  /**
+   *  @fn double libo_xl_sheet_column_sum(libo_xl_sheet *sheet, int col)
+   *
+   *  @brief returns sum of numbers in column @p col of @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *
+   *  @return sum of numbers
+   */
+
+double libo_xl_sheet_column_sum(libo_xl_sheet *sheet, int col)
+{
+  double sum = 0;
+
+  libo_xl_sheet_column_scan(sheet, col, NULL, &sum);
+
+  return sum;
+}
+
+  /**
+   *  @fn int libo_xl_sheet_column_stats(libo_xl_sheet *sheet,
+   *                                     int col,
+   *                                     libo_xl_column_stats *out)
+   *
+   *  @brief computes aggregates of numbers in column @p col of @p sheet
+   *
+   *  Cells that are not numbers are skipped.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *  @param out - pointer to @a libo_xl_column_stats struct to fill
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_sheet_column_stats(libo_xl_sheet *sheet,
+                               int col,
+                               libo_xl_column_stats *out)
+{
+  if (!sheet) return -1;
+
+  return libo_xl_sheet_column_stats_range(sheet, col, 0, sheet->n_rows - 1, out);
+}
+
+  /**
+   *  @fn int libo_xl_sheet_column_stats_range(libo_xl_sheet *sheet,
+   *                                           int col,
+   *                                           int first_row,
+   *                                           int last_row,
+   *                                           libo_xl_column_stats *out)
+   *
+   *  @brief computes aggregates of numbers in column @p col of @p sheet,
+   *         from row @p first_row to row @p last_row
+   *
+   *  Numbers are gathered a group of rows at a time into a contiguous
+   *  array, which is handed to the fastest kernel the processor supports.
+   *  Columnar sheets are gathered straight from their encoded columns.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *  @param first_row - index of first row
+   *  @param last_row - index of last row, inclusive
+   *  @param out - pointer to @a libo_xl_column_stats struct to fill
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_sheet_column_stats_range(libo_xl_sheet *sheet,
+                                     int col,
+                                     int first_row,
+                                     int last_row,
+                                     libo_xl_column_stats *out)
+{
+  libo_xl_store *store;
+  store_block *block;
+  libo_xl_cell *cell;
+  double *values;
+  int n = 0;
+  int i;
+
+  if (!sheet || !out || (col < 0)) return -1;
+
+  memset(out, 0, sizeof(libo_xl_column_stats));
+
+  if (first_row < 0) first_row = 0;
+  if (last_row >= sheet->n_rows) last_row = sheet->n_rows - 1;
+  if (last_row < first_row) return 0;
+
+  values = (double *)malloc(sizeof(double) * LIBO_XL_STORE_GROUP);
+  if (!values) return -1;
+
+  store = sheet->store;
+
+  if (store && (store->type == libo_xl_storage_columnar))
+  {
+    pthread_mutex_lock(&store->lock);
+
+    libo_xl_store_flush(store);
+
+    for (i = 0; i < store->n_blocks; i++)
+    {
+      block = &store->block[i];
+      if (block->first_row + block->n_rows <= first_row) continue;
+      if (block->first_row > last_row) break;
+
+      n = column_block_numbers(block,
+                               col,
+                               first_row - block->first_row,
+                               last_row - block->first_row,
+                               values);
+      column_stats_add(out, values, n);
+    }
+
+    pthread_mutex_unlock(&store->lock);
+  }
+  else
+  {
+    for (i = first_row; i <= last_row; i++)
+    {
+      cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), col);
+      if (!cell_is_number(cell)) continue;
+
+      values[n++] = cell->number;
+      if (n == LIBO_XL_STORE_GROUP)
+      {
+        column_stats_add(out, values, n);
+        n = 0;
+      }
+    }
+
+    column_stats_add(out, values, n);
+  }
+
+  free(values);
+
+  column_stats_finish(out);
+
+  return 0;
+}
+
+  /**
+   *  @fn void libo_xl_column_stats_compute(const double *values,
+   *                                        size_t n,
+   *                                        libo_xl_column_stats *out)
+   *
+   *  @brief computes aggregates of @p n numbers in contiguous @p values
+   *
+   *  @param values - array of numbers
+   *  @param n - number of @p values
+   *  @param out - pointer to @a libo_xl_column_stats struct to fill
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_column_stats_compute(const double *values,
+                                  size_t n,
+                                  libo_xl_column_stats *out)
+{
+  if (!out) return;
+
+  memset(out, 0, sizeof(libo_xl_column_stats));
+
+  if (values) column_stats_add(out, values, n);
+
+  column_stats_finish(out);
+}
+
+  /**
+   *  @fn int libo_xl_sheet_get_column_profile_count(libo_xl_sheet *sheet)
+   *
+   *  @brief returns number of column profiles gathered for @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return number of column profiles, 0 if columns were not profiled
+   */
+
+int libo_xl_sheet_get_column_profile_count(libo_xl_sheet *sheet)
+{
+  if (!sheet) return 0;
+
+  return sheet->n_profiles;
+}
+
+  /**
+   *  @fn libo_xl_column_profile *libo_xl_sheet_get_column_profile(
+   *                                 libo_xl_sheet *sheet,
+   *                                 int col)
+   *
+   *  @brief returns profile of column @p col of @p sheet
+   *
+   *  Profiles describe the sheet as it was read, and are not updated as
+   *  cells change.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *
+   *  @return pointer to @a libo_xl_column_profile struct owned by @p sheet,
+   *          NULL if columns were not profiled
+   */
+
+libo_xl_column_profile *libo_xl_sheet_get_column_profile(libo_xl_sheet *sheet,
+                                                         int col)
+{
+  if (!sheet || !sheet->profile) return NULL;
+  if ((col < 0) || (col >= sheet->n_profiles)) return NULL;
+
+  return sheet->profile[col];
+}
+
+  /**
+   *  @fn libo_xl_row *libo_xl_row_new(void)
+   *
+   *  @brief returns new @a libo_xl_row struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_row struct
+   */
+
+libo_xl_row *libo_xl_row_new(void)
+{
+  libo_xl_row *row;
+
+  row = (libo_xl_row *)malloc(sizeof(libo_xl_row));
+  if (!row) return NULL;
+  memset(row, 0, sizeof(libo_xl_row));
+
+  return row;
+}
+
+  /**
+   *  @fn libo_xl_row *libo_xl_row_dup(libo_xl_row *row)
+   *
+   *  @brief returns deep copy of @p row
+   *
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *
+   *  @return pointer to new @a libo_xl_row struct
+   */
+
+libo_xl_row *libo_xl_row_dup(libo_xl_row *row)
+{
+  libo_xl_row *nrow = NULL;
+  int i;
+
+  if (!row) goto exit;
+
+  nrow = libo_xl_row_new();
+  if (!nrow) goto exit;
+
+  for (i = 0; i < row->n_cells; i++)
+    libo_xl_row_add(nrow, row->cell[i]);
+
+exit:
+  return nrow;
+}
+
+  /**
+   *  @fn void libo_xl_row_free(libo_xl_row *row)
+   *
+   *  @brief frees all memory allocated to @p row
+   *
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_row_free(libo_xl_row *row)
+{
+  int i;
+
+  if (!row) return;
+
+  for (i = 0; i < row->n_cells; i++)
+    libo_xl_cell_free(row->cell[i]);
+
+  free(row->cell);
+  free(row);
+
+  return;
+}
+
+  /**
+   *  @fn void libo_xl_row_add(libo_xl_row *xlr, libo_xl_cell *xlc)
+   *
+   *  @brief add @p xlc to @p xlr
+   *
+   *  @param xlr - pointer to existing @a libo_xl_row struct
+   *  @param xlc - pointer to existing @a libo_xl_cell struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_row_add(libo_xl_row *xlr, libo_xl_cell *xlc)
+{
+  libo_xl_cell **tmp = NULL;
+
+  if (!xlr || !xlc) return;
+
+  tmp = realloc(xlr->cell, sizeof(libo_xl_cell *) * (xlr->n_cells + 1));
+  if (!tmp) return;
+
+  xlr->cell = tmp;
+
+  xlr->cell[xlr->n_cells] = libo_xl_cell_dup(xlc);
+
+  ++xlr->n_cells;
+}
+
+  /**
+   *  @fn size_t libo_xl_row_memory_size(libo_xl_row *row)
+   *
+   *  @brief returns number of bytes of memory used by @p row
+   *
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *
+   *  @return approximate number of bytes allocated to @p row
+   */
+
+size_t libo_xl_row_memory_size(libo_xl_row *row)
+{
+  size_t bytes;
+  int i;
+
+  if (!row) return 0;
+
+  bytes = sizeof(libo_xl_row) + sizeof(libo_xl_cell *) * row->n_cells;
+
+  for (i = 0; i < row->n_cells; i++)
+    bytes += libo_xl_cell_memory_size(row->cell[i]);
+
+  return bytes;
+}
+
+  /**
+   *  @fn libo_xl_cell *libo_xl_cell_new(void)
+   *
+   *  @brief returns new @a libo_xl_cell struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_cell struct
+   */
+
+libo_xl_cell *libo_xl_cell_new(void)
+{
+  libo_xl_cell *cell;
+
+  cell = (libo_xl_cell *)malloc(sizeof(libo_xl_cell));
+  if (cell) memset(cell, 0, sizeof(libo_xl_cell));
+
+  return cell;
+}
+
+  /**
+   *  @fn libo_xl_cell *libo_xl_cell_dup(libo_xl_cell *cell)
+   *
+   *  @brief returns deep copy of @p cell
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *
+   *  @return pointer to new @a libo_xl_cell struct
+   */
+
+libo_xl_cell *libo_xl_cell_dup(libo_xl_cell *cell)
+{
+  libo_xl_cell *ncell = NULL;
+
+  if (!cell) goto exit;
+
+  ncell = libo_xl_cell_new();
+  if (!ncell) goto exit;
+
+  memcpy(ncell, cell, sizeof(libo_xl_cell));
+
+  if (cell->type == libo_xl_cell_type_expression)
+  {
+    memset(&ncell->expression, 0, sizeof(libo_xl_cell_expression));
+    if (cell->expression.formula)
+      libo_xl_cell_expression_set_formula(&ncell->expression,
+                                          cell->expression.formula);
+    if (cell->expression.value)
+      libo_xl_cell_expression_set_value(&ncell->expression,
+                                        cell->expression.value);
+  }
+
+exit:
+  return ncell;
+}
+
+  /**
+   *  @fn libo_xl_cell *libo_xl_cell_create(libo_xl_sheet *sheet,
+   *                                        int row,
+   *                                        int col)
+   *
+   *  @brief returns cell at @p row and @p col of @p sheet for changing,
+   *         creating it and the rows and cells before it as needed
+   *
+   *  The sheet is marked changed, so indexes over it see what is done to
+   *  the cell.  Cells reached through @a libo_xl_row_get_cell are not.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param row - row index to into which to add the cell
+   *  @param col - col index of cell to create
+   *
+   *  @return pointer to @a libo_xl_cell owned by @p sheet, NULL on failure
+   */
+
+libo_xl_cell *libo_xl_cell_create(libo_xl_sheet *sheet, int row, int col)
+{
+  if (!sheet) return NULL;
+  if (row < 0) return NULL;
+  if (col < 0) return NULL;
+
+  if (sheet->store && libo_xl_sheet_set_storage(sheet, libo_xl_storage_memory))
+    return NULL;
+
+  ++sheet->version;
+  sheet->dirty = 1;
+
+    // fills take counts, not the index of the last row or cell
+
+  if (row >= sheet->n_rows) libo_xl_row_fill(sheet, row + 1);
+  if (!sheet->row || (row >= sheet->n_rows)) return NULL;
+
+  if (col >= sheet->row[row]->n_cells) libo_xl_col_fill(sheet, row, col + 1);
+  if (!sheet->row[row]->cell || (col >= sheet->row[row]->n_cells)) return NULL;
+
+  return sheet->row[row]->cell[col];
+}
+
+  /**
+   *  @fn int libo_xl_sheet_set_number(libo_xl_sheet *sheet,
+   *                                   int row,
+   *                                   int col,
+   *                                   double number)
+   *
+   *  @brief sets cell at @p row and @p col of @p sheet to @p number
+   *
+   *  As @a libo_xl_cell_set_number on the cell from @a libo_xl_cell_create,
+   *  so indexes over @p sheet are rebuilt.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param row - index of row
+   *  @param col - index of column
+   *  @param number - value
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_sheet_set_number(libo_xl_sheet *sheet, int row, int col, double number)
+{
+  libo_xl_cell *cell;
+
+  cell = libo_xl_cell_create(sheet, row, col);
+  if (!cell) return -1;
+
+  libo_xl_cell_set_number(cell, number);
+
+  return 0;
+}
+
+  /**
+   *  @fn int libo_xl_sheet_set_text(libo_xl *xl,
+   *                                 libo_xl_sheet *sheet,
+   *                                 int row,
+   *                                 int col,
+   *                                 char *text)
+   *
+   *  @brief sets cell at @p row and @p col of @p sheet to @p text
+   *
+   *  As @a libo_xl_cell_set_text on the cell from @a libo_xl_cell_create,
+   *  so indexes over @p sheet are rebuilt.
+   *
+   *  @param xl - pointer to existing @a libo_xl owning @p sheet
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param row - index of row
+   *  @param col - index of column
+   *  @param text - text, copied into the string dictionary
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_sheet_set_text(libo_xl *xl, libo_xl_sheet *sheet, int row, int col, char *text)
+{
+  libo_xl_cell *cell;
+
+  if (!xl || !text) return -1;
+
+  cell = libo_xl_cell_create(sheet, row, col);
+  if (!cell) return -1;
+
+  libo_xl_cell_set_text(xl, cell, text);
+
+  return 0;
+}
+
+  /**
+   *  @fn void libo_xl_cell_free(libo_xl_cell *cell)
+   *
+   *  @brief frees all memory allocated to @p cell
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_cell_free(libo_xl_cell *cell)
+{
+  if (!cell) return;
+
+  libo_xl_cell_clear(cell);
+
+  free(cell);
+
+  return;
+}
+
+  /**
+   *  @fn size_t libo_xl_cell_memory_size(libo_xl_cell *cell)
+   *
+   *  @brief returns number of bytes of memory used by @p cell
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *
+   *  @return approximate number of bytes allocated to @p cell
+   */
+
+size_t libo_xl_cell_memory_size(libo_xl_cell *cell)
+{
+  size_t bytes;
+
+  if (!cell) return 0;
+
+  bytes = sizeof(libo_xl_cell);
+
+  if (cell->type == libo_xl_cell_type_expression)
+  {
+    if (cell->expression.formula) bytes += strlen(cell->expression.formula) + 1;
+    if (cell->expression.value) bytes += strlen(cell->expression.value) + 1;
+  }
+
+  return bytes;
+}
+
+  /**
+   *  @fn libo_xl *libo_xl_read(libo *l)
+   *
+   *  @brief reads entire contents of Excel parts of document file
+   *
+   *  @param l - pointer to existing @a libo struct
+   *
+   *  NOTE:  @p l must already have read ZIP file
+   *
+   *  @return pointer to new @a lib_xl struct
+   */
+
+libo_xl *libo_xl_read(libo *l)
+{
+  libo_xl *xl;
+
+  if (!l) return NULL;
+
+  xl = libo_xl_new();
+  if (!xl) return NULL;
+
+    // shared strings come first, so texts of options can become ids
+
+  xl->strings = libo_xl_strings_read(l);
+  libo_options_resolve_texts(l->options, xl->strings);
+  xl->styles = libo_xl_styles_read(l);
+  xl->book = book_read(l, xl->styles);
+
+  return xl;
+}
+
+  /**
+   *  @fn libo_xl_book *libo_xl_book_read(libo *l)
+   *
+   *  @brief reads work book contents of Excel parts of document file
+   *
+   *  @param l - pointer to existing @a libo struct
+   *
+   *  NOTE:  @p l must already have read ZIP file
+   *
+   *  @return pointer to new @a lib_xl struct
+   */
+
+libo_xl_book *libo_xl_book_read(libo *l)
+{
+  libo_xl_styles *styles = NULL;
+
+  if (l && (l->type == libo_type_xl) && l->xl) styles = l->xl->styles;
+
+  return book_read(l, styles);
+}
+
+  /**
+   *  @fn static libo_xl_book *book_read(libo *l, libo_xl_styles *styles)
+   *
+   *  @brief reads work book contents of Excel parts of document file, with
+   *         cells in formats of @p styles showing dates read as dates
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param styles - style sheet of document, or NULL
+   *
+   *  @return pointer to new @a lib_xl struct
+   */
+
+static libo_xl_book *book_read(libo *l, libo_xl_styles *styles)
+{
+  libo_xl_book *book;
+  libo_xl_sheet *sheet;
+  zip_file_t *zf;
+  int len;
+  char *workbook_file_name = "xl/workbook.xml";
+  char *buf;
+  zip_stat_t stat;
+  xmlDocPtr doc = NULL;
+  int i;
+
+  book = libo_xl_book_new();
+  if (!book) return NULL;
+
+    // open xl/workbook.xml
+
+  if (zip_stat(l->z, workbook_file_name, 0, &stat)) return NULL;
+  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return NULL;
+
+  if (strcmp(workbook_file_name, stat.name)) return NULL;
+
+  len = stat.size;
+
+  zf = zip_fopen(l->z, workbook_file_name, 0);
+  if (!zf)
+  {
+    fprintf(stderr, "Can not open '%s'\n", workbook_file_name); fflush(stderr);
+    return NULL;
+  }
+
+  buf = (char *)malloc(len+1);
+  if (!buf)
+  {
+    zip_fclose(zf);
+    return NULL;
+  }
+  memset(buf, 0, len+1);
+
+  zip_fread(zf, buf, len);
+
+  zip_fclose(zf);
+
+  doc = xmlParseMemory(buf, len);
+  if (!doc)
+  {
+    fprintf(stderr, "Failed to parse '%s'\n", workbook_file_name); fflush(stderr);
+    return NULL;
+  }
+  free(buf);
+
+  book->n_sheets = count_sheets_in_xml(doc);
+  book->date1904 = workbook_date1904(doc);
+
+  book->sheet = (libo_xl_sheet **)malloc(sizeof(libo_xl_sheet *) * book->n_sheets);
+  if (!book->sheet)
+  {
+    xmlFreeDoc(doc);
+    return NULL;
+  }
+  memset(book->sheet, 0, sizeof(libo_xl_sheet *) * book->n_sheets);
+
+  book->memory_budget = libo_options_get_memory_budget(l->options);
+  if (book->memory_budget && l->path)
+  {
+    book->path = strdup(l->path);
+    zip_directory_crc(l->path, &book->crc);
+    if (l->options) book->options = libo_options_dup(l->options);
+  }
+
+  for (i = 0; i < book->n_sheets; i++)
+  {
+    sheet = book->sheet[i] = libo_xl_sheet_meta_read(doc, i);
+    if (!sheet) continue;
+
+    sheet->index = i;
+    sheet_set_dates(sheet, styles);
+    libo_xl_sheet_read(l, sheet, i);
+
+      // keep within budget while reading, so whole book is never resident
+
+    if (book->memory_budget)
+    {
+      sheet->used = ++book->clock;
+      sheet->bytes = libo_xl_sheet_memory_size(sheet);
+      book_trim(book, sheet);
+    }
+  }
+
+  xmlFreeDoc(doc);
+
+  return book;
+}
+
+  /**
+   *  @fn void libo_xl_book_dump(libo_xl_book *lxb, FILE *stream, int indent)
+   *
+   *  @brief dumps contents of @p lxb to @p stream, default is STDOUT
+   *
+   *  @param lxb - pointer to existing @a libo_xl_box struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_book_dump(libo_xl_book *lxb, FILE *stream, int indent)
+{
+  int i;
+
+  if (!lxb) return;
+
+  if (!stream) stream = stdout;
+
+  do_indent(stream, indent); fprintf(stream, "Book:\n");
+  indent += 2;
+
+  do_indent(stream, indent); fprintf(stream, "Sheets (%d):\n", lxb->n_sheets);
+
+  indent += 2;
+
+  for (i = 0; i < lxb->n_sheets; i++)
+    libo_xl_sheet_dump(libo_xl_book_get_sheet(lxb, i), stream, indent);
+
+  return;
+}
+
+  /**
+   *  @fn void libo_xl_sheet_dump(libo_xl_sheet *lxs, FILE *stream, int indent)
+   *
+   *  @brief dumps contents of @p lxs to @p stream, default is STDOUT
+   *
+   *  @param lxs - pointer to existing @a libo_xl_sheet struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sheet_dump(libo_xl_sheet *lxs, FILE *stream, int indent)
+{
+  int i;
+
+  if (!lxs) return;
+
+  do_indent(stream, indent); fprintf(stream, "Sheet:\n");
+
+  indent += 2;
+
+  do_indent(stream, indent); fprintf(stream, "Name: %s\n", lxs->name);
+  do_indent(stream, indent); fprintf(stream, "ID: %d\n", lxs->ID);
+  do_indent(stream, indent); fprintf(stream, "rID: %s\n", lxs->rID);
+
+  if (lxs->n_shared)
+  {
+    do_indent(stream, indent);
+      fprintf(stream, "Shared formulas (%d):\n", lxs->n_shared);
+    for (i = 0; i < lxs->n_shared; i++)
+    {
+      do_indent(stream, indent + 2);
+        fprintf(stream, "%d: %s\n", i, lxs->shared[i]);
+    }
+  }
+
+  do_indent(stream, indent);
+    fprintf(stream, "Rows (%d):\n", lxs->n_rows);
+
+  indent += 2;
+  for (i = 0; i < lxs->n_rows; i++)
+    sheet_row_dump(lxs, i, libo_xl_sheet_get_row(lxs, i), stream, indent);
+
+  return;
+}
+
+  /**
+   *  @fn libo_xl_sheet *libo_xl_sheet_meta_read(xmlDocPtr doc, int n)
+   *
+   *  @brief creates new @a libo_xl_sheet struct from work sheet at position @p n in file in @a doc
+   *
+   *  @param doc - pointer to existing XML document
+   *  @param n - index of work sheet to extract
+   *
+   *  @return pointer to new @a libo_xl_sheet struct
+   */
+
+libo_xl_sheet *libo_xl_sheet_meta_read(xmlDocPtr doc, int n)
+{
+  libo_xl_sheet *sheet = NULL;
+  xmlXPathContextPtr xpathCtx; 
+  xmlXPathObjectPtr xpathObj; 
+  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'workbook']/*[local-name() = 'sheets']/*[local-name() = 'sheet']";
+  xmlNodeSetPtr nodes;
+  xmlNodePtr node;
+  int i;
+
+  if (!doc) return NULL;
+  if (n < 0) return NULL;
+
+  sheet = libo_xl_sheet_new();
+  if (!sheet) return NULL;
+
+  xpathCtx = xmlXPathNewContext(doc);
+  if(!xpathCtx)
+  {
+    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
+    return NULL;
+  }
+
+  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
+  if(!xpathObj)
+  {
+      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
+      xmlXPathFreeContext(xpathCtx); 
+      return NULL;
+  }
+
+  nodes = xpathObj->nodesetval;
+  if (nodes)
+  {
+    for (i = 0; i < nodes->nodeNr; i++)
+    {
+      if (!nodes->nodeTab[i]) continue;
+      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
+      {
+        node = nodes->nodeTab[i];
+        if (i == n)
+        {
+          sheet->name = strdup((char *)xmlGetProp(node, (xmlChar *)"name"));
+          sheet->ID = atoi((char *)xmlGetProp(node, (xmlChar *)"sheetId"));
+          sheet->rID = strdup((char *)xmlGetProp(node, (xmlChar *)"id"));
+          break;
+        }
+      }
+    }
+  }
+
+  xmlXPathFreeObject(xpathObj);
+  xmlXPathFreeContext(xpathCtx); 
+
+  return sheet;
+}
+
+  /**
+   *  @fn void libo_xl_sheet_read(libo *l, libo_xl_sheet *sheet, int n)
+   *
+   *  @brief builds data for sheet number @p n into @p sheet that resides in @p l
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet = pointer to existing @a libo_xl_sheet, filled with meta data
+   *  @param n - index of work sheet to extract
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sheet_read(libo *l, libo_xl_sheet *sheet, int n)
+{
+  char path[4096];
+  zip_file_t *zf;
+  int len;
+  char *buf;
+  zip_stat_t stat;
+  xmlDocPtr doc = NULL;
+  row_range range;
+
+  if (!l) return;
+  if (!sheet) return;
+  if (n < 0) return;
+
+  memset(path, 0, 4096);
+
+  sprintf(path, "xl/worksheets/sheet%d.xml", n+1);
+
+  libo_xl_sheet_read_reset(l, sheet);
+
+  if (libo_options_get_sample_rows(l->options))
+  {
+    if (libo_xl_sheet_sample(l, sheet, n,
+                             libo_options_get_sample_rows(l->options),
+                             libo_options_get_sample_seed(l->options)))
+    {
+      fprintf(stderr, "Failed to parse '%s'\n", path); fflush(stderr);
+    }
+    return;
+  }
+
+  range.first = libo_options_get_first_row(l->options);
+  range.last = libo_options_get_last_row(l->options);
+
+    // stream rows straight into a store, without building a document,
+    // and stream them whenever rows must meet predicates, only some
+    // columns are kept, only some rows are read, or checkpoints are kept
+
+  if ((libo_options_get_storage(l->options) != libo_xl_storage_memory) ||
+      libo_options_get_predicate_count(l->options) ||
+      libo_options_get_column_count(l->options) ||
+      libo_options_get_seek_span(l->options) ||
+      range.first || (range.last >= 0))
+  {
+    if (libo_xl_sheet_read_stream(l, sheet, n, range.first,
+                                  (range.first || (range.last >= 0)) ? range_select : NULL,
+                                  &range, store_row_handler, sheet))
+    {
+      fprintf(stderr, "Failed to parse '%s'\n", path); fflush(stderr);
+    }
+    return;
+  }
+
+    // open xl/worksheets/sheetN.xml
+
+  if (zip_stat(l->z, path, 0, &stat)) return;
+  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return;
+
+  if (strcmp(path, stat.name)) return;
+
+  len = stat.size;
+
+  zf = zip_fopen(l->z, path, 0);
+  if (!zf)
+  {
+    fprintf(stderr, "Can not open '%s'\n", path); fflush(stderr);
+    return;
+  }
+
+  buf = (char *)malloc(len+1);
+  if (!buf)
+  {
+    zip_fclose(zf);
+    return;
+  }
+  memset(buf, 0, len+1);
+
+  zip_fread(zf, buf, len);
+
+  zip_fclose(zf);
+
+  doc = xmlParseMemory(buf, len);
+  if (!doc)
+  {
+    fprintf(stderr, "Failed to parse '%s'\n", path); fflush(stderr);
+    return;
+  }
+  free(buf);
+
+  sheet->n_rows = count_sheet_rows_in_xml(doc);
+  sheet->n_cols = count_sheet_columns_in_xml(doc);
+  sheet->row = libo_xl_sheet_rows_read(sheet, doc);
+
+  xmlFreeDoc(doc);
+
+  return;
+}
+
+  /**
+   *  @fn int libo_xl_sheet_read_range(libo *l,
+   *                                   libo_xl_sheet *sheet,
+   *                                   int first,
+   *                                   int last)
+   *
+   *  @brief reads rows @p first up to, but not including, @p last of the
+   *         work sheet of @p l that @p sheet was read from
+   *
+   *  Rows already in @p sheet are replaced.  Rows before @p first are
+   *  passed over without building their cells, and reading stops at
+   *  @p last, so the rest of the work sheet is never decompressed.  Other
+   *  options of @p l are kept, and rows are counted after predicates are
+   *  met.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param first - index of first row
+   *  @param last - index of row after last row, -1 to read to the end
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_sheet_read_range(libo *l, libo_xl_sheet *sheet, int first, int last)
+{
+  row_range range;
+
+  if (!l || !sheet) return -1;
+  if (sheet->index < 0) return -1;
+
+  range.first = (first > 0) ? first : 0;
+  range.last = (last >= 0) ? last : -1;
+
+  libo_xl_sheet_read_reset(l, sheet);
+
+  return libo_xl_sheet_read_stream(l, sheet, sheet->index, range.first,
+                                   range_select, &range, store_row_handler, sheet);
+}
+
+  /**
+   *  @fn int libo_xl_sheet_read_sample(libo *l,
+   *                                    libo_xl_sheet *sheet,
+   *                                    int k,
+   *                                    unsigned long seed)
+   *
+   *  @brief reads @p k rows chosen at random from the work sheet of @p l
+   *         that @p sheet was read from
+   *
+   *  Rows already in @p sheet are replaced.  The work sheet is read once,
+   *  keeping a reservoir of @p k rows, and rows the reservoir would not
+   *  take are passed over without building their cells.  Rows sampled
+   *  keep their order in the work sheet, and follow any header rows of
+   *  the options of @p l, which are always kept.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param k - number of rows sampled
+   *  @param seed - seed of random choice of rows, the same seed choosing
+   *                the same rows
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_sheet_read_sample(libo *l, libo_xl_sheet *sheet, int k, unsigned long seed)
+{
+  if (!l || !sheet) return -1;
+  if (sheet->index < 0) return -1;
+  if (k < 0) return -1;
+
+  libo_xl_sheet_read_reset(l, sheet);
+
+  return libo_xl_sheet_sample(l, sheet, sheet->index, k, seed);
+}
+
+  /**
+   *  @fn libo_xl_row **libo_xl_sheet_rows_read(libo_xl_sheet *sheet, xmlDocPtr doc)
+   *
+   *  @brief builds rows for sheet number @p sheet from @p doc
+   *
+   *  @param sheet = pointer to existing @a libo_xl_sheet, filled with meta data
+   *  @param doc - pointer to existing XML document
+   *
+   *  @return pointer to new @a libo_xl_sheet struct
+   */
+
+libo_xl_row **libo_xl_sheet_rows_read(libo_xl_sheet *sheet, xmlDocPtr doc)
+{
+  int i, j;
+  libo_xl_row **rows = NULL;
+  libo_xl_row *row;
+  libo_xl_cell *cell;
+  xmlXPathContextPtr xpathCtx; 
+  xmlXPathObjectPtr xpathObj; 
+  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'worksheet']/*[local-name() = 'sheetData']/*[local-name() = 'row']";
+  xmlNodeSetPtr nodes;
+  xmlNodePtr node;
+  xmlNodePtr node2;
+  xmlNodePtr node3;
+  int k;
+  int r,c;
+  char *ref;
+  char *type;
+  char *text;
+  char *value;
+  char *shared;
+  char *si;
+  int *group = NULL;
+  int n_groups = 0;
+  int idx;
+
+  if (!sheet) return NULL;
+  if (!doc) return NULL;
+
+  rows = (libo_xl_row **)malloc(sizeof(libo_xl_row *) * sheet->n_rows);
+  if (!rows) return NULL;
+  memset(rows, 0, sizeof(libo_xl_row *) * sheet->n_rows);
+
+  for (i = 0; i < sheet->n_rows; i++)
+  {
+    row = rows[i] = libo_xl_row_new();
+
+    row->cell = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * sheet->n_cols);
+    if (!row->cell) break;
+    memset(row->cell, 0, sizeof(libo_xl_cell *) * sheet->n_cols);
+    row->n_cells = sheet->n_cols;
+
+    for (j = 0; j < sheet->n_cols; j++)
+      row->cell[j] = libo_xl_cell_new();
+  }
+
+  xpathCtx = xmlXPathNewContext(doc);
+  if(!xpathCtx)
+  {
+    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
+    return 0;
+  }
+
+  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
+  if(!xpathObj)
+  {
+      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
+      xmlXPathFreeContext(xpathCtx); 
+      return 0;
+  }
+
+  nodes = xpathObj->nodesetval;
+  if (nodes)
+  {
+    if (nodes->nodeNr != sheet->n_rows)
+      fprintf(stderr, "Row count does not match XML nodes\n");
+    else
+    {
+      for (i = 0; i < sheet->n_rows; i++)
+      {
+        row = rows[i];
+
+        if (!nodes->nodeTab[i]) continue;
+        node = nodes->nodeTab[i];
+        if (node->type == XML_ELEMENT_NODE)
+        {
+          if (!strcmp((char *)node->name, "row"))
+          {
+            node2 = node->xmlChildrenNode;
+
+            for (j = 0; node2 && (j < sheet->n_cols);)
+            {
+              if (node2->type == XML_ELEMENT_NODE)
+              {
+                if (!strcmp((char *)node2->name, "c"))
+                {
+                  ref = (char *)xmlGetProp(node2, (xmlChar *)"r");
+                  cell_ref_to_row_col(ref, &r, &c);
+                  xmlFree(ref);
+
+                  while (j < c)
+                  {
+                    row->cell[j]->type = libo_xl_cell_type_empty;
+                    ++j;
+                  }
+
+                  cell = row->cell[j];
+
+                  idx = style_attr_int(node2, "s");
+                  if ((idx > 0) && (idx < LIBO_XL_STYLES_MAX)) cell->style = idx;
+
+                  type = (char *)xmlGetProp(node2, (xmlChar *)"t");
+                  if (type)
+                    cell->type = string_to_libo_xl_cell_type(type);
+                  else
+                    cell->type = libo_xl_cell_type_number;
+                  xmlFree(type);
+
+                    // cells of a shared formula after the first name it, and
+                    // keep no text of their own
+
+                  value = NULL;
+                  for (node3 = node2->xmlChildrenNode; node3; node3 = node3->next)
+                  {
+                    if (node3->type != XML_ELEMENT_NODE) continue;
+
+                    if (!strcmp((char *)node3->name, "v"))
+                    {
+                      if (!value) value = (char *)xmlNodeGetContent(node3);
+                      continue;
+                    }
+                    if (strcmp((char *)node3->name, "f")) continue;
+
+                    text = (char *)xmlNodeGetContent(node3);
+                    shared = (char *)xmlGetProp(node3, (xmlChar *)"t");
+                    if (shared && !strcmp(shared, "shared"))
+                    {
+                      si = (char *)xmlGetProp(node3, (xmlChar *)"si");
+                      idx = sheet_formula_share(sheet, &group, &n_groups, si, text, i, j);
+                      if (idx >= 0) cell->shared = idx + 1;
+                      xmlFree(si);
+                    }
+                    if ((text && *text) || cell->shared) cell->type = libo_xl_cell_type_expression;
+                    if (text && *text && !cell->expression.formula) cell->expression.formula = strdup(text);
+                    xmlFree(shared);
+                    xmlFree(text);
+                  }
+
+                  libo_xl_cell_parse_value(cell, value);
+                  cell_resolve_date(cell, sheet);
+                  xmlFree(value);
+                }
+                ++k;
+                ++j;
+              }
+              node2 = node2->next;
+            }
+
+            while (j < sheet->n_cols)
+            {
+              row->cell[j]->type = libo_xl_cell_type_empty;
+              ++j;
+            }
+
+            if (sheet->profile) libo_xl_sheet_profile_row(sheet, row);
+          }
+        }
+      }
+    }
+  }
+
+  xmlXPathFreeObject(xpathObj);
+  xmlXPathFreeContext(xpathCtx); 
+  free(group);
+
+  return rows;
+}
+
+  /**
+   *  @fn void libo_xl_row_dump(libo_xl_row *row, FILE *stream, int indent)
+   *
+   *  @brief dumps contents of @p row to @p stream, default is STDOUT
+   *
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_row_dump(libo_xl_row *row, FILE *stream, int indent)
+{
+  sheet_row_dump(NULL, 0, row, stream, indent);
+}
+
+  /**
+   *  @fn static void sheet_row_dump(libo_xl_sheet *sheet,
+   *                                 int n,
+   *                                 libo_xl_row *row,
+   *                                 FILE *stream,
+   *                                 int indent)
+   *
+   *  @brief dumps contents of @p row, at index @p n of @p sheet, to
+   *         @p stream
+   *
+   *  Cells sharing a formula of @p sheet are dumped with its text at their
+   *  position.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct, or NULL
+   *  @param n - index of row in @p sheet
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void sheet_row_dump(libo_xl_sheet *sheet,
+                           int n,
+                           libo_xl_row *row,
+                           FILE *stream,
+                           int indent)
+{
+  libo_xl_cell *cell;
+  char *formula;
+  size_t len;
+  int i;
+
+  if (!row) return;
+  if (!stream) stream = stdout;
+
+  do_indent(stream, indent); fprintf(stream, "Row:\n");
+  indent += 2;
+
+  do_indent(stream, indent);
+    fprintf(stream, "Cells (%d):\n", row->n_cells);
+  indent += 2;
+
+  for (i = 0; i < row->n_cells; i++)
+  {
+    cell = row->cell[i];
+    formula = NULL;
+    if (sheet && cell && cell->shared && !cell->expression.formula)
+    {
+      len = libo_xl_sheet_format_formula(sheet, n, i, NULL, 0);
+      formula = (char *)malloc(len + 1);
+      if (formula) libo_xl_sheet_format_formula(sheet, n, i, formula, len + 1);
+    }
+
+    cell_dump(cell, formula, stream, indent);
+    free(formula);
+  }
+
+  return;
+}
+
+  /**
+   *  @fn void libo_xl_cell_dump(libo_xl_cell *cell, FILE *stream, int indent)
+   *
+   *  @brief dumps contents of @p cell to @p stream, default is STDOUT
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_cell_dump(libo_xl_cell *cell, FILE *stream, int indent)
+{
+  cell_dump(cell, NULL, stream, indent);
+}
+
+  /**
+   *  @fn static void cell_dump(libo_xl_cell *cell,
+   *                            const char *formula,
+   *                            FILE *stream,
+   *                            int indent)
+   *
+   *  @brief dumps contents of @p cell to @p stream, default is STDOUT
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param formula - formula made for @p cell from one it shares, or NULL
+   *                   for its own
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void cell_dump(libo_xl_cell *cell, const char *formula, FILE *stream, int indent)
+{
+  string *str;
+
+  if (!cell) return;
+  if (!stream) stream = stdout;
+
+  do_indent(stream, indent); fprintf(stream, "Cell:\n");
+  indent += 2;
+
+  do_indent(stream, indent);
+    fprintf(stream, "Type: %s\n",
+            libo_xl_cell_type_to_string(cell->type));
+
+  if (cell->style)
+  {
+    do_indent(stream, indent); fprintf(stream, "Style: %d\n", cell->style);
+  }
+
+  do_indent(stream, indent); fprintf(stream, "Contents:\n");
+  indent += 2;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_none:
+      do_indent(stream, indent); fprintf(stream, "[NONE]\n");
+      break;
+    case libo_xl_cell_type_reference:
+      do_indent(stream, indent);
+        fprintf(stream, "Reference: %d\n", cell->reference);
+      do_indent(stream, indent);
+        str = strings_find_by_id(__xl__->strings, cell->reference);
+        fprintf(stream, "String: %s\n", str ? str->text : "");
+      break;
+    case libo_xl_cell_type_expression:
+      do_indent(stream, indent); fprintf(stream, "Expression:\n");
+      indent += 2;
+      do_indent(stream, indent);
+        fprintf(stream, "Formula: %s\n", formula ? formula : cell->expression.formula);
+      if (cell->shared)
+      {
+        do_indent(stream, indent);
+          fprintf(stream, "Shared: %d\n", cell->shared - 1);
+      }
+      do_indent(stream, indent);
+        fprintf(stream, "Value: %s\n", cell->expression.value);
+      break;
+    case libo_xl_cell_type_number:
+      do_indent(stream, indent);
+        fprintf(stream, "Number: %f\n", cell->number);
+      break;
+    case libo_xl_cell_type_boolean:
+      do_indent(stream, indent);
+        fprintf(stream, "Boolean: %s\n", cell->boolean ? "TRUE" : "FALSE");
+      break;
+    case libo_xl_cell_type_error:
+      do_indent(stream, indent);
+        fprintf(stream, "Error: %s\n", libo_xl_error_to_string(cell->error));
+      break;
+    case libo_xl_cell_type_empty:
+      do_indent(stream, indent); fprintf(stream, "[EMPTY]\n");
+      break;
+    case libo_xl_cell_type_date:
+      do_indent(stream, indent);
+        fprintf(stream, "Date: %f\n", cell->number);
+      break;
+  }
+
+  return;
+}
+
+  /**
+   *  @fn char *libo_xl_cell_type_to_string(libo_xl_cell_type ct)
+   *
+   *  @brief returns string representation of @p ct
+   *
+   *  @param ct - @a libo_xl_cell_type
+   *
+   *  @return string representation of @p ct
+   */
+
+char *libo_xl_cell_type_to_string(libo_xl_cell_type ct)
+{
+  switch (ct)
+  {
+    case libo_xl_cell_type_none: return "[UNKNOWN]";
+    case libo_xl_cell_type_reference: return "REFERENCE";
+    case libo_xl_cell_type_expression: return "EXPRESSION";
+    case libo_xl_cell_type_number: return "NUMBER";
+    case libo_xl_cell_type_boolean: return "BOOLEAN";
+    case libo_xl_cell_type_error: return "ERROR";
+    case libo_xl_cell_type_empty: return "EMPTY";
+    case libo_xl_cell_type_date: return "DATE";
+  }
+
+  return "[UNKNOWN]";
+}
+
+  /**
+   *  @fn const char *libo_xl_error_to_string(libo_xl_error error)
+   *
+   *  @brief returns code of @p error as Excel writes it, such as #N/A
+   *
+   *  @param error - @a libo_xl_error
+   *
+   *  @return code of @p error, empty string for none
+   */
+
+const char *libo_xl_error_to_string(libo_xl_error error)
+{
+  if ((error < libo_xl_error_none) || (error > libo_xl_error_na)) return "";
+
+  return _calc_errors[error];
+}
+
+  /**
+   *  @fn libo_xl_error libo_xl_error_from_string(const char *text)
+   *
+   *  @brief returns error whose code is @p text
+   *
+   *  @param text - code of error, such as #N/A
+   *
+   *  @return @a libo_xl_error, libo_xl_error_none if @p text is no known code
+   */
+
+libo_xl_error libo_xl_error_from_string(const char *text)
+{
+  int i;
+
+  if (!text || (*text != '#')) return libo_xl_error_none;
+
+  for (i = libo_xl_error_null; i <= libo_xl_error_na; i++)
+    if (!strcmp(text, _calc_errors[i])) return (libo_xl_error)i;
+
+  return libo_xl_error_none;
+}
+
+  /**
+   *  @fn int libo_xl_number_format_is_date(const char *code)
+   *
+   *  @brief tells whether number format @p code shows a date or time
+   *
+   *  Only the first section of @p code counts.  Letters in quotes, after
+   *  a backslash, underscore or asterisk, and in brackets other than
+   *  elapsed times such as [h], are passed over.
+   *
+   *  @param code - format code, such as yyyy-mm-dd
+   *
+   *  @return 1 if @p code shows a date or time, 0 otherwise
+   */
+
+int libo_xl_number_format_is_date(const char *code)
+{
+  const char *p;
+  int c;
+
+  if (!code) return 0;
+
+  for (p = code; *p && (*p != ';'); p++)
+  {
+    switch (*p)
+    {
+      case '"':
+        for (++p; *p && (*p != '"'); p++);
+        if (!*p) return 0;
+        break;
+
+      case '\\':
+      case '_':
+      case '*':
+        if (!*++p) return 0;
+        break;
+
+      case '[':
+        c = tolower((unsigned char)p[1]);
+        if ((c == 'h') || (c == 'm') || (c == 's')) return 1;
+        for (++p; *p && (*p != ']'); p++);
+        if (!*p) return 0;
+        break;
+
+      default:
+        c = tolower((unsigned char)*p);
+        if ((c == 'y') || (c == 'm') || (c == 'd') || (c == 'h') || (c == 's')) return 1;
+        break;
+    }
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn char *libo_xl_encoding_to_string(libo_xl_encoding encoding)
+   *
+   *  @brief returns string representation of @p encoding
+   *
+   *  @param encoding - @a libo_xl_encoding
+   *
+   *  @return string representation of @p encoding
+   */
+
+char *libo_xl_encoding_to_string(libo_xl_encoding encoding)
+{
+  switch (encoding)
+  {
+    case libo_xl_encoding_none: return "NONE";
+    case libo_xl_encoding_plain: return "PLAIN";
+    case libo_xl_encoding_run_length: return "RUN-LENGTH";
+    case libo_xl_encoding_dictionary: return "DICTIONARY";
+    case libo_xl_encoding_frame: return "FRAME";
+  }
+
+  return "[UNKNOWN]";
+}
+
+  /**
+   *  @fn char *libo_xl_column_type_to_string(libo_xl_column_type type)
+   *
+   *  @brief returns string representation of @p type
+   *
+   *  @param type - @a libo_xl_column_type
+   *
+   *  @return string representation of @p type
+   */
+
+char *libo_xl_column_type_to_string(libo_xl_column_type type)
+{
+  switch (type)
+  {
+    case libo_xl_column_type_mixed: return "MIXED";
+    case libo_xl_column_type_integer: return "INTEGER";
+    case libo_xl_column_type_number: return "NUMBER";
+    case libo_xl_column_type_reference: return "REFERENCE";
+    case libo_xl_column_type_boolean: return "BOOLEAN";
+    case libo_xl_column_type_error: return "ERROR";
+  }
+
+  return "[UNKNOWN]";
+}
+
+  /**
+   *  @fn libo_xl_column *libo_xl_column_new(void)
+   *
+   *  @brief creates a new @a libo_xl_column struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_column struct
+   */
+
+libo_xl_column *libo_xl_column_new(void)
+{
+  libo_xl_column *c = malloc(sizeof(libo_xl_column));
+  if (c) memset(c, 0, sizeof(libo_xl_column));
+
+  return c;
+}
+
+  /**
+   *  @fn libo_xl_column *libo_xl_column_new_with_values(float width, int autowidth)
+   *
+   *  @brief creates a new @a libo_xl_column struct with values filled
+   *
+   *  @param width - specific width of column
+   *  @param autowidth - flag, 1 to auto-caculate column width, 0 to use specific width
+   *
+   *  @return pointer to new @a libo_xl_column struct
+   */
+
+libo_xl_column *libo_xl_column_new_with_values(float width, int autowidth)
+{
+  libo_xl_column *c = libo_xl_column_new();
+  if (c)
+  {
+    c->width = width;
+    c->autowidth = autowidth;
+  }
+
+  return c;
+}
+
+  /**
+   *  @fn void libo_xl_column_free(libo_xl_column *column)
+   *
+   *  @brief frees all memory allocated to @p column
+   *
+   *  @param column - pointer to existing @a libo_xl_column struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_column_free(libo_xl_column *column) { if (column) free(column); }
+
+  /**
+   *  @fn libo_xl_filter *libo_xl_filter_new(void)
+   *
+   *  @brief returns new @a libo_xl_filter struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_filter struct
+   */
+
+libo_xl_filter *libo_xl_filter_new(void)
+{
+  libo_xl_filter *filter;
+
+  filter = (libo_xl_filter *)malloc(sizeof(libo_xl_filter));
+  if (filter) memset(filter, 0, sizeof(libo_xl_filter));
+
+  return filter;
+}
+
+  /**
+   *  @fn libo_xl_filter *libo_xl_filter_new_with_values(
+   *                         unsigned int first_column,
+   *                         unsigned int last_column)
+   *
+   *  @brief returns new @a libo_xl_filter struct
+   *
+   *  @param first_column - first column that defines filter
+   *  @param last_column - last column that defines filter
+   *
+   *  @return pointer to new @a libo_xl_filter struct
+   */
+
+libo_xl_filter *libo_xl_filter_new_with_values(unsigned int first_column,
+                                               unsigned int last_column)
+{
+  libo_xl_filter *filter;
+
+  filter = libo_xl_filter_new();
+  if (filter)
+  {
+    filter->first_column = first_column;
+    filter->last_column = last_column;
+  }
+
+  return filter;
+}
+
+  /**
+   *  @fn void libo_xl_filter_free(libo_xl_filter *filter)
+   *
+   *  @brief frees all memory allocated to @p filter
+   *
+   *  @param filter - pointer to existing @a libo_xl_filter struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_filter_free(libo_xl_filter *filter)
+{
+  if (!filter) return;
+
+  free(filter);
+}
+
+  /**
+   *  @fn libo_xl_sort *libo_xl_sort_new(void)
+   *
+   *  @brief returns new @a libo_xl_sort struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_sort struct
+   */
+
+libo_xl_sort *libo_xl_sort_new(void)
+{
+  libo_xl_sort *sort;
+
+  sort = (libo_xl_sort *)malloc(sizeof(libo_xl_sort));
+  if (sort) memset(sort, 0, sizeof(libo_xl_sort));
+
+  return sort;
+}
+
+  /**
+   *  @fn libo_xl_sort *libo_xl_sort_new_with_values(int first_row,
+   *                                                 libo_xl_sort_key *keys,
+   *                                                 int n_keys)
+   *
+   *  @brief returns new @a libo_xl_sort struct holding a copy of @p keys
+   *
+   *  @param first_row - index of first sorted row
+   *  @param keys - array of @a libo_xl_sort_key
+   *  @param n_keys - number of keys
+   *
+   *  @return pointer to new @a libo_xl_sort struct, NULL on failure
+   */
+
+libo_xl_sort *libo_xl_sort_new_with_values(int first_row,
+                                           libo_xl_sort_key *keys,
+                                           int n_keys)
+{
+  libo_xl_sort *sort;
+
+  if (!keys || (n_keys < 1)) return NULL;
+
+  sort = libo_xl_sort_new();
+  if (!sort) return NULL;
+
+  sort->key = (libo_xl_sort_key *)malloc(sizeof(libo_xl_sort_key) * n_keys);
+  if (!sort->key)
+  {
+    free(sort);
+    return NULL;
+  }
+
+  memcpy(sort->key, keys, sizeof(libo_xl_sort_key) * n_keys);
+  sort->n_keys = n_keys;
+  sort->first_row = first_row;
+
+  return sort;
+}
+
+  /**
+   *  @fn void libo_xl_sort_free(libo_xl_sort *sort)
+   *
+   *  @brief frees all memory allocated to @p sort
+   *
+   *  @param sort - pointer to existing @a libo_xl_sort struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sort_free(libo_xl_sort *sort)
+{
+  if (!sort) return;
+
+  free(sort->key);
+  free(sort);
+}
+
+  /**
+   *  @fn libo_xl_column_profile *libo_xl_column_profile_new(void)
+   *
+   *  @brief returns new @a libo_xl_column_profile struct
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_column_profile struct
+   */
+
+libo_xl_column_profile *libo_xl_column_profile_new(void)
+{
+  libo_xl_column_profile *profile;
+
+  profile = (libo_xl_column_profile *)malloc(sizeof(libo_xl_column_profile));
+  if (profile) memset(profile, 0, sizeof(libo_xl_column_profile));
+
+  return profile;
+}
+
+  /**
+   *  @fn void libo_xl_column_profile_free(libo_xl_column_profile *profile)
+   *
+   *  @brief frees all memory allocated to @p profile
+   *
+   *  @param profile - pointer to existing @a libo_xl_column_profile struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_column_profile_free(libo_xl_column_profile *profile)
+{
+  if (profile) free(profile);
+}
+
+  /**
+   *  @fn void libo_xl_column_profile_add(libo_xl_column_profile *profile,
+   *                                      libo_xl_cell *cell)
+   *
+   *  @brief adds @p cell to @p profile
+   *
+   *  A NULL @p cell, or an expression without formula or value, counts as
+   *  empty.
+   *
+   *  @param profile - pointer to existing @a libo_xl_column_profile struct
+   *  @param cell - pointer to @a libo_xl_cell struct, or NULL
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_column_profile_add(libo_xl_column_profile *profile,
+                                libo_xl_cell *cell)
+{
+  uint64_t h;
+  int first;
+  int i;
+  int rank;
+
+  if (!profile) return;
+
+  if (!cell || profile_cell_is_empty(cell))
+  {
+    ++profile->nulls;
+    return;
+  }
+
+  if (cell->type < LIBO_XL_CELL_TYPES)
+    ++profile->count[cell->type];
+
+  if (cell_is_number(cell))
+  {
+    first = (profile->count[libo_xl_cell_type_number] + profile->count[libo_xl_cell_type_date]) == 1;
+    if (first || (cell->number < profile->min)) profile->min = cell->number;
+    if (first || (cell->number > profile->max)) profile->max = cell->number;
+  }
+
+    // register from the top bits, rank from the position of the first 1 after
+
+  h = profile_cell_hash(cell);
+  i = h >> (64 - LIBO_XL_PROFILE_BITS);
+  h <<= LIBO_XL_PROFILE_BITS;
+
+  for (rank = 1; (rank <= 64 - LIBO_XL_PROFILE_BITS) && !(h & ((uint64_t)1 << 63)); rank++)
+    h <<= 1;
+
+  if (rank > profile->registers[i]) profile->registers[i] = rank;
+}
+
+  /**
+   *  @fn double libo_xl_column_profile_get_distinct(
+   *                libo_xl_column_profile *profile)
+   *
+   *  @brief returns estimated number of distinct values in @p profile
+   *
+   *  The HyperLogLog estimate is within a few percent, and is exact enough
+   *  for small columns, where linear counting takes over.
+   *
+   *  @param profile - pointer to existing @a libo_xl_column_profile struct
+   *
+   *  @return estimated number of distinct values
+   */
+
+double libo_xl_column_profile_get_distinct(libo_xl_column_profile *profile)
+{
+  double m = LIBO_XL_PROFILE_REGISTERS;
+  double sum = 0;
+  double estimate;
+  int zeros = 0;
+  int i;
+
+  if (!profile) return 0;
+
+  for (i = 0; i < LIBO_XL_PROFILE_REGISTERS; i++)
+  {
+    sum += ldexp(1.0, -profile->registers[i]);
+    if (!profile->registers[i]) ++zeros;
+  }
+
+  estimate = (0.7213 / (1 + 1.079 / m)) * m * m / sum;
+
+  if ((estimate <= 2.5 * m) && zeros)
+    estimate = m * log(m / zeros);
+
+  return estimate;
+}
+
+  /**
+   *  @fn void libo_xl_column_profile_dump(libo_xl_column_profile *profile,
+   *                                       FILE *stream,
+   *                                       int indent)
+   *
+   *  @brief dumps contents of @p profile to @p stream, default is STDOUT
+   *
+   *  @param profile - pointer to existing @a libo_xl_column_profile struct
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to indent output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_column_profile_dump(libo_xl_column_profile *profile,
+                                 FILE *stream,
+                                 int indent)
+{
+  int i;
+
+  if (!profile) return;
+  if (!stream) stream = stdout;
+
+  do_indent(stream, indent); fprintf(stream, "Profile:\n");
+
+  indent += 2;
+
+  for (i = 0; i < LIBO_XL_CELL_TYPES; i++)
+  {
+    do_indent(stream, indent);
+      fprintf(stream, "%s: %ld\n", libo_xl_cell_type_to_string(i), profile->count[i]);
+  }
+
+  do_indent(stream, indent); fprintf(stream, "Nulls: %ld\n", profile->nulls);
+  do_indent(stream, indent); fprintf(stream, "Min: %f\n", profile->min);
+  do_indent(stream, indent); fprintf(stream, "Max: %f\n", profile->max);
+  do_indent(stream, indent);
+    fprintf(stream, "Distinct: %.0f\n", libo_xl_column_profile_get_distinct(profile));
+}
+
+  /**
+   *  @fn libo_xl_index *libo_xl_index_build(libo_xl_sheet *sheet, int col)
+   *
+   *  @brief builds hash index over values in column @p col of @p sheet
+   *
+   *  Numbers and shared strings are indexed, other cells are not.  The
+   *  index must be freed before @p sheet.
+   *
+   *  The index is refilled when the sheet changes through
+   *  @a libo_xl_cell_create and the sheet setters, or is marked dirty.  Cells
+   *  changed through @a libo_xl_row_get_cell alone go unseen.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *
+   *  @return pointer to new @a libo_xl_index struct, NULL on failure
+   */
+
+libo_xl_index *libo_xl_index_build(libo_xl_sheet *sheet, int col)
+{
+  libo_xl_index *idx;
+
+  if (!sheet || (col < 0)) return NULL;
+
+  idx = (libo_xl_index *)malloc(sizeof(libo_xl_index));
+  if (!idx) return NULL;
+  memset(idx, 0, sizeof(libo_xl_index));
+
+  idx->sheet = sheet;
+  idx->col = col;
+
+  if (libo_xl_index_fill(idx))
+  {
+    free(idx->slot);
+    free(idx->next);
+    free(idx);
+    return NULL;
+  }
+
+  pthread_rwlock_init(&idx->lock, NULL);
+
+  return idx;
+}
+
+  /**
+   *  @fn void libo_xl_index_free(libo_xl_index *idx)
+   *
+   *  @brief frees all memory allocated to @p idx
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_index_free(libo_xl_index *idx)
+{
+  if (!idx) return;
+
+  pthread_rwlock_destroy(&idx->lock);
+
+  free(idx->slot);
+  free(idx->next);
+  free(idx);
+}
+
+  /**
+   *  @fn int libo_xl_index_lookup(libo_xl_index *idx, libo_xl_cell *value)
+   *
+   *  @brief returns first row whose indexed cell equals @p value, as MATCH
+   *         with exact match does
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *  @param value - pointer to @a libo_xl_cell holding number or shared
+   *                 string
+   *
+   *  @return index of row, -1 if not found
+   */
+
+int libo_xl_index_lookup(libo_xl_index *idx, libo_xl_cell *value)
+{
+  uint64_t key;
+
+  if (!idx || !value) return -1;
+  if (index_cell_key(value, &key)) return -1;
+
+  return libo_xl_index_find_row(idx, value->type, key);
+}
+
+  /**
+   *  @fn int libo_xl_index_lookup_number(libo_xl_index *idx, double number)
+   *
+   *  @brief returns first row whose indexed cell is @p number
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *  @param number - number to find
+   *
+   *  @return index of row, -1 if not found
+   */
+
+int libo_xl_index_lookup_number(libo_xl_index *idx, double number)
+{
+  libo_xl_cell cell;
+
+  memset(&cell, 0, sizeof(libo_xl_cell));
+  cell.type = libo_xl_cell_type_number;
+  cell.number = number;
+
+  return libo_xl_index_lookup(idx, &cell);
+}
+
+  /**
+   *  @fn int libo_xl_index_lookup_reference(libo_xl_index *idx,
+   *                                         int reference)
+   *
+   *  @brief returns first row whose indexed cell holds shared string
+   *         @p reference
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *  @param reference - index of shared string
+   *
+   *  @return index of row, -1 if not found
+   */
+
+int libo_xl_index_lookup_reference(libo_xl_index *idx, int reference)
+{
+  libo_xl_cell cell;
+
+  memset(&cell, 0, sizeof(libo_xl_cell));
+  cell.type = libo_xl_cell_type_reference;
+  cell.reference = reference;
+
+  return libo_xl_index_lookup(idx, &cell);
+}
+
+  /**
+   *  @fn int libo_xl_index_lookup_text(libo_xl_index *idx,
+   *                                    libo_xl *xl,
+   *                                    char *text)
+   *
+   *  @brief returns first row whose indexed cell holds shared string
+   *         @p text
+   *
+   *  @p text is turned into its shared string id once, so rows are found
+   *  without comparing strings.
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *  @param xl - pointer to existing @a libo_xl struct owning the sheet
+   *  @param text - string to find
+   *
+   *  @return index of row, -1 if not found
+   */
+
+int libo_xl_index_lookup_text(libo_xl_index *idx, libo_xl *xl, char *text)
+{
+  string *str;
+
+  if (!idx || !xl || !xl->strings || !text) return -1;
+
+  str = strings_find_by_text(xl->strings, text);
+  if (!str) return -1;
+
+  return libo_xl_index_lookup_reference(idx, str->id);
+}
+
+  /**
+   *  @fn int libo_xl_index_next(libo_xl_index *idx, int row)
+   *
+   *  @brief returns next row after @p row holding the same value
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *  @param row - index of row returned by a lookup
+   *
+   *  @return index of row, -1 if there are no more
+   */
+
+int libo_xl_index_next(libo_xl_index *idx, int row)
+{
+  int next = -1;
+
+  if (!idx || (row < 0)) return -1;
+
+  pthread_rwlock_rdlock(&idx->lock);
+
+  if ((idx->version == idx->sheet->version) && (row < idx->n_rows))
+    next = idx->next[row];
+
+  pthread_rwlock_unlock(&idx->lock);
+
+  return next;
+}
+
+  /**
+   *  @fn libo_xl_sorted_index *libo_xl_sorted_index_build(libo_xl *xl,
+   *                                                       libo_xl_sheet *sheet,
+   *                                                       int col)
+   *
+   *  @brief builds sorted index over values in column @p col of @p sheet
+   *
+   *  Rows are ordered as Excel sorts them, numbers before text, text
+   *  ignoring case.  Rows holding equal values keep their order.  Text is
+   *  only indexed when @p xl is given.  The rows are sorted by several
+   *  threads when the column is long.
+   *
+   *  The index is not changed by lookups, so it may be shared by threads
+   *  without locking.  It is not rebuilt when cells of @p sheet change; see
+   *  libo_xl_sorted_index_is_stale(), which sees changes made through
+   *  @a libo_xl_cell_create, the sheet setters and
+   *  @a libo_xl_sheet_set_dirty, but not through @a libo_xl_row_get_cell
+   *  alone.  The index must be freed before @p sheet and @p xl.
+   *
+   *  @param xl - pointer to existing @a libo_xl struct owning the sheet, or
+   *              NULL
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *
+   *  @return pointer to new @a libo_xl_sorted_index struct, NULL on failure
+   */
+
+libo_xl_sorted_index *libo_xl_sorted_index_build(libo_xl *xl, libo_xl_sheet *sheet, int col)
+{
+  libo_xl_sorted_index *idx;
+  libo_xl_cell *cell;
+  sorted_entry *entry = NULL;
+  int *perm = NULL;
+  int n = 0;
+  int i;
+
+  if (!sheet || (col < 0)) return NULL;
+
+  idx = (libo_xl_sorted_index *)malloc(sizeof(libo_xl_sorted_index));
+  if (!idx) return NULL;
+  memset(idx, 0, sizeof(libo_xl_sorted_index));
+
+  idx->xl = xl;
+  idx->sheet = sheet;
+  idx->col = col;
+  idx->version = sheet->version;
+
+  if (xl && xl->strings)
+  {
+    idx->rank = libo_xl_strings_rank(xl, &idx->n_strings, &idx->by_rank, &idx->n_ranked);
+    if (!idx->rank) goto bail;
+  }
+
+  entry = (sorted_entry *)malloc(sizeof(sorted_entry) * (sheet->n_rows ? sheet->n_rows : 1));
+  if (!entry) goto bail;
+
+  for (i = 0; i < sheet->n_rows; i++)
+  {
+    cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), col);
+    if (!cell || sorted_cell_key(idx, cell, &entry[n])) continue;
+    entry[n++].row = i;
+  }
+
+  perm = (int *)malloc(sizeof(int) * (n ? n : 1));
+  idx->entry = (sorted_entry *)malloc(sizeof(sorted_entry) * (n ? n : 1));
+  if (!perm || !idx->entry) goto bail;
+
+  for (i = 0; i < n; i++)
+    perm[i] = i;
+
+  if (parallel_sort(perm, n, sorted_entry_compare, entry)) goto bail;
+
+  for (i = 0; i < n; i++)
+    idx->entry[i] = entry[perm[i]];
+  idx->n = n;
+
+  free(perm);
+  free(entry);
+
+  return idx;
+
+bail:
+  free(perm);
+  free(entry);
+  libo_xl_sorted_index_free(idx);
+
+  return NULL;
+}
+
+  /**
+   *  @fn void libo_xl_sorted_index_free(libo_xl_sorted_index *idx)
+   *
+   *  @brief frees all memory allocated to @p idx
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_sorted_index_free(libo_xl_sorted_index *idx)
+{
+  if (!idx) return;
+
+  free(idx->entry);
+  free(idx->rank);
+  free(idx->by_rank);
+  free(idx);
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_is_stale(libo_xl_sorted_index *idx)
+   *
+   *  @brief reports whether cells of the sheet of @p idx changed since
+   *         @p idx was built
+   *
+   *  A stale index still answers lookups from the values it was built
+   *  with; build a new one to see the changes.
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *
+   *  @return 1 if stale, 0 if current, -1 on failure
+   */
+
+int libo_xl_sorted_index_is_stale(libo_xl_sorted_index *idx)
+{
+  if (!idx) return -1;
+
+  return idx->version != idx->sheet->version;
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_get_count(libo_xl_sorted_index *idx)
+   *
+   *  @brief returns number of rows held by @p idx
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *
+   *  @return number of rows, -1 on failure
+   */
+
+int libo_xl_sorted_index_get_count(libo_xl_sorted_index *idx)
+{
+  if (!idx) return -1;
+
+  return idx->n;
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_get_row(libo_xl_sorted_index *idx,
+   *                                       int pos)
+   *
+   *  @brief returns row at position @p pos of sorted order of @p idx
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param pos - position, from 0 to count - 1
+   *
+   *  @return index of row, -1 on failure
+   */
+
+int libo_xl_sorted_index_get_row(libo_xl_sorted_index *idx, int pos)
+{
+  if (!idx || (pos < 0) || (pos >= idx->n)) return -1;
+
+  return idx->entry[pos].row;
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_lower_bound(libo_xl_sorted_index *idx,
+   *                                           libo_xl_cell *value)
+   *
+   *  @brief returns first position of @p idx whose value is not less than
+   *         @p value
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param value - pointer to @a libo_xl_cell holding number or shared
+   *                 string
+   *
+   *  @return position, from 0 to count, -1 on failure
+   */
+
+int libo_xl_sorted_index_lower_bound(libo_xl_sorted_index *idx, libo_xl_cell *value)
+{
+  sorted_entry key;
+
+  if (!idx || !value) return -1;
+  if (sorted_cell_key(idx, value, &key)) return -1;
+
+  return sorted_bound(idx, &key, 0);
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_upper_bound(libo_xl_sorted_index *idx,
+   *                                           libo_xl_cell *value)
+   *
+   *  @brief returns first position of @p idx whose value is greater than
+   *         @p value
+   *
+   *  Rows from lower bound up to, but not including, upper bound of one
+   *  value hold that value.
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param value - pointer to @a libo_xl_cell holding number or shared
+   *                 string
+   *
+   *  @return position, from 0 to count, -1 on failure
+   */
+
+int libo_xl_sorted_index_upper_bound(libo_xl_sorted_index *idx, libo_xl_cell *value)
+{
+  sorted_entry key;
+
+  if (!idx || !value) return -1;
+  if (sorted_cell_key(idx, value, &key)) return -1;
+
+  return sorted_bound(idx, &key, 1);
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_lower_bound_number(libo_xl_sorted_index *idx,
+   *                                                  double number)
+   *
+   *  @brief returns first position of @p idx whose value is not less than
+   *         @p number
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param number - number to compare
+   *
+   *  @return position, from 0 to count, -1 on failure
+   */
+
+int libo_xl_sorted_index_lower_bound_number(libo_xl_sorted_index *idx, double number)
+{
+  libo_xl_cell cell;
+
+  memset(&cell, 0, sizeof(libo_xl_cell));
+  cell.type = libo_xl_cell_type_number;
+  cell.number = number;
+
+  return libo_xl_sorted_index_lower_bound(idx, &cell);
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_upper_bound_number(libo_xl_sorted_index *idx,
+   *                                                  double number)
+   *
+   *  @brief returns first position of @p idx whose value is greater than
+   *         @p number
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param number - number to compare
+   *
+   *  @return position, from 0 to count, -1 on failure
+   */
+
+int libo_xl_sorted_index_upper_bound_number(libo_xl_sorted_index *idx, double number)
+{
+  libo_xl_cell cell;
+
+  memset(&cell, 0, sizeof(libo_xl_cell));
+  cell.type = libo_xl_cell_type_number;
+  cell.number = number;
+
+  return libo_xl_sorted_index_upper_bound(idx, &cell);
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_lower_bound_text(libo_xl_sorted_index *idx,
+   *                                                char *text)
+   *
+   *  @brief returns first position of @p idx whose value is not less than
+   *         @p text
+   *
+   *  @p text need not be a shared string.
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param text - string to compare
+   *
+   *  @return position, from 0 to count, -1 on failure
+   */
+
+int libo_xl_sorted_index_lower_bound_text(libo_xl_sorted_index *idx, char *text)
+{
+  sorted_entry key;
+
+  if (!idx || !text || !idx->rank) return -1;
+
+  sorted_text_key(idx, text, &key);
+
+  return sorted_bound(idx, &key, 0);
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_upper_bound_text(libo_xl_sorted_index *idx,
+   *                                                char *text)
+   *
+   *  @brief returns first position of @p idx whose value is greater than
+   *         @p text
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param text - string to compare
+   *
+   *  @return position, from 0 to count, -1 on failure
+   */
+
+int libo_xl_sorted_index_upper_bound_text(libo_xl_sorted_index *idx, char *text)
+{
+  sorted_entry key;
+
+  if (!idx || !text || !idx->rank) return -1;
+
+  sorted_text_key(idx, text, &key);
+
+  return sorted_bound(idx, &key, 1);
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_match(libo_xl_sorted_index *idx,
+   *                                     libo_xl_cell *value)
+   *
+   *  @brief returns row holding largest value not greater than @p value,
+   *         as MATCH with match type 1 does
+   *
+   *  Only values of the same kind as @p value, number or text, are
+   *  considered.  Of rows holding that value, the last in sorted order is
+   *  returned.
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param value - pointer to @a libo_xl_cell holding number or shared
+   *                 string
+   *
+   *  @return index of row, -1 if not found
+   */
+
+int libo_xl_sorted_index_match(libo_xl_sorted_index *idx, libo_xl_cell *value)
+{
+  sorted_entry key;
+  int pos;
+
+  if (!idx || !value) return -1;
+  if (sorted_cell_key(idx, value, &key)) return -1;
+
+  pos = sorted_bound(idx, &key, 1) - 1;
+  if ((pos < 0) || (idx->entry[pos].kind != key.kind)) return -1;
+
+  return idx->entry[pos].row;
+}
+
+  /**
+   *  @fn int libo_xl_sorted_index_rows(libo_xl_sorted_index *idx,
+   *                                    int first,
+   *                                    int last,
+   *                                    int *rows)
+   *
+   *  @brief fills @p rows with rows at positions @p first up to, but not
+   *         including, @p last of @p idx, in row order
+   *
+   *  Lists of rows of several indexes may then be joined with
+   *  libo_xl_rows_intersect() and libo_xl_rows_union().
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param first - first position, as from a lower bound
+   *  @param last - position after last, as from an upper bound
+   *  @param rows - array of at least @p last - @p first integers
+   *
+   *  @return number of rows, -1 on failure
+   */
+
+int libo_xl_sorted_index_rows(libo_xl_sorted_index *idx, int first, int last, int *rows)
+{
+  int n;
+  int i;
+
+  if (!idx || !rows || (first < 0) || (last > idx->n)) return -1;
+  if (first >= last) return 0;
+
+  n = last - first;
+  for (i = 0; i < n; i++)
+    rows[i] = idx->entry[first + i].row;
+
+  qsort(rows, n, sizeof(int), int_compare);
+
+  return n;
+}
+
+  /**
+   *  @fn int libo_xl_rows_intersect(const int *a,
+   *                                 int na,
+   *                                 const int *b,
+   *                                 int nb,
+   *                                 int *rows)
+   *
+   *  @brief fills @p rows with rows found in both @p a and @p b
+   *
+   *  @p a and @p b must be in row order, as from
+   *  libo_xl_sorted_index_rows().  @p rows may be @p a or @p b.
+   *
+   *  @param a - array of rows
+   *  @param na - number of rows in @p a
+   *  @param b - array of rows
+   *  @param nb - number of rows in @p b
+   *  @param rows - array of at least the smaller of @p na and @p nb integers
+   *
+   *  @return number of rows, -1 on failure
+   */
+
+int libo_xl_rows_intersect(const int *a, int na, const int *b, int nb, int *rows)
+{
+  int i = 0, j = 0, n = 0;
+
+  if (!a || !b || !rows || (na < 0) || (nb < 0)) return -1;
+
+  while ((i < na) && (j < nb))
+  {
+    if (a[i] < b[j]) i++;
+    else if (b[j] < a[i]) j++;
+    else
+    {
+      rows[n++] = a[i];
+      i++;
+      j++;
+    }
+  }
+
+  return n;
+}
+
+  /**
+   *  @fn int libo_xl_rows_union(const int *a,
+   *                             int na,
+   *                             const int *b,
+   *                             int nb,
+   *                             int *rows)
+   *
+   *  @brief fills @p rows with rows found in either @p a or @p b
+   *
+   *  @p a and @p b must be in row order, as from
+   *  libo_xl_sorted_index_rows().  @p rows must not be @p a or @p b.
+   *
+   *  @param a - array of rows
+   *  @param na - number of rows in @p a
+   *  @param b - array of rows
+   *  @param nb - number of rows in @p b
+   *  @param rows - array of at least @p na + @p nb integers
+   *
+   *  @return number of rows, -1 on failure
+   */
+
+int libo_xl_rows_union(const int *a, int na, const int *b, int nb, int *rows)
+{
+  int i = 0, j = 0, n = 0;
+
+  if (!a || !b || !rows || (na < 0) || (nb < 0)) return -1;
+
+  while ((i < na) || (j < nb))
+  {
+    if ((j >= nb) || ((i < na) && (a[i] < b[j]))) rows[n++] = a[i++];
+    else if ((i >= na) || (b[j] < a[i])) rows[n++] = b[j++];
+    else
+    {
+      rows[n++] = a[i];
+      i++;
+      j++;
+    }
+  }
+
+  return n;
+}
+
+  /**
+   *  @fn libo_xl_view *libo_xl_view_filter(libo_xl_sheet *sheet,
+   *                                        libo_xl_predicate *pred)
+   *
+   *  @brief returns view of rows of @p sheet whose cell in column of
+   *         @p pred matches @p pred
+   *
+   *  Cells are tested a block of rows at a time, by SSE2 or AVX2 kernels
+   *  where the processor has them.  Comparisons only match numbers, and
+   *  sets only match shared strings.  The view holds row numbers as of
+   *  now; it does not follow later changes to @p sheet.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param pred - pointer to existing @a libo_xl_predicate struct
+   *
+   *  @return pointer to new @a libo_xl_view struct, NULL on failure
+   */
+
+libo_xl_view *libo_xl_view_filter(libo_xl_sheet *sheet, libo_xl_predicate *pred)
+{
+  libo_xl_view *view = NULL;
+  view_test test;
+  uint64_t *words = NULL;
+  int first, n;
+
+  if (!sheet || !pred || (pred->col < 0)) return NULL;
+  if (view_test_init(&test, pred)) return NULL;
+
+  view = libo_xl_view_new(sheet);
+  words = (uint64_t *)malloc(sizeof(uint64_t) * LIBO_XL_VIEW_WORDS);
+  if (!view || !words) goto bail;
+
+  for (first = 0; first < sheet->n_rows; first += LIBO_XL_VIEW_SPAN)
+  {
+    n = sheet->n_rows - first;
+    if (n > LIBO_XL_VIEW_SPAN) n = LIBO_XL_VIEW_SPAN;
+
+    view_test_rows(&test, sheet, pred->col, first, n, words);
+    if (view_container_add(view, first / LIBO_XL_VIEW_SPAN, words)) goto bail;
+  }
+
+  free(words);
+  view_test_clear(&test);
+
+  return view;
+
+bail:
+  free(words);
+  view_test_clear(&test);
+  libo_xl_view_free(view);
+
+  return NULL;
+}
+
+  /**
+   *  @fn libo_xl_view *libo_xl_view_and(libo_xl_view *a, libo_xl_view *b)
+   *
+   *  @brief returns view of rows found in both @p a and @p b
+   *
+   *  @param a - pointer to existing @a libo_xl_view struct
+   *  @param b - pointer to existing @a libo_xl_view struct of same sheet
+   *
+   *  @return pointer to new @a libo_xl_view struct, NULL on failure
+   */
+
+libo_xl_view *libo_xl_view_and(libo_xl_view *a, libo_xl_view *b)
+{
+  return view_combine(a, b, 0);
+}
+
+  /**
+   *  @fn libo_xl_view *libo_xl_view_or(libo_xl_view *a, libo_xl_view *b)
+   *
+   *  @brief returns view of rows found in either @p a or @p b
+   *
+   *  @param a - pointer to existing @a libo_xl_view struct
+   *  @param b - pointer to existing @a libo_xl_view struct of same sheet
+   *
+   *  @return pointer to new @a libo_xl_view struct, NULL on failure
+   */
+
+libo_xl_view *libo_xl_view_or(libo_xl_view *a, libo_xl_view *b)
+{
+  return view_combine(a, b, 1);
+}
+
+  /**
+   *  @fn void libo_xl_view_free(libo_xl_view *view)
+   *
+   *  @brief frees all memory allocated to @p view
+   *
+   *  @param view - pointer to existing @a libo_xl_view struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_view_free(libo_xl_view *view)
+{
+  int i;
+
+  if (!view) return;
+
+  for (i = 0; i < view->n_containers; i++)
+  {
+    free(view->container[i].array);
+    free(view->container[i].bits);
+  }
+
+  free(view->container);
+  free(view);
+}
+
+  /**
+   *  @fn int libo_xl_view_get_count(libo_xl_view *view)
+   *
+   *  @brief returns number of rows in @p view
+   *
+   *  @param view - pointer to existing @a libo_xl_view struct
+   *
+   *  @return number of rows, -1 on failure
+   */
+
+int libo_xl_view_get_count(libo_xl_view *view)
+{
+  if (!view) return -1;
+
+  return view->count;
+}
+
+  /**
+   *  @fn int libo_xl_view_contains(libo_xl_view *view, int row)
+   *
+   *  @brief reports whether @p row is in @p view
+   *
+   *  @param view - pointer to existing @a libo_xl_view struct
+   *  @param row - index of row
+   *
+   *  @return 1 if in view, 0 otherwise
+   */
+
+int libo_xl_view_contains(libo_xl_view *view, int row)
+{
+  view_container *c;
+
+  if (!view || (row < 0)) return 0;
+
+  c = view_container_find(view, row / LIBO_XL_VIEW_SPAN);
+  if (!c || (c->key != row / LIBO_XL_VIEW_SPAN)) return 0;
+
+  return view_container_next(c, row % LIBO_XL_VIEW_SPAN) == row % LIBO_XL_VIEW_SPAN;
+}
+
+  /**
+   *  @fn int libo_xl_view_next(libo_xl_view *view, int row)
+   *
+   *  @brief returns first row of @p view after @p row
+   *
+   *  Rows of a view are visited in order, without copying them, with
+   *  @code for (row = libo_xl_view_next(view, -1); row >= 0; row = libo_xl_view_next(view, row)) @endcode
+   *
+   *  @param view - pointer to existing @a libo_xl_view struct
+   *  @param row - index of row, -1 to start
+   *
+   *  @return index of row, -1 if there are no more
+   */
+
+int libo_xl_view_next(libo_xl_view *view, int row)
+{
+  view_container *c, *end;
+  int low;
+
+  if (!view) return -1;
+
+  if (row < -1) row = -1;
+  ++row;
+
+  c = view_container_find(view, row / LIBO_XL_VIEW_SPAN);
+  if (!c) return -1;
+
+  end = view->container + view->n_containers;
+
+  for (; c < end; c++)
+  {
+    low = (c->key == row / LIBO_XL_VIEW_SPAN) ? row % LIBO_XL_VIEW_SPAN : 0;
+    low = view_container_next(c, low);
+    if (low >= 0) return c->key * LIBO_XL_VIEW_SPAN + low;
+  }
+
+  return -1;
+}
+
+  /**
+   *  @fn libo_xl_sheet *libo_xl_view_to_sheet(libo_xl_view *view)
+   *
+   *  @brief returns new work sheet holding copies of rows of @p view
+   *
+   *  Rows are copied straight from the sheet of @p view, in order.  Cells
+   *  sharing a formula are given its text, as the rows move.
+   *
+   *  @param view - pointer to existing @a libo_xl_view struct
+   *
+   *  @return pointer to new @a libo_xl_sheet struct, NULL on failure
+   */
+
+libo_xl_sheet *libo_xl_view_to_sheet(libo_xl_view *view)
+{
+  libo_xl_sheet *nsheet;
+  libo_xl_row *xlr;
+  int n_rows;
+  int row;
+
+  if (!view) return NULL;
+
+  nsheet = libo_xl_sheet_new();
+  if (!nsheet) return NULL;
+
+  nsheet->default_row_height = view->sheet->default_row_height;
+
+    // shared formulas hold only at the rows they were read at
+
+  for (row = libo_xl_view_next(view, -1); row >= 0; row = libo_xl_view_next(view, row))
+  {
+    xlr = libo_xl_sheet_get_row(view->sheet, row);
+    if (!xlr) continue;
+
+    n_rows = nsheet->n_rows;
+    libo_xl_sheet_add(nsheet, xlr);
+
+      // a row that was not added must not have the last one expanded again
+
+    if ((nsheet->n_rows == n_rows) ||
+        (sheet_row_expand(view->sheet, row, nsheet->row[nsheet->n_rows - 1]) < 0))
+    {
+      libo_xl_sheet_free(nsheet);
+      return NULL;
+    }
+  }
+
+  return nsheet;
+}
+
+  /**
+   *  @fn int libo_xl_view_apply(libo_xl_view *view,
+   *                             unsigned int first_column,
+   *                             unsigned int last_column)
+   *
+   *  @brief hides rows of the sheet of @p view that are not in @p view,
+   *         and adds a filter over columns @p first_column to
+   *         @p last_column
+   *
+   *  The first row holds the headings of the filter, and is never hidden.
+   *  Rows are hidden when the sheet is written; none are removed.
+   *
+   *  @param view - pointer to existing @a libo_xl_view struct
+   *  @param first_column - first filtered column
+   *  @param last_column - last filtered column
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_view_apply(libo_xl_view *view,
+                       unsigned int first_column,
+                       unsigned int last_column)
+{
+  libo_xl_view *visible;
+
+  if (!view) return -1;
+
+  visible = view_combine(view, view, 1);
+  if (!visible) return -1;
+
+  libo_xl_view_free(view->sheet->visible);
+  view->sheet->visible = visible;
+
+  libo_xl_sheet_add_filter(view->sheet, first_column, last_column);
+
+  return 0;
+}
+
+  /**
+   *  @fn libo_xl_schema *libo_xl_sheet_schema(libo_xl *xl,
+   *                                           libo_xl_sheet *sheet,
+   *                                           int header_row)
+   *
+   *  @brief builds a table finding columns of @p sheet by the headings in
+   *         row @p header_row
+   *
+   *  Headings are hashed once, so looking up a column by name takes no
+   *  search of the header row.  Where two columns have the same heading,
+   *  the first is found.
+   *
+   *  @param xl - pointer to existing @a libo_xl struct holding shared strings
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param header_row - index of row holding headings
+   *
+   *  @return pointer to new @a libo_xl_schema struct, NULL on failure
+   */
+
+libo_xl_schema *libo_xl_sheet_schema(libo_xl *xl, libo_xl_sheet *sheet, int header_row)
+{
+  libo_xl_row *row;
+
+  if (!xl || !sheet) return NULL;
+
+  row = libo_xl_sheet_get_row(sheet, header_row);
+  if (!row) return NULL;
+
+  return schema_build(xl, row);
+}
+
+  /**
+   *  @fn void libo_xl_schema_free(libo_xl_schema *schema)
+   *
+   *  @brief frees all memory allocated to @p schema
+   *
+   *  @param schema - pointer to existing @a libo_xl_schema struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_schema_free(libo_xl_schema *schema)
+{
+  int i;
+
+  if (!schema) return;
+
+  if (schema->name)
+  {
+    for (i = 0; i < schema->n_names; i++)
+      free(schema->name[i]);
+    free(schema->name);
+  }
+
+  free(schema->slot);
+
+  free(schema);
+}
+
+  /**
+   *  @fn int libo_xl_schema_get_column_count(libo_xl_schema *schema)
+   *
+   *  @brief returns number of columns of header row of @p schema
+   *
+   *  @param schema - pointer to existing @a libo_xl_schema struct
+   *
+   *  @return count of columns
+   */
+
+int libo_xl_schema_get_column_count(libo_xl_schema *schema)
+{
+  if (!schema) return 0;
+
+  return schema->n_names;
+}
+
+  /**
+   *  @fn char *libo_xl_schema_get_name(libo_xl_schema *schema, int col)
+   *
+   *  @brief returns heading of column @p col of @p schema
+   *
+   *  @param schema - pointer to existing @a libo_xl_schema struct
+   *  @param col - index of column
+   *
+   *  @return heading, NULL if column has none or @p col is out of range
+   */
+
+char *libo_xl_schema_get_name(libo_xl_schema *schema, int col)
+{
+  if (!schema) return NULL;
+  if ((col < 0) || (col >= schema->n_names)) return NULL;
+
+  return schema->name[col];
+}
+
+  /**
+   *  @fn int libo_xl_schema_get_column(libo_xl_schema *schema, char *name)
+   *
+   *  @brief returns index of column of @p schema headed @p name
+   *
+   *  Columns found are remembered by the address of @p name, so a name
+   *  given as the same string each time, such as a literal, is hashed only
+   *  the first time.
+   *
+   *  @param schema - pointer to existing @a libo_xl_schema struct
+   *  @param name - heading of column
+   *
+   *  @return index of column, -1 if no column has heading @p name
+   */
+
+int libo_xl_schema_get_column(libo_xl_schema *schema, char *name)
+{
+  schema_hit *hit;
+  int col;
+
+  if (!schema || !name) return -1;
+
+  hit = &schema->hit[((uintptr_t)name >> 3) & (LIBO_XL_SCHEMA_CACHE - 1)];
+
+    // string at same address may since have changed
+
+  if ((hit->name == name) && !strcmp(name, schema->name[hit->col])) return hit->col;
+
+  col = schema_find(schema, name);
+  if (col >= 0)
+  {
+    hit->name = name;
+    hit->col = col;
+  }
+
+  return col;
+}
+
+  /**
+   *  @fn int libo_xl_sheet_get_record(libo_xl_sheet *sheet,
+   *                                   libo_xl_schema *schema,
+   *                                   int n,
+   *                                   libo_xl_record *rec)
+   *
+   *  @brief fills @p rec with row @p n of @p sheet, named by @p schema
+   *
+   *  @p rec holds the row itself, not a copy, so it is valid for as long
+   *  as a row returned by @a libo_xl_sheet_get_row.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param schema - pointer to existing @a libo_xl_schema struct
+   *  @param n - index of row
+   *  @param rec - pointer to @a libo_xl_record struct to fill
+   *
+   *  @return 0 on success, -1 if there is no row @p n
+   */
+
+int libo_xl_sheet_get_record(libo_xl_sheet *sheet,
+                             libo_xl_schema *schema,
+                             int n,
+                             libo_xl_record *rec)
+{
+  libo_xl_row *row;
+
+  if (!sheet || !schema || !rec) return -1;
+
+  row = libo_xl_sheet_get_row(sheet, n);
+  if (!row) return -1;
+
+  rec->schema = schema;
+  rec->row = row;
+  rec->n = n;
+
+  return 0;
+}
+
+  /**
+   *  @fn int libo_xl_sheet_stream_records(libo *l,
+   *                                       libo_xl_sheet *sheet,
+   *                                       int header_row,
+   *                                       libo_xl_record_handler handler,
+   *                                       void *data)
+   *
+   *  @brief reads rows of the work sheet of @p l that @p sheet was read
+   *         from one at a time, passing each row after @p header_row to
+   *         @p handler as a record
+   *
+   *  Rows are streamed, and none is kept in @p sheet.  The schema is built
+   *  from row @p header_row as it passes, and rows before it are not
+   *  passed to @p handler.  Predicates and columns of the options of
+   *  @p l apply as they do to @a libo_xl_sheet_read, with header rows set
+   *  so the header row is always read.  Each record is valid only until
+   *  @p handler returns.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param header_row - index of row holding headings
+   *  @param handler - function called with each record
+   *  @param data - passed to @p handler
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+int libo_xl_sheet_stream_records(libo *l,
+                                 libo_xl_sheet *sheet,
+                                 int header_row,
+                                 libo_xl_record_handler handler,
+                                 void *data)
+{
+  record_stream rs;
+  int ret;
+
+  if (!l || !sheet || !handler) return -1;
+  if (sheet->index < 0) return -1;
+  if (header_row < 0) return -1;
+
+  memset(&rs, 0, sizeof(record_stream));
+  rs.xl = libo_get_xl(l);
+  rs.header_row = header_row;
+  rs.handler = handler;
+  rs.data = data;
+
+  ret = libo_xl_sheet_stream(l, sheet, sheet->index, NULL, &sheet->seek, 0, NULL, NULL,
+                             record_row_handler, &rs);
+
+  libo_xl_schema_free(rs.schema);
+
+  return (ret || rs.failed) ? -1 : 0;
+}
+
+  /**
+   *  @fn libo_xl_cell *libo_xl_record_get_cell(libo_xl_record *rec,
+   *                                            char *name)
+   *
+   *  @brief returns cell of @p rec in column headed @p name
+   *
+   *  @param rec - pointer to existing @a libo_xl_record struct
+   *  @param name - heading of column
+   *
+   *  @return pointer to @a libo_xl_cell, NULL if there is none
+   */
+
+libo_xl_cell *libo_xl_record_get_cell(libo_xl_record *rec, char *name)
+{
+  if (!rec) return NULL;
+
+  return libo_xl_row_get_cell(rec->row, libo_xl_schema_get_column(rec->schema, name));
+}
+
+  /**
+   *  @fn double libo_xl_record_get_number(libo_xl_record *rec, char *name)
+   *
+   *  @brief returns number in cell of @p rec in column headed @p name
+   *
+   *  Values of formulas are read as numbers, and booleans as 1 or 0.
+   *
+   *  @param rec - pointer to existing @a libo_xl_record struct
+   *  @param name - heading of column
+   *
+   *  @return number, 0 if the cell holds none
+   */
+
+double libo_xl_record_get_number(libo_xl_record *rec, char *name)
+{
+  libo_xl_cell *cell;
+
+  cell = libo_xl_record_get_cell(rec, name);
+  if (!cell) return 0;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      return cell->number;
+    case libo_xl_cell_type_boolean:
+      return cell->boolean ? 1 : 0;
+    case libo_xl_cell_type_expression:
+      if (cell->expression.value) return atof(cell->expression.value);
+      break;
+    default:
+      break;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn char *libo_xl_record_get_text(libo_xl_record *rec, char *name)
+   *
+   *  @brief returns text in cell of @p rec in column headed @p name
+   *
+   *  Text is not copied, and belongs to the workbook or the cell.
+   *
+   *  @param rec - pointer to existing @a libo_xl_record struct
+   *  @param name - heading of column
+   *
+   *  @return text of shared string, value of formula, TRUE or FALSE, or
+   *          error code, NULL if the cell holds none of these
+   */
+
+char *libo_xl_record_get_text(libo_xl_record *rec, char *name)
+{
+  libo_xl_cell *cell;
+
+  cell = libo_xl_record_get_cell(rec, name);
+  if (!cell) return NULL;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_reference:
+      return libo_xl_cell_get_text(rec->schema->xl, cell);
+    case libo_xl_cell_type_expression:
+      return cell->expression.value;
+    case libo_xl_cell_type_boolean:
+    case libo_xl_cell_type_error:
+      return (char *)libo_xl_cell_get_string_view(rec->schema->xl, cell, NULL);
+    default:
+      break;
+  }
+
+  return NULL;
+}
+
+  /**
+   *  @fn long libo_xl_sheet_bind(libo *l,
+   *                              libo_xl_sheet *sheet,
+   *                              int first,
+   *                              int last,
+   *                              libo_xl_field *field,
+   *                              int n_fields,
+   *                              size_t size,
+   *                              void **records)
+   *
+   *  @brief reads rows @p first up to, but not including, @p last of the
+   *         work sheet of @p l that @p sheet was read from straight into
+   *         an array of structs described by @p field
+   *
+   *  Values are parsed from the XML of the work sheet into the fields of
+   *  each struct as they are read, without building any cell or row, and
+   *  texts point at the shared strings of @p l, which are not copied.
+   *  Fields of cells missing, or of the wrong type, are left 0, or -1 for
+   *  ids of shared strings.  Predicates and columns of the options of
+   *  @p l are not applied.  Rows before @p first resume from a checkpoint
+   *  when @p sheet has one.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param first - index of first row
+   *  @param last - index of row after last row, -1 to read to the end
+   *  @param field - array of fields of struct
+   *  @param n_fields - number of entries of @p field
+   *  @param size - size of struct, from @a sizeof
+   *  @param records - receives new array of structs, to be freed by caller
+   *
+   *  @return number of structs filled, -1 on failure
+   */
+
+long libo_xl_sheet_bind(libo *l,
+                        libo_xl_sheet *sheet,
+                        int first,
+                        int last,
+                        libo_xl_field *field,
+                        int n_fields,
+                        size_t size,
+                        void **records)
+{
+  sheet_reader sr;
+  xmlTextReaderPtr reader;
+  strings *strings;
+  char *data = NULL;
+  char *ndata;
+  char *rec = NULL;
+  char *name;
+  char t[16];
+  long n_recs = 0;
+  long size_recs = 0;
+  int n_read = 0;
+  int in_v = 0;
+  int c = 0;
+  int last_c = -1;
+  int r;
+  int i;
+  int type;
+  int ret;
+
+  if (!l || !sheet || !field || !size || !records) return -1;
+  if (sheet->index < 0) return -1;
+
+  *records = NULL;
+  strings = libo_get_xl(l) ? libo_get_xl(l)->strings : NULL;
+  if (first < 0) first = 0;
+
+  if (sheet_reader_open(l, sheet->index, &sheet->seek, first, 1, &sr)) return -1;
+  reader = sr.reader;
+
+  if (sr.point) n_read = sr.point->row;
+
+  t[0] = 0;
+
+  while ((ret = xmlTextReaderRead(reader)) == 1)
+  {
+    type = xmlTextReaderNodeType(reader);
+
+      // value of a cell of a row bound, parsed in place
+
+    if (in_v && rec && ((type == XML_READER_TYPE_TEXT) ||
+                        (type == XML_READER_TYPE_SIGNIFICANT_WHITESPACE)))
+    {
+      name = (char *)xmlTextReaderConstValue(reader);
+      if (name) bind_value(rec, field, n_fields, c, t, name, strings);
+      continue;
+    }
+
+    name = (char *)xmlTextReaderConstLocalName(reader);
+    if (!name) continue;
+
+    if (type == XML_READER_TYPE_ELEMENT)
+    {
+      if (!strcmp(name, "row"))
+      {
+        if ((last >= 0) && (n_read >= last)) break;
+
+        rec = NULL;
+        last_c = -1;
+
+        if (n_read >= first)
+        {
+          if (n_recs == size_recs)
+          {
+            ndata = (char *)realloc(data, size * (size_recs ? 2 * size_recs : 64));
+            if (!ndata)
+            {
+              ret = -1;
+              break;
+            }
+            data = ndata;
+            size_recs = size_recs ? 2 * size_recs : 64;
+          }
+
+          rec = data + size * n_recs;
+          memset(rec, 0, size);
+          for (i = 0; i < n_fields; i++)
+            if (field[i].type == libo_xl_field_string_id) *(int *)(rec + field[i].offset) = -1;
+        }
+
+        if (xmlTextReaderIsEmptyElement(reader))
+        {
+          if (rec) ++n_recs;
+          rec = NULL;
+          ++n_read;
+        }
+      }
+      else if (rec && !strcmp(name, "c"))
+      {
+          // attributes are read in place, without copying
+
+        c = last_c + 1;
+        t[0] = 0;
+        while (xmlTextReaderMoveToNextAttribute(reader) == 1)
+        {
+          name = (char *)xmlTextReaderConstLocalName(reader);
+          if (!strcmp(name, "r"))
+            cell_ref_to_row_col((char *)xmlTextReaderConstValue(reader), &r, &c);
+          else if (!strcmp(name, "t"))
+          {
+            strncpy(t, (char *)xmlTextReaderConstValue(reader), sizeof(t) - 1);
+            t[sizeof(t) - 1] = 0;
+          }
+        }
+        xmlTextReaderMoveToElement(reader);
+        last_c = c;
+      }
+      else if (rec && !strcmp(name, "v"))
+        in_v = !xmlTextReaderIsEmptyElement(reader);
+    }
+    else if (type == XML_READER_TYPE_END_ELEMENT)
+    {
+      if (!strcmp(name, "v"))
+        in_v = 0;
+      else if (!strcmp(name, "row"))
+      {
+        if (rec) ++n_recs;
+        rec = NULL;
+        ++n_read;
+      }
+      else if (!strcmp(name, "sheetData"))
+        break;
+    }
+  }
+
+  sheet_reader_close(&sr, &sheet->seek);
+
+  if (ret < 0)
+  {
+    free(data);
+    return -1;
+  }
+
+  *records = data;
+
+  return n_recs;
+}
+
+  /**
+   *  @fn char *libo_xl_formula_to_r1c1(const char *formula, int row, int col)
+   *
+   *  @brief converts @p formula, held by a cell at @p row and @p col, to
+   *         R1C1 form
+   *
+   *  References are made relative to the cell, such as R[-1]C for the cell
+   *  above it, unless fixed with $, so cells holding the same formula
+   *  relative to their own positions share one R1C1 text.  Text, names of
+   *  sheets, functions and tables are kept as they are.  Whole columns or
+   *  rows, such as A:A or 1:3, are converted only as ranges.
+   *
+   *  @param formula - formula in A1 form
+   *  @param row - index of row of cell holding @p formula
+   *  @param col - index of column of cell holding @p formula
+   *
+   *  @return new formula in R1C1 form, to be freed by caller, NULL on
+   *          failure
+   */
+
+char *libo_xl_formula_to_r1c1(const char *formula, int row, int col)
+{
+  pack_buffer b;
+  formula_ref a, z;
+  const char *p;
+  char s[80];
+  size_t n, m;
+  size_t len;
+
+  if (!formula || (row < 0) || (col < 0)) return NULL;
+
+  memset(&b, 0, sizeof(pack_buffer));
+
+  for (p = formula; *p; p += n)
+  {
+    if ((n = formula_literal(p)))
+    {
+      if (pack_bytes(&b, (void *)p, n)) goto bail;
+      continue;
+    }
+
+    n = formula_word(p);
+    if (!n)
+    {
+      n = 1;
+      if (pack_bytes(&b, (void *)p, n)) goto bail;
+      continue;
+    }
+
+      // names of sheets, functions and tables are kept
+
+    if ((p[n] == '!') || (p[n] == '(') || (p[n] == '[') || formula_a1_parse(p, n, &a))
+    {
+      if (pack_bytes(&b, (void *)p, n)) goto bail;
+      continue;
+    }
+
+    if ((a.row >= 0) && (a.col >= 0))
+    {
+      len = formula_r1c1_format(&a, row, col, s);
+      if (pack_bytes(&b, s, len)) goto bail;
+      continue;
+    }
+
+      // a column or row on its own is a number or a name, not a reference
+
+    m = (p[n] == ':') ? formula_word(p + n + 1) : 0;
+    if (m && ((p[n + 1 + m] == '!') || (p[n + 1 + m] == '(') ||
+              formula_a1_parse(p + n + 1, m, &z) ||
+              ((z.row < 0) != (a.row < 0)) || ((z.col < 0) != (a.col < 0))))
+      m = 0;
+
+    if (!m)
+    {
+      if (pack_bytes(&b, (void *)p, n)) goto bail;
+      continue;
+    }
+
+    len = formula_r1c1_format(&a, row, col, s);
+    s[len++] = ':';
+    len += formula_r1c1_format(&z, row, col, s + len);
+    if (pack_bytes(&b, s, len)) goto bail;
+    n += 1 + m;
+  }
+
+  if (pack_bytes(&b, "", 1)) goto bail;
+
+  return (char *)b.data;
+
+bail:
+  free(b.data);
+
+  return NULL;
+}
+
+  /**
+   *  @fn size_t libo_xl_formula_from_r1c1(const char *r1c1,
+   *                                       int row,
+   *                                       int col,
+   *                                       char *buffer,
+   *                                       size_t size)
+   *
+   *  @brief writes @p r1c1, made by @a libo_xl_formula_to_r1c1, into
+   *         @p buffer as the A1 formula of a cell at @p row and @p col
+   *
+   *  The formula is truncated to fit @p size bytes including the
+   *  terminator, as by snprintf().  References falling outside a work
+   *  sheet become #REF!.
+   *
+   *  @param r1c1 - formula in R1C1 form
+   *  @param row - index of row of cell
+   *  @param col - index of column of cell
+   *  @param buffer - buffer to receive formula, or NULL
+   *  @param size - size of @p buffer in bytes
+   *
+   *  @return length of whole formula, 0 on failure
+   */
+
+size_t libo_xl_formula_from_r1c1(const char *r1c1,
+                                 int row,
+                                 int col,
+                                 char *buffer,
+                                 size_t size)
+{
+  formula_ref a, z;
+  const char *p;
+  char s[40];
+  size_t len = 0;
+  size_t n, m;
+  size_t k;
+
+  if (buffer && size) *buffer = 0;
+  if (!r1c1 || (row < 0) || (col < 0)) return 0;
+
+  for (p = r1c1; *p; p += n)
+  {
+    if ((n = formula_literal(p)))
+    {
+      formula_put(buffer, size, &len, p, n);
+      continue;
+    }
+
+    n = formula_r1c1_parse(p, row, col, &a);
+    m = (n && (p[n] == ':')) ? formula_r1c1_parse(p + n + 1, row, col, &z) : 0;
+    if (m && (((z.row < 0) != (a.row < 0)) || ((z.col < 0) != (a.col < 0)))) m = 0;
+
+      // a column or row must be one end of a range, as it was written
+
+    if (!n || (!m && ((a.row < 0) || (a.col < 0))))
+    {
+      n = formula_word(p);
+      if (!n) n = 1;
+      formula_put(buffer, size, &len, p, n);
+      continue;
+    }
+
+    if (a.bad || (m && z.bad))
+      formula_put(buffer, size, &len, "#REF!", 5);
+    else
+    {
+      k = formula_a1_format(&a, s);
+      if (m)
+      {
+        s[k++] = ':';
+        k += formula_a1_format(&z, s + k);
+      }
+      formula_put(buffer, size, &len, s, k);
+    }
+
+    if (m) n += 1 + m;
+  }
+
+  if (buffer && size) buffer[(len < size) ? len : size - 1] = 0;
+
+  return len;
+}
+
+  /**
+   *  @fn libo_xl_calc *libo_xl_calc_new(libo_xl *xl)
+   *
+   *  @brief compiles the formulas of every work sheet of @p xl, and records
+   *         the cells each reads
+   *
+   *  Nothing is calculated; every formula is marked for
+   *  libo_xl_calc_update(), and until then gives the value last saved in
+   *  its cell.  Work sheets
+   *  holding formulas are moved to memory, so results can be written into
+   *  their cells.  Formulas that cannot be compiled give #NAME?.
+   *
+   *  @param xl - pointer to existing @a libo_xl struct
+   *
+   *  @return pointer to new @a libo_xl_calc struct, NULL on failure
+   */
+
+libo_xl_calc *libo_xl_calc_new(libo_xl *xl)
+{
+  libo_xl_calc *calc;
+  libo_xl_sheet *sheet;
+  libo_xl_row *row;
+  libo_xl_cell *cell;
+  calc_column *column;
+  int s, r, c, n;
+
+  if (!xl || !xl->book) return NULL;
+
+  calc = (libo_xl_calc *)malloc(sizeof(libo_xl_calc));
+  if (!calc) return NULL;
+  memset(calc, 0, sizeof(libo_xl_calc));
+
+  calc->xl = xl;
+  calc->free_edge = -1;
+  calc->n_sheets = xl->book->n_sheets;
+
+  calc->sheet = (calc_sheet *)malloc(sizeof(calc_sheet) * (calc->n_sheets ? calc->n_sheets : 1));
+  if (!calc->sheet) goto bail;
+  memset(calc->sheet, 0, sizeof(calc_sheet) * (calc->n_sheets ? calc->n_sheets : 1));
+
+    // all sheets are named before any formula is compiled
+
+  for (s = 0; s < calc->n_sheets; s++)
+    calc->sheet[s].sheet = xl->book->sheet[s];
+
+  for (s = 0; s < calc->n_sheets; s++)
+  {
+    sheet = calc_sheet_get(calc, s);
+    if (!sheet) continue;
+
+    if (sheet->store && calc_sheet_has_formulas(sheet) &&
+        libo_xl_sheet_set_storage(sheet, libo_xl_storage_memory))
+      goto bail;
+
+    for (r = 0; r < sheet->n_rows; r++)
+    {
+      row = libo_xl_sheet_get_row(sheet, r);
+
+      for (c = 0; row && (c < row->n_cells); c++)
+      {
+        cell = row->cell[c];
+        if (!calc_cell_is_value(cell)) continue;
+
+        column = calc_column_get(calc, s, c);
+        if (!column) goto bail;
+        ++column->n_values;
+
+        if (!cell_has_formula(cell)) continue;
+        if ((r >= LIBO_XL_CALC_ROWS) || (c >= LIBO_XL_CALC_COLS)) continue;
+
+        n = calc_node_get(calc, s, r, c);
+        if ((n < 0) || calc_compile_cell(calc, n, sheet, cell, r, c)) goto bail;
+        ++column->n_nodes;
+      }
+    }
+  }
+
+    // nothing is calculated yet, so cells keep the values last saved
+
+  for (n = 0; n < calc->n_nodes; n++)
+  {
+    if (calc_node_link(calc, n, 1)) goto bail;
+    calc->node[n].dirty = 1;
+    calc->dirty[calc->n_dirty++] = n;
+  }
+
+  return calc;
+
+bail:
+  libo_xl_calc_free(calc);
+
+  return NULL;
+}
+
+  /**
+   *  @fn void libo_xl_calc_free(libo_xl_calc *calc)
+   *
+   *  @brief frees all memory allocated to @p calc
+   *
+   *  @p calc must be freed before the workbook it was made from.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+void libo_xl_calc_free(libo_xl_calc *calc)
+{
+  calc_block *block, *next;
+  int i, j;
+
+  if (!calc) return;
+
+  for (i = 0; i < calc->n_nodes; i++)
+  {
+    free(calc->node[i].code);
+    free(calc->node[i].text);
+  }
+
+  for (i = 0; calc->sheet && (i < calc->n_sheets); i++)
+  {
+    for (j = 0; j < calc->sheet[i].n_cols; j++)
+    {
+      free(calc->sheet[i].col[j].dep);
+      libo_xl_sorted_index_free(calc->sheet[i].col[j].sorted);
+    }
+    free(calc->sheet[i].col);
+  }
+
+  for (block = calc->block; block; block = next)
+  {
+    next = block->next;
+    free(block);
+  }
+
+  free(calc->sheet);
+  free(calc->node);
+  free(calc->slot);
+  free(calc->edge);
+  free(calc->head);
+  free(calc->dep);
+  free(calc->dirty);
+  free(calc->queue);
+  free(calc->stack);
+  free(calc);
+}
+
+  /**
+   *  @fn int libo_xl_calc_get_formula_count(libo_xl_calc *calc)
+   *
+   *  @brief returns number of formulas known to @p calc
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *
+   *  @return number of formulas, -1 on failure
+   */
+
+int libo_xl_calc_get_formula_count(libo_xl_calc *calc)
+{
+  int count = 0;
+  int i;
+
+  if (!calc) return -1;
+
+  for (i = 0; i < calc->n_nodes; i++)
+    if (calc->node[i].code) ++count;
+
+  return count;
+}
+
+  /**
+   *  @fn int libo_xl_calc_recalculate(libo_xl_calc *calc)
+   *
+   *  @brief calculates every formula of @p calc, each after the formulas
+   *         it reads, and writes the results into their cells
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *
+   *  @return number of formulas calculated, -1 on failure
+   */
+
+int libo_xl_calc_recalculate(libo_xl_calc *calc)
+{
+  int i;
+
+  if (!calc) return -1;
+
+  calc->n_dirty = 0;
+
+  for (i = 0; i < calc->n_nodes; i++)
+  {
+    calc->node[i].dirty = (calc->node[i].code != NULL);
+    if (calc->node[i].dirty) calc->dirty[calc->n_dirty++] = i;
+  }
+
+  return calc_run(calc);
+}
+
+  /**
+   *  @fn int libo_xl_calc_mark(libo_xl_calc *calc,
+   *                            libo_xl_sheet *sheet,
+   *                            int row,
+   *                            int col)
+   *
+   *  @brief tells @p calc the cell at @p row and @p col of @p sheet changed
+   *
+   *  A new or changed formula is compiled again.  The formulas reading the
+   *  cell, directly or through other formulas or ranges, are marked for
+   *  libo_xl_calc_update(), and no others.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - pointer to work sheet of @p calc holding cell
+   *  @param row - index of row
+   *  @param col - index of column
+   *
+   *  @return number of formulas marked, -1 on failure
+   */
+
+int libo_xl_calc_mark(libo_xl_calc *calc, libo_xl_sheet *sheet, int row, int col)
+{
+  libo_xl_cell *cell;
+  calc_column *column;
+  calc_node *node;
+  int first;
+  int s, n;
+
+  if (!calc) return -1;
+
+  s = calc_sheet_index(calc, sheet);
+  if ((s < 0) || (row < 0) || (col < 0)) return -1;
+  if ((row >= LIBO_XL_CALC_ROWS) || (col >= LIBO_XL_CALC_COLS)) return -1;
+
+  column = calc_column_get(calc, s, col);
+  if (!column) return -1;
+
+  cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, row), col);
+  if (calc_cell_is_value(cell)) ++column->n_values;
+
+  first = calc->n_dirty;
+  n = calc_find(calc, calc_key(s, row, col));
+
+  if (cell_has_formula(cell))
+  {
+    if (sheet->store)
+    {
+      if (libo_xl_sheet_set_storage(sheet, libo_xl_storage_memory)) return -1;
+      cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, row), col);
+    }
+
+    if (n < 0) n = calc_node_get(calc, s, row, col);
+    if (n < 0) return -1;
+
+    if (calc->node[n].code) calc_node_link(calc, n, 0);
+    else ++column->n_nodes;
+
+    if (calc_compile_cell(calc, n, sheet, cell, row, col) || calc_node_link(calc, n, 1)) return -1;
+
+    node = &calc->node[n];
+    if (!node->dirty)
+    {
+      node->dirty = 1;
+      calc->dirty[calc->n_dirty++] = n;
+    }
+  }
+  else
+  {
+    if ((n >= 0) && calc->node[n].code)
+    {
+      node = &calc->node[n];
+      calc_node_link(calc, n, 0);
+      free(node->code);
+      node->code = NULL;
+      node->n_code = 0;
+      calc_result_set(node, NULL);
+      --column->n_nodes;
+    }
+
+    calc_touch(calc, s, row, col);
+  }
+
+  calc_spread(calc, first);
+
+  ++sheet->version;
+  sheet->dirty = 1;
+
+  return calc->n_dirty - first;
+}
+
+  /**
+   *  @fn int libo_xl_calc_update(libo_xl_calc *calc)
+   *
+   *  @brief calculates the formulas marked by libo_xl_calc_mark(), each
+   *         after the formulas it reads, and writes the results into their
+   *         cells
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *
+   *  @return number of formulas calculated, -1 on failure
+   */
+
+int libo_xl_calc_update(libo_xl_calc *calc)
+{
+  if (!calc) return -1;
+
+  return calc_run(calc);
+}
+
+  /**
+   *  @fn int libo_xl_calc_get_value(libo_xl_calc *calc,
+   *                                 libo_xl_sheet *sheet,
+   *                                 int row,
+   *                                 int col,
+   *                                 libo_xl_value *value)
+   *
+   *  @brief fills @p value with the value of the cell at @p row and @p col
+   *         of @p sheet, formulas giving their last result
+   *
+   *  Results that are numbers, booleans and errors are given as cells of
+   *  those types, text as expression cells whose text is the result.  The
+   *  text is valid until the formula is calculated again.  Formulas marked
+   *  but not yet calculated give the value held in their cell.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - pointer to work sheet of @p calc holding cell
+   *  @param row - index of row
+   *  @param col - index of column
+   *  @param value - pointer to @a libo_xl_value to fill
+   *
+   *  @return type of value, -1 on error
+   */
+
+int libo_xl_calc_get_value(libo_xl_calc *calc,
+                           libo_xl_sheet *sheet,
+                           int row,
+                           int col,
+                           libo_xl_value *value)
+{
+  libo_xl_cell *cell;
+  calc_node *node;
+  int s, n;
+
+  if (!calc || !value) return -1;
+
+  s = calc_sheet_index(calc, sheet);
+  if ((s < 0) || (row < 0) || (col < 0)) return -1;
+
+  n = ((row < LIBO_XL_CALC_ROWS) && (col < LIBO_XL_CALC_COLS)) ? calc_find(calc, calc_key(s, row, col)) : -1;
+
+  cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, row), col);
+
+  if ((n < 0) || !calc->node[n].code)
+    return libo_xl_cell_get_value(calc->xl, cell, value);
+
+  node = &calc->node[n];
+
+  value->type = libo_xl_cell_type_expression;
+  value->number = 0;
+  value->reference = -1;
+  value->error = libo_xl_error_none;
+  value->text = NULL;
+  value->length = 0;
+
+    // formulas not yet calculated give the result saved with them
+
+  if (node->dirty)
+  {
+    value->text = (cell && (cell->type == libo_xl_cell_type_expression)) ? cell->expression.value : NULL;
+    if (!value->text) value->text = "";
+
+    if (!*expression_value_type(value->text))
+    {
+      value->type = libo_xl_cell_type_number;
+      value->number = strtod(value->text, NULL);
+      value->text = NULL;
+    }
+    else if (!strcmp(value->text, "TRUE") || !strcmp(value->text, "FALSE"))
+    {
+      value->type = libo_xl_cell_type_boolean;
+      value->number = (*value->text == 'T');
+    }
+    else if ((value->error = libo_xl_error_from_string(value->text)) != libo_xl_error_none)
+      value->type = libo_xl_cell_type_error;
+  }
+  else switch (node->value.kind)
+  {
+    case calc_number:
+      value->type = libo_xl_cell_type_number;
+      value->number = node->value.number;
+      break;
+    case calc_text:
+      value->text = node->text;
+      break;
+    case calc_bool:
+      value->type = libo_xl_cell_type_boolean;
+      value->number = node->value.number ? 1 : 0;
+      value->text = node->value.number ? "TRUE" : "FALSE";
+      break;
+    case calc_error:
+      value->type = libo_xl_cell_type_error;
+      value->error = (libo_xl_error)node->value.error;
+      value->text = _calc_errors[node->value.error];
+      break;
+    default:
+      value->type = libo_xl_cell_type_none;
+      break;
+  }
+
+  if (value->text) value->length = strlen(value->text);
+
+  return value->type;
+}
+
+ // INTERNALS
+
+  /**
+   *  @fn static void cell_ref_to_row_col(char *ref, int *row, int *col)
+   *
+   *  @brief converts string cell reference to row and column
+   *
+   *  @p ref is in form "A1", or "YX120"
+   *
+   *  @param ref - string cell reference
+   *  @param row - pointer to integer to store extracted row
+   *  @param col - pointer to integer to store extracted col
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void cell_ref_to_row_col(char *ref, int *row, int *col)
+{
+  char *p;
+  int c;
+  int i;
+  int prod;
+  int mag = 0;
+
+  *row = *col = 0;
+
+  if (!ref || !row || !col) return;
+
+  p = ref;
+  while (isalpha(*p)) ++p;
+  *row = atoi(p) - 1;
+
+  --p;
+
+  while (p >= ref)
+  {
+    c = (*p - 'A' + 1);
+    for (prod = 1, i = 0; i < mag; i++)
+      prod *= 26;
+    *col += c * prod;
+    ++mag;
+    --p;
+  }
+
+  *col -= 1;
+
+  return;
+}
+
+  /**
+   *  @fn static int is_office(libo *l)
+   *
+   *  @brief determines if contents of @p l is legitimate Office document
+   *
+   *  @param l - pointer to existing @a libo struct, with ZIP contents
+   *
+   *  @return 1 if Office document, 0 for anything else
+   */
+
+static int is_office(libo *l)
+{
+  zip_int64_t n_entries;
+  int i;
+  char *name;
+  int have_core = 0;
+  int have_app = 0;
+
+  if (!l) return 0;
+  if (!l->z) return 0;
+
+  n_entries = zip_get_num_entries(l->z, 0);
+
+  for (i = 0; i < n_entries; i++)
+  {
+    name = (char *)zip_get_name(l->z, i, 0);
+    if (!strcmp(name, "docProps/core.xml")) have_core = 1;
+    if (!strcmp(name, "docProps/app.xml")) have_app = 1;
+
+    if (have_core && have_app) return 1;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static void do_indent(FILE *stream, int indent)
+   *
+   *  @brief emits @p indent spaces to @p stream
+   *
+   *  @param stream - open FILE * for writing
+   *  @param indent - number of spaces to output
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void do_indent(FILE *stream, int indent)
+{
+  int i;
+
+  if (!stream) return;
+
+  for (i = 0; i < indent; i++) fputc(' ', stream);
+
+  return;
+}
+
+  /**
+   *  @fn static int is_supported(libo *l)
+   *
+   *  @brief determines if this Office document is currently implemented
+   *
+   *  @param l - pointer to existing @a libo struct, with ZIP contents
+   *
+   *  @return 1 implemented, 0 otherwise
+   */
+
+static int is_supported(libo *l)
+{
+  if (!l) return 0;
+
+  switch (l->type)
+  {
+    case libo_type_xl:
+      return 1;
+
+    case libo_type_none:
+    case libo_type_doc:
+    case libo_type_pp:
+    default:
+      return 0;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static libo_type get_type(libo *l)
+   *
+   *  @brief returns Office document type from @p l
+   *
+   *  @param l - pointer to existing @a libo struct, with ZIP contents
+   *
+   *  @return @a libo_type of document
+   */
+
+static libo_type get_type(libo *l)
+{
+  zip_file_t *zf;
+  int len;
+  char *buf;
+  char *app_file_name = "docProps/app.xml";
+  zip_stat_t stat;
+  xmlDocPtr doc = NULL;
+  libo_type type = libo_type_none;
+
+  if (!l) return libo_type_none;
+
+    // open docProps/app.xml
+
+  if (zip_stat(l->z, app_file_name, 0, &stat)) return libo_type_none;
+  if (!((stat.valid & ZIP_STAT_NAME) && (stat.valid & ZIP_STAT_SIZE))) return libo_type_none;
+
+  if (strcmp(app_file_name, stat.name)) return libo_type_none;
+
+  len = stat.size;
+
+  zf = zip_fopen(l->z, app_file_name, 0);
+  if (!zf)
+  {
+    fprintf(stderr, "Can not open '%s'\n", app_file_name); fflush(stderr);
+    return libo_type_none;
+  }
+
+  buf = (char *)malloc(len+1);
+  if (!buf)
+  {
+    zip_fclose(zf);
+    return libo_type_none;
+  }
+  memset(buf, 0, len+1);
+
+  zip_fread(zf, buf, len);
+
+  zip_fclose(zf);
+
+  doc = xmlParseMemory(buf, len);
+  if (!doc)
+  {
+    fprintf(stderr, "Failed to parse app.xml\n"); fflush(stderr);
+    return libo_type_none;
+  }
+  free(buf);
+
+    // find entry for document type
+
+  buf = find_app_type_name_in_xml(doc);
+
+  xmlFreeDoc(doc);
+
+  if (!buf) return libo_type_none;
+
+    // convert to libo_type
+
+  if (!strcmp(buf, "Microsoft Excel")) type = libo_type_xl;
+
+  free(buf);
+
+  return type;
+}
+
+  /**
+   *  @fn static char *find_app_type_name_in_xml(xmlDocPtr doc)
+   *
+   *  @brief locates application type name in XML document
+   *
+   *  @param doc - pointer to XML document
+   *
+   *  @return string containing application type name
+   */
+
+static char *find_app_type_name_in_xml(xmlDocPtr doc)
+{
+  xmlXPathContextPtr xpathCtx; 
+  xmlXPathObjectPtr xpathObj; 
+  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'Properties']/*[local-name() = 'Application']";
+  xmlNodeSetPtr nodes;
+  xmlNodePtr node;
+  char *app_type_name = NULL;
+
+  if (!doc) return NULL;
+
+  xpathCtx = xmlXPathNewContext(doc);
+  if(!xpathCtx)
+  {
+    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
+    return NULL;
+  }
+
+  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
+  if(!xpathObj)
+  {
+      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
+      xmlXPathFreeContext(xpathCtx); 
+      return NULL;
+  }
+
+  nodes = xpathObj->nodesetval;
+  if (nodes)
+  {
+    for (int i = 0; i < nodes->nodeNr; i++)
+    {
+      if (!nodes->nodeTab[i]) continue;
+      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
+      {
+        node = nodes->nodeTab[i];
+        app_type_name = (char *)xmlNodeListGetString(doc, node->xmlChildrenNode, 1);
+        break;
+      }
+    }
+  }
+
+  xmlXPathFreeObject(xpathObj);
+  xmlXPathFreeContext(xpathCtx); 
+
+  return app_type_name;
+}
+
+  /**
+   *  @fn static int count_sheets_in_xml(xmlDocPtr doc)
+   *
+   *  @brief returns number of work sheets in XML document
+   *
+   *  @param doc - pointer to XML document
+   *
+   *  @return count of work sheets
+   */
+
+static int count_sheets_in_xml(xmlDocPtr doc)
+{
+  xmlXPathContextPtr xpathCtx; 
+  xmlXPathObjectPtr xpathObj; 
+  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'workbook']/*[local-name() = 'sheets']";
+  xmlNodeSetPtr nodes;
+  xmlNodePtr node;
+  int count = 0;
+
+  if (!doc) return 0;
+
+  xpathCtx = xmlXPathNewContext(doc);
+  if(!xpathCtx)
+  {
+    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
+    return 0;
+  }
+
+  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
+  if(!xpathObj)
+  {
+      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
+      xmlXPathFreeContext(xpathCtx); 
+      return 0;
+  }
+
+  nodes = xpathObj->nodesetval;
+  if (nodes)
+  {
+    for (int i = 0; i < nodes->nodeNr; i++)
+    {
+      if (!nodes->nodeTab[i]) continue;
+      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
+      {
+        node = nodes->nodeTab[i];
+        if (!strcmp((char *)node->name, "sheets"))
+        {
+          count = xmlChildElementCount(node);
+          break;
+        }
+      }
+    }
+  }
+
+  xmlXPathFreeObject(xpathObj);
+  xmlXPathFreeContext(xpathCtx); 
+
+  return count;
+}
+
+  /**
+   *  @fn static int count_sheet_rows_in_xml(xmlDocPtr doc)
+   *
+   *  @brief returns number of work sheet rows in XML document
+   *
+   *  @param doc - pointer to XML document
+   *
+   *  @return count of rows
+   */
+
+static int count_sheet_rows_in_xml(xmlDocPtr doc)
+{
+  xmlXPathContextPtr xpathCtx; 
+  xmlXPathObjectPtr xpathObj; 
+  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'worksheet']/*[local-name() = 'sheetData']";
+  xmlNodeSetPtr nodes;
+  xmlNodePtr node;
+  int count = 0;
+
+  if (!doc) return 0;
+
+  xpathCtx = xmlXPathNewContext(doc);
+  if(!xpathCtx)
+  {
+    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
+    return 0;
+  }
+
+  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
+  if(!xpathObj)
+  {
+      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
+      xmlXPathFreeContext(xpathCtx); 
+      return 0;
+  }
+
+  nodes = xpathObj->nodesetval;
+  if (nodes)
+  {
+    for (int i = 0; i < nodes->nodeNr; i++)
+    {
+      if (!nodes->nodeTab[i]) continue;
+      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
+      {
+        node = nodes->nodeTab[i];
+        if (!strcmp((char *)node->name, "sheetData"))
+        {
+          count = xmlChildElementCount(node);
+          break;
+        }
+      }
+    }
+  }
+
+  xmlXPathFreeObject(xpathObj);
+  xmlXPathFreeContext(xpathCtx); 
+
+  return count;
+}
+
+  /**
+   *  @fn static int count_sheet_columns_in_xml(xmlDocPtr doc)
+   *
+   *  @brief returns number of work sheet columns in XML document
+   *
+   *  @param doc - pointer to XML document
+   *
+   *  @return count of columns
+   */
+
+static int count_sheet_columns_in_xml(xmlDocPtr doc)
+{
+  xmlXPathContextPtr xpathCtx; 
+  xmlXPathObjectPtr xpathObj; 
+  xmlChar *xpathExpr = (xmlChar *)"/*[local-name() = 'worksheet']/*[local-name() = 'sheetData']/*[local-name() = 'row']";
+  xmlNodeSetPtr nodes;
+  xmlNodePtr node;
+  int count = 0;
+  char *spans;
+  char *p;
+
+  if (!doc) return 0;
+
+  xpathCtx = xmlXPathNewContext(doc);
+  if(!xpathCtx)
+  {
+    fprintf(stderr,"Error: unable to create new XPath context\n"); fflush(stdout);
+    return 0;
+  }
+
+  xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
+  if(!xpathObj)
+  {
+      fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
+      xmlXPathFreeContext(xpathCtx); 
+      return 0;
+  }
+
+  nodes = xpathObj->nodesetval;
+  if (nodes)
+  {
+    for (int i = 0; i < nodes->nodeNr; i++)
+    {
+      if (!nodes->nodeTab[i]) continue;
+      if (nodes->nodeTab[i]->type == XML_ELEMENT_NODE)
+      {
+        node = nodes->nodeTab[i];
+        if (!strcmp((char *)node->name, "row"))
+        {
+          spans = (char *)xmlGetProp(node, (xmlChar *)"spans");
+          if (spans)
+          {
+            p = strchr(spans, ':');
+            if (p)
+            {
+              ++p;
+              count = atoi(p);
+            }
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  xmlXPathFreeObject(xpathObj);
+  xmlXPathFreeContext(xpathCtx); 
+
+  return count;
+}
+
+  /**
+   *  @fn static libo_xl_cell_type string_to_libo_xl_cell_type(char *s)
+   *
+   *  @brief converts string representation of cell type to @a libo_xl_cell_type
+   *
+   *  @param s - string representation of cell type
+   *
+   *  @return @a libo_xl_cell_type
+   */
+
+static libo_xl_cell_type string_to_libo_xl_cell_type(char *s)
+{
+  if (!s) return libo_xl_cell_type_none;
+
+  if (!strcmp(s, "s")) return libo_xl_cell_type_reference;
+  if (!strcmp(s, "e")) return libo_xl_cell_type_error;
+  if (!strcmp(s, "b")) return libo_xl_cell_type_boolean;
+  if (!strcmp(s, "str")) return libo_xl_cell_type_expression;
+  if (!strcmp(s, "n")) return libo_xl_cell_type_number;
+
+  return libo_xl_cell_type_none;
+}
+
+  /**
+   *  @fn static int libo_xl_write(libo *l)
+   *
+   *  @brief writes XL document to file
+   *
+   *  @param l - pointer to existing @a libo struct
+   *
+   *  @return 0 on success, STDIO error on failure
+   */
+
+static int libo_xl_write(libo *l)
+{
+  int success = -1;
+
+    // create required directories in zip file
+
+  if (!l) goto bail;
+  if (!l->z) goto bail;
+
+/*
+  if ((zip_dir_add(l->z, "_rels", 0)) < 0) goto bail;
+  if ((zip_dir_add(l->z, "docProps", 0)) < 0) goto bail;
+  if ((zip_dir_add(l->z, "xl", 0)) < 0) goto bail;
+  if ((zip_dir_add(l->z, "xl/_rels", 0)) < 0) goto bail;
+  if ((zip_dir_add(l->z, "xl/theme", 0)) < 0) goto bail;
+  if ((zip_dir_add(l->z, "xl/worksheets", 0)) < 0) goto bail;
+*/
+
+  libo_xl_content_types_write(l);
+  libo_xl_docprops_write(l);
+  libo_xl__rels_dot_rels_write(l);
+  libo_xl_xl_rels_write(l);
+  libo_xl_themes_write(l);
+  libo_xl_styles_write(l);
+  libo_xl_workbook_write(l);
+  libo_xl_sheets_write(l);
+  libo_xl_shared_strings_write(l);
+
+  success = 0;
+
+bail:
+  return success;
+}
+
+#include "libo-xl-theme.c"
+
+  /**
+   *  @fn int libo_xl_themes_write(libo *l)
+   *
+   *  @brief writes XL themes to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_themes_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+
+  if (!l || !l->z) return -1;
+
+  zs = zip_source_buffer_create(libo_xl_theme_standard, strlen(libo_xl_theme_standard), 0, &err);
+  if (!zs) return -1;
+
+  if ((zip_file_add(l->z, "xl/theme/theme1.xml", zs, 0)) < 0) return -1;
+
+  return 0;
+}
+
+#include "libo-xl-styles.c"
+
+  /**
+   *  @fn int libo_xl_styles_write(libo *l)
+   *
+   *  @brief writes XL styles to document file
+   *
+   *  Only cell formats some cell has, and what they refer to, are written,
+   *  renumbered in order.  Cells are written with the new numbers.
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_styles_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  libo_xl_styles *styles;
+  unsigned char *used;
+  char *buf = NULL;
+  int success = -1;
+
+  if (!l || !l->z) goto bail;
+
+  styles = libo_xl_get_styles(l->xl);
+  if (!styles) goto bail;
+
+  used = styles_used(l->xl->book, styles);
+  if (!used) goto bail;
+
+  buf = styles_xml(styles, used);
+  free(used);
+  if (!buf) goto bail;
+
+  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+  if (!zs) goto bail;
+
+  if ((zip_file_add(l->z, "xl/styles.xml", zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+
+  return success;
+}
+
+  /**
+   *  @fn static int style_slots_grow(int **slot,
+   *                                  int *n_slots,
+   *                                  unsigned long *hash,
+   *                                  int n)
+   *
+   *  @brief makes room in open addressed table @p slot, holding @p n
+   *         entries with hashes @p hash, for one more
+   *
+   *  Tables are kept at most half full, and rebuilt as they grow.
+   *
+   *  @param slot - pointer to table, NULL if none
+   *  @param n_slots - pointer to number of slots of table, a power of two
+   *  @param hash - hash of each entry
+   *  @param n - number of entries
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int style_slots_grow(int **slot, int *n_slots, unsigned long *hash, int n)
+{
+  int *nslot;
+  int size;
+  int i;
+
+  if ((n + 1) * 2 <= *n_slots) return 0;
+
+  size = *n_slots ? *n_slots : 16;
+  while ((n + 1) * 2 > size) size *= 2;
+
+  nslot = (int *)malloc(sizeof(int) * size);
+  if (!nslot) return -1;
+  memset(nslot, 0xff, sizeof(int) * size);
+
+  for (i = 0; i < n; i++)
+    style_slot_put(nslot, size, hash[i], i);
+
+  free(*slot);
+  *slot = nslot;
+  *n_slots = size;
+
+  return 0;
+}
+
+  /**
+   *  @fn static void style_slot_put(int *slot,
+   *                                 int n_slots,
+   *                                 unsigned long h,
+   *                                 int index)
+   *
+   *  @brief puts entry @p index with hash @p h in first free slot of @p slot
+   *
+   *  Entries with the same key are found in the order they were put, so a
+   *  lookup finds the first.
+   *
+   *  @param slot - open addressed table, with a free slot
+   *  @param n_slots - number of slots of @p slot, a power of two
+   *  @param h - hash of entry
+   *  @param index - index of entry
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void style_slot_put(int *slot, int n_slots, unsigned long h, int index)
+{
+  int i;
+
+  for (i = h & (n_slots - 1); slot[i] >= 0; i = (i + 1) & (n_slots - 1));
+
+  slot[i] = index;
+}
+
+  /**
+   *  @fn static int style_pool_find(style_pool *pool, const char *text)
+   *
+   *  @brief finds entry of @p pool holding @p text
+   *
+   *  @param pool - pointer to existing @a style_pool struct
+   *  @param text - text of entry
+   *
+   *  @return index of first entry holding @p text, -1 if none
+   */
+
+static int style_pool_find(style_pool *pool, const char *text)
+{
+  unsigned long h;
+  int i;
+
+  if (!pool->n_slots) return -1;
+
+  h = hash_string((char *)text);
+
+  for (i = h & (pool->n_slots - 1); pool->slot[i] >= 0; i = (i + 1) & (pool->n_slots - 1))
+  {
+    if ((pool->hash[pool->slot[i]] == h) && !strcmp(pool->text[pool->slot[i]], text))
+      return pool->slot[i];
+  }
+
+  return -1;
+}
+
+  /**
+   *  @fn static int style_pool_put(style_pool *pool,
+   *                                const char *text,
+   *                                int intern)
+   *
+   *  @brief adds copy of @p text to end of @p pool
+   *
+   *  Entries read from a style sheet are added even when the same as an
+   *  earlier one, as cell formats refer to them by position.
+   *
+   *  @param pool - pointer to existing @a style_pool struct
+   *  @param text - text of entry
+   *  @param intern - 1 to give the index of an entry holding @p text, if
+   *                  any, rather than add it
+   *
+   *  @return index of entry, -1 on failure
+   */
+
+static int style_pool_put(style_pool *pool, const char *text, int intern)
+{
+  char **ntext;
+  unsigned long *nhash;
+  int size;
+  int i;
+
+  if (intern)
+  {
+    i = style_pool_find(pool, text);
+    if (i >= 0) return i;
+  }
+
+  if (pool->n == pool->size)
+  {
+    size = pool->size ? pool->size * 2 : 8;
+
+    ntext = (char **)realloc(pool->text, sizeof(char *) * size);
+    if (!ntext) return -1;
+    pool->text = ntext;
+
+    nhash = (unsigned long *)realloc(pool->hash, sizeof(unsigned long) * size);
+    if (!nhash) return -1;
+    pool->hash = nhash;
+
+    pool->size = size;
+  }
+
+  if (style_slots_grow(&pool->slot, &pool->n_slots, pool->hash, pool->n)) return -1;
+
+  pool->text[pool->n] = strdup(text);
+  if (!pool->text[pool->n]) return -1;
+
+  pool->hash[pool->n] = hash_string((char *)text);
+  style_slot_put(pool->slot, pool->n_slots, pool->hash[pool->n], pool->n);
+
+  return pool->n++;
+}
+
+  /**
+   *  @fn static void style_pool_clear(style_pool *pool)
+   *
+   *  @brief frees entries of @p pool, leaving it empty
+   *
+   *  @param pool - pointer to existing @a style_pool struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void style_pool_clear(style_pool *pool)
+{
+  int i;
+
+  for (i = 0; i < pool->n; i++)
+    free(pool->text[i]);
+
+  free(pool->text);
+  free(pool->hash);
+  free(pool->slot);
+
+  memset(pool, 0, sizeof(style_pool));
+}
+
+  /**
+   *  @fn static unsigned long style_hash(libo_xl_style *style)
+   *
+   *  @brief returns hash of cell format @p style
+   *
+   *  @param style - pointer to existing @a libo_xl_style struct
+   *
+   *  @return hash value
+   */
+
+static unsigned long style_hash(libo_xl_style *style)
+{
+  int key[7];
+
+  key[0] = style->number_format;
+  key[1] = style->font;
+  key[2] = style->fill;
+  key[3] = style->border;
+  key[4] = style->parent;
+  key[5] = style->flags;
+  key[6] = style->cleared;
+
+  return hash_bytes(hash_string(style->alignment ? style->alignment : (char *)""), key, sizeof(key));
+}
+
+  /**
+   *  @fn static int style_same(libo_xl_style *a, libo_xl_style *b)
+   *
+   *  @brief tests whether cell formats @p a and @p b are the same
+   *
+   *  @param a - pointer to existing @a libo_xl_style struct
+   *  @param b - pointer to existing @a libo_xl_style struct
+   *
+   *  @return 1 if the same, 0 otherwise
+   */
+
+static int style_same(libo_xl_style *a, libo_xl_style *b)
+{
+  if (a->number_format != b->number_format) return 0;
+  if ((a->font != b->font) || (a->fill != b->fill) || (a->border != b->border)) return 0;
+  if ((a->parent != b->parent) || (a->flags != b->flags) || (a->cleared != b->cleared)) return 0;
+
+  if (!a->alignment || !b->alignment) return a->alignment == b->alignment;
+
+  return !strcmp(a->alignment, b->alignment);
+}
+
+  /**
+   *  @fn static int style_attr_int(xmlNodePtr node, char *name)
+   *
+   *  @brief returns value of integer attribute @p name of @p node
+   *
+   *  @param node - element
+   *  @param name - name of attribute
+   *
+   *  @return value of attribute, 0 if missing
+   */
+
+static int style_attr_int(xmlNodePtr node, char *name)
+{
+  char *value;
+  int n = 0;
+
+  value = (char *)xmlGetProp(node, (xmlChar *)name);
+  if (value) n = atoi(value);
+  xmlFree(value);
+
+  return n;
+}
+
+  /**
+   *  @fn static char *style_node_xml(xmlDocPtr doc,
+   *                                  xmlNodePtr node,
+   *                                  int children)
+   *
+   *  @brief returns XML of @p node, or of its child elements
+   *
+   *  @param doc - document holding @p node
+   *  @param node - element
+   *  @param children - 1 for child elements of @p node, 0 for @p node
+   *
+   *  @return new string, to be freed, NULL if there is no XML
+   */
+
+static char *style_node_xml(xmlDocPtr doc, xmlNodePtr node, int children)
+{
+  xmlBufferPtr buf;
+  xmlNodePtr child;
+  char *xml = NULL;
+
+  buf = xmlBufferCreate();
+  if (!buf) return NULL;
+
+  if (!children)
+    xmlNodeDump(buf, doc, node, 0, 0);
+  else
+  {
+    for (child = node->children; child; child = child->next)
+      if (child->type == XML_ELEMENT_NODE) xmlNodeDump(buf, doc, child, 0, 0);
+  }
+
+  if (xmlBufferLength(buf)) xml = strdup((char *)xmlBufferContent(buf));
+  xmlBufferFree(buf);
+
+  return xml;
+}
+
+  /**
+   *  @fn static void style_parse_xf(xmlDocPtr doc,
+   *                                 xmlNodePtr node,
+   *                                 libo_xl_style *style)
+   *
+   *  @brief fills @p style from xf element @p node
+   *
+   *  @param doc - document holding @p node
+   *  @param node - xf element
+   *  @param style - pointer to @a libo_xl_style to fill, whose alignment
+   *                 is then to be freed
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void style_parse_xf(xmlDocPtr doc, xmlNodePtr node, libo_xl_style *style)
+{
+  char *value;
+  int i;
+
+  memset(style, 0, sizeof(libo_xl_style));
+
+  style->number_format = style_attr_int(node, "numFmtId");
+  style->font = style_attr_int(node, "fontId");
+  style->fill = style_attr_int(node, "fillId");
+  style->border = style_attr_int(node, "borderId");
+  style->parent = style_attr_int(node, "xfId");
+
+  for (i = 0; i < (int)(sizeof(_xl_style_flags) / sizeof(_xl_style_flags[0])); i++)
+  {
+    value = (char *)xmlGetProp(node, (xmlChar *)_xl_style_flags[i]);
+    if (value && (!strcmp(value, "1") || !strcmp(value, "true"))) style->flags |= 1 << i;
+    if (value && (!strcmp(value, "0") || !strcmp(value, "false"))) style->cleared |= 1 << i;
+    xmlFree(value);
+  }
+
+  style->alignment = style_node_xml(doc, node, 1);
+}
+
+  /**
+   *  @fn static int styles_put_style(libo_xl_styles *styles,
+   *                                  libo_xl_style *style,
+   *                                  int intern)
+   *
+   *  @brief adds copy of cell format @p style to end of @p styles
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param style - cell format
+   *  @param intern - 1 to give the index of a format the same as @p style,
+   *                  if any, rather than add it
+   *
+   *  @return index of cell format, -1 on failure
+   */
+
+static int styles_put_style(libo_xl_styles *styles, libo_xl_style *style, int intern)
+{
+  libo_xl_style *nstyle;
+  unsigned long *nhash;
+  unsigned char *ndate;
+  unsigned long h;
+  int size;
+  int i;
+
+  h = style_hash(style);
+
+  if (intern && styles->n_slots)
+  {
+    for (i = h & (styles->n_slots - 1); styles->slot[i] >= 0; i = (i + 1) & (styles->n_slots - 1))
+    {
+      if ((styles->hash[styles->slot[i]] == h) && style_same(&styles->style[styles->slot[i]], style))
+        return styles->slot[i];
+    }
+  }
+
+  if (styles->n_styles >= LIBO_XL_STYLES_MAX) return -1;
+
+  if (styles->n_styles == styles->size_styles)
+  {
+    size = styles->size_styles ? styles->size_styles * 2 : 16;
+
+    nstyle = (libo_xl_style *)realloc(styles->style, sizeof(libo_xl_style) * size);
+    if (!nstyle) return -1;
+    styles->style = nstyle;
+
+    nhash = (unsigned long *)realloc(styles->hash, sizeof(unsigned long) * size);
+    if (!nhash) return -1;
+    styles->hash = nhash;
+
+    ndate = (unsigned char *)realloc(styles->date, size);
+    if (!ndate) return -1;
+    styles->date = ndate;
+
+    styles->size_styles = size;
+  }
+
+  if (style_slots_grow(&styles->slot, &styles->n_slots, styles->hash, styles->n_styles)) return -1;
+
+  nstyle = &styles->style[styles->n_styles];
+  *nstyle = *style;
+  if (style->alignment)
+  {
+    nstyle->alignment = strdup(style->alignment);
+    if (!nstyle->alignment) return -1;
+  }
+
+  styles->hash[styles->n_styles] = h;
+  style_slot_put(styles->slot, styles->n_slots, h, styles->n_styles);
+
+    // whether a format shows dates is resolved once, as it is added
+
+  styles->date[styles->n_styles] = styles_format_is_date(styles, style->number_format);
+
+  return styles->n_styles++;
+}
+
+  /**
+   *  @fn static int styles_put_format(libo_xl_styles *styles,
+   *                                   const char *code,
+   *                                   int id)
+   *
+   *  @brief adds custom number format @p code to @p styles
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param code - format code
+   *  @param id - id of format as read, or -1 to give the id of a format
+   *              the same as @p code, if any, or else the next free id
+   *
+   *  @return id of number format, -1 on failure
+   */
+
+static int styles_put_format(libo_xl_styles *styles, const char *code, int id)
+{
+  int *nid;
+  int i;
+
+  if (id < 0)
+  {
+    i = style_pool_find(&styles->format, code);
+    if (i >= 0) return styles->format_id[i];
+    id = styles->next_format;
+  }
+
+  nid = (int *)realloc(styles->format_id, sizeof(int) * (styles->format.n + 1));
+  if (!nid) return -1;
+  styles->format_id = nid;
+
+  i = style_pool_put(&styles->format, code, 0);
+  if (i < 0) return -1;
+
+  styles->format_id[i] = id;
+  if (id >= styles->next_format) styles->next_format = id + 1;
+
+  return id;
+}
+
+  /**
+   *  @fn static int styles_format_is_date(libo_xl_styles *styles, int id)
+   *
+   *  @brief tells whether number format @p id of @p styles shows a date
+   *
+   *  Built in formats without a code, 27 to 36 and 50 to 58, are dates in
+   *  the locales that have them.
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param id - id of number format
+   *
+   *  @return 1 if format @p id shows a date or time, 0 otherwise
+   */
+
+static int styles_format_is_date(libo_xl_styles *styles, int id)
+{
+  const char *code;
+
+  code = libo_xl_styles_get_number_format(styles, id);
+  if (code) return libo_xl_number_format_is_date(code);
+
+  return ((id >= 27) && (id <= 36)) || ((id >= 50) && (id <= 58));
+}
+
+  /**
+   *  @fn static int64_t date_serial_to_epoch(int64_t ms, int64_t date1904)
+   *
+   *  @brief converts serial date @p ms, in milliseconds, to milliseconds
+   *         since the epoch
+   *
+   *  Days before the fictitious 29 February 1900 are one day later in the
+   *  1900 date system.  Both corrections are masks, not branches, so loops
+   *  over the kernel vectorize.
+   *
+   *  @param ms - serial date in milliseconds
+   *  @param date1904 - 1 for the 1904 date system, 0 for the 1900 one
+   *
+   *  @return milliseconds since 1970-01-01 00:00:00 UTC
+   */
+
+static int64_t date_serial_to_epoch(int64_t ms, int64_t date1904)
+{
+  int64_t early = (ms < XL_LEAP_1900 * XL_DAY_MS) & (date1904 ^ 1);
+
+  return ms - XL_DAY_MS * (XL_EPOCH_1900 - (XL_EPOCH_1900 - XL_EPOCH_1904) * date1904) +
+         XL_DAY_MS * early;
+}
+
+  /**
+   *  @fn static int64_t date_epoch_to_serial(int64_t ms, int64_t date1904)
+   *
+   *  @brief converts @p ms milliseconds since the epoch to a serial date,
+   *         in milliseconds
+   *
+   *  @param ms - milliseconds since 1970-01-01 00:00:00 UTC
+   *  @param date1904 - 1 for the 1904 date system, 0 for the 1900 one
+   *
+   *  @return serial date in milliseconds
+   */
+
+static int64_t date_epoch_to_serial(int64_t ms, int64_t date1904)
+{
+  int64_t early = (ms < (XL_LEAP_1900 - XL_EPOCH_1900) * XL_DAY_MS) & (date1904 ^ 1);
+
+  return ms + XL_DAY_MS * (XL_EPOCH_1900 - (XL_EPOCH_1900 - XL_EPOCH_1904) * date1904) -
+         XL_DAY_MS * early;
+}
+
+  /**
+   *  @fn static int64_t date_serial_max(int64_t date1904)
+   *
+   *  @brief returns first serial date after 31 December 9999
+   *
+   *  @param date1904 - 1 for the 1904 date system, 0 for the 1900 one
+   *
+   *  @return serial date in days
+   */
+
+static int64_t date_serial_max(int64_t date1904)
+{
+  return XL_SERIAL_MAX - (XL_EPOCH_1900 - XL_EPOCH_1904) * date1904;
+}
+
+  /**
+   *  @fn static libo_xl_styles *styles_parse(xmlDocPtr doc)
+   *
+   *  @brief creates new @a libo_xl_styles struct from style sheet @p doc
+   *
+   *  Defaults Excel requires, such as the first font and the two first
+   *  fills, are added when the style sheet lacks them.
+   *
+   *  @param doc - parsed style sheet
+   *
+   *  @return pointer to new @a libo_xl_styles struct, NULL on failure
+   */
+
+static libo_xl_styles *styles_parse(xmlDocPtr doc)
+{
+  libo_xl_styles *styles;
+  libo_xl_style style;
+  libo_xl_style *nparent;
+  style_pool *pool;
+  xmlNodePtr root, node, child;
+  xmlAttrPtr attr;
+  xmlChar *text;
+  char **nname;
+  int *nname_parent;
+  char *attrs;
+  char *xml;
+  char *name;
+  int size_parents = 0;
+
+  styles = (libo_xl_styles *)calloc(1, sizeof(libo_xl_styles));
+  if (!styles) return NULL;
+
+  styles->next_format = XL_CUSTOM_FORMATS;
+
+  root = xmlDocGetRootElement(doc);
+  if (!root || strcmp((char *)root->name, "styleSheet")) goto bail;
+
+  for (node = root->children; node; node = node->next)
+  {
+    if (node->type != XML_ELEMENT_NODE) continue;
+    name = (char *)node->name;
+
+    if (!strcmp(name, "numFmts"))
+    {
+      for (child = node->children; child; child = child->next)
+      {
+        if ((child->type != XML_ELEMENT_NODE) || strcmp((char *)child->name, "numFmt")) continue;
+
+        text = xmlGetProp(child, (xmlChar *)"formatCode");
+        if (text && (styles_put_format(styles, (char *)text, style_attr_int(child, "numFmtId")) < 0))
+        {
+          xmlFree(text);
+          goto bail;
+        }
+        xmlFree(text);
+      }
+    }
+    else if (!strcmp(name, "fonts") || !strcmp(name, "fills") || !strcmp(name, "borders"))
+    {
+      pool = (*name == 'f') ? ((name[2] == 'n') ? &styles->font : &styles->fill) : &styles->border;
+
+      for (child = node->children; child; child = child->next)
+      {
+        if (child->type != XML_ELEMENT_NODE) continue;
+
+        xml = style_node_xml(doc, child, 0);
+        if (!xml || (style_pool_put(pool, xml, 0) < 0))
+        {
+          free(xml);
+          goto bail;
+        }
+        free(xml);
+      }
+    }
+    else if (!strcmp(name, "cellStyleXfs") || !strcmp(name, "cellXfs"))
+    {
+      for (child = node->children; child; child = child->next)
+      {
+        if ((child->type != XML_ELEMENT_NODE) || strcmp((char *)child->name, "xf")) continue;
+
+        style_parse_xf(doc, child, &style);
+
+        if (name[4] == 'X')
+        {
+            // files with more formats than cells can refer to keep the first
+
+          styles_put_style(styles, &style, 0);
+          free(style.alignment);
+          continue;
+        }
+
+        if (styles->n_parents == size_parents)
+        {
+          size_parents = size_parents ? size_parents * 2 : 16;
+          nparent = (libo_xl_style *)realloc(styles->parent, sizeof(libo_xl_style) * size_parents);
+          if (!nparent)
+          {
+            free(style.alignment);
+            goto bail;
+          }
+          styles->parent = nparent;
+        }
+        styles->parent[styles->n_parents++] = style;
+      }
+    }
+    else if (!strcmp(name, "cellStyles"))
+    {
+      for (child = node->children; child; child = child->next)
+      {
+        if ((child->type != XML_ELEMENT_NODE) || strcmp((char *)child->name, "cellStyle")) continue;
+
+          // attributes other than xfId are kept as written
+
+        attrs = strapp(NULL, "");
+        for (attr = child->properties; attrs && attr; attr = attr->next)
+        {
+          if (!strcmp((char *)attr->name, "xfId")) continue;
+
+          attrs = strapp(attrs, " ");
+          if (attr->ns && attr->ns->prefix)
+          {
+            attrs = strapp(attrs, (char *)attr->ns->prefix);
+            attrs = strapp(attrs, ":");
+          }
+          attrs = strapp(attrs, (char *)attr->name);
+          attrs = strapp(attrs, "=\"");
+
+          text = xmlNodeGetContent((xmlNodePtr)attr);
+          xml = (char *)xmlEncodeSpecialChars(doc, text);
+          attrs = strapp(attrs, xml);
+          xmlFree(xml);
+          xmlFree(text);
+
+          attrs = strapp(attrs, "\"");
+        }
+        if (!attrs) goto bail;
+
+        nname = (char **)realloc(styles->name, sizeof(char *) * (styles->n_names + 1));
+        if (nname) styles->name = nname;
+        nname_parent = (int *)realloc(styles->name_parent, sizeof(int) * (styles->n_names + 1));
+        if (nname_parent) styles->name_parent = nname_parent;
+        if (!nname || !nname_parent)
+        {
+          free(attrs);
+          goto bail;
+        }
+
+        styles->name[styles->n_names] = attrs;
+        styles->name_parent[styles->n_names++] = style_attr_int(child, "xfId");
+      }
+    }
+    else if (!strcmp(name, "dxfs") || !strcmp(name, "tableStyles") ||
+             !strcmp(name, "colors") || !strcmp(name, "extLst"))
+    {
+      xml = style_node_xml(doc, node, 0);
+      styles->rest = strapp(styles->rest, xml);
+      free(xml);
+    }
+  }
+
+    // defaults cells without a format rely on
+
+  if (!styles->font.n &&
+      (style_pool_put(&styles->font, "<font><sz val=\"11\"/><name val=\"Calibri\"/><family val=\"2\"/></font>", 0) < 0))
+    goto bail;
+  if (!styles->fill.n &&
+      ((style_pool_put(&styles->fill, "<fill><patternFill patternType=\"none\"/></fill>", 0) < 0) ||
+       (style_pool_put(&styles->fill, "<fill><patternFill patternType=\"gray125\"/></fill>", 0) < 0)))
+    goto bail;
+  if (!styles->border.n &&
+      (style_pool_put(&styles->border, "<border><left/><right/><top/><bottom/><diagonal/></border>", 0) < 0))
+    goto bail;
+
+  memset(&style, 0, sizeof(libo_xl_style));
+
+  if (!styles->n_parents)
+  {
+    styles->parent = (libo_xl_style *)calloc(1, sizeof(libo_xl_style));
+    if (!styles->parent) goto bail;
+    styles->n_parents = 1;
+  }
+  if (!styles->n_styles && (styles_put_style(styles, &style, 0) < 0)) goto bail;
+
+  if (!styles->n_names)
+  {
+    styles->name = (char **)malloc(sizeof(char *));
+    styles->name_parent = (int *)calloc(1, sizeof(int));
+    if (!styles->name || !styles->name_parent) goto bail;
+    styles->name[0] = strdup(" name=\"Normal\" builtinId=\"0\"");
+    if (!styles->name[0]) goto bail;
+    styles->n_names = 1;
+  }
+
+  return styles;
+
+bail:
+  libo_xl_styles_free(styles);
+
+  return NULL;
+}
+
+  /**
+   *  @fn static libo_xl_styles *styles_new_standard(void)
+   *
+   *  @brief creates new @a libo_xl_styles struct holding the standard
+   *         style sheet, given to workbooks that were not read with one
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_styles struct, NULL on failure
+   */
+
+static libo_xl_styles *styles_new_standard(void)
+{
+  libo_xl_styles *styles;
+  xmlDocPtr doc;
+
+  doc = xmlParseMemory(libo_xl_styles_standard, strlen(libo_xl_styles_standard));
+  if (!doc) return NULL;
+
+  styles = styles_parse(doc);
+
+  xmlFreeDoc(doc);
+
+  return styles;
+}
+
+  /**
+   *  @fn static libo_xl_styles *styles_dup(libo_xl_styles *styles)
+   *
+   *  @brief creates a deep copy of @p styles
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *
+   *  @return pointer to new @a libo_xl_styles struct, NULL on failure
+   */
+
+static libo_xl_styles *styles_dup(libo_xl_styles *styles)
+{
+  libo_xl_styles *nstyles;
+  xmlDocPtr doc;
+  char *xml;
+
+    // everything is written, so indices are kept
+
+  xml = styles_xml(styles, NULL);
+  if (!xml) return NULL;
+
+  doc = xmlParseMemory(xml, strlen(xml));
+  free(xml);
+  if (!doc) return NULL;
+
+  nstyles = styles_parse(doc);
+
+  xmlFreeDoc(doc);
+
+  return nstyles;
+}
+
+  /**
+   *  @fn static unsigned char *styles_used(libo_xl_book *book,
+   *                                        libo_xl_styles *styles)
+   *
+   *  @brief marks cell formats of @p styles some cell of @p book has
+   *
+   *  The first format, which cells without one have, is always marked.
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *
+   *  @return new array of a byte for each cell format, 1 if used, to be
+   *          freed, NULL on failure
+   */
+
+static unsigned char *styles_used(libo_xl_book *book, libo_xl_styles *styles)
+{
+  libo_xl_sheet *sheet;
+  libo_xl_row *row;
+  libo_xl_cell *cell;
+  unsigned char *used;
+  int i, j, k;
+
+  used = (unsigned char *)calloc(styles->n_styles ? styles->n_styles : 1, 1);
+  if (!used) return NULL;
+
+  used[0] = 1;
+
+  for (i = 0; book && (i < book->n_sheets); i++)
+  {
+    sheet = libo_xl_book_get_sheet(book, i);
+    if (!sheet) continue;
+
+    for (j = 0; j < sheet->n_rows; j++)
+    {
+      row = libo_xl_sheet_get_row(sheet, j);
+      for (k = 0; row && (k < row->n_cells); k++)
+      {
+        cell = row->cell[k];
+        if (cell && (cell->style < styles->n_styles)) used[cell->style] = 1;
+      }
+    }
+  }
+
+  return used;
+}
+
+  /**
+   *  @fn static char *styles_xf_xml(char *buf,
+   *                                 libo_xl_style *style,
+   *                                 int **map,
+   *                                 int *n,
+   *                                 int cell)
+   *
+   *  @brief appends xf element of @p style to @p buf
+   *
+   *  @param buf - string holding XML buffer
+   *  @param style - cell format, or cell style format
+   *  @param map - index written for each font, fill, border and cell
+   *               style format
+   *  @param n - number of entries of each of @p map
+   *  @param cell - 1 for a cell format, 0 for a cell style format
+   *
+   *  @return pointer to extended @p buf
+   */
+
+static char *styles_xf_xml(char *buf, libo_xl_style *style, int **map, int *n, int cell)
+{
+  char number[160];
+  int i;
+
+  sprintf(number, "<xf numFmtId=\"%d\" fontId=\"%d\" fillId=\"%d\" borderId=\"%d\"",
+          style->number_format,
+          ((style->font >= 0) && (style->font < n[0])) ? map[0][style->font] : 0,
+          ((style->fill >= 0) && (style->fill < n[1])) ? map[1][style->fill] : 0,
+          ((style->border >= 0) && (style->border < n[2])) ? map[2][style->border] : 0);
+  buf = strapp(buf, number);
+
+  if (cell)
+  {
+    sprintf(number, " xfId=\"%d\"",
+            ((style->parent >= 0) && (style->parent < n[3])) ? map[3][style->parent] : 0);
+    buf = strapp(buf, number);
+  }
+
+    // attributes given as 0 are kept, cell style formats apply what
+    // they leave out
+
+  for (i = 0; i < (int)(sizeof(_xl_style_flags) / sizeof(_xl_style_flags[0])); i++)
+  {
+    if (!((style->flags | style->cleared) & (1 << i))) continue;
+    buf = strapp(buf, " ");
+    buf = strapp(buf, (char *)_xl_style_flags[i]);
+    buf = strapp(buf, (style->flags & (1 << i)) ? "=\"1\"" : "=\"0\"");
+  }
+
+  if (!style->alignment) return strapp(buf, "/>");
+
+  buf = strapp(buf, ">");
+  buf = strapp(buf, style->alignment);
+
+  return strapp(buf, "</xf>");
+}
+
+  /**
+   *  @fn static char *styles_xml(libo_xl_styles *styles, unsigned char *used)
+   *
+   *  @brief returns style sheet of @p styles holding the cell formats
+   *         marked in @p used
+   *
+   *  Fonts, fills, borders, number formats and cell style formats no kept
+   *  cell format refers to are left out, and the rest renumbered in order.
+   *  The index each cell format is written with is left in the map of
+   *  @p styles.
+   *
+   *  @param styles - pointer to existing @a libo_xl_styles struct
+   *  @param used - byte for each cell format, 1 to keep it, or NULL to
+   *                keep everything, leaving the map of @p styles as it is
+   *
+   *  @return new string holding XML, to be freed, NULL on failure
+   */
+
+static char *styles_xml(libo_xl_styles *styles, unsigned char *used)
+{
+  style_pool *pool[3];
+  libo_xl_style *style;
+  unsigned char *keep[4] = { NULL, NULL, NULL, NULL };
+  unsigned char *keep_format = NULL;
+  int *map[4] = { NULL, NULL, NULL, NULL };
+  int *smap = NULL;
+  int n[4], count[4];
+  char *buf = NULL;
+  char number[64];
+  xmlChar *text;
+  int n_formats = 0;
+  int n_names = 0;
+  int n_kept = 0;
+  int i, j, k;
+
+  pool[0] = &styles->font;
+  pool[1] = &styles->fill;
+  pool[2] = &styles->border;
+
+  for (j = 0; j < 3; j++)
+    n[j] = pool[j]->n;
+  n[3] = styles->n_parents;
+
+  for (j = 0; j < 4; j++)
+  {
+    keep[j] = (unsigned char *)calloc(n[j] ? n[j] : 1, 1);
+    map[j] = (int *)calloc(n[j] ? n[j] : 1, sizeof(int));
+    if (!keep[j] || !map[j]) goto bail;
+  }
+
+  keep_format = (unsigned char *)calloc(styles->format.n ? styles->format.n : 1, 1);
+  smap = (int *)calloc(styles->n_styles ? styles->n_styles : 1, sizeof(int));
+  if (!keep_format || !smap) goto bail;
+
+    // cell formats kept, then what they refer to
+
+  for (i = 0; i < styles->n_styles; i++)
+  {
+    if (used && !used[i]) continue;
+
+    smap[i] = n_kept++;
+    style = &styles->style[i];
+    if ((style->parent >= 0) && (style->parent < n[3])) keep[3][style->parent] = 1;
+  }
+  if (n[3]) keep[3][0] = 1;
+
+  for (i = 0; i < styles->n_styles + n[3]; i++)
+  {
+    if (i < styles->n_styles)
+    {
+      if (used && !used[i]) continue;
+      style = &styles->style[i];
+    }
+    else
+    {
+      if (used && !keep[3][i - styles->n_styles]) continue;
+      style = &styles->parent[i - styles->n_styles];
+    }
+
+    if ((style->font >= 0) && (style->font < n[0])) keep[0][style->font] = 1;
+    if ((style->fill >= 0) && (style->fill < n[1])) keep[1][style->fill] = 1;
+    if ((style->border >= 0) && (style->border < n[2])) keep[2][style->border] = 1;
+
+    for (k = 0; k < styles->format.n; k++)
+    {
+      if (styles->format_id[k] != style->number_format) continue;
+      keep_format[k] = 1;
+      break;
+    }
+  }
+
+    // Excel expects the first font and border, and the first two fills
+
+  for (j = 0; j < 4; j++)
+  {
+    for (i = 0; i < n[j]; i++)
+      if (!used || (i < ((j == 1) ? 2 : 1))) keep[j][i] = 1;
+
+    for (i = 0, count[j] = 0; i < n[j]; i++)
+      if (keep[j][i]) map[j][i] = count[j]++;
+  }
+
+  for (k = 0; k < styles->format.n; k++)
+    if (!used || keep_format[k]) ++n_formats;
+
+  for (k = 0; k < styles->n_names; k++)
+  {
+    i = styles->name_parent[k];
+    if ((i >= 0) && (i < n[3]) && keep[3][i]) ++n_names;
+  }
+
+  buf = strapp(buf, "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                    "<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+                    "xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\" "
+                    "mc:Ignorable=\"x14ac x16r2 xr\" "
+                    "xmlns:x14ac=\"http://schemas.microsoft.com/office/spreadsheetml/2009/9/ac\" "
+                    "xmlns:x16r2=\"http://schemas.microsoft.com/office/spreadsheetml/2015/02/main\" "
+                    "xmlns:xr=\"http://schemas.microsoft.com/office/spreadsheetml/2014/revision\">");
+
+  if (n_formats)
+  {
+    sprintf(number, "<numFmts count=\"%d\">", n_formats);
+    buf = strapp(buf, number);
+    for (k = 0; k < styles->format.n; k++)
+    {
+      if (used && !keep_format[k]) continue;
+      sprintf(number, "<numFmt numFmtId=\"%d\" formatCode=\"", styles->format_id[k]);
+      buf = strapp(buf, number);
+      text = xmlEncodeSpecialChars(NULL, (xmlChar *)styles->format.text[k]);
+      buf = strapp(buf, (char *)text);
+      xmlFree(text);
+      buf = strapp(buf, "\"/>");
+    }
+    buf = strapp(buf, "</numFmts>");
+  }
+
+  for (j = 0; j < 3; j++)
+  {
+    sprintf(number, "<%s count=\"%d\">", (j == 0) ? "fonts" : (j == 1) ? "fills" : "borders", count[j]);
+    buf = strapp(buf, number);
+    for (i = 0; i < n[j]; i++)
+      if (keep[j][i]) buf = strapp(buf, pool[j]->text[i]);
+    buf = strapp(buf, (j == 0) ? "</fonts>" : (j == 1) ? "</fills>" : "</borders>");
+  }
+
+  sprintf(number, "<cellStyleXfs count=\"%d\">", count[3]);
+  buf = strapp(buf, number);
+  for (i = 0; i < n[3]; i++)
+    if (keep[3][i]) buf = styles_xf_xml(buf, &styles->parent[i], map, n, 0);
+  buf = strapp(buf, "</cellStyleXfs>");
+
+  sprintf(number, "<cellXfs count=\"%d\">", n_kept);
+  buf = strapp(buf, number);
+  for (i = 0; i < styles->n_styles; i++)
+    if (!used || used[i]) buf = styles_xf_xml(buf, &styles->style[i], map, n, 1);
+  buf = strapp(buf, "</cellXfs>");
+
+  sprintf(number, "<cellStyles count=\"%d\">", n_names);
+  buf = strapp(buf, number);
+  for (k = 0; k < styles->n_names; k++)
+  {
+    i = styles->name_parent[k];
+    if ((i < 0) || (i >= n[3]) || !keep[3][i]) continue;
+    buf = strapp(buf, "<cellStyle");
+    buf = strapp(buf, styles->name[k]);
+    sprintf(number, " xfId=\"%d\"/>", map[3][i]);
+    buf = strapp(buf, number);
+  }
+  buf = strapp(buf, "</cellStyles>");
+
+  buf = strapp(buf, styles->rest);
+  buf = strapp(buf, "</styleSheet>");
+
+  if (used)
+  {
+    free(styles->map);
+    styles->map = smap;
+    smap = NULL;
+  }
+
+bail:
+  for (j = 0; j < 4; j++)
+  {
+    free(keep[j]);
+    free(map[j]);
+  }
+  free(keep_format);
+  free(smap);
+
+  return buf;
+}
+
+  /**
+   *  @fn int libo_xl_docprops_write(libo *l)
+   *
+   *  @brief writes XL document properties to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_docprops_write(libo *l)
+{
+  int success = -1;
+
+  if (!l || !l->z) goto bail;
+
+  if (libo_xl_docprops_app_write(l)) goto bail;
+  if (libo_xl_docprops_core_write(l)) goto bail;
+
+  success = 0;
+
+bail:
+  return success;
+}
+
+static char *libo_xl_app_boiler_plate_1 =  /**<  XML boiler plate  */
+  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+  "<Properties xmlns=\"http://schemas.openxmlformats.org/officeDocument/2006/extended-properties\" xmlns:vt=\"http://schemas.openxmlformats.org/officeDocument/2006/docPropsVTypes\">"
+  "<Application>Microsoft Excel</Application>"
+  "<DocSecurity>0</DocSecurity>"
+  "<ScaleCrop>false</ScaleCrop>";
+
+static char *libo_xl_app_boiler_plate_2 =  /**<  XML boiler plate  */
+  "<LinksUpToDate>false</LinksUpToDate>"
+  "<SharedDoc>false</SharedDoc>"
+  "<HyperlinksChanged>false</HyperlinksChanged>"
+  "<AppVersion>16.0300</AppVersion>"
+  "</Properties>";
+
+  /**
+   *  @fn int libo_xl_docprops_app_write(libo *l)
+   *
+   *  @brief writes application document properties to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_docprops_app_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  int success = -1;
+  char number[25];
+  char *buf = NULL;
+  int i;
+
+  if (!l || !l->z) goto bail;
+
+  memset(number, 0, 25);
+
+  buf = strapp(buf, libo_xl_app_boiler_plate_1);
+
+  buf = strapp(buf, "<HeadingPairs>");
+  buf = strapp(buf, "<vt:vector size=\"2\" baseType=\"variant\">");
+  buf = strapp(buf, "<vt:variant>");
+  buf = strapp(buf, "<vt:lpstr>Worksheets</vt:lpstr>");
+  buf = strapp(buf, "</vt:variant>");
+  buf = strapp(buf, "<vt:variant>");
+  buf = strapp(buf, "<vt:i4>");
+  sprintf(number, "%d", l->xl->book->n_sheets);
+  buf = strapp(buf, number);
+  buf = strapp(buf, "</vt:i4>");
+  buf = strapp(buf, "</vt:variant>");
+  buf = strapp(buf, "</vt:vector>");
+  buf = strapp(buf, "</HeadingPairs>");
+  buf = strapp(buf, "<TitlesOfParts>");
+  buf = strapp(buf, "<vt:vector size=\"");
+  sprintf(number, "%d", l->xl->book->n_sheets);
+  buf = strapp(buf, number);
+  buf = strapp(buf, "\" baseType=\"lpstr\">");
+  for (i = 0; i < l->xl->book->n_sheets; i++)
+  {
+    buf = strapp(buf, "<vt:lpstr>");
+    buf = strapp(buf, l->xl->book->sheet[i]->name);
+    buf = strapp(buf, "</vt:lpstr>");
+  }
+  buf = strapp(buf, "</vt:vector>");
+  buf = strapp(buf, "</TitlesOfParts>");
+
+  buf = strapp(buf, libo_xl_app_boiler_plate_2);
+
+  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+  if (!zs) goto bail;
+
+  if ((zip_file_add(l->z, "docProps/app.xml", zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+
+  return success;
+}
+
+static char *libo_xl_core_boiler_plate_1 =  /**<  XML boiler plate  */
+  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+  "<cp:coreProperties xmlns:cp=\"http://schemas.openxmlformats.org/package/2006/metadata/core-properties\" xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:dcterms=\"http://purl.org/dc/terms/\" xmlns:dcmitype=\"http://purl.org/dc/dcmitype/\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">"
+  "<dc:creator>LIBO</dc:creator>"
+  "<cp:lastModifiedBy>LIBO</cp:lastModifiedBy>";
+
+static char *libo_xl_core_boiler_plate_2 =  /**<  XML boiler plate  */
+  "</cp:coreProperties>";
+
+  /**
+   *  @fn int libo_xl_docprops_core_write(libo *l)
+   *
+   *  @brief writes XL core document properties to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_docprops_core_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  int success = -1;
+  char *buf = NULL;
+  char date[50];
+  time_t tim = 0;
+  struct tm *gmt;
+
+  if (!l || !l->z) goto bail;
+
+  memset(date, 0, 50);
+
+  tim = time(NULL);
+  gmt = gmtime(&tim);
+  strftime(date, 50, "%Y-%m-%dT%H:%M:%SZ", gmt);
+
+  buf = strapp(buf, libo_xl_core_boiler_plate_1);
+
+  buf = strapp(buf, "<dcterms:created xsi:type=\"dcterms:W3CDTF\">");
+  buf = strapp(buf, date);
+  buf = strapp(buf, "</dcterms:created>");
+  buf = strapp(buf, "<dcterms:modified xsi:type=\"dcterms:W3CDTF\">");
+  buf = strapp(buf, date);
+  buf = strapp(buf, "</dcterms:modified>");
+
+  buf = strapp(buf, libo_xl_core_boiler_plate_2);
+
+  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+  if (!zs) goto bail;
+
+  if ((zip_file_add(l->z, "docProps/core.xml", zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+
+  return success;
+}
+
+  /**
+   *  @fn int libo_xl_xl_rels_write(libo *l)
+   *
+   *  @brief writes XL relationships to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_xl_rels_write(libo *l)
+{
+  int success = -1;
+
+  if (!l || !l->z) goto bail;
+
+  if (libo_xl_xl_rels_workbook_rels_write(l)) goto bail;
+
+  success = 0;
+
+bail:
+  return success;
+}
+
+static char *libo_xl__rels_dot_rels_boiler_plate_1 =  /**<  XML boiler plate  */
+  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+  "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+  "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+  "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/package/2006/relationships/metadata/core-properties\" Target=\"docProps/core.xml\"/>"
+  "<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/extended-properties\" Target=\"docProps/app.xml\"/>"
+  "</Relationships>";
+
+  /**
+   *  @fn int libo_xl__rels_dot_rels_write(libo *l)
+   *
+   *  @brief writes XL default relationships to document files
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl__rels_dot_rels_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  int success = -1;
+  char *buf = NULL;
+
+  buf = strapp(buf, libo_xl__rels_dot_rels_boiler_plate_1);
+
+  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+  if (!zs) goto bail;
+
+  if ((zip_file_add(l->z, "_rels/.rels", zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+
+  return success;
+}
+
+static char *libo_xl_workbook_rels_boiler_plate_1 =  /**<  XML boiler plate  */
+  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+  "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+  "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/theme\" Target=\"theme/theme1.xml\"/>"
+  "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>"
+  "<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>";
+
+static char *libo_xl_workbook_rels_boiler_plate_2 =  /**<  XML boiler plate  */
+  "</Relationships>";
+
+  /**
+   *  @fn int libo_xl_xl_rels_workbook_rels_write(libo *l)
+   *
+   *  @brief writes XL workbook relationships to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_xl_rels_workbook_rels_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  int success = -1;
+  char *buf = NULL;
+  char number[25];
+  int i;
+
+  if (!l || !l->z) goto bail;
+
+  memset(number, 0, 25);
+
+  buf = strapp(buf, libo_xl_workbook_rels_boiler_plate_1);
+
+  for (i = 0; i < l->xl->book->n_sheets; i++)
+  {
+    sprintf(number, "%d", i+4);
+    buf = strapp(buf, "<Relationship Id=\"rId");
+    buf = strapp(buf, number);
+    buf = strapp(buf, "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet");
+    sprintf(number, "%d", i+1);
+    buf = strapp(buf, number);
+    buf = strapp(buf, ".xml\"/>");
+  }
+
+  buf = strapp(buf, libo_xl_workbook_rels_boiler_plate_2);
+
+  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+  if (!zs) goto bail;
+
+  if ((zip_file_add(l->z, "xl/_rels/workbook.xml.rels", zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+
+  return success;
+}
+
+static char *libo_xl_content_types_boiler_plate_1 =  /**<  XML boiler plate  */
+  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+  "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">\n"
+  //"<Default Extension=\"bin\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.printerSettings\"/>\n"
+  "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>\n"
+  "<Default Extension=\"xml\" ContentType=\"application/xml\"/>\n";
+
+static char *libo_xl_content_types_boiler_plate_2 =  /**<  XML boiler plate  */
+  "<Override PartName=\"/docProps/core.xml\" ContentType=\"application/vnd.openxmlformats-package.core-properties+xml\"/>\n"
+  "<Override PartName=\"/docProps/app.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.extended-properties+xml\"/>\n"
+  "</Types>\n";
+
+  /**
+   *  @fn int libo_xl_content_types_write(libo *l)
+   *
+   *  @brief writes XL content types to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_content_types_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  char *buf = NULL;
+  char number[25];
+  int i;
+  int success = -1;
+
+  if (!l || !l->z) goto bail;
+
+  memset(number, 0, 25);
+
+  buf = strapp(buf, libo_xl_content_types_boiler_plate_1);
+
+  switch (l->type)
+  {
+    case libo_type_xl:
+      buf = strapp(buf, "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>");
+
+      for (i = 0; i < l->xl->book->n_sheets; i++)
+      {
+        buf = strapp(buf, "<Override PartName=\"/xl/worksheets/sheet");
+        sprintf(number, "%d", i+1);
+        buf = strapp(buf, number);
+        buf = strapp(buf, ".xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>");
+      }
+
+      buf = strapp(buf, "<Override PartName=\"/xl/theme/theme1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.theme+xml\"/>");
+      buf = strapp(buf, "<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>");
+      buf = strapp(buf, "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>");
+
+      break; //libo_type_xl
+
+    case libo_type_doc:
+      break; //libo_type_doc
+
+    case libo_type_pp:
+      break; //libo_type_pp
+
+    default: break;
+  }
+
+  buf = strapp(buf, libo_xl_content_types_boiler_plate_2);
+
+  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+  if (!zs) goto bail;
+
+  if ((zip_file_add(l->z, "[Content_Types].xml", zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+
+  return success;
+}
+
+static char *libo_xl_workbook_boiler_plate_1 =  /**<  XML boiler plate  */
+  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+  "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\" xmlns:x15=\"http://schemas.microsoft.com/office/spreadsheetml/2010/11/main\" xmlns:xr=\"http://schemas.microsoft.com/office/spreadsheetml/2014/revision\" xmlns:xr6=\"http://schemas.microsoft.com/office/spreadsheetml/2016/revision6\" xmlns:xr10=\"http://schemas.microsoft.com/office/spreadsheetml/2016/revision10\" mc:Ignorable=\"x15 xr xr6 xr10\">";
+
+  /**
+   *  @fn int libo_xl_workbook_write(libo *l)
+   *
+   *  @brief writes XL workbook to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_workbook_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  char *buf = NULL;
+  char number[25];
+  int success = -1;
+  int i;
+
+  if (!l || !l->z) goto bail;
+
+  buf = strapp(buf, libo_xl_workbook_boiler_plate_1);
+  buf = strapp(buf, "<fileVersion appName=\"xl\" lastEdited=\"1\" lowestEdited=\"1\" rupBuild=\"25601\"/>"); // what are parameters??
+  if (l->xl->book && l->xl->book->date1904)
+    buf = strapp(buf, "<workbookPr date1904=\"1\" defaultThemeVersion=\"166925\"/>");
+  else
+    buf = strapp(buf, "<workbookPr defaultThemeVersion=\"166925\"/>");
+  buf = strapp(buf, "<mc:AlternateContent xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">");
+  buf = strapp(buf, "<mc:Choice Requires=\"x15\">");
+  buf = strapp(buf, "<x15ac:absPath xmlns:x15ac=\"http://schemas.microsoft.com/office/spreadsheetml/2010/11/ac\" url=\"");
+  buf = strapp(buf, l->path);
+  buf = strapp(buf, "\"/>");
+  buf = strapp(buf, "</mc:Choice>");
+  buf = strapp(buf, "</mc:AlternateContent>");
+  buf = strapp(buf, "<xr:revisionPtr revIDLastSave=\"0\" documentId=\"13_ncr:40009_{47680350-0BCE-45AA-9C35-94426BD8D69C}\" xr6:coauthVersionLast=\"47\" xr6:coauthVersionMax=\"47\" xr10:uidLastSave=\"{00000000-0000-0000-0000-000000000000}\"/>");
+  buf = strapp(buf, "<bookViews>");
+  buf = strapp(buf, "<workbookView xWindow=\"-108\" yWindow=\"-108\" windowWidth=\"23256\" windowHeight=\"12576\"/>");
+  buf = strapp(buf, "</bookViews>");
+  buf = strapp(buf, "<sheets>");
+  for (i = 0; i < l->xl->book->n_sheets; i++)
+  {
+    buf = strapp(buf, "<sheet name=\"");
+    buf = strapp(buf, l->xl->book->sheet[i]->name);
+    buf = strapp(buf, "\" sheetId=\"");
+    sprintf(number, "%d", i+1);
+    buf = strapp(buf, number);
+    buf = strapp(buf, "\" r:id=\"rId");
+    sprintf(number, "%d", i+4);
+    buf = strapp(buf, number);
+    buf = strapp(buf, "\"/>");
+  }
+  buf = strapp(buf, "</sheets>");
+  buf = strapp(buf, "<calcPr calcId=\"0\"/>");
+  buf = strapp(buf, "</workbook>");
+
+  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+  if (!zs) goto bail;
+
+  if ((zip_file_add(l->z, "xl/workbook.xml", zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+
+  return success;
+}
+
+  /**
+   *  @fn int libo_xl_sheets_write(libo *l)
+   *
+   *  @brief writes XL worksheets to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_sheets_write(libo *l)
+{
+  int success = -1;
+  int i;
+
+  if (!l) goto bail;
+  if (l->type != libo_type_xl) goto bail;
+
+  libo_xl_renumber_strings(l);
+
+  for (i = 0; i < l->xl->book->n_sheets; i++)
+  {
+    if (!libo_xl_book_get_sheet(l->xl->book, i)) goto bail;
+    if (libo_xl_sheet_write(l, i) < 0) goto bail;
+  }
+
+  success = 0;
+
+bail:
+  return success;
+}
+
+  //"<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\" xmlns:x14ac=\"http://schemas.microsoft.com/office/spreadsheetml/2009/9/ac\" mc:Ignorable=\"x14ac\">";
+static char *libo_xl_sheet_boiler_plate_1 =  /**<  XML boiler plate  */
+  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+  "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\" xmlns:x14ac=\"http://schemas.microsoft.com/office/spreadsheetml/2009/9/ac\" xmlns:xr=\"http://schemas.microsoft.com/office/spreadsheetml/2014/revision\" xmlns:xr2=\"http://schemas.microsoft.com/office/spreadsheetml/2015/revision2\" xmlns:xr3=\"http://schemas.microsoft.com/office/spreadsheetml/2016/revision3\" mc:Ignorable=\"x14ac xr xr2 xr3\" xr:uid=\"{00000000-0001-0000-0800-000000000000}\">\n";
+
+static char *libo_xl_sheet_boiler_plate_2 =  /**<  XML boiler plate  */
+  "<pageMargins left=\"0.7\" right=\"0.7\" top=\"0.75\" bottom=\"0.75\" header=\"0.3\" footer=\"0.3\"/>\n"
+  "<pageSetup orientation=\"portrait\" horizontalDpi=\"300\" verticalDpi=\"300\" r:id=\"rId1\"/>\n"
+  "</worksheet>\n";
+
+  /**
+   *  @fn int libo_xl_sheet_write(libo *l, int sheet)
+   *
+   *  @brief writes XL worksheet to document file
+   *
+   *  @param l - pointer to existing @a libo document
+   *  @param sheet - index of sheet to write 
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_sheet_write(libo *l, int sheet)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  char *buf = NULL;
+  char number[25];
+  char name[256];
+  int success = -1;
+  libo_xl_sheet *sht;
+  FILE *stream = NULL;
+
+  if (!l) goto bail;
+  if (l->type != libo_type_xl) goto bail;
+  if (!l->xl) goto bail;
+  if (!l->xl->book) goto bail;
+  if (sheet >= l->xl->book->n_sheets) goto bail;
+  if (!l->xl->book->sheet[sheet]) goto bail;
+
+  memset(number, 0, 25);
+  memset(name, 0, 256);
+
+  sht = l->xl->book->sheet[sheet];
+
+  libo_xl_sheet_count_columns(sht);
+  if (!sht->column) sht->column = libo_xl_sheet_columns_create_defaults(sht);
+
+    // rows kept on disk are written through a temporary file, row by row
+
+  if (sht->store)
+  {
+    stream = tmpfile();
+    if (!stream) goto bail;
+  }
+
+  buf = strapp(buf, libo_xl_sheet_boiler_plate_1);
+
+  libo_xl_sheet_dimension_add(l, sheet, &buf);
+  libo_xl_sheet_sheetviews_add(l, sheet, &buf);
+  libo_xl_sheet_formatpr_add(l, sheet, &buf);
+  libo_xl_sheet_cols_add(l, sheet, &buf);
+  libo_xl_sheet_sheetdata_add(l, sheet, &buf, stream);
+  libo_xl_sheet_filter_add(l, sheet, &buf);
+
+  buf = strapp(buf, libo_xl_sheet_boiler_plate_2);
+
+  if (stream)
+  {
+    if (!buf) goto bail;
+    fputs(buf, stream);
+    free(buf);
+    buf = NULL;
+
+    if (fflush(stream)) goto bail;
+
+    zs = zip_source_filep(l->z, stream, 0, -1);
+    if (!zs) goto bail;
+    stream = NULL;
+  }
+  else
+  {
+    zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+    if (!zs) goto bail;
+  }
+
+  sprintf(name, "xl/worksheets/sheet%d.xml", sheet+1);
+  if ((zip_file_add(l->z, name, zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+  if (stream) fclose(stream);
+
+  return success;
+}
+
+ /**
+  * @fn static char *strapp(char *s1, char *s2)
+  *
+  * @brief appends @p s2 to @p s1 , reallocating memory
+  *
+  * NOTE:  The user is responsible for freeing @p s2 if required.
+  *
+  * @param s1 - original string, can be NULL
+  * @param s2 - addendum to string
+  *
+  * @return pointer to newly formed string
+  */
+
+static char *strapp(char *s1, char *s2)
+{
+  int len1, len2;
+  char *tmp;
+
+  if (!s1)
+  {
+    s1 = malloc(1);
+    if (!s1) return NULL;
+    *s1 = 0;
+  }
+
+  if (!s2) return s1;
+
+  len1 = strlen(s1);
+  len2 = strlen(s2);
+
+  tmp = realloc(s1, len1 + len2 + 1);
+  if (tmp)
+  {
+    s1 = tmp;
+    strcat(s1, s2);
+  }
+
+  return s1;
+}
+
+ /**
+  * @fn static int libo_xl_shared_strings_write(libo *l)
+  *
+  * @brief writes XL shared strings to file
+  *
+  * @param l - pointer to existing @a libo struct
+  *
+  * @return 0 on success, STDIO error on failure
+  */
+
+static int libo_xl_shared_strings_write(libo *l)
+{
+  zip_error_t err;
+  zip_source_t *zs = NULL;
+  char *buf = NULL;
+  strings *strs;
+  char number[25];
+  char name[256];
+  int success = -1;
+
+  if (!l) goto bail;
+  if (l->type != libo_type_xl) goto bail;
+  if (!l->xl) goto bail;
+  if (!l->xl->strings) goto bail;
+
+  strs = l->xl->strings;
+
+    // Count number of strings
+
+  _strings_count = 0;
+  strings_walk(strs, string_text, libo_xl_strings_count_action);
+
+  buf = strapp(buf, "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+  sprintf(number, "%d", _strings_count);
+  buf = strapp(buf, "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"");
+  buf = strapp(buf, number);
+  buf = strapp(buf, "\" uniqueCount=\"");
+  buf = strapp(buf, number);
+  buf = strapp(buf, "\">");
+
+    // Add each strings entry into buffer
+
+  _strings_buf = buf;
+  strings_walk(strs, string_id, libo_xl_strings_add_action);
+  buf = _strings_buf;
+
+  buf = strapp(buf, "</sst>");
+
+  zs = zip_source_buffer_create(buf, strlen(buf), 1, &err);
+  if (!zs) goto bail;
+
+  strcpy(name, "xl/sharedStrings.xml");
+  if ((zip_file_add(l->z, name, zs, 0)) < 0) goto bail;
+
+  success = 0;
+
+bail:
+  if (success < 0 && buf) free(buf);
+
+  return success;
+}
+
+ /**
+  * @fn static void libo_xl_renumber_strings(libo *l)
+  *
+  * @brief renumbers all string references in XL doc
+  *
+  * @param l - pointer to existing @a libo struct
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_renumber_strings(libo *l)
+{
+  libo_xl_book *book;
+  libo_xl_sheet *sheet;
+  libo_xl_row *row;
+  libo_xl_cell *cell;
+  libo_xl_store *store;
+  int i, j, k;
+  unsigned int new_id = 0;
+  strings *strings = NULL;
+  string *found;
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (!l->xl) return;
+  if (!l->xl->strings) return;
+
+  book = l->xl->book;
+  if (!book) return;
+
+  strings = strings_new();
+  if (!strings) return;
+
+    // Set shared string references to new strings IDs
+
+  for (i = 0; i < book->n_sheets; i++)
+  {
+    sheet = libo_xl_book_get_sheet(book, i);
+    if (!sheet) return;
+
+      // references no longer match file, so sheet can not simply be reparsed
+
+    ++sheet->version;
+    sheet->dirty = 1;
+
+      // stored rows are decoded copies, so renumbered rows go to a new store
+
+    store = NULL;
+    if (sheet->store)
+    {
+      store = libo_xl_store_new(sheet->store->type);
+      if (!store) return;
+    }
+
+    for (j = 0; j < sheet->n_rows; j++)
+    {
+      row = libo_xl_sheet_get_row(sheet, j);
+      if (!row) return;
+      for (k = 0; k < row->n_cells; k++)
+      {
+        cell = row->cell[k];
+        switch (cell->type)
+        {
+          case libo_xl_cell_type_none:
+          case libo_xl_cell_type_expression:
+          case libo_xl_cell_type_number:
+          case libo_xl_cell_type_boolean:
+          case libo_xl_cell_type_error:
+          case libo_xl_cell_type_empty:
+          case libo_xl_cell_type_date:
+            break;
+
+          case libo_xl_cell_type_reference:
+            found = strings_find_by_id(l->xl->strings, cell->reference);
+            if (found) found = strings_find_by_text(strings, found->text);
+            if (found)
+            {
+              strings_add(strings, string_dup(found));
+              cell->reference = found->id;
+            }
+            else
+            {
+              found = strings_find_by_id(l->xl->strings, cell->reference);
+              if (found) strings_add(strings, string_dup(found));
+              cell->reference = new_id;
+              ++new_id;
+            }
+            break;
+        }
+      }
+
+      if (store) libo_xl_store_append(store, row);
+    }
+
+    if (store)
+    {
+      libo_xl_store_free(sheet->store);
+      sheet->store = store;
+    }
+  }
+
+  strings_free(l->xl->strings);
+  l->xl->strings = strings;
+}
+
+ /**
+  * @fn static void libo_xl_sheet_dimension_add(libo *l,
+  *                                                 int sheet,
+  *                                                 char **buf)
+  *
+  * @brief adds worksheet dimension references to XML buffer
+  *
+  * @param l - pointer to existing @a libo struct
+  * @param sheet - index of sheet in book
+  * @param buf - pointer to string holding XML buffer
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_sheet_dimension_add(libo *l, int sheet, char **buf)
+{
+  char number[25];
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (sheet >= l->xl->book->n_sheets) return;
+  if (!buf) return;
+
+  memset(number, 0, 25);
+
+    /* <dimension ref="A1:G5"/> */
+
+  *buf = strapp(*buf, "<dimension ref=\"A1:");
+  if (l->xl->book->sheet[sheet]->n_cols)
+    *buf = strapp(*buf, column_number_to_reference(l->xl->book->sheet[sheet]->n_cols-1));
+  else *buf = strapp(*buf, "A");
+  sprintf(number, "%d", l->xl->book->sheet[sheet]->n_rows);
+  *buf = strapp(*buf, number);
+  *buf = strapp(*buf, "\"/>\n");
+}
+
+ /**
+  * @fn static void libo_xl_sheet_sheetviews_add(libo *l,
+  *                                                  int sheet,
+  *                                                  char **buf)
+  *
+  * @brief adds XL sheetviews information to XML buffer
+  *
+  * @param l - pointer to existing @a libo struct
+  * @param sheet - index of sheet in book
+  * @param buf - pointer to string holding XML buffer
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_sheet_sheetviews_add(libo *l, int sheet, char **buf)
+{
+  char number[25];
+  libo_xl_sheet *sht;
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (sheet >= l->xl->book->n_sheets) return;
+  if (!buf) return;
+
+  memset(number, 0, 25);
+
+  sht = l->xl->book->sheet[sheet];
+
+  if (!sht->freeze.type) return;
+
+  *buf = strapp(*buf, "<sheetViews>\n");
+  *buf = strapp(*buf, "<sheetView tabSelected=\"1\" topLeftCell=\"A1\" workbookViewId=\"0\">\n");
+  *buf = strapp(*buf, "<pane ");
+  switch (sht->freeze.type)
+  {
+    case libo_xl_freeze_type_none: break;
+    case libo_xl_freeze_type_top:
+      *buf = strapp(*buf, "ySplit");
+      break;
+    case libo_xl_freeze_type_left: break;
+      *buf = strapp(*buf, "xSplit");
+      break;
+  }
+  *buf = strapp(*buf, "=\"1\" topLeftCell=\"");
+  switch (sht->freeze.type)
+  {
+    case libo_xl_freeze_type_none: break;
+    case libo_xl_freeze_type_top:
+      *buf = strapp(*buf, "A");
+      sprintf(number, "%d", sht->freeze.n + 1);
+      *buf = strapp(*buf, number);
+      break;
+    case libo_xl_freeze_type_left: break;
+      sprintf(number, "%c", sht->freeze.n + 'A');
+      *buf = strapp(*buf, number);
+      *buf = strapp(*buf, "1");
+      break;
+  }
+  *buf = strapp(*buf, "\" activePane=\"");
+  switch (sht->freeze.type)
+  {
+    case libo_xl_freeze_type_none: break;
+    case libo_xl_freeze_type_top:
+      *buf = strapp(*buf, "bottomLeft");
+      break;
+    case libo_xl_freeze_type_left: break;
+      *buf = strapp(*buf, "topRight");
+      break;
+  }
+  *buf = strapp(*buf, "\" state=\"frozen\"/>");
+  *buf = strapp(*buf, "<selection pane=\"");
+  switch (sht->freeze.type)
+  {
+    case libo_xl_freeze_type_none: break;
+    case libo_xl_freeze_type_top:
+      *buf = strapp(*buf, "bottomLeft");
+      break;
+    case libo_xl_freeze_type_left: break;
+      *buf = strapp(*buf, "topRight");
+      break;
+  }
+  *buf = strapp(*buf, "\"/>");
+  *buf = strapp(*buf, "</sheetView>\n");
+  *buf = strapp(*buf, "</sheetViews>\n");
+}
+
+ /**
+  * @fn static void libo_xl_sheet_formatpr_add(libo *l,
+  *                                                int sheet,
+  *                                                char **buf)
+  *
+  * @brief adds XL formatpr information to XML buffer
+  *
+  * @param l - pointer to existing @a libo struct
+  * @param sheet - index of sheet in book
+  * @param buf - pointer to string holding XML buffer
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_sheet_formatpr_add(libo *l, int sheet, char **buf)
+{
+  char number[25];
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (sheet >= l->xl->book->n_sheets) return;
+  if (!buf) return;
+
+  memset(number, 0, 25);
+
+    /*
+      <sheetFormatPr defaultRowHeight="15" customHeight="1" x14ac:dyDescent="0.3"/>
+    */
+
+  *buf = strapp(*buf, "<sheetFormatPr");
+  if (l->xl->book->sheet[sheet]->default_row_height)
+  {
+    *buf = strapp(*buf, " defaultRowHeight=\"");
+    sprintf(number, "%g", l->xl->book->sheet[sheet]->default_row_height);
+    *buf = strapp(*buf, number);
+    *buf = strapp(*buf, "\"");
+    *buf = strapp(*buf, " customHeight=\"1\"");
+  }
+  *buf = strapp(*buf," x14ac:dyDescent=\"0.3\"/>\n");
+}
+
+ /**
+  * @fn static void libo_xl_sheet_cols_add(libo *l, int sheet, char **buf)
+  *
+  * @brief adds XL worksheet column attributes to XML buffer
+  *
+  * @param l - pointer to existing @a libo struct
+  * @param sheet - index of sheet in book
+  * @param buf - pointer to string holding XML buffer
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_sheet_cols_add(libo *l, int sheet, char **buf)
+{
+  char number[25];
+  int i;
+  libo_xl_column *col;
+  libo_xl_sheet *sht;
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (!l->xl) return;
+  if (!l->xl->book) return;
+  if (sheet >= l->xl->book->n_sheets) return;
+  if (!buf) return;
+
+  memset(number, 0, 25);
+
+  sht = l->xl->book->sheet[sheet];
+
+  if (!sht->column) sht->column = libo_xl_sheet_columns_create_defaults(sht);
+  if (!sht->column) return;
+
+    /*
+      <cols>
+        <col min="1" max="1" width="16.88671875" bestFit="1" customWidth="1"/>
+      </cols>
+    */
+
+  *buf = strapp(*buf,"<cols>\n");
+  for (i = 0; i < sht->n_cols; i++)
+  {
+    col = sht->column[i];
+
+    *buf = strapp(*buf, "<col min=\"");
+    sprintf(number, "%d", i+1);
+    *buf = strapp(*buf, number);
+    *buf = strapp(*buf, "\" max=\"");
+    *buf = strapp(*buf, number);
+    *buf = strapp(*buf, "\" width=\"");
+    sprintf(number, "%f", col->width);
+    *buf = strapp(*buf, number);
+    *buf = strapp(*buf, "\" bestfit=\"");
+    sprintf(number, "%d", col->autowidth ? 1 : 0);
+    *buf = strapp(*buf, number);
+    *buf = strapp(*buf, "\" customWidth=\"1\"/>\n");
+  }
+  *buf = strapp(*buf,"</cols>\n");
+}
+
+ /**
+  * @fn static void libo_xl_sheet_sheetdata_add(libo *l,
+  *                                                 int sheet,
+  *                                                 char **buf,
+  *                                                 FILE *stream)
+  *
+  * @brief adds XL worksheet data to XML buffer
+  *
+  * When @p stream is not NULL, the buffer is written to it after each row
+  * and emptied, so a sheet larger than memory can be written.
+  *
+  * @param l - pointer to existing @a libo struct
+  * @param sheet - index of sheet in book
+  * @param buf - pointer to string holding XML buffer
+  * @param stream - open FILE * receiving XML, or NULL
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_sheet_sheetdata_add(libo *l,
+                                            int sheet,
+                                            char **buf,
+                                            FILE *stream)
+{
+  number_batch batch;
+  formula_runs runs;
+  int i;
+  int batched = 0;
+  int running;
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (sheet >= l->xl->book->n_sheets) return;
+  if (!buf) return;
+
+  memset(&batch, 0, sizeof(number_batch));
+  running = !formula_runs_init(&runs, l->xl->book->sheet[sheet]);
+
+    /*
+      <sheetData>
+        ROWS
+      </sheetData>
+    */
+
+  *buf = strapp(*buf, "<sheetData>\n");
+  for (i = 0; i < l->xl->book->sheet[sheet]->n_rows; i++)
+  {
+      // numbers are formatted a span of rows ahead, a column at a time
+
+    if (i >= batch.first + batch.n_rows)
+      batched = !number_batch_fill(&batch, l->xl->book->sheet[sheet], i);
+
+    libo_xl_sheet_sheetdata_row_add(l,
+                                    sheet,
+                                    i,
+                                    batched ? &batch : NULL,
+                                    running ? &runs : NULL,
+                                    buf);
+
+    if (stream && *buf)
+    {
+      fputs(*buf, stream);
+      **buf = 0;
+    }
+  }
+  *buf = strapp(*buf, "</sheetData>\n");
+
+  number_batch_clear(&batch);
+  formula_runs_clear(&runs);
+}
+
+ /**
+  * @fn static void libo_xl_sheet_sheetdata_row_add(libo *l,
+  *                                                     int sheet,
+  *                                                     int row,
+  *                                                     number_batch *batch,
+  *                                                     formula_runs *runs,
+  *                                                     char **buf)
+  *
+  * @brief adds XL worksheet row data to XML buffer
+  *
+  * @param l - pointer to existing @a libo struct
+  * @param sheet - index of sheet in book
+  * @param row - index of row in sheet
+  * @param batch - numbers formatted ahead, or NULL
+  * @param runs - runs of shared formulas being written, or NULL
+  * @param buf - pointer to string holding XML buffer
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_sheet_sheetdata_row_add(libo *l,
+                                                int sheet,
+                                                int row,
+                                                number_batch *batch,
+                                                formula_runs *runs,
+                                                char **buf)
+{
+  int i;
+  int n_cells;
+  char number[25];
+  libo_xl_sheet *sht;
+  libo_xl_row *r;
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (!l->xl->book) return;
+  if (sheet >= l->xl->book->n_sheets) return;
+  if (!buf) return;
+
+  sht = l->xl->book->sheet[sheet];
+
+  r = libo_xl_sheet_get_row(sht, row);
+  if (!r) return;
+  n_cells = r->n_cells;
+
+  memset(number, 0, 25);
+
+    /*
+      NOTE:  Not sure what s="1" is, selected?
+      <row r="1" spans="1:7" s="1" customFormat="1" ht="15" customHeight="1" x14ac:dyDescent="0.3">
+        COLS
+      </row>
+    */
+
+  *buf = strapp(*buf, "<row r=\"");
+  sprintf(number, "%d", row+1);
+  *buf = strapp(*buf, number);
+  *buf = strapp(*buf, "\" spans=\"1:");
+  sprintf(number, "%d", l->xl->book->sheet[sheet]->n_cols);
+  *buf = strapp(*buf, number);
+  *buf = strapp(*buf, "\" customFormat=\"1\" ht=\"");
+  sprintf(number, "%g", l->xl->book->sheet[sheet]->default_row_height);
+  *buf = strapp(*buf, number);
+  if (sht->visible && row && !libo_xl_view_contains(sht->visible, row))
+    *buf = strapp(*buf, "\" hidden=\"1");
+  *buf = strapp(*buf, "\" customHeight=\"1\" x14ac:dyDescent=\"0.3\">\n");
+
+    // rows below are read to find shared formulas, which may drop r from
+    // the cache of a stored sheet
+
+  for (i = 0; i < n_cells; i++)
+    libo_xl_sheet_sheetdata_row_col_add(l,
+                                        sheet,
+                                        row,
+                                        i,
+                                        number_batch_get(batch, row, i),
+                                        runs,
+                                        buf);
+  *buf = strapp(*buf, "</row>\n");
+}
+
+ /**
+  * @fn static void libo_xl_sheet_sheetdata_row_col_add(libo *l,
+  *                                                         int sheet,
+  *                                                         int row,
+  *                                                         int col,
+  *                                                         char *value,
+  *                                                         formula_runs *runs,
+  *                                                         char **buf)
+  *
+  * @brief adds XL worksheet cell data to XML buffer
+  *
+  * @param l - pointer to existing @a libo struct
+  * @param sheet - index of sheet in book
+  * @param row - index of row in sheet
+  * @param col - index of col in row
+  * @param value - number of cell formatted ahead, or NULL
+  * @param runs - runs of shared formulas being written, or NULL
+  * @param buf - pointer to string holding XML buffer
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_sheet_sheetdata_row_col_add(libo *l,
+                                                    int sheet,
+                                                    int row,
+                                                    int col,
+                                                    char *value,
+                                                    formula_runs *runs,
+                                                    char **buf)
+{
+  libo_xl_styles *styles;
+  libo_xl_cell *cell;
+  libo_xl_sheet *sht;
+  xmlChar *text;
+  char number[LIBO_XL_NUMBER_SIZE];
+  int style = 0;
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (!l->xl->book) return;
+  if (sheet >= l->xl->book->n_sheets) return;
+  if (!buf) return;
+
+  sht = l->xl->book->sheet[sheet];
+  if (!sht) return;
+
+  if (row >= sht->n_rows) return;
+  if (col >= sht->n_cols) return;
+
+  cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sht, row), col);
+  if (!cell) return;
+
+    // cell format, as numbered in written style sheet
+  styles = l->xl->styles;
+  if (cell->style && styles && styles->map && (cell->style < styles->n_styles))
+    style = styles->map[cell->style];
+
+    // empty cells are left out, unless they carry a cell format
+  if ((cell->type == libo_xl_cell_type_empty) && !style) return;
+
+    /*
+      <c r="A1" s="1" t="s"> //shared strings id
+        <v>0</v>
+      </c>
+      <c r="C2"> //direct value (number)
+        <v>156057</v>
+      </c>
+    */
+  *buf = strapp(*buf, "<c r=\"");
+  *buf = strapp(*buf, column_number_to_reference(col));
+  sprintf(number, "%d\"", row+1);
+  *buf = strapp(*buf, number);
+
+  if (style)
+  {
+    sprintf(number, " s=\"%d\"", style);
+    *buf = strapp(*buf, number);
+  }
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_none:
+      *buf = strapp(*buf, ">\n");
+      break;
+
+    case libo_xl_cell_type_reference:
+      *buf = strapp(*buf, " t=\"s\">\n");
+      break;
+
+    case libo_xl_cell_type_expression:
+      *buf = strapp(*buf, (char *)expression_value_type(cell->expression.value));
+      *buf = strapp(*buf, ">\n");
+
+      if (cell_has_formula(cell))
+      {
+        formula_runs_add(runs, sht, cell, row, col, buf);
+        cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sht, row), col);
+        if (!cell)
+        {
+          *buf = strapp(*buf, "</c>\n");
+          return;
+        }
+      }
+      break;
+
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      *buf = strapp(*buf, ">\n");
+      break;
+
+    case libo_xl_cell_type_boolean:
+      *buf = strapp(*buf, " t=\"b\">\n");
+      break;
+
+    case libo_xl_cell_type_error:
+      *buf = strapp(*buf, " t=\"e\">\n");
+      break;
+
+    case libo_xl_cell_type_empty:
+      *buf = strapp(*buf, "/>\n");
+      return;
+  }
+
+  *buf = strapp(*buf, "<v>");
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_none: break;
+
+    case libo_xl_cell_type_reference:
+      sprintf(number, "%d", cell->reference);
+      *buf = strapp(*buf, number);
+      //*buf = strapp(*buf, "\n");
+      break;
+
+    case libo_xl_cell_type_expression:
+      if (!cell->expression.value) break;
+
+        // booleans are written as 1 and 0
+
+      if (!strcmp(cell->expression.value, "TRUE") || !strcmp(cell->expression.value, "FALSE"))
+      {
+        *buf = strapp(*buf, (*cell->expression.value == 'T') ? "1" : "0");
+        break;
+      }
+
+      text = xmlEncodeSpecialChars(NULL, (xmlChar *)cell->expression.value);
+      if (text) *buf = strapp(*buf, (char *)text);
+      xmlFree(text);
+      break;
+
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      if (!value)
+      {
+        libo_xl_cell_format_number(cell, number, sizeof(number));
+        value = number;
+      }
+      *buf = strapp(*buf, value);
+      //*buf = strapp(*buf, "\n");
+      break;
+
+    case libo_xl_cell_type_boolean:
+      *buf = strapp(*buf, cell->boolean ? "1" : "0");
+      break;
+
+    case libo_xl_cell_type_error:
+      *buf = strapp(*buf, (char *)libo_xl_error_to_string(cell->error));
+      break;
+
+    case libo_xl_cell_type_empty: break;
+  }
+
+  *buf = strapp(*buf, "</v>\n");
+  *buf = strapp(*buf, "</c>\n");
+}
+
+ /**
+  * @fn static void libo_xl_sheet_filter_add(libo *l, int sheet, char **buf)
+  *
+  * @brief adds XL worksheet filter and sort information to XML buffer
+  *
+  * @param l - pointer to existing @a libo struct
+  * @param sheet - index of sheet in book
+  * @param buf - pointer to string holding XML buffer
+  *
+  * @par Returns
+  * Nothing.
+  */
+
+static void libo_xl_sheet_filter_add(libo *l, int sheet, char **buf)
+{
+  libo_xl_sheet *sht;
+  char number[25];
+
+  if (!l) return;
+  if (l->type != libo_type_xl) return;
+  if (!l->xl->book) return;
+  if (sheet >= l->xl->book->n_sheets) return;
+  if (!buf) return;
+
+  sht = l->xl->book->sheet[sheet];
+  if (!sht) return;
+
+    // a sort without a filter is kept by the work sheet itself
+
+  if (!sht->filter)
+  {
+    if (sht->sort)
+      libo_xl_sheet_sortstate_add(sht, 0, sht->n_cols ? sht->n_cols - 1 : 0, buf);
+    return;
+  }
+
+    /*
+      <autoFilter ref="A1:E6" xr:uid="{00000000-0009-0000-0000-000000000000}">
+        <sortState xmlns:xlrd2="http://schemas.microsoft.com/office/spreadsheetml/2017/richdata2" ref="A2:E6">
+          <sortCondition ref="A2:A6"/>
+        </sortState>
+      </autoFilter>
+    */
+
+  *buf = strapp(*buf, "<autoFilter ref=\"");
+  *buf = strapp(*buf, column_number_to_reference(sht->filter->first_column));
+  sprintf(number, "%d", 1);
+  *buf = strapp(*buf, number);
+  *buf = strapp(*buf, ":");
+  *buf = strapp(*buf, column_number_to_reference(sht->filter->last_column));
+  sprintf(number, "%d", sht->n_rows);
+  *buf = strapp(*buf, number);
+  *buf = strapp(*buf, "\" xr:uid=\"{00000000-0009-0000-0000-000000000000}\">");
+  libo_xl_sheet_sortstate_add(sht, sht->filter->first_column, sht->filter->last_column, buf);
+  *buf = strapp(*buf, "</autoFilter>");
+}
+
+  /**
+   *  @fn void libo_xl_strings_count_action(avl_node *n)
+   *
+   *  @brief called by avl_walk() when counting XL strings
+   *
+   *  @param n - pointer to existing @a avl_node
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_strings_count_action(avl_node *n) { ++_strings_count; }
+
+  /**
+   *  @fn void libo_xl_strings_add_action(avl_node *n)
+   *
+   *  @brief called by avl_walk() when adding XML content to strings
+   *
+   *  @param n - pointer to existing @a avl_node
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_strings_add_action(avl_node *n)
+{
+  string_node *sn;
+  string *str;
+
+  if (!n) return;
+
+  sn = (string_node *)n;
+
+  str = &sn->value;
+  if (!str) return;
+
+  _strings_buf = strapp(_strings_buf, "<si>");
+  _strings_buf = strapp(_strings_buf, "<t>");
+  _strings_buf = strapp(_strings_buf, str->text);
+  _strings_buf = strapp(_strings_buf, "</t>");
+  _strings_buf = strapp(_strings_buf, "</si>");
+}
+
+  /**
+   *  @fn char *column_number_to_reference(unsigned int n)
+   *
+   *  @brief converts a column number to XL cell reference
+   *
+   *  @param n - column number
+   *
+   *  @return string containing XL cell reference
+   */
+
+static char *column_number_to_reference(unsigned int n)
+{
+  static char ref[10];
+  int i = 0;
+  unsigned int r;
+
+  memset(ref, 0, 10);
+
+  ++n;
+
+  do
+  {
+    r = (n - 1) % 26;
+    n = (n - 1) / 26;
+    ref[i] = 'A' + r;
+    ++i;
+  } while (n);
+
+  return reverse(ref);
+}
+
+  /**
+   *  @fn char *reverse(char *s)
+   *
+   *  @brief reverses order of characters in a string
+   *
+   *  NOTE:  It is the caller's responsibility to free allocated memory
+   *         of the reversed string
+   *
+   *  @param s - string to reverse
+   *
+   *  @return reversed string
+   */
+
+static char *reverse(char *s)
+{
+  int len;
+  int i, j;
+  char *t;
+
+  if (!s) return NULL;
+
+  len = strlen(s);
+  if (len < 2) return s;
+
+  t = strdup(s);
+  memset(t, 0, len);
+
+  i = 0;
+  j = len - 1;
+  while (i < len) t[i++] = s[j--];
+
+  strcpy(s, t);
+  free(t);
+
+  return s;
+}
+
+  /**
+   *  @fn void libo_xl_row_fill(libo_xl_sheet *sheet, int max_row)
+   *
+   *  @brief fills XL worksheet with rows up to @p max_row
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param max_row - index of last row to create
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_row_fill(libo_xl_sheet *sheet, int max_row)
+{
+  int i;
+
+  if (!sheet) return;
+
+  if (sheet->row)
+    sheet->row = (libo_xl_row **)realloc(sheet->row, sizeof(libo_xl_row *) * max_row);
+  else
+    sheet->row = (libo_xl_row **)malloc(sizeof(libo_xl_row *) * max_row);
+
+  for (i = sheet->n_rows; i < max_row; i++)
+    sheet->row[i] = libo_xl_row_new();
+
+  sheet->n_rows = max_row;
+
+  return;
+}
+
+  /**
+   *  @fn void libo_xl_col_fill(libo_xl_sheet *sheet,
+   *                            int row,
+   *                            int max_col)
+   *
+   *  @brief fills XL row of worksheet with cells up to @p max_col
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param row - index of row to fill
+   *  @param max_col - index of last col to create
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_col_fill(libo_xl_sheet *sheet, int row, int max_col)
+{
+  int i;
+
+  if (!sheet) return;
+
+  if (row >= sheet->n_rows) libo_xl_row_fill(sheet, row);
+
+  if (sheet->row[row]->cell)
+    sheet->row[row]->cell = (libo_xl_cell **)realloc(sheet->row[row]->cell, sizeof(libo_xl_cell *) * max_col);
+  else
+    sheet->row[row]->cell = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * max_col);
+
+  for (i = sheet->row[row]->n_cells; i < max_col; i++)
+    sheet->row[row]->cell[i] = libo_xl_cell_new();
+
+  sheet->row[row]->n_cells = max_col;
+
+  return;
+}
+
+  /**
+   *  @fn void string_dumper(avl_node *n)
+   *
+   *  @brief outputs @a string struct contents for "dumpers"
+   *
+   *  @param n - pointer to existing @a avl_node struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void string_dumper(avl_node *n)
+{
+  string_node *sn;
+  string *str = NULL;
+
+  if (!n) return;
+
+  sn = (string_node *)n;
+
+  str = &sn->value;
+
+  do_indent(_dumper_file, _strings_indent);
+  fprintf(_dumper_file,
+          "id=%d, text='%s'\n",
+          str->id,
+          str->text ? str->text : "");
+}
+
+  /**
+   *  @fn static void libo_xl_cell_clear(libo_xl_cell *cell)
+   *
+   *  @brief clears contents of @p cell, freeing memory if needed
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_cell_clear(libo_xl_cell *cell)
+{
+  if (!cell) return;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_reference:
+      cell->reference = 0;
+      break;
+
+    case libo_xl_cell_type_expression:
+      if (cell->expression.value) free(cell->expression.value);
+      if (cell->expression.formula) free(cell->expression.formula);
+      memset(&cell->expression, 0, sizeof(libo_xl_cell_expression));
+      break;
+
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      cell->reference = 0;
+      break;
+
+    case libo_xl_cell_type_none:
+    default:
+      break;
+  }
+
+  libo_xl_cell_set_type(cell, libo_xl_cell_type_none);
+}
+
+  /**
+   *  @fn void libo_xl_sheet_count_columns(libo_xl_sheet *xls)
+   *
+   *  @brief finds maximum columns in @p xls
+   *
+   *  NOTE:  This function modifies the n_cols field in @p xls
+   *
+   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_sheet_count_columns(libo_xl_sheet *xls)
+{
+  int i;
+  libo_xl_row *row;
+
+  if (!xls) return;
+
+    // stored rows are not scanned, their width is tracked as they are added
+
+  if (xls->store) return;
+
+  xls->n_cols = 0;
+
+  for (i = 0; i < xls->n_rows; i++)
+  {
+    row = xls->row[i];
+    if (row->n_cells > xls->n_cols)
+      xls->n_cols = row->n_cells;
+  }
+}
+
+  /**
+   *  @fn libo_xl_column **libo_xl_sheet_columns_create_defaults(libo_xl_sheet *sheet)
+   *
+   *  @brief creates a @a libo_xl_column for each column used in @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return pointer to array of @a libo_xl_column pointers
+   */
+
+static libo_xl_column **libo_xl_sheet_columns_create_defaults(libo_xl_sheet *sheet)
+{
+  libo_xl_column **columns = NULL;
+  int i;
+
+  if (!sheet) goto exit;
+
+  columns = realloc(columns, sizeof(libo_xl_column *) * sheet->n_cols);
+  if (!columns) goto exit;
+
+  for (i = 0; i < sheet->n_cols; i++)
+    columns[i] = libo_xl_column_new_with_values(15, 1);
+
+exit:
+  return columns;
+}
+
+  /**
+   *  @fn static unsigned long hash_string(char *s)
+   *
+   *  @brief returns FNV-1a hash of @p s
+   *
+   *  @param s - string to hash
+   *
+   *  @return hash value
+   */
+
+static unsigned long hash_string(char *s)
+{
+  unsigned long h = 2166136261UL;
+
+  if (!s) return h;
+
+  while (*s)
+  {
+    h ^= (unsigned char)*s++;
+    h *= 16777619UL;
+  }
+
+  return h;
+}
+
+  /**
+   *  @fn static unsigned long hash_bytes(unsigned long h, void *p, size_t len)
+   *
+   *  @brief continues FNV-1a hash @p h over @p len bytes at @p p
+   *
+   *  @param h - hash value so far
+   *  @param p - pointer to bytes to hash
+   *  @param len - number of bytes to hash
+   *
+   *  @return hash value
+   */
+
+static unsigned long hash_bytes(unsigned long h, void *p, size_t len)
+{
+  unsigned char *b = (unsigned char *)p;
+
+  while (len--)
+  {
+    h ^= *b++;
+    h *= 16777619UL;
+  }
+
+  return h;
+}
+
+  /**
+   *  @fn static int zip_directory_crc(char *path, unsigned long *crc)
+   *
+   *  @brief computes checksum of ZIP central directory of file @p path
+   *
+   *  Only the central directory is read, no entry is decompressed.
+   *
+   *  @param path - name of ZIP file
+   *  @param crc - pointer to storage for checksum
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int zip_directory_crc(char *path, unsigned long *crc)
+{
+  zip_t *z;
+  zip_stat_t stat;
+  zip_int64_t n_entries;
+  zip_int64_t i;
+  unsigned long h = 2166136261UL;
+  int err = 0;
+
+  if (!path || !crc) return -1;
+
+  z = zip_open(path, ZIP_RDONLY, &err);
+  if (!z) return -1;
+
+  n_entries = zip_get_num_entries(z, 0);
+
+  for (i = 0; i < n_entries; i++)
+  {
+    if (zip_stat_index(z, i, 0, &stat)) continue;
+
+    if (stat.valid & ZIP_STAT_NAME) h = hash_bytes(h, (void *)stat.name, strlen(stat.name));
+    if (stat.valid & ZIP_STAT_CRC) h = hash_bytes(h, &stat.crc, sizeof(stat.crc));
+    if (stat.valid & ZIP_STAT_SIZE) h = hash_bytes(h, &stat.size, sizeof(stat.size));
+    if (stat.valid & ZIP_STAT_COMP_SIZE) h = hash_bytes(h, &stat.comp_size, sizeof(stat.comp_size));
+  }
+
+  zip_close(z);
+
+  *crc = h;
+
+  return 0;
+}
+
+  /**
+   *  @fn static libo_cache_entry *libo_cache_lookup(libo_cache *cache, char *path)
+   *
+   *  @brief finds entry for @p path in hash table of @p cache
+   *
+   *  NOTE:  caller must hold lock of @p cache
+   *
+   *  @param cache - pointer to existing @a libo_cache struct
+   *  @param path - path of document
+   *
+   *  @return pointer to @a libo_cache_entry, NULL if not cached
+   */
+
+static libo_cache_entry *libo_cache_lookup(libo_cache *cache, char *path)
+{
+  libo_cache_entry *e;
+
+  if (!cache || !path) return NULL;
+
+  e = cache->bucket[hash_string(path) & (cache->n_buckets - 1)];
+  while (e)
+  {
+    if (!strcmp(e->path, path)) return e;
+    e = e->chain;
+  }
+
+  return NULL;
+}
+
+  /**
+   *  @fn static void libo_cache_touch(libo_cache *cache, libo_cache_entry *e)
+   *
+   *  @brief moves @p e to front of LRU list of @p cache
+   *
+   *  NOTE:  caller must hold lock of @p cache
+   *
+   *  @param cache - pointer to existing @a libo_cache struct
+   *  @param e - pointer to existing @a libo_cache_entry struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_cache_touch(libo_cache *cache, libo_cache_entry *e)
+{
+  if (!cache || !e) return;
+  if (cache->head == e) return;
+
+  if (e->prev) e->prev->next = e->next;
+  if (e->next) e->next->prev = e->prev;
+  if (cache->tail == e) cache->tail = e->prev;
+
+  e->prev = NULL;
+  e->next = cache->head;
+  if (cache->head) cache->head->prev = e;
+  cache->head = e;
+  if (!cache->tail) cache->tail = e;
+}
+
+  /**
+   *  @fn static void libo_cache_insert(libo_cache *cache, libo_cache_entry *e)
+   *
+   *  @brief adds @p e to hash table and front of LRU list of @p cache
+   *
+   *  NOTE:  caller must hold lock of @p cache
+   *
+   *  @param cache - pointer to existing @a libo_cache struct
+   *  @param e - pointer to new @a libo_cache_entry struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_cache_insert(libo_cache *cache, libo_cache_entry *e)
+{
+  libo_cache_entry **tmp;
+  libo_cache_entry *p;
+  libo_cache_entry *next;
+  unsigned long slot;
+  int n_buckets;
+  int i;
+
+  if (!cache || !e) return;
+
+    // grow hash table to keep chains short
+
+  if (cache->n_entries >= cache->n_buckets)
+  {
+    n_buckets = cache->n_buckets * 2;
+    tmp = (libo_cache_entry **)malloc(sizeof(libo_cache_entry *) * n_buckets);
+    if (tmp)
+    {
+      memset(tmp, 0, sizeof(libo_cache_entry *) * n_buckets);
+      for (i = 0; i < cache->n_buckets; i++)
+      {
+        for (p = cache->bucket[i]; p; p = next)
+        {
+          next = p->chain;
+          slot = hash_string(p->path) & (n_buckets - 1);
+          p->chain = tmp[slot];
+          tmp[slot] = p;
+        }
+      }
+      free(cache->bucket);
+      cache->bucket = tmp;
+      cache->n_buckets = n_buckets;
+    }
+  }
+
+  slot = hash_string(e->path) & (cache->n_buckets - 1);
+  e->chain = cache->bucket[slot];
+  cache->bucket[slot] = e;
+
+  e->prev = e->next = NULL;
+  libo_cache_touch(cache, e);
+
+  cache->bytes += e->bytes;
+  ++cache->n_entries;
+}
+
+  /**
+   *  @fn static void libo_cache_remove(libo_cache *cache, libo_cache_entry *e)
+   *
+   *  @brief removes @p e from @p cache
+   *
+   *  If @p e is still referenced, it is kept on the stale list of @p cache
+   *  until its last reference is released, otherwise it is freed.
+   *
+   *  NOTE:  caller must hold lock of @p cache
+   *
+   *  @param cache - pointer to existing @a libo_cache struct
+   *  @param e - pointer to existing @a libo_cache_entry struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_cache_remove(libo_cache *cache, libo_cache_entry *e)
+{
+  libo_cache_entry **pp;
+
+  if (!cache || !e) return;
+
+  pp = &cache->bucket[hash_string(e->path) & (cache->n_buckets - 1)];
+  while (*pp && (*pp != e)) pp = &(*pp)->chain;
+  if (*pp) *pp = e->chain;
+
+  if (e->prev) e->prev->next = e->next;
+  if (e->next) e->next->prev = e->prev;
+  if (cache->head == e) cache->head = e->next;
+  if (cache->tail == e) cache->tail = e->prev;
+
+  cache->bytes -= e->bytes;
+  --cache->n_entries;
+
+  if (e->refs)
+  {
+    e->stale = 1;
+    e->chain = e->prev = NULL;
+    e->next = cache->stale;
+    cache->stale = e;
+    return;
+  }
+
+  libo_cache_entry_free(e);
+}
+
+  /**
+   *  @fn static void libo_cache_trim(libo_cache *cache)
+   *
+   *  @brief evicts least recently used, unreferenced documents from @p cache
+   *         until it fits its budget
+   *
+   *  NOTE:  caller must hold lock of @p cache
+   *
+   *  @param cache - pointer to existing @a libo_cache struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_cache_trim(libo_cache *cache)
+{
+  libo_cache_entry *e;
+  libo_cache_entry *prev;
+
+  if (!cache) return;
+
+  for (e = cache->tail; e && (cache->bytes > cache->budget); e = prev)
+  {
+    prev = e->prev;
+    if (!e->refs) libo_cache_remove(cache, e);
+  }
+}
+
+  /**
+   *  @fn static void libo_cache_entry_free(libo_cache_entry *e)
+   *
+   *  @brief frees all memory allocated to @p e, including its document
+   *
+   *  @param e - pointer to existing @a libo_cache_entry struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_cache_entry_free(libo_cache_entry *e)
+{
+  if (!e) return;
+
+  if (e->l) libo_free(e->l);
+  if (e->path) free(e->path);
+
+  free(e);
+}
+
+  /**
+   *  @fn static int pack_bytes(pack_buffer *b, void *p, size_t len)
+   *
+   *  @brief appends @p len bytes at @p p to @p b, growing it as needed
+   *
+   *  @param b - pointer to existing @a pack_buffer struct
+   *  @param p - pointer to bytes to append
+   *  @param len - number of bytes to append
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int pack_bytes(pack_buffer *b, void *p, size_t len)
+{
+  unsigned char *tmp;
+  size_t size;
+
+  if (!b) return -1;
+
+  if (b->len + len > b->size)
+  {
+    size = b->size ? b->size : 4096;
+    while (size < b->len + len) size *= 2;
+
+    tmp = (unsigned char *)realloc(b->data, size);
+    if (!tmp) return -1;
+
+    b->data = tmp;
+    b->size = size;
+  }
+
+  memcpy(b->data + b->len, p, len);
+  b->len += len;
+
+  return 0;
+}
+
+  /**
+   *  @fn static int pack_string(pack_buffer *b, char *s)
+   *
+   *  @brief appends length prefixed @p s to @p b
+   *
+   *  @param b - pointer to existing @a pack_buffer struct
+   *  @param s - string to append, can be NULL
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int pack_string(pack_buffer *b, char *s)
+{
+  int len = -1;
+
+  if (s) len = strlen(s);
+
+  if (pack_bytes(b, &len, sizeof(len))) return -1;
+  if (len > 0) return pack_bytes(b, s, len);
+
+  return 0;
+}
+
+  /**
+   *  @fn static int unpack_bytes(unsigned char **p,
+   *                              unsigned char *end,
+   *                              void *dst,
+   *                              size_t len)
+   *
+   *  @brief copies @p len bytes at @p *p to @p dst, advancing @p *p
+   *
+   *  @param p - pointer to read position
+   *  @param end - end of packed data
+   *  @param dst - storage for bytes
+   *  @param len - number of bytes to copy
+   *
+   *  @return 0 on success, -1 if packed data is too short
+   */
+
+static int unpack_bytes(unsigned char **p, unsigned char *end, void *dst, size_t len)
+{
+  if (!p || !*p) return -1;
+  if ((size_t)(end - *p) < len) return -1;
+
+  memcpy(dst, *p, len);
+  *p += len;
+
+  return 0;
+}
+
+  /**
+   *  @fn static char *unpack_string(unsigned char **p, unsigned char *end)
+   *
+   *  @brief returns new copy of length prefixed string at @p *p
+   *
+   *  @param p - pointer to read position
+   *  @param end - end of packed data
+   *
+   *  @return new string, NULL if string was NULL or data is too short
+   */
+
+static char *unpack_string(unsigned char **p, unsigned char *end)
+{
+  char *s;
+  int len;
+
+  if (unpack_bytes(p, end, &len, sizeof(len))) return NULL;
+  if (len < 0) return NULL;
+  if ((end - *p) < len) return NULL;
+
+  s = (char *)malloc(len + 1);
+  if (!s) return NULL;
+
+  memcpy(s, *p, len);
+  s[len] = 0;
+  *p += len;
+
+  return s;
+}
+
+  /**
+   *  @fn static int libo_xl_row_pack(libo_xl_row *row, pack_buffer *b)
+   *
+   *  @brief appends binary form of @p row to @p b
+   *
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *  @param b - pointer to existing @a pack_buffer struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_row_pack(libo_xl_row *row, pack_buffer *b)
+{
+  libo_xl_cell *cell;
+  unsigned char type;
+  int n_cells = 0;
+  int i;
+
+  if (row) n_cells = row->n_cells;
+
+  if (pack_bytes(b, &n_cells, sizeof(n_cells))) return -1;
+
+  for (i = 0; i < n_cells; i++)
+  {
+    cell = row->cell[i];
+    type = cell ? cell->type : libo_xl_cell_type_none;
+
+      // high bit of type tells a cell format follows
+
+    if (cell && cell->style) type |= 0x80;
+    if (pack_bytes(b, &type, sizeof(type))) return -1;
+    if ((type & 0x80) && pack_bytes(b, &cell->style, sizeof(cell->style))) return -1;
+
+    switch (type & 0x7f)
+    {
+      case libo_xl_cell_type_reference:
+        if (pack_bytes(b, &cell->reference, sizeof(cell->reference))) return -1;
+        break;
+
+      case libo_xl_cell_type_expression:
+        if (pack_string(b, cell->expression.formula)) return -1;
+        if (pack_string(b, cell->expression.value)) return -1;
+        if (pack_bytes(b, &cell->shared, sizeof(cell->shared))) return -1;
+        break;
+
+      case libo_xl_cell_type_number:
+      case libo_xl_cell_type_date:
+        if (pack_bytes(b, &cell->number, sizeof(cell->number))) return -1;
+        break;
+
+      case libo_xl_cell_type_boolean:
+        if (pack_bytes(b, &cell->boolean, sizeof(cell->boolean))) return -1;
+        break;
+
+      case libo_xl_cell_type_error:
+        if (pack_bytes(b, &cell->error, sizeof(cell->error))) return -1;
+        break;
+
+      case libo_xl_cell_type_none:
+      default:
+        break;
+    }
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static libo_xl_row *libo_xl_row_unpack(unsigned char **p,
+   *                                             unsigned char *end)
+   *
+   *  @brief creates new @a libo_xl_row struct from binary form at @p *p
+   *
+   *  @param p - pointer to read position, advanced past row
+   *  @param end - end of packed data
+   *
+   *  @return pointer to new @a libo_xl_row struct, NULL on error
+   */
+
+static libo_xl_row *libo_xl_row_unpack(unsigned char **p, unsigned char *end)
+{
+  libo_xl_row *row;
+  libo_xl_cell *cell;
+  unsigned char type;
+  int n_cells;
+  int i;
+
+  if (unpack_bytes(p, end, &n_cells, sizeof(n_cells))) return NULL;
+  if (n_cells < 0) return NULL;
+
+  row = libo_xl_row_new();
+  if (!row) return NULL;
+
+  if (n_cells)
+  {
+    row->cell = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * n_cells);
+    if (!row->cell) goto bail;
+    memset(row->cell, 0, sizeof(libo_xl_cell *) * n_cells);
+  }
+
+  for (i = 0; i < n_cells; i++)
+  {
+    if (unpack_bytes(p, end, &type, sizeof(type))) goto bail;
+
+    cell = row->cell[i] = libo_xl_cell_new();
+    if (!cell) goto bail;
+    ++row->n_cells;
+
+    cell->type = type & 0x7f;
+    if ((type & 0x80) && unpack_bytes(p, end, &cell->style, sizeof(cell->style))) goto bail;
+
+    switch (cell->type)
+    {
+      case libo_xl_cell_type_reference:
+        if (unpack_bytes(p, end, &cell->reference, sizeof(cell->reference))) goto bail;
+        break;
+
+      case libo_xl_cell_type_expression:
+        cell->expression.formula = unpack_string(p, end);
+        cell->expression.value = unpack_string(p, end);
+        if (unpack_bytes(p, end, &cell->shared, sizeof(cell->shared))) goto bail;
+        break;
+
+      case libo_xl_cell_type_number:
+      case libo_xl_cell_type_date:
+        if (unpack_bytes(p, end, &cell->number, sizeof(cell->number))) goto bail;
+        break;
+
+      case libo_xl_cell_type_boolean:
+        if (unpack_bytes(p, end, &cell->boolean, sizeof(cell->boolean))) goto bail;
+        break;
+
+      case libo_xl_cell_type_error:
+        if (unpack_bytes(p, end, &cell->error, sizeof(cell->error))) goto bail;
+        break;
+
+      case libo_xl_cell_type_none:
+      default:
+        break;
+    }
+  }
+
+  return row;
+
+bail:
+  libo_xl_row_free(row);
+
+  return NULL;
+}
+
+  /**
+   *  @fn static int libo_xl_sheet_evict(libo_xl_book *book,
+   *                                     libo_xl_sheet *sheet)
+   *
+   *  @brief drops rows of @p sheet, spilling them to a temporary file if
+   *         they can not be reparsed from the file of @p book
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param sheet - pointer to resident @a libo_xl_sheet struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_sheet_evict(libo_xl_book *book, libo_xl_sheet *sheet)
+{
+  pack_buffer b;
+  int i;
+
+  if (!book || !sheet) return -1;
+  if (sheet->state != libo_xl_sheet_state_resident) return 0;
+
+  if (sheet->dirty || !book->path)
+  {
+    memset(&b, 0, sizeof(pack_buffer));
+
+    for (i = 0; i < sheet->n_rows; i++)
+    {
+      if (libo_xl_row_pack(sheet->row[i], &b))
+      {
+        free(b.data);
+        return -1;
+      }
+    }
+
+    sheet->spill = tmpfile();
+    if (!sheet->spill)
+    {
+      free(b.data);
+      return -1;
+    }
+
+    if (b.len && (fwrite(b.data, 1, b.len, sheet->spill) != b.len))
+    {
+      fprintf(stderr, "Can not spill sheet '%s'\n", sheet->name);
+      fclose(sheet->spill);
+      sheet->spill = NULL;
+      free(b.data);
+      return -1;
+    }
+
+    free(b.data);
+
+    sheet->state = libo_xl_sheet_state_spilled;
+  }
+  else
+    sheet->state = libo_xl_sheet_state_evicted;
+
+  if (sheet->row)
+  {
+    for (i = 0; i < sheet->n_rows; i++)
+      libo_xl_row_free(sheet->row[i]);
+    free(sheet->row);
+    sheet->row = NULL;
+  }
+
+  sheet->bytes = 0;
+
+  return 0;
+}
+
+  /**
+   *  @fn static int libo_xl_sheet_restore(libo_xl_book *book,
+   *                                       libo_xl_sheet *sheet)
+   *
+   *  @brief makes rows of evicted or spilled @p sheet resident again
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_sheet_restore(libo_xl_book *book, libo_xl_sheet *sheet)
+{
+  libo l;
+  unsigned long crc = 0;
+  int err = 0;
+
+  if (!book || !sheet) return -1;
+
+  switch (sheet->state)
+  {
+    case libo_xl_sheet_state_resident:
+      return 0;
+
+    case libo_xl_sheet_state_evicted:
+      if (zip_directory_crc(book->path, &crc) || (crc != book->crc))
+      {
+        fprintf(stderr, "'%s' changed since it was read\n", book->path);
+        return -1;
+      }
+
+      memset(&l, 0, sizeof(libo));
+      l.path = book->path;
+      l.type = libo_type_xl;
+      l.options = book->options;
+      l.z = zip_open(book->path, ZIP_RDONLY, &err);
+      if (!l.z)
+      {
+        fprintf(stderr, "Can not open '%s', error code is %d\n", book->path, err);
+        return -1;
+      }
+
+      libo_xl_sheet_read(&l, sheet, sheet->index);
+
+      zip_close(l.z);
+      break;
+
+    case libo_xl_sheet_state_spilled:
+      if (sheet_unpack(sheet, sheet->spill))
+      {
+        fprintf(stderr, "Can not restore sheet '%s'\n", sheet->name);
+        return -1;
+      }
+
+      fclose(sheet->spill);
+      sheet->spill = NULL;
+      break;
+  }
+
+  sheet->state = libo_xl_sheet_state_resident;
+  sheet->bytes = libo_xl_sheet_memory_size(sheet);
+
+  return 0;
+}
+
+  /**
+   *  @fn static int sheet_unpack(libo_xl_sheet *sheet, FILE *fp)
+   *
+   *  @brief reads @a n_rows rows of @p sheet from spill file @p fp
+   *
+   *  @p fp is read without moving its position, so the sheet it was
+   *  spilled from is left as it is.  On failure no rows are kept.
+   *
+   *  @param sheet - pointer to @a libo_xl_sheet struct without rows
+   *  @param fp - spill file
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int sheet_unpack(libo_xl_sheet *sheet, FILE *fp)
+{
+  struct stat st;
+  unsigned char *data;
+  unsigned char *p;
+  size_t len;
+  int i;
+
+  if (!sheet || !fp) return -1;
+
+  if (fflush(fp) || fstat(fileno(fp), &st)) return -1;
+  len = (size_t)st.st_size;
+
+  data = (unsigned char *)malloc(len ? len : 1);
+  if (!data) return -1;
+
+  if (pread(fileno(fp), data, len, 0) != (ssize_t)len)
+  {
+    free(data);
+    return -1;
+  }
+
+  sheet->row = (libo_xl_row **)malloc(sizeof(libo_xl_row *) * (sheet->n_rows ? sheet->n_rows : 1));
+  if (!sheet->row)
+  {
+    free(data);
+    return -1;
+  }
+
+  for (p = data, i = 0; i < sheet->n_rows; i++)
+    if (!(sheet->row[i] = libo_xl_row_unpack(&p, data + len))) break;
+
+  free(data);
+
+    // on a short or corrupt spill file, keep no rows rather than leave
+    // some missing
+
+  if (i < sheet->n_rows)
+  {
+    while (i--) libo_xl_row_free(sheet->row[i]);
+    free(sheet->row);
+    sheet->row = NULL;
+    return -1;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static libo_xl_sheet *sheet_copy_rows(libo_xl_book *book,
+   *                                            libo_xl_sheet *sheet)
+   *
+   *  @brief returns resident copy of evicted or spilled @p sheet of @p book
+   *
+   *  Rows are read into the copy, from the file of @p book or from the
+   *  spill file, and @p sheet stays as it is.
+   *
+   *  @param book - pointer to existing @a libo_xl_book struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return pointer to new @a libo_xl_sheet struct, NULL on failure
+   */
+
+static libo_xl_sheet *sheet_copy_rows(libo_xl_book *book, libo_xl_sheet *sheet)
+{
+  libo_xl_sheet *nsheet;
+  int err = 0;
+
+  nsheet = libo_xl_sheet_dup(sheet);
+  if (!nsheet) return NULL;
+
+  nsheet->index = sheet->index;
+
+  switch (sheet->state)
+  {
+    case libo_xl_sheet_state_resident:
+      break;
+
+    case libo_xl_sheet_state_evicted:
+      nsheet->state = libo_xl_sheet_state_evicted;
+      err = libo_xl_sheet_restore(book, nsheet);
+      break;
+
+    case libo_xl_sheet_state_spilled:
+      nsheet->n_rows = sheet->n_rows;
+      err = sheet_unpack(nsheet, sheet->spill);
+      if (err) nsheet->n_rows = 0;
+      break;
+  }
+
+  if (err)
+  {
+    libo_xl_sheet_free(nsheet);
+    return NULL;
+  }
+
+  return nsheet;
+}
+
+  /**
+   *  @fn static void store_cache_key_create(void)
+   *
+   *  @brief creates key of per thread caches of decoded blocks, once
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void store_cache_key_create(void)
+{
+  if (!pthread_key_create(&_store_cache_key, store_cache_free))
+    _store_cache_ready = 1;
+}
+
+  /**
+   *  @fn static store_cache *store_cache_get(void)
+   *
+   *  @brief returns cache of decoded blocks of calling thread, creating it
+   *         on first use
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to @a store_cache, NULL on failure
+   */
+
+static store_cache *store_cache_get(void)
+{
+  store_cache *cache;
+
+  pthread_once(&_store_cache_once, store_cache_key_create);
+  if (!_store_cache_ready) return NULL;
+
+  cache = (store_cache *)pthread_getspecific(_store_cache_key);
+  if (cache) return cache;
+
+  cache = (store_cache *)malloc(sizeof(store_cache));
+  if (!cache) return NULL;
+  memset(cache, 0, sizeof(store_cache));
+
+  if (pthread_setspecific(_store_cache_key, cache))
+  {
+    free(cache);
+    return NULL;
+  }
+
+  return cache;
+}
+
+  /**
+   *  @fn static void store_cache_free(void *cache)
+   *
+   *  @brief frees all memory allocated to per thread @p cache
+   *
+   *  @param cache - pointer to existing @a store_cache struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void store_cache_free(void *cache)
+{
+  store_cache *sc = (store_cache *)cache;
+  int i;
+
+  if (!sc) return;
+
+  for (i = 0; i < LIBO_XL_STORE_PAGES; i++)
+    store_page_clear(&sc->page[i]);
+
+  free(sc);
+
+  return;
+}
+
+  /**
+   *  @fn static void store_page_clear(store_page *page)
+   *
+   *  @brief frees rows decoded into @p page, and marks it unused
+   *
+   *  @param page - pointer to existing @a store_page struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void store_page_clear(store_page *page)
+{
+  int i;
+
+  if (!page) return;
+
+  for (i = 0; i < page->n_rows; i++)
+    libo_xl_row_free(page->row[i]);
+  free(page->row);
+
+  memset(page, 0, sizeof(store_page));
+
+  return;
+}
+
+  /**
+   *  @fn static libo_xl_store *libo_xl_store_new(libo_xl_storage type)
+   *
+   *  @brief creates new, empty @a libo_xl_store
+   *
+   *  @param type - @a libo_xl_storage_disk for blocks in a temporary file,
+   *                @a libo_xl_storage_compressed for compressed blocks on
+   *                the heap, @a libo_xl_storage_columnar for blocks of
+   *                encoded columns
+   *
+   *  @return pointer to new @a libo_xl_store struct, NULL on failure
+   */
+
+static libo_xl_store *libo_xl_store_new(libo_xl_storage type)
+{
+  libo_xl_store *store;
+
+  if (type == libo_xl_storage_memory) return NULL;
+
+  store = (libo_xl_store *)malloc(sizeof(libo_xl_store));
+  if (!store) return NULL;
+  memset(store, 0, sizeof(libo_xl_store));
+
+  store->type = type;
+
+  if (type == libo_xl_storage_disk)
+  {
+    store->fp = tmpfile();
+    if (!store->fp)
+    {
+      fprintf(stderr, "Can not create temporary file for rows\n");
+      free(store);
+      return NULL;
+    }
+  }
+
+  pthread_mutex_init(&store->lock, NULL);
+
+  pthread_mutex_lock(&_store_serial_lock);
+  store->serial = ++_store_serial;
+  pthread_mutex_unlock(&_store_serial_lock);
+
+  return store;
+}
+
+  /**
+   *  @fn static void libo_xl_store_free(libo_xl_store *store)
+   *
+   *  @brief frees all memory allocated to @p store, and removes its file
+   *
+   *  Blocks of @p store decoded by other threads are never matched again,
+   *  and age out of their caches.
+   *
+   *  @param store - pointer to existing @a libo_xl_store struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_store_free(libo_xl_store *store)
+{
+  store_cache *cache;
+  int i;
+
+  if (!store) return;
+
+  if (_store_cache_ready)
+  {
+    cache = (store_cache *)pthread_getspecific(_store_cache_key);
+    if (cache)
+      for (i = 0; i < LIBO_XL_STORE_PAGES; i++)
+        if (cache->page[i].store == store->serial)
+          store_page_clear(&cache->page[i]);
+  }
+
+#ifndef _WIN32
+  if (store->map) munmap(store->map, store->map_size);
+#endif
+
+  if (store->fp) fclose(store->fp);
+
+  for (i = 0; i < store->n_blocks; i++)
+  {
+    free(store->block[i].data);
+    column_block_clear(&store->block[i]);
+  }
+
+  pthread_mutex_destroy(&store->lock);
+
+  free(store->block);
+  free(store->pending.data);
+  free(store);
+
+  return;
+}
+
+  /**
+   *  @fn static int libo_xl_store_append(libo_xl_store *store,
+   *                                      libo_xl_row *row)
+   *
+   *  @brief appends copy of @p row to end of @p store
+   *
+   *  @param store - pointer to existing @a libo_xl_store struct
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_store_append(libo_xl_store *store, libo_xl_row *row)
+{
+  int err = 0;
+
+  if (!store) return -1;
+
+  pthread_mutex_lock(&store->lock);
+
+  if (libo_xl_row_pack(row, &store->pending))
+    err = -1;
+  else
+  {
+    ++store->pending_rows;
+    ++store->n_rows;
+
+      // columnar blocks are sized by rows, so columns encode in even groups
+
+    if (store->type == libo_xl_storage_columnar)
+    {
+      if (store->pending_rows >= LIBO_XL_STORE_GROUP)
+        err = libo_xl_store_flush(store);
+    }
+    else if (store->pending.len >= LIBO_XL_STORE_BLOCK)
+      err = libo_xl_store_flush(store);
+  }
+
+  pthread_mutex_unlock(&store->lock);
+
+  return err;
+}
+
+  /**
+   *  @fn static int libo_xl_store_flush(libo_xl_store *store)
+   *
+   *  @brief seals pending rows of @p store into a new block, written to its
+   *         file, compressed, or split into encoded columns
+   *
+   *  NOTE:  Caller must hold lock of @p store.
+   *
+   *  @param store - pointer to existing @a libo_xl_store struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_store_flush(libo_xl_store *store)
+{
+  store_block *tmp;
+  store_block *block;
+  unsigned char *data = NULL;
+  unsigned char *shrunk;
+  size_t len;
+
+  if (!store) return -1;
+  if (!store->pending_rows) return 0;
+
+  tmp = realloc(store->block, sizeof(store_block) * (store->n_blocks + 1));
+  if (!tmp) return -1;
+  store->block = tmp;
+
+  block = &store->block[store->n_blocks];
+  memset(block, 0, sizeof(store_block));
+
+  len = store->pending.len;
+
+  if (store->type == libo_xl_storage_columnar)
+  {
+    if (column_block_build(block, &store->pending, store->pending_rows))
+      return -1;
+    len = 0;
+  }
+  else if (store->type == libo_xl_storage_compressed)
+  {
+    data = (unsigned char *)malloc(len ? len : 1);
+    if (!data) return -1;
+
+      // blocks that do not shrink are kept as they are
+
+    len = lz_compress(store->pending.data, store->pending.len, data, store->pending.len);
+    if (!len)
+    {
+      len = store->pending.len;
+      memcpy(data, store->pending.data, len);
+    }
+
+    shrunk = realloc(data, len ? len : 1);
+    if (shrunk) data = shrunk;
+  }
+  else if (fseek(store->fp, store->size, SEEK_SET) ||
+           (fwrite(store->pending.data, 1, len, store->fp) != len))
+  {
+    fprintf(stderr, "Can not write rows to temporary file\n");
+    return -1;
+  }
+
+  block->offset = store->size;
+  block->len = len;
+  block->raw_len = store->pending.len;
+  block->data = data;
+  block->first_row = store->n_rows - store->pending_rows;
+  block->n_rows = store->pending_rows;
+
+  ++store->n_blocks;
+  store->size += len;
+
+  store->pending.len = 0;
+  store->pending_rows = 0;
+
+  return 0;
+}
+
+  /**
+   *  @fn static libo_xl_row *libo_xl_store_get_row(libo_xl_store *store,
+   *                                                int n)
+   *
+   *  @brief returns row at index @p n from @p store
+   *
+   *  The block holding the row is decoded into the least recently used
+   *  page of the calling thread's cache if it is not already there, so
+   *  rows returned stay valid until the thread has read
+   *  @a LIBO_XL_STORE_PAGES other blocks.
+   *
+   *  @param store - pointer to existing @a libo_xl_store struct
+   *  @param n - index of row to retrieve
+   *
+   *  @return pointer to cached @a libo_xl_row, NULL on failure
+   */
+
+static libo_xl_row *libo_xl_store_get_row(libo_xl_store *store, int n)
+{
+  store_cache *cache;
+  store_block block;
+  store_page *page = NULL;
+  unsigned char *data = NULL;
+  unsigned char *raw = NULL;
+  unsigned char *p;
+  int locked = 0;
+  int lo, hi, mid;
+  int i;
+
+  if (!store) return NULL;
+
+  cache = store_cache_get();
+  if (!cache) return NULL;
+
+  pthread_mutex_lock(&store->lock);
+  locked = 1;
+
+  if ((n < 0) || (n >= store->n_rows)) goto bail;
+
+  if (n >= (store->n_rows - store->pending_rows))
+    if (libo_xl_store_flush(store)) goto bail;
+
+    // find block holding row
+
+  lo = 0;
+  hi = store->n_blocks - 1;
+  while (lo < hi)
+  {
+    mid = (lo + hi + 1) / 2;
+    if (store->block[mid].first_row <= n) lo = mid;
+    else hi = mid - 1;
+  }
+  block = store->block[lo];
+
+  ++cache->clock;
+
+  for (i = 0; i < LIBO_XL_STORE_PAGES; i++)
+  {
+    if ((cache->page[i].store == store->serial) && (cache->page[i].block == lo))
+    {
+      page = &cache->page[i];
+      page->used = cache->clock;
+      pthread_mutex_unlock(&store->lock);
+      return page->row[n - block.first_row];
+    }
+    if (!page || (cache->page[i].used < page->used)) page = &cache->page[i];
+  }
+
+    // reuse least recently used page
+
+  store_page_clear(page);
+
+  page->row = (libo_xl_row **)malloc(sizeof(libo_xl_row *) * block.n_rows);
+  if (!page->row) goto bail;
+  memset(page->row, 0, sizeof(libo_xl_row *) * block.n_rows);
+
+  if (store->type != libo_xl_storage_disk)
+  {
+      // compressed and columnar blocks never change, so decode them unlocked
+
+    pthread_mutex_unlock(&store->lock);
+    locked = 0;
+  }
+
+  if (store->type == libo_xl_storage_columnar)
+  {
+    page->n_rows = block.n_rows;
+    if (column_block_decode(&block, page->row)) goto bail;
+  }
+  else if (store->type == libo_xl_storage_compressed)
+  {
+    data = block.data;
+    if (block.len < block.raw_len)
+    {
+      raw = (unsigned char *)malloc(block.raw_len);
+      if (!raw) goto bail;
+      if (lz_decompress(block.data, block.len, raw, block.raw_len))
+      {
+        fprintf(stderr, "Corrupt block of compressed rows\n");
+        goto bail;
+      }
+      data = raw;
+    }
+  }
+  else
+  {
+#ifndef _WIN32
+    if (store->map_size < store->size)
+    {
+      if (store->map) munmap(store->map, store->map_size);
+      store->map = NULL;
+      store->map_size = 0;
+
+      if (fflush(store->fp)) goto bail;
+
+      store->map = mmap(NULL, store->size, PROT_READ, MAP_SHARED, fileno(store->fp), 0);
+      if (store->map == MAP_FAILED)
+      {
+        fprintf(stderr, "Can not map temporary file of rows\n");
+        store->map = NULL;
+        goto bail;
+      }
+      store->map_size = store->size;
+    }
+
+    data = store->map + block.offset;
+#else
+    raw = (unsigned char *)malloc(block.len ? block.len : 1);
+    if (!raw) goto bail;
+
+    if (fseek(store->fp, block.offset, SEEK_SET) ||
+        (fread(raw, 1, block.len, store->fp) != block.len))
+      goto bail;
+
+    data = raw;
+#endif
+  }
+
+  if (store->type != libo_xl_storage_columnar)
+  {
+    for (p = data, i = 0; i < block.n_rows; i++)
+    {
+      page->row[i] = libo_xl_row_unpack(&p, data + block.raw_len);
+      if (!page->row[i]) break;
+      ++page->n_rows;
+    }
+
+    if (page->n_rows != block.n_rows) goto bail;
+  }
+
+  page->store = store->serial;
+  page->block = lo;
+  page->used = cache->clock;
+
+  if (locked) pthread_mutex_unlock(&store->lock);
+  free(raw);
+
+  return page->row[n - block.first_row];
+
+bail:
+  if (page) store_page_clear(page);
+  if (locked) pthread_mutex_unlock(&store->lock);
+  free(raw);
+
+  return NULL;
+}
+
+  /**
+   *  @fn static size_t libo_xl_store_memory_size(libo_xl_store *store)
+   *
+   *  @brief returns number of bytes of heap memory used by @p store
+   *
+   *  Blocks in the file, its mapping, and blocks decoded into per thread
+   *  caches are not counted.
+   *
+   *  @param store - pointer to existing @a libo_xl_store struct
+   *
+   *  @return approximate number of bytes allocated to @p store
+   */
+
+static size_t libo_xl_store_memory_size(libo_xl_store *store)
+{
+  store_block *block;
+  size_t bytes;
+  int i, j;
+
+  if (!store) return 0;
+
+  bytes = sizeof(libo_xl_store);
+  bytes += sizeof(store_block) * store->n_blocks;
+  bytes += store->pending.size;
+
+  for (i = 0; i < store->n_blocks; i++)
+  {
+    block = &store->block[i];
+    if (block->data) bytes += block->len;
+    if (block->widths) bytes += sizeof(int) * block->n_rows;
+    bytes += sizeof(column_chunk) * block->n_chunks;
+    for (j = 0; j < block->n_chunks; j++)
+      bytes += column_chunk_memory_size(&block->chunk[j]);
+  }
+
+  return bytes;
+}
+
+  /**
+   *  @fn static void lz_emit(unsigned char **op,
+   *                          unsigned char *oend,
+   *                          unsigned char *literals,
+   *                          size_t n_literals,
+   *                          size_t offset,
+   *                          size_t match)
+   *
+   *  @brief appends one sequence of the LZ4 block format at @p *op
+   *
+   *  @param op - pointer to write position, advanced past sequence
+   *  @param oend - end of output buffer
+   *  @param literals - bytes copied before match
+   *  @param n_literals - number of @p literals
+   *  @param offset - distance back to start of match
+   *  @param match - length of match, 0 for last sequence
+   *
+   *  @return 0 on success, -1 if output buffer is too small
+   */
+
+static int lz_emit(unsigned char **op,
+                   unsigned char *oend,
+                   unsigned char *literals,
+                   size_t n_literals,
+                   size_t offset,
+                   size_t match)
+{
+  unsigned char *o = *op;
+  unsigned char *token;
+  size_t n;
+
+  if (o >= oend) return -1;
+  token = o++;
+
+  n = n_literals;
+  *token = (n < 15 ? n : 15) << 4;
+  if (n >= 15)
+  {
+    for (n -= 15; n >= 255; n -= 255)
+    {
+      if (o >= oend) return -1;
+      *o++ = 255;
+    }
+    if (o >= oend) return -1;
+    *o++ = (unsigned char)n;
+  }
+
+  if ((size_t)(oend - o) < n_literals) return -1;
+  memcpy(o, literals, n_literals);
+  o += n_literals;
+
+  if (match)
+  {
+    if ((oend - o) < 2) return -1;
+    *o++ = offset & 0xff;
+    *o++ = (offset >> 8) & 0xff;
+
+    n = match - 4;
+    *token |= (n < 15 ? n : 15);
+    if (n >= 15)
+    {
+      for (n -= 15; n >= 255; n -= 255)
+      {
+        if (o >= oend) return -1;
+        *o++ = 255;
+      }
+      if (o >= oend) return -1;
+      *o++ = (unsigned char)n;
+    }
+  }
+
+  *op = o;
+
+  return 0;
+}
+
+  /**
+   *  @fn static size_t lz_compress(unsigned char *src,
+   *                                size_t len,
+   *                                unsigned char *dst,
+   *                                size_t cap)
+   *
+   *  @brief compresses @p src into @p dst in the LZ4 block format
+   *
+   *  A single pass with a small hash table of recent 4 byte sequences,
+   *  trading ratio for speed as LZ4 does.
+   *
+   *  @param src - bytes to compress
+   *  @param len - number of bytes in @p src
+   *  @param dst - output buffer
+   *  @param cap - size of @p dst
+   *
+   *  @return number of bytes written to @p dst, 0 if they do not fit
+   */
+
+static size_t lz_compress(unsigned char *src, size_t len, unsigned char *dst, size_t cap)
+{
+  size_t table[1 << LZ_HASH_BITS];
+  unsigned char *op = dst;
+  unsigned char *oend = dst + cap;
+  size_t ip = 0;
+  size_t anchor = 0;
+  size_t ref;
+  size_t match;
+  unsigned int seq, rseq;
+  unsigned int h;
+
+  memset(table, 0, sizeof(table));
+
+    // last match must start 12 bytes, and end 5 bytes, before end of input
+
+  if (len >= 13)
+  {
+    while (ip + 12 <= len)
+    {
+      memcpy(&seq, src + ip, 4);
+      h = (seq * 2654435761U) >> (32 - LZ_HASH_BITS);
+      ref = table[h];
+      table[h] = ip;
+
+      if ((ref >= ip) || ((ip - ref) > 65535))
+      {
+        ++ip;
+        continue;
+      }
+
+      memcpy(&rseq, src + ref, 4);
+      if (rseq != seq)
+      {
+        ++ip;
+        continue;
+      }
+
+      match = 4;
+      while ((ip + match < len - 5) && (src[ref + match] == src[ip + match]))
+        ++match;
+
+      if (lz_emit(&op, oend, src + anchor, ip - anchor, ip - ref, match)) return 0;
+
+      ip += match;
+      anchor = ip;
+    }
+  }
+
+  if (lz_emit(&op, oend, src + anchor, len - anchor, 0, 0)) return 0;
+
+  if ((size_t)(op - dst) >= len) return 0;
+
+  return op - dst;
+}
+
+  /**
+   *  @fn static int lz_decompress(unsigned char *src,
+   *                               size_t len,
+   *                               unsigned char *dst,
+   *                               size_t raw_len)
+   *
+   *  @brief expands LZ4 block format @p src into exactly @p raw_len bytes
+   *
+   *  @param src - compressed bytes
+   *  @param len - number of bytes in @p src
+   *  @param dst - output buffer of @p raw_len bytes
+   *  @param raw_len - expected number of output bytes
+   *
+   *  @return 0 on success, -1 if @p src is corrupt
+   */
+
+static int lz_decompress(unsigned char *src, size_t len, unsigned char *dst, size_t raw_len)
+{
+  unsigned char *ip = src;
+  unsigned char *iend = src + len;
+  unsigned char *op = dst;
+  unsigned char *oend = dst + raw_len;
+  unsigned char token;
+  unsigned char b;
+  size_t n;
+  size_t offset;
+
+  while (ip < iend)
+  {
+    token = *ip++;
+
+    n = token >> 4;
+    if (n == 15)
+    {
+      do
+      {
+        if (ip >= iend) return -1;
+        b = *ip++;
+        n += b;
+      } while (b == 255);
+    }
+
+    if (((size_t)(iend - ip) < n) || ((size_t)(oend - op) < n)) return -1;
+    memcpy(op, ip, n);
+    ip += n;
+    op += n;
+
+    if (ip == iend) break;
+
+    if ((iend - ip) < 2) return -1;
+    offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (!offset || (offset > (size_t)(op - dst))) return -1;
+
+    n = token & 15;
+    if (n == 15)
+    {
+      do
+      {
+        if (ip >= iend) return -1;
+        b = *ip++;
+        n += b;
+      } while (b == 255);
+    }
+    n += 4;
+
+    if ((size_t)(oend - op) < n) return -1;
+
+      // matches may overlap their own output
+
+    for (; n; --n, ++op)
+      *op = *(op - offset);
+  }
+
+  return (op == oend) ? 0 : -1;
+}
+
+  /**
+   *  @fn static libo_xl_cell *libo_xl_cell_parse(char *t,
+   *                                               int s,
+   *                                               char *f,
+   *                                               char *v)
+   *
+   *  @brief creates new @a libo_xl_cell from text of a work sheet cell
+   *
+   *  Cells holding a formula are expressions, whatever the type of the
+   *  value cached with it.
+   *
+   *  @param t - value of cell type attribute, or NULL
+   *  @param s - value of cell style attribute, 0 if none
+   *  @param f - content of formula element, or NULL
+   *  @param v - content of value element, or NULL
+   *
+   *  @return pointer to new @a libo_xl_cell struct
+   */
+
+static libo_xl_cell *libo_xl_cell_parse(char *t, int s, char *f, char *v)
+{
+  libo_xl_cell *cell;
+
+  cell = libo_xl_cell_new();
+  if (!cell) return NULL;
+
+  if (f && *f)
+    cell->type = libo_xl_cell_type_expression;
+  else if (t)
+    cell->type = string_to_libo_xl_cell_type(t);
+  else
+    cell->type = libo_xl_cell_type_number;
+
+  if (f && *f) cell->expression.formula = strdup(f);
+  libo_xl_cell_parse_value(cell, v);
+
+  if ((s > 0) && (s < LIBO_XL_STYLES_MAX)) cell->style = s;
+
+  return cell;
+}
+
+  /**
+   *  @fn static void libo_xl_cell_parse_value(libo_xl_cell *cell, char *v)
+   *
+   *  @brief sets value of @p cell, whose type is set, from text of its
+   *         value element
+   *
+   *  Error codes that are not known are kept as expression text, and
+   *  numbers without a value are empty.
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param v - content of value element, or NULL
+   *
+   *  @return None.
+   */
+
+static void libo_xl_cell_parse_value(libo_xl_cell *cell, char *v)
+{
+  libo_xl_error error;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_none:
+    case libo_xl_cell_type_empty:
+      break;
+    case libo_xl_cell_type_reference:
+      if (v) cell->reference = atoi(v);
+      break;
+    case libo_xl_cell_type_expression:
+      if (v) cell->expression.value = strdup(v);
+      break;
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      if (v)
+        cell->number = atof(v);
+      else
+        cell->type = libo_xl_cell_type_empty;
+      break;
+    case libo_xl_cell_type_boolean:
+      cell->boolean = v && (atoi(v) != 0);
+      break;
+    case libo_xl_cell_type_error:
+      error = libo_xl_error_from_string(v);
+      if (error != libo_xl_error_none)
+        cell->error = error;
+      else
+      {
+        cell->type = libo_xl_cell_type_expression;
+        cell->expression.formula = NULL;
+        cell->expression.value = v ? strdup(v) : NULL;
+      }
+      break;
+  }
+}
+
+  /**
+   *  @fn static libo_xl_cell *libo_xl_cell_new_padding(void)
+   *
+   *  @brief creates new @a libo_xl_cell standing in for a missing cell
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_cell struct
+   */
+
+static libo_xl_cell *libo_xl_cell_new_padding(void)
+{
+  libo_xl_cell *cell;
+
+  cell = libo_xl_cell_new();
+  if (!cell) return NULL;
+
+  cell->type = libo_xl_cell_type_empty;
+
+  return cell;
+}
+
+  /**
+   *  @fn static int zip_read_callback(void *context, char *buffer, int len)
+   *
+   *  @brief feeds bytes of an open ZIP member to an XML reader
+   *
+   *  @param context - pointer to open @a zip_file_t
+   *  @param buffer - buffer to fill
+   *  @param len - size of @p buffer
+   *
+   *  @return number of bytes read, 0 at end, -1 on error
+   */
+
+static int zip_read_callback(void *context, char *buffer, int len)
+{
+  return (int)zip_fread((zip_file_t *)context, buffer, len);
+}
+
+  /**
+   *  @fn static libo_xl_seek_index *seek_index_new(void)
+   *
+   *  @brief creates an empty index of checkpoints
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @return pointer to new @a libo_xl_seek_index struct
+   */
+
+static libo_xl_seek_index *seek_index_new(void)
+{
+  libo_xl_seek_index *seek;
+
+  seek = (libo_xl_seek_index *)malloc(sizeof(libo_xl_seek_index));
+  if (!seek) return NULL;
+  memset(seek, 0, sizeof(libo_xl_seek_index));
+
+  return seek;
+}
+
+  /**
+   *  @fn static void seek_index_free(libo_xl_seek_index *seek)
+   *
+   *  @brief frees all memory allocated to @p seek
+   *
+   *  @param seek - pointer to existing @a libo_xl_seek_index struct, or NULL
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void seek_index_free(libo_xl_seek_index *seek)
+{
+  int i;
+
+  if (!seek) return;
+
+  for (i = 0; i < seek->n_points; i++)
+    free(seek->point[i].window);
+  free(seek->point);
+  free(seek->prolog);
+  for (i = 0; i < seek->n_shared; i++)
+    free(seek->shared[i]);
+  free(seek->shared);
+
+  free(seek);
+}
+
+  /**
+   *  @fn static size_t seek_index_memory_size(libo_xl_seek_index *seek)
+   *
+   *  @brief returns number of bytes of memory used by @p seek
+   *
+   *  @param seek - pointer to existing @a libo_xl_seek_index struct, or NULL
+   *
+   *  @return approximate number of bytes allocated to @p seek
+   */
+
+static size_t seek_index_memory_size(libo_xl_seek_index *seek)
+{
+  size_t bytes;
+  int i;
+
+  if (!seek) return 0;
+
+  bytes = sizeof(libo_xl_seek_index) + seek->n_prolog;
+  bytes += sizeof(seek_point) * seek->size_points;
+  for (i = 0; i < seek->n_points; i++)
+    bytes += seek->point[i].n_window;
+  bytes += sizeof(char *) * seek->n_shared;
+  for (i = 0; i < seek->n_shared; i++)
+    if (seek->shared[i]) bytes += strlen(seek->shared[i]) + 1;
+
+  return bytes;
+}
+
+  /**
+   *  @fn static seek_point *seek_index_find(libo_xl_seek_index *seek, int row)
+   *
+   *  @brief finds last checkpoint of @p seek before row @p row starts
+   *
+   *  @param seek - pointer to existing @a libo_xl_seek_index struct
+   *  @param row - index of row
+   *
+   *  @return pointer to checkpoint, NULL if there is none before @p row
+   */
+
+static seek_point *seek_index_find(libo_xl_seek_index *seek, int row)
+{
+  int lo = 0;
+  int hi;
+  int mid;
+
+  hi = seek->n_points;
+
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    if (seek->point[mid].row <= row)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo ? &seek->point[lo - 1] : NULL;
+}
+
+  /**
+   *  @fn static int seek_index_add(seek_stream *s)
+   *
+   *  @brief adds a checkpoint at the current end of the XML of @p s to the
+   *         index it builds
+   *
+   *  The last 32K of XML are copied out of the circular window, oldest
+   *  first.
+   *
+   *  @param s - pointer to existing @a seek_stream struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int seek_index_add(seek_stream *s)
+{
+  libo_xl_seek_index *seek = s->build;
+  seek_point *npoint;
+  seek_point *point;
+  size_t tail;
+
+  if (seek->n_points == seek->size_points)
+  {
+    npoint = (seek_point *)realloc(seek->point, sizeof(seek_point) *
+                                                (seek->size_points ? 2 * seek->size_points : 16));
+    if (!npoint) return -1;
+    seek->point = npoint;
+    seek->size_points = seek->size_points ? 2 * seek->size_points : 16;
+  }
+
+  point = &seek->point[seek->n_points];
+  point->in = s->strm.total_in;
+  point->bits = s->strm.data_type & 7;
+  point->out = s->out;
+  point->row = s->rows;
+  point->n_window = s->wrapped ? LIBO_XL_SEEK_WINDOW : (int)s->have;
+
+  point->window = (unsigned char *)malloc(point->n_window);
+  if (!point->window) return -1;
+
+  tail = s->wrapped ? LIBO_XL_SEEK_WINDOW - s->have : 0;
+  if (tail) memcpy(point->window, s->window + s->have, tail);
+  memcpy(point->window + tail, s->window, s->have);
+
+  ++seek->n_points;
+  s->last = s->out;
+
+  return 0;
+}
+
+  /**
+   *  @fn static seek_stream *seek_stream_open(zip_t *z,
+   *                                           char *path,
+   *                                           libo_xl_seek_index *seek,
+   *                                           seek_point *point,
+   *                                           libo_xl_seek_index *build,
+   *                                           size_t span)
+   *
+   *  @brief opens member @p path of @p z for raw deflate decompression,
+   *         from @p point of @p seek, or from the start
+   *
+   *  Decompression resumes by reading on from the compressed byte the
+   *  checkpoint stopped in, with the 32K of XML before it as dictionary.
+   *  The XML read then starts with the prolog of @p seek, up to the name of
+   *  its first row, and goes on with the first row after the checkpoint,
+   *  so it is well formed.
+   *
+   *  @param z - pointer to open ZIP file
+   *  @param path - name of member
+   *  @param seek - index @p point belongs to, or NULL
+   *  @param point - checkpoint to resume from, or NULL to start at the start
+   *  @param build - index to add checkpoints to, or NULL
+   *  @param span - bytes of XML between checkpoints added to @p build
+   *
+   *  @return pointer to new @a seek_stream struct, NULL if the member is
+   *          not deflated or can not be opened
+   */
+
+static seek_stream *seek_stream_open(zip_t *z,
+                                     char *path,
+                                     libo_xl_seek_index *seek,
+                                     seek_point *point,
+                                     libo_xl_seek_index *build,
+                                     size_t span)
+{
+  seek_stream *s;
+  zip_stat_t stat;
+  zip_int64_t len;
+  size_t skip;
+  unsigned char c;
+
+  if (zip_stat(z, path, 0, &stat)) return NULL;
+  if (!(stat.valid & ZIP_STAT_COMP_METHOD) || (stat.comp_method != ZIP_CM_DEFLATE)) return NULL;
+  if ((stat.valid & ZIP_STAT_ENCRYPTION_METHOD) && (stat.encryption_method != ZIP_EM_NONE)) return NULL;
+
+  s = (seek_stream *)malloc(sizeof(seek_stream));
+  if (!s) return NULL;
+  memset(s, 0, sizeof(seek_stream));
+
+  if (inflateInit2(&s->strm, -15) != Z_OK)
+  {
+    free(s);
+    return NULL;
+  }
+
+  s->zf = zip_fopen(z, path, ZIP_FL_COMPRESSED);
+  if (!s->zf) goto bail;
+
+  s->build = build;
+  s->span = span;
+  s->found = 1;
+
+  if (point)
+  {
+      // move to byte holding first bits of next block, reading over
+      // compressed bytes if member can not seek
+
+    skip = point->in - (point->bits ? 1 : 0);
+    if (zip_fseek(s->zf, (zip_int64_t)skip, SEEK_SET))
+    {
+      while (skip)
+      {
+        len = zip_fread(s->zf, s->in, (skip < LIBO_XL_SEEK_INPUT) ? skip : LIBO_XL_SEEK_INPUT);
+        if (len <= 0) goto bail;
+        skip -= (size_t)len;
+      }
+    }
+
+    if (point->bits)
+    {
+      if (zip_fread(s->zf, &c, 1) != 1) goto bail;
+      if (inflatePrime(&s->strm, point->bits, c >> (8 - point->bits)) != Z_OK) goto bail;
+    }
+
+    if (inflateSetDictionary(&s->strm, point->window, point->n_window) != Z_OK) goto bail;
+
+    s->out = s->last = point->out;
+    s->rows = point->row;
+    s->head = seek->prolog;
+    s->n_head = seek->n_prolog;
+    s->found = 0;
+  }
+  else if (build)
+    s->found = 0;
+
+  return s;
+
+bail:
+  seek_stream_close(s);
+
+  return NULL;
+}
+
+  /**
+   *  @fn static void seek_stream_close(seek_stream *s)
+   *
+   *  @brief closes member read by @p s, and frees all memory allocated to
+   *         @p s
+   *
+   *  @param s - pointer to existing @a seek_stream struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void seek_stream_close(seek_stream *s)
+{
+  if (!s) return;
+
+  inflateEnd(&s->strm);
+  if (s->zf) zip_fclose(s->zf);
+
+  free(s);
+}
+
+  /**
+   *  @fn static int seek_stream_fill(seek_stream *s)
+   *
+   *  @brief inflates more XML into the window of @p s, once all of it has
+   *         been read
+   *
+   *  Inflation stops at the end of each deflate block, where a checkpoint
+   *  is added once @a span bytes of XML have passed since the last, as
+   *  long as no row name is cut in two.
+   *
+   *  @param s - pointer to existing @a seek_stream struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int seek_stream_fill(seek_stream *s)
+{
+  zip_int64_t len;
+  size_t start;
+  int ret;
+
+  if (s->have == LIBO_XL_SEEK_WINDOW)
+  {
+    s->have = s->sent = 0;
+    s->wrapped = 1;
+  }
+
+  if (!s->strm.avail_in)
+  {
+    len = zip_fread(s->zf, s->in, LIBO_XL_SEEK_INPUT);
+    if (len < 0) return -1;
+    if (!len)
+    {
+      s->end = 1;
+      return 0;
+    }
+    s->strm.next_in = s->in;
+    s->strm.avail_in = (uInt)len;
+  }
+
+  start = s->have;
+  s->strm.next_out = s->window + s->have;
+  s->strm.avail_out = (uInt)(LIBO_XL_SEEK_WINDOW - s->have);
+
+  ret = inflate(&s->strm, Z_BLOCK);
+  if ((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR)) return -1;
+
+  s->have = LIBO_XL_SEEK_WINDOW - s->strm.avail_out;
+  s->out += s->have - start;
+
+  if (seek_stream_scan(s, start)) return -1;
+
+  if (ret == Z_STREAM_END)
+  {
+    s->end = 1;
+    return 0;
+  }
+
+  if (s->build && s->found && !s->match &&
+      (s->strm.data_type & 128) && !(s->strm.data_type & 64) &&
+      (s->out - s->last >= s->span))
+  {
+    if (seek_index_add(s)) s->build = NULL;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static int seek_stream_scan(seek_stream *s, size_t start)
+   *
+   *  @brief counts rows starting in XML just inflated into window of @p s,
+   *         from @p start
+   *
+   *  Rows are found by the name of their start tag, "<row" followed by
+   *  white space, '>' or '/', which may be cut across two calls.  While
+   *  building an index, XML up to the name of the first row is kept as
+   *  its prolog.  When resuming, XML before the first row is passed over.
+   *
+   *  @param s - pointer to existing @a seek_stream struct
+   *  @param start - position in window of first byte just inflated
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int seek_stream_scan(seek_stream *s, size_t start)
+{
+  static const char tag[] = "<row";
+  libo_xl_seek_index *build = s->build;
+  unsigned char *prolog;
+  unsigned char *q;
+  unsigned char ch;
+  size_t p = start;
+  size_t keep;
+
+  while (p < s->have)
+  {
+    if (!s->match)
+    {
+      q = memchr(s->window + p, '<', s->have - p);
+      if (!q)
+      {
+        p = s->have;
+        break;
+      }
+      p = q - s->window;
+    }
+
+    ch = s->window[p];
+
+    if (s->match == 4)
+    {
+      s->match = 0;
+      if ((ch == ' ') || (ch == '>') || (ch == '/') ||
+          (ch == '\t') || (ch == '\r') || (ch == '\n'))
+      {
+        if (!s->found) break;
+        ++s->rows;
+        ++p;
+        continue;
+      }
+    }
+
+    if (ch == tag[s->match])
+      ++s->match;
+    else
+      s->match = (ch == '<');
+    ++p;
+  }
+
+  if (s->found) return 0;
+
+    // first row found at p, or none yet
+
+  keep = p - start;
+
+  if (s->head)
+  {
+      // resuming, so XML before first row is passed over, and reading
+      // goes on from prolog ending in its name
+
+    s->sent = p;
+    if (p == s->have) return 0;
+  }
+  else if (build)
+  {
+    if (build->n_prolog + keep > LIBO_XL_SEEK_PROLOG)
+    {
+      s->build = NULL;
+      s->found = 1;
+      return 0;
+    }
+
+    prolog = (unsigned char *)realloc(build->prolog, build->n_prolog + keep + 1);
+    if (!prolog) return -1;
+    build->prolog = prolog;
+    memcpy(build->prolog + build->n_prolog, s->window + start, keep);
+    build->n_prolog += keep;
+
+    if (p == s->have) return 0;
+  }
+
+  ++s->rows;
+  s->found = 1;
+
+  if (p + 1 < s->have) return seek_stream_scan(s, p + 1);
+
+  return 0;
+}
+
+  /**
+   *  @fn static int seek_stream_read(void *context, char *buffer, int len)
+   *
+   *  @brief feeds XML of a work sheet, decompressed by a @a seek_stream, to
+   *         an XML reader
+   *
+   *  @param context - pointer to open @a seek_stream
+   *  @param buffer - buffer to fill
+   *  @param len - size of @p buffer
+   *
+   *  @return number of bytes read, 0 at end, -1 on error
+   */
+
+static int seek_stream_read(void *context, char *buffer, int len)
+{
+  seek_stream *s = (seek_stream *)context;
+  size_t k;
+  int n = 0;
+
+  while (n < len)
+  {
+    if (s->found && (s->sent_head < s->n_head))
+    {
+      k = s->n_head - s->sent_head;
+      if (k > (size_t)(len - n)) k = len - n;
+      memcpy(buffer + n, s->head + s->sent_head, k);
+      s->sent_head += k;
+      n += (int)k;
+    }
+    else if (s->sent < s->have)
+    {
+      k = s->have - s->sent;
+      if (k > (size_t)(len - n)) k = len - n;
+      memcpy(buffer + n, s->window + s->sent, k);
+      s->sent += k;
+      n += (int)k;
+    }
+    else if (s->end)
+      break;
+    else if (seek_stream_fill(s))
+      return -1;
+  }
+
+  return n;
+}
+
+  /**
+   *  @fn static int sheet_reader_open(libo *l,
+   *                                   int n,
+   *                                   libo_xl_seek_index **seek,
+   *                                   int first,
+   *                                   int resume,
+   *                                   sheet_reader *sr)
+   *
+   *  @brief opens an XML reader over work sheet number @p n of @p l
+   *
+   *  When @p resume is set, reading resumes from the last checkpoint of
+   *  @p seek before row @p first, so rows before it are not decompressed
+   *  at all.  Reading from the start instead builds a new index of
+   *  checkpoints, when the options of @p l ask for one.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param n - index of work sheet to read
+   *  @param seek - index of checkpoints of work sheet, or NULL
+   *  @param first - index of first row wanted
+   *  @param resume - 1 if rows need not be counted from the start
+   *  @param sr - pointer to @a sheet_reader struct to fill
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int sheet_reader_open(libo *l,
+                             int n,
+                             libo_xl_seek_index **seek,
+                             int first,
+                             int resume,
+                             sheet_reader *sr)
+{
+  char path[4096];
+
+  memset(sr, 0, sizeof(sheet_reader));
+
+  memset(path, 0, 4096);
+
+  sprintf(path, "xl/worksheets/sheet%d.xml", n+1);
+
+  if (seek && *seek && ((*seek)->sheet == n) && resume)
+    sr->point = seek_index_find(*seek, first);
+
+  if (seek && !sr->point && libo_options_get_seek_span(l->options))
+  {
+    sr->build = seek_index_new();
+    if (!sr->build) return -1;
+    sr->build->sheet = n;
+  }
+
+  if (sr->point || sr->build)
+  {
+    sr->ss = seek_stream_open(l->z, path, sr->point ? *seek : NULL, sr->point, sr->build,
+                              libo_options_get_seek_span(l->options));
+    if (!sr->ss)
+    {
+      seek_index_free(sr->build);
+      sr->build = NULL;
+      sr->point = NULL;
+    }
+  }
+
+  if (sr->ss)
+    sr->reader = xmlReaderForIO(seek_stream_read, NULL, sr->ss, path, NULL, 0);
+  else
+  {
+    sr->zf = zip_fopen(l->z, path, 0);
+    if (!sr->zf)
+    {
+      fprintf(stderr, "Can not open '%s'\n", path); fflush(stderr);
+      return -1;
+    }
+    sr->reader = xmlReaderForIO(zip_read_callback, NULL, sr->zf, path, NULL, 0);
+  }
+
+  if (!sr->reader)
+  {
+    sheet_reader_close(sr, NULL);
+    return -1;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static void sheet_reader_close(sheet_reader *sr,
+   *                                     libo_xl_seek_index **seek)
+   *
+   *  @brief closes XML reader of @p sr and the work sheet it reads
+   *
+   *  An index of checkpoints built while reading replaces @p seek if it
+   *  reaches further into the work sheet.
+   *
+   *  @param sr - pointer to @a sheet_reader struct filled by
+   *              @a sheet_reader_open
+   *  @param seek - index of checkpoints of work sheet, or NULL to drop the
+   *                index built
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void sheet_reader_close(sheet_reader *sr, libo_xl_seek_index **seek)
+{
+  if (sr->reader) xmlFreeTextReader(sr->reader);
+
+  if (sr->build && sr->ss) sr->build->out = sr->ss->out;
+
+  if (sr->ss) seek_stream_close(sr->ss);
+  if (sr->zf) zip_fclose(sr->zf);
+
+    // keep whichever index reaches further into the work sheet
+
+  if (seek && sr->build && sr->build->n_points &&
+      (!*seek || (sr->build->out > (*seek)->out)))
+  {
+    seek_index_free(*seek);
+    *seek = sr->build;
+  }
+  else
+    seek_index_free(sr->build);
+
+  memset(sr, 0, sizeof(sheet_reader));
+}
+
+  /**
+   *  @fn static int libo_xl_sheet_stream(libo *l,
+   *                                      libo_xl_sheet *sheet,
+   *                                      int n,
+   *                                      int *source,
+   *                                      libo_xl_seek_index **seek,
+   *                                      int first,
+   *                                      row_select select,
+   *                                      void *select_data,
+   *                                      row_handler handler,
+   *                                      void *data)
+   *
+   *  @brief reads rows of work sheet number @p n of @p l one at a time,
+   *         passing each to @p handler
+   *
+   *  The work sheet is decompressed and parsed incrementally, so only one
+   *  row is in memory at a time.  Rows are built like those of
+   *  @a libo_xl_sheet_rows_read.  Each row is freed after @p handler
+   *  returns.
+   *
+   *  Raw values of the cells of a row are kept until the row ends, and
+   *  tested against the predicates of the options of @p l as they arrive.
+   *  Once a row fails, the rest of it is passed over unread, and no cell
+   *  of it is ever built.
+   *
+   *  Cells of a shared formula are given its text in full as they are
+   *  read.  Formulas shared from rows before a checkpoint are kept in
+   *  @p seek, and reading resumes only from checkpoints whose earlier
+   *  rows were read when it was built.
+   *
+   *  When the options of @p l name columns, rows hold only those columns,
+   *  in that order, and cells of other columns are passed over unread
+   *  unless a predicate tests them.  Columns named by heading are found in
+   *  the first row, which is read whole.
+   *
+   *  Rows meeting the predicates are offered to @p select before they are
+   *  built, which can pass over them, or stop reading, so the rest of the
+   *  work sheet is never decompressed.  Without predicates, rows are
+   *  offered as they start, and rows passed over are never read.
+   *
+   *  Without predicates or columns named by heading, reading resumes from
+   *  the last checkpoint of @p seek before row @p first, so rows before it
+   *  are not decompressed at all.  Reading from the start instead builds
+   *  a new index of checkpoints, when the options of @p l ask for one,
+   *  which replaces @p seek if it reaches further.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet - work sheet whose cell formats showing dates the cells
+   *                 read take, or NULL
+   *  @param n - index of work sheet to read
+   *  @param source - receives column of file each column kept was read
+   *                  from, one for each column named by options, or NULL
+   *  @param seek - index of checkpoints of work sheet, or NULL
+   *  @param first - index of first row wanted
+   *  @param select - function choosing rows to build, or NULL for all
+   *  @param select_data - passed to @p select
+   *  @param handler - function called with each row
+   *  @param data - passed to @p handler
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_sheet_stream(libo *l,
+                                libo_xl_sheet *sheet,
+                                int n,
+                                int *source,
+                                libo_xl_seek_index **seek,
+                                int first,
+                                row_select select,
+                                void *select_data,
+                                row_handler handler,
+                                void *data)
+{
+  sheet_reader sr;
+  xmlTextReaderPtr reader;
+  libo_xl_row *row = NULL;
+  libo_xl_cell *cell;
+  libo_xl_cell **tmp;
+  libo_xl_predicate *pred;
+  libo_xl_projection *pick = NULL;
+  view_test *test = NULL;
+  stream_cell *token = NULL;
+  stream_cell *ntoken;
+  int *seen = NULL;
+  int *from = NULL;
+  int *slot = NULL;
+  int n_tests;
+  int n_picks;
+  int n_slots = 0;
+  int header_rows;
+  int n_tokens = 0;
+  int size_tokens = 0;
+  int size = 0;
+  int n_cols = -1;
+  int n_rows = 0;
+  int n_read = 0;
+  int in_row = 0;
+  int in_cell = 0;
+  int testing = 0;
+  int naming = 0;
+  int resolving = 0;
+  int keep = 0;
+  int skip = 0;
+  int pass = 0;
+  int chosen;
+  int r, c = 0;
+  int last_c = -1;
+  int start;
+  int i, j;
+  int type;
+  int ret = 0;
+  int stop = 0;
+  int empty;
+  char *name;
+  char *ref;
+  char *spans;
+  char *t = NULL;
+  char *f = NULL;
+  char *v = NULL;
+  char *p;
+  char **shared = NULL;
+  int style = 0;
+  int n_shared = 0;
+
+  if (!l || !handler) return -1;
+  if (n < 0) return -1;
+
+  n_tests = libo_options_get_predicate_count(l->options);
+  n_picks = libo_options_get_column_count(l->options);
+  header_rows = libo_options_get_header_rows(l->options);
+
+  if (n_tests)
+  {
+    test = (view_test *)calloc(n_tests, sizeof(view_test));
+    seen = (int *)calloc(n_tests, sizeof(int));
+    if (!test || !seen)
+    {
+      free(test);
+      free(seen);
+      return -1;
+    }
+
+    for (i = 0; i < n_tests; i++)
+    {
+      if (view_test_init(&test[i], &l->options->predicate[i]))
+      {
+        n_tests = i;
+        ret = -1;
+        goto bail;
+      }
+    }
+  }
+
+    // columns named by heading wait for the first row
+
+  if (n_picks)
+  {
+    pick = l->options->column;
+
+    from = (int *)malloc(sizeof(int) * n_picks);
+    if (!from)
+    {
+      ret = -1;
+      goto bail;
+    }
+
+    for (j = 0; j < n_picks; j++)
+    {
+      from[j] = pick[j].col;
+      if (pick[j].name) naming = 1;
+    }
+
+    if (!naming && stream_slots(from, n_picks, &slot, &n_slots))
+    {
+      ret = -1;
+      goto bail;
+    }
+  }
+
+    // resume from a checkpoint, unless rows must be counted from the start,
+    // and only where the shared formulas of the rows before it are known
+
+  start = first;
+  if (seek && *seek && (start > (*seek)->shared_rows)) start = (*seek)->shared_rows;
+
+  if (sheet_reader_open(l, n, seek, start, !n_tests && !naming, &sr))
+  {
+    ret = -1;
+    goto bail;
+  }
+  reader = sr.reader;
+
+  if (sr.point)
+  {
+    n_cols = (*seek)->n_cols;
+    n_rows = n_read = sr.point->row;
+
+    if ((*seek)->n_shared)
+    {
+      shared = (char **)calloc((*seek)->n_shared, sizeof(char *));
+      if (shared) n_shared = (*seek)->n_shared;
+      for (i = 0; shared && (i < n_shared); i++)
+        if ((*seek)->shared[i] && !(shared[i] = strdup((*seek)->shared[i]))) break;
+
+      if (!shared || (i < n_shared))
+      {
+        sheet_reader_close(&sr, NULL);
+        ret = -1;
+        goto bail;
+      }
+    }
+  }
+
+  while (!stop && ((ret = xmlTextReaderRead(reader)) == 1))
+  {
+    type = xmlTextReaderNodeType(reader);
+    name = (char *)xmlTextReaderConstLocalName(reader);
+    if (!name) continue;
+
+    empty = (type == XML_READER_TYPE_ELEMENT) && xmlTextReaderIsEmptyElement(reader);
+
+    if (type == XML_READER_TYPE_ELEMENT)
+    {
+      if (!strcmp(name, "row"))
+      {
+          // width of sheet comes from first row, as in count_sheet_columns_in_xml
+
+        if (n_cols < 0)
+        {
+          n_cols = 0;
+          spans = (char *)xmlTextReaderGetAttribute(reader, (xmlChar *)"spans");
+          if (spans)
+          {
+            p = strchr(spans, ':');
+            if (p) n_cols = atoi(p + 1);
+            xmlFree(spans);
+          }
+          if (sr.build) sr.build->n_cols = n_cols;
+        }
+
+        testing = n_tests && (n_read >= header_rows);
+        resolving = naming && !n_read;
+        skip = 0;
+        pass = 0;
+        last_c = -1;
+        if (testing) memset(seen, 0, sizeof(int) * n_tests);
+
+          // rows not tested are chosen before any cell is read
+
+        if (select && !testing)
+        {
+          chosen = select(n_rows, select_data);
+          if (chosen < 0)
+          {
+            stop = 1;
+            continue;
+          }
+          pass = !chosen;
+        }
+
+        in_row = 1;
+      }
+      else if (!strcmp(name, "c") && in_row && ((!skip && !pass) || resolving))
+      {
+        ref = (char *)xmlTextReaderGetAttribute(reader, (xmlChar *)"r");
+        if (ref)
+        {
+          cell_ref_to_row_col(ref, &r, &c);
+          xmlFree(ref);
+        }
+        else
+        {
+          r = n_read;
+          c = last_c + 1;
+        }
+        last_c = c;
+
+          // cells outside projection are passed over, unless tested
+
+        keep = !n_picks || resolving || ((c < n_slots) && (slot[c] >= 0));
+
+        in_cell = keep;
+        for (i = 0; !in_cell && testing && (i < n_tests); i++)
+          if (l->options->predicate[i].col == c) in_cell = 1;
+
+        if (in_cell)
+        {
+          t = (char *)xmlTextReaderGetAttribute(reader, (xmlChar *)"t");
+
+          p = (char *)xmlTextReaderGetAttribute(reader, (xmlChar *)"s");
+          if (p) style = atoi(p);
+          xmlFree(p);
+        }
+      }
+      else if (in_row && !strcmp(name, "f"))
+      {
+          // shared formulas are noted even in cells passed over
+
+        if (f) xmlFree(f);
+        f = stream_formula_share(reader, r, c, in_cell, &shared, &n_shared);
+      }
+      else if (in_cell && !strcmp(name, "v"))
+      {
+        if (v) xmlFree(v);
+        v = (char *)xmlTextReaderReadString(reader);
+      }
+    }
+
+    if (!empty && (type != XML_READER_TYPE_END_ELEMENT)) continue;
+
+    if (!strcmp(name, "c") && in_cell)
+    {
+        // test raw values, so failing rows never build a cell
+
+      if (testing && ((n_cols <= 0) || (c < n_cols)))
+      {
+        for (i = 0; i < n_tests; i++)
+        {
+          pred = &l->options->predicate[i];
+          if (pred->col != c) continue;
+          seen[i] = 1;
+          if (!view_test_token(&test[i], t, v)) skip = 1;
+        }
+      }
+
+      keep = keep && ((!skip && !pass) || resolving);
+
+      if (keep && (n_tokens == size_tokens))
+      {
+        ntoken = (stream_cell *)realloc(token, sizeof(stream_cell) *
+                                              (size_tokens ? 2 * size_tokens : 16));
+        if (ntoken)
+        {
+          token = ntoken;
+          size_tokens = size_tokens ? 2 * size_tokens : 16;
+        }
+        else
+        {
+          keep = 0;
+          skip = 1;
+        }
+      }
+
+      if (keep)
+      {
+        token[n_tokens].col = c;
+        token[n_tokens].s = style;
+        token[n_tokens].t = t;
+        token[n_tokens].f = f;
+        token[n_tokens].v = v;
+        ++n_tokens;
+      }
+      else
+      {
+        if (t) xmlFree(t);
+        if (f) xmlFree(f);
+        if (v) xmlFree(v);
+      }
+
+      t = f = v = NULL;
+      style = 0;
+      in_cell = 0;
+    }
+    else if (!strcmp(name, "row") && in_row)
+    {
+        // headings name columns of shared strings
+
+      if (resolving)
+      {
+        for (j = 0; j < n_picks; j++)
+        {
+          if (!pick[j].name) continue;
+
+          from[j] = -1;
+          for (i = 0; (pick[j].id >= 0) && (i < n_tokens); i++)
+          {
+            if (token[i].t && !strcmp(token[i].t, "s") && token[i].v &&
+                (atoi(token[i].v) == pick[j].id))
+            {
+              from[j] = token[i].col;
+              break;
+            }
+          }
+        }
+
+        if (stream_slots(from, n_picks, &slot, &n_slots)) skip = stop = 1;
+        naming = resolving = 0;
+      }
+
+        // missing cells meet no predicate
+
+      if (testing)
+      {
+        for (i = 0; i < n_tests; i++)
+          if (!seen[i]) skip = 1;
+      }
+
+      if (!skip && testing && select)
+      {
+        chosen = select(n_rows, select_data);
+        if (chosen < 0) stop = 1;
+        pass = (chosen <= 0);
+      }
+
+      if (!skip && !pass) row = libo_xl_row_new();
+      size = 0;
+
+      if (row && n_picks)
+      {
+          // place cells of projection, then fill columns still empty
+
+        row->cell = (libo_xl_cell **)calloc(n_picks, sizeof(libo_xl_cell *));
+        if (row->cell)
+        {
+          row->n_cells = n_picks;
+
+          for (i = 0; i < n_tokens; i++)
+          {
+            c = token[i].col;
+            if ((c >= n_slots) || (slot[c] < 0)) continue;
+            if ((n_cols > 0) && (c >= n_cols)) continue;
+            if (row->cell[slot[c]]) continue;
+            row->cell[slot[c]] = libo_xl_cell_parse(token[i].t, token[i].s, token[i].f, token[i].v);
+            cell_resolve_date(row->cell[slot[c]], sheet);
+          }
+
+          for (j = 0; j < n_picks; j++)
+          {
+            if (row->cell[j]) continue;
+
+            c = from[j];
+            if ((c >= 0) && (c < n_slots) && (slot[c] != j) && row->cell[slot[c]])
+              row->cell[j] = libo_xl_cell_dup(row->cell[slot[c]]);
+            else
+              row->cell[j] = libo_xl_cell_new_padding();
+          }
+
+          for (j = 0; j < n_picks; j++)
+            if (!row->cell[j]) break;
+        }
+
+        if (!row->cell || (j < n_picks))
+        {
+          libo_xl_row_free(row);
+          row = NULL;
+        }
+      }
+
+        // pad skipped cells, drop cells beyond width of sheet
+
+      for (i = 0; row && !n_picks && (i < n_tokens); i++)
+      {
+        c = token[i].col;
+
+        while (((n_cols <= 0) || (row->n_cells < n_cols)) && (row->n_cells <= c))
+        {
+          if (row->n_cells == size)
+          {
+            size = size ? size * 2 : 16;
+            tmp = realloc(row->cell, sizeof(libo_xl_cell *) * size);
+            if (!tmp) break;
+            row->cell = tmp;
+          }
+
+          if (row->n_cells < c)
+            cell = libo_xl_cell_new_padding();
+          else
+            cell = libo_xl_cell_parse(token[i].t, token[i].s, token[i].f, token[i].v);
+          if (!cell) break;
+          cell_resolve_date(cell, sheet);
+
+          row->cell[row->n_cells++] = cell;
+        }
+      }
+
+      while (row && !n_picks && (row->n_cells < n_cols))
+      {
+        if (row->n_cells == size)
+        {
+          size = n_cols;
+          tmp = realloc(row->cell, sizeof(libo_xl_cell *) * size);
+          if (!tmp) break;
+          row->cell = tmp;
+        }
+        cell = libo_xl_cell_new_padding();
+        if (!cell) break;
+        row->cell[row->n_cells++] = cell;
+      }
+
+      for (i = 0; i < n_tokens; i++)
+      {
+        if (token[i].t) xmlFree(token[i].t);
+        if (token[i].f) xmlFree(token[i].f);
+        if (token[i].v) xmlFree(token[i].v);
+      }
+      n_tokens = 0;
+
+      if (row) stop = handler(row, n_rows, data);
+      if (!skip) ++n_rows;
+      ++n_read;
+
+      libo_xl_row_free(row);
+      row = NULL;
+      in_row = 0;
+    }
+    else if (!strcmp(name, "sheetData"))
+      break;
+  }
+
+  if (t) xmlFree(t);
+  if (f) xmlFree(f);
+  if (v) xmlFree(v);
+  for (i = 0; i < n_tokens; i++)
+  {
+    if (token[i].t) xmlFree(token[i].t);
+    if (token[i].f) xmlFree(token[i].f);
+    if (token[i].v) xmlFree(token[i].v);
+  }
+
+    // an index built keeps the shared formulas of the rows read
+
+  if (sr.build)
+  {
+    sr.build->shared_rows = n_read;
+    sr.build->n_shared = n_shared;
+    sr.build->shared = shared;
+    n_shared = 0;
+    shared = NULL;
+  }
+
+  sheet_reader_close(&sr, seek);
+
+  if (source && from)
+  {
+    for (j = 0; j < n_picks; j++)
+      source[j] = (naming && pick[j].name) ? -1 : from[j];
+  }
+
+bail:
+  for (i = 0; i < n_tests; i++)
+    view_test_clear(&test[i]);
+  for (i = 0; i < n_shared; i++)
+    free(shared[i]);
+  free(shared);
+  free(test);
+  free(seen);
+  free(token);
+  free(from);
+  free(slot);
+
+  return (ret < 0) ? -1 : 0;
+}
+
+  /**
+   *  @fn static int stream_slots(int *from, int n, int **slot, int *n_slots)
+   *
+   *  @brief builds table giving position in projection of each column of
+   *         file, -1 for columns not kept
+   *
+   *  A column kept more than once is placed at its first position.
+   *
+   *  @param from - column of file for each of @p n columns kept, or -1
+   *  @param n - number of columns kept
+   *  @param slot - receives new table, to be freed by caller
+   *  @param n_slots - receives number of entries of @p slot
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int stream_slots(int *from, int n, int **slot, int *n_slots)
+{
+  int i;
+
+  *n_slots = 0;
+  for (i = 0; i < n; i++)
+    if (from[i] >= *n_slots) *n_slots = from[i] + 1;
+
+  free(*slot);
+  *slot = (int *)malloc(sizeof(int) * (*n_slots ? *n_slots : 1));
+  if (!*slot)
+  {
+    *n_slots = 0;
+    return -1;
+  }
+
+  for (i = 0; i < *n_slots; i++)
+    (*slot)[i] = -1;
+
+  for (i = n - 1; i >= 0; i--)
+    if (from[i] >= 0) (*slot)[from[i]] = i;
+
+  return 0;
+}
+
+  /**
+   *  @fn static char *stream_formula_share(xmlTextReaderPtr reader,
+   *                                        int row,
+   *                                        int col,
+   *                                        int keep,
+   *                                        char ***shared,
+   *                                        int *n_shared)
+   *
+   *  @brief reads formula of the element of @p reader, for a cell at @p row
+   *         and @p col
+   *
+   *  The first cell of a shared formula gives its text, kept in R1C1 form
+   *  in @p shared by its identifier.  Other cells of it are given the
+   *  text made from that.
+   *
+   *  @param reader - reader positioned on an f element
+   *  @param row - index of row of cell in file
+   *  @param col - index of column of cell in file
+   *  @param keep - 0 if the formula of the cell is not wanted, only noted
+   *  @param shared - table of shared formulas read so far, grown as needed,
+   *                  to be freed by caller
+   *  @param n_shared - number of entries of @p shared
+   *
+   *  @return formula of cell, to be freed by xmlFree(), NULL if not
+   *          wanted or on failure
+   */
+
+static char *stream_formula_share(xmlTextReaderPtr reader,
+                                  int row,
+                                  int col,
+                                  int keep,
+                                  char ***shared,
+                                  int *n_shared)
+{
+  char **nshared;
+  char *t;
+  char *si;
+  char *ref;
+  char *f = NULL;
+  size_t len;
+  int k = -1;
+  int i;
+
+  t = (char *)xmlTextReaderGetAttribute(reader, (xmlChar *)"t");
+  if (!t || strcmp(t, "shared"))
+  {
+    if (t) xmlFree(t);
+    return keep ? (char *)xmlTextReaderReadString(reader) : NULL;
+  }
+  xmlFree(t);
+
+  si = (char *)xmlTextReaderGetAttribute(reader, (xmlChar *)"si");
+  if (si)
+  {
+    if (isdigit((unsigned char)*si)) k = atoi(si);
+    xmlFree(si);
+  }
+  if ((k < 0) || (k >= LIBO_XL_CALC_ROWS))
+    return keep ? (char *)xmlTextReaderReadString(reader) : NULL;
+
+    // the first cell names the range of the formula
+
+  ref = (char *)xmlTextReaderGetAttribute(reader, (xmlChar *)"ref");
+  if (ref)
+  {
+    cell_ref_to_row_col(ref, &row, &col);
+    xmlFree(ref);
+
+    f = (char *)xmlTextReaderReadString(reader);
+    if (f && *f)
+    {
+      if (k >= *n_shared)
+      {
+        nshared = (char **)realloc(*shared, sizeof(char *) * (k + 1));
+        if (nshared)
+        {
+          for (i = *n_shared; i <= k; i++)
+            nshared[i] = NULL;
+          *shared = nshared;
+          *n_shared = k + 1;
+        }
+      }
+
+      if (k < *n_shared)
+      {
+        free((*shared)[k]);
+        (*shared)[k] = libo_xl_formula_to_r1c1(f, row, col);
+      }
+    }
+
+    if (!keep && f)
+    {
+      xmlFree(f);
+      f = NULL;
+    }
+
+    return f;
+  }
+
+  if (!keep) return NULL;
+
+  if ((k >= *n_shared) || !(*shared)[k])
+    return (char *)xmlTextReaderReadString(reader);
+
+  len = libo_xl_formula_from_r1c1((*shared)[k], row, col, NULL, 0);
+  f = (char *)xmlMalloc(len + 1);
+  if (f) libo_xl_formula_from_r1c1((*shared)[k], row, col, f, len + 1);
+
+  return f;
+}
+
+  /**
+   *  @fn static int store_row_handler(libo_xl_row *row, int n, void *data)
+   *
+   *  @brief adds streamed @p row to the work sheet in @p data
+   *
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *  @param n - index of @p row in work sheet
+   *  @param data - pointer to @a libo_xl_sheet struct
+   *
+   *  @return 0 to continue reading, -1 on failure
+   */
+
+static int store_row_handler(libo_xl_row *row, int n, void *data)
+{
+  libo_xl_sheet *sheet = (libo_xl_sheet *)data;
+  int n_rows;
+
+  if (sheet->profile) libo_xl_sheet_profile_row(sheet, row);
+
+  n_rows = sheet->n_rows;
+  libo_xl_sheet_add(sheet, row);
+
+  if (row->n_cells > sheet->n_cols) sheet->n_cols = row->n_cells;
+
+  return (sheet->n_rows == n_rows) ? -1 : 0;
+}
+
+  /**
+   *  @fn static int libo_xl_sheet_read_stream(libo *l,
+   *                                           libo_xl_sheet *sheet,
+   *                                           int n,
+   *                                           int first,
+   *                                           row_select select,
+   *                                           void *select_data,
+   *                                           row_handler handler,
+   *                                           void *data)
+   *
+   *  @brief streams rows of work sheet number @p n of @p l into @p sheet,
+   *         through @p handler
+   *
+   *  Rows go to a store when the options of @p l ask for one.  Reading
+   *  resumes from, or builds, checkpoints of @p sheet.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct, emptied
+   *  @param n - index of work sheet to read
+   *  @param first - index of first row wanted
+   *  @param select - function choosing rows to build, or NULL for all
+   *  @param select_data - passed to @p select
+   *  @param handler - function called with each row
+   *  @param data - passed to @p handler
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_sheet_read_stream(libo *l,
+                                     libo_xl_sheet *sheet,
+                                     int n,
+                                     int first,
+                                     row_select select,
+                                     void *select_data,
+                                     row_handler handler,
+                                     void *data)
+{
+  int ret;
+
+  if (!sheet->store && (libo_options_get_storage(l->options) != libo_xl_storage_memory))
+  {
+    sheet->store = libo_xl_store_new(libo_options_get_storage(l->options));
+    if (!sheet->store) return -1;
+  }
+
+    // columns kept are only known once any headings have been read
+
+  free(sheet->source);
+  sheet->source = NULL;
+  sheet->n_sources = libo_options_get_column_count(l->options);
+  if (sheet->n_sources)
+  {
+    sheet->source = (int *)malloc(sizeof(int) * sheet->n_sources);
+    if (!sheet->source)
+    {
+      sheet->n_sources = 0;
+      return -1;
+    }
+  }
+
+  ret = libo_xl_sheet_stream(l, sheet, n, sheet->source, &sheet->seek, first,
+                             select, select_data, handler, data);
+
+  sheet->dirty = 0;
+
+  return ret;
+}
+
+  /**
+   *  @fn static void libo_xl_sheet_read_reset(libo *l, libo_xl_sheet *sheet)
+   *
+   *  @brief empties @p sheet of rows, before they are read into it
+   *
+   *  Rows of evicted sheets are already gone, though they are still
+   *  counted.  An empty profile table asks for columns to be profiled as
+   *  rows arrive.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_sheet_read_reset(libo *l, libo_xl_sheet *sheet)
+{
+  int i;
+
+  if (sheet->row)
+  {
+    for (i = 0; i < sheet->n_rows; i++)
+      libo_xl_row_free(sheet->row[i]);
+    free(sheet->row);
+    sheet->row = NULL;
+  }
+
+  libo_xl_store_free(sheet->store);
+  sheet->store = NULL;
+
+  sheet_shared_free(sheet);
+
+  sheet->n_rows = 0;
+  sheet->n_cols = 0;
+
+  if (libo_options_get_profile(l->options))
+  {
+    libo_xl_sheet_profiles_free(sheet);
+    sheet->profile = (libo_xl_column_profile **)calloc(1, sizeof(libo_xl_column_profile *));
+  }
+}
+
+  /**
+   *  @fn static int libo_xl_sheet_sample(libo *l,
+   *                                      libo_xl_sheet *sheet,
+   *                                      int n,
+   *                                      int k,
+   *                                      unsigned long seed)
+   *
+   *  @brief reads @p k rows chosen at random from work sheet number @p n of
+   *         @p l into @p sheet
+   *
+   *  Rows are chosen by reservoir sampling, so each row has the same
+   *  chance of being kept, in one pass over the work sheet.
+   *
+   *  @param l - pointer to existing @a libo struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct, emptied
+   *  @param n - index of work sheet to read
+   *  @param k - number of rows sampled
+   *  @param seed - seed of random choice of rows
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_sheet_sample(libo *l, libo_xl_sheet *sheet, int n, int k, unsigned long seed)
+{
+  row_sample sample;
+  int *perm = NULL;
+  int ret = -1;
+  int i;
+
+  memset(&sample, 0, sizeof(row_sample));
+  sample.sheet = sheet;
+  sample.header_rows = libo_options_get_header_rows(l->options);
+  sample.k = k;
+  sample.state = seed;
+  sample.slot = -1;
+
+  sample.row = (libo_xl_row **)calloc(k ? k : 1, sizeof(libo_xl_row *));
+  sample.index = (int *)malloc(sizeof(int) * (k ? k : 1));
+  if (!sample.row || !sample.index) goto bail;
+
+  if (libo_xl_sheet_read_stream(l, sheet, n, 0, sample_select, &sample,
+                                sample_row_handler, &sample)) goto bail;
+
+    // rows sampled keep their order in work sheet
+
+  perm = (int *)malloc(sizeof(int) * (sample.n ? sample.n : 1));
+  if (!perm) goto bail;
+
+  for (i = 0; i < sample.n; i++)
+    perm[i] = i;
+
+  if (parallel_sort(perm, sample.n, int_rank_compare, sample.index)) goto bail;
+
+  for (i = 0; i < sample.n; i++)
+    if (store_row_handler(sample.row[perm[i]], sample.index[perm[i]], sheet)) goto bail;
+
+  sheet->dirty = 0;
+
+  ret = 0;
+
+bail:
+  if (sample.row)
+  {
+    for (i = 0; i < sample.n; i++)
+      libo_xl_row_free(sample.row[i]);
+  }
+  free(sample.row);
+  free(sample.index);
+  free(perm);
+
+  return ret;
+}
+
+  /**
+   *  @fn static int int_rank_compare(int a, int b, void *data)
+   *
+   *  @brief compares entries @p a and @p b of array of ints @p data
+   *
+   *  @param a - index of first entry
+   *  @param b - index of second entry
+   *  @param data - array of ints
+   *
+   *  @return negative, zero or positive as entry @p a is less than, equal
+   *          to or greater than entry @p b
+   */
+
+static int int_rank_compare(int a, int b, void *data)
+{
+  int *v = (int *)data;
+
+  return (v[a] > v[b]) - (v[a] < v[b]);
+}
+
+  /**
+   *  @fn static int range_select(int n, void *data)
+   *
+   *  @brief chooses rows within the @a row_range in @p data
+   *
+   *  @param n - index of row
+   *  @param data - pointer to @a row_range struct
+   *
+   *  @return 1 to build row, 0 to pass over it, -1 to stop reading
+   */
+
+static int range_select(int n, void *data)
+{
+  row_range *range = (row_range *)data;
+
+  if ((range->last >= 0) && (n >= range->last)) return -1;
+
+  return (n >= range->first) ? 1 : 0;
+}
+
+  /**
+   *  @fn static int sample_select(int n, void *data)
+   *
+   *  @brief chooses rows the reservoir of the @a row_sample in @p data
+   *         takes
+   *
+   *  Row @p n past the header rows replaces a random entry with chance
+   *  k / (n + 1), once the reservoir is full.
+   *
+   *  @param n - index of row
+   *  @param data - pointer to @a row_sample struct
+   *
+   *  @return 1 to build row, 0 to pass over it, -1 to stop reading
+   */
+
+static int sample_select(int n, void *data)
+{
+  row_sample *sample = (row_sample *)data;
+  uint64_t j;
+  int m;
+
+  sample->slot = -1;
+
+  if (n < sample->header_rows) return 1;
+  if (!sample->k) return -1;
+
+  m = n - sample->header_rows;
+
+  if (m < sample->k)
+  {
+    sample->slot = m;
+    return 1;
+  }
+
+  sample->state += 0x9e3779b97f4a7c15ULL;
+  j = hash_mix(sample->state) % (uint64_t)(m + 1);
+  if (j >= (uint64_t)sample->k) return 0;
+
+  sample->slot = (int)j;
+
+  return 1;
+}
+
+  /**
+   *  @fn static int sample_row_handler(libo_xl_row *row, int n, void *data)
+   *
+   *  @brief puts streamed @p row into the reservoir of the @a row_sample in
+   *         @p data, or straight into its sheet if it is a header row
+   *
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *  @param n - index of @p row in work sheet
+   *  @param data - pointer to @a row_sample struct
+   *
+   *  @return 0 to continue reading, -1 on failure
+   */
+
+static int sample_row_handler(libo_xl_row *row, int n, void *data)
+{
+  row_sample *sample = (row_sample *)data;
+  libo_xl_row *nrow;
+
+  if (sample->slot < 0) return store_row_handler(row, n, sample->sheet);
+
+  nrow = libo_xl_row_dup(row);
+  if (!nrow) return -1;
+
+  if (sample->slot < sample->n)
+    libo_xl_row_free(sample->row[sample->slot]);
+  else
+    ++sample->n;
+
+  sample->row[sample->slot] = nrow;
+  sample->index[sample->slot] = n;
+
+  return 0;
+}
+
+  /**
+   *  @fn static libo_xl_schema *schema_build(libo_xl *xl, libo_xl_row *row)
+   *
+   *  @brief builds a schema from the headings in @p row
+   *
+   *  @param xl - pointer to existing @a libo_xl struct holding shared strings
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *
+   *  @return pointer to new @a libo_xl_schema struct, NULL on failure
+   */
+
+static libo_xl_schema *schema_build(libo_xl *xl, libo_xl_row *row)
+{
+  libo_xl_schema *schema;
+  char buf[64];
+  char *name;
+  unsigned long i;
+  int c;
+
+  schema = (libo_xl_schema *)malloc(sizeof(libo_xl_schema));
+  if (!schema) return NULL;
+  memset(schema, 0, sizeof(libo_xl_schema));
+
+  schema->xl = xl;
+  schema->n_names = row->n_cells;
+
+    // slots stay at most half full
+
+  schema->size = 8;
+  while (schema->size < 2 * schema->n_names)
+    schema->size *= 2;
+
+  schema->name = (char **)calloc(schema->n_names ? schema->n_names : 1, sizeof(char *));
+  schema->slot = (int *)malloc(sizeof(int) * schema->size);
+  if (!schema->name || !schema->slot) goto bail;
+
+  for (i = 0; i < (unsigned long)schema->size; i++)
+    schema->slot[i] = -1;
+
+  for (c = 0; c < schema->n_names; c++)
+  {
+    name = schema_cell_name(xl, row->cell[c], buf);
+    if (!name || !*name) continue;
+
+    schema->name[c] = strdup(name);
+    if (!schema->name[c]) goto bail;
+
+    if (schema_find(schema, name) >= 0) continue;
+
+    i = hash_string(name) & (schema->size - 1);
+    while (schema->slot[i] >= 0)
+      i = (i + 1) & (schema->size - 1);
+    schema->slot[i] = c;
+  }
+
+  return schema;
+
+bail:
+  libo_xl_schema_free(schema);
+
+  return NULL;
+}
+
+  /**
+   *  @fn static char *schema_cell_name(libo_xl *xl,
+   *                                    libo_xl_cell *cell,
+   *                                    char *buf)
+   *
+   *  @brief returns heading held by @p cell
+   *
+   *  @param xl - pointer to existing @a libo_xl struct holding shared strings
+   *  @param cell - pointer to existing @a libo_xl_cell struct, or NULL
+   *  @param buf - buffer of at least 64 bytes a number is written in
+   *
+   *  @return heading, not to be freed, NULL if @p cell holds none
+   */
+
+static char *schema_cell_name(libo_xl *xl, libo_xl_cell *cell, char *buf)
+{
+  if (!cell) return NULL;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_reference:
+      return libo_xl_cell_get_text(xl, cell);
+    case libo_xl_cell_type_expression:
+      return cell->expression.value;
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      snprintf(buf, 64, "%.15g", cell->number);
+      return buf;
+    case libo_xl_cell_type_boolean:
+    case libo_xl_cell_type_error:
+      return (char *)libo_xl_cell_get_string_view(xl, cell, NULL);
+    default:
+      break;
+  }
+
+  return NULL;
+}
+
+  /**
+   *  @fn static int schema_find(libo_xl_schema *schema, char *name)
+   *
+   *  @brief finds column of @p schema headed @p name in its hash slots
+   *
+   *  @param schema - pointer to existing @a libo_xl_schema struct
+   *  @param name - heading of column
+   *
+   *  @return index of column, -1 if no column has heading @p name
+   */
+
+static int schema_find(libo_xl_schema *schema, char *name)
+{
+  unsigned long i;
+  int c;
+
+  i = hash_string(name) & (schema->size - 1);
+
+  while ((c = schema->slot[i]) >= 0)
+  {
+    if (!strcmp(schema->name[c], name)) return c;
+    i = (i + 1) & (schema->size - 1);
+  }
+
+  return -1;
+}
+
+  /**
+   *  @fn static int record_row_handler(libo_xl_row *row, int n, void *data)
+   *
+   *  @brief builds schema of the @a record_stream in @p data from its
+   *         header row, and passes each later row to its handler as a record
+   *
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *  @param n - index of @p row in work sheet
+   *  @param data - pointer to @a record_stream struct
+   *
+   *  @return 0 to continue reading, non-zero to stop
+   */
+
+static int record_row_handler(libo_xl_row *row, int n, void *data)
+{
+  record_stream *rs = (record_stream *)data;
+  libo_xl_record rec;
+
+  if (n < rs->header_row) return 0;
+
+  if (n == rs->header_row)
+  {
+    rs->schema = schema_build(rs->xl, row);
+    if (!rs->schema) rs->failed = 1;
+    return rs->failed;
+  }
+
+  if (!rs->schema) return 0;
+
+  rec.schema = rs->schema;
+  rec.row = row;
+  rec.n = n;
+
+  return rs->handler(&rec, rs->data) ? 1 : 0;
+}
+
+  /**
+   *  @fn static void bind_value(char *rec,
+   *                             libo_xl_field *field,
+   *                             int n_fields,
+   *                             int col,
+   *                             char *t,
+   *                             char *v,
+   *                             strings *strings)
+   *
+   *  @brief parses raw value @p v of a cell of column @p col into each
+   *         field of struct @p rec that reads the column
+   *
+   *  Integer fields take whole numbers exactly, and other numbers cut
+   *  toward zero.  Values out of range of the field are skipped, leaving
+   *  it as it was.
+   *
+   *  @param rec - struct being filled
+   *  @param field - array of fields of struct
+   *  @param n_fields - number of entries of @p field
+   *  @param col - index of column of cell
+   *  @param t - type attribute of cell, empty if none
+   *  @param v - value element of cell
+   *  @param strings - shared strings of workbook, or NULL
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void bind_value(char *rec,
+                       libo_xl_field *field,
+                       int n_fields,
+                       int col,
+                       char *t,
+                       char *v,
+                       strings *strings)
+{
+  string *str;
+  char *end;
+  double d;
+  int64_t i64 = 0;
+  int whole = 0;
+  int shared;
+  int i;
+
+  shared = !strcmp(t, "s");
+
+    // numbers are numbers, booleans and results of formulas that are
+    // numbers, never texts or errors
+
+  if (!shared && strcmp(t, "inlineStr") && strcmp(t, "e"))
+  {
+    d = strtod(v, &end);
+    if ((end == v) || *end) shared = -1;
+    else
+      whole = bind_integer(v, d, &i64);
+  }
+  else
+    d = 0;
+
+  for (i = 0; i < n_fields; i++)
+  {
+    if (field[i].col != col) continue;
+
+    switch (field[i].type)
+    {
+      case libo_xl_field_double:
+        if (!shared) memcpy(rec + field[i].offset, &d, sizeof(double));
+        break;
+      case libo_xl_field_int64:
+        if (shared || !whole) break;
+        memcpy(rec + field[i].offset, &i64, sizeof(int64_t));
+        break;
+      case libo_xl_field_int:
+        if (shared || !whole || (i64 < INT_MIN) || (i64 > INT_MAX)) break;
+        *(int *)(rec + field[i].offset) = (int)i64;
+        break;
+      case libo_xl_field_text:
+        if (shared != 1 || !strings) break;
+        str = strings_find_by_id(strings, atoi(v));
+        if (str) *(char **)(rec + field[i].offset) = str->text;
+        break;
+      case libo_xl_field_string_id:
+        if (shared == 1) *(int *)(rec + field[i].offset) = atoi(v);
+        break;
+    }
+  }
+}
+
+  /**
+   *  @fn static int bind_integer(char *v, double d, int64_t *i64)
+   *
+   *  @brief parses raw value @p v of a cell, read as @p d, into a 64 bit
+   *         integer
+   *
+   *  Digits are read exactly, as a double holds integers only up to 2^53.
+   *  Other numbers are cut toward zero.
+   *
+   *  @param v - value element of cell
+   *  @param d - @p v read as a number
+   *  @param i64 - receives integer
+   *
+   *  @return 1 on success, 0 if out of range of a 64 bit integer
+   */
+
+static int bind_integer(char *v, double d, int64_t *i64)
+{
+  long long ll;
+  char *end;
+
+  errno = 0;
+  ll = strtoll(v, &end, 10);
+  if ((end != v) && !*end)
+  {
+    if (errno == ERANGE) return 0;
+    *i64 = (int64_t)ll;
+    return 1;
+  }
+
+    // -2^63 and 2^63 are exact as doubles, and NaN fails both tests
+
+  if (!(d >= -9223372036854775808.0) || !(d < 9223372036854775808.0)) return 0;
+
+  *i64 = (int64_t)d;
+
+  return 1;
+}
+
+  /**
+   *  @fn static int sheet_append_matrix(libo_xl_sheet *sheet,
+   *                                     libo_xl_field_type type,
+   *                                     const void *data,
+   *                                     int rows,
+   *                                     int cols,
+   *                                     size_t stride)
+   *
+   *  @brief appends a row major matrix of @p type to @p sheet
+   *
+   *  Stored sheets pack each row straight from one block of cells that is
+   *  refilled for every row.  Sheets in memory grow their rows once, and
+   *  take cells built in place rather than copies.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param type - @a libo_xl_field_double, @a libo_xl_field_int64 or
+   *                @a libo_xl_field_string_id
+   *  @param data - @p rows rows of @p cols values
+   *  @param rows - number of rows in @p data
+   *  @param cols - number of columns in @p data
+   *  @param stride - elements from the start of one row to the next, 0 if
+   *                  rows are packed
+   *
+   *  @return 0 on success, -1 on error
+   */
+
+static int sheet_append_matrix(libo_xl_sheet *sheet,
+                               libo_xl_field_type type,
+                               const void *data,
+                               int rows,
+                               int cols,
+                               size_t stride)
+{
+  libo_xl_row row;
+  libo_xl_row *nrow;
+  libo_xl_row **tmp;
+  libo_xl_cell *cells = NULL;
+  libo_xl_cell **cell = NULL;
+  int i, j;
+  int rc = -1;
+
+  if (!sheet || !data) return -1;
+  if (rows < 0 || cols < 1) return -1;
+  if (!rows) return 0;
+
+  if (!stride) stride = cols;
+  if (stride < (size_t)cols) return -1;
+
+  if (sheet->store)
+  {
+    cells = (libo_xl_cell *)malloc(sizeof(libo_xl_cell) * cols);
+    cell = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * cols);
+    if (!cells || !cell) goto bail;
+
+    for (j = 0; j < cols; j++)
+      cell[j] = &cells[j];
+
+    row.n_cells = cols;
+    row.cell = cell;
+
+    for (i = 0; i < rows; i++)
+    {
+      for (j = 0; j < cols; j++)
+        matrix_cell_set(&cells[j], type, data, i * stride + j);
+
+      if (libo_xl_store_append(sheet->store, &row)) goto bail;
+
+      ++sheet->n_rows;
+    }
+  }
+  else
+  {
+    tmp = realloc(sheet->row, sizeof(libo_xl_row *) * (sheet->n_rows + rows));
+    if (!tmp) return -1;
+
+    sheet->row = tmp;
+
+    for (i = 0; i < rows; i++)
+    {
+      nrow = libo_xl_row_new();
+      if (!nrow) goto bail;
+
+      nrow->cell = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * cols);
+      if (!nrow->cell)
+      {
+        free(nrow);
+        goto bail;
+      }
+
+      for (j = 0; j < cols; j++)
+      {
+        nrow->cell[j] = (libo_xl_cell *)malloc(sizeof(libo_xl_cell));
+        if (!nrow->cell[j]) break;
+
+        matrix_cell_set(nrow->cell[j], type, data, i * stride + j);
+      }
+
+      nrow->n_cells = j;
+      sheet->row[sheet->n_rows++] = nrow;
+
+      if (j < cols) goto bail;
+    }
+  }
+
+  rc = 0;
+
+bail:
+  if (cols > sheet->n_cols) sheet->n_cols = cols;
+
+  ++sheet->version;
+  sheet->dirty = 1;
+
+  if (cell) free(cell);
+  if (cells) free(cells);
+
+  return rc;
+}
+
+  /**
+   *  @fn static int matrix_check(libo_xl *xl,
+   *                              libo_xl_field_type type,
+   *                              const void *data,
+   *                              int rows,
+   *                              int cols,
+   *                              size_t stride)
+   *
+   *  @brief tests that each element of a row major matrix of @p type can
+   *         be held by a cell
+   *
+   *  Integers must be within +/-2^53, and string ids in the dictionary of
+   *  @p xl.  Shapes are left to @a sheet_append_matrix.
+   *
+   *  @param xl - pointer to existing @a libo_xl, for string ids
+   *  @param type - @a libo_xl_field_int64 or @a libo_xl_field_string_id
+   *  @param data - @p rows rows of @p cols values
+   *  @param rows - number of rows in @p data
+   *  @param cols - number of columns in @p data
+   *  @param stride - elements from the start of one row to the next, 0 if
+   *                  rows are packed
+   *
+   *  @return 0 if every element can be held, -1 otherwise
+   */
+
+static int matrix_check(libo_xl *xl,
+                        libo_xl_field_type type,
+                        const void *data,
+                        int rows,
+                        int cols,
+                        size_t stride)
+{
+  const int64_t *i64 = (const int64_t *)data;
+  const int *id = (const int *)data;
+  size_t k;
+  int i, j;
+
+  if (!data || (rows < 1) || (cols < 1)) return 0;
+
+  if (!stride) stride = cols;
+  if (stride < (size_t)cols) return 0;
+
+  for (i = 0; i < rows; i++)
+  {
+    for (j = 0; j < cols; j++)
+    {
+      k = (size_t)i * stride + j;
+
+      if (type == libo_xl_field_int64)
+      {
+        if ((i64[k] > XL_EXACT_MAX) || (i64[k] < -XL_EXACT_MAX)) return -1;
+      }
+      else if (type == libo_xl_field_string_id)
+      {
+          // repeats of an id along a row are looked up once
+
+        if (j && (id[k] == id[k - 1])) continue;
+        if ((id[k] < 0) || !strings_find_by_id(xl->strings, id[k])) return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static void matrix_cell_set(libo_xl_cell *cell,
+   *                                  libo_xl_field_type type,
+   *                                  const void *data,
+   *                                  size_t i)
+   *
+   *  @brief sets @p cell to element @p i of @p data
+   *
+   *  @param cell - pointer to cell to set
+   *  @param type - type of elements of @p data
+   *  @param data - array of values
+   *  @param i - index of element in @p data
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void matrix_cell_set(libo_xl_cell *cell,
+                            libo_xl_field_type type,
+                            const void *data,
+                            size_t i)
+{
+  memset(cell, 0, sizeof(libo_xl_cell));
+
+  switch (type)
+  {
+    case libo_xl_field_int64:
+      cell->type = libo_xl_cell_type_number;
+      cell->number = (double)((const int64_t *)data)[i];
+      break;
+
+    case libo_xl_field_string_id:
+      cell->type = libo_xl_cell_type_reference;
+      cell->reference = ((const int *)data)[i];
+      break;
+
+    default:
+      cell->type = libo_xl_cell_type_number;
+      cell->number = ((const double *)data)[i];
+      break;
+  }
+}
+
+  /**
+   *  @fn static int format_integer(long long x, char *s)
+   *
+   *  @brief writes @p x in decimal to @p s
+   *
+   *  @param x - integer to write
+   *  @param s - buffer of at least 21 bytes
+   *
+   *  @return number of characters written, not counting the terminator
+   */
+
+static int format_integer(long long x, char *s)
+{
+  char digits[20];
+  unsigned long long u;
+  int n = 0;
+  int len = 0;
+
+  u = x < 0 ? 0ULL - (unsigned long long)x : (unsigned long long)x;
+
+  do
+  {
+    digits[n++] = '0' + (char)(u % 10);
+    u /= 10;
+  } while (u);
+
+  if (x < 0) s[len++] = '-';
+  while (n) s[len++] = digits[--n];
+  s[len] = 0;
+
+  return len;
+}
+
+  /**
+   *  @fn static size_t format_numbers(const double *v,
+   *                                   int n,
+   *                                   char *text,
+   *                                   size_t *start)
+   *
+   *  @brief formats @p n numbers as @a libo_xl_cell_format_number would,
+   *         one after another into @p text
+   *
+   *  Small whole numbers, which are most of a numeric column, are written
+   *  by @a format_integer, and the rest by snprintf with the fewest digits
+   *  that read back the same.
+   *
+   *  @param v - numbers to format
+   *  @param n - number of numbers
+   *  @param text - buffer of @p n times @a LIBO_XL_NUMBER_SIZE bytes
+   *  @param start - receives offset in @p text of each formatted number
+   *
+   *  @return number of bytes of @p text used
+   */
+
+static size_t format_numbers(const double *v, int n, char *text, size_t *start)
+{
+  size_t used = 0;
+  int i, len;
+
+  for (i = 0; i < n; i++)
+  {
+    start[i] = used;
+
+    if (v[i] > -1e6 && v[i] < 1e6 && v[i] == (double)(long long)v[i] &&
+        (v[i] != 0 || !signbit(v[i])))
+      len = format_integer((long long)v[i], text + used);
+    else
+    {
+      len = snprintf(text + used, LIBO_XL_NUMBER_SIZE, "%.15g", v[i]);
+      if (strtod(text + used, NULL) != v[i])
+        len = snprintf(text + used, LIBO_XL_NUMBER_SIZE, "%.17g", v[i]);
+    }
+
+    used += len + 1;
+  }
+
+  return used;
+}
+
+  /**
+   *  @fn static int number_batch_fill(number_batch *batch,
+   *                                   libo_xl_sheet *sheet,
+   *                                   int first)
+   *
+   *  @brief formats numbers of the rows of @p sheet from @p first on, a
+   *         column at a time
+   *
+   *  @param batch - pointer to batch to fill
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param first - first row to format
+   *
+   *  @return 0 on success, -1 on error
+   */
+
+static int number_batch_fill(number_batch *batch, libo_xl_sheet *sheet, int first)
+{
+  libo_xl_cell *cell;
+  size_t used = 0;
+  size_t len;
+  void *tmp;
+  int rows, cols;
+  int r, c, n, k;
+
+  cols = sheet->n_cols ? sheet->n_cols : 1;
+  rows = LIBO_XL_FORMAT_CELLS / cols;
+  if (rows < 1) rows = 1;
+  if (rows > sheet->n_rows - first) rows = sheet->n_rows - first;
+
+  batch->first = first;
+  batch->n_rows = rows;
+  batch->n_cols = cols;
+
+  if (rows > batch->size_rows || cols > batch->size_cols)
+  {
+    if (rows > batch->size_rows) batch->size_rows = rows;
+    if (cols > batch->size_cols) batch->size_cols = cols;
+
+    if (!(tmp = realloc(batch->number, sizeof(double) * batch->size_rows))) goto bail;
+    batch->number = (double *)tmp;
+    if (!(tmp = realloc(batch->at, sizeof(int) * batch->size_rows))) goto bail;
+    batch->at = (int *)tmp;
+    if (!(tmp = realloc(batch->start, sizeof(size_t) * batch->size_rows))) goto bail;
+    batch->start = (size_t *)tmp;
+    tmp = realloc(batch->offset, sizeof(size_t) * batch->size_rows * batch->size_cols);
+    if (!tmp) goto bail;
+    batch->offset = (size_t *)tmp;
+    tmp = realloc(batch->text, (size_t)LIBO_XL_NUMBER_SIZE * batch->size_rows * batch->size_cols);
+    if (!tmp) goto bail;
+    batch->text = (char *)tmp;
+  }
+
+  for (c = 0; c < cols; c++)
+  {
+    for (r = n = 0; r < rows; r++)
+    {
+      cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, first + r), c);
+
+      batch->offset[r * cols + c] = (size_t)-1;
+      if (!cell_is_number(cell)) continue;
+
+      batch->number[n] = cell->number;
+      batch->at[n++] = r;
+    }
+
+    len = format_numbers(batch->number, n, batch->text + used, batch->start);
+
+    for (k = 0; k < n; k++)
+      batch->offset[batch->at[k] * cols + c] = used + batch->start[k];
+
+    used += len;
+  }
+
+  return 0;
+
+bail:
+  number_batch_clear(batch);
+  batch->first = first;
+  batch->n_rows = rows;
+
+  return -1;
+}
+
+  /**
+   *  @fn static char *number_batch_get(number_batch *batch, int row, int col)
+   *
+   *  @brief returns number of cell at @p row and @p col formatted by
+   *         @a number_batch_fill
+   *
+   *  @param batch - pointer to filled batch, or NULL
+   *  @param row - index of row in sheet
+   *  @param col - index of column in row
+   *
+   *  @return formatted number, NULL if cell is not a number of the batch
+   */
+
+static char *number_batch_get(number_batch *batch, int row, int col)
+{
+  size_t offset;
+
+  if (!batch) return NULL;
+  if (row < batch->first || row >= batch->first + batch->n_rows) return NULL;
+  if (col < 0 || col >= batch->n_cols) return NULL;
+
+  offset = batch->offset[(row - batch->first) * batch->n_cols + col];
+  if (offset == (size_t)-1) return NULL;
+
+  return batch->text + offset;
+}
+
+  /**
+   *  @fn static void number_batch_clear(number_batch *batch)
+   *
+   *  @brief frees memory held by @p batch
+   *
+   *  @param batch - pointer to batch
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void number_batch_clear(number_batch *batch)
+{
+  if (batch->number) free(batch->number);
+  if (batch->at) free(batch->at);
+  if (batch->start) free(batch->start);
+  if (batch->offset) free(batch->offset);
+  if (batch->text) free(batch->text);
+
+  memset(batch, 0, sizeof(number_batch));
+}
+
+  /**
+   *  @fn static int formula_runs_init(formula_runs *runs, libo_xl_sheet *sheet)
+   *
+   *  @brief sets up @p runs for writing cells of @p sheet
+   *
+   *  @param runs - pointer to @a formula_runs struct to fill
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int formula_runs_init(formula_runs *runs, libo_xl_sheet *sheet)
+{
+  memset(runs, 0, sizeof(formula_runs));
+
+  if (!sheet || (sheet->n_cols <= 0)) return -1;
+
+  runs->end = (int *)calloc(sheet->n_cols, sizeof(int));
+  runs->si = (int *)calloc(sheet->n_cols, sizeof(int));
+  if (!runs->end || !runs->si)
+  {
+    formula_runs_clear(runs);
+    return -1;
+  }
+
+  runs->n_cols = sheet->n_cols;
+
+  return 0;
+}
+
+  /**
+   *  @fn static void formula_runs_add(formula_runs *runs,
+   *                                   libo_xl_sheet *sheet,
+   *                                   libo_xl_cell *cell,
+   *                                   int row,
+   *                                   int col,
+   *                                   char **buf)
+   *
+   *  @brief adds formula of @p cell, at @p row and @p col of @p sheet, to
+   *         XML buffer
+   *
+   *  Cells below @p cell holding the same formula relative to their own
+   *  positions are written as one shared formula, given in full only in
+   *  the first, and named by the rest.
+   *
+   *  @param runs - runs of shared formulas being written, or NULL to write
+   *                each formula in full
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param cell - pointer to existing @a libo_xl_cell, which may be
+   *                dropped from the cache of a stored sheet by this call
+   *  @param row - index of row of @p cell
+   *  @param col - index of column of @p cell
+   *  @param buf - pointer to string holding XML buffer
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void formula_runs_add(formula_runs *runs,
+                             libo_xl_sheet *sheet,
+                             libo_xl_cell *cell,
+                             int row,
+                             int col,
+                             char **buf)
+{
+  libo_xl_cell *next;
+  xmlChar *encoded;
+  char *text;
+  char *r1c1 = NULL;
+  char *other;
+  char number[16];
+  char ref[48];
+  size_t len;
+  int shared;
+  int same;
+  int end;
+
+  if (!cell_has_formula(cell)) return;
+
+    // cells inside a run only name it
+
+  if (runs && (col < runs->n_cols) && (row < runs->end[col]))
+  {
+    sprintf(number, "%d", runs->si[col]);
+    *buf = strapp(*buf, "<f t=\"shared\" si=\"");
+    *buf = strapp(*buf, number);
+    *buf = strapp(*buf, "\"/>\n");
+    return;
+  }
+
+  len = libo_xl_sheet_format_formula(sheet, row, col, NULL, 0);
+  text = (char *)malloc(len + 1);
+  if (!text) return;
+  libo_xl_sheet_format_formula(sheet, row, col, text, len + 1);
+
+  if (runs && (col < runs->n_cols)) r1c1 = cell_formula_r1c1(sheet, cell, row, col);
+
+    // cells of one shared formula need no conversion to compare
+
+  shared = cell->shared;
+  if (r1c1 && shared && ((shared > sheet->n_shared) || strcmp(r1c1, sheet->shared[shared - 1])))
+    shared = 0;
+
+  for (end = row + 1; r1c1 && (end < sheet->n_rows); end++)
+  {
+    next = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, end), col);
+    if (!cell_has_formula(next)) break;
+    if (shared && (next->shared == shared) && !next->expression.formula) continue;
+
+    other = cell_formula_r1c1(sheet, next, end, col);
+    same = other && !strcmp(other, r1c1);
+    free(other);
+    if (!same) break;
+  }
+  free(r1c1);
+
+  if (end - row > 1)
+  {
+    runs->end[col] = end;
+    runs->si[col] = runs->n_groups++;
+
+    len = formula_column_format(col, ref);
+    len += sprintf(ref + len, "%d:", row + 1);
+    len += formula_column_format(col, ref + len);
+    sprintf(ref + len, "%d", end);
+    sprintf(number, "%d", runs->si[col]);
+
+    *buf = strapp(*buf, "<f t=\"shared\" ref=\"");
+    *buf = strapp(*buf, ref);
+    *buf = strapp(*buf, "\" si=\"");
+    *buf = strapp(*buf, number);
+    *buf = strapp(*buf, "\">");
+  }
+  else
+    *buf = strapp(*buf, "<f>");
+
+  encoded = xmlEncodeSpecialChars(NULL, (xmlChar *)text);
+  if (encoded) *buf = strapp(*buf, (char *)encoded);
+  *buf = strapp(*buf, "</f>\n");
+  xmlFree(encoded);
+
+  free(text);
+}
+
+  /**
+   *  @fn static void formula_runs_clear(formula_runs *runs)
+   *
+   *  @brief frees memory held by @p runs
+   *
+   *  @param runs - pointer to existing @a formula_runs struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void formula_runs_clear(formula_runs *runs)
+{
+  if (runs->end) free(runs->end);
+  if (runs->si) free(runs->si);
+
+  memset(runs, 0, sizeof(formula_runs));
+}
+
+  /**
+   *  @fn static const char *expression_value_type(const char *value)
+   *
+   *  @brief returns type attribute a cell is written with for the value
+   *         of its expression
+   *
+   *  @param value - value of expression, or NULL
+   *
+   *  @return attribute with leading space, "" for numbers
+   */
+
+static const char *expression_value_type(const char *value)
+{
+  char *end;
+  int i;
+
+  if (value && *value && !isspace((unsigned char)*value))
+  {
+    strtod(value, &end);
+    if (!*end) return "";
+  }
+
+  if (value && !strcmp(value, "TRUE")) return " t=\"b\"";
+  if (value && !strcmp(value, "FALSE")) return " t=\"b\"";
+
+  for (i = 1; value && (i <= calc_error_na); i++)
+    if (!strcmp(value, _calc_errors[i])) return " t=\"e\"";
+
+  return " t=\"str\"";
+}
+
+  /**
+   *  @fn static uint64_t calc_key(int sheet, int row, int col)
+   *
+   *  @brief returns key of the cell at @p row and @p col of @p sheet
+   *
+   *  @param sheet - index of sheet in book
+   *  @param row - index of row
+   *  @param col - index of column
+   *
+   *  @return key of cell
+   */
+
+static uint64_t calc_key(int sheet, int row, int col)
+{
+  return ((uint64_t)sheet << 40) | ((uint64_t)row << 14) | (uint64_t)col;
+}
+
+  /**
+   *  @fn static int calc_find(libo_xl_calc *calc, uint64_t key)
+   *
+   *  @brief returns node of the formula in cell @p key
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param key - key of cell, see @a calc_key
+   *
+   *  @return index of node, -1 if cell holds no formula known to @p calc
+   */
+
+static int calc_find(libo_xl_calc *calc, uint64_t key)
+{
+  int i;
+
+  if (!calc->n_slots) return -1;
+
+  for (i = hash_mix(key) & (calc->n_slots - 1);
+       calc->slot[i].node >= 0;
+       i = (i + 1) & (calc->n_slots - 1))
+  {
+    if (calc->slot[i].key == key) return calc->slot[i].node;
+  }
+
+  return -1;
+}
+
+  /**
+   *  @fn static int calc_node_get(libo_xl_calc *calc, int sheet, int row, int col)
+   *
+   *  @brief returns node for the cell at @p row and @p col of @p sheet,
+   *         adding one if there is none
+   *
+   *  Nodes are never removed, a cell losing its formula keeps a node
+   *  without code.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - index of sheet in book
+   *  @param row - index of row
+   *  @param col - index of column
+   *
+   *  @return index of node, -1 on failure
+   */
+
+static int calc_node_get(libo_xl_calc *calc, int sheet, int row, int col)
+{
+  calc_slot *slot;
+  calc_node *node;
+  uint64_t key;
+  void *tmp;
+  int n_slots;
+  int i, j, n;
+
+  key = calc_key(sheet, row, col);
+
+  n = calc_find(calc, key);
+  if (n >= 0) return n;
+
+    // the table is kept at most half full
+
+  if (2 * (calc->n_nodes + 1) > calc->n_slots)
+  {
+    n_slots = calc->n_slots ? 2 * calc->n_slots : 64;
+
+    slot = (calc_slot *)malloc(sizeof(calc_slot) * n_slots);
+    if (!slot) return -1;
+
+    for (i = 0; i < n_slots; i++)
+      slot[i].node = -1;
+
+    for (i = 0; i < calc->n_nodes; i++)
+    {
+      node = &calc->node[i];
+      key = calc_key(node->sheet, node->row, node->col);
+      for (j = hash_mix(key) & (n_slots - 1); slot[j].node >= 0; j = (j + 1) & (n_slots - 1));
+      slot[j].key = key;
+      slot[j].node = i;
+    }
+
+    free(calc->slot);
+    calc->slot = slot;
+    calc->n_slots = n_slots;
+
+    key = calc_key(sheet, row, col);
+  }
+
+  if (calc->n_nodes == calc->size_nodes)
+  {
+    n = calc->size_nodes ? 2 * calc->size_nodes : 64;
+
+    tmp = realloc(calc->node, sizeof(calc_node) * n);
+    if (!tmp) return -1;
+    calc->node = (calc_node *)tmp;
+
+    tmp = realloc(calc->dirty, sizeof(int) * n);
+    if (!tmp) return -1;
+    calc->dirty = (int *)tmp;
+
+    tmp = realloc(calc->queue, sizeof(int) * n);
+    if (!tmp) return -1;
+    calc->queue = (int *)tmp;
+
+    calc->size_nodes = n;
+  }
+
+  n = calc->n_nodes++;
+  node = &calc->node[n];
+  memset(node, 0, sizeof(calc_node));
+  node->sheet = sheet;
+  node->row = row;
+  node->col = col;
+
+  for (j = hash_mix(key) & (calc->n_slots - 1);
+       calc->slot[j].node >= 0;
+       j = (j + 1) & (calc->n_slots - 1));
+  calc->slot[j].key = key;
+  calc->slot[j].node = n;
+
+  return n;
+}
+
+  /**
+   *  @fn static calc_column *calc_column_get(libo_xl_calc *calc, int sheet, int col)
+   *
+   *  @brief returns what @p calc knows of column @p col of @p sheet
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - index of sheet in book
+   *  @param col - index of column
+   *
+   *  @return pointer to @a calc_column, NULL on failure
+   */
+
+static calc_column *calc_column_get(libo_xl_calc *calc, int sheet, int col)
+{
+  calc_sheet *cs;
+  calc_column *tmp;
+  int n;
+
+  if (sheet < 0 || sheet >= calc->n_sheets) return NULL;
+  if (col < 0 || col >= LIBO_XL_CALC_COLS) return NULL;
+
+  cs = &calc->sheet[sheet];
+
+  if (col >= cs->n_cols)
+  {
+    n = cs->n_cols ? cs->n_cols : 16;
+    while (n <= col) n *= 2;
+    if (n > LIBO_XL_CALC_COLS) n = LIBO_XL_CALC_COLS;
+
+    tmp = (calc_column *)realloc(cs->col, sizeof(calc_column) * n);
+    if (!tmp) return NULL;
+
+    memset(tmp + cs->n_cols, 0, sizeof(calc_column) * (n - cs->n_cols));
+    cs->col = tmp;
+    cs->n_cols = n;
+  }
+
+  return &cs->col[col];
+}
+
+  /**
+   *  @fn static int calc_column_is_plain(libo_xl_calc *calc, int sheet, int col)
+   *
+   *  @brief tells whether column @p col of @p sheet holds only numbers,
+   *         shared strings and empty cells, so indexes and column kernels
+   *         see every value of it
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - index of sheet in book
+   *  @param col - index of column
+   *
+   *  @return 1 if column is plain, 0 if not
+   */
+
+static int calc_column_is_plain(libo_xl_calc *calc, int sheet, int col)
+{
+  calc_column *column;
+
+  if (sheet < 0 || sheet >= calc->n_sheets) return 0;
+  if (col >= calc->sheet[sheet].n_cols) return 1;
+
+  column = &calc->sheet[sheet].col[col];
+
+  return !column->n_nodes && !column->n_values;
+}
+
+  /**
+   *  @fn static libo_xl_sheet *calc_sheet_get(libo_xl_calc *calc, int sheet)
+   *
+   *  @brief returns work sheet @p sheet, restoring its rows if evicted
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - index of sheet in book
+   *
+   *  @return pointer to @a libo_xl_sheet, NULL if there is none
+   */
+
+static libo_xl_sheet *calc_sheet_get(libo_xl_calc *calc, int sheet)
+{
+  if (sheet < 0 || sheet >= calc->n_sheets) return NULL;
+
+  return libo_xl_book_get_sheet(calc->xl->book, sheet);
+}
+
+  /**
+   *  @fn static int calc_edge_add(libo_xl_calc *calc, uint64_t key, int node)
+   *
+   *  @brief records that @p node reads cell @p key
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param key - key of cell read
+   *  @param node - index of node reading it
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int calc_edge_add(libo_xl_calc *calc, uint64_t key, int node)
+{
+  calc_edge *tmp;
+  int *head;
+  int n_heads;
+  int i, e, next;
+
+  if (calc->free_edge < 0 && calc->n_edges == calc->size_edges)
+  {
+    i = calc->size_edges ? 2 * calc->size_edges : 64;
+
+    tmp = (calc_edge *)realloc(calc->edge, sizeof(calc_edge) * i);
+    if (!tmp) return -1;
+
+    calc->edge = tmp;
+    calc->size_edges = i;
+  }
+
+    // chains are rehashed as they grow longer than one edge on average
+
+  if (calc->n_edges + 1 > calc->n_heads)
+  {
+    n_heads = calc->n_heads ? 2 * calc->n_heads : 64;
+
+    head = (int *)malloc(sizeof(int) * n_heads);
+    if (!head) return -1;
+
+    for (i = 0; i < n_heads; i++)
+      head[i] = -1;
+
+    for (i = 0; i < calc->n_heads; i++)
+    {
+      for (e = calc->head[i]; e >= 0; e = next)
+      {
+        next = calc->edge[e].next;
+        calc->edge[e].next = head[hash_mix(calc->edge[e].key) & (n_heads - 1)];
+        head[hash_mix(calc->edge[e].key) & (n_heads - 1)] = e;
+      }
+    }
+
+    free(calc->head);
+    calc->head = head;
+    calc->n_heads = n_heads;
+  }
+
+  if (calc->free_edge >= 0)
+  {
+    e = calc->free_edge;
+    calc->free_edge = calc->edge[e].next;
+  }
+  else
+    e = calc->n_edges;
+
+  ++calc->n_edges;
+
+  i = hash_mix(key) & (calc->n_heads - 1);
+  calc->edge[e].key = key;
+  calc->edge[e].node = node;
+  calc->edge[e].next = calc->head[i];
+  calc->head[i] = e;
+
+  return 0;
+}
+
+  /**
+   *  @fn static void calc_edge_remove(libo_xl_calc *calc, uint64_t key, int node)
+   *
+   *  @brief forgets one record that @p node reads cell @p key
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param key - key of cell read
+   *  @param node - index of node reading it
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_edge_remove(libo_xl_calc *calc, uint64_t key, int node)
+{
+  int *link;
+  int e;
+
+  if (!calc->n_heads) return;
+
+  for (link = &calc->head[hash_mix(key) & (calc->n_heads - 1)]; *link >= 0; link = &calc->edge[*link].next)
+  {
+    e = *link;
+    if (calc->edge[e].key != key || calc->edge[e].node != node) continue;
+
+    *link = calc->edge[e].next;
+    calc->edge[e].next = calc->free_edge;
+    calc->free_edge = e;
+    --calc->n_edges;
+    return;
+  }
+}
+
+  /**
+   *  @fn static int calc_dep_add(libo_xl_calc *calc, calc_area *area, int node)
+   *
+   *  @brief records that @p node reads the cells of @p area, listing it
+   *         under each column of @p area
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param area - cells read
+   *  @param node - index of node reading them
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int calc_dep_add(libo_xl_calc *calc, calc_area *area, int node)
+{
+  calc_column *column;
+  calc_dep *tmp;
+  int *ntmp;
+  int d, c, n;
+
+  for (d = 0; d < calc->n_deps; d++)
+    if (calc->dep[d].node < 0) break;
+
+  if (d == calc->n_deps)
+  {
+    tmp = (calc_dep *)realloc(calc->dep, sizeof(calc_dep) * (calc->n_deps + 1));
+    if (!tmp) return -1;
+
+    calc->dep = tmp;
+    ++calc->n_deps;
+  }
+
+  calc->dep[d].area = *area;
+  calc->dep[d].node = node;
+
+  for (c = area->c1; c <= area->c2; c++)
+  {
+    column = calc_column_get(calc, area->sheet, c);
+    if (!column) return -1;
+
+    if (column->n_deps == column->size_deps)
+    {
+      n = column->size_deps ? 2 * column->size_deps : 4;
+      ntmp = (int *)realloc(column->dep, sizeof(int) * n);
+      if (!ntmp) return -1;
+
+      column->dep = ntmp;
+      column->size_deps = n;
+    }
+
+    column->dep[column->n_deps++] = d;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static size_t calc_instr_size(const unsigned char *ip)
+   *
+   *  @brief returns bytes of the instruction at @p ip, with its operands
+   *
+   *  @param ip - pointer to instruction
+   *
+   *  @return bytes of instruction
+   */
+
+static size_t calc_instr_size(const unsigned char *ip)
+{
+  int len;
+
+  switch ((calc_op)*ip)
+  {
+    case calc_op_number: return 1 + sizeof(double);
+    case calc_op_text:
+      memcpy(&len, ip + 1, sizeof(int));
+      return 1 + sizeof(int) + len;
+    case calc_op_bool: return 2;
+    case calc_op_error: return 2;
+    case calc_op_cell: return 1 + 3 * sizeof(int);
+    case calc_op_range: return 1 + 5 * sizeof(int);
+    case calc_op_call: return 3;
+    default: return 1;
+  }
+}
+
+  /**
+   *  @fn static int calc_node_link(libo_xl_calc *calc, int n, int link)
+   *
+   *  @brief records, or with @p link 0 forgets, the cells read by the code
+   *         of node @p n
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param n - index of node
+   *  @param link - 1 to record, 0 to forget
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int calc_node_link(libo_xl_calc *calc, int n, int link)
+{
+  calc_node *node;
+  calc_column *column;
+  calc_area area;
+  const unsigned char *ip;
+  int cell[3];
+  int d, c, i;
+
+  node = &calc->node[n];
+  if (!node->code) return 0;
+
+  for (ip = node->code; ip < node->code + node->n_code; ip += calc_instr_size(ip))
+  {
+    if (*ip == calc_op_cell)
+    {
+      memcpy(cell, ip + 1, sizeof(cell));
+
+      if (link)
+      {
+        if (calc_edge_add(calc, calc_key(cell[0], cell[1], cell[2]), n)) return -1;
+      }
+      else
+        calc_edge_remove(calc, calc_key(cell[0], cell[1], cell[2]), n);
+    }
+    else if (*ip == calc_op_range && link)
+    {
+      memcpy(&area, ip + 1, sizeof(calc_area));
+      if (calc_dep_add(calc, &area, n)) return -1;
+    }
+  }
+
+  if (link) return 0;
+
+    // ranges of node are dropped from the columns listing them
+
+  for (d = 0; d < calc->n_deps; d++)
+  {
+    if (calc->dep[d].node != n) continue;
+
+    for (c = calc->dep[d].area.c1; c <= calc->dep[d].area.c2; c++)
+    {
+      column = calc_column_get(calc, calc->dep[d].area.sheet, c);
+      if (!column) continue;
+
+      for (i = 0; i < column->n_deps; i++)
+      {
+        if (column->dep[i] != d) continue;
+        column->dep[i] = column->dep[--column->n_deps];
+        break;
+      }
+    }
+
+    calc->dep[d].node = -1;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static void calc_spread(libo_xl_calc *calc, int first)
+   *
+   *  @brief marks for recalculation every formula depending on the dirty
+   *         formulas from @p first on
+   *
+   *  The dirty list is a work list, the dependents of each formula on it
+   *  are appended in turn.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param first - position in dirty list of first formula to follow
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_spread(libo_xl_calc *calc, int first)
+{
+  calc_node *node;
+
+  for (; first < calc->n_dirty; first++)
+  {
+    node = &calc->node[calc->dirty[first]];
+    calc_touch(calc, node->sheet, node->row, node->col);
+  }
+}
+
+  /**
+   *  @fn static void calc_touch(libo_xl_calc *calc, int sheet, int row, int col)
+   *
+   *  @brief marks for recalculation the formulas reading the cell at
+   *         @p row and @p col of @p sheet
+   *
+   *  Newly marked formulas are appended to the dirty list, whose caller
+   *  marks their own dependents.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - index of sheet in book
+   *  @param row - index of row
+   *  @param col - index of column
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_touch(libo_xl_calc *calc, int sheet, int row, int col)
+{
+  calc_column *column;
+  calc_area *area;
+  uint64_t key;
+  int e, i, n;
+
+  key = calc_key(sheet, row, col);
+
+  for (e = calc->n_heads ? calc->head[hash_mix(key) & (calc->n_heads - 1)] : -1; e >= 0; e = calc->edge[e].next)
+  {
+    if (calc->edge[e].key != key) continue;
+
+    n = calc->edge[e].node;
+    if (calc->node[n].dirty) continue;
+
+    calc->node[n].dirty = 1;
+    calc->dirty[calc->n_dirty++] = n;
+  }
+
+  if (col >= calc->sheet[sheet].n_cols) return;
+
+  column = &calc->sheet[sheet].col[col];
+
+  for (i = 0; i < column->n_deps; i++)
+  {
+    area = &calc->dep[column->dep[i]].area;
+    if (row < area->r1 || row > area->r2) continue;
+
+    n = calc->dep[column->dep[i]].node;
+    if (calc->node[n].dirty) continue;
+
+    calc->node[n].dirty = 1;
+    calc->dirty[calc->n_dirty++] = n;
+  }
+}
+
+  /**
+   *  @fn static int calc_dependents(libo_xl_calc *calc,
+   *                                 int n,
+   *                                 int step,
+   *                                 int *queue,
+   *                                 int n_queue)
+   *
+   *  @brief adds @p step to the count of pending precedents of each dirty
+   *         formula reading node @p n, queueing those left with none
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param n - index of node
+   *  @param step - 1 while counting, -1 once @p n is recalculated
+   *  @param queue - formulas ready to recalculate
+   *  @param n_queue - number of formulas in @p queue
+   *
+   *  @return number of formulas in @p queue
+   */
+
+static int calc_dependents(libo_xl_calc *calc, int n, int step, int *queue, int n_queue)
+{
+  calc_node *node;
+  calc_column *column;
+  calc_area *area;
+  calc_node *d;
+  uint64_t key;
+  int e, i;
+
+  node = &calc->node[n];
+  key = calc_key(node->sheet, node->row, node->col);
+
+  for (e = calc->n_heads ? calc->head[hash_mix(key) & (calc->n_heads - 1)] : -1; e >= 0; e = calc->edge[e].next)
+  {
+    if (calc->edge[e].key != key) continue;
+
+    d = &calc->node[calc->edge[e].node];
+    if (!d->dirty) continue;
+
+    d->pending += step;
+    if (step < 0 && !d->pending) queue[n_queue++] = calc->edge[e].node;
+  }
+
+  if (node->col >= calc->sheet[node->sheet].n_cols) return n_queue;
+
+  column = &calc->sheet[node->sheet].col[node->col];
+
+  for (i = 0; i < column->n_deps; i++)
+  {
+    area = &calc->dep[column->dep[i]].area;
+    if (node->row < area->r1 || node->row > area->r2) continue;
+
+    d = &calc->node[calc->dep[column->dep[i]].node];
+    if (!d->dirty) continue;
+
+    d->pending += step;
+    if (step < 0 && !d->pending) queue[n_queue++] = calc->dep[column->dep[i]].node;
+  }
+
+  return n_queue;
+}
+
+  /**
+   *  @fn static int calc_run(libo_xl_calc *calc)
+   *
+   *  @brief recalculates dirty formulas, each after the formulas it reads
+   *
+   *  Formulas are taken in topological order: each counts its dirty
+   *  precedents, and is queued once all are recalculated.  Formulas left
+   *  over read themselves through a cycle, and are given #REF!.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *
+   *  @return number of formulas recalculated
+   */
+
+static int calc_run(libo_xl_calc *calc)
+{
+  calc_node *node;
+  int n_queue = 0;
+  int done = 0;
+  int i, n;
+
+  for (i = 0; i < calc->n_dirty; i++)
+    calc->node[calc->dirty[i]].pending = 0;
+
+  for (i = 0; i < calc->n_dirty; i++)
+    calc_dependents(calc, calc->dirty[i], 1, calc->queue, 0);
+
+  for (i = 0; i < calc->n_dirty; i++)
+    if (!calc->node[calc->dirty[i]].pending) calc->queue[n_queue++] = calc->dirty[i];
+
+  for (i = 0; i < n_queue; i++)
+  {
+    n = calc->queue[i];
+
+    calc_eval(calc, n);
+    calc_store(calc, n);
+    calc->node[n].dirty = 0;
+    ++done;
+
+    n_queue = calc_dependents(calc, n, -1, calc->queue, n_queue);
+  }
+
+  for (i = 0; i < calc->n_dirty; i++)
+  {
+    node = &calc->node[calc->dirty[i]];
+    if (!node->dirty) continue;
+
+    calc_result_set(node, NULL);
+    node->value.kind = calc_error;
+    node->value.error = calc_error_ref;
+    calc_store(calc, calc->dirty[i]);
+    node->dirty = 0;
+    ++done;
+  }
+
+  calc->n_dirty = 0;
+
+  return done;
+}
+
+  /**
+   *  @fn static void calc_emit(calc_compiler *cc, const void *p, size_t n)
+   *
+   *  @brief appends @p n bytes at @p p to code of @p cc
+   *
+   *  @param cc - pointer to compiler
+   *  @param p - bytes to append
+   *  @param n - number of bytes
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_emit(calc_compiler *cc, const void *p, size_t n)
+{
+  unsigned char *tmp;
+  size_t size;
+
+  if (cc->error) return;
+
+  if (cc->n + n > cc->size)
+  {
+    size = cc->size ? 2 * cc->size : 64;
+    while (size < cc->n + n) size *= 2;
+
+    tmp = (unsigned char *)realloc(cc->code, size);
+    if (!tmp)
+    {
+      cc->error = 1;
+      return;
+    }
+
+    cc->code = tmp;
+    cc->size = size;
+  }
+
+  memcpy(cc->code + cc->n, p, n);
+  cc->n += n;
+}
+
+  /**
+   *  @fn static void calc_emit_op(calc_compiler *cc, calc_op op, int pushed)
+   *
+   *  @brief appends instruction @p op, which changes the depth of the stack
+   *         by @p pushed
+   *
+   *  @param cc - pointer to compiler
+   *  @param op - instruction
+   *  @param pushed - values pushed, less values popped
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_emit_op(calc_compiler *cc, calc_op op, int pushed)
+{
+  unsigned char b = (unsigned char)op;
+
+  calc_emit(cc, &b, 1);
+
+  cc->depth += pushed;
+  if (cc->depth > cc->max) cc->max = cc->depth;
+}
+
+  /**
+   *  @fn static void calc_emit_error(calc_compiler *cc, calc_error_code error)
+   *
+   *  @brief appends instruction pushing @p error
+   *
+   *  @param cc - pointer to compiler
+   *  @param error - error pushed
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_emit_error(calc_compiler *cc, calc_error_code error)
+{
+  unsigned char b = (unsigned char)error;
+
+  calc_emit_op(cc, calc_op_error, 1);
+  calc_emit(cc, &b, 1);
+}
+
+  /**
+   *  @fn static void calc_skip(calc_compiler *cc)
+   *
+   *  @brief passes over white space in formula
+   *
+   *  @param cc - pointer to compiler
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_skip(calc_compiler *cc)
+{
+  while (*cc->p == ' ' || *cc->p == '\t' || *cc->p == '\r' || *cc->p == '\n') ++cc->p;
+}
+
+  /**
+   *  @fn static int calc_ref_parse(const char *s, size_t n, int *row, int *col,
+   *                                 int *fixed)
+   *
+   *  @brief parses @p n characters at @p s as a reference such as A1, $B$2
+   *         or, for a column, C
+   *
+   *  @param s - characters of reference
+   *  @param n - number of characters
+   *  @param row - receives index of row, -1 for a column
+   *  @param col - receives index of column
+   *  @param fixed - if not NULL, receives 1 if row is absolute, plus 2 if
+   *                 column is
+   *
+   *  @return 0 on success, -1 if @p s is not a reference
+   */
+
+static int calc_ref_parse(const char *s, size_t n, int *row, int *col, int *fixed)
+{
+  size_t i = 0;
+  int letters = 0;
+  int digits = 0;
+  int c = 0;
+  int r = 0;
+  int f = 0;
+
+  if (i < n && s[i] == '$')
+  {
+    f |= 2;
+    ++i;
+  }
+
+  while (i < n && isalpha((unsigned char)s[i]) && letters < 3)
+  {
+    c = c * 26 + (toupper((unsigned char)s[i]) - 'A' + 1);
+    ++letters;
+    ++i;
+  }
+
+  if (!letters || c > LIBO_XL_CALC_COLS) return -1;
+  *col = c - 1;
+
+  if (i == n)
+  {
+    *row = -1;
+    if (fixed) *fixed = f;
+    return 0;
+  }
+
+  if (s[i] == '$')
+  {
+    f |= 1;
+    ++i;
+  }
+
+  while (i < n && isdigit((unsigned char)s[i]) && digits < 8)
+  {
+    r = r * 10 + (s[i] - '0');
+    ++digits;
+    ++i;
+  }
+
+  if (!digits || i != n || r < 1 || r > LIBO_XL_CALC_ROWS) return -1;
+  *row = r - 1;
+  if (fixed) *fixed = f;
+
+  return 0;
+}
+
+  /**
+   *  @fn static size_t calc_word(calc_compiler *cc)
+   *
+   *  @brief returns length of the name or reference starting formula
+   *
+   *  @param cc - pointer to compiler
+   *
+   *  @return number of characters, 0 if none
+   */
+
+static size_t calc_word(calc_compiler *cc)
+{
+  return formula_word(cc->p);
+}
+
+  /**
+   *  @fn static size_t formula_word(const char *p)
+   *
+   *  @brief returns length of the name, number or reference at @p p
+   *
+   *  @param p - characters of formula
+   *
+   *  @return number of characters, 0 if none
+   */
+
+static size_t formula_word(const char *p)
+{
+  const char *s = p;
+
+  while (isalnum((unsigned char)*s) || *s == '_' || *s == '.' || *s == '$' || *s == '\\') ++s;
+
+  return s - p;
+}
+
+  /**
+   *  @fn static size_t formula_literal(const char *p)
+   *
+   *  @brief returns length of the text, quoted sheet name or bracketed
+   *         name at @p p, which are copied as they are
+   *
+   *  @param p - characters of formula
+   *
+   *  @return number of characters, 0 if none starts at @p p
+   */
+
+static size_t formula_literal(const char *p)
+{
+  const char *s;
+  int depth = 0;
+
+  if (*p == '"' || *p == '\'')
+  {
+      // doubled quotes stay inside
+
+    for (s = p + 1; *s; s++)
+    {
+      if (*s != *p) continue;
+      if (s[1] != *p) return s + 1 - p;
+      ++s;
+    }
+    return s - p;
+  }
+
+  if (*p == '[')
+  {
+    for (s = p; *s; s++)
+    {
+      if (*s == '[') ++depth;
+      else if (*s == ']' && !--depth) return s + 1 - p;
+    }
+    return s - p;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static int formula_a1_parse(const char *p, size_t n, formula_ref *ref)
+   *
+   *  @brief parses @p n characters at @p p as a cell such as $B2, a column
+   *         such as C, or a row such as $3
+   *
+   *  @param p - characters of reference
+   *  @param n - number of characters
+   *  @param ref - receives reference
+   *
+   *  @return 0 on success, -1 if @p p is not a reference
+   */
+
+static int formula_a1_parse(const char *p, size_t n, formula_ref *ref)
+{
+  size_t i = 0;
+  long r = 0;
+
+  memset(ref, 0, sizeof(formula_ref));
+
+  if (!calc_ref_parse(p, n, &ref->row, &ref->col, &ref->fixed)) return 0;
+
+  if (i < n && p[i] == '$')
+  {
+    ref->fixed = 1;
+    ++i;
+  }
+
+  if (i == n || n - i > 7) return -1;
+
+  for (; i < n; i++)
+  {
+    if (!isdigit((unsigned char)p[i])) return -1;
+    r = r * 10 + (p[i] - '0');
+  }
+
+  if (r < 1 || r > LIBO_XL_CALC_ROWS) return -1;
+
+  ref->row = r - 1;
+  ref->col = -1;
+
+  return 0;
+}
+
+  /**
+   *  @fn static const char *formula_r1c1_part(const char *p,
+   *                                           char axis,
+   *                                           int base,
+   *                                           int limit,
+   *                                           int *value,
+   *                                           int *fixed,
+   *                                           int *bad)
+   *
+   *  @brief parses the row or column part of an R1C1 reference, such as
+   *         R, R3 or R[-1]
+   *
+   *  @param p - characters of reference
+   *  @param axis - 'R' or 'C'
+   *  @param base - index of row or column references are relative to
+   *  @param limit - number of rows or columns of a work sheet
+   *  @param value - receives index, -1 if @p p holds no part of @p axis
+   *  @param fixed - receives 1 if the index is absolute, 0 if not
+   *  @param bad - set to 1 if the index falls outside a work sheet
+   *
+   *  @return characters after part, NULL if part is malformed
+   */
+
+static const char *formula_r1c1_part(const char *p,
+                                     char axis,
+                                     int base,
+                                     int limit,
+                                     int *value,
+                                     int *fixed,
+                                     int *bad)
+{
+  char *end;
+  long v;
+
+  *value = -1;
+  *fixed = 0;
+
+  if (*p != axis) return p;
+  ++p;
+
+  if (*p == '[')
+  {
+    v = strtol(p + 1, &end, 10);
+    if (end == p + 1 || *end != ']') return NULL;
+    v += base;
+    p = end + 1;
+  }
+  else if (isdigit((unsigned char)*p))
+  {
+    v = strtol(p, &end, 10) - 1;
+    *fixed = 1;
+    p = end;
+  }
+  else
+    v = base;
+
+  if (v < 0 || v >= limit)
+  {
+    *bad = 1;
+    v = 0;
+  }
+  *value = (int)v;
+
+  return p;
+}
+
+  /**
+   *  @fn static size_t formula_r1c1_parse(const char *p, int row, int col,
+   *                                       formula_ref *ref)
+   *
+   *  @brief parses an R1C1 reference at @p p, made by
+   *         @a libo_xl_formula_to_r1c1, for a cell at @p row and @p col
+   *
+   *  @param p - characters of formula
+   *  @param row - index of row of cell holding formula
+   *  @param col - index of column of cell holding formula
+   *  @param ref - receives reference
+   *
+   *  @return number of characters of reference, 0 if none starts at @p p
+   */
+
+static size_t formula_r1c1_parse(const char *p, int row, int col, formula_ref *ref)
+{
+  const char *s;
+  int fixed;
+
+  memset(ref, 0, sizeof(formula_ref));
+
+  s = formula_r1c1_part(p, 'R', row, LIBO_XL_CALC_ROWS, &ref->row, &fixed, &ref->bad);
+  if (!s) return 0;
+  ref->fixed = fixed;
+
+  s = formula_r1c1_part(s, 'C', col, LIBO_XL_CALC_COLS, &ref->col, &fixed, &ref->bad);
+  if (!s) return 0;
+  ref->fixed |= fixed << 1;
+
+    // names and calls that merely start like a reference are not one
+
+  if (s == p) return 0;
+  if (formula_word(s) || *s == '(' || *s == '!' || *s == '[') return 0;
+
+  return s - p;
+}
+
+  /**
+   *  @fn static size_t formula_column_format(int col, char *s)
+   *
+   *  @brief writes letters of column @p col into @p s, unterminated
+   *
+   *  @param col - index of column
+   *  @param s - buffer of at least 4 characters
+   *
+   *  @return number of characters written
+   */
+
+static size_t formula_column_format(int col, char *s)
+{
+  char letters[4];
+  size_t n = 0;
+  size_t i;
+
+  for (++col; col && n < sizeof(letters); col = (col - 1) / 26)
+    letters[n++] = 'A' + (col - 1) % 26;
+
+  for (i = 0; i < n; i++)
+    s[i] = letters[n - 1 - i];
+
+  return n;
+}
+
+  /**
+   *  @fn static size_t formula_a1_format(formula_ref *ref, char *s)
+   *
+   *  @brief writes @p ref in A1 form into @p s, unterminated
+   *
+   *  @param ref - pointer to reference
+   *  @param s - buffer of at least 16 characters
+   *
+   *  @return number of characters written
+   */
+
+static size_t formula_a1_format(formula_ref *ref, char *s)
+{
+  size_t n = 0;
+
+  if (ref->col >= 0)
+  {
+    if (ref->fixed & 2) s[n++] = '$';
+    n += formula_column_format(ref->col, s + n);
+  }
+
+  if (ref->row >= 0)
+  {
+    if (ref->fixed & 1) s[n++] = '$';
+    n += format_integer(ref->row + 1, s + n);
+  }
+
+  return n;
+}
+
+  /**
+   *  @fn static size_t formula_r1c1_format(formula_ref *ref, int row, int col,
+   *                                        char *s)
+   *
+   *  @brief writes @p ref in R1C1 form into @p s, unterminated, relative to
+   *         a cell at @p row and @p col
+   *
+   *  @param ref - pointer to reference
+   *  @param row - index of row of cell holding formula
+   *  @param col - index of column of cell holding formula
+   *  @param s - buffer of at least 32 characters
+   *
+   *  @return number of characters written
+   */
+
+static size_t formula_r1c1_format(formula_ref *ref, int row, int col, char *s)
+{
+  int n = 0;
+
+  if (ref->row >= 0)
+  {
+    if (ref->fixed & 1) n += sprintf(s + n, "R%d", ref->row + 1);
+    else if (ref->row != row) n += sprintf(s + n, "R[%d]", ref->row - row);
+    else s[n++] = 'R';
+  }
+
+  if (ref->col >= 0)
+  {
+    if (ref->fixed & 2) n += sprintf(s + n, "C%d", ref->col + 1);
+    else if (ref->col != col) n += sprintf(s + n, "C[%d]", ref->col - col);
+    else s[n++] = 'C';
+  }
+
+  return n;
+}
+
+  /**
+   *  @fn static void formula_put(char *buffer, size_t size, size_t *len,
+   *                              const char *s, size_t n)
+   *
+   *  @brief appends @p n characters at @p s to @p buffer, as far as they
+   *         fit, counting all of them in @p len
+   *
+   *  @param buffer - buffer receiving text, or NULL
+   *  @param size - size of @p buffer in bytes
+   *  @param len - length of text, advanced by @p n
+   *  @param s - characters to append
+   *  @param n - number of characters
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void formula_put(char *buffer, size_t size, size_t *len, const char *s, size_t n)
+{
+  size_t room;
+
+  if (buffer && size && *len < size - 1)
+  {
+    room = size - 1 - *len;
+    memcpy(buffer + *len, s, n < room ? n : room);
+  }
+
+  *len += n;
+}
+
+  /**
+   *  @fn static int cell_has_formula(libo_xl_cell *cell)
+   *
+   *  @brief tells whether @p cell holds a formula, of its own or shared
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell, or NULL
+   *
+   *  @return 1 if @p cell has a formula, 0 if not
+   */
+
+static int cell_has_formula(libo_xl_cell *cell)
+{
+  if (!cell || (cell->type != libo_xl_cell_type_expression)) return 0;
+
+  if (cell->shared) return 1;
+
+  return cell->expression.formula && *cell->expression.formula;
+}
+
+  /**
+   *  @fn static int cell_is_number(libo_xl_cell *cell)
+   *
+   *  @brief tells whether @p cell holds a number, dates included
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell, or NULL
+   *
+   *  @return 1 if @p cell is a number or a date, 0 if not
+   */
+
+static int cell_is_number(libo_xl_cell *cell)
+{
+  if (!cell) return 0;
+
+  return (cell->type == libo_xl_cell_type_number) || (cell->type == libo_xl_cell_type_date);
+}
+
+  /**
+   *  @fn static void cell_resolve_date(libo_xl_cell *cell,
+   *                                    libo_xl_sheet *sheet)
+   *
+   *  @brief makes number @p cell a date when its format shows one
+   *
+   *  @param cell - pointer to @a libo_xl_cell just read, or NULL
+   *  @param sheet - work sheet holding the formats showing dates, or NULL
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void cell_resolve_date(libo_xl_cell *cell, libo_xl_sheet *sheet)
+{
+  if (!cell || !sheet || (cell->type != libo_xl_cell_type_number)) return;
+
+  if ((cell->style < sheet->n_dates) && sheet->dates[cell->style])
+    cell->type = libo_xl_cell_type_date;
+}
+
+  /**
+   *  @fn static int sheet_set_dates(libo_xl_sheet *sheet,
+   *                                 libo_xl_styles *styles)
+   *
+   *  @brief gives @p sheet the cell formats of @p styles showing dates,
+   *         so cells read into it in those formats are dates
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param styles - pointer to @a libo_xl_styles struct, or NULL for none
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int sheet_set_dates(libo_xl_sheet *sheet, libo_xl_styles *styles)
+{
+  free(sheet->dates);
+  sheet->dates = NULL;
+  sheet->n_dates = 0;
+
+  if (!styles || !styles->n_styles) return 0;
+
+  sheet->dates = (unsigned char *)malloc(styles->n_styles);
+  if (!sheet->dates) return -1;
+
+  memcpy(sheet->dates, styles->date, styles->n_styles);
+  sheet->n_dates = styles->n_styles;
+
+  return 0;
+}
+
+  /**
+   *  @fn static int workbook_date1904(xmlDocPtr doc)
+   *
+   *  @brief returns date system of parsed workbook part @p doc
+   *
+   *  @param doc - parsed xl/workbook.xml
+   *
+   *  @return 1 if serial dates count from 1904, 0 if from 1900
+   */
+
+static int workbook_date1904(xmlDocPtr doc)
+{
+  xmlNodePtr node;
+  char *value;
+  int date1904 = 0;
+
+  node = xmlDocGetRootElement(doc);
+  if (!node) return 0;
+
+  for (node = node->children; node; node = node->next)
+  {
+    if ((node->type != XML_ELEMENT_NODE) || strcmp((char *)node->name, "workbookPr")) continue;
+
+    value = (char *)xmlGetProp(node, (xmlChar *)"date1904");
+    date1904 = value && (!strcmp(value, "1") || !strcmp(value, "true"));
+    xmlFree(value);
+    break;
+  }
+
+  return date1904;
+}
+
+  /**
+   *  @fn static char *cell_formula_r1c1(libo_xl_sheet *sheet,
+   *                                     libo_xl_cell *cell,
+   *                                     int row,
+   *                                     int col)
+   *
+   *  @brief returns formula of @p cell, at @p row and @p col of @p sheet,
+   *         in R1C1 form
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param cell - pointer to existing @a libo_xl_cell
+   *  @param row - index of row of @p cell
+   *  @param col - index of column of @p cell
+   *
+   *  @return new formula, to be freed by caller, NULL if none
+   */
+
+static char *cell_formula_r1c1(libo_xl_sheet *sheet, libo_xl_cell *cell, int row, int col)
+{
+  if (!cell_has_formula(cell)) return NULL;
+
+    // text set on a cell overrides its shared formula
+
+  if (cell->expression.formula && *cell->expression.formula)
+    return libo_xl_formula_to_r1c1(cell->expression.formula, row, col);
+
+  if ((cell->shared > 0) && (cell->shared <= sheet->n_shared))
+    return strdup(sheet->shared[cell->shared - 1]);
+
+  return NULL;
+}
+
+  /**
+   *  @fn static int sheet_formula_share(libo_xl_sheet *sheet,
+   *                                     int **group,
+   *                                     int *n_groups,
+   *                                     char *si,
+   *                                     char *text,
+   *                                     int row,
+   *                                     int col)
+   *
+   *  @brief finds shared formula of @p sheet for group @p si of a work
+   *         sheet, adding it when @p text is given
+   *
+   *  @p text is the formula of the first cell of the group, at @p row and
+   *  @p col, and is kept in R1C1 form.  Groups with the same R1C1 form
+   *  share one entry.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param group - table giving entry of @a shared of @p sheet for each
+   *                 group, grown as needed, to be freed by caller
+   *  @param n_groups - number of entries of @p group
+   *  @param si - identifier of group, as in file
+   *  @param text - formula of first cell of group, NULL or empty for others
+   *  @param row - index of row of cell
+   *  @param col - index of column of cell
+   *
+   *  @return index of shared formula, -1 if none
+   */
+
+static int sheet_formula_share(libo_xl_sheet *sheet,
+                               int **group,
+                               int *n_groups,
+                               char *si,
+                               char *text,
+                               int row,
+                               int col)
+{
+  char **shared;
+  char *r1c1;
+  int *ngroup;
+  int k;
+  int i;
+
+  if (!si || !isdigit((unsigned char)*si)) return -1;
+
+  k = atoi(si);
+  if ((k < 0) || (k >= LIBO_XL_CALC_ROWS)) return -1;
+
+  if (!text || !*text)
+    return (k < *n_groups) ? (*group)[k] : -1;
+
+  if (k >= *n_groups)
+  {
+    ngroup = (int *)realloc(*group, sizeof(int) * (k + 1));
+    if (!ngroup) return -1;
+
+    for (i = *n_groups; i <= k; i++)
+      ngroup[i] = -1;
+
+    *group = ngroup;
+    *n_groups = k + 1;
+  }
+
+  r1c1 = libo_xl_formula_to_r1c1(text, row, col);
+  if (!r1c1) return -1;
+
+  for (i = 0; i < sheet->n_shared; i++)
+  {
+    if (strcmp(sheet->shared[i], r1c1)) continue;
+
+    free(r1c1);
+    (*group)[k] = i;
+
+    return i;
+  }
+
+  shared = (char **)realloc(sheet->shared, sizeof(char *) * (sheet->n_shared + 1));
+  if (!shared)
+  {
+    free(r1c1);
+    return -1;
+  }
+
+  sheet->shared = shared;
+  sheet->shared[sheet->n_shared] = r1c1;
+  (*group)[k] = sheet->n_shared++;
+
+  return (*group)[k];
+}
+
+  /**
+   *  @fn static int sheet_row_expand(libo_xl_sheet *sheet, int n,
+   *                                  libo_xl_row *row)
+   *
+   *  @brief gives each cell of @p row, at index @p n of @p sheet, sharing
+   *         a formula its own text
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct holding
+   *                 the shared formulas
+   *  @param n - index of row in @p sheet
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *
+   *  @return number of cells given text, -1 on failure
+   */
+
+static int sheet_row_expand(libo_xl_sheet *sheet, int n, libo_xl_row *row)
+{
+  libo_xl_cell *cell;
+  int count = 0;
+  int k;
+  int j;
+
+  if (!sheet || !row) return 0;
+
+  for (j = 0; j < row->n_cells; j++)
+  {
+    cell = row->cell[j];
+    if (!cell || !cell->shared) continue;
+
+    k = cell_formula_expand(sheet, cell, n, j);
+    if (k < 0) return -1;
+    count += k;
+
+    cell->shared = 0;
+  }
+
+  return count;
+}
+
+  /**
+   *  @fn static int cell_formula_expand(libo_xl_sheet *sheet,
+   *                                     libo_xl_cell *cell,
+   *                                     int row,
+   *                                     int col)
+   *
+   *  @brief gives @p cell, at @p row and @p col of @p sheet, the text of the
+   *         shared formula it holds only the index of
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct holding
+   *                 the shared formulas
+   *  @param cell - pointer to existing @a libo_xl_cell
+   *  @param row - index of row of @p cell
+   *  @param col - index of column of @p cell
+   *
+   *  @return 1 if @p cell was given text, 0 if not needed, -1 on failure
+   */
+
+static int cell_formula_expand(libo_xl_sheet *sheet, libo_xl_cell *cell, int row, int col)
+{
+  char *r1c1;
+  size_t len;
+
+  if ((cell->type != libo_xl_cell_type_expression) || cell->expression.formula) return 0;
+  if ((cell->shared <= 0) || (cell->shared > sheet->n_shared)) return 0;
+
+  r1c1 = sheet->shared[cell->shared - 1];
+  len = libo_xl_formula_from_r1c1(r1c1, row, col, NULL, 0);
+
+  cell->expression.formula = (char *)malloc(len + 1);
+  if (!cell->expression.formula) return -1;
+
+  libo_xl_formula_from_r1c1(r1c1, row, col, cell->expression.formula, len + 1);
+
+  return 1;
+}
+
+  /**
+   *  @fn static void sheet_shared_free(libo_xl_sheet *sheet)
+   *
+   *  @brief frees shared formulas of @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void sheet_shared_free(libo_xl_sheet *sheet)
+{
+  int i;
+
+  if (!sheet) return;
+
+  for (i = 0; i < sheet->n_shared; i++)
+    free(sheet->shared[i]);
+  free(sheet->shared);
+
+  sheet->shared = NULL;
+  sheet->n_shared = 0;
+}
+
+  /**
+   *  @fn static int calc_sheet_find(libo_xl_calc *calc, const char *name, size_t n)
+   *
+   *  @brief returns index of sheet named by @p n characters at @p name
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param name - name, not terminated, quotes doubled if it was quoted
+   *  @param n - number of characters
+   *
+   *  @return index of sheet, -1 if there is none
+   */
+
+static int calc_sheet_find(libo_xl_calc *calc, const char *name, size_t n)
+{
+  char *sname;
+  size_t i, j;
+  int s;
+
+  for (s = 0; s < calc->n_sheets; s++)
+  {
+    sname = calc->sheet[s].sheet ? calc->sheet[s].sheet->name : NULL;
+    if (!sname) continue;
+
+    for (i = j = 0; i < n && sname[j]; i++, j++)
+    {
+      if (name[i] == '\'' && i + 1 < n && name[i + 1] == '\'') ++i;
+      if (toupper((unsigned char)name[i]) != toupper((unsigned char)sname[j])) break;
+    }
+
+    if (i == n && !sname[j]) return s;
+  }
+
+  return -1;
+}
+
+  /**
+   *  @fn static int calc_parse_reference(calc_compiler *cc, int sheet)
+   *
+   *  @brief compiles a cell, range or column reference into @p sheet
+   *
+   *  @param cc - pointer to compiler
+   *  @param sheet - index of sheet referred to, -1 if it is unknown
+   *
+   *  @return 0 on success, -1 if no reference follows
+   */
+
+static int calc_parse_reference(calc_compiler *cc, int sheet)
+{
+  calc_area area;
+  size_t n;
+  int r1, c1, r2, c2;
+  int cell[3];
+  int t;
+
+  n = calc_word(cc);
+  if (!n || calc_ref_parse(cc->p, n, &r1, &c1, NULL)) return -1;
+  cc->p += n;
+
+  r2 = r1;
+  c2 = c1;
+
+  if (*cc->p == ':')
+  {
+    ++cc->p;
+    n = calc_word(cc);
+    if (!n || calc_ref_parse(cc->p, n, &r2, &c2, NULL)) return -1;
+    if ((r1 < 0) != (r2 < 0)) return -1;
+    cc->p += n;
+  }
+  else if (r1 < 0)
+    return -1;
+
+  if (sheet < 0)
+  {
+    calc_emit_error(cc, calc_error_ref);
+    return 0;
+  }
+
+    // whole columns reach the last row formulas may name
+
+  if (r1 < 0)
+  {
+    r1 = 0;
+    r2 = LIBO_XL_CALC_ROWS - 1;
+  }
+
+  if ((r1 == r2) && (c1 == c2))
+  {
+    cell[0] = sheet;
+    cell[1] = r1;
+    cell[2] = c1;
+    calc_emit_op(cc, calc_op_cell, 1);
+    calc_emit(cc, cell, sizeof(cell));
+    return 0;
+  }
+
+  if (r1 > r2) { t = r1; r1 = r2; r2 = t; }
+  if (c1 > c2) { t = c1; c1 = c2; c2 = t; }
+
+  area.sheet = sheet;
+  area.r1 = r1;
+  area.c1 = c1;
+  area.r2 = r2;
+  area.c2 = c2;
+  calc_emit_op(cc, calc_op_range, 1);
+  calc_emit(cc, &area, sizeof(calc_area));
+
+  return 0;
+}
+
+  /**
+   *  @fn static int calc_parse_call(calc_compiler *cc, const char *name, size_t n)
+   *
+   *  @brief compiles arguments of function named by @p n characters at
+   *         @p name, and its call
+   *
+   *  @param cc - pointer to compiler, at the opening parenthesis
+   *  @param name - name of function, not terminated
+   *  @param n - number of characters
+   *
+   *  @return 0 on success, -1 on error
+   */
+
+static int calc_parse_call(calc_compiler *cc, const char *name, size_t n)
+{
+  unsigned char op[2];
+  char upper[32];
+  int argc = 0;
+  int fn;
+  size_t i;
+
+    // functions newer than the file format carry a prefix
+
+  if (n > 6 && !strncasecmp(name, "_xlfn.", 6))
+  {
+    name += 6;
+    n -= 6;
+  }
+
+  for (i = 0; i < n && i < sizeof(upper) - 1; i++)
+    upper[i] = toupper((unsigned char)name[i]);
+  upper[i] = 0;
+
+  for (fn = 0; _calc_builtins[fn].name; fn++)
+    if (i == n && !strcmp(_calc_builtins[fn].name, upper)) break;
+
+  ++cc->p;
+  calc_skip(cc);
+
+  if (*cc->p != ')')
+  {
+    for (;;)
+    {
+      calc_skip(cc);
+
+      if (*cc->p == ',' || *cc->p == ')')
+        calc_emit_op(cc, calc_op_empty, 1);
+      else if (calc_parse_expression(cc))
+        return -1;
+
+      if (++argc > 255) return -1;
+
+      calc_skip(cc);
+      if (*cc->p == ')') break;
+      if (*cc->p != ',') return -1;
+      ++cc->p;
+    }
+  }
+
+  ++cc->p;
+
+  op[0] = (unsigned char)(_calc_builtins[fn].name ? fn : 255);
+  op[1] = (unsigned char)argc;
+  calc_emit_op(cc, calc_op_call, 1 - argc);
+  calc_emit(cc, op, 2);
+
+  return 0;
+}
+
+  /**
+   *  @fn static int calc_parse_primary(calc_compiler *cc)
+   *
+   *  @brief compiles a number, text, boolean, error, reference, function
+   *         call or parenthesized expression
+   *
+   *  @param cc - pointer to compiler
+   *
+   *  @return 0 on success, -1 on error
+   */
+
+static int calc_parse_primary(calc_compiler *cc)
+{
+  const char *start;
+  unsigned char b;
+  double number;
+  char *end;
+  size_t n;
+  int len;
+  int sheet;
+  int i;
+
+  calc_skip(cc);
+  start = cc->p;
+
+  if (isdigit((unsigned char)*cc->p) || (*cc->p == '.' && isdigit((unsigned char)cc->p[1])))
+  {
+    number = strtod(cc->p, &end);
+    cc->p = end;
+    calc_emit_op(cc, calc_op_number, 1);
+    calc_emit(cc, &number, sizeof(double));
+    return 0;
+  }
+
+  if (*cc->p == '"')
+  {
+      // doubled quotes are undone as the text is emitted
+
+    for (++cc->p, len = 0; *cc->p; ++cc->p, ++len)
+    {
+      if (*cc->p != '"') continue;
+      if (cc->p[1] != '"') break;
+      ++cc->p;
+    }
+    if (*cc->p != '"') return -1;
+
+    calc_emit_op(cc, calc_op_text, 1);
+    calc_emit(cc, &len, sizeof(int));
+    for (cc->p = start + 1; *cc->p != '"' || cc->p[1] == '"'; ++cc->p)
+    {
+      if (*cc->p == '"') ++cc->p;
+      calc_emit(cc, cc->p, 1);
+    }
+    ++cc->p;
+    return 0;
+  }
+
+  if (*cc->p == '(')
+  {
+    ++cc->p;
+    if (calc_parse_expression(cc)) return -1;
+    calc_skip(cc);
+    if (*cc->p != ')') return -1;
+    ++cc->p;
+    return 0;
+  }
+
+  if (*cc->p == '#')
+  {
+    for (i = 1; i <= calc_error_na; i++)
+    {
+      n = strlen(_calc_errors[i]);
+      if (strncasecmp(cc->p, _calc_errors[i], n)) continue;
+      cc->p += n;
+      calc_emit_error(cc, (calc_error_code)i);
+      return 0;
+    }
+    return -1;
+  }
+
+  if (*cc->p == '\'')
+  {
+    for (++cc->p; *cc->p; ++cc->p)
+    {
+      if (*cc->p != '\'') continue;
+      if (cc->p[1] != '\'') break;
+      ++cc->p;
+    }
+    if (cc->p[0] != '\'' || cc->p[1] != '!') return -1;
+
+    sheet = calc_sheet_find(cc->calc, start + 1, cc->p - start - 1);
+    cc->p += 2;
+    return calc_parse_reference(cc, sheet);
+  }
+
+  n = calc_word(cc);
+  if (!n) return -1;
+
+  if (cc->p[n] == '!')
+  {
+    sheet = calc_sheet_find(cc->calc, cc->p, n);
+    cc->p += n + 1;
+    return calc_parse_reference(cc, sheet);
+  }
+
+  if (cc->p[n] == '(')
+  {
+    cc->p += n;
+    return calc_parse_call(cc, start, n);
+  }
+
+  if ((n == 4 && !strncasecmp(cc->p, "TRUE", 4)) || (n == 5 && !strncasecmp(cc->p, "FALSE", 5)))
+  {
+    b = (n == 4);
+    cc->p += n;
+    calc_emit_op(cc, calc_op_bool, 1);
+    calc_emit(cc, &b, 1);
+    return 0;
+  }
+
+  if (!calc_parse_reference(cc, cc->sheet)) return 0;
+
+    // defined names are not known, they give #NAME?
+
+  cc->p = start + n;
+  calc_emit_error(cc, calc_error_name);
+
+  return 0;
+}
+
+  /**
+   *  @fn static int calc_parse_unary(calc_compiler *cc)
+   *
+   *  @brief compiles a value with leading signs and trailing percent signs
+   *
+   *  @param cc - pointer to compiler
+   *
+   *  @return 0 on success, -1 on error
+   */
+
+static int calc_parse_unary(calc_compiler *cc)
+{
+  calc_skip(cc);
+
+  if (*cc->p == '-' || *cc->p == '+')
+  {
+    if (*cc->p++ == '+') return calc_parse_unary(cc);
+    if (calc_parse_unary(cc)) return -1;
+    calc_emit_op(cc, calc_op_negate, 0);
+    return 0;
+  }
+
+  if (calc_parse_primary(cc)) return -1;
+
+  for (calc_skip(cc); *cc->p == '%'; calc_skip(cc))
+  {
+    ++cc->p;
+    calc_emit_op(cc, calc_op_percent, 0);
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static int calc_parse_binary(calc_compiler *cc, int level)
+   *
+   *  @brief compiles operators of precedence @p level and above
+   *
+   *  Levels are comparison, &, + and -, * and /, then ^, all taken left to
+   *  right as Excel does.  Negation binds tighter than ^.
+   *
+   *  @param cc - pointer to compiler
+   *  @param level - 0 for comparison to 4 for ^
+   *
+   *  @return 0 on success, -1 on error
+   */
+
+static int calc_parse_binary(calc_compiler *cc, int level)
+{
+  calc_op op;
+  const char *p;
+  int n;
+
+  if (level > 4) return calc_parse_unary(cc);
+
+  if (calc_parse_binary(cc, level + 1)) return -1;
+
+  for (;;)
+  {
+    calc_skip(cc);
+    p = cc->p;
+    n = 1;
+
+    switch (level)
+    {
+      case 0:
+        if (p[0] == '<' && p[1] == '=') { op = calc_op_le; n = 2; }
+        else if (p[0] == '>' && p[1] == '=') { op = calc_op_ge; n = 2; }
+        else if (p[0] == '<' && p[1] == '>') { op = calc_op_ne; n = 2; }
+        else if (p[0] == '<') op = calc_op_lt;
+        else if (p[0] == '>') op = calc_op_gt;
+        else if (p[0] == '=') op = calc_op_eq;
+        else return 0;
+        break;
+      case 1:
+        if (p[0] != '&') return 0;
+        op = calc_op_concat;
+        break;
+      case 2:
+        if (p[0] == '+') op = calc_op_add;
+        else if (p[0] == '-') op = calc_op_subtract;
+        else return 0;
+        break;
+      case 3:
+        if (p[0] == '*') op = calc_op_multiply;
+        else if (p[0] == '/') op = calc_op_divide;
+        else return 0;
+        break;
+      default:
+        if (p[0] != '^') return 0;
+        op = calc_op_power;
+        break;
+    }
+
+    cc->p += n;
+    if (calc_parse_binary(cc, level + 1)) return -1;
+    calc_emit_op(cc, op, -1);
+  }
+}
+
+  /**
+   *  @fn static int calc_parse_expression(calc_compiler *cc)
+   *
+   *  @brief compiles an expression
+   *
+   *  @param cc - pointer to compiler
+   *
+   *  @return 0 on success, -1 on error
+   */
+
+static int calc_parse_expression(calc_compiler *cc)
+{
+  if (calc_parse_binary(cc, 0) || cc->error) return -1;
+
+  return 0;
+}
+
+  /**
+   *  @fn static int calc_compile(libo_xl_calc *calc, int n, const char *formula)
+   *
+   *  @brief compiles @p formula into the code of node @p n
+   *
+   *  A formula that cannot be compiled is given code producing #NAME?.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param n - index of node
+   *  @param formula - text of formula, without leading =
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int calc_compile(libo_xl_calc *calc, int n, const char *formula)
+{
+  calc_compiler cc;
+  calc_node *node;
+  calc_value *tmp;
+
+  memset(&cc, 0, sizeof(calc_compiler));
+  cc.calc = calc;
+  cc.sheet = calc->node[n].sheet;
+  cc.p = formula;
+
+  if (*cc.p == '=') ++cc.p;
+
+  if (calc_parse_expression(&cc) || (calc_skip(&cc), *cc.p))
+  {
+    cc.n = 0;
+    cc.depth = cc.max = 0;
+    cc.error = 0;
+    calc_emit_error(&cc, calc_error_name);
+  }
+
+  if (cc.error)
+  {
+    free(cc.code);
+    return -1;
+  }
+
+  if (cc.max > calc->size_stack)
+  {
+    tmp = (calc_value *)realloc(calc->stack, sizeof(calc_value) * cc.max);
+    if (!tmp)
+    {
+      free(cc.code);
+      return -1;
+    }
+
+    calc->stack = tmp;
+    calc->size_stack = cc.max;
+  }
+
+  node = &calc->node[n];
+  if (node->code) free(node->code);
+  node->code = cc.code;
+  node->n_code = cc.n;
+  node->depth = cc.max;
+
+  return 0;
+}
+
+  /**
+   *  @fn static int calc_compile_cell(libo_xl_calc *calc,
+   *                                   int n,
+   *                                   libo_xl_sheet *sheet,
+   *                                   libo_xl_cell *cell,
+   *                                   int row,
+   *                                   int col)
+   *
+   *  @brief compiles formula of @p cell, at @p row and @p col of @p sheet,
+   *         into the code of node @p n
+   *
+   *  A cell sharing a formula is compiled from the text made for its
+   *  position.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param n - index of node
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param cell - pointer to existing @a libo_xl_cell holding a formula
+   *  @param row - index of row of @p cell
+   *  @param col - index of column of @p cell
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int calc_compile_cell(libo_xl_calc *calc,
+                             int n,
+                             libo_xl_sheet *sheet,
+                             libo_xl_cell *cell,
+                             int row,
+                             int col)
+{
+  char text[256];
+  char *formula = text;
+  size_t len;
+  int rc;
+
+  if (cell->expression.formula && *cell->expression.formula)
+    return calc_compile(calc, n, cell->expression.formula);
+
+  len = libo_xl_sheet_format_formula(sheet, row, col, text, sizeof(text));
+  if (len >= sizeof(text))
+  {
+    formula = (char *)malloc(len + 1);
+    if (!formula) return -1;
+    libo_xl_sheet_format_formula(sheet, row, col, formula, len + 1);
+  }
+
+  rc = calc_compile(calc, n, formula);
+
+  if (formula != text) free(formula);
+
+  return rc;
+}
+
+  /**
+   *  @fn static char *calc_alloc(libo_xl_calc *calc, size_t n)
+   *
+   *  @brief returns @p n bytes for text made while a formula is evaluated
+   *
+   *  The bytes last until the next formula is evaluated.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param n - number of bytes
+   *
+   *  @return pointer to bytes, NULL on failure
+   */
+
+static char *calc_alloc(libo_xl_calc *calc, size_t n)
+{
+  calc_block *block = calc->block;
+  size_t size;
+  char *p;
+
+  if (!block || (block->used + n > block->size))
+  {
+    size = (n > LIBO_XL_CALC_BLOCK) ? n : LIBO_XL_CALC_BLOCK;
+
+    block = (calc_block *)malloc(sizeof(calc_block) + size);
+    if (!block) return NULL;
+
+    block->next = calc->block;
+    block->used = 0;
+    block->size = size;
+    calc->block = block;
+  }
+
+  p = block->data + block->used;
+  block->used += n;
+
+  return p;
+}
+
+  /**
+   *  @fn static void calc_arena_reset(libo_xl_calc *calc)
+   *
+   *  @brief releases text made while the last formula was evaluated,
+   *         keeping one block for the next
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_arena_reset(libo_xl_calc *calc)
+{
+  calc_block *block, *next;
+
+  if (!calc->block) return;
+
+  for (block = calc->block->next; block; block = next)
+  {
+    next = block->next;
+    free(block);
+  }
+
+  calc->block->next = NULL;
+  calc->block->used = 0;
+}
+
+  /**
+   *  @fn static void calc_set_number(calc_value *v, double number)
+   *
+   *  @brief sets @p v to @p number
+   *
+   *  @param v - value to set
+   *  @param number - number
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_set_number(calc_value *v, double number)
+{
+  memset(v, 0, sizeof(calc_value));
+  v->kind = calc_number;
+  v->number = number;
+}
+
+  /**
+   *  @fn static void calc_set_bool(calc_value *v, int b)
+   *
+   *  @brief sets @p v to TRUE if @p b is set, else FALSE
+   *
+   *  @param v - value to set
+   *  @param b - boolean
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_set_bool(calc_value *v, int b)
+{
+  memset(v, 0, sizeof(calc_value));
+  v->kind = calc_bool;
+  v->number = b ? 1 : 0;
+}
+
+  /**
+   *  @fn static void calc_set_error(calc_value *v, calc_error_code error)
+   *
+   *  @brief sets @p v to @p error
+   *
+   *  @param v - value to set
+   *  @param error - error
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_set_error(calc_value *v, calc_error_code error)
+{
+  memset(v, 0, sizeof(calc_value));
+  v->kind = calc_error;
+  v->error = error;
+}
+
+  /**
+   *  @fn static void calc_set_text(calc_value *v, const char *text, size_t len)
+   *
+   *  @brief sets @p v to @p len bytes of @p text
+   *
+   *  @param v - value to set
+   *  @param text - text, which must outlive @p v
+   *  @param len - bytes of text
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_set_text(calc_value *v, const char *text, size_t len)
+{
+  memset(v, 0, sizeof(calc_value));
+  v->kind = calc_text;
+  v->text = text;
+  v->len = len;
+}
+
+  /**
+   *  @fn static void calc_parse_value(libo_xl_calc *calc, const char *s, calc_value *out)
+   *
+   *  @brief sets @p out to value held as text @p s by an expression cell
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param s - value of expression, or NULL
+   *  @param out - receives value
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_parse_value(libo_xl_calc *calc, const char *s, calc_value *out)
+{
+  char *end;
+  char *text;
+  size_t len;
+  int i;
+
+  memset(out, 0, sizeof(calc_value));
+  out->kind = calc_empty;
+
+  if (!s || !*s) return;
+
+  if (*s == '#')
+  {
+    for (i = 1; i <= calc_error_na; i++)
+    {
+      if (strcmp(s, _calc_errors[i])) continue;
+      calc_set_error(out, (calc_error_code)i);
+      return;
+    }
+  }
+
+  if (!strcmp(s, "TRUE") || !strcmp(s, "FALSE"))
+  {
+    calc_set_bool(out, *s == 'T');
+    return;
+  }
+
+  calc_set_number(out, strtod(s, &end));
+  if (!*end && !isspace((unsigned char)*s)) return;
+
+    // rows of stored sheets are reused, so text is copied
+
+  len = strlen(s);
+  text = calc_alloc(calc, len);
+  if (!text)
+  {
+    calc_set_error(out, calc_error_value);
+    return;
+  }
+
+  memcpy(text, s, len);
+  calc_set_text(out, text, len);
+}
+
+  /**
+   *  @fn static void calc_cell_value(libo_xl_calc *calc,
+   *                                  int sheet,
+   *                                  int row,
+   *                                  int col,
+   *                                  calc_value *out)
+   *
+   *  @brief sets @p out to value of the cell at @p row and @p col of
+   *         @p sheet
+   *
+   *  Formulas give their last result, other cells their contents.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - index of sheet in book
+   *  @param row - index of row
+   *  @param col - index of column
+   *  @param out - receives value
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_cell_value(libo_xl_calc *calc, int sheet, int row, int col, calc_value *out)
+{
+  libo_xl_sheet *xls;
+  libo_xl_cell *cell;
+  string *str;
+  int n;
+
+  memset(out, 0, sizeof(calc_value));
+  out->kind = calc_empty;
+
+  if (!calc_column_is_plain(calc, sheet, col))
+  {
+    n = calc_find(calc, calc_key(sheet, row, col));
+    if ((n >= 0) && calc->node[n].code)
+    {
+      *out = calc->node[n].value;
+      return;
+    }
+  }
+
+  xls = calc_sheet_get(calc, sheet);
+  cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(xls, row), col);
+  if (!cell) return;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      calc_set_number(out, cell->number);
+      break;
+    case libo_xl_cell_type_reference:
+      str = calc->xl->strings ? strings_find_by_id(calc->xl->strings, cell->reference) : NULL;
+      if (str && str->text) calc_set_text(out, str->text, strlen(str->text));
+      break;
+    case libo_xl_cell_type_expression:
+      calc_parse_value(calc, cell->expression.value, out);
+      break;
+    case libo_xl_cell_type_boolean:
+      calc_set_bool(out, cell->boolean);
+      break;
+    case libo_xl_cell_type_error:
+      calc_set_error(out, (calc_error_code)cell->error);
+      break;
+    default:
+      break;
+  }
+}
+
+  /**
+   *  @fn static void calc_scalar(libo_xl_calc *calc, calc_value *v)
+   *
+   *  @brief replaces range @p v by the value of its one cell
+   *
+   *  Ranges of more than one cell give #VALUE!.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param v - value, changed in place
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_scalar(libo_xl_calc *calc, calc_value *v)
+{
+  calc_area area;
+
+  if (v->kind != calc_range) return;
+
+  area = v->area;
+
+  if ((area.r1 != area.r2) || (area.c1 != area.c2))
+    calc_set_error(v, calc_error_value);
+  else
+    calc_cell_value(calc, area.sheet, area.r1, area.c1, v);
+}
+
+  /**
+   *  @fn static calc_error_code calc_to_number(calc_value *v, double *number)
+   *
+   *  @brief converts scalar @p v to a number
+   *
+   *  @param v - value
+   *  @param number - receives number
+   *
+   *  @return error met, @a calc_error_none on success
+   */
+
+static calc_error_code calc_to_number(calc_value *v, double *number)
+{
+  char buffer[LIBO_XL_NUMBER_SIZE];
+  char *end;
+  size_t i, n;
+
+  *number = 0;
+
+  switch (v->kind)
+  {
+    case calc_number:
+    case calc_bool:
+      *number = v->number;
+      return calc_error_none;
+    case calc_empty:
+      return calc_error_none;
+    case calc_error:
+      return v->error;
+    case calc_text:
+      for (i = 0; (i < v->len) && isspace((unsigned char)v->text[i]); i++);
+      for (n = v->len; (n > i) && isspace((unsigned char)v->text[n - 1]); n--);
+      if ((n == i) || (n - i >= sizeof(buffer))) return calc_error_value;
+
+      memcpy(buffer, v->text + i, n - i);
+      buffer[n - i] = 0;
+
+      *number = strtod(buffer, &end);
+      return *end ? calc_error_value : calc_error_none;
+    default:
+      return calc_error_value;
+  }
+}
+
+  /**
+   *  @fn static calc_error_code calc_to_text(libo_xl_calc *calc,
+   *                                          calc_value *v,
+   *                                          const char **text,
+   *                                          size_t *len)
+   *
+   *  @brief converts scalar @p v to text, numbers shown to 15 digits as
+   *         Excel shows them
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param v - value
+   *  @param text - receives text, not terminated
+   *  @param len - receives bytes of text
+   *
+   *  @return error met, @a calc_error_none on success
+   */
+
+static calc_error_code calc_to_text(libo_xl_calc *calc, calc_value *v, const char **text, size_t *len)
+{
+  char *buffer;
+
+  *text = "";
+  *len = 0;
+
+  switch (v->kind)
+  {
+    case calc_text:
+      *text = v->text;
+      *len = v->len;
+      return calc_error_none;
+    case calc_bool:
+      *text = v->number ? "TRUE" : "FALSE";
+      *len = strlen(*text);
+      return calc_error_none;
+    case calc_number:
+      buffer = calc_alloc(calc, LIBO_XL_NUMBER_SIZE);
+      if (!buffer) return calc_error_value;
+      *len = snprintf(buffer, LIBO_XL_NUMBER_SIZE, "%.15g", v->number);
+      *text = buffer;
+      return calc_error_none;
+    case calc_empty:
+      return calc_error_none;
+    case calc_error:
+      return v->error;
+    default:
+      return calc_error_value;
+  }
+}
+
+  /**
+   *  @fn static calc_error_code calc_to_bool(calc_value *v, int *b)
+   *
+   *  @brief converts scalar @p v to a boolean
+   *
+   *  @param v - value
+   *  @param b - receives 1 for TRUE, 0 for FALSE
+   *
+   *  @return error met, @a calc_error_none on success
+   */
+
+static calc_error_code calc_to_bool(calc_value *v, int *b)
+{
+  *b = 0;
+
+  switch (v->kind)
+  {
+    case calc_number:
+    case calc_bool:
+      *b = (v->number != 0);
+      return calc_error_none;
+    case calc_empty:
+      return calc_error_none;
+    case calc_error:
+      return v->error;
+    case calc_text:
+      if ((v->len == 4) && !strncasecmp(v->text, "TRUE", 4)) *b = 1;
+      else if ((v->len != 5) || strncasecmp(v->text, "FALSE", 5)) return calc_error_value;
+      return calc_error_none;
+    default:
+      return calc_error_value;
+  }
+}
+
+  /**
+   *  @fn static int calc_text_compare(const char *a, size_t na, const char *b, size_t nb)
+   *
+   *  @brief compares texts ignoring case
+   *
+   *  @param a - first text
+   *  @param na - bytes of @p a
+   *  @param b - second text
+   *  @param nb - bytes of @p b
+   *
+   *  @return -1, 0, or 1 as @p a is less than, equal to, or greater than @p b
+   */
+
+static int calc_text_compare(const char *a, size_t na, const char *b, size_t nb)
+{
+  int ca, cb;
+  size_t i;
+
+  for (i = 0; (i < na) && (i < nb); i++)
+  {
+    ca = tolower((unsigned char)a[i]);
+    cb = tolower((unsigned char)b[i]);
+    if (ca != cb) return (ca > cb) - (ca < cb);
+  }
+
+  return (na > nb) - (na < nb);
+}
+
+  /**
+   *  @fn static int calc_compare(calc_value *a, calc_value *b)
+   *
+   *  @brief compares scalars @p a and @p b as Excel does
+   *
+   *  Numbers sort before text, and text before booleans.  Empty values
+   *  take the kind of the other value, as 0, "" or FALSE.
+   *
+   *  @param a - first value, not an error
+   *  @param b - second value, not an error
+   *
+   *  @return -1, 0, or 1 as @p a is less than, equal to, or greater than @p b
+   */
+
+static int calc_compare(calc_value *a, calc_value *b)
+{
+  calc_kind ka = a->kind;
+  calc_kind kb = b->kind;
+  int ra, rb;
+
+  if (ka == calc_empty) ka = (kb == calc_empty) ? calc_number : kb;
+  if (kb == calc_empty) kb = ka;
+
+  ra = (ka == calc_number) ? 0 : (ka == calc_text) ? 1 : 2;
+  rb = (kb == calc_number) ? 0 : (kb == calc_text) ? 1 : 2;
+  if (ra != rb) return (ra > rb) - (ra < rb);
+
+  if (ka == calc_text)
+    return calc_text_compare(a->kind == calc_text ? a->text : "",
+                             a->kind == calc_text ? a->len : 0,
+                             b->kind == calc_text ? b->text : "",
+                             b->kind == calc_text ? b->len : 0);
+
+  return (a->number > b->number) - (a->number < b->number);
+}
+
+  /**
+   *  @fn static int calc_wildcard(const char *p, size_t np, const char *t, size_t nt)
+   *
+   *  @brief matches text @p t against pattern @p p ignoring case, where *
+   *         matches any text, ? any one character and ~ escapes either
+   *
+   *  @param p - pattern
+   *  @param np - bytes of @p p
+   *  @param t - text
+   *  @param nt - bytes of @p t
+   *
+   *  @return 1 if text matches, 0 if not
+   */
+
+static int calc_wildcard(const char *p, size_t np, const char *t, size_t nt)
+{
+  size_t i = 0, j = 0;
+  size_t star = (size_t)-1, mark = 0;
+  size_t k;
+
+  while (j < nt)
+  {
+    if ((i < np) && (p[i] == '*'))
+    {
+      star = i++;
+      mark = j;
+      continue;
+    }
+
+    if (i < np)
+    {
+      k = ((p[i] == '~') && (i + 1 < np)) ? i + 1 : i;
+      if (((p[i] == '?') && (k == i)) || (tolower((unsigned char)p[k]) == tolower((unsigned char)t[j])))
+      {
+        i = k + 1;
+        j++;
+        continue;
+      }
+    }
+
+    if (star == (size_t)-1) return 0;
+
+    i = star + 1;
+    j = ++mark;
+  }
+
+  while ((i < np) && (p[i] == '*')) i++;
+
+  return i == np;
+}
+
+  /**
+   *  @fn static void calc_arith(libo_xl_calc *calc, calc_op op, calc_value *a, calc_value *b)
+   *
+   *  @brief applies arithmetic operator @p op to @p a and @p b, leaving
+   *         the result in @p a
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param op - operator, @a calc_op_add to @a calc_op_power
+   *  @param a - left operand, receives result
+   *  @param b - right operand
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_arith(libo_xl_calc *calc, calc_op op, calc_value *a, calc_value *b)
+{
+  calc_error_code error;
+  double x, y, r;
+
+  calc_scalar(calc, a);
+  calc_scalar(calc, b);
+
+  error = calc_to_number(a, &x);
+  if (!error) error = calc_to_number(b, &y);
+  if (error)
+  {
+    calc_set_error(a, error);
+    return;
+  }
+
+  switch (op)
+  {
+    case calc_op_add: r = x + y; break;
+    case calc_op_subtract: r = x - y; break;
+    case calc_op_multiply: r = x * y; break;
+    case calc_op_divide:
+      if (y == 0)
+      {
+        calc_set_error(a, calc_error_div0);
+        return;
+      }
+      r = x / y;
+      break;
+    default:
+      if ((x == 0) && (y <= 0))
+      {
+        calc_set_error(a, (y == 0) ? calc_error_num : calc_error_div0);
+        return;
+      }
+      r = pow(x, y);
+      break;
+  }
+
+  if (!isfinite(r))
+    calc_set_error(a, calc_error_num);
+  else
+    calc_set_number(a, r);
+}
+
+  /**
+   *  @fn static void calc_concat(libo_xl_calc *calc, calc_value *a, calc_value *b)
+   *
+   *  @brief joins @p a and @p b as text, leaving the result in @p a
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param a - left operand, receives result
+   *  @param b - right operand
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_concat(libo_xl_calc *calc, calc_value *a, calc_value *b)
+{
+  calc_error_code error;
+  const char *ta, *tb;
+  size_t na, nb;
+  char *text;
+
+  calc_scalar(calc, a);
+  calc_scalar(calc, b);
+
+  error = calc_to_text(calc, a, &ta, &na);
+  if (!error) error = calc_to_text(calc, b, &tb, &nb);
+  if (error)
+  {
+    calc_set_error(a, error);
+    return;
+  }
+
+  text = calc_alloc(calc, na + nb ? na + nb : 1);
+  if (!text)
+  {
+    calc_set_error(a, calc_error_value);
+    return;
+  }
+
+  memcpy(text, ta, na);
+  memcpy(text + na, tb, nb);
+  calc_set_text(a, text, na + nb);
+}
+
+  /**
+   *  @fn static void calc_relate(libo_xl_calc *calc, calc_op op, calc_value *a, calc_value *b)
+   *
+   *  @brief compares @p a and @p b by @p op, leaving the result in @p a
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param op - operator, @a calc_op_eq to @a calc_op_ge
+   *  @param a - left operand, receives result
+   *  @param b - right operand
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_relate(libo_xl_calc *calc, calc_op op, calc_value *a, calc_value *b)
+{
+  int c;
+
+  calc_scalar(calc, a);
+  calc_scalar(calc, b);
+
+  if (a->kind == calc_error) return;
+  if (b->kind == calc_error)
+  {
+    *a = *b;
+    return;
+  }
+
+  c = calc_compare(a, b);
+
+  switch (op)
+  {
+    case calc_op_eq: calc_set_bool(a, c == 0); break;
+    case calc_op_ne: calc_set_bool(a, c != 0); break;
+    case calc_op_lt: calc_set_bool(a, c < 0); break;
+    case calc_op_le: calc_set_bool(a, c <= 0); break;
+    case calc_op_gt: calc_set_bool(a, c > 0); break;
+    default: calc_set_bool(a, c >= 0); break;
+  }
+}
+
+  /**
+   *  @fn static void calc_eval(libo_xl_calc *calc, int n)
+   *
+   *  @brief runs the code of node @p n, setting its result
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param n - index of node
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_eval(libo_xl_calc *calc, int n)
+{
+  calc_node *node = &calc->node[n];
+  const unsigned char *ip;
+  calc_value *sp = calc->stack;
+  calc_value out;
+  int cell[3];
+  int len;
+  int id, argc;
+
+  calc_arena_reset(calc);
+
+  if (!node->code)
+  {
+    calc_result_set(node, NULL);
+    return;
+  }
+
+  for (ip = node->code; ip < node->code + node->n_code; ip += calc_instr_size(ip))
+  {
+    switch ((calc_op)*ip)
+    {
+      case calc_op_number:
+        memset(sp, 0, sizeof(calc_value));
+        sp->kind = calc_number;
+        memcpy(&sp->number, ip + 1, sizeof(double));
+        ++sp;
+        break;
+      case calc_op_text:
+        memcpy(&len, ip + 1, sizeof(int));
+        calc_set_text(sp++, (const char *)ip + 1 + sizeof(int), len);
+        break;
+      case calc_op_bool:
+        calc_set_bool(sp++, ip[1]);
+        break;
+      case calc_op_error:
+        calc_set_error(sp++, (calc_error_code)ip[1]);
+        break;
+      case calc_op_empty:
+        memset(sp, 0, sizeof(calc_value));
+        sp->kind = calc_empty;
+        ++sp;
+        break;
+      case calc_op_cell:
+        memcpy(cell, ip + 1, sizeof(cell));
+        calc_cell_value(calc, cell[0], cell[1], cell[2], sp++);
+        break;
+      case calc_op_range:
+        memset(sp, 0, sizeof(calc_value));
+        sp->kind = calc_range;
+        memcpy(&sp->area, ip + 1, sizeof(calc_area));
+        ++sp;
+        break;
+      case calc_op_negate:
+      case calc_op_percent:
+        calc_set_number(&out, (*ip == calc_op_negate) ? -1 : 0.01);
+        calc_arith(calc, calc_op_multiply, sp - 1, &out);
+        break;
+      case calc_op_add:
+      case calc_op_subtract:
+      case calc_op_multiply:
+      case calc_op_divide:
+      case calc_op_power:
+        --sp;
+        calc_arith(calc, (calc_op)*ip, sp - 1, sp);
+        break;
+      case calc_op_concat:
+        --sp;
+        calc_concat(calc, sp - 1, sp);
+        break;
+      case calc_op_eq:
+      case calc_op_ne:
+      case calc_op_lt:
+      case calc_op_le:
+      case calc_op_gt:
+      case calc_op_ge:
+        --sp;
+        calc_relate(calc, (calc_op)*ip, sp - 1, sp);
+        break;
+      case calc_op_call:
+        id = ip[1];
+        argc = ip[2];
+        sp -= argc;
+
+        if (id == 255)
+          calc_set_error(&out, calc_error_name);
+        else if ((argc < _calc_builtins[id].min_args) || (argc > _calc_builtins[id].max_args))
+          calc_set_error(&out, calc_error_value);
+        else
+          _calc_builtins[id].call(calc, sp, argc, &out);
+
+        *sp++ = out;
+        break;
+    }
+  }
+
+    // a formula showing an empty cell shows 0
+
+  out = calc->stack[0];
+  calc_scalar(calc, &out);
+  if (out.kind == calc_empty) calc_set_number(&out, 0);
+
+  calc_result_set(node, &out);
+}
+
+  /**
+   *  @fn static void calc_result_set(calc_node *node, calc_value *value)
+   *
+   *  @brief sets result of @p node to @p value, keeping a copy of its text
+   *
+   *  @param node - pointer to node
+   *  @param value - scalar result, or NULL for an empty result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_result_set(calc_node *node, calc_value *value)
+{
+  char *text = NULL;
+
+  if (value && (value->kind == calc_text))
+  {
+    text = (char *)malloc(value->len + 1);
+    if (text)
+    {
+      memcpy(text, value->text, value->len);
+      text[value->len] = 0;
+    }
+  }
+
+  free(node->text);
+  node->text = text;
+
+  if (!value)
+  {
+    memset(&node->value, 0, sizeof(calc_value));
+    node->value.kind = calc_empty;
+  }
+  else if ((value->kind == calc_text) && !text)
+    calc_set_error(&node->value, calc_error_value);
+  else
+  {
+    node->value = *value;
+    if (text) node->value.text = text;
+  }
+}
+
+  /**
+   *  @fn static const char *calc_format(calc_value *v, char *buffer, size_t size)
+   *
+   *  @brief writes scalar @p v as the value of an expression cell
+   *
+   *  Numbers are written with the fewest digits that read back the same.
+   *
+   *  @param v - value
+   *  @param buffer - receives text, at least @a LIBO_XL_NUMBER_SIZE bytes
+   *  @param size - bytes of @p buffer
+   *
+   *  @return text, @p buffer or a constant
+   */
+
+static const char *calc_format(calc_value *v, char *buffer, size_t size)
+{
+  switch (v->kind)
+  {
+    case calc_number:
+      snprintf(buffer, size, "%.15g", v->number);
+      if (strtod(buffer, NULL) != v->number) snprintf(buffer, size, "%.17g", v->number);
+      return buffer;
+    case calc_text:
+      return v->text;
+    case calc_bool:
+      return v->number ? "TRUE" : "FALSE";
+    case calc_error:
+      return _calc_errors[v->error];
+    default:
+      return "";
+  }
+}
+
+  /**
+   *  @fn static void calc_store(libo_xl_calc *calc, int n)
+   *
+   *  @brief writes result of node @p n into the value of its cell
+   *
+   *  The version of the sheet is left alone, as results are not seen by
+   *  indexes.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param n - index of node
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_store(libo_xl_calc *calc, int n)
+{
+  char buffer[LIBO_XL_NUMBER_SIZE];
+  calc_node *node = &calc->node[n];
+  libo_xl_sheet *sheet;
+  libo_xl_cell *cell;
+  const char *value;
+
+  if (!node->code) return;
+
+  sheet = calc_sheet_get(calc, node->sheet);
+  cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, node->row), node->col);
+  if (!cell || (cell->type != libo_xl_cell_type_expression)) return;
+
+  value = calc_format(&node->value, buffer, sizeof(buffer));
+  if (cell->expression.value && !strcmp(cell->expression.value, value)) return;
+
+  libo_xl_cell_expression_set_value(&cell->expression, (char *)value);
+  sheet->dirty = 1;
+}
+
+  /**
+   *  @fn static calc_error_code calc_arg_number(libo_xl_calc *calc, calc_value *arg, double *number)
+   *
+   *  @brief converts argument @p arg to a number
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - argument, changed to a scalar
+   *  @param number - receives number
+   *
+   *  @return error met, @a calc_error_none on success
+   */
+
+static calc_error_code calc_arg_number(libo_xl_calc *calc, calc_value *arg, double *number)
+{
+  calc_scalar(calc, arg);
+
+  return calc_to_number(arg, number);
+}
+
+  /**
+   *  @fn static void calc_aggregate_number(calc_aggregate *agg, double number)
+   *
+   *  @brief adds @p number to @p agg
+   *
+   *  @param agg - pointer to aggregates
+   *  @param number - number
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_aggregate_number(calc_aggregate *agg, double number)
+{
+  if (!agg->count || (number < agg->min)) agg->min = number;
+  if (!agg->count || (number > agg->max)) agg->max = number;
+
+  agg->sum += number;
+  agg->product *= number;
+  ++agg->count;
+}
+
+  /**
+   *  @fn static void calc_aggregate_value(calc_aggregate *agg, calc_value *v, int direct)
+   *
+   *  @brief adds @p v to @p agg
+   *
+   *  Values given directly as arguments count booleans and text holding
+   *  numbers; values of ranges count numbers only.  Errors are kept.
+   *
+   *  @param agg - pointer to aggregates
+   *  @param v - scalar value
+   *  @param direct - 1 if @p v is an argument, 0 if a cell of a range
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_aggregate_value(calc_aggregate *agg, calc_value *v, int direct)
+{
+  calc_error_code error;
+  double number;
+
+  if (v->kind == calc_empty) return;
+
+  ++agg->values;
+
+  switch (v->kind)
+  {
+    case calc_number:
+      calc_aggregate_number(agg, v->number);
+      break;
+    case calc_bool:
+      if (direct) calc_aggregate_number(agg, v->number);
+      break;
+    case calc_text:
+      if (!direct) break;
+      error = calc_to_number(v, &number);
+      if (!error) calc_aggregate_number(agg, number);
+      else if (!agg->error) agg->error = error;
+      break;
+    case calc_error:
+      if (!agg->error) agg->error = v->error;
+      break;
+    default:
+      break;
+  }
+}
+
+  /**
+   *  @fn static int calc_area_rows(libo_xl_calc *calc, calc_area *area)
+   *
+   *  @brief returns last row of @p area holding cells, so whole columns are
+   *         not walked past the end of their sheet
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param area - cells
+   *
+   *  @return index of last row, less than r1 of @p area if none
+   */
+
+static int calc_area_rows(libo_xl_calc *calc, calc_area *area)
+{
+  libo_xl_sheet *sheet;
+
+  sheet = calc_sheet_get(calc, area->sheet);
+  if (!sheet) return area->r1 - 1;
+
+  return (area->r2 < sheet->n_rows) ? area->r2 : sheet->n_rows - 1;
+}
+
+  /**
+   *  @fn static void calc_aggregate_range(libo_xl_calc *calc, calc_area *area, calc_aggregate *agg)
+   *
+   *  @brief adds the cells of @p area to @p agg
+   *
+   *  Columns holding no formulas are handed whole to the column kernels,
+   *  unless @p agg needs more than they give.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param area - cells
+   *  @param agg - pointer to aggregates
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_aggregate_range(libo_xl_calc *calc, calc_area *area, calc_aggregate *agg)
+{
+  libo_xl_column_stats stats;
+  libo_xl_sheet *sheet;
+  calc_value v;
+  int last;
+  int r, c;
+
+  sheet = calc_sheet_get(calc, area->sheet);
+  last = calc_area_rows(calc, area);
+
+  for (c = area->c1; c <= area->c2; c++)
+  {
+    if (!agg->full && calc_column_is_plain(calc, area->sheet, c) &&
+        !libo_xl_sheet_column_stats_range(sheet, c, area->r1, last, &stats))
+    {
+      if (!stats.count) continue;
+
+      if (!agg->count || (stats.min < agg->min)) agg->min = stats.min;
+      if (!agg->count || (stats.max > agg->max)) agg->max = stats.max;
+      agg->sum += stats.sum;
+      agg->count += stats.count;
+      continue;
+    }
+
+    for (r = area->r1; r <= last; r++)
+    {
+      calc_cell_value(calc, area->sheet, r, c, &v);
+      calc_aggregate_value(agg, &v, 0);
+    }
+  }
+}
+
+  /**
+   *  @fn static void calc_aggregate_args(libo_xl_calc *calc,
+   *                                      calc_value *arg,
+   *                                      int n,
+   *                                      int full,
+   *                                      calc_aggregate *agg)
+   *
+   *  @brief sets @p agg to the aggregates of @p n arguments @p arg
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param full - 1 if product and count of values are needed
+   *  @param agg - receives aggregates
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_aggregate_args(libo_xl_calc *calc, calc_value *arg, int n, int full, calc_aggregate *agg)
+{
+  int i;
+
+  memset(agg, 0, sizeof(calc_aggregate));
+  agg->product = 1;
+  agg->full = full;
+
+  for (i = 0; i < n; i++)
+  {
+    if (arg[i].kind == calc_range)
+      calc_aggregate_range(calc, &arg[i].area, agg);
+    else
+      calc_aggregate_value(agg, &arg[i], 1);
+  }
+}
+
+  /**
+   *  @fn static void calc_fn_sum(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief SUM(value, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_sum(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_aggregate agg;
+
+  calc_aggregate_args(calc, arg, n, 0, &agg);
+
+  if (agg.error) calc_set_error(out, agg.error);
+  else calc_set_number(out, agg.sum);
+}
+
+  /**
+   *  @fn static void calc_fn_average(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief AVERAGE(value, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_average(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_aggregate agg;
+
+  calc_aggregate_args(calc, arg, n, 0, &agg);
+
+  if (agg.error) calc_set_error(out, agg.error);
+  else if (!agg.count) calc_set_error(out, calc_error_div0);
+  else calc_set_number(out, agg.sum / agg.count);
+}
+
+  /**
+   *  @fn static void calc_fn_min(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief MIN(value, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_min(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_aggregate agg;
+
+  calc_aggregate_args(calc, arg, n, 0, &agg);
+
+  if (agg.error) calc_set_error(out, agg.error);
+  else calc_set_number(out, agg.count ? agg.min : 0);
+}
+
+  /**
+   *  @fn static void calc_fn_max(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief MAX(value, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_max(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_aggregate agg;
+
+  calc_aggregate_args(calc, arg, n, 0, &agg);
+
+  if (agg.error) calc_set_error(out, agg.error);
+  else calc_set_number(out, agg.count ? agg.max : 0);
+}
+
+  /**
+   *  @fn static void calc_fn_product(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief PRODUCT(value, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_product(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_aggregate agg;
+
+  calc_aggregate_args(calc, arg, n, 1, &agg);
+
+  if (agg.error) calc_set_error(out, agg.error);
+  else calc_set_number(out, agg.count ? agg.product : 0);
+}
+
+  /**
+   *  @fn static void calc_fn_count(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief COUNT(value, ...), errors are not counted
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_count(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_aggregate agg;
+
+  calc_aggregate_args(calc, arg, n, 0, &agg);
+
+  calc_set_number(out, agg.count);
+}
+
+  /**
+   *  @fn static void calc_fn_counta(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief COUNTA(value, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_counta(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_aggregate agg;
+
+  calc_aggregate_args(calc, arg, n, 1, &agg);
+
+  calc_set_number(out, agg.values);
+}
+
+  /**
+   *  @fn static libo_xl_sorted_index *calc_sorted(libo_xl_calc *calc, int sheet, int col)
+   *
+   *  @brief returns sorted index of column @p col of @p sheet, building it
+   *         on first use and again once the sheet changes
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - index of sheet in book
+   *  @param col - index of column
+   *
+   *  @return pointer to @a libo_xl_sorted_index, NULL if the column holds
+   *          values the index does not see, or on failure
+   */
+
+static libo_xl_sorted_index *calc_sorted(libo_xl_calc *calc, int sheet, int col)
+{
+  calc_column *column;
+  libo_xl_sheet *xls;
+
+  if (!calc_column_is_plain(calc, sheet, col)) return NULL;
+
+  xls = calc_sheet_get(calc, sheet);
+  column = calc_column_get(calc, sheet, col);
+  if (!xls || !column) return NULL;
+
+  if (column->sorted && libo_xl_sorted_index_is_stale(column->sorted))
+  {
+    libo_xl_sorted_index_free(column->sorted);
+    column->sorted = NULL;
+  }
+
+  if (!column->sorted) column->sorted = libo_xl_sorted_index_build(calc->xl, xls, col);
+
+  return column->sorted;
+}
+
+  /**
+   *  @fn static int calc_sorted_key(libo_xl_calc *calc,
+   *                                 libo_xl_sorted_index *idx,
+   *                                 calc_value *v,
+   *                                 sorted_entry *key)
+   *
+   *  @brief sets @p key to the sort key of @p v in @p idx
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param v - number or text
+   *  @param key - receives key
+   *
+   *  @return 0 on success, -1 if @p v cannot be looked up in @p idx
+   */
+
+static int calc_sorted_key(libo_xl_calc *calc, libo_xl_sorted_index *idx, calc_value *v, sorted_entry *key)
+{
+  char *text;
+
+  if (v->kind == calc_number)
+  {
+    key->kind = 0;
+    key->key = (v->number == 0) ? 0 : v->number;
+    return 0;
+  }
+
+  if ((v->kind != calc_text) || !idx->rank) return -1;
+
+  text = calc_alloc(calc, v->len + 1);
+  if (!text) return -1;
+
+  memcpy(text, v->text, v->len);
+  text[v->len] = 0;
+  sorted_text_key(idx, text, key);
+
+  return 0;
+}
+
+  /**
+   *  @fn static int calc_match(libo_xl_calc *calc, calc_value *v, calc_area *area, int type)
+   *
+   *  @brief returns position of @p v in the row or column @p area, as
+   *         MATCH does for match @p type
+   *
+   *  Columns holding no formulas are searched through their sorted index,
+   *  so both exact matches and matches of the largest value not greater
+   *  than @p v are found without a scan.  Text is matched ignoring case.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param v - scalar to find, not an error
+   *  @param area - one row or column of cells
+   *  @param type - 0 for exact match, 1 for largest value not greater,
+   *                -1 for smallest value not less
+   *
+   *  @return position from 0, -1 if not found
+   */
+
+static int calc_match(libo_xl_calc *calc, calc_value *v, calc_area *area, int type)
+{
+  libo_xl_sorted_index *idx;
+  sorted_entry key;
+  calc_value cell;
+  int vertical = (area->c1 == area->c2);
+  int wildcards = 0;
+  int found = -1;
+  int pos, end, last;
+  int i, c;
+
+  if (v->kind == calc_empty) return -1;
+
+  if (v->kind == calc_text)
+    wildcards = (memchr(v->text, '*', v->len) || memchr(v->text, '?', v->len)) && !type;
+
+  if (vertical && (type >= 0) && !wildcards &&
+      (idx = calc_sorted(calc, area->sheet, area->c1)) &&
+      !calc_sorted_key(calc, idx, v, &key))
+  {
+    if (!type)
+    {
+      end = sorted_bound(idx, &key, 1);
+      for (pos = sorted_bound(idx, &key, 0); pos < end; pos++)
+      {
+        if ((idx->entry[pos].row >= area->r1) && (idx->entry[pos].row <= area->r2))
+          return idx->entry[pos].row - area->r1;
+      }
+      return -1;
+    }
+
+    for (pos = sorted_bound(idx, &key, 1) - 1; (pos >= 0) && (idx->entry[pos].kind == key.kind); pos--)
+    {
+      if ((idx->entry[pos].row >= area->r1) && (idx->entry[pos].row <= area->r2))
+        return idx->entry[pos].row - area->r1;
+    }
+    return -1;
+  }
+
+  last = vertical ? calc_area_rows(calc, area) - area->r1 : area->c2 - area->c1;
+
+  for (i = 0; i <= last; i++)
+  {
+    if (vertical) calc_cell_value(calc, area->sheet, area->r1 + i, area->c1, &cell);
+    else calc_cell_value(calc, area->sheet, area->r1, area->c1 + i, &cell);
+
+    if (wildcards)
+    {
+      if ((cell.kind == calc_text) && calc_wildcard(v->text, v->len, cell.text, cell.len)) return i;
+      continue;
+    }
+
+    if (cell.kind != v->kind) continue;
+
+    c = calc_compare(&cell, v);
+
+      // approximate matches assume sorted cells, and stop past the value
+
+    if (!type)
+    {
+      if (!c) return i;
+    }
+    else if (c * type <= 0)
+      found = i;
+    else
+      break;
+  }
+
+  return found;
+}
+
+  /**
+   *  @fn static void calc_fn_match(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief MATCH(value, range, [type])
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_match(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_error_code error;
+  double type = 1;
+  int pos;
+
+  calc_scalar(calc, &arg[0]);
+  if (arg[0].kind == calc_error)
+  {
+    *out = arg[0];
+    return;
+  }
+
+  if ((n > 2) && (error = calc_arg_number(calc, &arg[2], &type)))
+  {
+    calc_set_error(out, error);
+    return;
+  }
+
+  if ((arg[1].kind != calc_range) || ((arg[1].area.r1 != arg[1].area.r2) && (arg[1].area.c1 != arg[1].area.c2)))
+  {
+    calc_set_error(out, calc_error_na);
+    return;
+  }
+
+  pos = calc_match(calc, &arg[0], &arg[1].area, (type > 0) - (type < 0));
+
+  if (pos < 0) calc_set_error(out, calc_error_na);
+  else calc_set_number(out, pos + 1);
+}
+
+  /**
+   *  @fn static void calc_lookup(libo_xl_calc *calc,
+   *                              calc_value *arg,
+   *                              int n,
+   *                              int vertical,
+   *                              calc_value *out)
+   *
+   *  @brief looks up @p arg[0] in the first column, or row, of table
+   *         @p arg[1], giving the cell @p arg[2] columns, or rows, across
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param vertical - 1 for VLOOKUP, 0 for HLOOKUP
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_lookup(libo_xl_calc *calc, calc_value *arg, int n, int vertical, calc_value *out)
+{
+  calc_error_code error;
+  calc_area area;
+  double index;
+  int approx = 1;
+  int pos;
+
+  calc_scalar(calc, &arg[0]);
+  if (arg[0].kind == calc_error)
+  {
+    *out = arg[0];
+    return;
+  }
+
+  if ((error = calc_arg_number(calc, &arg[2], &index)))
+  {
+    calc_set_error(out, error);
+    return;
+  }
+
+  if (n > 3)
+  {
+    calc_scalar(calc, &arg[3]);
+    if ((error = calc_to_bool(&arg[3], &approx)))
+    {
+      calc_set_error(out, error);
+      return;
+    }
+  }
+
+  if (arg[1].kind != calc_range)
+  {
+    calc_set_error(out, calc_error_na);
+    return;
+  }
+
+  area = arg[1].area;
+
+  if (index < 1)
+  {
+    calc_set_error(out, calc_error_value);
+    return;
+  }
+
+  if (index > (vertical ? area.c2 - area.c1 : area.r2 - area.r1) + 1)
+  {
+    calc_set_error(out, calc_error_ref);
+    return;
+  }
+
+  if (vertical) area.c2 = area.c1;
+  else area.r2 = area.r1;
+
+  pos = calc_match(calc, &arg[0], &area, approx ? 1 : 0);
+  if (pos < 0)
+  {
+    calc_set_error(out, calc_error_na);
+    return;
+  }
+
+  if (vertical)
+    calc_cell_value(calc, area.sheet, area.r1 + pos, area.c1 + (int)index - 1, out);
+  else
+    calc_cell_value(calc, area.sheet, area.r1 + (int)index - 1, area.c1 + pos, out);
+}
+
+  /**
+   *  @fn static void calc_fn_vlookup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief VLOOKUP(value, table, column, [approximate])
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_vlookup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_lookup(calc, arg, n, 1, out);
+}
+
+  /**
+   *  @fn static void calc_fn_hlookup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief HLOOKUP(value, table, row, [approximate])
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_hlookup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_lookup(calc, arg, n, 0, out);
+}
+
+  /**
+   *  @fn static void calc_fn_index(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief INDEX(range, row, [column]), row or column 0 giving the whole
+   *         column or row
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_index(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_error_code error;
+  calc_area area;
+  double row, col = 0;
+
+  if ((error = calc_arg_number(calc, &arg[1], &row)) ||
+      ((n > 2) && (error = calc_arg_number(calc, &arg[2], &col))))
+  {
+    calc_set_error(out, error);
+    return;
+  }
+
+  if (arg[0].kind != calc_range)
+  {
+    calc_scalar(calc, &arg[0]);
+    if ((row > 1) || (col > 1)) calc_set_error(out, calc_error_ref);
+    else *out = arg[0];
+    return;
+  }
+
+  area = arg[0].area;
+
+    // one index into a single row counts across it
+
+  if ((n < 3) && (area.r1 == area.r2))
+  {
+    col = row;
+    row = 1;
+  }
+
+  if ((row < 0) || (col < 0))
+  {
+    calc_set_error(out, calc_error_value);
+    return;
+  }
+
+  if ((row > area.r2 - area.r1 + 1) || (col > area.c2 - area.c1 + 1))
+  {
+    calc_set_error(out, calc_error_ref);
+    return;
+  }
+
+  if (row >= 1) area.r1 = area.r2 = area.r1 + (int)row - 1;
+  if (col >= 1) area.c1 = area.c2 = area.c1 + (int)col - 1;
+
+  memset(out, 0, sizeof(calc_value));
+  out->kind = calc_range;
+  out->area = area;
+}
+
+  /**
+   *  @fn static void calc_criteria_parse(calc_value *v, calc_criteria *cr)
+   *
+   *  @brief sets @p cr to the condition @p v of COUNTIF or SUMIF, such as
+   *         3, "apple", ">=10" or "a*"
+   *
+   *  @param v - scalar condition
+   *  @param cr - receives condition
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_criteria_parse(calc_value *v, calc_criteria *cr)
+{
+  const char *p;
+  double number;
+  size_t n;
+  int b;
+
+  memset(cr, 0, sizeof(calc_criteria));
+  cr->op = calc_op_eq;
+  cr->value = *v;
+
+  if (v->kind == calc_empty) calc_set_number(&cr->value, 0);
+  if (v->kind != calc_text) return;
+
+  p = v->text;
+  n = v->len;
+
+  if ((n >= 2) && (p[0] == '<') && (p[1] == '=')) cr->op = calc_op_le;
+  else if ((n >= 2) && (p[0] == '>') && (p[1] == '=')) cr->op = calc_op_ge;
+  else if ((n >= 2) && (p[0] == '<') && (p[1] == '>')) cr->op = calc_op_ne;
+  else if ((n >= 1) && (p[0] == '<')) cr->op = calc_op_lt;
+  else if ((n >= 1) && (p[0] == '>')) cr->op = calc_op_gt;
+  else if ((n >= 1) && (p[0] == '=')) cr->op = calc_op_eq;
+
+  if ((cr->op == calc_op_le) || (cr->op == calc_op_ge) || (cr->op == calc_op_ne)) n -= 2, p += 2;
+  else if ((cr->op != calc_op_eq) || ((n >= 1) && (p[0] == '='))) n -= 1, p += 1;
+
+  calc_set_text(&cr->value, p, n);
+
+  if (!n)
+    cr->value.kind = calc_empty;
+  else if (!calc_to_number(&cr->value, &number))
+    calc_set_number(&cr->value, number);
+  else if (!calc_to_bool(&cr->value, &b))
+    calc_set_bool(&cr->value, b);
+  else
+    cr->wildcards = memchr(p, '*', n) || memchr(p, '?', n);
+}
+
+  /**
+   *  @fn static int calc_criteria_match(calc_criteria *cr, calc_value *v)
+   *
+   *  @brief tells whether scalar @p v meets condition @p cr
+   *
+   *  @param cr - condition
+   *  @param v - scalar value
+   *
+   *  @return 1 if @p v meets @p cr, 0 if not
+   */
+
+static int calc_criteria_match(calc_criteria *cr, calc_value *v)
+{
+  int match;
+  int c;
+
+  if (cr->value.kind == calc_empty)
+  {
+    match = (v->kind == calc_empty) || ((v->kind == calc_text) && !v->len);
+    return (cr->op == calc_op_ne) ? !match : (cr->op == calc_op_eq) ? match : 0;
+  }
+
+  if (cr->wildcards && ((cr->op == calc_op_eq) || (cr->op == calc_op_ne)))
+  {
+    match = (v->kind == calc_text) && calc_wildcard(cr->value.text, cr->value.len, v->text, v->len);
+    return (cr->op == calc_op_ne) ? !match : match;
+  }
+
+  if ((v->kind != cr->value.kind) || ((v->kind == calc_error) && (v->error != cr->value.error)))
+    return cr->op == calc_op_ne;
+
+  c = (v->kind == calc_error) ? 0 : calc_compare(v, &cr->value);
+
+  switch (cr->op)
+  {
+    case calc_op_eq: return c == 0;
+    case calc_op_ne: return c != 0;
+    case calc_op_lt: return c < 0;
+    case calc_op_le: return c <= 0;
+    case calc_op_gt: return c > 0;
+    default: return c >= 0;
+  }
+}
+
+  /**
+   *  @fn static void calc_conditional(libo_xl_calc *calc,
+   *                                   calc_value *arg,
+   *                                   int n,
+   *                                   int sum,
+   *                                   calc_value *out)
+   *
+   *  @brief counts, or sums, the cells of range @p arg[0] meeting condition
+   *         @p arg[1]
+   *
+   *  Equality with a number or text on a column holding no formulas finds
+   *  its rows through the sorted index of the column.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param sum - 1 for SUMIF, 0 for COUNTIF
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_conditional(libo_xl_calc *calc, calc_value *arg, int n, int sum, calc_value *out)
+{
+  libo_xl_sorted_index *idx;
+  calc_error_code error = calc_error_none;
+  calc_criteria cr;
+  sorted_entry key;
+  calc_area area, target;
+  calc_value v;
+  double total = 0;
+  long count = 0;
+  int pos, end, last;
+  int r, c;
+
+  calc_scalar(calc, &arg[1]);
+
+  if ((arg[0].kind != calc_range) || ((n > 2) && (arg[2].kind != calc_range)))
+  {
+    calc_set_error(out, calc_error_value);
+    return;
+  }
+
+  calc_criteria_parse(&arg[1], &cr);
+
+  area = arg[0].area;
+  target = (n > 2) ? arg[2].area : area;
+
+  if ((cr.op == calc_op_eq) && !cr.wildcards && (area.c1 == area.c2) &&
+      ((cr.value.kind == calc_number) || (cr.value.kind == calc_text)) &&
+      (idx = calc_sorted(calc, area.sheet, area.c1)) &&
+      !calc_sorted_key(calc, idx, &cr.value, &key))
+  {
+    end = sorted_bound(idx, &key, 1);
+
+    for (pos = sorted_bound(idx, &key, 0); pos < end; pos++)
+    {
+      r = idx->entry[pos].row;
+      if ((r < area.r1) || (r > area.r2)) continue;
+
+      ++count;
+      if (!sum) continue;
+
+      calc_cell_value(calc, target.sheet, target.r1 + r - area.r1, target.c1, &v);
+      if (v.kind == calc_number) total += v.number;
+      else if ((v.kind == calc_error) && !error) error = v.error;
+    }
+  }
+  else
+  {
+    last = calc_area_rows(calc, &area);
+
+    for (c = area.c1; c <= area.c2; c++)
+    {
+      for (r = area.r1; r <= last; r++)
+      {
+        calc_cell_value(calc, area.sheet, r, c, &v);
+        if (!calc_criteria_match(&cr, &v)) continue;
+
+        ++count;
+        if (!sum) continue;
+
+        calc_cell_value(calc, target.sheet, target.r1 + r - area.r1, target.c1 + c - area.c1, &v);
+        if (v.kind == calc_number) total += v.number;
+        else if ((v.kind == calc_error) && !error) error = v.error;
+      }
+    }
+  }
+
+  if (error) calc_set_error(out, error);
+  else calc_set_number(out, sum ? total : count);
+}
+
+  /**
+   *  @fn static void calc_fn_countif(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief COUNTIF(range, condition)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_countif(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_conditional(calc, arg, n, 0, out);
+}
+
+  /**
+   *  @fn static void calc_fn_sumif(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief SUMIF(range, condition, [sum range])
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_sumif(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_conditional(calc, arg, n, 1, out);
+}
+
+  /**
+   *  @fn static void calc_math(libo_xl_calc *calc,
+   *                            calc_value *arg,
+   *                            double (*f)(double),
+   *                            calc_value *out)
+   *
+   *  @brief applies @p f to number @p arg[0], results that are not finite
+   *         giving #NUM!
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param f - function of one number
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_math(libo_xl_calc *calc, calc_value *arg, double (*f)(double), calc_value *out)
+{
+  calc_error_code error;
+  double x;
+
+  if ((error = calc_arg_number(calc, &arg[0], &x)))
+    calc_set_error(out, error);
+  else if (!isfinite(x = f(x)))
+    calc_set_error(out, calc_error_num);
+  else
+    calc_set_number(out, x);
+}
+
+  /**
+   *  @fn static double calc_sign(double x)
+   *
+   *  @brief returns -1, 0 or 1 as @p x is negative, zero or positive
+   *
+   *  @param x - number
+   *
+   *  @return sign of @p x
+   */
+
+static double calc_sign(double x)
+{
+  return (x > 0) - (x < 0);
+}
+
+  /**
+   *  @fn static void calc_fn_abs(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ABS(number)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_abs(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_math(calc, arg, fabs, out);
+}
+
+  /**
+   *  @fn static void calc_fn_int(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief INT(number), rounding down
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_int(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_math(calc, arg, floor, out);
+}
+
+  /**
+   *  @fn static void calc_fn_sqrt(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief SQRT(number)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_sqrt(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_math(calc, arg, sqrt, out);
+}
+
+  /**
+   *  @fn static void calc_fn_exp(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief EXP(number)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_exp(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_math(calc, arg, exp, out);
+}
+
+  /**
+   *  @fn static void calc_fn_ln(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief LN(number)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_ln(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_math(calc, arg, log, out);
+}
+
+  /**
+   *  @fn static void calc_fn_log10(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief LOG10(number)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_log10(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_math(calc, arg, log10, out);
+}
+
+  /**
+   *  @fn static void calc_fn_sign(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief SIGN(number)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_sign(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_math(calc, arg, calc_sign, out);
+}
+
+  /**
+   *  @fn static void calc_fn_pi(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief PI()
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_pi(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_set_number(out, M_PI);
+}
+
+  /**
+   *  @fn static void calc_fn_power(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief POWER(number, power)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_power(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_arith(calc, calc_op_power, &arg[0], &arg[1]);
+
+  *out = arg[0];
+}
+
+  /**
+   *  @fn static void calc_fn_mod(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief MOD(number, divisor), the result taking the sign of divisor
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_mod(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_error_code error;
+  double x, y;
+
+  if ((error = calc_arg_number(calc, &arg[0], &x)) || (error = calc_arg_number(calc, &arg[1], &y)))
+    calc_set_error(out, error);
+  else if (y == 0)
+    calc_set_error(out, calc_error_div0);
+  else
+    calc_set_number(out, x - y * floor(x / y));
+}
+
+  /**
+   *  @fn static void calc_round(libo_xl_calc *calc, calc_value *arg, int mode, calc_value *out)
+   *
+   *  @brief rounds number @p arg[0] to @p arg[1] digits
+   *
+   *  The scaled number is first taken to 15 digits, so numbers such as
+   *  2.675 round as they are shown rather than as they are held.
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param mode - 0 to round half away from zero, 1 away from zero, 2
+   *                toward zero
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_round(libo_xl_calc *calc, calc_value *arg, int mode, calc_value *out)
+{
+  char buffer[LIBO_XL_NUMBER_SIZE];
+  calc_error_code error;
+  double x, digits, scale, y;
+
+  if ((error = calc_arg_number(calc, &arg[0], &x)) || (error = calc_arg_number(calc, &arg[1], &digits)))
+  {
+    calc_set_error(out, error);
+    return;
+  }
+
+  scale = pow(10, fabs(trunc(digits)));
+  y = (digits < 0) ? x / scale : x * scale;
+
+  snprintf(buffer, sizeof(buffer), "%.15g", y);
+  y = strtod(buffer, NULL);
+
+  switch (mode)
+  {
+    case 0: y = round(y); break;
+    case 1: y = (y < 0) ? floor(y) : ceil(y); break;
+    default: y = trunc(y); break;
+  }
+
+  y = (digits < 0) ? y * scale : y / scale;
+
+  if (!isfinite(y)) calc_set_error(out, calc_error_num);
+  else calc_set_number(out, y);
+}
+
+  /**
+   *  @fn static void calc_fn_round(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ROUND(number, digits)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_round(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_round(calc, arg, 0, out);
+}
+
+  /**
+   *  @fn static void calc_fn_roundup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ROUNDUP(number, digits)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_roundup(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_round(calc, arg, 1, out);
+}
+
+  /**
+   *  @fn static void calc_fn_rounddown(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ROUNDDOWN(number, digits)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_rounddown(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_round(calc, arg, 2, out);
+}
+
+  /**
+   *  @fn static void calc_fn_if(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief IF(condition, [then], [else])
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_if(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_error_code error;
+  int b;
+
+  calc_scalar(calc, &arg[0]);
+
+  if ((error = calc_to_bool(&arg[0], &b)))
+    calc_set_error(out, error);
+  else if (b)
+    *out = (n > 1) ? arg[1] : arg[0];
+  else if (n > 2)
+    *out = arg[2];
+  else
+    calc_set_bool(out, 0);
+}
+
+  /**
+   *  @fn static void calc_logical(libo_xl_calc *calc,
+   *                               calc_value *arg,
+   *                               int n,
+   *                               int any,
+   *                               calc_value *out)
+   *
+   *  @brief AND or OR of the numbers and booleans of @p arg
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param any - 1 for OR, 0 for AND
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_logical(libo_xl_calc *calc, calc_value *arg, int n, int any, calc_value *out)
+{
+  calc_error_code error;
+  calc_value v;
+  int values = 0;
+  int result = !any;
+  int i, r, c, b, last;
+
+  for (i = 0; i < n; i++)
+  {
+    if (arg[i].kind != calc_range)
+    {
+      if (arg[i].kind == calc_empty) continue;
+
+      if ((error = calc_to_bool(&arg[i], &b)))
+      {
+        calc_set_error(out, error);
+        return;
+      }
+
+      result = any ? (result || b) : (result && b);
+      ++values;
+      continue;
+    }
+
+    last = calc_area_rows(calc, &arg[i].area);
+
+    for (c = arg[i].area.c1; c <= arg[i].area.c2; c++)
+    {
+      for (r = arg[i].area.r1; r <= last; r++)
+      {
+        calc_cell_value(calc, arg[i].area.sheet, r, c, &v);
+
+        if (v.kind == calc_error)
+        {
+          *out = v;
+          return;
+        }
+
+        if ((v.kind != calc_number) && (v.kind != calc_bool)) continue;
+
+        result = any ? (result || v.number) : (result && v.number);
+        ++values;
+      }
+    }
+  }
+
+  if (!values) calc_set_error(out, calc_error_value);
+  else calc_set_bool(out, result);
+}
+
+  /**
+   *  @fn static void calc_fn_and(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief AND(value, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_and(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_logical(calc, arg, n, 0, out);
+}
+
+  /**
+   *  @fn static void calc_fn_or(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief OR(value, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_or(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_logical(calc, arg, n, 1, out);
+}
+
+  /**
+   *  @fn static void calc_fn_not(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief NOT(value)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_not(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_error_code error;
+  int b;
+
+  calc_scalar(calc, &arg[0]);
+
+  if ((error = calc_to_bool(&arg[0], &b))) calc_set_error(out, error);
+  else calc_set_bool(out, !b);
+}
+
+  /**
+   *  @fn static void calc_fn_iferror(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief IFERROR(value, value if error)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_iferror(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_scalar(calc, &arg[0]);
+
+  *out = (arg[0].kind == calc_error) ? arg[1] : arg[0];
+}
+
+  /**
+   *  @fn static void calc_fn_iserror(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ISERROR(value)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_iserror(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_scalar(calc, &arg[0]);
+
+  calc_set_bool(out, arg[0].kind == calc_error);
+}
+
+  /**
+   *  @fn static void calc_fn_isna(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ISNA(value)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_isna(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_scalar(calc, &arg[0]);
+
+  calc_set_bool(out, (arg[0].kind == calc_error) && (arg[0].error == calc_error_na));
+}
+
+  /**
+   *  @fn static void calc_fn_isblank(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ISBLANK(value)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_isblank(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_scalar(calc, &arg[0]);
+
+  calc_set_bool(out, arg[0].kind == calc_empty);
+}
+
+  /**
+   *  @fn static void calc_fn_isnumber(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ISNUMBER(value)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_isnumber(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_scalar(calc, &arg[0]);
+
+  calc_set_bool(out, arg[0].kind == calc_number);
+}
+
+  /**
+   *  @fn static void calc_fn_istext(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief ISTEXT(value)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_istext(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_scalar(calc, &arg[0]);
+
+  calc_set_bool(out, arg[0].kind == calc_text);
+}
+
+  /**
+   *  @fn static void calc_fn_len(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief LEN(text), in bytes
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_len(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_error_code error;
+  const char *text;
+  size_t len;
+
+  calc_scalar(calc, &arg[0]);
+
+  if ((error = calc_to_text(calc, &arg[0], &text, &len))) calc_set_error(out, error);
+  else calc_set_number(out, len);
+}
+
+  /**
+   *  @fn static void calc_fn_concatenate(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief CONCATENATE(text, ...)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_concatenate(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  int i;
+
+  calc_set_text(out, "", 0);
+
+  for (i = 0; (i < n) && (out->kind != calc_error); i++)
+    calc_concat(calc, out, &arg[i]);
+}
+
+  /**
+   *  @fn static void calc_side(libo_xl_calc *calc, calc_value *arg, int n, int right, calc_value *out)
+   *
+   *  @brief first, or last, @p arg[1] bytes of text @p arg[0]
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param right - 1 for RIGHT, 0 for LEFT
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_side(libo_xl_calc *calc, calc_value *arg, int n, int right, calc_value *out)
+{
+  calc_error_code error;
+  const char *text;
+  double count = 1;
+  size_t len, total;
+
+  calc_scalar(calc, &arg[0]);
+
+  if ((error = calc_to_text(calc, &arg[0], &text, &total)) ||
+      ((n > 1) && (error = calc_arg_number(calc, &arg[1], &count))))
+  {
+    calc_set_error(out, error);
+    return;
+  }
+
+  if (count < 0)
+  {
+    calc_set_error(out, calc_error_value);
+    return;
+  }
+
+  len = (count < total) ? (size_t)count : total;
+  calc_set_text(out, right ? text + total - len : text, len);
+}
+
+  /**
+   *  @fn static void calc_fn_left(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief LEFT(text, [count])
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_left(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_side(calc, arg, n, 0, out);
+}
+
+  /**
+   *  @fn static void calc_fn_right(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief RIGHT(text, [count])
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_right(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_side(calc, arg, n, 1, out);
+}
+
+  /**
+   *  @fn static void calc_fn_mid(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief MID(text, start, count), with @p start counted from 1
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_mid(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_error_code error;
+  const char *text;
+  double start;
+  double count;
+  size_t first, len, total;
+
+  calc_scalar(calc, &arg[0]);
+
+  if ((error = calc_to_text(calc, &arg[0], &text, &total)) ||
+      (error = calc_arg_number(calc, &arg[1], &start)) ||
+      (error = calc_arg_number(calc, &arg[2], &count)))
+  {
+    calc_set_error(out, error);
+    return;
+  }
+
+  if ((start < 1) || (count < 0))
+  {
+    calc_set_error(out, calc_error_value);
+    return;
+  }
+
+    // a start past the end gives empty text
+
+  first = (start - 1 < total) ? (size_t)(start - 1) : total;
+  len = (count < total - first) ? (size_t)count : total - first;
+  calc_set_text(out, text + first, len);
+}
+
+  /**
+   *  @fn static void calc_case(libo_xl_calc *calc, calc_value *arg, int upper, calc_value *out)
+   *
+   *  @brief text @p arg[0] in upper, or lower, case
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param upper - 1 for UPPER, 0 for LOWER
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_case(libo_xl_calc *calc, calc_value *arg, int upper, calc_value *out)
+{
+  calc_error_code error;
+  const char *text;
+  char *copy;
+  size_t len, i;
+
+  calc_scalar(calc, &arg[0]);
+
+  if ((error = calc_to_text(calc, &arg[0], &text, &len)))
+  {
+    calc_set_error(out, error);
+    return;
+  }
+
+  copy = calc_alloc(calc, len ? len : 1);
+  if (!copy)
+  {
+    calc_set_error(out, calc_error_value);
+    return;
+  }
+
+  for (i = 0; i < len; i++)
+    copy[i] = upper ? toupper((unsigned char)text[i]) : tolower((unsigned char)text[i]);
+
+  calc_set_text(out, copy, len);
+}
+
+  /**
+   *  @fn static void calc_fn_upper(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief UPPER(text)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_upper(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_case(calc, arg, 1, out);
+}
+
+  /**
+   *  @fn static void calc_fn_lower(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+   *
+   *  @brief LOWER(text)
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param arg - arguments
+   *  @param n - number of arguments
+   *  @param out - receives result
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void calc_fn_lower(libo_xl_calc *calc, calc_value *arg, int n, calc_value *out)
+{
+  calc_case(calc, arg, 0, out);
+}
+
+  /**
+   *  @fn static int calc_sheet_index(libo_xl_calc *calc, libo_xl_sheet *sheet)
+   *
+   *  @brief returns index in book of work sheet @p sheet
+   *
+   *  @param calc - pointer to existing @a libo_xl_calc struct
+   *  @param sheet - pointer to work sheet
+   *
+   *  @return index of sheet, -1 if @p sheet is not of @p calc
+   */
+
+static int calc_sheet_index(libo_xl_calc *calc, libo_xl_sheet *sheet)
+{
+  int s;
+
+  if (!sheet) return -1;
+
+  for (s = 0; s < calc->n_sheets; s++)
+    if (calc->sheet[s].sheet == sheet) return s;
+
+  return -1;
+}
+
+  /**
+   *  @fn static int calc_sheet_has_formulas(libo_xl_sheet *sheet)
+   *
+   *  @brief tells whether any cell of @p sheet holds a formula
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return 1 if a cell holds a formula, 0 if none
+   */
+
+static int calc_sheet_has_formulas(libo_xl_sheet *sheet)
+{
+  libo_xl_row *row;
+  int r, c;
+
+  if (sheet->n_shared) return 1;
+
+  for (r = 0; r < sheet->n_rows; r++)
+  {
+    row = libo_xl_sheet_get_row(sheet, r);
+
+    for (c = 0; row && (c < row->n_cells); c++)
+      if (cell_has_formula(row->cell[c])) return 1;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static int calc_cell_is_value(libo_xl_cell *cell)
+   *
+   *  @brief tells whether @p cell is a boolean, an error, or an expression
+   *         holding a formula or a value, which indexes and column kernels
+   *         do not see
+   *
+   *  Expressions holding neither read as empty cells.
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct, or NULL
+   *
+   *  @return 1 if @p cell holds a formula or value, 0 if not
+   */
+
+static int calc_cell_is_value(libo_xl_cell *cell)
+{
+  if (!cell) return 0;
+  if ((cell->type == libo_xl_cell_type_boolean) || (cell->type == libo_xl_cell_type_error)) return 1;
+  if (cell->type != libo_xl_cell_type_expression) return 0;
+
+  return cell_has_formula(cell) || (cell->expression.value && *cell->expression.value);
+}
+
+  /**
+   *  @fn static int predicate_copy(libo_xl_predicate *dst,
+   *                                libo_xl_predicate *src)
+   *
+   *  @brief fills @p dst with a deep copy of @p src
+   *
+   *  @param dst - pointer to @a libo_xl_predicate struct to fill
+   *  @param src - pointer to existing @a libo_xl_predicate struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int predicate_copy(libo_xl_predicate *dst, libo_xl_predicate *src)
+{
+  int i;
+
+  memcpy(dst, src, sizeof(libo_xl_predicate));
+  dst->ids = NULL;
+  dst->texts = NULL;
+
+  if (src->n_ids)
+  {
+    dst->ids = (int *)malloc(sizeof(int) * src->n_ids);
+    if (!dst->ids) goto bail;
+    memcpy(dst->ids, src->ids, sizeof(int) * src->n_ids);
+  }
+
+  if (src->n_texts)
+  {
+    dst->texts = (char **)calloc(src->n_texts, sizeof(char *));
+    if (!dst->texts) goto bail;
+
+    for (i = 0; i < src->n_texts; i++)
+    {
+      dst->texts[i] = strdup(src->texts[i] ? src->texts[i] : "");
+      if (!dst->texts[i]) goto bail;
+    }
+  }
+
+  return 0;
+
+bail:
+  predicate_clear(dst);
+
+  return -1;
+}
+
+  /**
+   *  @fn static void predicate_clear(libo_xl_predicate *pred)
+   *
+   *  @brief frees ids and texts of @p pred made by @a predicate_copy
+   *
+   *  @param pred - pointer to existing @a libo_xl_predicate struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void predicate_clear(libo_xl_predicate *pred)
+{
+  int i;
+
+  if (pred->texts)
+  {
+    for (i = 0; i < pred->n_texts; i++)
+      free(pred->texts[i]);
+  }
+
+  free(pred->texts);
+  free(pred->ids);
+
+  pred->texts = NULL;
+  pred->ids = NULL;
+  pred->n_texts = 0;
+  pred->n_ids = 0;
+}
+
+  /**
+   *  @fn static int projection_add(libo_options *options,
+   *                                libo_xl_projection *pick)
+   *
+   *  @brief adds a copy of @p pick to the columns read for @p options
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param pick - pointer to existing @a libo_xl_projection struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int projection_add(libo_options *options, libo_xl_projection *pick)
+{
+  libo_xl_projection *tmp;
+  char *name = NULL;
+
+  if (pick->name)
+  {
+    name = strdup(pick->name);
+    if (!name) return -1;
+  }
+
+  tmp = (libo_xl_projection *)realloc(options->column,
+                                      sizeof(libo_xl_projection) * (options->n_columns + 1));
+  if (!tmp)
+  {
+    free(name);
+    return -1;
+  }
+  options->column = tmp;
+
+  options->column[options->n_columns].col = pick->col;
+  options->column[options->n_columns].name = name;
+  options->column[options->n_columns].id = pick->id;
+  ++options->n_columns;
+
+  return 0;
+}
+
+  /**
+   *  @fn static void libo_options_resolve_texts(libo_options *options,
+   *                                             strings *strings)
+   *
+   *  @brief looks up texts of predicates and headings of columns of
+   *         @p options in @p strings
+   *
+   *  Ids of texts of predicates join their sets of ids, and the texts are
+   *  dropped.  Headings of columns keep their text, and gain its id.
+   *  Texts not among @p strings can match no cell.
+   *
+   *  @param options - pointer to existing @a libo_options struct
+   *  @param strings - pointer to shared strings of document, or NULL
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_options_resolve_texts(libo_options *options, strings *strings)
+{
+  libo_xl_predicate *pred;
+  string *str;
+  int *ids;
+  int i, j;
+
+  if (!options) return;
+
+  for (i = 0; i < options->n_predicates; i++)
+  {
+    pred = &options->predicate[i];
+    if (!pred->n_texts) continue;
+
+    ids = (int *)realloc(pred->ids, sizeof(int) * (pred->n_ids + pred->n_texts));
+    if (ids)
+    {
+      pred->ids = ids;
+
+      for (j = 0; strings && (j < pred->n_texts); j++)
+      {
+        str = strings_find_by_text(strings, pred->texts[j]);
+        if (str) pred->ids[pred->n_ids++] = str->id;
+      }
+    }
+
+    for (j = 0; j < pred->n_texts; j++)
+      free(pred->texts[j]);
+    free(pred->texts);
+    pred->texts = NULL;
+    pred->n_texts = 0;
+  }
+
+  for (i = 0; i < options->n_columns; i++)
+  {
+    if (!options->column[i].name) continue;
+
+    str = strings ? strings_find_by_text(strings, options->column[i].name) : NULL;
+    options->column[i].id = str ? str->id : -1;
+  }
+}
+
+  /**
+   *  @fn static int bits_for(uint64_t x)
+   *
+   *  @brief returns number of bits needed to hold @p x
+   *
+   *  @param x - largest value to hold
+   *
+   *  @return number of bits, 0 for 0
+   */
+
+static int bits_for(uint64_t x)
+{
+  int n = 0;
+
+  while (x)
+  {
+    ++n;
+    x >>= 1;
+  }
+
+  return n;
+}
+
+  /**
+   *  @fn static uint64_t bits_get(uint64_t *p, size_t i, int width)
+   *
+   *  @brief returns value @p i of @p width bits from bit-packed @p p
+   *
+   *  @param p - bit-packed values
+   *  @param i - index of value
+   *  @param width - bits per value, 0 to 64
+   *
+   *  @return value
+   */
+
+static uint64_t bits_get(uint64_t *p, size_t i, int width)
+{
+  size_t bit;
+  size_t word;
+  int shift;
+  uint64_t v;
+  uint64_t mask;
+
+  if (!width) return 0;
+
+  mask = (width == 64) ? ~(uint64_t)0 : (((uint64_t)1 << width) - 1);
+
+  bit = i * width;
+  word = bit / 64;
+  shift = bit % 64;
+
+  v = p[word] >> shift;
+  if (shift + width > 64) v |= p[word + 1] << (64 - shift);
+
+  return v & mask;
+}
+
+  /**
+   *  @fn static void bits_put(uint64_t *p, size_t i, int width, uint64_t v)
+   *
+   *  @brief stores @p v as value @p i of @p width bits in bit-packed @p p
+   *
+   *  NOTE:  @p p must start zeroed, values are or'ed in.
+   *
+   *  @param p - bit-packed values
+   *  @param i - index of value
+   *  @param width - bits per value, 0 to 64
+   *  @param v - value, which must fit in @p width bits
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void bits_put(uint64_t *p, size_t i, int width, uint64_t v)
+{
+  size_t bit;
+  size_t word;
+  int shift;
+
+  if (!width) return;
+
+  bit = i * width;
+  word = bit / 64;
+  shift = bit % 64;
+
+  p[word] |= v << shift;
+  if (shift + width > 64) p[word + 1] |= v >> (64 - shift);
+}
+
+  /**
+   *  @fn static double column_key_to_number(chunk_kind kind, uint64_t key)
+   *
+   *  @brief returns number held by @p key of a chunk of @p kind
+   *
+   *  @param kind - @a chunk_kind of chunk
+   *  @param key - 64 bit key
+   *
+   *  @return number, or string id as a number
+   */
+
+static double column_key_to_number(chunk_kind kind, uint64_t key)
+{
+  double d;
+
+  if (kind != chunk_kind_number) return (double)(int64_t)key;
+
+  memcpy(&d, &key, sizeof(d));
+
+  return d;
+}
+
+  /**
+   *  @fn static int column_number_is_integral(double d)
+   *
+   *  @brief tests whether @p d is a whole number that a 64 bit integer
+   *         holds exactly
+   *
+   *  @param d - number
+   *
+   *  @return 1 if @p d is whole, 0 otherwise
+   */
+
+static int column_number_is_integral(double d)
+{
+  if (d != floor(d)) return 0;
+  if (fabs(d) > 9007199254740992.0) return 0;
+  if ((d == 0) && signbit(d)) return 0;
+
+  return 1;
+}
+
+  /**
+   *  @fn static void column_census_add(column_census *census,
+   *                                    libo_xl_cell *cell)
+   *
+   *  @brief tallies @p cell in @p census
+   *
+   *  @param census - pointer to existing @a column_census struct
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void column_census_add(column_census *census, libo_xl_cell *cell)
+{
+  ++census->n;
+
+  if (cell->type == libo_xl_cell_type_reference)
+    ++census->references;
+  else if (cell->type == libo_xl_cell_type_boolean)
+    ++census->booleans;
+  else if (cell->type == libo_xl_cell_type_error)
+    ++census->errors;
+  else if (cell_is_number(cell))
+  {
+    ++census->numbers;
+    if (column_number_is_integral(cell->number)) ++census->integral;
+  }
+}
+
+  /**
+   *  @fn static chunk_kind column_census_kind(column_census *census)
+   *
+   *  @brief returns dominant type of cells tallied in @p census
+   *
+   *  A type dominates when it holds more than half of the cells.  Numbers
+   *  are whole numbers only when every one of them is.
+   *
+   *  @param census - pointer to existing @a column_census struct
+   *
+   *  @return @a chunk_kind, @a chunk_kind_cells if no type dominates
+   */
+
+static chunk_kind column_census_kind(column_census *census)
+{
+  if (census->references * 2 > census->n) return chunk_kind_reference;
+  if (census->booleans * 2 > census->n) return chunk_kind_boolean;
+  if (census->errors * 2 > census->n) return chunk_kind_error;
+
+  if (census->numbers * 2 > census->n)
+    return (census->integral == census->numbers) ? chunk_kind_integer : chunk_kind_number;
+
+  return chunk_kind_cells;
+}
+
+  /**
+   *  @fn static int column_kind_is_numeric(chunk_kind kind)
+   *
+   *  @brief tests whether typed values of @p kind are numbers
+   *
+   *  @param kind - @a chunk_kind of chunk
+   *
+   *  @return 1 if numbers, 0 otherwise
+   */
+
+static int column_kind_is_numeric(chunk_kind kind)
+{
+  return (kind == chunk_kind_number) || (kind == chunk_kind_integer);
+}
+
+  /**
+   *  @fn static int column_cell_is_kind(libo_xl_cell *cell, chunk_kind kind)
+   *
+   *  @brief tests whether @p cell is held as a typed value of @p kind
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param kind - @a chunk_kind of chunk
+   *
+   *  @return 1 if @p cell is of @p kind, 0 otherwise
+   */
+
+static int column_cell_is_kind(libo_xl_cell *cell, chunk_kind kind)
+{
+  switch (kind)
+  {
+    case chunk_kind_number:
+      return cell_is_number(cell);
+    case chunk_kind_integer:
+      return cell_is_number(cell) && column_number_is_integral(cell->number);
+    case chunk_kind_reference:
+      return cell->type == libo_xl_cell_type_reference;
+    case chunk_kind_boolean:
+      return cell->type == libo_xl_cell_type_boolean;
+    case chunk_kind_error:
+      return cell->type == libo_xl_cell_type_error;
+    case chunk_kind_cells:
+    default:
+      return 0;
+  }
+}
+
+  /**
+   *  @fn static int column_chunk_is_exception(column_chunk *chunk,
+   *                                           int p,
+   *                                           int e)
+   *
+   *  @brief tests whether cell at position @p p of @p chunk is an exception
+   *
+   *  @param chunk - pointer to existing @a column_chunk struct
+   *  @param p - position of cell in @p chunk
+   *  @param e - number of exceptions before position @p p
+   *
+   *  @return 1 if cell is an exception, 0 if it is a typed value
+   */
+
+static int column_chunk_is_exception(column_chunk *chunk, int p, int e)
+{
+  if (chunk->kind == chunk_kind_cells) return 1;
+
+  return (e < chunk->n_exceptions) && (chunk->at[e] == (unsigned int)p);
+}
+
+  /**
+   *  @fn static libo_xl_row *column_chunk_exceptions(column_chunk *chunk)
+   *
+   *  @brief unpacks exception cells of @p chunk
+   *
+   *  @param chunk - pointer to existing @a column_chunk struct
+   *
+   *  @return pointer to new @a libo_xl_row struct holding the exceptions,
+   *          NULL if there are none or on failure
+   */
+
+static libo_xl_row *column_chunk_exceptions(column_chunk *chunk)
+{
+  libo_xl_row *row;
+  unsigned char *p;
+
+  if (!chunk->n_exceptions) return NULL;
+
+  p = chunk->cells;
+  row = libo_xl_row_unpack(&p, chunk->cells + chunk->len);
+  if (row && (row->n_cells != chunk->n_exceptions))
+  {
+    libo_xl_row_free(row);
+    row = NULL;
+  }
+
+  return row;
+}
+
+  /**
+   *  @fn static int column_chunk_build(column_chunk *chunk,
+   *                                    libo_xl_cell **cells,
+   *                                    int n)
+   *
+   *  @brief encodes @p n @p cells of one column into @p chunk
+   *
+   *  The dominant type of the cells is inferred, those cells become typed
+   *  values, and the rest are kept aside as exceptions.
+   *
+   *  @param chunk - pointer to zeroed @a column_chunk struct
+   *  @param cells - cells of column, top to bottom
+   *  @param n - number of @p cells
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int column_chunk_build(column_chunk *chunk, libo_xl_cell **cells, int n)
+{
+  column_census census;
+  libo_xl_row tmp;
+  libo_xl_cell **odd = NULL;
+  pack_buffer b;
+  uint64_t *keys = NULL;
+  int m = 0;
+  int i;
+
+  memset(&census, 0, sizeof(column_census));
+  for (i = 0; i < n; i++)
+    column_census_add(&census, cells[i]);
+
+  chunk->n_cells = n;
+  chunk->kind = column_census_kind(&census);
+  chunk->encoding = libo_xl_encoding_plain;
+
+  odd = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * (n ? n : 1));
+  if (!odd) goto bail;
+
+  if (chunk->kind != chunk_kind_cells)
+  {
+    keys = (uint64_t *)malloc(sizeof(uint64_t) * (n ? n : 1));
+    chunk->at = (unsigned int *)malloc(sizeof(unsigned int) * (n ? n : 1));
+    if (!keys || !chunk->at) goto bail;
+  }
+
+    // typed values share the cell format, and whether a date, of the first
+
+  for (i = 0; i < n; i++)
+  {
+    if (!m && column_cell_is_kind(cells[i], chunk->kind))
+    {
+      chunk->style = cells[i]->style;
+      chunk->date = cells[i]->type == libo_xl_cell_type_date;
+    }
+
+    if (!column_cell_is_kind(cells[i], chunk->kind) || (cells[i]->style != chunk->style) ||
+        ((cells[i]->type == libo_xl_cell_type_date) != chunk->date))
+    {
+      if (chunk->at) chunk->at[chunk->n_exceptions] = i;
+      odd[chunk->n_exceptions++] = cells[i];
+    }
+    else if (chunk->kind == chunk_kind_number)
+      memcpy(&keys[m++], &cells[i]->number, sizeof(uint64_t));
+    else if (chunk->kind == chunk_kind_integer)
+      keys[m++] = (uint64_t)(int64_t)cells[i]->number;
+    else if (chunk->kind == chunk_kind_boolean)
+      keys[m++] = (uint64_t)(int64_t)cells[i]->boolean;
+    else if (chunk->kind == chunk_kind_error)
+      keys[m++] = (uint64_t)cells[i]->error;
+    else
+      keys[m++] = (uint64_t)(int64_t)cells[i]->reference;
+  }
+
+    // exceptions keep their cells in the binary form of a row
+
+  if (chunk->n_exceptions)
+  {
+    memset(&tmp, 0, sizeof(libo_xl_row));
+    tmp.n_cells = chunk->n_exceptions;
+    tmp.cell = odd;
+
+    memset(&b, 0, sizeof(pack_buffer));
+    if (libo_xl_row_pack(&tmp, &b))
+    {
+      free(b.data);
+      goto bail;
+    }
+
+    chunk->cells = b.data;
+    chunk->len = b.len;
+  }
+
+  if (!chunk->n_exceptions || (chunk->kind == chunk_kind_cells))
+  {
+    free(chunk->at);
+    chunk->at = NULL;
+  }
+
+  free(odd);
+
+  if (chunk->kind == chunk_kind_cells) return 0;
+
+  chunk->n_values = m;
+
+  return column_chunk_encode(chunk, keys, m, chunk->kind != chunk_kind_number);
+
+bail:
+  free(odd);
+  free(keys);
+  column_chunk_clear(chunk);
+
+  return -1;
+}
+
+  /**
+   *  @fn static int column_chunk_encode(column_chunk *chunk,
+   *                                     uint64_t *keys,
+   *                                     int n,
+   *                                     int integral)
+   *
+   *  @brief encodes @p keys into @p chunk with the smallest encoding
+   *
+   *  @p chunk takes ownership of @p keys.
+   *
+   *  @param chunk - pointer to @a column_chunk struct, with kind set
+   *  @param keys - 64 bit keys of values
+   *  @param n - number of @p keys
+   *  @param integral - 1 if keys are integers, which frame encoding needs
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int column_chunk_encode(column_chunk *chunk, uint64_t *keys, int n, int integral)
+{
+  libo_xl_encoding best = libo_xl_encoding_plain;
+  size_t best_size;
+  size_t size;
+  uint64_t *dict = NULL;
+  int *slot = NULL;
+  int n_slots;
+  int n_dict = 0;
+  int n_runs = 1;
+  int64_t v, min = 0, max = 0;
+  uint64_t h;
+  int width;
+  int i, j;
+
+  best_size = sizeof(uint64_t) * n;
+
+    // run-length
+
+  for (i = 1; i < n; i++)
+    if (keys[i] != keys[i - 1]) ++n_runs;
+
+  size = (sizeof(uint64_t) + sizeof(unsigned int)) * n_runs;
+  if (size < best_size)
+  {
+    best = libo_xl_encoding_run_length;
+    best_size = size;
+  }
+
+    // dictionary, in order of first appearance
+
+  for (n_slots = 16; n_slots < 2 * n; n_slots *= 2);
+
+  slot = (int *)malloc(sizeof(int) * n_slots);
+  dict = (uint64_t *)malloc(sizeof(uint64_t) * n);
+  if (!slot || !dict) goto bail;
+  for (i = 0; i < n_slots; i++) slot[i] = -1;
+
+  for (i = 0; (i < n) && (n_dict <= LIBO_XL_DICTIONARY_MAX); i++)
+  {
+    h = (keys[i] * 0x9E3779B97F4A7C15ULL) & (n_slots - 1);
+    while ((slot[h] >= 0) && (dict[slot[h]] != keys[i]))
+      h = (h + 1) & (n_slots - 1);
+    if (slot[h] < 0)
+    {
+      slot[h] = n_dict;
+      dict[n_dict++] = keys[i];
+    }
+  }
+
+  if (n_dict <= LIBO_XL_DICTIONARY_MAX)
+  {
+    width = bits_for(n_dict - 1);
+    size = sizeof(uint64_t) * n_dict +
+           sizeof(uint64_t) * (((size_t)n * width + 63) / 64);
+    if (size < best_size)
+    {
+      best = libo_xl_encoding_dictionary;
+      best_size = size;
+    }
+  }
+
+    // frame of reference, for whole numbers
+
+  if (integral)
+  {
+    for (i = 0; i < n; i++)
+    {
+      v = (int64_t)keys[i];
+      if (!i || (v < min)) min = v;
+      if (!i || (v > max)) max = v;
+    }
+
+    width = bits_for((uint64_t)max - (uint64_t)min);
+    size = sizeof(int64_t) + sizeof(uint64_t) * (((size_t)n * width + 63) / 64);
+    if (size < best_size)
+    {
+      best = libo_xl_encoding_frame;
+      best_size = size;
+    }
+  }
+
+  chunk->encoding = best;
+
+  switch (best)
+  {
+    case libo_xl_encoding_run_length:
+      chunk->values = (uint64_t *)malloc(sizeof(uint64_t) * n_runs);
+      chunk->ends = (unsigned int *)malloc(sizeof(unsigned int) * n_runs);
+      if (!chunk->values || !chunk->ends) goto bail;
+
+      for (i = 0, j = 0; i < n; i++)
+      {
+        if (i && (keys[i] == keys[i - 1])) continue;
+        if (j) chunk->ends[j - 1] = i;
+        chunk->values[j++] = keys[i];
+      }
+      chunk->ends[j - 1] = n;
+      chunk->n_entries = n_runs;
+      break;
+
+    case libo_xl_encoding_dictionary:
+      chunk->width = bits_for(n_dict - 1);
+      chunk->packed = (uint64_t *)calloc(((size_t)n * chunk->width + 63) / 64 + 1, sizeof(uint64_t));
+      if (!chunk->packed) goto bail;
+
+      for (i = 0; i < n; i++)
+      {
+        h = (keys[i] * 0x9E3779B97F4A7C15ULL) & (n_slots - 1);
+        while (dict[slot[h]] != keys[i])
+          h = (h + 1) & (n_slots - 1);
+        bits_put(chunk->packed, i, chunk->width, slot[h]);
+      }
+
+      chunk->values = realloc(dict, sizeof(uint64_t) * n_dict);
+      if (!chunk->values) chunk->values = dict;
+      dict = NULL;
+      chunk->n_entries = n_dict;
+      break;
+
+    case libo_xl_encoding_frame:
+      chunk->base = min;
+      chunk->width = bits_for((uint64_t)max - (uint64_t)min);
+      chunk->packed = (uint64_t *)calloc(((size_t)n * chunk->width + 63) / 64 + 1, sizeof(uint64_t));
+      if (!chunk->packed) goto bail;
+
+      for (i = 0; i < n; i++)
+      {
+        v = (int64_t)keys[i];
+        bits_put(chunk->packed, i, chunk->width, (uint64_t)v - (uint64_t)min);
+      }
+      break;
+
+    case libo_xl_encoding_plain:
+    default:
+      chunk->values = keys;
+      keys = NULL;
+      break;
+  }
+
+  free(keys);
+  free(dict);
+  free(slot);
+
+  return 0;
+
+bail:
+  free(keys);
+  free(dict);
+  free(slot);
+  column_chunk_clear(chunk);
+
+  return -1;
+}
+
+  /**
+   *  @fn static int column_chunk_decode(column_chunk *chunk, uint64_t *keys)
+   *
+   *  @brief expands typed values of @p chunk into @p keys
+   *
+   *  @param chunk - pointer to existing @a column_chunk struct
+   *  @param keys - room for n_values keys
+   *
+   *  @return 0 on success, -1 for a chunk without typed values
+   */
+
+static int column_chunk_decode(column_chunk *chunk, uint64_t *keys)
+{
+  int i, j;
+
+  if (chunk->kind == chunk_kind_cells) return -1;
+
+  switch (chunk->encoding)
+  {
+    case libo_xl_encoding_run_length:
+      for (i = 0, j = 0; i < chunk->n_values; i++)
+      {
+        while ((j < chunk->n_entries - 1) && (chunk->ends[j] <= (unsigned int)i)) ++j;
+        keys[i] = chunk->values[j];
+      }
+      break;
+
+    case libo_xl_encoding_dictionary:
+      for (i = 0; i < chunk->n_values; i++)
+        keys[i] = chunk->values[bits_get(chunk->packed, i, chunk->width)];
+      break;
+
+    case libo_xl_encoding_frame:
+      for (i = 0; i < chunk->n_values; i++)
+        keys[i] = (uint64_t)chunk->base + bits_get(chunk->packed, i, chunk->width);
+      break;
+
+    case libo_xl_encoding_plain:
+    default:
+      if (chunk->n_values)
+        memcpy(keys, chunk->values, sizeof(uint64_t) * chunk->n_values);
+      break;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static void column_chunk_clear(column_chunk *chunk)
+   *
+   *  @brief frees all memory allocated to contents of @p chunk
+   *
+   *  @param chunk - pointer to existing @a column_chunk struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void column_chunk_clear(column_chunk *chunk)
+{
+  if (!chunk) return;
+
+  free(chunk->values);
+  free(chunk->ends);
+  free(chunk->packed);
+  free(chunk->at);
+  free(chunk->cells);
+
+  memset(chunk, 0, sizeof(column_chunk));
+}
+
+  /**
+   *  @fn static size_t column_chunk_memory_size(column_chunk *chunk)
+   *
+   *  @brief returns number of bytes allocated to contents of @p chunk
+   *
+   *  @param chunk - pointer to existing @a column_chunk struct
+   *
+   *  @return number of bytes
+   */
+
+static size_t column_chunk_memory_size(column_chunk *chunk)
+{
+  size_t bytes = 0;
+
+  if (!chunk) return 0;
+
+  switch (chunk->encoding)
+  {
+    case libo_xl_encoding_run_length:
+      bytes += (sizeof(uint64_t) + sizeof(unsigned int)) * chunk->n_entries;
+      break;
+
+    case libo_xl_encoding_dictionary:
+      bytes += sizeof(uint64_t) * chunk->n_entries;
+      bytes += sizeof(uint64_t) * (((size_t)chunk->n_values * chunk->width + 63) / 64 + 1);
+      break;
+
+    case libo_xl_encoding_frame:
+      bytes += sizeof(uint64_t) * (((size_t)chunk->n_values * chunk->width + 63) / 64 + 1);
+      break;
+
+    case libo_xl_encoding_plain:
+    default:
+      if (chunk->values) bytes += sizeof(uint64_t) * chunk->n_values;
+      break;
+  }
+
+  if (chunk->at) bytes += sizeof(unsigned int) * chunk->n_exceptions;
+  bytes += chunk->len;
+
+  return bytes;
+}
+
+  /**
+   *  @fn static int column_cell_matches(libo_xl_cell *cell,
+   *                                     column_predicate *pred)
+   *
+   *  @brief tests @p cell against @p pred
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param pred - pointer to existing @a column_predicate struct
+   *
+   *  @return 1 if @p cell matches, 0 otherwise
+   */
+
+static int column_cell_matches(libo_xl_cell *cell, column_predicate *pred)
+{
+  if (!cell || !pred) return 0;
+  if ((cell->type != pred->type) && !(cell_is_number(cell) && (pred->type == libo_xl_cell_type_number)))
+    return 0;
+
+  if (pred->type == libo_xl_cell_type_reference)
+    return cell->reference == pred->reference;
+
+  return (cell->number >= pred->lo) && (cell->number <= pred->hi);
+}
+
+  /**
+   *  @fn static int column_key_matches(chunk_kind kind,
+   *                                    uint64_t key,
+   *                                    column_predicate *pred)
+   *
+   *  @brief tests value held by @p key of a chunk of @p kind against @p pred
+   *
+   *  @param kind - @a chunk_kind of chunk
+   *  @param key - 64 bit key
+   *  @param pred - pointer to existing @a column_predicate struct
+   *
+   *  @return 1 if value matches, 0 otherwise
+   */
+
+static int column_key_matches(chunk_kind kind, uint64_t key, column_predicate *pred)
+{
+  double d;
+
+  if (kind == chunk_kind_reference)
+    return (pred->type == libo_xl_cell_type_reference) &&
+           ((int)(int64_t)key == pred->reference);
+
+  d = column_key_to_number(kind, key);
+
+  return (pred->type == libo_xl_cell_type_number) &&
+         (d >= pred->lo) && (d <= pred->hi);
+}
+
+  /**
+   *  @fn static long column_chunk_count(column_chunk *chunk,
+   *                                     column_predicate *pred)
+   *
+   *  @brief counts cells of @p chunk matching @p pred, without expanding
+   *         encoded values
+   *
+   *  Runs and dictionary entries are tested once each, and frame of
+   *  reference offsets are compared against bounds moved into their
+   *  range.  Exceptions are tested one by one.
+   *
+   *  @param chunk - pointer to existing @a column_chunk struct
+   *  @param pred - pointer to existing @a column_predicate struct
+   *
+   *  @return number of matching cells
+   */
+
+static long column_chunk_count(column_chunk *chunk, column_predicate *pred)
+{
+  libo_xl_row *odd;
+  unsigned char *match;
+  uint64_t lo, hi, off;
+  double dlo, dhi;
+  long count = 0;
+  int i;
+
+  odd = column_chunk_exceptions(chunk);
+  if (odd)
+  {
+    for (i = 0; i < odd->n_cells; i++)
+      count += column_cell_matches(odd->cell[i], pred);
+    libo_xl_row_free(odd);
+  }
+
+  if (!column_kind_is_numeric(chunk->kind) && (chunk->kind != chunk_kind_reference))
+    return count;
+
+  if ((chunk->kind == chunk_kind_reference) != (pred->type == libo_xl_cell_type_reference))
+    return count;
+
+  switch (chunk->encoding)
+  {
+    case libo_xl_encoding_run_length:
+      for (i = 0; i < chunk->n_entries; i++)
+        if (column_key_matches(chunk->kind, chunk->values[i], pred))
+          count += chunk->ends[i] - (i ? chunk->ends[i - 1] : 0);
+      break;
+
+    case libo_xl_encoding_dictionary:
+      match = (unsigned char *)malloc(chunk->n_entries);
+      if (!match) return count;
+      for (i = 0; i < chunk->n_entries; i++)
+        match[i] = column_key_matches(chunk->kind, chunk->values[i], pred);
+      for (i = 0; i < chunk->n_values; i++)
+        count += match[bits_get(chunk->packed, i, chunk->width)];
+      free(match);
+      break;
+
+    case libo_xl_encoding_frame:
+      if (pred->type == libo_xl_cell_type_reference)
+        dlo = dhi = pred->reference;
+      else
+      {
+        dlo = ceil(pred->lo);
+        dhi = floor(pred->hi);
+      }
+      dlo -= (double)chunk->base;
+      dhi -= (double)chunk->base;
+      if (dlo < 0) dlo = 0;
+      if ((dhi < dlo) || (dhi < 0)) break;
+      if (dlo > 18446744073709549568.0) break;
+      lo = (uint64_t)dlo;
+      hi = (dhi > 18446744073709549568.0) ? ~(uint64_t)0 : (uint64_t)dhi;
+
+      for (i = 0; i < chunk->n_values; i++)
+      {
+        off = bits_get(chunk->packed, i, chunk->width);
+        count += (off >= lo) && (off <= hi);
+      }
+      break;
+
+    case libo_xl_encoding_plain:
+    default:
+      for (i = 0; i < chunk->n_values; i++)
+        count += column_key_matches(chunk->kind, chunk->values[i], pred);
+      break;
+  }
+
+  return count;
+}
+
+  /**
+   *  @fn static double column_chunk_sum(column_chunk *chunk, long *count)
+   *
+   *  @brief sums numbers of @p chunk without expanding encoded values
+   *
+   *  @param chunk - pointer to existing @a column_chunk struct
+   *  @param count - incremented by number of numbers summed
+   *
+   *  @return sum of numbers
+   */
+
+static double column_chunk_sum(column_chunk *chunk, long *count)
+{
+  libo_xl_row *odd;
+  long *hist;
+  double sum = 0;
+  uint64_t offsets = 0;
+  int i;
+
+  odd = column_chunk_exceptions(chunk);
+  if (odd)
+  {
+    for (i = 0; i < odd->n_cells; i++)
+    {
+      if (!cell_is_number(odd->cell[i])) continue;
+      sum += odd->cell[i]->number;
+      ++*count;
+    }
+    libo_xl_row_free(odd);
+  }
+
+  if (!column_kind_is_numeric(chunk->kind)) return sum;
+
+  *count += chunk->n_values;
+
+  switch (chunk->encoding)
+  {
+    case libo_xl_encoding_run_length:
+      for (i = 0; i < chunk->n_entries; i++)
+        sum += column_key_to_number(chunk->kind, chunk->values[i]) *
+               (chunk->ends[i] - (i ? chunk->ends[i - 1] : 0));
+      break;
+
+    case libo_xl_encoding_dictionary:
+      hist = (long *)calloc(chunk->n_entries, sizeof(long));
+      if (!hist) return sum;
+      for (i = 0; i < chunk->n_values; i++)
+        ++hist[bits_get(chunk->packed, i, chunk->width)];
+      for (i = 0; i < chunk->n_entries; i++)
+        sum += column_key_to_number(chunk->kind, chunk->values[i]) * hist[i];
+      free(hist);
+      break;
+
+    case libo_xl_encoding_frame:
+      for (i = 0; i < chunk->n_values; i++)
+        offsets += bits_get(chunk->packed, i, chunk->width);
+      sum += (double)chunk->base * chunk->n_values + (double)offsets;
+      break;
+
+    case libo_xl_encoding_plain:
+    default:
+      for (i = 0; i < chunk->n_values; i++)
+        sum += column_key_to_number(chunk->kind, chunk->values[i]);
+      break;
+  }
+
+  return sum;
+}
+
+  /**
+   *  @fn static int column_block_build(store_block *block,
+   *                                    pack_buffer *pending,
+   *                                    int n_rows)
+   *
+   *  @brief splits @p n_rows packed rows in @p pending into encoded
+   *         columns of @p block
+   *
+   *  @param block - pointer to zeroed @a store_block struct
+   *  @param pending - pointer to @a pack_buffer holding packed rows
+   *  @param n_rows - number of rows in @p pending
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int column_block_build(store_block *block, pack_buffer *pending, int n_rows)
+{
+  libo_xl_row **rows = NULL;
+  libo_xl_cell **cells = NULL;
+  unsigned char *p;
+  int uniform = 1;
+  int err = -1;
+  int c, i, m;
+
+  rows = (libo_xl_row **)calloc(n_rows ? n_rows : 1, sizeof(libo_xl_row *));
+  cells = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * (n_rows ? n_rows : 1));
+  if (!rows || !cells) goto exit;
+
+  for (p = pending->data, i = 0; i < n_rows; i++)
+  {
+    rows[i] = libo_xl_row_unpack(&p, pending->data + pending->len);
+    if (!rows[i]) goto exit;
+
+    if (rows[i]->n_cells > block->width) block->width = rows[i]->n_cells;
+    if (i && (rows[i]->n_cells != rows[0]->n_cells)) uniform = 0;
+  }
+
+  if (!uniform)
+  {
+    block->widths = (int *)malloc(sizeof(int) * n_rows);
+    if (!block->widths) goto exit;
+    for (i = 0; i < n_rows; i++)
+      block->widths[i] = rows[i]->n_cells;
+  }
+
+  if (block->width)
+  {
+    block->chunk = (column_chunk *)calloc(block->width, sizeof(column_chunk));
+    if (!block->chunk) goto exit;
+  }
+  block->n_chunks = block->width;
+
+  for (c = 0; c < block->width; c++)
+  {
+    for (m = 0, i = 0; i < n_rows; i++)
+      if (c < rows[i]->n_cells) cells[m++] = rows[i]->cell[c];
+
+    if (column_chunk_build(&block->chunk[c], cells, m)) goto exit;
+  }
+
+  err = 0;
+
+exit:
+  if (err) column_block_clear(block);
+
+  if (rows)
+    for (i = 0; i < n_rows; i++)
+      libo_xl_row_free(rows[i]);
+
+  free(rows);
+  free(cells);
+
+  return err;
+}
+
+  /**
+   *  @fn static int column_block_decode(store_block *block,
+   *                                     libo_xl_row **rows)
+   *
+   *  @brief rebuilds rows of columnar @p block into @p rows
+   *
+   *  @param block - pointer to existing @a store_block struct
+   *  @param rows - zeroed room for rows of @p block
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int column_block_decode(store_block *block, libo_xl_row **rows)
+{
+  column_chunk *chunk;
+  libo_xl_row *odd = NULL;
+  libo_xl_cell *cell;
+  uint64_t *keys = NULL;
+  int width;
+  int err = -1;
+  int c, i, j, e, p;
+
+  for (i = 0; i < block->n_rows; i++)
+  {
+    width = block->widths ? block->widths[i] : block->width;
+
+    rows[i] = libo_xl_row_new();
+    if (!rows[i]) return -1;
+
+    if (width)
+    {
+      rows[i]->cell = (libo_xl_cell **)calloc(width, sizeof(libo_xl_cell *));
+      if (!rows[i]->cell) return -1;
+    }
+    rows[i]->n_cells = width;
+  }
+
+  for (c = 0; c < block->n_chunks; c++)
+  {
+    chunk = &block->chunk[c];
+
+    odd = column_chunk_exceptions(chunk);
+    if (chunk->n_exceptions && !odd) goto exit;
+
+    if (chunk->kind != chunk_kind_cells)
+    {
+      keys = (uint64_t *)malloc(sizeof(uint64_t) * (chunk->n_values ? chunk->n_values : 1));
+      if (!keys) goto exit;
+      column_chunk_decode(chunk, keys);
+    }
+
+    for (p = 0, j = 0, e = 0, i = 0; (i < block->n_rows) && (p < chunk->n_cells); i++)
+    {
+      if (c >= rows[i]->n_cells) continue;
+
+      if (column_chunk_is_exception(chunk, p, e))
+      {
+        cell = odd->cell[e];
+        odd->cell[e++] = NULL;
+      }
+      else
+      {
+        cell = libo_xl_cell_new();
+        if (!cell) goto exit;
+
+        if (chunk->kind == chunk_kind_reference)
+        {
+          cell->type = libo_xl_cell_type_reference;
+          cell->reference = (int)(int64_t)keys[j];
+        }
+        else if (chunk->kind == chunk_kind_boolean)
+        {
+          cell->type = libo_xl_cell_type_boolean;
+          cell->boolean = (int)(int64_t)keys[j];
+        }
+        else if (chunk->kind == chunk_kind_error)
+        {
+          cell->type = libo_xl_cell_type_error;
+          cell->error = (libo_xl_error)keys[j];
+        }
+        else
+        {
+          cell->type = chunk->date ? libo_xl_cell_type_date : libo_xl_cell_type_number;
+          cell->number = column_key_to_number(chunk->kind, keys[j]);
+        }
+        cell->style = chunk->style;
+        ++j;
+      }
+
+      rows[i]->cell[c] = cell;
+      ++p;
+    }
+
+    libo_xl_row_free(odd);
+    free(keys);
+    odd = NULL;
+    keys = NULL;
+
+    if (p != chunk->n_cells) goto exit;
+  }
+
+  err = 0;
+
+exit:
+  libo_xl_row_free(odd);
+  free(keys);
+
+  return err;
+}
+
+  /**
+   *  @fn static void column_block_clear(store_block *block)
+   *
+   *  @brief frees encoded columns of @p block
+   *
+   *  @param block - pointer to existing @a store_block struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void column_block_clear(store_block *block)
+{
+  int i;
+
+  if (!block) return;
+
+  for (i = 0; i < block->n_chunks; i++)
+    column_chunk_clear(&block->chunk[i]);
+
+  free(block->chunk);
+  free(block->widths);
+
+  block->chunk = NULL;
+  block->widths = NULL;
+  block->n_chunks = 0;
+  block->width = 0;
+}
+
+  /**
+   *  @fn static long libo_xl_store_scan(libo_xl_store *store,
+   *                                     int col,
+   *                                     column_predicate *pred,
+   *                                     double *sum)
+   *
+   *  @brief counts cells of column @p col of columnar @p store matching
+   *         @p pred, or sums its numbers when @p pred is NULL
+   *
+   *  @param store - pointer to existing columnar @a libo_xl_store struct
+   *  @param col - index of column
+   *  @param pred - pointer to @a column_predicate, or NULL
+   *  @param sum - receives sum of numbers when @p pred is NULL
+   *
+   *  @return number of matching cells, or of numbers summed
+   */
+
+static long libo_xl_store_scan(libo_xl_store *store,
+                               int col,
+                               column_predicate *pred,
+                               double *sum)
+{
+  store_block *block;
+  long count = 0;
+  int i;
+
+  if (!store) return 0;
+
+  pthread_mutex_lock(&store->lock);
+
+  libo_xl_store_flush(store);
+
+  for (i = 0; i < store->n_blocks; i++)
+  {
+    block = &store->block[i];
+    if (col >= block->n_chunks) continue;
+
+    if (pred)
+      count += column_chunk_count(&block->chunk[col], pred);
+    else
+      *sum += column_chunk_sum(&block->chunk[col], &count);
+  }
+
+  pthread_mutex_unlock(&store->lock);
+
+  return count;
+}
+
+  /**
+   *  @fn static long libo_xl_sheet_column_scan(libo_xl_sheet *sheet,
+   *                                            int col,
+   *                                            column_predicate *pred,
+   *                                            double *sum)
+   *
+   *  @brief counts cells of column @p col of @p sheet matching @p pred, or
+   *         sums its numbers when @p pred is NULL
+   *
+   *  Columnar sheets are scanned in their encoded form, others row by row.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *  @param pred - pointer to @a column_predicate, or NULL
+   *  @param sum - receives sum of numbers when @p pred is NULL
+   *
+   *  @return number of matching cells, or of numbers summed
+   */
+
+static long libo_xl_sheet_column_scan(libo_xl_sheet *sheet,
+                                      int col,
+                                      column_predicate *pred,
+                                      double *sum)
+{
+  libo_xl_cell *cell;
+  long count = 0;
+  int i;
+
+  if (!sheet || (col < 0)) return 0;
+
+  if (sheet->store && (sheet->store->type == libo_xl_storage_columnar))
+    return libo_xl_store_scan(sheet->store, col, pred, sum);
+
+  for (i = 0; i < sheet->n_rows; i++)
+  {
+    cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), col);
+    if (!cell) continue;
+
+    if (pred)
+      count += column_cell_matches(cell, pred);
+    else if (cell_is_number(cell))
+    {
+      *sum += cell->number;
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+  /**
+   *  @fn static void stats_kernels_select(void)
+   *
+   *  @brief picks the fastest column kernels the processor supports
+   *
+   *  @par Parameters
+   *  None.
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void stats_kernels_select(void)
+{
+#ifdef X86_KERNELS
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+  {
+    _stats_sum = stats_sum_avx2;
+    _stats_deviation = stats_deviation_avx2;
+    _filter_range = filter_range_avx2;
+    _filter_member = filter_member_avx2;
+  }
+  else if (__builtin_cpu_supports("sse2"))
+  {
+    _stats_sum = stats_sum_sse2;
+    _stats_deviation = stats_deviation_sse2;
+    _filter_range = filter_range_sse2;
+    _filter_member = filter_member_sse2;
+  }
+#endif
+}
+
+  /**
+   *  @fn static void stats_sum_scalar(const double *v,
+   *                                   size_t n,
+   *                                   double *sum,
+   *                                   double *min,
+   *                                   double *max)
+   *
+   *  @brief sums @p n numbers of @p v, and finds the smallest and largest
+   *
+   *  @param v - array of at least one number
+   *  @param n - number of numbers in @p v
+   *  @param sum - receives sum
+   *  @param min - receives smallest number
+   *  @param max - receives largest number
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void stats_sum_scalar(const double *v,
+                             size_t n,
+                             double *sum,
+                             double *min,
+                             double *max)
+{
+  double s = 0;
+  double lo = v[0];
+  double hi = v[0];
+  size_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    s += v[i];
+    if (v[i] < lo) lo = v[i];
+    if (v[i] > hi) hi = v[i];
+  }
+
+  *sum = s;
+  *min = lo;
+  *max = hi;
+}
+
+  /**
+   *  @fn static double stats_deviation_scalar(const double *v,
+   *                                           size_t n,
+   *                                           double mean)
+   *
+   *  @brief returns sum of squared differences of @p n numbers of @p v
+   *         from @p mean
+   *
+   *  @param v - array of numbers
+   *  @param n - number of numbers in @p v
+   *  @param mean - average of numbers in @p v
+   *
+   *  @return sum of squared differences
+   */
+
+static double stats_deviation_scalar(const double *v, size_t n, double mean)
+{
+  double s = 0;
+  double d;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    d = v[i] - mean;
+    s += d * d;
+  }
+
+  return s;
+}
+
+#ifdef X86_KERNELS
+
+  /**
+   *  @fn static void stats_sum_sse2(const double *v,
+   *                                 size_t n,
+   *                                 double *sum,
+   *                                 double *min,
+   *                                 double *max)
+   *
+   *  @brief SSE2 version of @a stats_sum_scalar, four numbers at a time
+   *
+   *  @param v - array of at least one number
+   *  @param n - number of numbers in @p v
+   *  @param sum - receives sum
+   *  @param min - receives smallest number
+   *  @param max - receives largest number
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+__attribute__((target("sse2")))
+static void stats_sum_sse2(const double *v,
+                           size_t n,
+                           double *sum,
+                           double *min,
+                           double *max)
+{
+  __m128d s0 = _mm_setzero_pd();
+  __m128d s1 = _mm_setzero_pd();
+  __m128d lo = _mm_set1_pd(v[0]);
+  __m128d hi = lo;
+  __m128d a, b;
+  double t[2];
+  double s, l, h;
+  size_t i;
+
+  for (i = 0; i + 4 <= n; i += 4)
+  {
+    a = _mm_loadu_pd(v + i);
+    b = _mm_loadu_pd(v + i + 2);
+    s0 = _mm_add_pd(s0, a);
+    s1 = _mm_add_pd(s1, b);
+    lo = _mm_min_pd(lo, _mm_min_pd(a, b));
+    hi = _mm_max_pd(hi, _mm_max_pd(a, b));
+  }
+
+  _mm_storeu_pd(t, _mm_add_pd(s0, s1));
+  s = t[0] + t[1];
+  _mm_storeu_pd(t, lo);
+  l = (t[0] < t[1]) ? t[0] : t[1];
+  _mm_storeu_pd(t, hi);
+  h = (t[0] > t[1]) ? t[0] : t[1];
+
+  for (; i < n; i++)
+  {
+    s += v[i];
+    if (v[i] < l) l = v[i];
+    if (v[i] > h) h = v[i];
+  }
+
+  *sum = s;
+  *min = l;
+  *max = h;
+}
+
+  /**
+   *  @fn static double stats_deviation_sse2(const double *v,
+   *                                         size_t n,
+   *                                         double mean)
+   *
+   *  @brief SSE2 version of @a stats_deviation_scalar
+   *
+   *  @param v - array of numbers
+   *  @param n - number of numbers in @p v
+   *  @param mean - average of numbers in @p v
+   *
+   *  @return sum of squared differences
+   */
+
+__attribute__((target("sse2")))
+static double stats_deviation_sse2(const double *v, size_t n, double mean)
+{
+  __m128d m = _mm_set1_pd(mean);
+  __m128d s0 = _mm_setzero_pd();
+  __m128d s1 = _mm_setzero_pd();
+  __m128d a, b;
+  double t[2];
+  double s, d;
+  size_t i;
+
+  for (i = 0; i + 4 <= n; i += 4)
+  {
+    a = _mm_sub_pd(_mm_loadu_pd(v + i), m);
+    b = _mm_sub_pd(_mm_loadu_pd(v + i + 2), m);
+    s0 = _mm_add_pd(s0, _mm_mul_pd(a, a));
+    s1 = _mm_add_pd(s1, _mm_mul_pd(b, b));
+  }
+
+  _mm_storeu_pd(t, _mm_add_pd(s0, s1));
+  s = t[0] + t[1];
+
+  for (; i < n; i++)
+  {
+    d = v[i] - mean;
+    s += d * d;
+  }
+
+  return s;
+}
+
+  /**
+   *  @fn static void stats_sum_avx2(const double *v,
+   *                                 size_t n,
+   *                                 double *sum,
+   *                                 double *min,
+   *                                 double *max)
+   *
+   *  @brief AVX2 version of @a stats_sum_scalar, eight numbers at a time
+   *
+   *  @param v - array of at least one number
+   *  @param n - number of numbers in @p v
+   *  @param sum - receives sum
+   *  @param min - receives smallest number
+   *  @param max - receives largest number
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+__attribute__((target("avx2")))
+static void stats_sum_avx2(const double *v,
+                           size_t n,
+                           double *sum,
+                           double *min,
+                           double *max)
+{
+  __m256d s0 = _mm256_setzero_pd();
+  __m256d s1 = _mm256_setzero_pd();
+  __m256d lo = _mm256_set1_pd(v[0]);
+  __m256d hi = lo;
+  __m256d a, b;
+  __m128d x;
+  double t[2];
+  double s, l, h;
+  size_t i;
+
+  for (i = 0; i + 8 <= n; i += 8)
+  {
+    a = _mm256_loadu_pd(v + i);
+    b = _mm256_loadu_pd(v + i + 4);
+    s0 = _mm256_add_pd(s0, a);
+    s1 = _mm256_add_pd(s1, b);
+    lo = _mm256_min_pd(lo, _mm256_min_pd(a, b));
+    hi = _mm256_max_pd(hi, _mm256_max_pd(a, b));
+  }
+
+  s0 = _mm256_add_pd(s0, s1);
+  x = _mm_add_pd(_mm256_castpd256_pd128(s0), _mm256_extractf128_pd(s0, 1));
+  _mm_storeu_pd(t, x);
+  s = t[0] + t[1];
+
+  x = _mm_min_pd(_mm256_castpd256_pd128(lo), _mm256_extractf128_pd(lo, 1));
+  _mm_storeu_pd(t, x);
+  l = (t[0] < t[1]) ? t[0] : t[1];
+
+  x = _mm_max_pd(_mm256_castpd256_pd128(hi), _mm256_extractf128_pd(hi, 1));
+  _mm_storeu_pd(t, x);
+  h = (t[0] > t[1]) ? t[0] : t[1];
+
+  for (; i < n; i++)
+  {
+    s += v[i];
+    if (v[i] < l) l = v[i];
+    if (v[i] > h) h = v[i];
+  }
+
+  *sum = s;
+  *min = l;
+  *max = h;
+}
+
+  /**
+   *  @fn static double stats_deviation_avx2(const double *v,
+   *                                         size_t n,
+   *                                         double mean)
+   *
+   *  @brief AVX2 version of @a stats_deviation_scalar
+   *
+   *  @param v - array of numbers
+   *  @param n - number of numbers in @p v
+   *  @param mean - average of numbers in @p v
+   *
+   *  @return sum of squared differences
+   */
+
+__attribute__((target("avx2")))
+static double stats_deviation_avx2(const double *v, size_t n, double mean)
+{
+  __m256d m = _mm256_set1_pd(mean);
+  __m256d s0 = _mm256_setzero_pd();
+  __m256d s1 = _mm256_setzero_pd();
+  __m256d a, b;
+  __m128d x;
+  double t[2];
+  double s, d;
+  size_t i;
+
+  for (i = 0; i + 8 <= n; i += 8)
+  {
+    a = _mm256_sub_pd(_mm256_loadu_pd(v + i), m);
+    b = _mm256_sub_pd(_mm256_loadu_pd(v + i + 4), m);
+    s0 = _mm256_add_pd(s0, _mm256_mul_pd(a, a));
+    s1 = _mm256_add_pd(s1, _mm256_mul_pd(b, b));
+  }
+
+  s0 = _mm256_add_pd(s0, s1);
+  x = _mm_add_pd(_mm256_castpd256_pd128(s0), _mm256_extractf128_pd(s0, 1));
+  _mm_storeu_pd(t, x);
+  s = t[0] + t[1];
+
+  for (; i < n; i++)
+  {
+    d = v[i] - mean;
+    s += d * d;
+  }
+
+  return s;
+}
+
+#endif
+
+  /**
+   *  @fn static void column_stats_add(libo_xl_column_stats *acc,
+   *                                   const double *v,
+   *                                   size_t n)
+   *
+   *  @brief folds @p n numbers of @p v into @p acc
+   *
+   *  Each batch is reduced on its own, then merged with the running
+   *  totals, so the variance holds up over many batches.  Until
+   *  @a column_stats_finish is called, variance holds the sum of squared
+   *  differences from the mean.
+   *
+   *  @param acc - pointer to running @a libo_xl_column_stats struct
+   *  @param v - array of numbers
+   *  @param n - number of numbers in @p v
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void column_stats_add(libo_xl_column_stats *acc,
+                             const double *v,
+                             size_t n)
+{
+  double sum, min, max;
+  double mean, m2, delta;
+  double total;
+
+  if (!n) return;
+
+  pthread_once(&_stats_once, stats_kernels_select);
+
+  _stats_sum(v, n, &sum, &min, &max);
+  mean = sum / n;
+  m2 = _stats_deviation(v, n, mean);
+
+  if (!acc->count)
+  {
+    acc->min = min;
+    acc->max = max;
+    acc->mean = mean;
+    acc->variance = m2;
+  }
+  else
+  {
+    total = (double)acc->count + n;
+    delta = mean - acc->mean;
+    acc->mean += delta * n / total;
+    acc->variance += m2 + delta * delta * acc->count * n / total;
+    if (min < acc->min) acc->min = min;
+    if (max > acc->max) acc->max = max;
+  }
+
+  acc->sum += sum;
+  acc->count += n;
+}
+
+  /**
+   *  @fn static void column_stats_finish(libo_xl_column_stats *acc)
+   *
+   *  @brief turns running totals of @p acc into the mean and sample
+   *         variance
+   *
+   *  @param acc - pointer to running @a libo_xl_column_stats struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void column_stats_finish(libo_xl_column_stats *acc)
+{
+  if (!acc->count) return;
+
+  acc->mean = acc->sum / acc->count;
+  acc->variance = (acc->count > 1) ? acc->variance / (acc->count - 1) : 0;
+}
+
+  /**
+   *  @fn static int column_block_numbers(store_block *block,
+   *                                      int col,
+   *                                      int first,
+   *                                      int last,
+   *                                      double *out)
+   *
+   *  @brief copies numbers of column @p col of columnar @p block, from row
+   *         @p first to row @p last of the block, into @p out
+   *
+   *  @param block - pointer to existing @a store_block struct
+   *  @param col - index of column
+   *  @param first - index of first row, within @p block
+   *  @param last - index of last row, within @p block, inclusive
+   *  @param out - room for the rows of @p block
+   *
+   *  @return number of numbers copied
+   */
+
+static int column_block_numbers(store_block *block,
+                                int col,
+                                int first,
+                                int last,
+                                double *out)
+{
+  column_chunk *chunk;
+  libo_xl_row *odd = NULL;
+  uint64_t *keys = NULL;
+  int n = 0;
+  int i, j, e, p;
+
+  if (col >= block->n_chunks) return 0;
+
+  chunk = &block->chunk[col];
+  if (!column_kind_is_numeric(chunk->kind) && (chunk->kind != chunk_kind_cells) &&
+      !chunk->n_exceptions)
+    return 0;
+
+  if (first < 0) first = 0;
+  if (last >= block->n_rows) last = block->n_rows - 1;
+
+  odd = column_chunk_exceptions(chunk);
+  if (chunk->n_exceptions && !odd) return 0;
+
+  if (chunk->kind != chunk_kind_cells)
+  {
+    keys = (uint64_t *)malloc(sizeof(uint64_t) * (chunk->n_values ? chunk->n_values : 1));
+    if (!keys)
+    {
+      libo_xl_row_free(odd);
+      return 0;
+    }
+    column_chunk_decode(chunk, keys);
+
+      // keys of doubles are their bits, so whole typed blocks copy straight out
+
+    if ((chunk->kind == chunk_kind_number) && !odd && !block->widths &&
+        !first && (last == block->n_rows - 1))
+    {
+      memcpy(out, keys, sizeof(double) * chunk->n_values);
+      free(keys);
+      return chunk->n_values;
+    }
+  }
+
+  for (p = 0, j = 0, e = 0, i = 0; (i <= last) && (p < chunk->n_cells); i++)
+  {
+    if (block->widths && (col >= block->widths[i])) continue;
+
+    if (column_chunk_is_exception(chunk, p, e))
+    {
+      if ((i >= first) && cell_is_number(odd->cell[e]))
+        out[n++] = odd->cell[e]->number;
+      ++e;
+    }
+    else
+    {
+      if ((i >= first) && column_kind_is_numeric(chunk->kind))
+        out[n++] = column_key_to_number(chunk->kind, keys[j]);
+      ++j;
+    }
+
+    ++p;
+  }
+
+  libo_xl_row_free(odd);
+  free(keys);
+
+  return n;
+}
+
+  /**
+   *  @fn static int profile_cell_is_empty(libo_xl_cell *cell)
+   *
+   *  @brief tests whether @p cell is empty, as padding cells are
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *
+   *  @return 1 if @p cell is empty, 0 otherwise
+   */
+
+static int profile_cell_is_empty(libo_xl_cell *cell)
+{
+  if (cell->type == libo_xl_cell_type_none) return 1;
+  if (cell->type == libo_xl_cell_type_empty) return 1;
+  if (cell->type != libo_xl_cell_type_expression) return 0;
+  if (cell_has_formula(cell)) return 0;
+
+  return !cell->expression.value || !*cell->expression.value;
+}
+
+  /**
+   *  @fn static uint64_t profile_cell_hash(libo_xl_cell *cell)
+   *
+   *  @brief returns 64 bit hash of value of @p cell
+   *
+   *  Numbers hash their bits, shared strings their id, booleans and
+   *  errors their value, and expressions their formula and value.  Each
+   *  is salted by type, so a number and a string id with the same bits
+   *  are kept apart.
+   *
+   *  @param cell - pointer to existing, non empty @a libo_xl_cell struct
+   *
+   *  @return hash
+   */
+
+static uint64_t profile_cell_hash(libo_xl_cell *cell)
+{
+  uint64_t h = 0xcbf29ce484222325ULL;
+  double d;
+  char *p;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      d = (cell->number == 0) ? 0 : cell->number;
+      memcpy(&h, &d, sizeof(h));
+      h ^= 0x6e756d6265720000ULL;
+      break;
+
+    case libo_xl_cell_type_reference:
+      h = (uint64_t)(int64_t)cell->reference ^ 0x7265666572656e63ULL;
+      break;
+
+    case libo_xl_cell_type_boolean:
+      h = (uint64_t)cell->boolean ^ 0x626f6f6c65616e00ULL;
+      break;
+
+    case libo_xl_cell_type_error:
+      h = (uint64_t)cell->error ^ 0x6572726f72000000ULL;
+      break;
+
+    default:
+      for (p = cell->expression.formula; p && *p; p++)
+        h = (h ^ (unsigned char)*p) * 0x100000001b3ULL;
+      h = (h ^ (0xff + (uint64_t)cell->shared)) * 0x100000001b3ULL;
+      for (p = cell->expression.value; p && *p; p++)
+        h = (h ^ (unsigned char)*p) * 0x100000001b3ULL;
+      break;
+  }
+
+  return hash_mix(h);
+}
+
+  /**
+   *  @fn static void libo_xl_sheet_profile_row(libo_xl_sheet *sheet,
+   *                                            libo_xl_row *row)
+   *
+   *  @brief adds cells of @p row, as it is read, to column profiles of
+   *         @p sheet
+   *
+   *  Profiles are added as wider rows arrive, and columns a row stops
+   *  short of count as empty.
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct, with
+   *                 profile table
+   *  @param row - pointer to existing @a libo_xl_row struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_sheet_profile_row(libo_xl_sheet *sheet, libo_xl_row *row)
+{
+  libo_xl_column_profile **tmp;
+  long seen = 0;
+  int i;
+
+  if (!sheet || !sheet->profile || !row) return;
+
+  if (row->n_cells > sheet->n_profiles)
+  {
+    if (sheet->n_profiles)
+    {
+      seen = sheet->profile[0]->nulls;
+      for (i = 0; i < LIBO_XL_CELL_TYPES; i++)
+        seen += sheet->profile[0]->count[i];
+    }
+
+    tmp = realloc(sheet->profile, sizeof(libo_xl_column_profile *) * row->n_cells);
+    if (!tmp) return;
+    sheet->profile = tmp;
+
+    for (i = sheet->n_profiles; i < row->n_cells; i++)
+    {
+      sheet->profile[i] = libo_xl_column_profile_new();
+      if (!sheet->profile[i]) break;
+
+        // rows read before this column appeared had it empty
+
+      sheet->profile[i]->nulls = seen;
+    }
+    sheet->n_profiles = i;
+  }
+
+  for (i = 0; i < sheet->n_profiles; i++)
+    libo_xl_column_profile_add(sheet->profile[i],
+                               (i < row->n_cells) ? row->cell[i] : NULL);
+}
+
+  /**
+   *  @fn static void libo_xl_sheet_profiles_free(libo_xl_sheet *sheet)
+   *
+   *  @brief frees column profiles of @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_sheet_profiles_free(libo_xl_sheet *sheet)
+{
+  int i;
+
+  if (!sheet || !sheet->profile) return;
+
+  for (i = 0; i < sheet->n_profiles; i++)
+    libo_xl_column_profile_free(sheet->profile[i]);
+
+  free(sheet->profile);
+
+  sheet->profile = NULL;
+  sheet->n_profiles = 0;
+}
+
+  /**
+   *  @fn static uint64_t hash_mix(uint64_t h)
+   *
+   *  @brief spreads every bit of @p h over the whole of the result
+   *
+   *  @param h - 64 bit value
+   *
+   *  @return mixed 64 bit value
+   */
+
+static uint64_t hash_mix(uint64_t h)
+{
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+
+  return h;
+}
+
+  /**
+   *  @fn static int index_cell_key(libo_xl_cell *cell, uint64_t *key)
+   *
+   *  @brief sets @p key to the index key of @p cell
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param key - receives key
+   *
+   *  @return 0 on success, -1 if @p cell is not indexed
+   */
+
+static int index_cell_key(libo_xl_cell *cell, uint64_t *key)
+{
+  double d;
+
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      d = (cell->number == 0) ? 0 : cell->number;
+      memcpy(key, &d, sizeof(uint64_t));
+      return 0;
+
+    case libo_xl_cell_type_reference:
+      *key = (uint64_t)(int64_t)cell->reference;
+      return 0;
+
+    default:
+      return -1;
+  }
+}
+
+  /**
+   *  @fn static index_slot *index_find(libo_xl_index *idx,
+   *                                    libo_xl_cell_type type,
+   *                                    uint64_t key)
+   *
+   *  @brief returns slot of @p idx holding @p key of @p type, or the free
+   *         slot where it belongs
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *  @param type - @a libo_xl_cell_type of value
+   *  @param key - key of value
+   *
+   *  @return pointer to slot
+   */
+
+static index_slot *index_find(libo_xl_index *idx, libo_xl_cell_type type, uint64_t key)
+{
+  index_slot *slot;
+  unsigned int mask = idx->n_slots - 1;
+  unsigned int i;
+
+  i = hash_mix(key ^ ((uint64_t)type << 56)) & mask;
+
+  for (;;)
+  {
+    slot = &idx->slot[i];
+    if (slot->head < 0) return slot;
+    if ((slot->key == key) && (slot->type == type)) return slot;
+    i = (i + 1) & mask;
+  }
+}
+
+  /**
+   *  @fn static int libo_xl_index_fill(libo_xl_index *idx)
+   *
+   *  @brief (re)builds table of @p idx from current cells of its sheet
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int libo_xl_index_fill(libo_xl_index *idx)
+{
+  libo_xl_sheet *sheet = idx->sheet;
+  libo_xl_cell *cell;
+  index_slot *slot;
+  uint64_t key;
+  int n_slots;
+  int i;
+
+  for (n_slots = 16; n_slots < 2 * sheet->n_rows; n_slots *= 2);
+
+  free(idx->slot);
+  free(idx->next);
+
+  idx->n_slots = n_slots;
+  idx->n_rows = sheet->n_rows;
+  idx->version = sheet->version;
+  idx->slot = (index_slot *)malloc(sizeof(index_slot) * n_slots);
+  idx->next = (int *)malloc(sizeof(int) * (sheet->n_rows ? sheet->n_rows : 1));
+  if (!idx->slot || !idx->next) return -1;
+
+  for (i = 0; i < n_slots; i++)
+    idx->slot[i].head = -1;
+
+  for (i = 0; i < sheet->n_rows; i++)
+  {
+    idx->next[i] = -1;
+
+    cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), idx->col);
+    if (!cell || index_cell_key(cell, &key)) continue;
+
+    slot = index_find(idx, cell->type, key);
+    if (slot->head < 0)
+    {
+      slot->key = key;
+      slot->type = cell->type;
+      slot->head = i;
+    }
+    else
+      idx->next[slot->tail] = i;
+    slot->tail = i;
+  }
+
+  return 0;
+}
+
+  /**
+   *  @fn static int libo_xl_index_find_row(libo_xl_index *idx,
+   *                                        libo_xl_cell_type type,
+   *                                        uint64_t key)
+   *
+   *  @brief returns first row of @p idx holding @p key of @p type,
+   *         rebuilding @p idx first if its sheet changed
+   *
+   *  @param idx - pointer to existing @a libo_xl_index struct
+   *  @param type - @a libo_xl_cell_type of value
+   *  @param key - key of value
+   *
+   *  @return index of row, -1 if not found
+   */
+
+static int libo_xl_index_find_row(libo_xl_index *idx, libo_xl_cell_type type, uint64_t key)
+{
+  int row = -1;
+
+  pthread_rwlock_rdlock(&idx->lock);
+
+  if (idx->version != idx->sheet->version)
+  {
+    pthread_rwlock_unlock(&idx->lock);
+    pthread_rwlock_wrlock(&idx->lock);
+
+    if ((idx->version != idx->sheet->version) && libo_xl_index_fill(idx))
+    {
+      idx->n_slots = 0;
+      idx->n_rows = 0;
+    }
+  }
+
+  if (idx->n_slots) row = index_find(idx, type, key)->head;
+
+  pthread_rwlock_unlock(&idx->lock);
+
+  return row;
+}
+
+  /**
+   *  @fn static int int_compare(const void *a, const void *b)
+   *
+   *  @brief compares two integers for qsort()
+   *
+   *  @param a - pointer to first integer
+   *  @param b - pointer to second integer
+   *
+   *  @return -1, 0, or 1 as @p a is less than, equal to, or greater than @p b
+   */
+
+static int int_compare(const void *a, const void *b)
+{
+  int x = *(const int *)a;
+  int y = *(const int *)b;
+
+  return (x > y) - (x < y);
+}
+
+  /**
+   *  @fn static int sort_threads(int n)
+   *
+   *  @brief returns number of threads to sort @p n items with
+   *
+   *  @param n - number of items
+   *
+   *  @return number of threads, from 1 to LIBO_XL_SORT_THREADS
+   */
+
+static int sort_threads(int n)
+{
+  long cpus = 2;
+
+#ifdef _SC_NPROCESSORS_ONLN
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+  if (n < LIBO_XL_SORT_MIN) return 1;
+  if (cpus < 1) return 1;
+  if (cpus > LIBO_XL_SORT_THREADS) return LIBO_XL_SORT_THREADS;
+
+  return (int)cpus;
+}
+
+  /**
+   *  @fn static void merge_runs(const int *src,
+   *                             int *dst,
+   *                             int lo,
+   *                             int mid,
+   *                             int hi,
+   *                             perm_compare cmp,
+   *                             void *data)
+   *
+   *  @brief merges sorted runs @p lo to @p mid and @p mid to @p hi of
+   *         @p src into @p dst, keeping order of equal items
+   *
+   *  @param src - array holding runs
+   *  @param dst - array to receive merged run at @p lo
+   *  @param lo - start of first run
+   *  @param mid - start of second run
+   *  @param hi - end of second run
+   *  @param cmp - function comparing items
+   *  @param data - passed to @p cmp
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void merge_runs(const int *src, int *dst, int lo, int mid, int hi, perm_compare cmp, void *data)
+{
+  int i = lo, j = mid, k = lo;
+
+  while ((i < mid) && (j < hi))
+  {
+    if (cmp(src[j], src[i], data) < 0) dst[k++] = src[j++];
+    else dst[k++] = src[i++];
+  }
+
+  while (i < mid) dst[k++] = src[i++];
+  while (j < hi) dst[k++] = src[j++];
+}
+
+  /**
+   *  @fn static void sort_run(int *perm,
+   *                           int *tmp,
+   *                           int lo,
+   *                           int hi,
+   *                           perm_compare cmp,
+   *                           void *data)
+   *
+   *  @brief sorts items @p lo to @p hi of @p perm, keeping order of equal
+   *         items
+   *
+   *  Short runs are sorted by insertion, then merged bottom up between
+   *  @p perm and @p tmp.
+   *
+   *  @param perm - array of items
+   *  @param tmp - scratch array as long as @p perm
+   *  @param lo - first item
+   *  @param hi - item after last
+   *  @param cmp - function comparing items
+   *  @param data - passed to @p cmp
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void sort_run(int *perm, int *tmp, int lo, int hi, perm_compare cmp, void *data)
+{
+  int *src = perm, *dst = tmp, *swap;
+  int width, start, end, mid;
+  int i, j, v;
+
+  for (start = lo; start < hi; start += 32)
+  {
+    end = (start + 32 < hi) ? start + 32 : hi;
+    for (i = start + 1; i < end; i++)
+    {
+      v = perm[i];
+      for (j = i; (j > start) && (cmp(v, perm[j - 1], data) < 0); j--)
+        perm[j] = perm[j - 1];
+      perm[j] = v;
+    }
+  }
+
+  for (width = 32; width < hi - lo; width *= 2)
+  {
+    for (start = lo; start < hi; start += 2 * width)
+    {
+      mid = (start + width < hi) ? start + width : hi;
+      end = (start + 2 * width < hi) ? start + 2 * width : hi;
+      merge_runs(src, dst, start, mid, end, cmp, data);
+    }
+    swap = src; src = dst; dst = swap;
+  }
+
+  if (src != perm)
+    memcpy(perm + lo, src + lo, sizeof(int) * (hi - lo));
+}
+
+  /**
+   *  @fn static void *sort_worker(void *arg)
+   *
+   *  @brief thread sorting run of one @a sort_task
+   *
+   *  @param arg - pointer to @a sort_task
+   *
+   *  @return NULL
+   */
+
+static void *sort_worker(void *arg)
+{
+  sort_task *task = (sort_task *)arg;
+
+  sort_run(task->perm, task->tmp, task->lo, task->hi, task->cmp, task->data);
+
+  return NULL;
+}
+
+  /**
+   *  @fn static void *merge_worker(void *arg)
+   *
+   *  @brief thread merging two sorted runs of one @a sort_task
+   *
+   *  @param arg - pointer to @a sort_task
+   *
+   *  @return NULL
+   */
+
+static void *merge_worker(void *arg)
+{
+  sort_task *task = (sort_task *)arg;
+
+  merge_runs(task->perm, task->tmp, task->lo, task->mid, task->hi, task->cmp, task->data);
+  memcpy(task->perm + task->lo, task->tmp + task->lo, sizeof(int) * (task->hi - task->lo));
+
+  return NULL;
+}
+
+  /**
+   *  @fn static void sort_tasks_run(sort_task *task,
+   *                                 int n,
+   *                                 void *(*worker)(void *))
+   *
+   *  @brief runs @p worker on each of @p n tasks, each in its own thread
+   *
+   *  The first task runs in the calling thread, as does any task whose
+   *  thread cannot be started.
+   *
+   *  @param task - array of @a sort_task
+   *  @param n - number of tasks
+   *  @param worker - function to run
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void sort_tasks_run(sort_task *task, int n, void *(*worker)(void *))
+{
+  pthread_t thread[LIBO_XL_SORT_THREADS];
+  int started[LIBO_XL_SORT_THREADS];
+  int i;
+
+  for (i = 1; i < n; i++)
+    started[i] = !pthread_create(&thread[i], NULL, worker, &task[i]);
+
+  worker(&task[0]);
+
+  for (i = 1; i < n; i++)
+  {
+    if (started[i]) pthread_join(thread[i], NULL);
+    else worker(&task[i]);
+  }
+}
+
+  /**
+   *  @fn static int parallel_sort(int *perm, int n, perm_compare cmp, void *data)
+   *
+   *  @brief sorts @p n items of @p perm, keeping order of equal items
+   *
+   *  Equal runs of @p perm are sorted by several threads, then merged in
+   *  pairs, each pair by its own thread.
+   *
+   *  @param perm - array of items, usually indexes into @p data
+   *  @param n - number of items
+   *  @param cmp - function comparing items
+   *  @param data - passed to @p cmp
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int parallel_sort(int *perm, int n, perm_compare cmp, void *data)
+{
+  sort_task task[LIBO_XL_SORT_THREADS];
+  int bound[LIBO_XL_SORT_THREADS + 1];
+  int *tmp;
+  int n_runs, n_tasks, width, last;
+  int i;
+
+  if (n < 2) return 0;
+
+  tmp = (int *)malloc(sizeof(int) * n);
+  if (!tmp) return -1;
+
+  n_runs = sort_threads(n);
+  for (i = 0; i <= n_runs; i++)
+    bound[i] = (int)((long long)n * i / n_runs);
+
+  for (i = 0; i < LIBO_XL_SORT_THREADS; i++)
+  {
+    task[i].perm = perm;
+    task[i].tmp = tmp;
+    task[i].cmp = cmp;
+    task[i].data = data;
+  }
+
+  for (i = 0; i < n_runs; i++)
+  {
+    task[i].lo = bound[i];
+    task[i].hi = bound[i + 1];
+  }
+  sort_tasks_run(task, n_runs, sort_worker);
+
+  for (width = 1; width < n_runs; width *= 2)
+  {
+    n_tasks = 0;
+    for (i = 0; i + width < n_runs; i += 2 * width)
+    {
+      last = (i + 2 * width < n_runs) ? i + 2 * width : n_runs;
+      task[n_tasks].lo = bound[i];
+      task[n_tasks].mid = bound[i + width];
+      task[n_tasks].hi = bound[last];
+      n_tasks++;
+    }
+    sort_tasks_run(task, n_tasks, merge_worker);
+  }
+
+  free(tmp);
+
+  return 0;
+}
+
+  /**
+   *  @fn static int string_rank_compare(int a, int b, void *data)
+   *
+   *  @brief compares shared strings @p a and @p b as Excel sorts text
+   *
+   *  @param a - id of first string
+   *  @param b - id of second string
+   *  @param data - array of texts of strings, by id
+   *
+   *  @return less than, equal to, or greater than 0 as @p a sorts before,
+   *          with, or after @p b
+   */
+
+static int string_rank_compare(int a, int b, void *data)
+{
+  char **text = (char **)data;
+
+  return strcasecmp(text[a], text[b]);
+}
+
+  /**
+   *  @fn static int *libo_xl_strings_rank(libo_xl *xl,
+   *                                       int *n_strings,
+   *                                       int **by_rank,
+   *                                       int *n_ranked)
+   *
+   *  @brief returns rank of each shared string of @p xl in sorted order
+   *
+   *  Strings are ordered as Excel sorts text, ignoring case, and strings
+   *  equal but for case share a rank.  Ids without a string have rank -1.
+   *
+   *  @param xl - pointer to existing @a libo_xl struct
+   *  @param n_strings - receives number of ids
+   *  @param by_rank - receives array of ids of strings in sorted order, or
+   *                   NULL
+   *  @param n_ranked - receives number of ids in @p by_rank, or NULL
+   *
+   *  @return array of ranks by id, NULL on failure
+   */
+
+static int *libo_xl_strings_rank(libo_xl *xl, int *n_strings, int **by_rank, int *n_ranked)
+{
+  string *str;
+  char **text;
+  int *rank;
+  int *order;
+  int n, m = 0, r = 0;
+  int i;
+
+  n = xl->strings->last_id;
+
+  text = (char **)malloc(sizeof(char *) * (n ? n : 1));
+  rank = (int *)malloc(sizeof(int) * (n ? n : 1));
+  order = (int *)malloc(sizeof(int) * (n ? n : 1));
+  if (!text || !rank || !order) goto bail;
+
+  for (i = 0; i < n; i++)
+  {
+    str = strings_find_by_id(xl->strings, i);
+    text[i] = (str && str->text) ? str->text : NULL;
+    rank[i] = -1;
+    if (text[i]) order[m++] = i;
+  }
+
+  if (parallel_sort(order, m, string_rank_compare, text)) goto bail;
+
+  for (i = 0; i < m; i++)
+  {
+    if (i && string_rank_compare(order[i - 1], order[i], text)) r++;
+    rank[order[i]] = r;
+  }
+
+  free(text);
+
+  *n_strings = n;
+  if (n_ranked) *n_ranked = m;
+  if (by_rank) *by_rank = order;
+  else free(order);
+
+  return rank;
+
+bail:
+  free(text);
+  free(rank);
+  free(order);
+
+  return NULL;
+}
+
+  /**
+   *  @fn static int sorted_key_compare(const sorted_entry *a,
+   *                                    const sorted_entry *b)
+   *
+   *  @brief compares values of two sorted index entries
+   *
+   *  NaN sorts after every number and with other NaNs, so the order stays
+   *  total.
+   *
+   *  @param a - pointer to first entry
+   *  @param b - pointer to second entry
+   *
+   *  @return -1, 0, or 1 as @p a is less than, equal to, or greater than @p b
+   */
+
+static int sorted_key_compare(const sorted_entry *a, const sorted_entry *b)
+{
+  int an, bn;
+
+  if (a->kind != b->kind) return (a->kind > b->kind) - (a->kind < b->kind);
+
+  an = isnan(a->key) != 0;
+  bn = isnan(b->key) != 0;
+  if (an || bn) return an - bn;
+
+  return (a->key > b->key) - (a->key < b->key);
+}
+
+  /**
+   *  @fn static int sorted_entry_compare(int a, int b, void *data)
+   *
+   *  @brief compares entries @p a and @p b of array of @a sorted_entry
+   *
+   *  @param a - index of first entry
+   *  @param b - index of second entry
+   *  @param data - array of @a sorted_entry
+   *
+   *  @return -1, 0, or 1 as @p a sorts before, with, or after @p b
+   */
+
+static int sorted_entry_compare(int a, int b, void *data)
+{
+  sorted_entry *entry = (sorted_entry *)data;
+
+  return sorted_key_compare(&entry[a], &entry[b]);
+}
+
+  /**
+   *  @fn static int sorted_cell_key(libo_xl_sorted_index *idx,
+   *                                 libo_xl_cell *cell,
+   *                                 sorted_entry *key)
+   *
+   *  @brief sets @p key to the sort key of @p cell
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param key - receives key
+   *
+   *  @return 0 on success, -1 if @p cell is not indexed
+   */
+
+static int sorted_cell_key(libo_xl_sorted_index *idx, libo_xl_cell *cell, sorted_entry *key)
+{
+  switch (cell->type)
+  {
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      key->kind = 0;
+      key->key = (cell->number == 0) ? 0 : cell->number;
+      return 0;
+
+    case libo_xl_cell_type_reference:
+      if (!idx->rank || (cell->reference < 0) || (cell->reference >= idx->n_strings))
+        return -1;
+      if (idx->rank[cell->reference] < 0) return -1;
+      key->kind = 1;
+      key->key = idx->rank[cell->reference];
+      return 0;
+
+    default:
+      return -1;
   }
-  *buf = strapp(*buf, "\" activePane=\"");
-  switch (sht->freeze.type)
+}
+
+  /**
+   *  @fn static void sorted_text_key(libo_xl_sorted_index *idx,
+   *                                  char *text,
+   *                                  sorted_entry *key)
+   *
+   *  @brief sets @p key to the sort key of @p text
+   *
+   *  Text which is not a shared string is keyed half way between the ranks
+   *  of strings sorting either side of it.
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param text - string
+   *  @param key - receives key
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void sorted_text_key(libo_xl_sorted_index *idx, char *text, sorted_entry *key)
+{
+  string *str;
+  int lo = 0, hi = idx->n_ranked, mid;
+  int c = 1;
+
+  while (lo < hi)
   {
-    case libo_xl_freeze_type_none: break;
-    case libo_xl_freeze_type_top:
-      *buf = strapp(*buf, "bottomLeft");
-      break;
-    case libo_xl_freeze_type_left: break;
-      *buf = strapp(*buf, "topRight");
-      break;
+    mid = lo + (hi - lo) / 2;
+    str = strings_find_by_id(idx->xl->strings, idx->by_rank[mid]);
+    if (strcasecmp(str->text, text) < 0) lo = mid + 1;
+    else hi = mid;
   }
-  *buf = strapp(*buf, "\" state=\"frozen\"/>");
-  *buf = strapp(*buf, "<selection pane=\"");
-  switch (sht->freeze.type)
+
+  if (lo < idx->n_ranked)
   {
-    case libo_xl_freeze_type_none: break;
-    case libo_xl_freeze_type_top:
-      *buf = strapp(*buf, "bottomLeft");
-      break;
-    case libo_xl_freeze_type_left: break;
-      *buf = strapp(*buf, "topRight");
-      break;
+    str = strings_find_by_id(idx->xl->strings, idx->by_rank[lo]);
+    c = strcasecmp(str->text, text);
   }
-  *buf = strapp(*buf, "\"/>");
-  *buf = strapp(*buf, "</sheetView>\n");
-  *buf = strapp(*buf, "</sheetViews>\n");
+
+  key->kind = 1;
+  if (lo == idx->n_ranked)
+    key->key = lo ? idx->rank[idx->by_rank[lo - 1]] + 0.5 : 0;
+  else
+    key->key = c ? idx->rank[idx->by_rank[lo]] - 0.5 : idx->rank[idx->by_rank[lo]];
 }
 
- /**
-  * @fn static void libo_xl_sheet_formatpr_add(libo *l,
-  *                                                int sheet,
-  *                                                char **buf)
-  *
-  * @brief adds XL formatpr information to XML buffer
-  *
-  * @param l - pointer to existing @a libo struct
-  * @param sheet - index of sheet in book
-  * @param buf - pointer to string holding XML buffer
-  *
-  * @par Returns
-  * Nothing.
-  */
+  /**
+   *  @fn static int sorted_bound(libo_xl_sorted_index *idx,
+   *                              sorted_entry *key,
+   *                              int upper)
+   *
+   *  @brief returns first position of @p idx whose value is not less
+   *         than, or if @p upper is set greater than, @p key
+   *
+   *  @param idx - pointer to existing @a libo_xl_sorted_index struct
+   *  @param key - pointer to key
+   *  @param upper - 0 for lower bound, 1 for upper bound
+   *
+   *  @return position, from 0 to count
+   */
 
-static void libo_xl_sheet_formatpr_add(libo *l, int sheet, char **buf)
+static int sorted_bound(libo_xl_sorted_index *idx, sorted_entry *key, int upper)
 {
-  char number[25];
+  int lo = 0, hi = idx->n, mid;
+  int c;
 
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (sheet >= l->xl->book->n_sheets) return;
-  if (!buf) return;
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    c = sorted_key_compare(&idx->entry[mid], key);
+    if ((c < 0) || (upper && !c)) lo = mid + 1;
+    else hi = mid;
+  }
 
-  memset(number, 0, 25);
+  return lo;
+}
 
-    /*
-      <sheetFormatPr defaultRowHeight="15" customHeight="1" x14ac:dyDescent="0.3"/>
-    */
+  /**
+   *  @fn static void sort_cell_key(libo_xl_cell *cell,
+   *                                int *rank,
+   *                                int n_strings,
+   *                                sorted_entry *key)
+   *
+   *  @brief sets @p key to the key @p cell is sorted by
+   *
+   *  Kind 0 is numbers, 1 text, 2 booleans, errors and formulas whose
+   *  value is not a number, and 3 empty cells.  FALSE sorts before TRUE,
+   *  and both before errors.
+   *
+   *  @param cell - pointer to existing @a libo_xl_cell struct, or NULL
+   *  @param rank - ranks of shared strings by id, or NULL
+   *  @param n_strings - number of ids in @p rank
+   *  @param key - receives key
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-  *buf = strapp(*buf, "<sheetFormatPr");
-  if (l->xl->book->sheet[sheet]->default_row_height)
+static void sort_cell_key(libo_xl_cell *cell, int *rank, int n_strings, sorted_entry *key)
+{
+  char *end;
+
+  key->key = 0;
+  key->kind = 3;
+
+  if (!cell) return;
+
+  switch (cell->type)
   {
-    *buf = strapp(*buf, " defaultRowHeight=\"");
-    sprintf(number, "%g", l->xl->book->sheet[sheet]->default_row_height);
-    *buf = strapp(*buf, number);
-    *buf = strapp(*buf, "\"");
-    *buf = strapp(*buf, " customHeight=\"1\"");
+    case libo_xl_cell_type_number:
+    case libo_xl_cell_type_date:
+      key->kind = 0;
+      key->key = cell->number;
+      break;
+
+    case libo_xl_cell_type_reference:
+      key->kind = 1;
+      if (rank && (cell->reference >= 0) && (cell->reference < n_strings))
+        key->key = rank[cell->reference];
+      break;
+
+    case libo_xl_cell_type_expression:
+      if (!cell->expression.value || !*cell->expression.value) break;
+      key->kind = 2;
+      key->key = strtod(cell->expression.value, &end);
+      if (!*end) key->kind = 0;
+      break;
+
+    case libo_xl_cell_type_boolean:
+      key->kind = 2;
+      key->key = cell->boolean;
+      break;
+
+    case libo_xl_cell_type_error:
+      key->kind = 2;
+      key->key = 2;
+      break;
+
+    default:
+      break;
   }
-  *buf = strapp(*buf," x14ac:dyDescent=\"0.3\"/>\n");
 }
 
- /**
-  * @fn static void libo_xl_sheet_cols_add(libo *l, int sheet, char **buf)
-  *
-  * @brief adds XL worksheet column attributes to XML buffer
-  *
-  * @param l - pointer to existing @a libo struct
-  * @param sheet - index of sheet in book
-  * @param buf - pointer to string holding XML buffer
-  *
-  * @par Returns
-  * Nothing.
-  */
+  /**
+   *  @fn static int sort_rows_compare(int a, int b, void *data)
+   *
+   *  @brief compares rows @p a and @p b by the keys of a sort
+   *
+   *  @param a - index of first row
+   *  @param b - index of second row
+   *  @param data - pointer to @a sort_context
+   *
+   *  @return less than, equal to, or greater than 0 as @p a sorts before,
+   *          with, or after @p b
+   */
 
-static void libo_xl_sheet_cols_add(libo *l, int sheet, char **buf)
+static int sort_rows_compare(int a, int b, void *data)
 {
-  char number[25];
-  int i;
-  libo_xl_column *col;
-  libo_xl_sheet *sht;
+  sort_context *ctx = (sort_context *)data;
+  sorted_entry *ea = &ctx->entry[(size_t)a * ctx->n_keys];
+  sorted_entry *eb = &ctx->entry[(size_t)b * ctx->n_keys];
+  libo_xl_cell *ca, *cb;
+  int c;
+  int k;
 
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (!l->xl) return;
-  if (!l->xl->book) return;
-  if (sheet >= l->xl->book->n_sheets) return;
-  if (!buf) return;
+  for (k = 0; k < ctx->n_keys; k++, ea++, eb++)
+  {
+      // empty cells go last whichever way the key runs
 
-  memset(number, 0, 25);
+    if ((ea->kind == 3) || (eb->kind == 3))
+    {
+      c = (ea->kind == 3) - (eb->kind == 3);
+      if (c) return c;
+      continue;
+    }
 
-  sht = l->xl->book->sheet[sheet];
+    c = sorted_key_compare(ea, eb);
+    if (!c && (ea->kind == 2))
+    {
+      ca = libo_xl_row_get_cell(ctx->row[a], ctx->key[k].col);
+      cb = libo_xl_row_get_cell(ctx->row[b], ctx->key[k].col);
 
-  if (!sht->column) sht->column = libo_xl_sheet_columns_create_defaults(sht);
-  if (!sht->column) return;
+        // only formula results have text, booleans and errors tie on key
 
-    /*
-      <cols>
-        <col min="1" max="1" width="16.88671875" bestFit="1" customWidth="1"/>
-      </cols>
-    */
+      if ((ca->type == libo_xl_cell_type_expression) &&
+          (cb->type == libo_xl_cell_type_expression))
+        c = strcasecmp(ca->expression.value, cb->expression.value);
+    }
 
-  *buf = strapp(*buf,"<cols>\n");
-  for (i = 0; i < sht->n_cols; i++)
-  {
-    col = sht->column[i];
+    if (c) return ctx->key[k].descending ? -c : c;
+  }
 
-    *buf = strapp(*buf, "<col min=\"");
-    sprintf(number, "%d", i+1);
-    *buf = strapp(*buf, number);
-    *buf = strapp(*buf, "\" max=\"");
-    *buf = strapp(*buf, number);
-    *buf = strapp(*buf, "\" width=\"");
-    sprintf(number, "%f", col->width);
+  return 0;
+}
+
+  /**
+   *  @fn static void libo_xl_sheet_sortstate_add(libo_xl_sheet *sheet,
+   *                                              unsigned int first_column,
+   *                                              unsigned int last_column,
+   *                                              char **buf)
+   *
+   *  @brief adds XL sort state of @p sheet to XML buffer
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param first_column - first column of sorted range
+   *  @param last_column - last column of sorted range
+   *  @param buf - pointer to string holding XML buffer
+   *
+   *  @par Returns
+   *  Nothing.
+   */
+
+static void libo_xl_sheet_sortstate_add(libo_xl_sheet *sheet,
+                                        unsigned int first_column,
+                                        unsigned int last_column,
+                                        char **buf)
+{
+  char number[25];
+  int first_row = 2;
+  int i;
+
+  if (sheet->sort) first_row = sheet->sort->first_row + 1;
+
+  *buf = strapp(*buf, "<sortState xmlns:xlrd2=\"http://schemas.microsoft.com/office/spreadsheetml/2017/richdata2\" ref=\"");
+  *buf = strapp(*buf, column_number_to_reference(first_column));
+  sprintf(number, "%d", first_row);
+  *buf = strapp(*buf, number);
+  *buf = strapp(*buf, ":");
+  *buf = strapp(*buf, column_number_to_reference(last_column));
+  sprintf(number, "%d", sheet->n_rows);
+  *buf = strapp(*buf, number);
+  *buf = strapp(*buf, "\">");
+
+  for (i = 0; sheet->sort && (i < sheet->sort->n_keys); i++)
+  {
+    *buf = strapp(*buf, "<sortCondition");
+    if (sheet->sort->key[i].descending)
+      *buf = strapp(*buf, " descending=\"1\"");
+    *buf = strapp(*buf, " ref=\"");
+    *buf = strapp(*buf, column_number_to_reference(sheet->sort->key[i].col));
+    sprintf(number, "%d", first_row);
     *buf = strapp(*buf, number);
-    *buf = strapp(*buf, "\" bestfit=\"");
-    sprintf(number, "%d", col->autowidth ? 1 : 0);
+    *buf = strapp(*buf, ":");
+    *buf = strapp(*buf, column_number_to_reference(sheet->sort->key[i].col));
+    sprintf(number, "%d", sheet->n_rows);
     *buf = strapp(*buf, number);
-    *buf = strapp(*buf, "\" customWidth=\"1\"/>\n");
+    *buf = strapp(*buf, "\"/>");
   }
-  *buf = strapp(*buf,"</cols>\n");
+
+  *buf = strapp(*buf, "</sortState>");
 }
 
- /**
-  * @fn static void libo_xl_sheet_sheetdata_add(libo *l,
-  *                                                 int sheet,
-  *                                                 char **buf)
-  *
-  * @brief adds XL worksheet data to XML buffer
-  *
-  * @param l - pointer to existing @a libo struct
-  * @param sheet - index of sheet in book
-  * @param buf - pointer to string holding XML buffer
-  *
-  * @par Returns
-  * Nothing.
-  */
+  /**
+   *  @fn static libo_xl_view *libo_xl_view_new(libo_xl_sheet *sheet)
+   *
+   *  @brief returns new empty @a libo_xl_view struct over @p sheet
+   *
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *
+   *  @return pointer to new @a libo_xl_view struct, NULL on failure
+   */
+
+static libo_xl_view *libo_xl_view_new(libo_xl_sheet *sheet)
+{
+  libo_xl_view *view;
+
+  view = (libo_xl_view *)malloc(sizeof(libo_xl_view));
+  if (!view) return NULL;
+  memset(view, 0, sizeof(libo_xl_view));
+
+  view->sheet = sheet;
+
+  return view;
+}
+
+  /**
+   *  @fn static int view_test_init(view_test *test, libo_xl_predicate *pred)
+   *
+   *  @brief prepares @p test to evaluate @p pred
+   *
+   *  Comparisons become a closed range, so one kernel serves them all.
+   *  Large sets of ids become a table indexed by id.
+   *
+   *  @param test - pointer to @a view_test struct
+   *  @param pred - pointer to existing @a libo_xl_predicate struct
+   *
+   *  @return 0 on success, -1 on failure
+   */
+
+static int view_test_init(view_test *test, libo_xl_predicate *pred)
+{
+  int i;
+
+  pthread_once(&_stats_once, stats_kernels_select);
+
+  memset(test, 0, sizeof(view_test));
+
+  switch (pred->op)
+  {
+    case libo_xl_predicate_op_equal:
+      test->lo = test->hi = pred->lo;
+      break;
+
+    case libo_xl_predicate_op_not_equal:
+      test->lo = test->hi = pred->lo;
+      test->negate = 1;
+      break;
+
+    case libo_xl_predicate_op_less:
+      test->lo = -INFINITY;
+      test->hi = nextafter(pred->lo, -INFINITY);
+      break;
 
-static void libo_xl_sheet_sheetdata_add(libo *l, int sheet, char **buf)
-{
-  int i;
+    case libo_xl_predicate_op_less_equal:
+      test->lo = -INFINITY;
+      test->hi = pred->lo;
+      break;
 
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (sheet >= l->xl->book->n_sheets) return;
-  if (!buf) return;
+    case libo_xl_predicate_op_greater:
+      test->lo = nextafter(pred->lo, INFINITY);
+      test->hi = INFINITY;
+      break;
 
-    /*
-      <sheetData>
-        ROWS
-      </sheetData>
-    */
+    case libo_xl_predicate_op_greater_equal:
+      test->lo = pred->lo;
+      test->hi = INFINITY;
+      break;
 
-  *buf = strapp(*buf, "<sheetData>\n");
-  for (i = 0; i < l->xl->book->sheet[sheet]->n_rows; i++)
-    libo_xl_sheet_sheetdata_row_add(l, sheet, i, buf);
-  *buf = strapp(*buf, "</sheetData>\n");
-}
+    case libo_xl_predicate_op_between:
+      test->lo = pred->lo;
+      test->hi = pred->hi;
+      break;
 
- /**
-  * @fn static void libo_xl_sheet_sheetdata_row_add(libo *l,
-  *                                                     int sheet,
-  *                                                     int row,
-  *                                                     char **buf)
-  *
-  * @brief adds XL worksheet row data to XML buffer
-  *
-  * @param l - pointer to existing @a libo struct
-  * @param sheet - index of sheet in book
-  * @param row - index of row in sheet
-  * @param buf - pointer to string holding XML buffer
-  *
-  * @par Returns
-  * Nothing.
-  */
+    case libo_xl_predicate_op_in:
+      if ((pred->n_ids < 0) || (pred->n_ids && !pred->ids)) return -1;
+      test->sets = 1;
+      test->n_ids = pred->n_ids;
+      test->ids = pred->ids;
+      break;
 
-static void libo_xl_sheet_sheetdata_row_add(libo *l, int sheet, int row, char **buf)
-{
-  int i;
-  char number[25];
+    default:
+      return -1;
+  }
 
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (!l->xl->book) return;
-  if (sheet >= l->xl->book->n_sheets) return;
-  if (!buf) return;
+  if (test->sets)
+    test->id = (int *)malloc(sizeof(int) * LIBO_XL_VIEW_BLOCK);
+  else
+  {
+    test->number = (double *)malloc(sizeof(double) * LIBO_XL_VIEW_BLOCK);
+    test->ordered = (uint64_t *)malloc(sizeof(uint64_t) * (LIBO_XL_VIEW_BLOCK / 64));
+  }
 
-  memset(number, 0, 25);
+  if (test->sets ? !test->id : (!test->number || !test->ordered))
+  {
+    view_test_clear(test);
+    return -1;
+  }
 
-    /*
-      NOTE:  Not sure what s="1" is, selected?
-      <row r="1" spans="1:7" s="1" customFormat="1" ht="15" customHeight="1" x14ac:dyDescent="0.3">
-        COLS
-      </row>
-    */
+  if (test->n_ids > LIBO_XL_VIEW_SET_MAX)
+  {
+    for (i = 0; i < test->n_ids; i++)
+      if (test->ids[i] >= test->n_member) test->n_member = test->ids[i] + 1;
 
-  *buf = strapp(*buf, "<row r=\"");
-  sprintf(number, "%d", row+1);
-  *buf = strapp(*buf, number);
-  *buf = strapp(*buf, "\" spans=\"1:");
-  sprintf(number, "%d", l->xl->book->sheet[sheet]->n_cols);
-  *buf = strapp(*buf, number);
-  *buf = strapp(*buf, "\" customFormat=\"1\" ht=\"");
-  sprintf(number, "%g", l->xl->book->sheet[sheet]->default_row_height);
-  *buf = strapp(*buf, number);
-  *buf = strapp(*buf, "\" customHeight=\"1\" x14ac:dyDescent=\"0.3\">\n");
-  for (i = 0; i < l->xl->book->sheet[sheet]->row[row]->n_cells; i++)
-    libo_xl_sheet_sheetdata_row_col_add(l, sheet, row, i, buf);
-  *buf = strapp(*buf, "</row>\n");
+    test->member = (unsigned char *)malloc(test->n_member ? test->n_member : 1);
+    if (!test->member)
+    {
+      view_test_clear(test);
+      return -1;
+    }
+    memset(test->member, 0, test->n_member);
+
+    for (i = 0; i < test->n_ids; i++)
+      if (test->ids[i] >= 0) test->member[test->ids[i]] = 1;
+  }
+
+  return 0;
 }
 
- /**
-  * @fn static void libo_xl_sheet_sheetdata_row_col_add(libo *l,
-  *                                                         int sheet,
-  *                                                         int row,
-  *                                                         int col,
-  *                                                         char **buf)
-  *
-  * @brief adds XL worksheet cell data to XML buffer
-  *
-  * @param l - pointer to existing @a libo struct
-  * @param sheet - index of sheet in book
-  * @param row - index of row in sheet
-  * @param col - index of col in row
-  * @param buf - pointer to string holding XML buffer
-  *
-  * @par Returns
-  * Nothing.
-  */
+  /**
+   *  @fn static void view_test_clear(view_test *test)
+   *
+   *  @brief frees all memory allocated to contents of @p test
+   *
+   *  @param test - pointer to existing @a view_test struct
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-static void libo_xl_sheet_sheetdata_row_col_add(libo *l,
-                                                    int sheet,
-                                                    int row,
-                                                    int col,
-                                                    char **buf)
+static void view_test_clear(view_test *test)
 {
-  libo_xl_cell *cell;
-  libo_xl_sheet *sht;
-  char number[25];
-
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (!l->xl->book) return;
-  if (sheet >= l->xl->book->n_sheets) return;
-  if (!buf) return;
+  free(test->number);
+  free(test->id);
+  free(test->ordered);
+  free(test->member);
 
-  sht = l->xl->book->sheet[sheet];
-  if (!sht) return;
+  memset(test, 0, sizeof(view_test));
+}
 
-  if (row >= sht->n_rows) return;
-  if (col >= sht->n_cols) return;
+  /**
+   *  @fn static void view_test_rows(view_test *test,
+   *                                 libo_xl_sheet *sheet,
+   *                                 int col,
+   *                                 int first,
+   *                                 int n,
+   *                                 uint64_t *words)
+   *
+   *  @brief sets bits of @p words for rows @p first to @p first + @p n of
+   *         @p sheet matching @p test
+   *
+   *  Values of a block of rows are gathered into an array, padded to a
+   *  whole word with values matching nothing, and handed to a kernel.
+   *
+   *  @param test - pointer to existing @a view_test struct
+   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param col - index of column
+   *  @param first - index of first row
+   *  @param n - number of rows, at most LIBO_XL_VIEW_SPAN
+   *  @param words - LIBO_XL_VIEW_WORDS words receiving a bit for each row
+   *
+   *  @par Returns
+   *  Nothing.
+   */
 
-  cell = sht->row[row]->cell[col];
+static void view_test_rows(view_test *test,
+                           libo_xl_sheet *sheet,
+                           int col,
+                           int first,
+                           int n,
+                           uint64_t *words)
+{
+  libo_xl_cell *cell;
+  uint64_t *out;
+  int block, m, padded;
+  int i, id;
 
-    /*
-      <c r="A1" s="1" t="s"> //shared strings id
-        <v>0</v>
-      </c>
-      <c r="C2" s="2"> //direct value (number)
-        <v>156057</v>
-      </c>
-    */
-  *buf = strapp(*buf, "<c r=\"");
-  *buf = strapp(*buf, column_number_to_reference(col));
-  sprintf(number, "%d", row+1);
-  *buf = strapp(*buf, number);
+  memset(words, 0, sizeof(uint64_t) * LIBO_XL_VIEW_WORDS);
 
-  switch (cell->type)
+  for (block = 0; block < n; block += LIBO_XL_VIEW_BLOCK)
   {
-    case libo_xl_cell_type_none: break;
+    m = n - block;
+    if (m > LIBO_XL_VIEW_BLOCK) m = LIBO_XL_VIEW_BLOCK;
+    padded = (m + 63) & ~63;
+    out = words + block / 64;
 
-    case libo_xl_cell_type_reference:
-      *buf = strapp(*buf, "\" s=\"1\" t=\"s\">\n");
-      break;
+    for (i = 0; i < m; i++)
+    {
+      cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, first + block + i), col);
+
+      if (test->sets)
+        test->id[i] = (cell && (cell->type == libo_xl_cell_type_reference)) ?
+                      cell->reference : -1;
+      else
+        test->number[i] = cell_is_number(cell) ?
+                          cell->number : NAN;
+    }
 
-#warning finish this
-    case libo_xl_cell_type_expression:
-      *buf = strapp(*buf, ">\n");
-      break;
+    for (; i < padded; i++)
+    {
+      if (test->sets) test->id[i] = -1;
+      else test->number[i] = NAN;
+    }
 
-    case libo_xl_cell_type_number:
-      *buf = strapp(*buf, "\" s=\"2\">\n");
-      break;
+    if (test->member)
+    {
+      for (i = 0; i < m; i++)
+      {
+        id = test->id[i];
+        if ((id >= 0) && (id < test->n_member) && test->member[id])
+          out[i / 64] |= (uint64_t)1 << (i % 64);
+      }
+    }
+    else if (test->sets)
+      _filter_member(test->id, padded, test->ids, test->n_ids, out);
+    else
+    {
+      _filter_range(test->number, padded, test->lo, test->hi, out);
+
+      if (test->negate)
+      {
+        _filter_range(test->number, padded, -INFINITY, INFINITY, test->ordered);
+        for (i = 0; i < padded / 64; i++)
+          out[i] = test->ordered[i] & ~out[i];
+      }
+    }
   }
+}
 
-  *buf = strapp(*buf, "<v>");
+  /**
+   *  @fn static int view_test_token(view_test *test, char *t, char *v)
+   *
+   *  @brief returns whether a cell read with type attribute @p t and value
+   *         @p v matches @p test
+   *
+   *  Values are taken as @a libo_xl_cell_parse would take them, without
+   *  building the cell.
+   *
+   *  @param test - pointer to existing @a view_test struct
+   *  @param t - type attribute of cell, or NULL
+   *  @param v - value of cell, or NULL
+   *
+   *  @return 1 if cell matches, 0 otherwise
+   */
 
-  switch (cell->type)
+static int view_test_token(view_test *test, char *t, char *v)
+{
+  libo_xl_cell_type type;
+  double number;
+  int id;
+  int i;
+
+  type = t ? string_to_libo_xl_cell_type(t) : libo_xl_cell_type_number;
+
+  if (test->sets)
   {
-    case libo_xl_cell_type_none: break;
+    if (type != libo_xl_cell_type_reference) return 0;
 
-    case libo_xl_cell_type_reference:
-      sprintf(number, "%d", cell->reference);
-      *buf = strapp(*buf, number);
-      //*buf = strapp(*buf, "\n");
-      break;
+    id = v ? atoi(v) : 0;
 
-#warning must handle expression type here
-    case libo_xl_cell_type_expression: break;
+    if (test->member)
+      return (id >= 0) && (id < test->n_member) && test->member[id];
 
-    case libo_xl_cell_type_number:
-      sprintf(number, "%g", cell->number);
-      *buf = strapp(*buf, number);
-      //*buf = strapp(*buf, "\n");
-      break;
+    for (i = 0; i < test->n_ids; i++)
+      if (test->ids[i] == id) return 1;
+
+    return 0;
   }
 
-  *buf = strapp(*buf, "</v>\n");
-  *buf = strapp(*buf, "</c>\n");
+    // numbers without a value are empty
+
+  if ((type != libo_xl_cell_type_number) || !v) return 0;
+
+  number = atof(v);
+  if (isnan(number)) return 0;
+
+  return ((number >= test->lo) && (number <= test->hi)) != test->negate;
 }
 
- /**
-  * @fn static void libo_xl_sheet_filter_add(libo *l, int sheet, char **buf)
-  *
-  * @brief adds XL worksheet filter information to XML buffer
-  *
-  * @param l - pointer to existing @a libo struct
-  * @param sheet - index of sheet in book
-  * @param buf - pointer to string holding XML buffer
-  *
-  * @par Returns
-  * Nothing.
-  */
+  /**
+   *  @fn static int view_container_add(libo_xl_view *view,
+   *                                    int key,
+   *                                    const uint64_t *words)
+   *
+   *  @brief appends container @p key holding rows set in @p words to
+   *         @p view
+   *
+   *  Containers with few rows keep them as a sorted array, others keep
+   *  the bits.  Empty containers are not kept.  Keys must be added in
+   *  increasing order.
+   *
+   *  @param view - pointer to existing @a libo_xl_view struct
+   *  @param key - index of span of LIBO_XL_VIEW_SPAN rows
+   *  @param words - LIBO_XL_VIEW_WORDS words holding a bit for each row
+   *
+   *  @return 0 on success, -1 on failure
+   */
 
-static void libo_xl_sheet_filter_add(libo *l, int sheet, char **buf)
+static int view_container_add(libo_xl_view *view, int key, const uint64_t *words)
 {
-  libo_xl_sheet *sht;
-  char number[25];
-
-  if (!l) return;
-  if (l->type != libo_type_xl) return;
-  if (!l->xl->book) return;
-  if (sheet >= l->xl->book->n_sheets) return;
-  if (!buf) return;
+  view_container *c;
+  uint64_t w;
+  int count = 0;
+  int i, k;
 
-  sht = l->xl->book->sheet[sheet];
-  if (!sht) return;
-  if (!sht->filter) return;
+  for (i = 0; i < LIBO_XL_VIEW_WORDS; i++)
+    count += __builtin_popcountll(words[i]);
 
-    /*
-      <autoFilter ref="A1:E6" xr:uid="{00000000-0009-0000-0000-000000000000}">
-        <sortState xmlns:xlrd2="http://schemas.microsoft.com/office/spreadsheetml/2017/richdata2" ref="A2:E6">
-          <sortCondition ref="A2:A6"/>
-        </sortState>
-      </autoFilter>
-    */
+  if (!count) return 0;
 
-  *buf = strapp(*buf, "<autoFilter ref=\"");
-  *buf = strapp(*buf, column_number_to_reference(sht->filter->first_column));
-  sprintf(number, "%d", 1);
-  *buf = strapp(*buf, number);
-  *buf = strapp(*buf, ":");
-  *buf = strapp(*buf, column_number_to_reference(sht->filter->last_column));
-  sprintf(number, "%d", sht->n_rows);
-  *buf = strapp(*buf, number);
-  *buf = strapp(*buf, "\" xr:uid=\"{00000000-0009-0000-0000-000000000000}\">");
-  *buf = strapp(*buf, "<sortState xmlns:xlrd2=\"http://schemas.microsoft.com/office/spreadsheetml/2017/richdata2\" ref=\"");
-  *buf = strapp(*buf, column_number_to_reference(sht->filter->first_column));
-  sprintf(number, "%d", 2);
-  *buf = strapp(*buf, number);
-  *buf = strapp(*buf, ":");
-  *buf = strapp(*buf, column_number_to_reference(sht->filter->last_column));
-  sprintf(number, "%d", sht->n_rows);
-  *buf = strapp(*buf, number);
-  *buf = strapp(*buf, "\">");
-  *buf = strapp(*buf, "</sortState>");
-  *buf = strapp(*buf, "</autoFilter>");
+  if (view->n_containers == view->size)
+  {
+    c = (view_container *)realloc(view->container,
+                                  sizeof(view_container) * (view->size ? 2 * view->size : 4));
+    if (!c) return -1;
+    view->container = c;
+    view->size = view->size ? 2 * view->size : 4;
+  }
+
+  c = &view->container[view->n_containers];
+  memset(c, 0, sizeof(view_container));
+  c->key = key;
+  c->n = count;
+
+  if (count <= LIBO_XL_VIEW_ARRAY_MAX)
+  {
+    c->array = (uint16_t *)malloc(sizeof(uint16_t) * count);
+    if (!c->array) return -1;
+
+    for (i = 0, k = 0; i < LIBO_XL_VIEW_WORDS; i++)
+    {
+      for (w = words[i]; w; w &= w - 1)
+        c->array[k++] = (uint16_t)(i * 64 + __builtin_ctzll(w));
+    }
+  }
+  else
+  {
+    c->bits = (uint64_t *)malloc(sizeof(uint64_t) * LIBO_XL_VIEW_WORDS);
+    if (!c->bits) return -1;
+    memcpy(c->bits, words, sizeof(uint64_t) * LIBO_XL_VIEW_WORDS);
+  }
+
+  ++view->n_containers;
+  view->count += count;
+
+  return 0;
 }
 
   /**
-   *  @fn void libo_xl_strings_count_action(avl_node *n)
+   *  @fn static void view_container_words(view_container *c, uint64_t *words)
    *
-   *  @brief called by avl_walk() when counting XL strings
+   *  @brief sets @p words to the bits of rows held by @p c
    *
-   *  @param n - pointer to existing @a avl_node
+   *  @param c - pointer to existing @a view_container struct
+   *  @param words - LIBO_XL_VIEW_WORDS words receiving a bit for each row
    *
    *  @par Returns
    *  Nothing.
    */
 
-static void libo_xl_strings_count_action(avl_node *n) { ++_strings_count; }
+static void view_container_words(view_container *c, uint64_t *words)
+{
+  int i;
+
+  if (c->bits)
+  {
+    memcpy(words, c->bits, sizeof(uint64_t) * LIBO_XL_VIEW_WORDS);
+    return;
+  }
+
+  memset(words, 0, sizeof(uint64_t) * LIBO_XL_VIEW_WORDS);
+
+  for (i = 0; i < c->n; i++)
+    words[c->array[i] / 64] |= (uint64_t)1 << (c->array[i] % 64);
+}
 
   /**
-   *  @fn void libo_xl_strings_add_action(avl_node *n)
+   *  @fn static view_container *view_container_find(libo_xl_view *view,
+   *                                                 int key)
    *
-   *  @brief called by avl_walk() when adding XML content to strings
+   *  @brief returns first container of @p view whose key is not less
+   *         than @p key
    *
-   *  @param n - pointer to existing @a avl_node
+   *  @param view - pointer to existing @a libo_xl_view struct
+   *  @param key - index of span of LIBO_XL_VIEW_SPAN rows
    *
-   *  @par Returns
-   *  Nothing.
+   *  @return pointer to container, NULL if none
    */
 
-static void libo_xl_strings_add_action(avl_node *n)
+static view_container *view_container_find(libo_xl_view *view, int key)
 {
-  string_node *sn;
-  string *str;
-
-  if (!n) return;
+  int lo = 0, hi = view->n_containers, mid;
 
-  sn = (string_node *)n;
-
-  str = &sn->value;
-  if (!str) return;
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    if (view->container[mid].key < key) lo = mid + 1;
+    else hi = mid;
+  }
 
-  _strings_buf = strapp(_strings_buf, "<si>");
-  _strings_buf = strapp(_strings_buf, "<t>");
-  _strings_buf = strapp(_strings_buf, str->text);
-  _strings_buf = strapp(_strings_buf, "</t>");
-  _strings_buf = strapp(_strings_buf, "</si>");
+  return (lo < view->n_containers) ? &view->container[lo] : NULL;
 }
 
   /**
-   *  @fn char *column_number_to_reference(unsigned int n)
+   *  @fn static int view_container_next(view_container *c, int low)
    *
-   *  @brief converts a column number to XL cell reference
+   *  @brief returns first row of @p c not less than @p low
    *
-   *  @param n - column number
+   *  @param c - pointer to existing @a view_container struct
+   *  @param low - row within span of container
    *
-   *  @return string containing XL cell reference
+   *  @return row within span of container, -1 if none
    */
 
-static char *column_number_to_reference(unsigned int n)
+static int view_container_next(view_container *c, int low)
 {
-  static char ref[10];
-  int i = 0;
-  unsigned int r;
+  uint64_t w;
+  int lo = 0, hi = c->n, mid;
+  int i;
 
-  memset(ref, 0, 10);
+  if (c->array)
+  {
+    while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (c->array[mid] < low) lo = mid + 1;
+      else hi = mid;
+    }
 
-  ++n;
+    return (lo < c->n) ? c->array[lo] : -1;
+  }
 
-  do
-  {
-    r = (n - 1) % 26;
-    n = (n - 1) / 26;
-    ref[i] = 'A' + r;
-    ++i;
-  } while (n);
+  i = low / 64;
+  w = c->bits[i] & (~(uint64_t)0 << (low % 64));
 
-  return reverse(ref);
+  for (;;)
+  {
+    if (w) return i * 64 + __builtin_ctzll(w);
+    if (++i == LIBO_XL_VIEW_WORDS) return -1;
+    w = c->bits[i];
+  }
 }
 
   /**
-   *  @fn char *reverse(char *s)
+   *  @fn static libo_xl_view *view_combine(libo_xl_view *a,
+   *                                        libo_xl_view *b,
+   *                                        int any)
    *
-   *  @brief reverses order of characters in a string
+   *  @brief returns view of rows found in both, or if @p any is set
+   *         either, of @p a and @p b
    *
-   *  NOTE:  It is the caller's responsibility to free allocated memory
-   *         of the reversed string
+   *  Containers with the same key are combined a word at a time.
    *
-   *  @param s - string to reverse
+   *  @param a - pointer to existing @a libo_xl_view struct
+   *  @param b - pointer to existing @a libo_xl_view struct
+   *  @param any - 0 for intersection, 1 for union
    *
-   *  @return reversed string
+   *  @return pointer to new @a libo_xl_view struct, NULL on failure
    */
 
-static char *reverse(char *s)
+static libo_xl_view *view_combine(libo_xl_view *a, libo_xl_view *b, int any)
 {
-  int len;
-  int i, j;
-  char *t;
+  libo_xl_view *view;
+  uint64_t *wa = NULL, *wb = NULL;
+  view_container *ca, *cb;
+  int i = 0, j = 0, k;
 
-  if (!s) return NULL;
+  if (!a || !b) return NULL;
 
-  len = strlen(s);
-  if (len < 2) return s;
+  view = libo_xl_view_new(a->sheet);
+  wa = (uint64_t *)malloc(sizeof(uint64_t) * LIBO_XL_VIEW_WORDS);
+  wb = (uint64_t *)malloc(sizeof(uint64_t) * LIBO_XL_VIEW_WORDS);
+  if (!view || !wa || !wb) goto bail;
 
-  t = strdup(s);
-  memset(t, 0, len);
+  while ((i < a->n_containers) || (j < b->n_containers))
+  {
+    ca = (i < a->n_containers) ? &a->container[i] : NULL;
+    cb = (j < b->n_containers) ? &b->container[j] : NULL;
 
-  i = 0;
-  j = len - 1;
-  while (i < len) t[i++] = s[j--];
+    if (ca && cb && (ca->key == cb->key))
+    {
+      view_container_words(ca, wa);
+      view_container_words(cb, wb);
+      for (k = 0; k < LIBO_XL_VIEW_WORDS; k++)
+        wa[k] = any ? (wa[k] | wb[k]) : (wa[k] & wb[k]);
+      if (view_container_add(view, ca->key, wa)) goto bail;
+      i++;
+      j++;
+    }
+    else if (ca && (!cb || (ca->key < cb->key)))
+    {
+      if (any)
+      {
+        view_container_words(ca, wa);
+        if (view_container_add(view, ca->key, wa)) goto bail;
+      }
+      i++;
+    }
+    else
+    {
+      if (any)
+      {
+        view_container_words(cb, wb);
+        if (view_container_add(view, cb->key, wb)) goto bail;
+      }
+      j++;
+    }
+  }
 
-  strcpy(s, t);
-  free(t);
+  free(wa);
+  free(wb);
 
-  return s;
+  return view;
+
+bail:
+  free(wa);
+  free(wb);
+  libo_xl_view_free(view);
+
+  return NULL;
 }
 
   /**
-   *  @fn void libo_xl_row_fill(libo_xl_sheet *sheet, int max_row)
+   *  @fn static void filter_range_scalar(const double *v,
+   *                                      int n,
+   *                                      double lo,
+   *                                      double hi,
+   *                                      uint64_t *bits)
    *
-   *  @brief fills XL worksheet with rows up to @p max_row
+   *  @brief sets a bit of @p bits for each number of @p v from @p lo to
+   *         @p hi, inclusive
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
-   *  @param max_row - index of last row to create
+   *  @param v - array of numbers, NaN matching nothing
+   *  @param n - number of numbers in @p v, a multiple of 64
+   *  @param lo - smallest matching number
+   *  @param hi - largest matching number
+   *  @param bits - receives @p n / 64 words
    *
    *  @par Returns
    *  Nothing.
    */
 
-static void libo_xl_row_fill(libo_xl_sheet *sheet, int max_row)
+static void filter_range_scalar(const double *v, int n, double lo, double hi, uint64_t *bits)
 {
-  int i;
-
-  if (!sheet) return;
-
-  if (sheet->row)
-    sheet->row = (libo_xl_row **)realloc(sheet->row, sizeof(libo_xl_row *) * max_row);
-  else
-    sheet->row = (libo_xl_row **)malloc(sizeof(libo_xl_row *) * max_row);
-
-  for (i = sheet->n_rows; i < max_row; i++)
-    sheet->row[i] = libo_xl_row_new();
-
-  sheet->n_rows = max_row;
+  uint64_t w;
+  int i, j;
 
-  return;
+  for (i = 0; i < n; i += 64)
+  {
+    w = 0;
+    for (j = 0; j < 64; j++)
+      w |= (uint64_t)((v[i + j] >= lo) & (v[i + j] <= hi)) << j;
+    bits[i / 64] = w;
+  }
 }
 
   /**
-   *  @fn void libo_xl_col_fill(libo_xl_sheet *sheet,
-   *                            int row,
-   *                            int max_col)
+   *  @fn static void filter_member_scalar(const int *v,
+   *                                       int n,
+   *                                       const int *ids,
+   *                                       int n_ids,
+   *                                       uint64_t *bits)
    *
-   *  @brief fills XL row of worksheet with cells up to @p max_col
+   *  @brief sets a bit of @p bits for each id of @p v found in @p ids
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
-   *  @param row - index of row to fill
-   *  @param max_col - index of last col to create
+   *  @param v - array of ids, -1 matching nothing
+   *  @param n - number of ids in @p v, a multiple of 64
+   *  @param ids - set of ids
+   *  @param n_ids - number of ids in @p ids
+   *  @param bits - receives @p n / 64 words
    *
    *  @par Returns
    *  Nothing.
    */
 
-static void libo_xl_col_fill(libo_xl_sheet *sheet, int row, int max_col)
+static void filter_member_scalar(const int *v, int n, const int *ids, int n_ids, uint64_t *bits)
 {
-  int i;
-
-  if (!sheet) return;
-
-  if (row >= sheet->n_rows) libo_xl_row_fill(sheet, row);
-
-  if (sheet->row[row]->cell)
-    sheet->row[row]->cell = (libo_xl_cell **)realloc(sheet->row[row]->cell, sizeof(libo_xl_cell *) * max_col);
-  else
-    sheet->row[row]->cell = (libo_xl_cell **)malloc(sizeof(libo_xl_cell *) * max_col);
-
-  for (i = sheet->row[row]->n_cells; i < max_col; i++)
-    sheet->row[row]->cell[i] = libo_xl_cell_new();
-
-  sheet->row[row]->n_cells = max_col;
+  uint64_t w;
+  int i, j, k;
 
-  return;
+  for (i = 0; i < n; i += 64)
+  {
+    w = 0;
+    for (j = 0; j < 64; j++)
+    {
+      if (v[i + j] < 0) continue;
+      for (k = 0; k < n_ids; k++)
+        if (v[i + j] == ids[k]) break;
+      if (k < n_ids) w |= (uint64_t)1 << j;
+    }
+    bits[i / 64] = w;
+  }
 }
 
+#ifdef X86_KERNELS
+
   /**
-   *  @fn void string_dumper(avl_node *n)
+   *  @fn static void filter_range_sse2(const double *v,
+   *                                    int n,
+   *                                    double lo,
+   *                                    double hi,
+   *                                    uint64_t *bits)
    *
-   *  @brief outputs @a string struct contents for "dumpers"
+   *  @brief SSE2 version of @a filter_range_scalar, two numbers at a time
    *
-   *  @param n - pointer to existing @a avl_node struct
+   *  @param v - array of numbers, NaN matching nothing
+   *  @param n - number of numbers in @p v, a multiple of 64
+   *  @param lo - smallest matching number
+   *  @param hi - largest matching number
+   *  @param bits - receives @p n / 64 words
    *
    *  @par Returns
    *  Nothing.
    */
 
-static void string_dumper(avl_node *n)
+__attribute__((target("sse2")))
+static void filter_range_sse2(const double *v, int n, double lo, double hi, uint64_t *bits)
 {
-  string_node *sn;
-  string *str = NULL;
-
-  if (!n) return;
-
-  sn = (string_node *)n;
-
-  str = &sn->value;
+  __m128d l = _mm_set1_pd(lo);
+  __m128d h = _mm_set1_pd(hi);
+  __m128d a;
+  uint64_t w;
+  int i, j;
 
-  do_indent(_dumper_file, _strings_indent);
-  fprintf(_dumper_file,
-          "id=%d, text='%s'\n",
-          str->id,
-          str->text ? str->text : "");
+  for (i = 0; i < n; i += 64)
+  {
+    w = 0;
+    for (j = 0; j < 64; j += 2)
+    {
+      a = _mm_loadu_pd(v + i + j);
+      a = _mm_and_pd(_mm_cmpge_pd(a, l), _mm_cmple_pd(a, h));
+      w |= (uint64_t)_mm_movemask_pd(a) << j;
+    }
+    bits[i / 64] = w;
+  }
 }
 
   /**
-   *  @fn static void libo_xl_cell_clear(libo_xl_cell *cell)
+   *  @fn static void filter_member_sse2(const int *v,
+   *                                     int n,
+   *                                     const int *ids,
+   *                                     int n_ids,
+   *                                     uint64_t *bits)
    *
-   *  @brief clears contents of @p cell, freeing memory if needed
+   *  @brief SSE2 version of @a filter_member_scalar, four ids at a time
    *
-   *  @param cell - pointer to existing @a libo_xl_cell struct
+   *  @param v - array of ids, -1 matching nothing
+   *  @param n - number of ids in @p v, a multiple of 64
+   *  @param ids - set of ids
+   *  @param n_ids - number of ids in @p ids
+   *  @param bits - receives @p n / 64 words
    *
    *  @par Returns
    *  Nothing.
    */
 
-static void libo_xl_cell_clear(libo_xl_cell *cell)
+__attribute__((target("sse2")))
+static void filter_member_sse2(const int *v, int n, const int *ids, int n_ids, uint64_t *bits)
 {
-  if (!cell) return;
+  __m128i a, m;
+  uint64_t w;
+  int i, j, k;
 
-  switch (cell->type)
+  for (i = 0; i < n; i += 64)
   {
-    case libo_xl_cell_type_reference:
-      cell->reference = 0;
-      break;
-
-    case libo_xl_cell_type_expression:
-      if (cell->expression.value) free(cell->expression.value);
-      if (cell->expression.formula) free(cell->expression.formula);
-      memset(&cell->expression, 0, sizeof(libo_xl_cell_expression));
-      break;
-
-    case libo_xl_cell_type_number:
-      cell->reference = 0;
-      break;
-
-    case libo_xl_cell_type_none:
-    default:
-      break;
+    w = 0;
+    for (j = 0; j < 64; j += 4)
+    {
+      a = _mm_loadu_si128((const __m128i *)(v + i + j));
+      m = _mm_setzero_si128();
+      for (k = 0; k < n_ids; k++)
+        m = _mm_or_si128(m, _mm_cmpeq_epi32(a, _mm_set1_epi32(ids[k])));
+      w |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(m)) << j;
+    }
+    bits[i / 64] = w;
   }
-
-  libo_xl_cell_set_type(cell, libo_xl_cell_type_none);
 }
 
   /**
-   *  @fn void libo_xl_sheet_count_columns(libo_xl_sheet *xls)
-   *
-   *  @brief finds maximum columns in @p xls
+   *  @fn static void filter_range_avx2(const double *v,
+   *                                    int n,
+   *                                    double lo,
+   *                                    double hi,
+   *                                    uint64_t *bits)
    *
-   *  NOTE:  This function modifies the n_cols field in @p xls
+   *  @brief AVX2 version of @a filter_range_scalar, four numbers at a time
    *
-   *  @param xls - pointer to existing @a libo_xl_sheet struct
+   *  @param v - array of numbers, NaN matching nothing
+   *  @param n - number of numbers in @p v, a multiple of 64
+   *  @param lo - smallest matching number
+   *  @param hi - largest matching number
+   *  @param bits - receives @p n / 64 words
    *
    *  @par Returns
    *  Nothing.
    */
 
-static void libo_xl_sheet_count_columns(libo_xl_sheet *xls)
+__attribute__((target("avx2")))
+static void filter_range_avx2(const double *v, int n, double lo, double hi, uint64_t *bits)
 {
-  int i;
-  libo_xl_row *row;
-
-  if (!xls) return;
-
-  xls->n_cols = 0;
+  __m256d l = _mm256_set1_pd(lo);
+  __m256d h = _mm256_set1_pd(hi);
+  __m256d a;
+  uint64_t w;
+  int i, j;
 
-  for (i = 0; i < xls->n_rows; i++)
+  for (i = 0; i < n; i += 64)
   {
-    row = xls->row[i];
-    if (row->n_cells > xls->n_cols)
-      xls->n_cols = row->n_cells;
+    w = 0;
+    for (j = 0; j < 64; j += 4)
+    {
+      a = _mm256_loadu_pd(v + i + j);
+      a = _mm256_and_pd(_mm256_cmp_pd(a, l, _CMP_GE_OQ), _mm256_cmp_pd(a, h, _CMP_LE_OQ));
+      w |= (uint64_t)_mm256_movemask_pd(a) << j;
+    }
+    bits[i / 64] = w;
   }
 }
 
   /**
-   *  @fn libo_xl_column **libo_xl_sheet_columns_create_defaults(libo_xl_sheet *sheet)
+   *  @fn static void filter_member_avx2(const int *v,
+   *                                     int n,
+   *                                     const int *ids,
+   *                                     int n_ids,
+   *                                     uint64_t *bits)
    *
-   *  @brief creates a @a libo_xl_column for each column used in @p sheet
+   *  @brief AVX2 version of @a filter_member_scalar, eight ids at a time
    *
-   *  @param sheet - pointer to existing @a libo_xl_sheet struct
+   *  @param v - array of ids, -1 matching nothing
+   *  @param n - number of ids in @p v, a multiple of 64
+   *  @param ids - set of ids
+   *  @param n_ids - number of ids in @p ids
+   *  @param bits - receives @p n / 64 words
    *
-   *  @return pointer to array of @a libo_xl_column pointers
+   *  @par Returns
+   *  Nothing.
    */
 
-static libo_xl_column **libo_xl_sheet_columns_create_defaults(libo_xl_sheet *sheet)
+__attribute__((target("avx2")))
+static void filter_member_avx2(const int *v, int n, const int *ids, int n_ids, uint64_t *bits)
 {
-  libo_xl_column **columns = NULL;
-  int i;
-
-  if (!sheet) goto exit;
-
-  columns = realloc(columns, sizeof(libo_xl_column *) * sheet->n_cols);
-  if (!columns) goto exit;
-
-  for (i = 0; i < sheet->n_cols; i++)
-    columns[i] = libo_xl_column_new_with_values(15, 1);
+  __m256i a, m;
+  uint64_t w;
+  int i, j, k;
 
-exit:
-  return columns;
+  for (i = 0; i < n; i += 64)
+  {
+    w = 0;
+    for (j = 0; j < 64; j += 8)
+    {
+      a = _mm256_loadu_si256((const __m256i *)(v + i + j));
+      m = _mm256_setzero_si256();
+      for (k = 0; k < n_ids; k++)
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi32(a, _mm256_set1_epi32(ids[k])));
+      w |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(m)) << j;
+    }
+    bits[i / 64] = w;
+  }
 }
 
+#endif
@@ -1,5 +1,8 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
 #include <getopt.h>
 
 #include "libo.h"
@@ -10,14 +13,53 @@ typedef enum
   API
 } test_type;
 
+typedef struct
+{
+  char *hostname;
+  int id;
+  double plugin;
+} test_host;
+
 static libo *test_creation_functions(void);
+static libo *test_shared_functions(char *path, int n_rows);
+static int test_record_handler(libo_xl_record *rec, void *data);
 
 int main(int argc, char **argv)
 {
   libo *l;
+  libo *l2;
+  libo_cache *cache;
+  libo_options *options;
+  libo_xl_column_stats stats;
+  libo_xl_index *index;
+  libo_xl_sorted_index *sorted;
+  int rows[64];
+  libo_xl_sort_key keys[2];
+  libo_xl_predicate pred;
+  libo_xl_view *view;
+  libo_xl_view *view2;
+  libo_xl_view *view3;
+  char *texts[2];
+  libo_xl_schema *schema;
+  libo_xl_record rec;
+  libo_xl_field fields[3];
+  test_host *hosts;
+  long n_hosts;
+  libo_xl_value value;
+  char number[LIBO_XL_NUMBER_SIZE];
+  char formula[256];
+  char other[256];
+  size_t length;
+  double matrix[3 * 4];
+  int64_t counts[3 * 2];
+  int ids[2];
+  libo_xl_calc *calc;
+  libo_xl_styles *styles;
+  libo_xl_style style;
   libo_xl *xl;
   libo_xl_book *book;
   libo_xl_sheet *sheet;
+  libo_xl_sheet *sheet2;
   libo_xl_row *row;
   libo_xl_cell *cell;
   int c;
@@ -115,6 +157,19 @@ int main(int argc, char **argv)
             case libo_xl_cell_type_number:
               printf("libo_xl_cell_get_number(%p)=%f\n", cell, cell_number = libo_xl_cell_get_number(cell));
               break;
+            case libo_xl_cell_type_boolean:
+              printf("libo_xl_cell_get_boolean(%p)=%d\n", cell, libo_xl_cell_get_boolean(cell));
+              break;
+            case libo_xl_cell_type_error:
+              printf("libo_xl_cell_get_error(%p)=%s\n", cell, libo_xl_error_to_string(libo_xl_cell_get_error(cell)));
+              break;
+            case libo_xl_cell_type_empty:
+              printf("EMPTY CELL\n");
+              break;
+            case libo_xl_cell_type_date:
+              printf("libo_xl_cell_get_date(%p, %d)=%f\n", cell, libo_xl_book_get_date1904(book),
+                     libo_xl_cell_get_date(cell, libo_xl_book_get_date1904(book)));
+              break;
           }
 
           printf("libo_xl_cell_get_string_value(%p, %p)=%s\n",
@@ -132,11 +187,953 @@ int main(int argc, char **argv)
 
   printf("\n\nREAD and DUMP Tests Complete\n\n");
 
+  printf("\n\nStarting CACHE Tests\n\n");
+
+  cache = libo_cache_new(64 * 1024 * 1024);
+  printf("libo_cache_new()=%p\n", cache);
+  printf("libo_cache_open(%p, %s)=%p\n", cache, "xlsx/all.xlsx", l = libo_cache_open(cache, "xlsx/all.xlsx"));
+  printf("libo_cache_open(%p, %s)=%p\n", cache, "xlsx/all.xlsx", l2 = libo_cache_open(cache, "xlsx/all.xlsx"));
+  printf("libo_memory_size(%p)=%zu\n", l, libo_memory_size(l));
+  libo_cache_dump(cache, stdout, 0);
+  libo_cache_release(cache, l2);
+  libo_cache_release(cache, l);
+  libo_cache_free(cache);
+
+  printf("\n\nCACHE Tests Complete\n\n");
+
+  printf("\n\nStarting BUDGET Tests\n\n");
+
+  options = libo_options_new();
+  libo_options_set_memory_budget(options, 1);
+  l = libo_open_with_options("xlsx/all.xlsx", options);
+  libo_options_free(options);
+  if (l)
+  {
+    book = libo_xl_get_book(libo_get_xl(l));
+    for (i = 0; i < libo_xl_book_get_sheet_count(book); i++)
+    {
+      printf("libo_xl_sheet_get_state(%p)=%d\n", book->sheet[i], libo_xl_sheet_get_state(book->sheet[i]));
+      printf("libo_xl_book_get_sheet(%p, %d)=%p\n", book, i, sheet = libo_xl_book_get_sheet(book, i));
+      printf("libo_xl_sheet_get_state(%p)=%d\n", sheet, libo_xl_sheet_get_state(sheet));
+      printf("libo_xl_sheet_get_row_count(%p)=%d\n", sheet, libo_xl_sheet_get_row_count(sheet));
+    }
+    libo_free(l);
+  }
+
+  printf("\n\nBUDGET Tests Complete\n\n");
+
+  printf("\n\nStarting STORAGE Tests\n\n");
+
+  options = libo_options_new();
+  libo_options_set_storage(options, libo_xl_storage_disk);
+  l = libo_open_with_options("xlsx/all.xlsx", options);
+  libo_options_free(options);
+  if (l)
+  {
+    book = libo_xl_get_book(libo_get_xl(l));
+    for (i = 0; i < libo_xl_book_get_sheet_count(book); i++)
+    {
+      printf("libo_xl_book_get_sheet(%p, %d)=%p\n", book, i, sheet = libo_xl_book_get_sheet(book, i));
+      printf("libo_xl_sheet_get_storage(%p)=%d\n", sheet, libo_xl_sheet_get_storage(sheet));
+      printf("libo_xl_sheet_get_row_count(%p)=%d\n", sheet, libo_xl_sheet_get_row_count(sheet));
+      printf("libo_xl_sheet_memory_size(%p)=%zu\n", sheet, libo_xl_sheet_memory_size(sheet));
+    }
+    libo_dump(l, stdout, 0);
+    libo_free(l);
+  }
+
+  printf("\n\nSTORAGE Tests Complete\n\n");
+
+  printf("\n\nStarting COMPRESSED STORAGE Tests\n\n");
+
+  options = libo_options_new();
+  libo_options_set_storage(options, libo_xl_storage_compressed);
+  l = libo_open_with_options("xlsx/all.xlsx", options);
+  libo_options_free(options);
+  if (l)
+  {
+    book = libo_xl_get_book(libo_get_xl(l));
+    for (i = 0; i < libo_xl_book_get_sheet_count(book); i++)
+    {
+      printf("libo_xl_book_get_sheet(%p, %d)=%p\n", book, i, sheet = libo_xl_book_get_sheet(book, i));
+      printf("libo_xl_sheet_get_storage(%p)=%d\n", sheet, libo_xl_sheet_get_storage(sheet));
+      printf("libo_xl_sheet_get_row_count(%p)=%d\n", sheet, libo_xl_sheet_get_row_count(sheet));
+      printf("libo_xl_sheet_memory_size(%p)=%zu\n", sheet, libo_xl_sheet_memory_size(sheet));
+    }
+    libo_dump(l, stdout, 0);
+    libo_free(l);
+  }
+
+  printf("\n\nCOMPRESSED STORAGE Tests Complete\n\n");
+
+  printf("\n\nStarting COLUMNAR STORAGE Tests\n\n");
+
+  options = libo_options_new();
+  libo_options_set_storage(options, libo_xl_storage_columnar);
+  l = libo_open_with_options("xlsx/all.xlsx", options);
+  libo_options_free(options);
+  if (l)
+  {
+    book = libo_xl_get_book(libo_get_xl(l));
+    for (i = 0; i < libo_xl_book_get_sheet_count(book); i++)
+    {
+      printf("libo_xl_book_get_sheet(%p, %d)=%p\n", book, i, sheet = libo_xl_book_get_sheet(book, i));
+      printf("libo_xl_sheet_get_storage(%p)=%d\n", sheet, libo_xl_sheet_get_storage(sheet));
+      printf("libo_xl_sheet_get_row_count(%p)=%d\n", sheet, libo_xl_sheet_get_row_count(sheet));
+      printf("libo_xl_sheet_memory_size(%p)=%zu\n", sheet, libo_xl_sheet_memory_size(sheet));
+      for (j = 0; j < libo_xl_sheet_get_column_count(sheet); j++)
+      {
+        printf("libo_xl_sheet_get_column_encoding(%p, %d)=%s\n", sheet, j,
+               libo_xl_encoding_to_string(libo_xl_sheet_get_column_encoding(sheet, j)));
+        printf("libo_xl_sheet_get_column_type(%p, %d)=%s\n", sheet, j,
+               libo_xl_column_type_to_string(libo_xl_sheet_get_column_type(sheet, j)));
+        printf("libo_xl_sheet_column_count_range(%p, %d, 0, 1000)=%ld\n", sheet, j,
+               libo_xl_sheet_column_count_range(sheet, j, 0, 1000));
+        printf("libo_xl_sheet_column_count_reference(%p, %d, 0)=%ld\n", sheet, j,
+               libo_xl_sheet_column_count_reference(sheet, j, 0));
+        printf("libo_xl_sheet_column_sum(%p, %d)=%f\n", sheet, j,
+               libo_xl_sheet_column_sum(sheet, j));
+      }
+    }
+    libo_dump(l, stdout, 0);
+    libo_free(l);
+  }
+
+      /* Columns of booleans and of errors are typed, and read back as set */
+
+  sheet = libo_xl_sheet_new();
+  for (i = 0; i < 1000; i++)
+  {
+    row = libo_xl_row_new();
+    cell = libo_xl_cell_new();
+    if (i == 500)
+      libo_xl_cell_set_number(cell, 1);
+    else
+      libo_xl_cell_set_boolean(cell, i % 3 == 0);
+    libo_xl_row_add(row, cell);
+    libo_xl_cell_set_error(cell, (i % 7) ? libo_xl_error_na : libo_xl_error_div0);
+    libo_xl_row_add(row, cell);
+    libo_xl_cell_free(cell);
+    libo_xl_sheet_add(sheet, row);
+    libo_xl_row_free(row);
+  }
+  printf("libo_xl_sheet_set_storage(%p, columnar)=%d\n", sheet,
+         libo_xl_sheet_set_storage(sheet, libo_xl_storage_columnar));
+  for (j = 0; j < 2; j++)
+  {
+    printf("libo_xl_sheet_get_column_type(%p, %d)=%s\n", sheet, j,
+           libo_xl_column_type_to_string(libo_xl_sheet_get_column_type(sheet, j)));
+    printf("libo_xl_sheet_get_column_encoding(%p, %d)=%s\n", sheet, j,
+           libo_xl_encoding_to_string(libo_xl_sheet_get_column_encoding(sheet, j)));
+    printf("libo_xl_sheet_column_sum(%p, %d)=%f\n", sheet, j, libo_xl_sheet_column_sum(sheet, j));
+  }
+  printf("libo_xl_sheet_memory_size(%p)=%zu\n", sheet, libo_xl_sheet_memory_size(sheet));
+  c = 0;
+  for (i = 0; i < 1000; i++)
+  {
+    row = libo_xl_sheet_get_row(sheet, i);
+    cell = libo_xl_row_get_cell(row, 0);
+    if (i == 500)
+      c += libo_xl_cell_get_type(cell) != libo_xl_cell_type_number;
+    else
+      c += (libo_xl_cell_get_type(cell) != libo_xl_cell_type_boolean) ||
+           (cell->boolean != (i % 3 == 0));
+    cell = libo_xl_row_get_cell(row, 1);
+    c += (libo_xl_cell_get_type(cell) != libo_xl_cell_type_error) ||
+         (cell->error != ((i % 7) ? libo_xl_error_na : libo_xl_error_div0));
+  }
+  printf("columnar booleans and errors mismatches=%d\n", c);
+  libo_xl_sheet_free(sheet);
+
+  printf("\n\nCOLUMNAR STORAGE Tests Complete\n\n");
+
+  printf("\n\nStarting COLUMN STATS Tests\n\n");
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    book = libo_xl_get_book(libo_get_xl(l));
+    for (i = 0; i < libo_xl_book_get_sheet_count(book); i++)
+    {
+      sheet = libo_xl_book_get_sheet(book, i);
+      for (j = 0; j < libo_xl_sheet_get_column_count(sheet); j++)
+      {
+        printf("libo_xl_sheet_column_stats(%p, %d, %p)=%d\n", sheet, j, &stats,
+               libo_xl_sheet_column_stats(sheet, j, &stats));
+        printf("  count=%ld sum=%f min=%f max=%f mean=%f variance=%f\n",
+               stats.count, stats.sum, stats.min, stats.max, stats.mean, stats.variance);
+      }
+      printf("libo_xl_sheet_column_stats_range(%p, 3, 1, 2, %p)=%d\n", sheet, &stats,
+             libo_xl_sheet_column_stats_range(sheet, 3, 1, 2, &stats));
+      printf("  count=%ld sum=%f min=%f max=%f mean=%f variance=%f\n",
+             stats.count, stats.sum, stats.min, stats.max, stats.mean, stats.variance);
+    }
+    libo_free(l);
+  }
+
+  printf("\n\nCOLUMN STATS Tests Complete\n\n");
+
+  printf("\n\nStarting PROFILE Tests\n\n");
+
+  for (k = 0; k < 2; k++)
+  {
+    options = libo_options_new();
+    libo_options_set_profile(options, 1);
+    if (k) libo_options_set_storage(options, libo_xl_storage_compressed);
+    l = libo_open_with_options("xlsx/all.xlsx", options);
+    libo_options_free(options);
+    if (l)
+    {
+      book = libo_xl_get_book(libo_get_xl(l));
+      for (i = 0; i < libo_xl_book_get_sheet_count(book); i++)
+      {
+        printf("libo_xl_book_get_sheet(%p, %d)=%p\n", book, i, sheet = libo_xl_book_get_sheet(book, i));
+        printf("libo_xl_sheet_get_column_profile_count(%p)=%d\n", sheet,
+               libo_xl_sheet_get_column_profile_count(sheet));
+        for (j = 0; j < libo_xl_sheet_get_column_profile_count(sheet); j++)
+          libo_xl_column_profile_dump(libo_xl_sheet_get_column_profile(sheet, j), stdout, 2);
+      }
+      libo_free(l);
+    }
+  }
+
+  printf("\n\nPROFILE Tests Complete\n\n");
+
+  printf("\n\nStarting INDEX Tests\n\n");
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    printf("libo_xl_index_build(%p, 0)=%p\n", sheet, index = libo_xl_index_build(sheet, 0));
+    for (i = 0; i < libo_xl_sheet_get_row_count(sheet); i++)
+    {
+      cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), 0);
+      sv = libo_xl_cell_get_string_value(xl, cell);
+      printf("libo_xl_index_lookup(%p, %p)=%d\n", index, cell, libo_xl_index_lookup(index, cell));
+      printf("libo_xl_index_lookup_text(%p, %p, \"%s\")=%d\n", index, xl, sv,
+             libo_xl_index_lookup_text(index, xl, sv));
+      free(sv);
+    }
+    printf("libo_xl_index_lookup_text(%p, %p, \"%s\")=%d\n", index, xl, "no such text",
+           libo_xl_index_lookup_text(index, xl, "no such text"));
+
+      /* Cells set through the sheet are seen by the index */
+
+    printf("libo_xl_sheet_set_text(%p, %p, 1, 0, \"%s\")=%d\n", xl, sheet, "new host",
+           libo_xl_sheet_set_text(xl, sheet, 1, 0, "new host"));
+    printf("libo_xl_index_lookup_text(%p, %p, \"%s\")=%d\n", index, xl, "new host",
+           libo_xl_index_lookup_text(index, xl, "new host"));
+    i = libo_xl_sheet_get_row_count(sheet) + 2;
+    printf("libo_xl_sheet_set_number(%p, %d, 1, 42)=%d\n", sheet, i,
+           libo_xl_sheet_set_number(sheet, i, 1, 42));
+    printf("libo_xl_sheet_set_number(%p, %d, 0, 42)=%d\n", sheet, i,
+           libo_xl_sheet_set_number(sheet, i, 0, 42));
+    cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), 0);
+    printf("libo_xl_index_lookup(%p, %p)=%d\n", index, cell, libo_xl_index_lookup(index, cell));
+    libo_xl_index_free(index);
+    libo_free(l);
+  }
+
+  printf("\n\nINDEX Tests Complete\n\n");
+
+  printf("\n\nStarting SORTED INDEX Tests\n\n");
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    printf("libo_xl_sorted_index_build(%p, %p, 0)=%p\n", xl, sheet, sorted = libo_xl_sorted_index_build(xl, sheet, 0));
+    printf("libo_xl_sorted_index_get_count(%p)=%d\n", sorted, libo_xl_sorted_index_get_count(sorted));
+    for (i = 0; i < libo_xl_sorted_index_get_count(sorted); i++)
+    {
+      j = libo_xl_sorted_index_get_row(sorted, i);
+      cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, j), 0);
+      sv = libo_xl_cell_get_string_value(xl, cell);
+      printf("libo_xl_sorted_index_get_row(%p, %d)=%d \"%s\"\n", sorted, i, j, sv);
+      printf("libo_xl_sorted_index_lower_bound(%p, %p)=%d\n", sorted, cell, libo_xl_sorted_index_lower_bound(sorted, cell));
+      printf("libo_xl_sorted_index_upper_bound(%p, %p)=%d\n", sorted, cell, libo_xl_sorted_index_upper_bound(sorted, cell));
+      printf("libo_xl_sorted_index_match(%p, %p)=%d\n", sorted, cell, libo_xl_sorted_index_match(sorted, cell));
+      free(sv);
+    }
+    i = libo_xl_sorted_index_lower_bound_number(sorted, 2);
+    j = libo_xl_sorted_index_upper_bound_number(sorted, 50);
+    printf("libo_xl_sorted_index_rows(%p, %d, %d, %p)=%d\n", sorted, i, j, rows, k = libo_xl_sorted_index_rows(sorted, i, j, rows));
+    for (c = 0; c < k; c++)
+      printf("  row %d\n", rows[c]);
+    printf("libo_xl_sorted_index_lower_bound_text(%p, \"%s\")=%d\n", sorted, "m",
+           libo_xl_sorted_index_lower_bound_text(sorted, "m"));
+    printf("libo_xl_sorted_index_upper_bound_text(%p, \"%s\")=%d\n", sorted, "m",
+           libo_xl_sorted_index_upper_bound_text(sorted, "m"));
+    printf("libo_xl_sorted_index_is_stale(%p)=%d\n", sorted, libo_xl_sorted_index_is_stale(sorted));
+    printf("libo_xl_sheet_set_number(%p, 1, 0, 7)=%d\n", sheet, libo_xl_sheet_set_number(sheet, 1, 0, 7));
+    printf("libo_xl_sorted_index_is_stale(%p)=%d\n", sorted, libo_xl_sorted_index_is_stale(sorted));
+    libo_xl_sorted_index_free(sorted);
+    libo_free(l);
+  }
+
+      /* NaN sorts after every number */
+
+  sheet = libo_xl_sheet_new();
+  for (i = 0; i < 6; i++)
+    libo_xl_sheet_set_number(sheet, i, 0, (i % 2) ? NAN : 5 - i);
+  printf("libo_xl_sorted_index_build(NULL, %p, 0)=%p\n", sheet, sorted = libo_xl_sorted_index_build(NULL, sheet, 0));
+  for (i = 0; i < libo_xl_sorted_index_get_count(sorted); i++)
+  {
+    j = libo_xl_sorted_index_get_row(sorted, i);
+    libo_xl_cell_format_number(libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, j), 0), number, sizeof(number));
+    printf("libo_xl_sorted_index_get_row(%p, %d)=%d \"%s\"\n", sorted, i, j, number);
+  }
+  printf("libo_xl_sorted_index_upper_bound_number(%p, 5)=%d\n", sorted,
+         libo_xl_sorted_index_upper_bound_number(sorted, 5));
+  libo_xl_sorted_index_free(sorted);
+  libo_xl_sheet_free(sheet);
+
+  printf("\n\nSORTED INDEX Tests Complete\n\n");
+
+  printf("\n\nStarting SORT Tests\n\n");
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    keys[0].col = 1;
+    keys[0].descending = 0;
+    keys[1].col = 0;
+    keys[1].descending = 1;
+    printf("libo_xl_sheet_sort(%p, %p, 1, %p, 2)=%d\n", xl, sheet, keys, libo_xl_sheet_sort(xl, sheet, 1, keys, 2));
+    for (i = 0; i < libo_xl_sheet_get_row_count(sheet); i++)
+    {
+      row = libo_xl_sheet_get_row(sheet, i);
+      for (j = 0; j < 2; j++)
+      {
+        sv = libo_xl_cell_get_string_value(xl, libo_xl_row_get_cell(row, j));
+        printf("%s\"%s\"", j ? ", " : "", sv);
+        free(sv);
+      }
+      printf("\n");
+    }
+    printf("libo_xl_sheet_get_sort(%p)=%p\n", sheet, libo_xl_sheet_get_sort(sheet));
+    libo_free(l);
+  }
+
+      /* NaN sorts after numbers, and equal booleans tie */
+
+  sheet = libo_xl_sheet_new();
+  for (i = 0; i < 8; i++)
+  {
+    if (i % 3 == 2)
+      libo_xl_cell_set_boolean(libo_xl_cell_create(sheet, i, 0), i > 4);
+    else
+      libo_xl_sheet_set_number(sheet, i, 0, (i % 3) ? NAN : i);
+  }
+  libo_xl_cell_set_boolean(libo_xl_cell_create(sheet, 8, 0), 1);
+  keys[0].col = 0;
+  keys[0].descending = 0;
+  printf("libo_xl_sheet_sort(NULL, %p, 0, %p, 1)=%d\n", sheet, keys, libo_xl_sheet_sort(NULL, sheet, 0, keys, 1));
+  for (i = 0; i < libo_xl_sheet_get_row_count(sheet); i++)
+  {
+    sv = libo_xl_cell_get_string_value(NULL, libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), 0));
+    printf("  row %d \"%s\"\n", i, sv);
+    free(sv);
+  }
+  libo_xl_sheet_free(sheet);
+
+  printf("\n\nSORT Tests Complete\n\n");
+
+  printf("\n\nStarting VIEW Tests\n\n");
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    pred.col = 0;
+    pred.op = libo_xl_predicate_op_in;
+    pred.lo = 0;
+    pred.hi = 0;
+    pred.n_ids = 2;
+    pred.ids = rows;
+    pred.n_texts = 0;
+    pred.texts = NULL;
+    rows[0] = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, 1), 0)->reference;
+    rows[1] = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, 3), 0)->reference;
+    printf("libo_xl_view_filter(%p, %p)=%p\n", sheet, &pred, view = libo_xl_view_filter(sheet, &pred));
+    printf("libo_xl_view_get_count(%p)=%d\n", view, libo_xl_view_get_count(view));
+    for (i = libo_xl_view_next(view, -1); i >= 0; i = libo_xl_view_next(view, i))
+      printf("libo_xl_view_next()=%d\n", i);
+    rows[0] = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, 2), 0)->reference;
+    pred.n_ids = 1;
+    printf("libo_xl_view_filter(%p, %p)=%p\n", sheet, &pred, view2 = libo_xl_view_filter(sheet, &pred));
+    printf("libo_xl_view_or(%p, %p)=%p\n", view, view2, view3 = libo_xl_view_or(view, view2));
+    libo_xl_view_free(view);
+    libo_xl_view_free(view2);
+    view = view3;
+    printf("libo_xl_view_get_count(%p)=%d\n", view, libo_xl_view_get_count(view));
+    printf("libo_xl_view_contains(%p, 2)=%d\n", view, libo_xl_view_contains(view, 2));
+    printf("libo_xl_view_contains(%p, 4)=%d\n", view, libo_xl_view_contains(view, 4));
+    printf("libo_xl_view_to_sheet(%p)=%p\n", view, sheet = libo_xl_view_to_sheet(view));
+    printf("libo_xl_sheet_get_row_count(%p)=%d\n", sheet, libo_xl_sheet_get_row_count(sheet));
+    libo_xl_sheet_free(sheet);
+    printf("libo_xl_view_apply(%p, 0, 1)=%d\n", view, libo_xl_view_apply(view, 0, 1));
+    libo_xl_view_free(view);
+    libo_free(l);
+  }
+
+  printf("\n\nVIEW Tests Complete\n\n");
+
+  printf("\n\nStarting PREDICATE Tests\n\n");
+
+  options = libo_options_new();
+  libo_options_set_header_rows(options, 1);
+  texts[0] = "XYZ-DT69953";
+  texts[1] = "no such text";
+  pred.col = 0;
+  pred.op = libo_xl_predicate_op_in;
+  pred.n_ids = 0;
+  pred.ids = NULL;
+  pred.n_texts = 2;
+  pred.texts = texts;
+  printf("libo_options_add_predicate(%p, %p)=%d\n", options, &pred, libo_options_add_predicate(options, &pred));
+  pred.col = 3;
+  pred.op = libo_xl_predicate_op_greater;
+  pred.lo = 1000;
+  pred.n_texts = 0;
+  pred.texts = NULL;
+  printf("libo_options_add_predicate(%p, %p)=%d\n", options, &pred, libo_options_add_predicate(options, &pred));
+  printf("libo_options_get_predicate_count(%p)=%d\n", options, libo_options_get_predicate_count(options));
+  for (k = 0; k < 2; k++)
+  {
+    if (k) libo_options_set_storage(options, libo_xl_storage_disk);
+    l = libo_open_with_options("xlsx/all.xlsx", options);
+    if (l)
+    {
+      xl = libo_get_xl(l);
+      sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+      printf("libo_xl_sheet_get_row_count(%p)=%d\n", sheet, libo_xl_sheet_get_row_count(sheet));
+      for (i = 0; i < libo_xl_sheet_get_row_count(sheet); i++)
+      {
+        sv = libo_xl_cell_get_string_value(xl, libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), 0));
+        printf("  row %d \"%s\"\n", i, sv);
+        free(sv);
+      }
+      libo_free(l);
+    }
+  }
+  libo_options_clear_predicates(options);
+  libo_options_free(options);
+
+  printf("\n\nPREDICATE Tests Complete\n\n");
+
+  printf("\n\nStarting PROJECTION Tests\n\n");
+
+  options = libo_options_new();
+  printf("libo_options_add_column_name(%p, \"%s\")=%d\n", options, "plugin",
+         libo_options_add_column_name(options, "plugin"));
+  printf("libo_options_add_column(%p, \"%s\")=%d\n", options, "A",
+         libo_options_add_column(options, "A"));
+  printf("libo_options_add_column_name(%p, \"%s\")=%d\n", options, "no such heading",
+         libo_options_add_column_name(options, "no such heading"));
+  printf("libo_options_get_column_count(%p)=%d\n", options, libo_options_get_column_count(options));
+  for (k = 0; k < 2; k++)
+  {
+    if (k) libo_options_set_storage(options, libo_xl_storage_columnar);
+    l = libo_open_with_options("xlsx/all.xlsx", options);
+    if (l)
+    {
+      xl = libo_get_xl(l);
+      sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+      printf("libo_xl_sheet_get_column_count(%p)=%d\n", sheet, libo_xl_sheet_get_column_count(sheet));
+      for (j = 0; j < libo_xl_sheet_get_column_count(sheet); j++)
+        printf("libo_xl_sheet_get_source_column(%p, %d)=%d\n", sheet, j, libo_xl_sheet_get_source_column(sheet, j));
+      for (i = 0; i < libo_xl_sheet_get_row_count(sheet); i++)
+      {
+        row = libo_xl_sheet_get_row(sheet, i);
+        for (j = 0; j < 2; j++)
+        {
+          sv = libo_xl_cell_get_string_value(xl, libo_xl_row_get_cell(row, j));
+          printf("%s\"%s\"", j ? ", " : "  ", sv);
+          free(sv);
+        }
+        printf("\n");
+      }
+      libo_free(l);
+    }
+  }
+  libo_options_clear_columns(options);
+  libo_options_free(options);
+
+  printf("\n\nPROJECTION Tests Complete\n\n");
+
+  printf("\n\nStarting ROW RANGE Tests\n\n");
+
+  options = libo_options_new();
+  libo_options_set_row_range(options, 1, 3);
+  l = libo_open_with_options("xlsx/all.xlsx", options);
+  libo_options_free(options);
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    for (k = 0; k < 3; k++)
+    {
+      if (k == 1)
+        printf("libo_xl_sheet_read_range(%p, %p, 4, -1)=%d\n", l, sheet, libo_xl_sheet_read_range(l, sheet, 4, -1));
+      if (k == 2)
+        printf("libo_xl_sheet_read_sample(%p, %p, 3, 1)=%d\n", l, sheet, libo_xl_sheet_read_sample(l, sheet, 3, 1));
+      printf("libo_xl_sheet_get_row_count(%p)=%d\n", sheet, libo_xl_sheet_get_row_count(sheet));
+      for (i = 0; i < libo_xl_sheet_get_row_count(sheet); i++)
+      {
+        sv = libo_xl_cell_get_string_value(xl, libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), 0));
+        printf("  row %d \"%s\"\n", i, sv);
+        free(sv);
+      }
+    }
+    libo_free(l);
+  }
+
+  printf("\n\nROW RANGE Tests Complete\n\n");
+
+  printf("\n\nStarting SEEK Tests\n\n");
+
+  options = libo_options_new();
+  libo_options_set_seek_span(options, 4096);
+  printf("libo_options_get_seek_span(%p)=%lu\n", options, (unsigned long)libo_options_get_seek_span(options));
+  l = libo_open_with_options("xlsx/all.xlsx", options);
+  libo_options_free(options);
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    printf("libo_xl_sheet_get_checkpoint_count(%p)=%d\n", sheet, libo_xl_sheet_get_checkpoint_count(sheet));
+    printf("libo_xl_sheet_read_range(%p, %p, 3, 5)=%d\n", l, sheet, libo_xl_sheet_read_range(l, sheet, 3, 5));
+    for (i = 0; i < libo_xl_sheet_get_row_count(sheet); i++)
+    {
+      sv = libo_xl_cell_get_string_value(xl, libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, i), 0));
+      printf("  row %d \"%s\"\n", i, sv);
+      free(sv);
+    }
+    libo_free(l);
+  }
+
+  l = test_shared_functions("TEST-SHARED.xlsx", 40000);
+  if (l)
+  {
+    libo_write(l, l->path);
+    libo_free(l);
+  }
+
+  options = libo_options_new();
+  libo_options_set_seek_span(options, 4096);
+  l = libo_open_with_options("TEST-SHARED.xlsx", options);
+  libo_options_free(options);
+  l2 = libo_open("TEST-SHARED.xlsx");
+  if (l && l2)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    printf("libo_xl_sheet_get_checkpoint_count(%p)=%d\n", sheet, libo_xl_sheet_get_checkpoint_count(sheet));
+    for (k = 0; k < 2; k++)
+    {
+      i = k ? 39990 : 20000;
+      printf("libo_xl_sheet_read_range(%p, %p, %d, %d)=%d", l, sheet, i, k ? -1 : 20005,
+             libo_xl_sheet_read_range(l, sheet, i, k ? -1 : 20005));
+
+        /* Rows read from a checkpoint match those read from the start */
+
+      c = 0;
+      for (j = 0; j < 2 * libo_xl_sheet_get_row_count(sheet); j++)
+      {
+        sheet2 = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l2)), 0);
+        cell_value = libo_xl_sheet_get_string_value(xl, sheet, j / 2, j % 2);
+        sv = libo_xl_sheet_get_string_value(libo_get_xl(l2), sheet2, i + j / 2, j % 2);
+        if (!cell_value || !sv || strcmp(cell_value, sv)) c++;
+        free(cell_value);
+        free(sv);
+
+        libo_xl_sheet_format_formula(sheet, j / 2, j % 2, formula, sizeof(formula));
+        libo_xl_sheet_format_formula(sheet2, i + j / 2, j % 2, other, sizeof(other));
+        if (strcmp(formula, other)) c++;
+      }
+      printf(" rows=%d mismatches=%d\n", libo_xl_sheet_get_row_count(sheet), c);
+    }
+  }
+  libo_free(l);
+  libo_free(l2);
+
+  printf("\n\nSEEK Tests Complete\n\n");
+
+  printf("\n\nStarting SCHEMA Tests\n\n");
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    printf("libo_xl_sheet_schema(%p, %p, 0)=%p\n", xl, sheet, schema = libo_xl_sheet_schema(xl, sheet, 0));
+    printf("libo_xl_schema_get_column_count(%p)=%d\n", schema, libo_xl_schema_get_column_count(schema));
+    for (i = 0; i < libo_xl_schema_get_column_count(schema); i++)
+      printf("libo_xl_schema_get_name(%p, %d)=%s\n", schema, i, libo_xl_schema_get_name(schema, i));
+    printf("libo_xl_schema_get_column(%p, \"plugin\")=%d\n", schema, libo_xl_schema_get_column(schema, "plugin"));
+    printf("libo_xl_schema_get_column(%p, \"no such heading\")=%d\n", schema, libo_xl_schema_get_column(schema, "no such heading"));
+    for (i = 1; !libo_xl_sheet_get_record(sheet, schema, i, &rec); i++)
+    {
+      printf("  record %d \"%s\" %f\n", rec.n,
+             libo_xl_record_get_text(&rec, "hostname"),
+             libo_xl_record_get_number(&rec, "plugin"));
+    }
+    libo_xl_schema_free(schema);
+    printf("libo_xl_sheet_stream_records(%p, %p, 0)=%d\n", l, sheet,
+           libo_xl_sheet_stream_records(l, sheet, 0, test_record_handler, NULL));
+    libo_free(l);
+  }
+
+  printf("\n\nSCHEMA Tests Complete\n\n");
+
+  printf("\n\nStarting BINDING Tests\n\n");
+
+  fields[0].col = 0;
+  fields[0].type = libo_xl_field_text;
+  fields[0].offset = offsetof(test_host, hostname);
+  fields[1].col = 0;
+  fields[1].type = libo_xl_field_string_id;
+  fields[1].offset = offsetof(test_host, id);
+  fields[2].col = 3;
+  fields[2].type = libo_xl_field_double;
+  fields[2].offset = offsetof(test_host, plugin);
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0);
+    n_hosts = libo_xl_sheet_bind(l, sheet, 1, -1, fields, 3, sizeof(test_host), (void **)&hosts);
+    printf("libo_xl_sheet_bind(%p, %p, 1, -1)=%ld\n", l, sheet, n_hosts);
+    for (i = 0; i < n_hosts; i++)
+      printf("  host %d \"%s\" %d %f\n", i, hosts[i].hostname, hosts[i].id, hosts[i].plugin);
+    free(hosts);
+    libo_free(l);
+  }
+
+  printf("\n\nBINDING Tests Complete\n\n");
+
+  printf("\n\nStarting VALUE Tests\n\n");
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(xl), 0);
+    for (i = 0; i < libo_xl_sheet_get_row_count(sheet) && i < 4; i++)
+    {
+      row = libo_xl_sheet_get_row(sheet, i);
+      for (j = 0; j < libo_xl_row_get_cell_count(row); j++)
+      {
+        cell = libo_xl_row_get_cell(row, j);
+        printf("libo_xl_cell_get_value(%p, %p)=%d", xl, cell, libo_xl_cell_get_value(xl, cell, &value));
+        if (value.type == libo_xl_cell_type_number)
+          printf(" %zu \"%s\"\n", libo_xl_cell_format_number(cell, number, sizeof(number)), number);
+        else
+          printf(" %zu \"%.*s\"\n", value.length, (int)value.length, value.text ? value.text : "");
+      }
+    }
+    cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, 0), 0);
+    printf("libo_xl_cell_get_string_view(%p, %p)=%s", xl, cell, libo_xl_cell_get_string_view(xl, cell, &length));
+    printf(" %zu\n", length);
+    libo_free(l);
+  }
+
+  printf("\n\nVALUE Tests Complete\n\n");
+
+  printf("\n\nStarting MATRIX Tests\n\n");
+
+  for (i = 0; i < 3; i++)
+  {
+    for (j = 0; j < 4; j++)
+      matrix[i * 4 + j] = i * 10 + j * 0.25;
+    counts[i * 2] = i;
+    counts[i * 2 + 1] = (int64_t)i * 1000000;
+  }
+
+  sheet = libo_xl_sheet_new();
+  if (sheet)
+  {
+    libo_xl_sheet_set_storage(sheet, libo_xl_storage_columnar);
+    printf("libo_xl_sheet_append_matrix(%p, %p, 3, 3, 4)=%d\n", sheet, matrix,
+           libo_xl_sheet_append_matrix(sheet, matrix, 3, 3, 4));
+    printf("libo_xl_sheet_append_matrix_int64(%p, %p, 3, 2, 0)=%d\n", sheet, counts,
+           libo_xl_sheet_append_matrix_int64(sheet, counts, 3, 2, 0));
+    for (i = 0; i < libo_xl_sheet_get_row_count(sheet); i++)
+    {
+      row = libo_xl_sheet_get_row(sheet, i);
+      printf("  row %d", i);
+      for (j = 0; j < libo_xl_row_get_cell_count(row); j++)
+      {
+        libo_xl_cell_format_number(libo_xl_row_get_cell(row, j), number, sizeof(number));
+        printf(" %s", number);
+      }
+      printf("\n");
+    }
+
+      /* Integers past 2^53 and unknown string ids append nothing */
+
+    counts[5] = (int64_t)1 << 53;
+    printf("libo_xl_sheet_append_matrix_int64(%p, %p, 3, 2, 0)=%d\n", sheet, counts,
+           libo_xl_sheet_append_matrix_int64(sheet, counts, 3, 2, 0));
+    counts[5] = ((int64_t)1 << 53) + 1;
+    printf("libo_xl_sheet_append_matrix_int64(%p, %p, 3, 2, 0)=%d\n", sheet, counts,
+           libo_xl_sheet_append_matrix_int64(sheet, counts, 3, 2, 0));
+    xl = libo_xl_new();
+    cell = libo_xl_cell_new();
+    libo_xl_cell_set_text(xl, cell, "matrix");
+    ids[0] = ids[1] = cell->reference;
+    printf("libo_xl_sheet_append_matrix_strings(%p, %p, %p, 1, 2, 0)=%d\n", xl, sheet, ids,
+           libo_xl_sheet_append_matrix_strings(xl, sheet, ids, 1, 2, 0));
+    ids[1] = 999;
+    printf("libo_xl_sheet_append_matrix_strings(%p, %p, %p, 1, 2, 0)=%d\n", xl, sheet, ids,
+           libo_xl_sheet_append_matrix_strings(xl, sheet, ids, 1, 2, 0));
+    printf("libo_xl_sheet_get_row_count(%p)=%d\n", sheet, libo_xl_sheet_get_row_count(sheet));
+    libo_xl_cell_free(cell);
+    libo_xl_free(xl);
+    libo_xl_sheet_free(sheet);
+  }
+
+  printf("\n\nMATRIX Tests Complete\n\n");
+
+  printf("\n\nStarting CALC Tests\n\n");
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    xl = libo_get_xl(l);
+    book = libo_xl_get_book(xl);
+    sheet = libo_xl_book_get_sheet(book, 0);
+    printf("libo_xl_calc_new(%p)=%p\n", xl, calc = libo_xl_calc_new(xl));
+    printf("libo_xl_calc_get_formula_count(%p)=%d\n", calc, libo_xl_calc_get_formula_count(calc));
+    printf("libo_xl_calc_recalculate(%p)=%d\n", calc, libo_xl_calc_recalculate(calc));
+    for (i = 1; i < 6; i++)
+    {
+      printf("libo_xl_calc_get_value(%p, %p, %d, 1)=%d", calc, sheet, i, libo_xl_calc_get_value(calc, sheet, i, 1, &value));
+      if (value.type == libo_xl_cell_type_number) printf(" %g\n", value.number);
+      else printf(" \"%.*s\"\n", (int)value.length, value.text ? value.text : "");
+    }
+
+    cell = libo_xl_cell_create(libo_xl_book_get_sheet(book, 1), 0, 0);
+    libo_xl_cell_set_text(xl, cell, (char *)libo_xl_cell_get_string_view(xl, libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, 1), 0), &length));
+    printf("libo_xl_calc_mark(%p, %p, 0, 0)=%d\n", calc, libo_xl_book_get_sheet(book, 1),
+           libo_xl_calc_mark(calc, libo_xl_book_get_sheet(book, 1), 0, 0));
+    printf("libo_xl_calc_update(%p)=%d\n", calc, libo_xl_calc_update(calc));
+    printf("libo_xl_calc_get_value(%p, %p, 1, 1)=%d", calc, sheet, libo_xl_calc_get_value(calc, sheet, 1, 1, &value));
+    printf(" %g\n", value.number);
+    libo_xl_calc_free(calc);
+    libo_free(l);
+  }
+
+  printf("\n\nCALC Tests Complete\n\n");
+
+  printf("\n\nStarting SHARED FORMULA Tests\n\n");
+
+  cell_formula = libo_xl_formula_to_r1c1("MATCH(A2,list!A:A,0)", 1, 1);
+  printf("libo_xl_formula_to_r1c1(\"MATCH(A2,list!A:A,0)\", 1, 1)=%s\n", cell_formula);
+  libo_xl_formula_from_r1c1(cell_formula, 4, 1, formula, sizeof(formula));
+  printf("libo_xl_formula_from_r1c1(\"%s\", 4, 1)=%s\n", cell_formula, formula);
+  free(cell_formula);
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0);
+    printf("libo_xl_sheet_get_shared_count(%p)=%d\n", sheet, libo_xl_sheet_get_shared_count(sheet));
+    for (i = 1; i < 6; i++)
+    {
+      libo_xl_sheet_format_formula(sheet, i, 1, formula, sizeof(formula));
+      printf("libo_xl_sheet_format_formula(%p, %d, 1)=%s\n", sheet, i, formula);
+    }
+    libo_free(l);
+  }
+
+  l = libo_open("TEST-SHARED.xlsx");
+  if (l)
+  {
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0);
+    printf("libo_xl_sheet_get_shared_count(%p)=%d\n", sheet, libo_xl_sheet_get_shared_count(sheet));
+    for (i = 0; i < 6; i++)
+    {
+      j = (i < 5) ? i : libo_xl_sheet_get_row_count(sheet) - 1;
+      cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, j), 1);
+      libo_xl_sheet_format_formula(sheet, j, 1, formula, sizeof(formula));
+      printf("  row %d formula \"%s\" own text %s\n", j, formula,
+             libo_xl_cell_expression_get_formula(libo_xl_cell_get_expression(cell)) ? "yes" : "no");
+    }
+    libo_free(l);
+  }
+
+  options = libo_options_new();
+  libo_options_set_seek_span(options, 4096);
+  l = libo_open_with_options("TEST-SHARED.xlsx", options);
+  libo_options_free(options);
+  if (l)
+  {
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0);
+    for (k = 0; k < 3; k++)
+    {
+      i = (k == 0) ? 20000 : (k == 1) ? 39990 : 39999;
+      j = (k == 0) ? 20005 : (k == 1) ? -1 : 40000;
+      printf("libo_xl_sheet_read_range(%p, %p, %d, %d)=%d\n", l, sheet, i, j,
+             libo_xl_sheet_read_range(l, sheet, i, j));
+      for (j = 0; j < libo_xl_sheet_get_row_count(sheet); j++)
+      {
+        libo_xl_sheet_format_formula(sheet, j, 1, formula, sizeof(formula));
+        printf("  row %d formula \"%s\"\n", i + j, formula);
+      }
+    }
+    libo_free(l);
+  }
+
+  printf("\n\nSHARED FORMULA Tests Complete\n\n");
+
+  printf("\n\nStarting NATIVE TYPES Tests\n\n");
+
+  cell = libo_xl_cell_new();
+  libo_xl_cell_set_boolean(cell, 1);
+  libo_xl_cell_get_value(NULL, cell, &value);
+  printf("libo_xl_cell_set_boolean(%p, 1): type=%s, number=%g, text=%s\n", cell,
+         libo_xl_cell_type_to_string(value.type), value.number, value.text);
+  libo_xl_cell_set_error(cell, libo_xl_error_from_string("#DIV/0!"));
+  libo_xl_cell_get_value(NULL, cell, &value);
+  printf("libo_xl_cell_set_error(%p, #DIV/0!): type=%s, error=%d, text=%s\n", cell,
+         libo_xl_cell_type_to_string(value.type), value.error, value.text);
+  printf("libo_xl_error_to_string(libo_xl_error_na)=%s\n", libo_xl_error_to_string(libo_xl_error_na));
+  libo_xl_cell_free(cell);
+
+  printf("\n\nNATIVE TYPES Tests Complete\n\n");
+
+  printf("\n\nStarting STYLES Tests\n\n");
+
+  xl = libo_xl_new();
+  styles = libo_xl_get_styles(xl);
+  printf("libo_xl_get_styles(%p)=%p, count=%d\n", xl, styles, libo_xl_styles_get_count(styles));
+  printf("libo_xl_styles_add_number_format(yyyy-mm-dd)=%d\n",
+         libo_xl_styles_add_number_format(styles, "yyyy-mm-dd"));
+  printf("libo_xl_styles_add_number_format(yyyy-mm-dd)=%d\n",
+         libo_xl_styles_add_number_format(styles, "yyyy-mm-dd"));
+  libo_xl_styles_get_style(styles, 0, &style);
+  style.number_format = 164;
+  style.flags |= LIBO_XL_STYLE_APPLY_NUMBER_FORMAT;
+  printf("libo_xl_styles_add_style()=%d\n", libo_xl_styles_add_style(styles, &style));
+  printf("libo_xl_styles_add_style()=%d\n", libo_xl_styles_add_style(styles, &style));
+  cell = libo_xl_cell_new();
+  libo_xl_cell_set_style(cell, libo_xl_styles_get_count(styles) - 1);
+  printf("libo_xl_cell_get_style(%p)=%d, format=%s\n", cell, libo_xl_cell_get_style(cell),
+         libo_xl_styles_get_number_format(styles, 164));
+  libo_xl_cell_free(cell);
+  libo_xl_free(xl);
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0);
+    row = libo_xl_row_new();
+    cell = libo_xl_cell_new();
+    libo_xl_cell_set_type(cell, libo_xl_cell_type_empty);
+    libo_xl_cell_set_style(cell, 1);
+    libo_xl_row_add(row, cell);
+    libo_xl_cell_free(cell);
+    libo_xl_sheet_add(sheet, row);
+    libo_xl_row_free(row);
+
+    libo_close(l);
+    remove("TEST-STYLES.xlsx");
+    printf("libo_write(%p, TEST-STYLES.xlsx)=%d\n", l, libo_write(l, "TEST-STYLES.xlsx"));
+    libo_free(l);
+  }
+
+  l = libo_open("TEST-STYLES.xlsx");
+  if (l)
+  {
+    libo_xl_styles_dump(libo_xl_get_styles(libo_get_xl(l)), stdout, 0);
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0);
+    cell = libo_xl_row_get_cell(libo_xl_sheet_get_row(sheet, libo_xl_sheet_get_row_count(sheet) - 1), 0);
+    printf("libo_xl_cell_get_style(%p)=%d, type=%s\n", cell, libo_xl_cell_get_style(cell),
+           libo_xl_cell_type_to_string(libo_xl_cell_get_type(cell)));
+    libo_free(l);
+  }
+
+  printf("\n\nSTYLES Tests Complete\n\n");
+
+  printf("\n\nStarting DATES Tests\n\n");
+
+  printf("libo_xl_number_format_is_date(yyyy-mm-dd)=%d\n", libo_xl_number_format_is_date("yyyy-mm-dd"));
+  printf("libo_xl_number_format_is_date([Red]0.00)=%d\n", libo_xl_number_format_is_date("[Red]0.00"));
+  printf("libo_xl_serial_to_epoch(25569, 0)=%d", libo_xl_serial_to_epoch(25569, 0, &value.number));
+  printf(" %.0f\n", value.number);
+  printf("libo_xl_serial_to_epoch(60, 0)=%d", libo_xl_serial_to_epoch(60, 0, &value.number));
+  printf(" %.0f\n", value.number);
+  printf("libo_xl_epoch_to_serial(0, 1)=%d", libo_xl_epoch_to_serial(0, 1, &value.number));
+  printf(" %g\n", value.number);
+  printf("libo_xl_serial_to_epoch(-1e300, 0)=%d\n", libo_xl_serial_to_epoch(-1e300, 0, &value.number));
+  printf("libo_xl_serial_to_epoch(NAN, 0)=%d\n", libo_xl_serial_to_epoch(NAN, 0, &value.number));
+  printf("libo_xl_serial_to_epoch(2958466, 0)=%d\n", libo_xl_serial_to_epoch(2958466, 0, &value.number));
+  printf("libo_xl_epoch_to_serial(1e300, 0)=%d\n", libo_xl_epoch_to_serial(1e300, 0, &value.number));
+  matrix[0] = 25569;
+  matrix[1] = NAN;
+  matrix[2] = -1;
+  printf("libo_xl_serials_to_epoch(25569, NAN, -1)=%d", libo_xl_serials_to_epoch(matrix, matrix, 3, 0));
+  printf(" %g %g %g\n", matrix[0], matrix[1], matrix[2]);
+  cell = libo_xl_cell_new();
+  printf("libo_xl_cell_set_date(%p, 1700000000, 0)=%d", cell, libo_xl_cell_set_date(cell, 1700000000, 0));
+  printf(": type=%s, date=%.0f\n",
+         libo_xl_cell_type_to_string(libo_xl_cell_get_type(cell)), libo_xl_cell_get_date(cell, 0));
+  libo_xl_cell_free(cell);
+
+  l = libo_open("xlsx/all.xlsx");
+  if (l)
+  {
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0);
+    row = libo_xl_row_new();
+    cell = libo_xl_cell_new();
+    libo_xl_cell_set_number(cell, 1.0 / 3.0);
+    libo_xl_row_add(row, cell);
+    libo_xl_cell_set_date(cell, 1700000000.123, 0);
+    libo_xl_row_add(row, cell);
+    libo_xl_cell_free(cell);
+    libo_xl_sheet_add(sheet, row);
+    libo_xl_row_free(row);
+
+    libo_close(l);
+    remove("TEST-NUMBERS.xlsx");
+    printf("libo_write(%p, TEST-NUMBERS.xlsx)=%d\n", l, libo_write(l, "TEST-NUMBERS.xlsx"));
+    libo_free(l);
+  }
+
+  l = libo_open("TEST-NUMBERS.xlsx");
+  if (l)
+  {
+    sheet = libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0);
+    row = libo_xl_sheet_get_row(sheet, libo_xl_sheet_get_row_count(sheet) - 1);
+    for (i = 0; i < 2; i++)
+    {
+      sv = libo_xl_cell_get_string_value(libo_get_xl(l), libo_xl_row_get_cell(row, i));
+      printf("libo_xl_cell_get_string_value(%p)=%s\n", libo_xl_row_get_cell(row, i), sv);
+      free(sv);
+    }
+    libo_free(l);
+  }
+
+  printf("\n\nDATES Tests Complete\n\n");
+
   printf("\n\nStarting CREATION Tests\n\n");
 
   l = test_creation_functions();
   printf("l=%p\n", l);
 
+  libo_xl_book_set_memory_budget(libo_xl_get_book(libo_get_xl(l)), 1);
+  libo_xl_sheet_set_storage(libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 0), libo_xl_storage_disk);
+  libo_xl_sheet_set_storage(libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 1), libo_xl_storage_compressed);
+  libo_xl_sheet_set_storage(libo_xl_book_get_sheet(libo_xl_get_book(libo_get_xl(l)), 2), libo_xl_storage_columnar);
+
   libo_dump(l, stdout, 0);
 
   libo_write(l, l->path);
@@ -148,6 +1145,15 @@ int main(int argc, char **argv)
   return 0;
 }
 
+static int test_record_handler(libo_xl_record *rec, void *data)
+{
+  printf("  streamed record %d \"%s\" %f\n", rec->n,
+         libo_xl_record_get_text(rec, "hostname"),
+         libo_xl_record_get_number(rec, "plugin"));
+
+  return 0;
+}
+
 static libo *test_creation_functions(void)
 {
   libo *doc = NULL;
@@ -229,3 +1235,73 @@ exit:
   return doc;
 }
 
+static libo *test_shared_functions(char *path, int n_rows)
+{
+  libo *doc = NULL;
+  libo_xl *xl = NULL;
+  libo_xl_book *book = NULL;
+  libo_xl_sheet *sheet = NULL;
+  libo_xl_row *row = NULL;
+  libo_xl_cell *cell = NULL;
+  libo_xl_cell_expression expression;
+  char formula[32];
+  char value[32];
+  int i;
+
+  doc = libo_new();
+  if (!doc) goto exit;
+
+  libo_set_type(doc, libo_type_xl);
+  libo_set_path(doc, path);
+
+  remove(doc->path);
+
+  xl = libo_get_xl(doc);
+  if (!xl) goto exit;
+
+  book = xl->book = libo_xl_book_new();
+
+  sheet = libo_xl_sheet_new();
+  libo_xl_sheet_set_name(sheet, "Sheet1");
+
+      /* Column B doubles column A, written as one shared formula */
+
+  for (i = 0; i < n_rows; i++)
+  {
+    row = libo_xl_row_new();
+    if (!row) goto exit;
+
+    cell = libo_xl_cell_new();
+    if (!cell) goto exit;
+    libo_xl_cell_set_number(cell, (double)(i + 1));
+    libo_xl_row_add(row, cell);
+    libo_xl_cell_free(cell); cell = NULL;
+
+    cell = libo_xl_cell_new();
+    if (!cell) goto exit;
+    sprintf(formula, "A%d*2", i + 1);
+    sprintf(value, "%d", 2 * (i + 1));
+    expression.formula = formula;
+    expression.value = value;
+    libo_xl_cell_set_expression(cell, &expression);
+    libo_xl_row_add(row, cell);
+    libo_xl_cell_free(cell); cell = NULL;
+
+    libo_xl_sheet_add(sheet, row);
+    libo_xl_row_free(row); row = NULL;
+  }
+
+  libo_xl_book_add(book, sheet);
+
+      /* Rows kept on disk are written a row at a time */
+
+  libo_xl_sheet_set_storage(libo_xl_book_get_sheet(book, 0), libo_xl_storage_disk);
+
+exit:
+  if (row) libo_xl_row_free(row);
+  if (cell) libo_xl_cell_free(cell);
+  if (sheet) libo_xl_sheet_free(sheet);
+
+  return doc;
+}
+